@@ -73,6 +73,9 @@ export SLURM_EAR_POLICY_IMC_TH=
 # Enables(1)/Disables(0) the energy policies to allow the hardware to 
 # select the default memory frequency. Applies to Intel and Min_time_to_solution: 1
 export SLURM_EAR_LET_HW_IMC=
+# Enables(1)/Disables(0) the energy policies to estimate the next memory frequency
+# from the ones already measured, instead of trying them one by one: 0
+export SLURM_EAR_POLICY_IMC_SEARCH=
 # Specified the job is using the job in exclusive mode. Some optimizations are applied to idle CPUs. 1
 export SLURM_EAR_JOB_EXCLUSIVE_MODE=
 # Enables(1)/Disables(0) the utilization of EARL phases classification
@@ -24,6 +24,7 @@
 #include <common/states.h>
 #include <common/system/user.h>
 #include <common/types/configuration/cluster_conf.h>
+#include <common/types/configuration/cluster_conf_image.h>
 #include <common/types/version.h>
 #include <daemon/log_eard.h>
 #include <global_manager/log_eargmd.h>
@@ -1150,7 +1151,7 @@ int main(int argc, char *argv[])
         printf("Error getting ear.conf path, load the ear module\n");
         return EXIT_FAILURE;
     }
-    if (state_fail(read_cluster_conf(path_name, &my_conf))) {
+    if (state_fail(cluster_conf_image_read(path_name, &my_conf))) {
         printf("Impossible to read ear.conf\n");
         return EXIT_FAILURE;
     }
@@ -67,6 +67,10 @@
 /* If set to 1, there should be no issues with jobs running while the node is "idle".
  * If set to 0, the idle powercap will be POWERCAP_UNLIMITED */
 #define EARD_POWERCAP_IDLE_PERC 1
+/** When set to 1, the coefficients shared with EARL are refined with the application signatures reported to EARD. */
+#define EARD_COEFFS_REFINE 0
+/** When set to 1, EARD keeps the frequencies selected by EARL for the phases of the applications across jobs. */
+#define EARD_PHASE_STORE 0
 /**  */
 #define SYNC_SET_RPC 1
 /**  */
@@ -94,6 +98,9 @@
 
 /** Maximum number of tries when doing non-blocking communications. */
 #define MAX_SOCKET_COMM_TRIES 40000000
+
+/** Maximum time (ms) a remote API send or receive waits for the socket to be ready. */
+#define MAX_SOCKET_COMM_TIMEOUT 10000
 //
 
 /* These flags configures EARL */
@@ -146,6 +153,7 @@
 #define GRACE_T1                          3
 #define MAX_TIME_DYNAIS_WITHOUT_SIGNATURE 15
 #define METRICS_OVH                       0
+#define METRICS_ALLOC_STATS               0
 
 /*
  * To be used by default in eard and eard_dummy
@@ -262,6 +270,11 @@
 /** Validates CPU busy waiting behavior. */
 #define EARL_CPUBUSYWAIT_VALIDATE 1
 
+/** Phases whose frequency selection is remembered by the policy, 0 disables the cache. */
+#define EARL_PHASE_CACHE 32
+/** Relative width of the signature buckets used to recognize a phase. */
+#define EARL_PHASE_CACHE_QUANTUM 0.05
+
 /** When set to 1, turbo is allowed */
 #define USE_TURBO 0
 
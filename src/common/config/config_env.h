@@ -149,6 +149,7 @@
 #define FLAG_SET_IMCFREQ    "EAR_SET_IMCFREQ" // This variable specifies the IMC freq must be selected by the EAR policy.
 #define FLAG_IMC_TH         "EAR_POLICY_IMC_TH" // Sets the threshold penalty tolered by the IMC/DF policy.
 #define FLAG_LET_HW_IMC     "EAR_LET_HW_IMC"    // Tells the IMC policy to be first guided by hardware's UFS algorithm.
+#define FLAG_IMC_SEARCH     "EAR_POLICY_IMC_SEARCH" // Lets the IMC policy skip the IMC pstates a search estimates.
 
 #define FLAG_EXCLUSIVE_MODE "EAR_JOB_EXCLUSIVE_MODE" // Tells EAR the current job is the unique executing in the node.
 #define FLAG_EARL_PHASES                                                                                               \
@@ -159,6 +160,7 @@
 #define FLAG_LOAD_BALANCE_TH "EAR_LOAD_BALANCE_TH" // Sets a threshold to considere the application is load unbalanced.
 #define FLAG_TURBO_CP        "USE_TURBO_FOR_CP"
 #define FLAG_MIN_CPUFREQ     "EAR_MIN_CPUFREQ" // Sets a minimum CPU frequency policies can set.
+#define FLAG_CPUFREQ_MSR     "EAR_CPUFREQ_MSR" // Sets the CPU frequency writing the HWP/PERF_CTL MSRs (Intel only).
 #define FLAG_NTWRK_IMC                                                                                                 \
     "EAR_NTWRK_IMC" // Tells the IMC policy the application uses IMC freq for network operations, making the policy less
                     // aggressive.
@@ -181,6 +183,8 @@
     "EAR_MPI_SAMPLING_ENABLED" // Allows MPI sampling monitoring to be enabled(1) or disabled (0). Default is 1.
 #define FLAG_LOOP_STRATEGY  "EAR_LOOP_STRATEGY"  // Specifies is EARL is dynamic or time guided
 #define FLAG_MPI_MONITORING "EAR_MPI_MONITORING" // Specifies if EARL has to take actions in MPI or not
+#define FLAG_DYNAIS_EVENT_MIX                                                                                          \
+    "EAR_DYNAIS_EVENT_MIX" // Comma separated list of MPI call data (bytes, comm, tag) mixed into the DynAIS event.
 
 #define FLAG_NO_AFFINITY_MASK                                                                                          \
     "EARL_NO_AFFINITY_MASK"                   // Prevents EARL from using the affinity mask. Only for special use cases
@@ -224,6 +228,12 @@
  * They affect features under development.
  * @{
  */
+#define FLAG_ENERGY_NODE_CACHE                                                                                         \
+    "EAR_ENERGY_NODE_CACHE" // EARD reads the node energy plug-in from a background thread and answers from cache. The
+                            // value is the polling period in ms (0 means the plug-in native frequency).
+#define FLAG_HW_ROOT                                                                                                   \
+    "EAR_HW_ROOT" // Folder where the hardware files (/dev/cpu, /sys, /proc/cpuinfo) are searched. It also replaces
+                  // the perf counters by simulated ones. Only read by test builds (HW_FAKE=1).
 /** @} */
 
 /**
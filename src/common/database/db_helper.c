@@ -1455,6 +1455,12 @@ void db_reset_counters()
     current_step_id = -1;
 }
 
+void db_set_counters(int job_id, int step_id)
+{
+    current_job_id  = job_id;
+    current_step_id = step_id;
+}
+
 int db_read_applications(application_t **apps, uint is_learning, int max_apps, char *node_name)
 {
     int num_apps = 0;
@@ -1483,7 +1489,7 @@ int db_read_applications(application_t **apps, uint is_learning, int max_apps, c
            node_name); */
         sprintf(query,
                 "SELECT Learning_applications.* FROM Learning_applications WHERE (job_id > %d AND node_id='%s') OR "
-                "(job_id = %d AND step_id > %d AND node_id = '%s') ORDER BY job_id LIMIT %d",
+                "(job_id = %d AND step_id > %d AND node_id = '%s') ORDER BY job_id, step_id LIMIT %d",
                 current_job_id, node_name, current_job_id, current_step_id, node_name, max_apps);
     } else if (is_learning && node_name == NULL) {
         sprintf(query,
@@ -1503,7 +1509,7 @@ int db_read_applications(application_t **apps, uint is_learning, int max_apps, c
                 "SELECT Applications.* FROM Applications INNER JOIN Signatures ON signature_id = Signatures.id WHERE "
                 "(job_id > %d AND node_id='%s') OR "
                 "(job_id = %d AND step_id > %d AND node_id = '%s') AND  "
-                " time > 60 AND DC_power > 100 AND DC_power < 1000 ORDER BY job_id LIMIT %d",
+                " time > 60 AND DC_power > 100 AND DC_power < 1000 ORDER BY job_id, step_id LIMIT %d",
                 current_job_id, node_name, current_job_id, current_step_id, node_name, max_apps);
     } else {
         sprintf(
@@ -120,6 +120,9 @@ int db_read_jobs_query(job_t **jobs, char *query);
 
 void db_reset_counters();
 
+/** Sets the last job and step read by db_read_applications, which reads the applications after them. */
+void db_set_counters(int job_id, int step_id);
+
 /* As the name implies, it checks for the MariaDB/MySQL environment variables
  * (LIBMYSQL_PLUGINS, LIBMYSQL_PLUGIN_DIR, MARIADB_PLUGIN_DIR, LIBMARIADB_PLUGINS, MARIADB_PLUGINS)
  * and unsets them if they are set. Returns true if any of them was found, and false if none was set */
@@ -0,0 +1,57 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <common/config/config_env.h>
+#include <common/hardware/hwroot.h>
+#include <common/sizes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Only the test builds define HW_FAKE=1 (see metrics/tests/Makefile). Otherwise
+// the root is always '/' and FLAG_HW_ROOT is ignored.
+#ifndef HW_FAKE
+#define HW_FAKE 0
+#endif
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static char root[SZ_NAME_SHORT];
+
+static void static_init()
+{
+    char *env;
+    size_t len;
+
+    root[0] = '\0';
+    if (!HW_FAKE) {
+        return;
+    }
+    if ((env = getenv(FLAG_HW_ROOT)) == NULL || strlen(env) == 0) {
+        return;
+    }
+    strncpy(root, env, sizeof(root) - 1);
+    // Removing the final slash, because all paths begin by '/'
+    len = strlen(root);
+    while (len > 0 && root[len - 1] == '/') {
+        root[--len] = '\0';
+    }
+}
+
+int hwroot_is_enabled()
+{
+    pthread_once(&once, static_init);
+    return (root[0] != '\0');
+}
+
+char *hwroot_get()
+{
+    pthread_once(&once, static_init);
+    return root;
+}
@@ -0,0 +1,28 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef COMMON_HARDWARE_HWROOT_H
+#define COMMON_HARDWARE_HWROOT_H
+
+// Simulated hardware support, only in test builds (HW_FAKE=1). If FLAG_HW_ROOT
+// is defined, the hardware files (/dev/cpu/*/msr, /sys/devices/system/cpu,
+// /sys/class/hwmon, powercap, perf PMUs and /proc/cpuinfo) are searched under
+// that folder instead of '/', and the perf counters are simulated (see
+// metrics/common/perf_fake.h).
+
+// Returns 1 if the hardware root is redirected.
+int hwroot_is_enabled();
+
+// Returns the root prefix (up to SZ_NAME_SHORT characters), or an empty string
+// if it is not redirected. To be used as:
+//     sprintf(path, "%s/dev/cpu/%d/msr", hwroot_get(), cpu);
+char *hwroot_get();
+
+#endif // COMMON_HARDWARE_HWROOT_H
@@ -11,6 +11,7 @@
 // #define SHOW_DEBUGS 1
 
 #include <asm/sigcontext.h>
+#include <common/hardware/hwroot.h>
 #include <common/hardware/topology_asm.h>
 #include <common/output/debug.h>
 #include <common/sizes.h>
@@ -104,7 +105,7 @@ static state_t topology_init_thread(topology_t *topo, uint thread)
     topo->cpus[thread].core_id    = thread;
     topo->cpus[thread].is_thread  = 0;
     // Getting the sibling_id and is_thread
-    sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", thread);
+    sprintf(path, "%s/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", hwroot_get(), thread);
 
     if ((fd = open(path, F_RD)) >= 0) {
         do {
@@ -136,7 +137,7 @@ static state_t topology_init_thread(topology_t *topo, uint thread)
         debug("Could not open '%s': %s", path, strerror(errno));
     }
     // Getting the socket_id
-    sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", thread);
+    sprintf(path, "%s/sys/devices/system/cpu/cpu%d/topology/physical_package_id", hwroot_get(), thread);
     aux1 = 0;
     aux2 = 0;
     memset(buffer, 0, buff_size);
@@ -159,7 +160,7 @@ static state_t topology_init_thread(topology_t *topo, uint thread)
     }
     // Getting cache information, iterating by index
     for (i = 0; i < TOPO_CL_COUNT; ++i) {
-        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level", thread, i);
+        sprintf(path, "%s/sys/devices/system/cpu/cpu%d/cache/index%d/level", hwroot_get(), thread, i);
         aux1 = 0; // Total bytes
         aux2 = 0; // Returned bytes
         aux3 = 0; // level
@@ -178,7 +179,7 @@ static state_t topology_init_thread(topology_t *topo, uint thread)
             // debug("Could not open '%s': %s", path, strerror(errno));
             continue;
         }
-        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/id", thread, i);
+        sprintf(path, "%s/sys/devices/system/cpu/cpu%d/cache/index%d/id", hwroot_get(), thread, i);
         aux1 = 0; // Total bytes
         aux2 = 0; // Returned bytes
         memset(buffer, 0, buff_size);
@@ -242,8 +243,13 @@ static void topology_cpuinfo(topology_t *topo)
     char *col  = NULL; // column
     size_t len = 0;
     int cpu    = 0;
+    char path[PATH_MAX];
+    FILE *cpuinfo;
 
-    FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+    sprintf(path, "%s/proc/cpuinfo", hwroot_get());
+    if ((cpuinfo = fopen(path, "r")) == NULL) {
+        return;
+    }
     while (getline(&line, &len, cpuinfo) != -1) {
         if (strncmp(line, "apicid", 6) == 0) {
             if ((col = strchr(line, ':')) != NULL) {
@@ -271,7 +277,7 @@ static int cpu_exists(uint cpu)
 {
     char path[PATH_MAX];
     //
-    sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+    sprintf(path, "%s/sys/devices/system/cpu/cpu%d", hwroot_get(), cpu);
     //
     if (access(path, F_OK) != 0) {
         debug("CPU '%s' not found", path);
@@ -79,6 +79,20 @@ typedef struct power_limit {
     unsigned int type;
 } power_limit_t;
 
+/* Incremental powercap status (EAR_RC_GET_POWERCAP_DELTA). Each node replies
+ * the change of its contribution since the previous epoch, and only its greedy
+ * entry if it changed (requested and extra_power to 0 means it left the list).
+ * In a resync each node replies its full contribution and takes it as the
+ * base. total_nodes counts the nodes replying, a node that cannot compute the
+ * change because it missed an epoch adds PC_DELTA_UNSYNCED instead. */
+#define PC_DELTA_UNSYNCED 0x10000
+
+typedef struct pc_delta_req {
+    int32_t release_power;
+    uint32_t epoch;
+    uint32_t resync;
+} pc_delta_req_t;
+
 typedef struct risk_dec {
     unsigned long target;
     risk_t level;
@@ -96,6 +110,7 @@ typedef union req_data {
     powercap_opt_t pc_opt;
     eargm_req_t eargm_data;
     int release_power;
+    pc_delta_req_t pc_delta;
     char *message;
 } req_data_t;
 
@@ -247,6 +262,7 @@ typedef struct power_check {
 #define EAR_RC_RELEASE_IDLE        707
 #define EAR_RC_DEF_POWERCAP        708
 #define EAR_RC_GET_POWER           709
+#define EAR_RC_GET_POWERCAP_DELTA  710
 
 /* EARGM commands*/
 #define EARGM_NEW_JOB  801
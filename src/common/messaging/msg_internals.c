@@ -30,13 +30,16 @@
 #include <common/config.h>
 #include <common/states.h>
 #include <common/system/poll.h>
+#include <common/system/time.h>
 #include <common/types/job.h>
 
 #include <common/messaging/msg_conf.h>
 #include <common/messaging/msg_internals.h>
+#include <common/messaging/msg_wire.h>
 
-int remote_connected = 0;
-int eards_sfd        = -1;
+/* Per thread, the EARD remote API workers propagate concurrently */
+__thread int remote_connected = 0;
+__thread int eards_sfd        = -1;
 
 // 2000 and 65535
 #define DAEMON_EXTERNAL_CONNEXIONS 256
@@ -52,87 +55,130 @@ uint32_t _get_sec_key()
 }
 #endif
 
-static uint64_t max_socket_tries = MAX_SOCKET_COMM_TRIES;
+/* Framed I/O. The sockets are used with MSG_DONTWAIT and, when a call would
+ * block, the operation waits for the socket readiness with poll until its
+ * deadline (socket_timeout milliseconds since the operation started). A frame
+ * is a request_header_t followed by its payload, both sent with a single
+ * sendmsg when the socket buffer allows it. */
+static ullong socket_timeout = MAX_SOCKET_COMM_TIMEOUT;
 
-int _read(int fd, void *data, size_t ssize)
+/* Returns 1 when fd is ready for events, or 0 if the deadline expired. */
+static int msg_wait(int fd, short events, timestamp *start)
 {
-
+    struct pollfd pfd = {.fd = fd, .events = events};
+    ullong elapsed;
     int ret;
-    int tries = 0;
-    uint to_read, read = 0;
-    uint must_abort = 0;
 
-    to_read = ssize;
     do {
-        ret = recv(fd, (char *) data + read, to_read, MSG_DONTWAIT);
-        if (ret > 0) {
-            read += ret;
-            to_read -= ret;
-        } else if (ret < 0) {
-            if ((errno == EWOULDBLOCK) || (errno == EAGAIN))
-                tries++;
-            else {
-                must_abort = 1;
-                verbose(VAPI, "_read: Error sending command to eard %s,%d", strerror(errno), errno);
-            }
-        } else if (ret == 0) {
-            debug("_read: read returns 0 bytes");
-            must_abort = 1;
+        elapsed = timestamp_diffnow(start, TIME_MSECS);
+        if (elapsed >= socket_timeout) {
+            return 0;
         }
-    } while ((tries < max_socket_tries) && (to_read > 0) &&
-             (must_abort == 0)); // still pending to send and hasn't tried more than MAX_TRIES
+        ret = poll(&pfd, 1, (int) (socket_timeout - elapsed));
+    } while (ret < 0 && errno == EINTR);
+    // Errors and hang ups are reported by the next send or recv
+    return (ret != 0);
+}
 
-    if (tries >= max_socket_tries) {
-        debug("_read: tries reached in read%d", tries);
+/* Consumes bytes from the head of the message vector, dropping the empty entries. */
+static void msg_iov_advance(struct msghdr *msg, size_t bytes)
+{
+    while (msg->msg_iovlen > 0 && bytes >= msg->msg_iov->iov_len) {
+        bytes -= msg->msg_iov->iov_len;
+        msg->msg_iov++;
+        msg->msg_iovlen--;
     }
-
-    /* If there are bytes left to send, we return a 0 */
-    if (to_read) {
-        debug("_read: return non blocking command with 0");
-        return read;
+    if (msg->msg_iovlen > 0) {
+        msg->msg_iov->iov_base = (char *) msg->msg_iov->iov_base + bytes;
+        msg->msg_iov->iov_len -= bytes;
     }
-    debug("_read: exiting send successfully");
-    return read;
 }
 
-int _write(int fd, void *data, size_t ssize)
+/* Sends or receives the whole vector (which is modified). Returns the bytes transferred, which are less than
+ * requested if the peer closed the connection, there was an error or the deadline expired. */
+static ssize_t msg_transfer(int fd, struct iovec *iov, int iovcnt, int sending)
 {
-    int ret;
-    int tries = 0;
-    uint to_send, sent = 0;
-    uint must_abort = 0;
-
-    to_send = ssize;
-    do {
-        ret = send(fd, (char *) data + sent, to_send, MSG_DONTWAIT);
+    struct msghdr msg = {.msg_iov = iov, .msg_iovlen = iovcnt};
+    ssize_t done      = 0;
+    ssize_t ret;
+    timestamp start;
+
+    timestamp_getfast(&start);
+    msg_iov_advance(&msg, 0);
+    while (msg.msg_iovlen > 0) {
+        if (sending) {
+            ret = sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } else {
+            ret = recvmsg(fd, &msg, MSG_DONTWAIT);
+        }
         if (ret > 0) {
-            sent += ret;
-            to_send -= ret;
-        } else if (ret < 0) {
-            if ((errno == EWOULDBLOCK) || (errno == EAGAIN))
-                tries++;
-            else {
-                must_abort = 1;
-                verbose(VAPI, "_write: Error sending command to eard %s,%d", strerror(errno), errno);
-            }
+            done += ret;
+            msg_iov_advance(&msg, ret);
         } else if (ret == 0) {
-            debug("_write: send returns 0 bytes");
-            must_abort = 1;
+            debug("msg_transfer: fd %d closed by the peer after %ld bytes", fd, done);
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            verbose(VAPI, "msg_transfer: Error %s eard %s,%d", (sending) ? "sending to" : "receiving from",
+                    strerror(errno), errno);
+            break;
+        } else if (!msg_wait(fd, (sending) ? POLLOUT : POLLIN, &start)) {
+            debug("msg_transfer: fd %d timeout after %lu ms and %ld bytes", fd, timestamp_diffnow(&start, TIME_MSECS),
+                  done);
+            errno = ETIMEDOUT;
+            break;
         }
-    } while ((tries < max_socket_tries) && (to_send > 0) &&
-             (must_abort == 0)); // still pending to send and hasn't tried more than MAX_TRIES
+    }
+    return done;
+}
 
-    if (tries >= max_socket_tries) {
-        debug("_write: tries reached in send %d", tries);
+int _read(int fd, void *data, size_t ssize)
+{
+    struct iovec iov = {.iov_base = data, .iov_len = ssize};
+    return (int) msg_transfer(fd, &iov, 1, 0);
+}
+
+int _write(int fd, void *data, size_t ssize)
+{
+    struct iovec iov = {.iov_base = data, .iov_len = ssize};
+    return (int) msg_transfer(fd, &iov, 1, 1);
+}
+
+/* Sends the header and the payload of a frame. The payload is encoded if the peer supports it (see msg_wire.h),
+ * and sent as it is if the encoding fails or it is not smaller, as small arrays of integers. */
+static state_t msg_send_frame(int fd, int type, char *data, size_t size)
+{
+    char *encoded         = NULL;
+    size_t encoded_size   = 0;
+    request_header_t head = {.type = type, .size = size};
+    state_t s             = EAR_SUCCESS;
+
+    if (data != NULL && size > 0 && msg_wire_peer(fd) >= MSG_PROTO_WIRE && msg_wire_supported(type)) {
+        if (state_fail(msg_wire_encode(type, data, size, &encoded, &encoded_size))) {
+            debug("msg_send_frame: type %d sent without encoding (%s)", type, state_msg);
+        } else if (encoded_size >= size) {
+            debug("msg_send_frame: type %d sent without encoding (%lu bytes encoded in %lu)", type, size,
+                  encoded_size);
+            free(encoded);
+            encoded = NULL;
+        } else {
+            head.type = type | EAR_TYPE_WIRE;
+            head.size = encoded_size;
+            data      = encoded;
+            size      = encoded_size;
+        }
     }
 
-    /* If there are bytes left to send, we return a 0 */
-    if (to_send) {
-        debug("_write: return non blocking command with 0");
-        return sent;
+    struct iovec iov[2] = {{.iov_base = &head, .iov_len = sizeof(request_header_t)},
+                           {.iov_base = data, .iov_len = (data != NULL) ? size : 0}};
+    size_t total        = iov[0].iov_len + iov[1].iov_len;
+
+    if (msg_transfer(fd, iov, 2, 1) < total) {
+        s = EAR_ERROR;
     }
-    debug("_write: exiting send successfully");
-    return sent;
+    free(encoded);
+    return s;
 }
 
 // based on getaddrinfo man pages
@@ -204,8 +250,10 @@ int wait_for_client(int s, struct sockaddr_in *client)
         return EAR_ERROR;
     }
 
-    char conection_ok = 1;
+    // The handshake byte is the protocol, the peer is not encoding until it sends an encoded command
+    char conection_ok = MSG_PROTO_WIRE;
     debug("connection received");
+    msg_wire_peer_set(new_sock, MSG_PROTO_LEGACY);
     _write(new_sock, &conection_ok, sizeof(char));
     debug("handshake sent");
 
@@ -355,6 +403,9 @@ size_t get_command_size(request_t *command, char **data_to_send)
         case EAR_RC_GET_POWERCAP_STATUS:
             size += sizeof(int);
             break;
+        case EAR_RC_GET_POWERCAP_DELTA:
+            size += sizeof(pc_delta_req_t);
+            break;
         case EAR_RC_SEND_MESSAGE:
             size += sizeof(char) * (strlen(command->my_req.message) + 1);
             break;
@@ -445,27 +496,8 @@ int send_command(request_t *command)
 
 int send_non_block_data(int fd, size_t size, char *data, int type)
 {
-    int32_t ret;
-    // int tries=0;
-    // uint to_send,sent=0;
-    // uint must_abort=0;
-
-    /* Prepare header */
-    request_header_t head;
-    head.type = type;
-    head.size = size;
-
-    /* Send header, blocking */
-    ret = _write(fd, &head, sizeof(request_header_t));
-
-    if (ret < sizeof(request_header_t)) {
-        verbose(VAPI, "send_non_block_data:error sending request_header in non_block command");
-        return 0;
-    }
-
-    ret = _write(eards_sfd, data, size);
-    if (ret < size) {
-        debug("send_non_block_data: return non blocking command with EAR_ERROR");
+    if (state_fail(msg_send_frame(fd, type, data, size))) {
+        verbose(VAPI, "send_non_block_data: error sending the frame (%s)", strerror(errno));
         return EAR_ERROR;
     }
     return EAR_SUCCESS;
@@ -473,23 +505,11 @@ int send_non_block_data(int fd, size_t size, char *data, int type)
 
 int send_data(int fd, size_t size, char *data, int type)
 {
-    int32_t ret;
-    request_header_t head;
-    head.size = size;
-    head.type = type;
-
     debug("send_data: sending data of size %lu and type %d", size, type);
-    debug("send_data: data sizes: %lu and %lu", sizeof(head.size), sizeof(head.type));
-    ret = write(fd, &head, sizeof(request_header_t));
-    if (ret < sizeof(request_header_t))
-        return EAR_ERROR;
-    debug("send_data: sent head, %d bytes", ret);
-
-    ret = write(fd, data, size);
-    if (ret < size)
+    if (state_fail(msg_send_frame(fd, type, data, size))) {
         return EAR_ERROR;
-    debug("send_data: sent data, %d bytes", ret);
-
+    }
+    debug("send_data: sent header and %lu bytes", size);
     return EAR_SUCCESS;
 }
 
@@ -504,7 +524,9 @@ request_header_t receive_data(int fd, void **data)
 {
     int32_t ret;
     request_header_t head;
-    char *read_data;
+    char *read_data, *decoded;
+    size_t decoded_size;
+    uint encoded;
     head.type = 0;
     head.size = 0;
 
@@ -519,6 +541,10 @@ request_header_t receive_data(int fd, void **data)
     }
 
     /* Check header */
+    encoded = (head.type & EAR_TYPE_WIRE) && msg_wire_supported(head.type & ~EAR_TYPE_WIRE);
+    if (encoded) {
+        head.type &= ~EAR_TYPE_WIRE;
+    }
     if (head.size < 1 || !is_valid_type(head.type)) {
         if (head.type != EAR_TYPE_APP_STATUS) {
             if (!((head.size == 0) && (head.type == 0))) {
@@ -547,6 +573,20 @@ request_header_t receive_data(int fd, void **data)
         head.size = 0;
         return head;
     }
+    if (encoded) {
+        if (state_fail(msg_wire_decode(head.type, read_data, head.size, &decoded, &decoded_size))) {
+            verbose(VAPI, "receive_data: error decoding data of type %d (%s)", head.type, state_msg);
+            free(read_data);
+            head.type = EAR_ERROR;
+            head.size = 0;
+            return head;
+        }
+        free(read_data);
+        read_data = decoded;
+        head.size = decoded_size;
+        // The peer encodes, so the answers to it are encoded too
+        msg_wire_peer_set(fd, MSG_PROTO_WIRE);
+    }
     *data = read_data;
 
     debug("receive_data: returning from receive_data with type %d and size %u", head.type, head.size);
@@ -667,8 +707,10 @@ int remote_connect(char *nodename, uint port)
 
     if (read(sfd, &conection_ok, sizeof(char)) > 0) {
         debug("Handshake with server completed.");
+        msg_wire_peer_set(sfd, (uint) conection_ok);
     } else {
         debug("Couldn't complete handshake with server, closing conection.");
+        msg_wire_peer_reset(sfd);
         close(sfd);
         return EAR_ERROR;
     }
@@ -685,6 +727,7 @@ int remote_disconnect()
 {
     remote_connected = 0;
     debug("normal disconnect, closing fd %d\n", eards_sfd);
+    msg_wire_peer_reset(eards_sfd);
     close(eards_sfd);
     return EAR_SUCCESS;
 }
@@ -692,6 +735,7 @@ int remote_disconnect()
 int remote_disconnect_fd(int sfd)
 {
     debug("targeted disconnect, closing fd %d\n", sfd);
+    msg_wire_peer_reset(sfd);
     close(sfd);
     return EAR_SUCCESS;
 }
@@ -1200,8 +1244,8 @@ void send_command_all(request_t command, cluster_conf_t *my_cluster_conf)
     free(ip_counts);
 }
 
-#define INCREASE_MAX_TRIES_IF_DATA_READ_FAILS 0
-#define MAX_TRIES_UPPER_LIMIT                 3
+#define INCREASE_TIMEOUT_IF_DATA_READ_FAILS 0
+#define MAX_TIMEOUT_UPPER_LIMIT             3
 #define MAX_CALLER_CONNECTIONS                50
 
 request_header_t data_all_nodes(request_t *command, cluster_conf_t *my_cluster_conf, void **data)
@@ -1306,13 +1350,13 @@ request_header_t data_all_nodes(request_t *command, cluster_conf_t *my_cluster_c
                     failed_is[count_failed] = i;
                     failed_js[count_failed] = j;
                     count_failed++;
-#if INCREASE_MAX_TRIES_IF_DATA_READ_FAILS
-                    /* If the data READ fails (with the message working) we increase the max tries by 10% of the
-                     * original value, with MAX_TRIES_UPPER_LIMIT * MAX_SOCKET_COMM_TRIES as a ceiling value*/
+#if INCREASE_TIMEOUT_IF_DATA_READ_FAILS
+                    /* If the data READ fails (with the message working) we increase the timeout by 10% of the
+                     * original value, with MAX_TIMEOUT_UPPER_LIMIT * MAX_SOCKET_COMM_TIMEOUT as a ceiling value*/
                     if (head.type == EAR_TIMEOUT) {
-                        max_socket_tries = (max_socket_tries > MAX_SOCKET_COMM_TRIES * MAX_TRIES_UPPER_LIMIT)
-                                               ? max_socket_tries
-                                               : max_socket_tries + MAX_SOCKET_COMM_TRIES / 10;
+                        socket_timeout = (socket_timeout > MAX_SOCKET_COMM_TIMEOUT * MAX_TIMEOUT_UPPER_LIMIT)
+                                             ? socket_timeout
+                                             : socket_timeout + MAX_SOCKET_COMM_TIMEOUT / 10;
                     }
 #endif
                 }
@@ -1435,88 +1479,77 @@ powercap_status_t *memmap_powercap_status(char *final_data, int *size)
     return status;
 }
 
+/* Appends the greedy nodes of new_status to the status in final_data, which is reallocated. The layout is the one of
+ * mem_alloc_char_powercap_status, so the greedy data of final_data is moved after the new nodes. */
+static char *append_powercap_greedy(char *final_data, powercap_status_t *new_status)
+{
+    uint num_old = ((powercap_status_t *) final_data)->num_greedy;
+    uint num_new = new_status->num_greedy;
+    char *nodes_end;
+    int size;
+
+    memmap_powercap_status(final_data, &size);
+    final_data = realloc(final_data, size + num_new * (sizeof(int) + sizeof(greedy_bytes_t)));
+    nodes_end  = &final_data[sizeof(powercap_status_t) + num_old * sizeof(int)];
+
+    memmove(&nodes_end[num_new * sizeof(int)], nodes_end, num_old * sizeof(greedy_bytes_t));
+    memcpy(nodes_end, new_status->greedy_nodes, num_new * sizeof(int));
+    memcpy(&nodes_end[num_new * sizeof(int) + num_old * sizeof(greedy_bytes_t)], new_status->greedy_data,
+           num_new * sizeof(greedy_bytes_t));
+    ((powercap_status_t *) final_data)->num_greedy = num_old + num_new;
+    return final_data;
+}
+
 request_header_t process_data(request_header_t data_head, char **temp_data_ptr, char **final_data_ptr, int final_size)
 {
     char *temp_data  = *temp_data_ptr;
     char *final_data = *final_data_ptr;
+    powercap_status_t *status, *new_status;
+    pc_release_data_t *released, *new_released;
+    power_check_t *power, *new_power;
     request_header_t head;
     head.type = data_head.type;
+
+    /* The first reply becomes the aggregated data. The caller frees *temp_data_ptr, which is NULL then. */
+    if (final_data == NULL) {
+        final_data     = temp_data;
+        *temp_data_ptr = NULL;
+        head.size      = data_head.size;
+        if (data_head.type == EAR_TYPE_POWER_STATUS) {
+            memmap_powercap_status(final_data, &final_size);
+        }
+        *final_data_ptr = final_data;
+        return head;
+    }
     switch (data_head.type) {
         case EAR_TYPE_POWER_CHECK:
+            power     = (power_check_t *) final_data;
+            new_power = (power_check_t *) temp_data;
+            power->power += new_power->power;
+            power->num_nodes += new_power->num_nodes;
             head.size = data_head.size;
-            if (final_data != NULL) {
-                power_check_t *power     = (power_check_t *) final_data;
-                power_check_t *new_power = (power_check_t *) temp_data;
-                power->power += new_power->power;
-                power->num_nodes += new_power->num_nodes;
-            } else {
-                final_data = realloc(final_data, final_size + data_head.size);
-                memcpy(&final_data[final_size], temp_data, data_head.size);
-                // cannot directly assign final_data = temp_data because the caller function (data_all_nodes) frees
-                // temp_data after passing through here
-            }
             break;
         case EAR_TYPE_RELEASED:
+            released     = (pc_release_data_t *) final_data;
+            new_released = (pc_release_data_t *) temp_data;
+            released->released += new_released->released;
             head.size = data_head.size;
-            if (final_data != NULL) {
-                pc_release_data_t *released     = (pc_release_data_t *) final_data;
-                pc_release_data_t *new_released = (pc_release_data_t *) temp_data;
-                released->released += new_released->released;
-            } else {
-                final_data = realloc(final_data, final_size + data_head.size);
-                memcpy(&final_data[final_size], temp_data, data_head.size);
-                // cannot directly assign final_data = temp_data because the caller function (data_all_nodes) frees
-                // temp_data after passing through here
-            }
             break;
         case EAR_TYPE_POWER_STATUS:
-            if (final_data != NULL) {
-                int total_size                     = 0;
-                powercap_status_t *original_status = memmap_powercap_status(final_data, &final_size);
-                total_size += final_size - sizeof(powercap_status_t);
-                powercap_status_t *new_status = memmap_powercap_status(temp_data, &final_size);
-                total_size += final_size;
-
-                char *final_status        = calloc(total_size, sizeof(char));
-                powercap_status_t *status = (powercap_status_t *) final_status;
-
-                status->total_nodes    = original_status->total_nodes + new_status->total_nodes;
-                status->idle_nodes     = original_status->idle_nodes + new_status->idle_nodes;
-                status->released       = original_status->released + new_status->released;
-                status->num_greedy     = original_status->num_greedy + new_status->num_greedy;
-                status->requested      = original_status->requested + new_status->requested;
-                status->current_power  = original_status->current_power + new_status->current_power;
-                status->total_powercap = original_status->total_powercap + new_status->total_powercap;
-
-                final_size = sizeof(powercap_status_t);
-                memcpy(&final_status[final_size], original_status->greedy_nodes,
-                       sizeof(int) * original_status->num_greedy);
-                final_size += sizeof(int) * original_status->num_greedy;
-                memcpy(&final_status[final_size], new_status->greedy_nodes, sizeof(int) * new_status->num_greedy);
-                final_size += sizeof(int) * new_status->num_greedy;
-
-                memcpy(&final_status[final_size], original_status->greedy_data,
-                       sizeof(greedy_bytes_t) * original_status->num_greedy);
-                final_size += sizeof(greedy_bytes_t) * original_status->num_greedy;
-                memcpy(&final_status[final_size], new_status->greedy_data,
-                       sizeof(greedy_bytes_t) * new_status->num_greedy);
-                final_size += sizeof(greedy_bytes_t) * new_status->num_greedy;
-
-                final_data = realloc(final_data, final_size);
-                memcpy(final_data, final_status, final_size);
-
-                status    = memmap_powercap_status(final_data, &final_size);
-                head.size = final_size;
-                free(final_status);
-
-            } else {
-                final_data = realloc(final_data, final_size + data_head.size);
-                memcpy(&final_data[final_size], temp_data, data_head.size);
-                head.size  = data_head.size;
-                final_data = (char *) memmap_powercap_status(final_data, &final_size);
-                // setting powercap_status pointers to its right value
-                // check if final_size == head.size??
+            /* Reduced in place, only the greedy nodes of the new status are copied */
+            status     = (powercap_status_t *) final_data;
+            new_status = memmap_powercap_status(temp_data, &final_size);
+            status->total_nodes += new_status->total_nodes;
+            status->idle_nodes += new_status->idle_nodes;
+            status->released += new_status->released;
+            status->requested += new_status->requested;
+            status->current_power += new_status->current_power;
+            status->total_powercap += new_status->total_powercap;
+            if (new_status->num_greedy > 0) {
+                final_data = append_powercap_greedy(final_data, new_status);
             }
+            memmap_powercap_status(final_data, &final_size);
+            head.size = final_size;
             break;
         default:
             final_data = realloc(final_data, final_size + data_head.size);
@@ -32,7 +32,8 @@
 #include <common/types/configuration/cluster_conf.h>
 #include <common/types/risk.h>
 
-/** Non-blocking version of write*/
+/** Writes ssize bytes, waiting for the socket readiness up to MAX_SOCKET_COMM_TIMEOUT ms.
+ * Returns the bytes written. */
 int _write(int fd, void *data, size_t ssize);
 
 /** Connects with the EARD running in the given nodename. The current implementation supports a single command per
@@ -85,6 +86,9 @@ request_header_t correct_data_prop_nodes(request_t *command, int self_ip, uint p
 /** Recieves data from a previously send command */
 request_header_t receive_data(int fd, void **data);
 
+/** Aggregates a reply (*temp_data_ptr) into the data received before (*final_data_ptr, of final_size bytes). Power
+ * checks, released power and powercap status are reduced in place, and the rest of types are concatenated. The first
+ * reply is taken without copying it and *temp_data_ptr is set to NULL. */
 request_header_t process_data(request_header_t data_head, char **temp_data_ptr, char **final_data_ptr, int final_size);
 
 request_header_t data_all_nodes(request_t *command, cluster_conf_t *my_cluster_conf, void **data);
@@ -0,0 +1,901 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/messaging/msg_conf.h>
+#include <common/messaging/msg_wire.h>
+#include <common/output/debug.h>
+#include <common/system/poll.h>
+
+/* Field kinds */
+#define WIRE_UINT   0 // Unsigned integer of 1, 2, 4 or 8 bytes
+#define WIRE_SINT   1 // Signed integer of 1, 2, 4 or 8 bytes
+#define WIRE_DOUBLE 2
+#define WIRE_BYTES  3 // Byte block, like the strings
+#define WIRE_RECORD 4 // Struct with its own schema
+#define WIRE_FIXED  5 // 4 bytes sent as they are, floats and IPv4 addresses
+
+/* Wire types */
+#define WT_VARINT  0
+#define WT_FIXED64 1
+#define WT_LENGTH  2
+#define WT_FIXED32 5
+
+#define WIRE_MAX_ID 64
+
+typedef struct wire_schema wire_schema_t;
+
+typedef struct wire_field {
+    uint id;
+    uint kind;
+    size_t offset;
+    size_t size;  // Of each element
+    uint count;   // Elements of an array, 1 if it is not an array
+    const wire_schema_t *sub;
+} wire_field_t;
+
+struct wire_schema {
+    const wire_field_t *fields;
+    uint num_fields;
+};
+
+#define member_size(t, m) sizeof(((t *) 0)->m)
+#define FIELD(id, kind, t, m) {id, kind, offsetof(t, m), member_size(t, m), 1, NULL}
+#define ARRAY(id, kind, t, m) {id, kind, offsetof(t, m), member_size(t, m[0]), member_size(t, m) / member_size(t, m[0]), NULL}
+#define RECORD(id, t, m, s)   {id, WIRE_RECORD, offsetof(t, m), member_size(t, m), 1, &s}
+#define RECORDS(id, t, m, s)                                                                                           \
+    {id, WIRE_RECORD, offsetof(t, m), member_size(t, m[0]), member_size(t, m) / member_size(t, m[0]), &s}
+#define SCHEMA(name, ...)                                                                                              \
+    static const wire_field_t name##_fields[] = {__VA_ARGS__};                                                        \
+    static const wire_schema_t name           = {name##_fields, sizeof(name##_fields) / sizeof(wire_field_t)}
+
+/*
+ * Schemas. The ids of a schema can not be reused for a different field.
+ */
+
+typedef struct wire_greedy {
+    int32_t node;
+    greedy_bytes_t data;
+} wire_greedy_t;
+
+SCHEMA(request_schema, FIELD(1, WIRE_UINT, internal_request_t, req),
+       FIELD(2, WIRE_UINT, internal_request_t, node_dist),
+#if USE_SEC_KEY_RC
+       FIELD(3, WIRE_UINT, internal_request_t, sec_key),
+#endif
+       FIELD(4, WIRE_SINT, internal_request_t, time_code), FIELD(5, WIRE_SINT, internal_request_t, num_nodes));
+
+SCHEMA(node_info_schema, FIELD(1, WIRE_UINT, status_node_info_t, avg_freq),
+       FIELD(2, WIRE_UINT, status_node_info_t, max_freq), FIELD(3, WIRE_UINT, status_node_info_t, temp),
+       FIELD(4, WIRE_UINT, status_node_info_t, power), FIELD(5, WIRE_UINT, status_node_info_t, rep_power));
+
+SCHEMA(app_info_schema, FIELD(1, WIRE_UINT, app_info_t, job_id), FIELD(2, WIRE_UINT, app_info_t, step_id));
+
+SCHEMA(policy_info_schema, FIELD(1, WIRE_UINT, eard_policy_info_t, freq), FIELD(2, WIRE_UINT, eard_policy_info_t, th),
+       FIELD(3, WIRE_UINT, eard_policy_info_t, id));
+
+#ifdef V5_COMPAT
+SCHEMA(status_schema, FIELD(8, WIRE_FIXED, status_t, ip), FIELD(2, WIRE_UINT, status_t, ok),
+       RECORD(3, status_t, node, node_info_schema), RECORD(4, status_t, app, app_info_schema),
+       FIELD(5, WIRE_UINT, status_t, eardbd_connected), FIELD(6, WIRE_UINT, status_t, num_policies),
+       RECORDS(7, status_t, policy_conf, policy_info_schema));
+#else
+SCHEMA(status_schema, FIELD(8, WIRE_FIXED, status_t, ip), FIELD(2, WIRE_UINT, status_t, ok),
+       RECORD(3, status_t, node, node_info_schema), RECORD(4, status_t, app, app_info_schema),
+       FIELD(5, WIRE_UINT, status_t, eardbd_connected));
+#endif
+
+SCHEMA(stalls_schema, FIELD(1, WIRE_UINT, stalls_t, fetch_decode), FIELD(2, WIRE_UINT, stalls_t, resources),
+       FIELD(3, WIRE_UINT, stalls_t, memory));
+
+SCHEMA(gpu_app_schema, FIELD(1, WIRE_DOUBLE, gpu_app_t, GPU_power), FIELD(2, WIRE_UINT, gpu_app_t, GPU_freq),
+       FIELD(3, WIRE_UINT, gpu_app_t, GPU_mem_freq), FIELD(4, WIRE_UINT, gpu_app_t, GPU_util),
+       FIELD(5, WIRE_UINT, gpu_app_t, GPU_mem_util),
+#if WF_SUPPORT
+       FIELD(6, WIRE_FIXED, gpu_app_t, GPU_GFlops), FIELD(7, WIRE_UINT, gpu_app_t, GPU_temp),
+       FIELD(8, WIRE_UINT, gpu_app_t, GPU_temp_mem)
+#endif
+);
+
+SCHEMA(gpu_sig_schema, FIELD(1, WIRE_SINT, gpu_signature_t, num_gpus),
+       RECORDS(2, gpu_signature_t, gpu_data, gpu_app_schema));
+
+SCHEMA(cpu_sig_schema, FIELD(1, WIRE_UINT, cpu_signature_t, devs_count), ARRAY(2, WIRE_SINT, cpu_signature_t, temp),
+       ARRAY(3, WIRE_DOUBLE, cpu_signature_t, cpu_power), ARRAY(4, WIRE_DOUBLE, cpu_signature_t, dram_power));
+
+SCHEMA(ps_sig_schema, FIELD(1, WIRE_UINT, proc_stat_signature_t, cpu_util),
+       FIELD(2, WIRE_UINT, proc_stat_signature_t, mem_util));
+
+SCHEMA(cache_schema, FIELD(1, WIRE_UINT, cache_signature_t, l1d_misses), FIELD(2, WIRE_UINT, cache_signature_t, l2_misses),
+       FIELD(3, WIRE_UINT, cache_signature_t, l3_misses), FIELD(4, WIRE_UINT, cache_signature_t, ll_misses),
+       FIELD(5, WIRE_UINT, cache_signature_t, l1d_hits), FIELD(6, WIRE_UINT, cache_signature_t, l2_hits),
+       FIELD(7, WIRE_UINT, cache_signature_t, l3_hits), FIELD(8, WIRE_UINT, cache_signature_t, ll_hits),
+       FIELD(9, WIRE_UINT, cache_signature_t, l1d_accesses), FIELD(10, WIRE_UINT, cache_signature_t, l2_accesses),
+       FIELD(11, WIRE_UINT, cache_signature_t, l3_accesses), FIELD(12, WIRE_UINT, cache_signature_t, ll_accesses),
+       FIELD(13, WIRE_DOUBLE, cache_signature_t, l1d_miss_rate), FIELD(14, WIRE_DOUBLE, cache_signature_t, l2_miss_rate),
+       FIELD(15, WIRE_DOUBLE, cache_signature_t, l3_miss_rate), FIELD(16, WIRE_DOUBLE, cache_signature_t, ll_miss_rate),
+       FIELD(17, WIRE_DOUBLE, cache_signature_t, l1d_hit_rate), FIELD(18, WIRE_DOUBLE, cache_signature_t, l2_hit_rate),
+       FIELD(19, WIRE_DOUBLE, cache_signature_t, l3_hit_rate), FIELD(20, WIRE_DOUBLE, cache_signature_t, ll_hit_rate));
+
+/* The ids 20 and 25 to 28 were the metrics structs sent as byte blocks */
+SCHEMA(signature_schema, FIELD(1, WIRE_DOUBLE, signature_t, DC_power), FIELD(2, WIRE_DOUBLE, signature_t, DRAM_power),
+       FIELD(3, WIRE_DOUBLE, signature_t, PCK_power), FIELD(4, WIRE_DOUBLE, signature_t, DC_job_power),
+       FIELD(5, WIRE_DOUBLE, signature_t, PCK_job_power), FIELD(6, WIRE_DOUBLE, signature_t, DRAM_job_power),
+       FIELD(7, WIRE_DOUBLE, signature_t, EDP), FIELD(8, WIRE_DOUBLE, signature_t, GBS),
+       FIELD(9, WIRE_DOUBLE, signature_t, IO_MBS), FIELD(10, WIRE_DOUBLE, signature_t, TPI),
+       FIELD(11, WIRE_DOUBLE, signature_t, CPI), FIELD(12, WIRE_DOUBLE, signature_t, Gflops),
+       FIELD(13, WIRE_DOUBLE, signature_t, time), ARRAY(14, WIRE_UINT, signature_t, FLOPS),
+       FIELD(15, WIRE_UINT, signature_t, L1_misses), FIELD(16, WIRE_UINT, signature_t, L2_misses),
+       FIELD(17, WIRE_UINT, signature_t, L3_misses), FIELD(18, WIRE_UINT, signature_t, instructions),
+       FIELD(19, WIRE_UINT, signature_t, cycles), RECORD(29, signature_t, stalls, stalls_schema),
+       FIELD(21, WIRE_UINT, signature_t, avg_f), FIELD(22, WIRE_UINT, signature_t, avg_imc_f),
+       FIELD(23, WIRE_UINT, signature_t, def_f), FIELD(24, WIRE_DOUBLE, signature_t, perc_MPI),
+#if USE_GPUS
+       RECORD(30, signature_t, gpu_sig, gpu_sig_schema),
+#endif
+#if WF_SUPPORT
+       RECORD(31, signature_t, cpu_sig, cpu_sig_schema),
+#endif
+       RECORD(32, signature_t, ps_sig, ps_sig_schema), RECORD(33, signature_t, cache, cache_schema));
+
+SCHEMA(app_status_schema, FIELD(7, WIRE_FIXED, app_status_t, ip), FIELD(2, WIRE_SINT, app_status_t, job_id),
+       FIELD(3, WIRE_SINT, app_status_t, step_id), FIELD(4, WIRE_UINT, app_status_t, nodes),
+       FIELD(5, WIRE_UINT, app_status_t, master_rank), RECORD(6, app_status_t, signature, signature_schema));
+
+SCHEMA(power_check_schema, FIELD(1, WIRE_UINT, power_check_t, power), FIELD(2, WIRE_SINT, power_check_t, num_nodes));
+
+SCHEMA(release_schema, FIELD(1, WIRE_UINT, pc_release_data_t, released));
+
+SCHEMA(powercap_schema, FIELD(1, WIRE_UINT, powercap_status_t, total_nodes),
+       FIELD(2, WIRE_UINT, powercap_status_t, idle_nodes), FIELD(3, WIRE_UINT, powercap_status_t, released),
+       FIELD(4, WIRE_UINT, powercap_status_t, requested), FIELD(5, WIRE_UINT, powercap_status_t, total_idle_power),
+       FIELD(6, WIRE_UINT, powercap_status_t, current_power), FIELD(7, WIRE_UINT, powercap_status_t, total_powercap));
+
+SCHEMA(greedy_schema, FIELD(5, WIRE_FIXED, wire_greedy_t, node), FIELD(2, WIRE_UINT, wire_greedy_t, data.requested),
+       FIELD(3, WIRE_UINT, wire_greedy_t, data.stress), FIELD(4, WIRE_UINT, wire_greedy_t, data.extra_power));
+
+/* The data of the commands, the member of my_req used by each request (see get_command_size) */
+SCHEMA(new_conf_schema, FIELD(1, WIRE_UINT, new_conf_t, max_freq), FIELD(2, WIRE_UINT, new_conf_t, min_freq),
+       FIELD(3, WIRE_UINT, new_conf_t, th), FIELD(4, WIRE_UINT, new_conf_t, p_states),
+       FIELD(5, WIRE_UINT, new_conf_t, p_id));
+
+SCHEMA(power_limit_schema, FIELD(1, WIRE_UINT, power_limit_t, limit), FIELD(2, WIRE_UINT, power_limit_t, type));
+
+SCHEMA(risk_schema, FIELD(1, WIRE_UINT, risk_dec_t, target), FIELD(2, WIRE_UINT, risk_dec_t, level));
+
+SCHEMA(policy_cont_schema, FIELD(1, WIRE_BYTES, new_policy_cont_t, name),
+       FIELD(2, WIRE_UINT, new_policy_cont_t, def_freq), ARRAY(3, WIRE_DOUBLE, new_policy_cont_t, settings));
+
+SCHEMA(job_schema, FIELD(1, WIRE_UINT, job_t, id), FIELD(2, WIRE_UINT, job_t, step_id),
+#if WF_SUPPORT
+       FIELD(3, WIRE_UINT, job_t, local_id),
+#endif
+       FIELD(4, WIRE_BYTES, job_t, user_id), FIELD(5, WIRE_BYTES, job_t, group_id),
+       FIELD(6, WIRE_BYTES, job_t, app_id), FIELD(7, WIRE_BYTES, job_t, user_acc),
+       FIELD(8, WIRE_BYTES, job_t, energy_tag), FIELD(9, WIRE_SINT, job_t, start_time),
+       FIELD(10, WIRE_SINT, job_t, end_time), FIELD(11, WIRE_SINT, job_t, start_mpi_time),
+       FIELD(12, WIRE_SINT, job_t, end_mpi_time), FIELD(13, WIRE_BYTES, job_t, policy),
+       FIELD(14, WIRE_DOUBLE, job_t, th), FIELD(15, WIRE_UINT, job_t, procs), FIELD(16, WIRE_UINT, job_t, type),
+       FIELD(17, WIRE_UINT, job_t, def_f));
+
+SCHEMA(new_job_schema, RECORD(1, new_job_req_t, job, job_schema), FIELD(2, WIRE_UINT, new_job_req_t, is_mpi),
+       FIELD(3, WIRE_UINT, new_job_req_t, is_learning));
+
+SCHEMA(end_job_schema, FIELD(1, WIRE_UINT, end_job_req_t, jid), FIELD(2, WIRE_UINT, end_job_req_t, sid));
+
+SCHEMA(new_task_schema, FIELD(1, WIRE_UINT, new_task_req_t, jid), FIELD(2, WIRE_UINT, new_task_req_t, sid),
+       FIELD(3, WIRE_SINT, new_task_req_t, pid), FIELD(4, WIRE_BYTES, new_task_req_t, mask),
+       FIELD(5, WIRE_UINT, new_task_req_t, num_cpus));
+
+SCHEMA(end_task_schema, FIELD(1, WIRE_UINT, end_task_req_t, jid), FIELD(2, WIRE_UINT, end_task_req_t, sid),
+       FIELD(3, WIRE_SINT, end_task_req_t, pid), FIELD(4, WIRE_BYTES, end_task_req_t, mask),
+       FIELD(5, WIRE_UINT, end_task_req_t, num_cpus));
+
+SCHEMA(release_power_schema, FIELD(1, WIRE_SINT, req_data_t, release_power));
+
+SCHEMA(pc_delta_schema, FIELD(1, WIRE_SINT, pc_delta_req_t, release_power), FIELD(2, WIRE_UINT, pc_delta_req_t, epoch),
+       FIELD(3, WIRE_UINT, pc_delta_req_t, resync));
+
+/* The greedy nodes and their extra power follow the struct, they are sent in the tail */
+SCHEMA(pc_opt_schema, FIELD(1, WIRE_UINT, powercap_opt_t, num_greedy),
+       FIELD(2, WIRE_UINT, powercap_opt_t, cluster_perc_power));
+
+SCHEMA(eargm_schema, FIELD(1, WIRE_UINT, eargm_req_t, num_nodes), FIELD(2, WIRE_UINT, eargm_req_t, pc_change));
+
+/* The schema of the data of a request and the size of its struct. The requests without one, like
+ * EAR_RC_SEND_MESSAGE, send their data in the tail. */
+static const wire_schema_t *command_schema(uint req, size_t *size)
+{
+    switch (req) {
+        case EAR_RC_MAX_FREQ:
+        case EAR_RC_SET_FREQ:
+        case EAR_RC_DEF_FREQ:
+        case EAR_RC_INC_TH:
+        case EAR_RC_RED_PSTATE:
+        case EAR_RC_NEW_TH:
+            *size = sizeof(new_conf_t);
+            return &new_conf_schema;
+        case EAR_RC_SET_POWER:
+        case EAR_RC_INC_POWER:
+        case EAR_RC_RED_POWER:
+            *size = sizeof(power_limit_t);
+            return &power_limit_schema;
+        case EAR_RC_SET_RISK:
+            *size = sizeof(risk_dec_t);
+            return &risk_schema;
+        case EAR_RC_SET_POLICY:
+            *size = sizeof(new_policy_cont_t);
+            return &policy_cont_schema;
+        case EAR_RC_NEW_JOB:
+        case EAR_RC_NEW_JOB_LIST:
+            *size = sizeof(new_job_req_t);
+            return &new_job_schema;
+        case EAR_RC_END_JOB:
+        case EAR_RC_END_JOB_LIST:
+            *size = sizeof(end_job_req_t);
+            return &end_job_schema;
+        case EAR_RC_NEW_TASK:
+            *size = sizeof(new_task_req_t);
+            return &new_task_schema;
+        case EAR_RC_END_TASK:
+            *size = sizeof(end_task_req_t);
+            return &end_task_schema;
+        case EAR_RC_GET_POWERCAP_STATUS:
+            *size = sizeof(int);
+            return &release_power_schema;
+        case EAR_RC_GET_POWERCAP_DELTA:
+            *size = sizeof(pc_delta_req_t);
+            return &pc_delta_schema;
+        case EAR_RC_SET_POWERCAP_OPT:
+            *size = sizeof(powercap_opt_t);
+            return &pc_opt_schema;
+        case EARGM_NEW_JOB:
+        case EARGM_END_JOB:
+        case EARGM_INC_PC:
+        case EARGM_SET_PC:
+        case EARGM_RED_PC:
+        case EARGM_RESET_PC:
+            *size = sizeof(eargm_req_t);
+            return &eargm_schema;
+    }
+    *size = 0;
+    return NULL;
+}
+
+/* Types sent as arrays of structs */
+static const wire_schema_t *array_schema(int type, size_t *stride)
+{
+    switch (type) {
+        case EAR_TYPE_STATUS:
+            *stride = sizeof(status_t);
+            return &status_schema;
+        case EAR_TYPE_APP_STATUS:
+            *stride = sizeof(app_status_t);
+            return &app_status_schema;
+        case EAR_TYPE_POWER_CHECK:
+            *stride = sizeof(power_check_t);
+            return &power_check_schema;
+        case EAR_TYPE_RELEASED:
+            *stride = sizeof(pc_release_data_t);
+            return &release_schema;
+    }
+    return NULL;
+}
+
+/*
+ * Encoding
+ */
+
+typedef struct wire_buffer {
+    char *data;
+    size_t len;
+    size_t cap;
+    uint error;
+} wire_buffer_t;
+
+static void wb_put(wire_buffer_t *b, const void *src, size_t n)
+{
+    size_t cap;
+    char *data;
+
+    if (b->error) {
+        return;
+    }
+    if (b->len + n > b->cap) {
+        cap = ear_max(b->cap * 2, b->len + n + 256);
+        if ((data = realloc(b->data, cap)) == NULL) {
+            b->error = 1;
+            return;
+        }
+        b->data = data;
+        b->cap  = cap;
+    }
+    memcpy(&b->data[b->len], src, n);
+    b->len += n;
+}
+
+static uint varint_put(uint8_t *out, ullong v)
+{
+    uint n = 0;
+
+    do {
+        out[n] = v & 0x7f;
+        v >>= 7;
+        if (v) {
+            out[n] |= 0x80;
+        }
+        n++;
+    } while (v);
+    return n;
+}
+
+static void wb_varint(wire_buffer_t *b, ullong v)
+{
+    uint8_t out[10];
+    wb_put(b, out, varint_put(out, v));
+}
+
+static void wb_key(wire_buffer_t *b, uint id, uint wt)
+{
+    wb_varint(b, (id << 3) | wt);
+}
+
+static ullong load_uint(const char *p, size_t size)
+{
+    uint8_t u8;
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+
+    switch (size) {
+        case 1:
+            memcpy(&u8, p, 1);
+            return u8;
+        case 2:
+            memcpy(&u16, p, 2);
+            return u16;
+        case 4:
+            memcpy(&u32, p, 4);
+            return u32;
+    }
+    memcpy(&u64, p, 8);
+    return u64;
+}
+
+static llong load_sint(const char *p, size_t size)
+{
+    int8_t s8;
+    int16_t s16;
+    int32_t s32;
+    int64_t s64;
+
+    switch (size) {
+        case 1:
+            memcpy(&s8, p, 1);
+            return s8;
+        case 2:
+            memcpy(&s16, p, 2);
+            return s16;
+        case 4:
+            memcpy(&s32, p, 4);
+            return s32;
+    }
+    memcpy(&s64, p, 8);
+    return s64;
+}
+
+static void store_int(char *p, size_t size, ullong v)
+{
+    uint8_t u8   = v;
+    uint16_t u16 = v;
+    uint32_t u32 = v;
+
+    switch (size) {
+        case 1:
+            memcpy(p, &u8, 1);
+            return;
+        case 2:
+            memcpy(p, &u16, 2);
+            return;
+        case 4:
+            memcpy(p, &u32, 4);
+            return;
+    }
+    memcpy(p, &v, 8);
+}
+
+static size_t trimmed_size(const char *p, size_t size)
+{
+    while (size > 0 && p[size - 1] == 0) {
+        size--;
+    }
+    return size;
+}
+
+static void encode_record(wire_buffer_t *b, const wire_schema_t *schema, const char *rec);
+
+/* Writes a record prefixed by its length */
+static void encode_nested(wire_buffer_t *b, const wire_schema_t *schema, const char *rec)
+{
+    uint8_t prefix[10];
+    size_t start, len;
+    uint n;
+
+    // One byte is reserved for the length, which is moved if it needs more
+    wb_put(b, "", 1);
+    start = b->len;
+    encode_record(b, schema, rec);
+    if (b->error) {
+        return;
+    }
+    len = b->len - start;
+    n   = varint_put(prefix, len);
+    if (n > 1) {
+        wb_put(b, prefix, n - 1);
+        if (b->error) {
+            return;
+        }
+        memmove(&b->data[start + n - 1], &b->data[start], len);
+    }
+    memcpy(&b->data[start - 1], prefix, n);
+}
+
+static void encode_element(wire_buffer_t *b, const wire_field_t *f, const char *p)
+{
+    llong s;
+    size_t n;
+
+    switch (f->kind) {
+        case WIRE_UINT:
+            wb_key(b, f->id, WT_VARINT);
+            wb_varint(b, load_uint(p, f->size));
+            break;
+        case WIRE_SINT:
+            s = load_sint(p, f->size);
+            wb_key(b, f->id, WT_VARINT);
+            wb_varint(b, ((ullong) s << 1) ^ (ullong) (s >> 63));
+            break;
+        case WIRE_DOUBLE:
+            wb_key(b, f->id, WT_FIXED64);
+            wb_put(b, p, sizeof(double));
+            break;
+        case WIRE_FIXED:
+            wb_key(b, f->id, WT_FIXED32);
+            wb_put(b, p, sizeof(uint32_t));
+            break;
+        case WIRE_BYTES:
+            n = trimmed_size(p, f->size);
+            wb_key(b, f->id, WT_LENGTH);
+            wb_varint(b, n);
+            wb_put(b, p, n);
+            break;
+        case WIRE_RECORD:
+            wb_key(b, f->id, WT_LENGTH);
+            encode_nested(b, f->sub, p);
+            break;
+    }
+}
+
+static void encode_record(wire_buffer_t *b, const wire_schema_t *schema, const char *rec)
+{
+    const wire_field_t *f;
+    uint i, j, last;
+
+    for (i = 0; i < schema->num_fields; i++) {
+        f = &schema->fields[i];
+        // Arrays are sent up to the last element not 0, which keeps the index of the rest
+        for (last = f->count; last > 0 && trimmed_size(&rec[f->offset + (last - 1) * f->size], f->size) == 0;
+             last--)
+            ;
+        for (j = 0; j < last; j++) {
+            encode_element(b, f, &rec[f->offset + j * f->size]);
+        }
+    }
+}
+
+static void encode_blob(wire_buffer_t *b, const char *p, size_t n)
+{
+    wb_varint(b, n);
+    wb_put(b, p, n);
+}
+
+static state_t encode_powercap(wire_buffer_t *b, char *data, size_t size)
+{
+    powercap_status_t *status = (powercap_status_t *) data;
+    wire_greedy_t greedy;
+    size_t nodes_off, data_off;
+    uint i;
+
+    if (size < sizeof(powercap_status_t)) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    nodes_off = sizeof(powercap_status_t);
+    data_off  = nodes_off + status->num_greedy * sizeof(int32_t);
+    if (data_off + status->num_greedy * sizeof(greedy_bytes_t) > size) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    wb_varint(b, 1 + status->num_greedy);
+    encode_nested(b, &powercap_schema, data);
+    for (i = 0; i < status->num_greedy; i++) {
+        memcpy(&greedy.node, &data[nodes_off + i * sizeof(int32_t)], sizeof(int32_t));
+        memcpy(&greedy.data, &data[data_off + i * sizeof(greedy_bytes_t)], sizeof(greedy_bytes_t));
+        encode_nested(b, &greedy_schema, (char *) &greedy);
+    }
+    return EAR_SUCCESS;
+}
+
+/* The command is the internal_request_t, the nodes and the data of the request (see get_command_size). The
+ * data is sent as the record of its member of my_req, and what follows it (or all of it if the request has no
+ * schema) as the tail. */
+static state_t encode_command(wire_buffer_t *b, char *data, size_t size)
+{
+    internal_request_t *request = (internal_request_t *) data;
+    size_t nodes_size           = (request->num_nodes > 0) ? request->num_nodes * sizeof(int32_t) : 0;
+    size_t data_off             = sizeof(internal_request_t) + nodes_size;
+    const wire_schema_t *schema;
+    size_t req_size;
+
+    if (size < data_off) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    schema = command_schema(request->req, &req_size);
+    if (schema != NULL && size - data_off < req_size) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    wb_varint(b, 4);
+    encode_nested(b, &request_schema, data);
+    encode_blob(b, &data[sizeof(internal_request_t)], nodes_size);
+    if (schema != NULL) {
+        encode_nested(b, schema, &data[data_off]);
+    } else {
+        encode_blob(b, "", 0);
+    }
+    encode_blob(b, &data[data_off + req_size], size - data_off - req_size);
+    return EAR_SUCCESS;
+}
+
+uint msg_wire_supported(int type)
+{
+    size_t stride;
+    return (array_schema(type, &stride) != NULL || type == EAR_TYPE_POWER_STATUS || type == EAR_TYPE_COMMAND);
+}
+
+state_t msg_wire_encode(int type, char *data, size_t size, char **encoded, size_t *encoded_size)
+{
+    const wire_schema_t *schema;
+    wire_buffer_t b = {0};
+    state_t s       = EAR_SUCCESS;
+    size_t stride, i;
+
+    wb_varint(&b, WIRE_VERSION);
+    if ((schema = array_schema(type, &stride)) != NULL) {
+        wb_varint(&b, size / stride);
+        for (i = 0; i < size / stride; i++) {
+            encode_nested(&b, schema, &data[i * stride]);
+        }
+    } else if (type == EAR_TYPE_POWER_STATUS) {
+        s = encode_powercap(&b, data, size);
+    } else if (type == EAR_TYPE_COMMAND) {
+        s = encode_command(&b, data, size);
+    } else {
+        s = EAR_ERROR;
+        state_msg = "type without encoding";
+    }
+    if (b.error) {
+        s         = EAR_ERROR;
+        state_msg = Generr.alloc_error;
+    }
+    if (state_fail(s)) {
+        free(b.data);
+        return s;
+    }
+    debug("Type %d encoded from %lu to %lu bytes", type, size, b.len);
+    *encoded      = b.data;
+    *encoded_size = b.len;
+    return EAR_SUCCESS;
+}
+
+/*
+ * Decoding
+ */
+
+typedef struct wire_reader {
+    const uint8_t *p;
+    size_t len;
+    size_t pos;
+} wire_reader_t;
+
+static state_t rd_varint(wire_reader_t *r, ullong *v)
+{
+    uint shift = 0;
+    uint8_t byte;
+
+    *v = 0;
+    do {
+        if (r->pos == r->len || shift > 63) {
+            return EAR_ERROR;
+        }
+        byte = r->p[r->pos++];
+        *v |= (ullong) (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return EAR_SUCCESS;
+}
+
+static state_t rd_length(wire_reader_t *r, wire_reader_t *sub)
+{
+    ullong len;
+
+    if (state_fail(rd_varint(r, &len)) || len > r->len - r->pos) {
+        return EAR_ERROR;
+    }
+    sub->p   = &r->p[r->pos];
+    sub->len = len;
+    sub->pos = 0;
+    r->pos += len;
+    return EAR_SUCCESS;
+}
+
+static state_t rd_skip(wire_reader_t *r, uint wt)
+{
+    wire_reader_t sub;
+    ullong v;
+
+    switch (wt) {
+        case WT_VARINT:
+            return rd_varint(r, &v);
+        case WT_FIXED64:
+            if (r->len - r->pos < sizeof(double)) {
+                return EAR_ERROR;
+            }
+            r->pos += sizeof(double);
+            return EAR_SUCCESS;
+        case WT_FIXED32:
+            if (r->len - r->pos < sizeof(uint32_t)) {
+                return EAR_ERROR;
+            }
+            r->pos += sizeof(uint32_t);
+            return EAR_SUCCESS;
+        case WT_LENGTH:
+            return rd_length(r, &sub);
+    }
+    return EAR_ERROR;
+}
+
+static uint wire_type(uint kind)
+{
+    switch (kind) {
+        case WIRE_UINT:
+        case WIRE_SINT:
+            return WT_VARINT;
+        case WIRE_DOUBLE:
+            return WT_FIXED64;
+        case WIRE_FIXED:
+            return WT_FIXED32;
+    }
+    return WT_LENGTH;
+}
+
+/* Decodes over rec, which must be 0 */
+static state_t decode_record(wire_reader_t *r, const wire_schema_t *schema, char *rec)
+{
+    uint seen[WIRE_MAX_ID] = {0};
+    const wire_field_t *f;
+    wire_reader_t sub;
+    ullong key, v;
+    uint id, wt, i;
+    char *dst;
+
+    while (r->pos < r->len) {
+        if (state_fail(rd_varint(r, &key))) {
+            return EAR_ERROR;
+        }
+        id = key >> 3;
+        wt = key & 0x7;
+        for (i = 0, f = NULL; i < schema->num_fields && f == NULL; i++) {
+            if (schema->fields[i].id == id) {
+                f = &schema->fields[i];
+            }
+        }
+        // Unknown fields, from newer versions, are skipped
+        if (f == NULL || id >= WIRE_MAX_ID || wt != wire_type(f->kind) || seen[id] == f->count) {
+            if (state_fail(rd_skip(r, wt))) {
+                return EAR_ERROR;
+            }
+            continue;
+        }
+        dst = &rec[f->offset + seen[id] * f->size];
+        seen[id]++;
+        switch (f->kind) {
+            case WIRE_UINT:
+            case WIRE_SINT:
+                if (state_fail(rd_varint(r, &v))) {
+                    return EAR_ERROR;
+                }
+                if (f->kind == WIRE_SINT) {
+                    v = (v >> 1) ^ (~(v & 1) + 1);
+                }
+                store_int(dst, f->size, v);
+                break;
+            case WIRE_DOUBLE:
+                if (r->len - r->pos < sizeof(double)) {
+                    return EAR_ERROR;
+                }
+                memcpy(dst, &r->p[r->pos], sizeof(double));
+                r->pos += sizeof(double);
+                break;
+            case WIRE_FIXED:
+                if (r->len - r->pos < sizeof(uint32_t)) {
+                    return EAR_ERROR;
+                }
+                memcpy(dst, &r->p[r->pos], sizeof(uint32_t));
+                r->pos += sizeof(uint32_t);
+                break;
+            case WIRE_BYTES:
+                if (state_fail(rd_length(r, &sub))) {
+                    return EAR_ERROR;
+                }
+                memcpy(dst, sub.p, ear_min(sub.len, f->size));
+                break;
+            case WIRE_RECORD:
+                if (state_fail(rd_length(r, &sub)) || state_fail(decode_record(&sub, f->sub, dst))) {
+                    return EAR_ERROR;
+                }
+                break;
+        }
+    }
+    return EAR_SUCCESS;
+}
+
+static state_t decode_nested(wire_reader_t *r, const wire_schema_t *schema, char *rec)
+{
+    wire_reader_t sub;
+
+    if (state_fail(rd_length(r, &sub))) {
+        return EAR_ERROR;
+    }
+    return decode_record(&sub, schema, rec);
+}
+
+static state_t decode_powercap(wire_reader_t *r, ullong count, char **data, size_t *size)
+{
+    powercap_status_t status = {0};
+    wire_greedy_t greedy;
+    size_t nodes_off, data_off;
+    char *out;
+    uint i;
+
+    if (count == 0 || state_fail(decode_nested(r, &powercap_schema, (char *) &status))) {
+        return EAR_ERROR;
+    }
+    status.num_greedy = count - 1;
+    nodes_off         = sizeof(powercap_status_t);
+    data_off          = nodes_off + status.num_greedy * sizeof(int32_t);
+    *size             = data_off + status.num_greedy * sizeof(greedy_bytes_t);
+    if ((out = calloc(1, *size)) == NULL) {
+        return EAR_ERROR;
+    }
+    memcpy(out, &status, sizeof(powercap_status_t));
+    for (i = 0; i < status.num_greedy; i++) {
+        memset(&greedy, 0, sizeof(wire_greedy_t));
+        if (state_fail(decode_nested(r, &greedy_schema, (char *) &greedy))) {
+            free(out);
+            return EAR_ERROR;
+        }
+        memcpy(&out[nodes_off + i * sizeof(int32_t)], &greedy.node, sizeof(int32_t));
+        memcpy(&out[data_off + i * sizeof(greedy_bytes_t)], &greedy.data, sizeof(greedy_bytes_t));
+    }
+    *data = out;
+    return EAR_SUCCESS;
+}
+
+static state_t decode_command(wire_reader_t *r, ullong count, char **data, size_t *size)
+{
+    internal_request_t request = {0};
+    wire_reader_t nodes, rec, tail;
+    const wire_schema_t *schema;
+    size_t data_off, req_size;
+    char *out;
+
+    if (count < 4 || state_fail(decode_nested(r, &request_schema, (char *) &request)) ||
+        state_fail(rd_length(r, &nodes)) || state_fail(rd_length(r, &rec)) || state_fail(rd_length(r, &tail))) {
+        return EAR_ERROR;
+    }
+    schema            = command_schema(request.req, &req_size);
+    request.num_nodes = nodes.len / sizeof(int32_t);
+    data_off          = sizeof(internal_request_t) + nodes.len;
+    *size             = data_off + req_size + tail.len;
+    if ((out = calloc(1, *size)) == NULL) {
+        return EAR_ERROR;
+    }
+    memcpy(out, &request, sizeof(internal_request_t));
+    memcpy(&out[sizeof(internal_request_t)], nodes.p, nodes.len);
+    if (schema != NULL && state_fail(decode_record(&rec, schema, &out[data_off]))) {
+        free(out);
+        return EAR_ERROR;
+    }
+    memcpy(&out[data_off + req_size], tail.p, tail.len);
+    *data = out;
+    return EAR_SUCCESS;
+}
+
+state_t msg_wire_decode(int type, char *encoded, size_t encoded_size, char **data, size_t *size)
+{
+    wire_reader_t r = {(uint8_t *) encoded, encoded_size, 0};
+    const wire_schema_t *schema;
+    ullong version, count, i;
+    size_t stride;
+    char *out;
+
+    // Newer versions only add fields, which are skipped
+    if (state_fail(rd_varint(&r, &version)) || state_fail(rd_varint(&r, &count)) || count > encoded_size) {
+        return_msg(EAR_ERROR, "malformed encoded payload");
+    }
+    if ((schema = array_schema(type, &stride)) != NULL) {
+        if (count == 0 || (out = calloc(count, stride)) == NULL) {
+            return_msg(EAR_ERROR, Generr.alloc_error);
+        }
+        for (i = 0; i < count; i++) {
+            if (state_fail(decode_nested(&r, schema, &out[i * stride]))) {
+                free(out);
+                return_msg(EAR_ERROR, "malformed encoded record");
+            }
+        }
+        *data = out;
+        *size = count * stride;
+    } else if (type == EAR_TYPE_POWER_STATUS) {
+        if (state_fail(decode_powercap(&r, count, data, size))) {
+            return_msg(EAR_ERROR, "malformed encoded powercap status");
+        }
+    } else if (type == EAR_TYPE_COMMAND) {
+        if (state_fail(decode_command(&r, count, data, size))) {
+            return_msg(EAR_ERROR, "malformed encoded command");
+        }
+    } else {
+        return_msg(EAR_ERROR, "type without encoding");
+    }
+    debug("Type %d version %llu decoded from %lu to %lu bytes", type, version, encoded_size, *size);
+    return EAR_SUCCESS;
+}
+
+/*
+ * Peers
+ */
+
+static uint8_t peer_proto[AFD_MAX];
+
+void msg_wire_peer_set(int fd, uint proto)
+{
+    if (fd >= 0 && fd < AFD_MAX) {
+        peer_proto[fd] = (uint8_t) proto;
+    }
+}
+
+void msg_wire_peer_reset(int fd)
+{
+    if (fd >= 0 && fd < AFD_MAX) {
+        peer_proto[fd] = 0;
+    }
+}
+
+uint msg_wire_peer(int fd)
+{
+    if (fd >= 0 && fd < AFD_MAX && peer_proto[fd] != 0) {
+        return peer_proto[fd];
+    }
+    return MSG_PROTO_LEGACY;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _MSG_WIRE_H
+#define _MSG_WIRE_H
+
+#include <common/states.h>
+#include <common/types/generic.h>
+
+/* Compact encoding of the remote API commands and replies. A payload is a
+ * version and a list of records, and a record is a list of tagged fields:
+ *
+ *     payload = varint(version) varint(count) count * (varint(length) record)
+ *     field   = varint(id << 3 | wire type) value
+ *
+ * The wire type is 0 for varints (zigzag for signed fields), 1 for 8 bytes
+ * doubles, 5 for 4 bytes sent as they are (floats and IPv4 addresses) and 2
+ * for length prefixed values (byte blocks and nested records). Fields equal
+ * to 0 are not sent, byte blocks are sent without the trailing zeros and
+ * arrays up to their last element not 0. The decoder skips the fields it does
+ * not know and leaves to 0 the ones not received, so fields can be added to
+ * the schemas in msg_wire.c without breaking older daemons.
+ *
+ * Every struct is described field by field, also the metrics of the
+ * signature. A command is the request record, the nodes, the record of the
+ * member of my_req used by the request and a tail with the bytes following
+ * it (the greedy nodes of EAR_RC_SET_POWERCAP_OPT, the text of
+ * EAR_RC_SEND_MESSAGE). The pointers of the structs are not sent.
+ *
+ * The encoded payloads travel with the type of the structs OR EAR_TYPE_WIRE,
+ * and receive_data returns them decoded into the structs, so the rest of the
+ * remote API is not aware of the encoding. A payload is sent as the struct
+ * when the encoding is not smaller. The server sends its protocol in
+ * the connection handshake byte (the old daemons send MSG_PROTO_LEGACY), a
+ * client encodes the commands if the server supports it, and the server
+ * encodes the replies of the encoded commands. Mixed version clusters keep
+ * using the structs between the nodes not supporting it. */
+
+#define WIRE_VERSION  1
+#define EAR_TYPE_WIRE 0x10000
+
+#define MSG_PROTO_LEGACY 1
+#define MSG_PROTO_WIRE   2
+
+/** Returns 1 if the payloads of the type have an encoding. */
+uint msg_wire_supported(int type);
+
+/** Encodes size bytes of data of the type. The encoded payload is allocated in *encoded. */
+state_t msg_wire_encode(int type, char *data, size_t size, char **encoded, size_t *encoded_size);
+
+/** Decodes an encoded payload of the type (without EAR_TYPE_WIRE) in the layout sent by the remote API. The data is
+ * allocated in *data. */
+state_t msg_wire_decode(int type, char *encoded, size_t encoded_size, char **data, size_t *size);
+
+/** Sets the protocol of the peer connected through fd. */
+void msg_wire_peer_set(int fd, uint proto);
+
+/** Forgets the protocol of the peer when fd is closed, so a socket reusing the fd starts as MSG_PROTO_LEGACY. */
+void msg_wire_peer_reset(int fd);
+
+uint msg_wire_peer(int fd);
+
+#endif
@@ -0,0 +1,545 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Checks the encoding of the remote API payloads (msg_wire.h) with the values
+// a cluster sends: the status of the nodes, the applications running, the
+// powercap replies and the commands of econtrol and EARGM. Each payload is
+// encoded and decoded, and the result must be equal to the source. Then every
+// truncation of the encoded payloads must be rejected, and payloads with more
+// records or bigger fields than the structs must be rejected or decoded
+// without writing out of them. The sizes are reported, a payload whose
+// encoding is not smaller is sent as the struct.
+//
+//     ./msg_wire
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/messaging/msg_conf.h>
+#include <common/messaging/msg_wire.h>
+
+#define RECORDS 16 // Nodes replying
+#define GREEDY  2  // Greedy nodes of the powercap replies
+
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+static int32_t node_ip(uint i)
+{
+    return (int32_t) htonl(0x0a000100 + i);
+}
+
+/* A node of a CPU only cluster running an MPI application */
+static void fill_signature(signature_t *s, uint i)
+{
+    uint f;
+
+    s->DC_power       = 352.7 + i;
+    s->DRAM_power     = 21.3;
+    s->PCK_power      = 240.1 + i;
+    s->DC_job_power   = 352.7 + i;
+    s->PCK_job_power  = 240.1 + i;
+    s->DRAM_job_power = 21.3;
+    s->time           = 12.31;
+    s->EDP            = s->time * s->time * s->DC_power;
+    s->GBS            = 45.62;
+    s->IO_MBS         = 1.25;
+    s->TPI            = 3.42;
+    s->CPI            = 0.81;
+    s->Gflops         = 120.5;
+    for (f = 0; f < FLOPS_EVENTS; f += 2) {
+        s->FLOPS[f] = 1000000000ULL * (f + 1);
+    }
+    s->L1_misses           = 8100000000ULL;
+    s->L2_misses           = 2300000000ULL;
+    s->L3_misses           = 410000000ULL;
+    s->instructions        = 5100000000000ULL;
+    s->cycles              = 4200000000000ULL;
+    s->stalls.fetch_decode = 310000000000ULL;
+    s->stalls.resources    = 620000000000ULL;
+    s->stalls.memory       = 980000000000ULL;
+    s->avg_f               = 2390000;
+    s->avg_imc_f           = 2000000;
+    s->def_f               = 2400000;
+    s->perc_MPI            = 12.5;
+#if WF_SUPPORT
+    s->cpu_sig.devs_count    = 2;
+    s->cpu_sig.temp[0]       = 55;
+    s->cpu_sig.temp[1]       = 57;
+    s->cpu_sig.cpu_power[0]  = 120.2;
+    s->cpu_sig.cpu_power[1]  = 119.9;
+    s->cpu_sig.dram_power[0] = 10.6;
+    s->cpu_sig.dram_power[1] = 10.7;
+#endif
+    s->ps_sig.cpu_util      = 95;
+    s->ps_sig.mem_util      = 40;
+    s->cache.l1d_misses     = s->L1_misses;
+    s->cache.l2_misses      = s->L2_misses;
+    s->cache.l3_misses      = s->L3_misses;
+    s->cache.l1d_accesses   = 98000000000ULL;
+    s->cache.l1d_miss_rate  = 0.083;
+    s->cache.l1d_hit_rate   = 0.917;
+}
+
+/* The payloads are allocated with calloc, so the padding is 0 as in the decoded ones */
+static char *payload_status(size_t *size)
+{
+    status_t *st = calloc(RECORDS, sizeof(status_t));
+    uint i;
+
+    for (i = 0; i < RECORDS; i++) {
+        st[i].ip               = node_ip(i);
+        st[i].ok               = 1;
+        st[i].node.avg_freq    = 2390000;
+        st[i].node.max_freq    = 2600000;
+        st[i].node.temp        = 45 + i % 5;
+        st[i].node.power       = 350 + i;
+        st[i].node.rep_power   = 360;
+        st[i].app.job_id       = (i < RECORDS / 2) ? 123456 : 0;
+        st[i].app.step_id      = 0;
+        st[i].eardbd_connected = 1;
+#ifdef V5_COMPAT
+        st[i].num_policies = 3;
+        for (uint p = 0; p < 3; p++) {
+            st[i].policy_conf[p].freq = 2400000;
+            st[i].policy_conf[p].th   = (p == 1) ? 5 : 10;
+            st[i].policy_conf[p].id   = p;
+        }
+#endif
+    }
+    *size = RECORDS * sizeof(status_t);
+    return (char *) st;
+}
+
+static char *payload_app_status(size_t *size)
+{
+    app_status_t *st = calloc(RECORDS, sizeof(app_status_t));
+    uint i;
+
+    for (i = 0; i < RECORDS; i++) {
+        st[i].ip          = node_ip(i);
+        st[i].job_id      = 123456;
+        st[i].step_id     = 0;
+        st[i].nodes       = RECORDS;
+        st[i].master_rank = (i == 0) ? 0 : i * 48;
+        fill_signature(&st[i].signature, i);
+    }
+    // A node without application
+    st[RECORDS - 1].job_id = -1;
+    memset(&st[RECORDS - 1].signature, 0, sizeof(signature_t));
+    *size = RECORDS * sizeof(app_status_t);
+    return (char *) st;
+}
+
+/* The node power accumulated by EARGM, and one reply of a node */
+static char *payload_power_check(size_t *size)
+{
+    power_check_t *pc = calloc(1, sizeof(power_check_t));
+
+    pc->power     = 5640;
+    pc->num_nodes = RECORDS;
+    *size         = sizeof(power_check_t);
+    return (char *) pc;
+}
+
+static char *payload_released(size_t *size)
+{
+    pc_release_data_t *rel = calloc(RECORDS, sizeof(pc_release_data_t));
+    uint i;
+
+    for (i = 0; i < RECORDS; i++) {
+        rel[i].released = (i % 3 == 0) ? 50 : 0;
+    }
+    *size = RECORDS * sizeof(pc_release_data_t);
+    return (char *) rel;
+}
+
+/* The reply of a single node, whose encoding is bigger */
+static char *payload_released_node(size_t *size)
+{
+    pc_release_data_t *rel = calloc(1, sizeof(pc_release_data_t));
+
+    rel->released = 50;
+    *size         = sizeof(pc_release_data_t);
+    return (char *) rel;
+}
+
+/* The status, the greedy nodes and their data, as sent by the powercap replies */
+static char *payload_power_status(size_t *size)
+{
+    powercap_status_t *status;
+    greedy_bytes_t *data;
+    int32_t *nodes;
+    char *payload;
+    uint i;
+
+    *size   = sizeof(powercap_status_t) + GREEDY * (sizeof(int32_t) + sizeof(greedy_bytes_t));
+    payload = calloc(1, *size);
+    status  = (powercap_status_t *) payload;
+    nodes   = (int32_t *) &payload[sizeof(powercap_status_t)];
+    data    = (greedy_bytes_t *) &nodes[GREEDY];
+
+    status->total_nodes      = RECORDS;
+    status->idle_nodes       = RECORDS / 2;
+    status->released         = 300;
+    status->requested        = 120;
+    status->total_idle_power = RECORDS / 2 * 180;
+    status->current_power    = 4400;
+    status->total_powercap   = RECORDS * 400;
+    status->num_greedy       = GREEDY;
+    for (i = 0; i < GREEDY; i++) {
+        nodes[i]            = node_ip(i);
+        data[i].requested   = 60;
+        data[i].stress      = 80;
+        data[i].extra_power = 40;
+    }
+    return payload;
+}
+
+/* The request, the nodes to propagate to and the data of the request, as in get_command_size */
+static char *command(uint req, uint nodes, size_t data_size, size_t *size)
+{
+    internal_request_t *request;
+    int32_t *ips;
+    char *payload;
+    uint i;
+
+    *size   = sizeof(internal_request_t) + nodes * sizeof(int32_t) + data_size;
+    payload = calloc(1, *size);
+    request = (internal_request_t *) payload;
+    ips     = (int32_t *) &payload[sizeof(internal_request_t)];
+
+    request->req       = req;
+    request->node_dist = (nodes > 0) ? 2 : 0;
+#if USE_SEC_KEY_RC
+    request->sec_key = 0x5eca1b0b;
+#endif
+    request->time_code = 1713000000 % 86400;
+    request->num_nodes = nodes;
+    for (i = 0; i < nodes; i++) {
+        ips[i] = node_ip(i);
+    }
+    return payload;
+}
+
+#define command_data(p) (&(p)[*size - data_size])
+
+static char *payload_set_freq(size_t *size)
+{
+    size_t data_size = sizeof(new_conf_t);
+    char *p          = command(EAR_RC_SET_FREQ, 4, data_size, size);
+    new_conf_t *conf = (new_conf_t *) command_data(p);
+
+    conf->max_freq = 2200000;
+    return p;
+}
+
+static char *payload_set_policy(size_t *size)
+{
+    size_t data_size        = sizeof(new_policy_cont_t);
+    char *p                 = command(EAR_RC_SET_POLICY, 4, data_size, size);
+    new_policy_cont_t *conf = (new_policy_cont_t *) command_data(p);
+
+    strcpy(conf->name, "min_energy");
+    conf->def_freq    = 2400000;
+    conf->settings[0] = 0.1;
+    return p;
+}
+
+static char *payload_new_job(size_t *size)
+{
+    size_t data_size  = sizeof(new_job_req_t);
+    char *p           = command(EAR_RC_NEW_JOB, 0, data_size, size);
+    new_job_req_t *nj = (new_job_req_t *) command_data(p);
+
+    nj->job.id         = 123456;
+    nj->job.step_id    = 0;
+    nj->job.start_time = 1713000000;
+    nj->job.th         = 0.1;
+    nj->job.procs      = 96;
+    nj->job.def_f      = 2400000;
+    nj->is_mpi         = 1;
+    strcpy(nj->job.user_id, "alice");
+    strcpy(nj->job.group_id, "bsc");
+    strcpy(nj->job.app_id, "lammps");
+    strcpy(nj->job.user_acc, "bsc99");
+    strcpy(nj->job.policy, "min_energy");
+    return p;
+}
+
+static char *payload_new_task(size_t *size)
+{
+    size_t data_size   = sizeof(new_task_req_t);
+    char *p            = command(EAR_RC_NEW_TASK, 0, data_size, size);
+    new_task_req_t *nt = (new_task_req_t *) command_data(p);
+    uint cpu;
+
+    nt->jid      = 123456;
+    nt->pid      = 41234;
+    nt->num_cpus = 48;
+    for (cpu = 0; cpu < 48; cpu++) {
+        CPU_SET(cpu, &nt->mask);
+    }
+    return p;
+}
+
+static char *payload_powercap_status(size_t *size)
+{
+    size_t data_size = sizeof(int);
+    char *p          = command(EAR_RC_GET_POWERCAP_STATUS, 8, data_size, size);
+
+    *(int *) command_data(p) = 50;
+    return p;
+}
+
+/* The greedy nodes and their extra power follow the struct, its pointers are not sent */
+static char *payload_powercap_opt(size_t *size)
+{
+    size_t data_size   = sizeof(powercap_opt_t) + GREEDY * 2 * sizeof(int32_t);
+    char *p            = command(EAR_RC_SET_POWERCAP_OPT, 0, data_size, size);
+    powercap_opt_t *pc = (powercap_opt_t *) command_data(p);
+    int32_t *tail      = (int32_t *) &pc[1];
+    uint i;
+
+    pc->num_greedy         = GREEDY;
+    pc->cluster_perc_power = 10;
+    for (i = 0; i < GREEDY; i++) {
+        tail[i]          = node_ip(i);
+        tail[GREEDY + i] = 40;
+    }
+    return p;
+}
+
+static char *payload_message(size_t *size)
+{
+    char *text       = "maintenance at 14:00";
+    size_t data_size = strlen(text) + 1;
+    char *p          = command(EAR_RC_SEND_MESSAGE, 0, data_size, size);
+
+    strcpy(command_data(p), text);
+    return p;
+}
+
+typedef struct wire_case {
+    char *name;
+    int type;
+    char *(*payload)(size_t *size);
+    uint smaller; // The encoding is expected to be smaller than the struct
+} wire_case_t;
+
+static size_t total_size, total_sent;
+
+static wire_case_t cases[] = {
+    {"status", EAR_TYPE_STATUS, payload_status, 1},
+    {"app_status", EAR_TYPE_APP_STATUS, payload_app_status, 1},
+    {"power_check", EAR_TYPE_POWER_CHECK, payload_power_check, 1},
+    {"released", EAR_TYPE_RELEASED, payload_released, 1},
+    {"released_1", EAR_TYPE_RELEASED, payload_released_node, 0},
+    {"power_status", EAR_TYPE_POWER_STATUS, payload_power_status, 1},
+    {"set_freq", EAR_TYPE_COMMAND, payload_set_freq, 1},
+    {"set_policy", EAR_TYPE_COMMAND, payload_set_policy, 1},
+    {"new_job", EAR_TYPE_COMMAND, payload_new_job, 1},
+    {"new_task", EAR_TYPE_COMMAND, payload_new_task, 1},
+    {"pc_status", EAR_TYPE_COMMAND, payload_powercap_status, 1},
+    {"pc_opt", EAR_TYPE_COMMAND, payload_powercap_opt, 1},
+    {"message", EAR_TYPE_COMMAND, payload_message, 1},
+};
+
+/* Decodes the first size bytes of encoded from a buffer of that size, so reading beyond it is an error */
+static state_t decode_exact(int type, char *encoded, size_t size, char **data, size_t *data_size)
+{
+    char *exact = malloc(ear_max(size, 1));
+    state_t s;
+
+    memcpy(exact, encoded, size);
+    s = msg_wire_decode(type, exact, size, data, data_size);
+    free(exact);
+    return s;
+}
+
+static void test_case(wire_case_t *c)
+{
+    size_t size, encoded_size, decoded_size, cut;
+    char *payload, *encoded, *decoded;
+    uint truncated_ok = 0;
+    char msg[256];
+
+    check(msg_wire_supported(c->type), c->name);
+    payload = c->payload(&size);
+    if (state_fail(msg_wire_encode(c->type, payload, size, &encoded, &encoded_size))) {
+        snprintf(msg, sizeof(msg), "%s: encoding failed: %s", c->name, state_msg);
+        check(0, msg);
+        free(payload);
+        return;
+    }
+    if (state_fail(decode_exact(c->type, encoded, encoded_size, &decoded, &decoded_size))) {
+        snprintf(msg, sizeof(msg), "%s: decoding failed: %s", c->name, state_msg);
+        check(0, msg);
+    } else {
+        snprintf(msg, sizeof(msg), "%s: decoded %lu bytes are not equal to the %lu sent", c->name, decoded_size,
+                 size);
+        check(decoded_size == size && memcmp(decoded, payload, size) == 0, msg);
+        free(decoded);
+    }
+    for (cut = 0; cut < encoded_size; cut++) {
+        if (state_ok(decode_exact(c->type, encoded, cut, &decoded, &decoded_size))) {
+            truncated_ok++;
+            free(decoded);
+        }
+    }
+    snprintf(msg, sizeof(msg), "%s: %u truncated payloads were accepted", c->name, truncated_ok);
+    check(truncated_ok == 0, msg);
+    if (c->smaller) {
+        snprintf(msg, sizeof(msg), "%s: %lu bytes encoded in %lu", c->name, size, encoded_size);
+        check(encoded_size < size, msg);
+    }
+    total_size += size;
+    total_sent += ear_min(size, encoded_size);
+    printf("%-12s %6lu bytes encoded in %5lu, sent as %-6s %lu truncations rejected\n", c->name, size,
+           encoded_size, (encoded_size < size) ? "wire," : "struct,", encoded_size - truncated_ok);
+    free(encoded);
+    free(payload);
+}
+
+static size_t put_varint(char *out, ullong v)
+{
+    size_t n = 0;
+
+    do {
+        out[n] = (v & 0x7f) | ((v >> 7) ? 0x80 : 0);
+        v >>= 7;
+        n++;
+    } while (v);
+    return n;
+}
+
+static void test_oversized()
+{
+    char buf[8192], *decoded;
+    size_t len, rec, sig, decoded_size;
+    new_policy_cont_t *pol;
+    app_status_t *st;
+    uint i, fine;
+
+    // More records than bytes
+    len = put_varint(buf, WIRE_VERSION);
+    len += put_varint(&buf[len], 1ULL << 40);
+    check(state_fail(decode_exact(EAR_TYPE_STATUS, buf, len, &decoded, &decoded_size)), "huge count accepted");
+
+    // More records than the ones sent
+    len = put_varint(buf, WIRE_VERSION);
+    len += put_varint(&buf[len], 3);
+    len += put_varint(&buf[len], 0);
+    check(state_fail(decode_exact(EAR_TYPE_STATUS, buf, len, &decoded, &decoded_size)), "missing records accepted");
+
+    // A record longer than the payload
+    len = put_varint(buf, WIRE_VERSION);
+    len += put_varint(&buf[len], 1);
+    len += put_varint(&buf[len], 1000);
+    check(state_fail(decode_exact(EAR_TYPE_STATUS, buf, len, &decoded, &decoded_size)), "long record accepted");
+
+    // An app status whose signature has a stalls record (field 29) with an
+    // unknown block bigger than the struct and more FLOPS (field 14) than
+    // FLOPS_EVENTS: the block and the elements exceeding the array are skipped
+    sig = 0;
+    sig += put_varint(&buf[4096 + sig], (29 << 3) | 2);
+    sig += put_varint(&buf[4096 + sig], 2 + 3 + 1024 + 2);
+    sig += put_varint(&buf[4096 + sig], (1 << 3) | 0);
+    sig += put_varint(&buf[4096 + sig], 77);
+    sig += put_varint(&buf[4096 + sig], (9 << 3) | 2);
+    sig += put_varint(&buf[4096 + sig], 1024);
+    memset(&buf[4096 + sig], 0x5a, 1024);
+    sig += 1024;
+    sig += put_varint(&buf[4096 + sig], (3 << 3) | 0);
+    sig += put_varint(&buf[4096 + sig], 78);
+    for (i = 0; i < FLOPS_EVENTS + 4; i++) {
+        sig += put_varint(&buf[4096 + sig], (14 << 3) | 0);
+        sig += put_varint(&buf[4096 + sig], i + 1);
+    }
+    rec = 0;
+    rec += put_varint(&buf[2048 + rec], (6 << 3) | 2);
+    rec += put_varint(&buf[2048 + rec], sig);
+    memcpy(&buf[2048 + rec], &buf[4096], sig);
+    rec += sig;
+    len = put_varint(buf, WIRE_VERSION);
+    len += put_varint(&buf[len], 1);
+    len += put_varint(&buf[len], rec);
+    memmove(&buf[len], &buf[2048], rec);
+    len += rec;
+    if (state_fail(decode_exact(EAR_TYPE_APP_STATUS, buf, len, &decoded, &decoded_size))) {
+        check(0, "oversized fields rejected");
+        return;
+    }
+    st   = (app_status_t *) decoded;
+    fine = (decoded_size == sizeof(app_status_t)) && (st->signature.stalls.fetch_decode == 77) &&
+           (st->signature.stalls.resources == 0) && (st->signature.stalls.memory == 78);
+    for (i = 0; fine && i < FLOPS_EVENTS; i++) {
+        fine = (st->signature.FLOPS[i] == i + 1);
+    }
+    fine = fine && (st->signature.avg_f == 0) && (st->ip == 0);
+    check(fine, "oversized fields not skipped");
+    free(decoded);
+
+    // A policy command whose name (field 1 of the data) is bigger than the
+    // struct: the name is cut and the rest of the data is decoded
+    rec = 0;
+    rec += put_varint(&buf[4096 + rec], (1 << 3) | 2);
+    rec += put_varint(&buf[4096 + rec], 1024);
+    memset(&buf[4096 + rec], 'a', 1024);
+    rec += 1024;
+    rec += put_varint(&buf[4096 + rec], (2 << 3) | 0);
+    rec += put_varint(&buf[4096 + rec], 2400000);
+    len = put_varint(buf, WIRE_VERSION);
+    len += put_varint(&buf[len], 4);
+    len += put_varint(&buf[len], 2);
+    len += put_varint(&buf[len], (1 << 3) | 0);
+    len += put_varint(&buf[len], EAR_RC_SET_POLICY);
+    len += put_varint(&buf[len], 0);
+    len += put_varint(&buf[len], rec);
+    memcpy(&buf[len], &buf[4096], rec);
+    len += rec;
+    len += put_varint(&buf[len], 0);
+    if (state_fail(decode_exact(EAR_TYPE_COMMAND, buf, len, &decoded, &decoded_size))) {
+        check(0, "oversized command rejected");
+        return;
+    }
+    pol  = (new_policy_cont_t *) &decoded[sizeof(internal_request_t)];
+    fine = (decoded_size == sizeof(internal_request_t) + sizeof(new_policy_cont_t)) &&
+           (((internal_request_t *) decoded)->req == EAR_RC_SET_POLICY) && (pol->def_freq == 2400000);
+    for (i = 0; fine && i < POLICY_NAME_SIZE; i++) {
+        fine = (pol->name[i] == 'a');
+    }
+    check(fine, "oversized command name not cut");
+    printf("oversized    payloads rejected or cut\n");
+    free(decoded);
+}
+
+int main(int argc, char *argv[])
+{
+    uint i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(wire_case_t); i++) {
+        test_case(&cases[i]);
+    }
+    printf("%-12s %6lu bytes sent in %5lu\n", "total", total_size, total_sent);
+    test_oversized();
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
@@ -33,6 +33,49 @@ void copy_application(application_t *destiny, application_t *source)
     memcpy(destiny, source, sizeof(application_t));
 }
 
+static ulong application_key_hash(application_t *app, uint by_freq)
+{
+    ulong hash = 14695981039346656037UL; // FNV-1a
+    char *c;
+
+    for (c = app->job.app_id; *c != '\0' && c < &app->job.app_id[GENERIC_NAME]; c++) {
+        hash = (hash ^ (uchar) *c) * 1099511628211UL;
+    }
+    return (by_freq) ? (hash ^ app->signature.def_f) * 1099511628211UL : hash;
+}
+
+state_t applications_group(application_t *apps, uint apps_count, uint by_freq, uint *group, uint *groups_count)
+{
+    uint *table; // Index of the first application of each group plus 1, 0 if the slot is empty
+    ulong size, mask, slot;
+    uint a, f;
+
+    *groups_count = 0;
+    for (size = 16; size < 2 * (ulong) apps_count; size <<= 1)
+        ;
+    if ((table = calloc(size, sizeof(uint))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    mask = size - 1;
+    for (a = 0; a < apps_count; ++a) {
+        for (slot = application_key_hash(&apps[a], by_freq) & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+            f = table[slot] - 1;
+            if ((!by_freq || apps[f].signature.def_f == apps[a].signature.def_f) &&
+                strncmp(apps[f].job.app_id, apps[a].job.app_id, GENERIC_NAME) == 0) {
+                break;
+            }
+        }
+        if (table[slot] == 0) {
+            table[slot] = a + 1;
+            group[a]    = (*groups_count)++;
+        } else {
+            group[a] = group[table[slot] - 1];
+        }
+    }
+    free(table);
+    return EAR_SUCCESS;
+}
+
 void application_print_channel(FILE *file, application_t *app)
 {
 #if WF_SUPPORT
@@ -37,6 +37,11 @@ void init_application(application_t *app);
 /** Replicates the application in *source to *destiny. */
 void copy_application(application_t *destiny, application_t *source);
 
+/** Groups the applications by app_id, and by default frequency if by_freq is set, in linear time. The group of each
+ * application is written in group (an array of apps_count elements), being the groups numbered in order of
+ * appearance. The number of groups is returned in *groups_count. */
+state_t applications_group(application_t *apps, uint apps_count, uint by_freq, uint *group, uint *groups_count);
+
 /** Cleaned remake of the classic print 'fd' function. */
 void application_print_channel(FILE *file, application_t *app);
 
@@ -20,6 +20,17 @@
 
 #define PERMISSION S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
 #define OPTIONS    O_WRONLY | O_CREAT | O_TRUNC | O_APPEND
+#define READ_TRIES 1000 // If EARD died while writing, the entry is copied anyway
+
+/* The sequence is the padding of the structure in the files, whatever it contains */
+static void coeffs_seq_clean(coefficient_t *coeffs, int count)
+{
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        coeffs[i].seq = 0;
+    }
+}
 
 int coeff_file_size(char *path)
 {
@@ -48,6 +59,7 @@ int coeff_file_read_no_alloc(char *path, coefficient_t *coeffs, int size)
         return EAR_READ_ERROR;
     }
     close(fd);
+    coeffs_seq_clean(coeffs, size / sizeof(coefficient_t));
 
     return (size / sizeof(coefficient_t));
 }
@@ -82,6 +94,37 @@ void coeff_reset(coefficient_t *coeff)
     coeff->available = 0;
 }
 
+void coeff_write(coefficient_t *dst, coefficient_t *src)
+{
+    uint seq = __atomic_load_n(&dst->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&dst->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    dst->pstate_ref = src->pstate_ref;
+    dst->pstate     = src->pstate;
+    dst->available  = src->available;
+    dst->A          = src->A;
+    dst->B          = src->B;
+    dst->C          = src->C;
+    dst->D          = src->D;
+    dst->E          = src->E;
+    dst->F          = src->F;
+    __atomic_store_n(&dst->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void coeff_read(coefficient_t *dst, coefficient_t *src)
+{
+    uint seq1, seq2, tries = 0;
+
+    do {
+        seq1 = __atomic_load_n(&src->seq, __ATOMIC_ACQUIRE);
+        memcpy(dst, src, sizeof(coefficient_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq2 = __atomic_load_n(&src->seq, __ATOMIC_RELAXED);
+    } while (((seq1 & 1) || seq1 != seq2) && ++tries < READ_TRIES);
+    dst->seq = 0;
+}
+
 int coeff_file_read(char *path, coefficient_t **coeffs)
 {
     coefficient_t *coeffs_aux;
@@ -111,6 +154,7 @@ int coeff_file_read(char *path, coefficient_t **coeffs)
         return EAR_READ_ERROR;
     }
     close(fd);
+    coeffs_seq_clean(coeffs_aux, size / sizeof(coefficient_t));
 
     *coeffs = coeffs_aux;
     return (size / sizeof(coefficient_t));
@@ -18,6 +18,7 @@ typedef struct coefficient {
     ulong pstate_ref;
     ulong pstate;
     uint available;
+    uint seq; // Odd while EARD writes the entry in the shared area, it takes the padding of the structure
     /* For power projection */
     double A;
     double B;
@@ -56,6 +57,13 @@ int coeff_gpu_file_read_no_alloc(char *path, coefficient_gpu_t *coeffs, int size
 // Misc
 void coeff_reset(coefficient_t *coeff);
 
+/** Replaces the entry dst of a shared area by src. The readers copying it by coeff_read do not see a partially
+ * written entry. There must be one writer. */
+void coeff_write(coefficient_t *dst, coefficient_t *src);
+
+/** Copies the entry src of a shared area, retrying while it is being written by coeff_write. */
+void coeff_read(coefficient_t *dst, coefficient_t *src);
+
 void coeff_print(coefficient_t *coeff);
 
 #endif
@@ -19,6 +19,8 @@
 #include <common/types/configuration/cluster_conf_eard.h>
 #include <common/types/configuration/cluster_conf_eardbd.h>
 #include <common/types/configuration/cluster_conf_eargm.h>
+#include <common/types/configuration/cluster_conf_image.h>
+#include <common/types/configuration/cluster_conf_index.h>
 #include <common/utils/serial_buffer.h>
 #include <global_manager/cluster_powercap.h>
 #include <netdb.h>
@@ -34,6 +36,16 @@
 
 /** IP functions */
 int get_ip(char *nodename, cluster_conf_t *conf)
+{
+    node_index_entry_t entry;
+
+    if (conf != NULL && state_ok(cluster_conf_index_find(conf, nodename, &entry))) {
+        return entry.ip;
+    }
+    return get_ip_dns(nodename, conf);
+}
+
+int get_ip_dns(char *nodename, cluster_conf_t *conf)
 {
     struct addrinfo hints;
     struct addrinfo *result, *rp;
@@ -206,6 +218,7 @@ static void _add_ips_and_names_from_range(char *base, range_def_t *r, int32_t **
 
 int get_ip_and_names_from_ranges(cluster_conf_t *my_conf, int **num_ips, int ***ips, char ****names)
 {
+    node_index_t *index;
     int i, j;
     int **aux_ips;
     char ***aux_names;
@@ -225,7 +238,20 @@ int get_ip_and_names_from_ranges(cluster_conf_t *my_conf, int **num_ips, int ***
     aux_ips    = calloc(total_ranges, sizeof(int *));
     aux_names  = calloc(total_ranges, sizeof(char **));
 
-    for (i = 0; i < my_conf->num_islands; i++) {
+    if ((index = cluster_conf_index_get(my_conf)) != NULL) {
+        for (i = 0; i < total_ranges; i++) {
+            ip_counter[i] = index->range_first[i + 1] - index->range_first[i];
+            aux_ips[i]    = calloc(ip_counter[i] + 1, sizeof(int));
+            aux_names[i]  = calloc(ip_counter[i] + 1, sizeof(char *));
+            for (j = 0; j < ip_counter[i]; j++) {
+                aux_ips[i][j]   = index->entries[index->range_first[i] + j].ip;
+                aux_names[i][j] = strdup(index->entries[index->range_first[i] + j].name);
+            }
+        }
+        current_range = total_ranges;
+    }
+
+    for (i = 0; i < my_conf->num_islands && current_range < total_ranges; i++) {
         for (j = 0; j < my_conf->islands[i].num_ranges; j++) {
             range_def_t range = my_conf->islands[i].ranges[j].r_def;
             _add_ips_and_names_from_range("", &range, &aux_ips[current_range], &ip_counter[current_range],
@@ -303,6 +329,7 @@ static void _add_ips_from_range(char *base, range_def_t *r, int32_t **ips, int32
 
 int get_ip_ranges(cluster_conf_t *my_conf, int **num_ips, int ***ips)
 {
+    node_index_t *index;
     int i, j;
     int **aux_ips;
     int *ip_counter;
@@ -320,7 +347,18 @@ int get_ip_ranges(cluster_conf_t *my_conf, int **num_ips, int ***ips)
     ip_counter = calloc(total_ranges, sizeof(int));
     aux_ips    = calloc(total_ranges, sizeof(int *));
 
-    for (i = 0; i < my_conf->num_islands; i++) {
+    if ((index = cluster_conf_index_get(my_conf)) != NULL) {
+        for (i = 0; i < total_ranges; i++) {
+            ip_counter[i] = index->range_first[i + 1] - index->range_first[i];
+            aux_ips[i]    = calloc(ip_counter[i] + 1, sizeof(int));
+            for (j = 0; j < ip_counter[i]; j++) {
+                aux_ips[i][j] = index->entries[index->range_first[i] + j].ip;
+            }
+        }
+        current_range = total_ranges;
+    }
+
+    for (i = 0; i < my_conf->num_islands && current_range < total_ranges; i++) {
         for (j = 0; j < my_conf->islands[i].num_ranges; j++) {
             range_def_t range = my_conf->islands[i].ranges[j].r_def;
             _add_ips_from_range("", &range, &aux_ips[current_range], &ip_counter[current_range], my_conf);
@@ -411,10 +449,14 @@ my_node_conf_t *get_my_node_conf(cluster_conf_t *my_conf, char *nodename)
     int island_idx = 0;
     int range_id   = -1;
     int tag_id = -1, def_tag_id = -1;
+    node_index_entry_t entry;
+    int indexed;
 
     if (my_conf->num_islands == 0)
         return NULL;
 
+    indexed = state_ok(cluster_conf_index_find(my_conf, nodename, &entry));
+
     def_tag_id = get_default_tag_id(my_conf);
 
     my_node_conf_t *n = calloc(1, sizeof(my_node_conf_t));
@@ -425,6 +467,13 @@ my_node_conf_t *get_my_node_conf(cluster_conf_t *my_conf, char *nodename)
 
     n->max_pstate = my_conf->eard.max_pstate;
 
+    if (indexed) {
+        if (entry.node_idx >= 0) {
+            n->cpus      = my_conf->nodes[entry.node_idx].cpus;
+            n->coef_file = my_conf->nodes[entry.node_idx].coef_file;
+        }
+        i = my_conf->num_nodes;
+    }
     while (i < my_conf->num_nodes) {
         if (range_conf_contains_node(&my_conf->nodes[i], nodename)) {
             n->cpus      = my_conf->nodes[i].cpus;
@@ -433,9 +482,10 @@ my_node_conf_t *get_my_node_conf(cluster_conf_t *my_conf, char *nodename)
         i++;
     }
 
-    i = 0;
+    i = (indexed) ? entry.island_idx : 0;
     do { // At least one node is assumed
-        if ((range_id = nodeconf_get_island_range_for_node(&my_conf->islands[i], nodename)) >= 0) {
+        range_id = (indexed) ? entry.range_idx : nodeconf_get_island_range_for_node(&my_conf->islands[i], nodename);
+        if (range_id >= 0) {
             range_found = 1;
             n->island   = my_conf->islands[i].id;
             island_idx  = i;
@@ -1022,19 +1072,18 @@ void set_default_conf_install(conf_install_t *inst)
 
 int get_node_island(cluster_conf_t *conf, char *hostname)
 {
-    my_node_conf_t *node;
-    int island;
-
-    node = get_my_node_conf(conf, hostname);
+    node_index_entry_t entry;
+    int i;
 
-    if (node == NULL) {
-        return EAR_ERROR;
+    if (state_ok(cluster_conf_index_find(conf, hostname, &entry))) {
+        return entry.island;
     }
-
-    island = node->island;
-    free(node);
-
-    return island;
+    for (i = 0; i < conf->num_islands; i++) {
+        if (nodeconf_get_island_range_for_node(&conf->islands[i], hostname) >= 0) {
+            return conf->islands[i].id;
+        }
+    }
+    return EAR_ERROR;
 }
 
 int get_node_server_mirror(cluster_conf_t *conf, const char *hostname, char *mirror_of)
@@ -1359,6 +1408,11 @@ void remove_islands_by_tag(cluster_conf_t conf[static 1], const char *tag)
 {
     if (tag == NULL)
         return;
+    // The islands of a configuration image are not allocated (cluster_conf_image.h)
+    if (cluster_conf_image_mapped(conf)) {
+        error("The islands of a configuration image can not be removed");
+        return;
+    }
     debug("Removing node with earmg different than %s", tag);
 
     int i, j, k;
@@ -1415,6 +1469,11 @@ void remove_islands_by_eargm(cluster_conf_t conf[static 1], eargm_def_t *e_def)
 {
     if (e_def == NULL)
         return;
+    // The islands of a configuration image are not allocated (cluster_conf_image.h)
+    if (cluster_conf_image_mapped(conf)) {
+        error("The islands of a configuration image can not be removed");
+        return;
+    }
     debug("Removing node with earmg different than %d", e_def->id);
 
     int i, j;
@@ -1441,6 +1500,11 @@ void remove_islands_by_eargm(cluster_conf_t conf[static 1], eargm_def_t *e_def)
 
 void remove_islands_by_island_id(cluster_conf_t conf[static 1], int32_t id)
 {
+    // The islands of a configuration image are not allocated (cluster_conf_image.h)
+    if (cluster_conf_image_mapped(conf)) {
+        error("The islands of a configuration image can not be removed");
+        return;
+    }
     debug("Removing nodes with island id different than %d", id);
 
     int i;
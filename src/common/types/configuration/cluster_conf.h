@@ -217,9 +217,12 @@ int get_ip_and_names_from_ranges(cluster_conf_t *my_conf, int **num_ips, int ***
 /** returns the number of nodes defined in cluster_conf_t */
 int get_num_nodes(cluster_conf_t *my_conf);
 
-/** returns the ip of the nodename specified */
+/** returns the ip of the nodename specified, from the node index if it is built (see cluster_conf_index.h) */
 int get_ip(char *nodename, cluster_conf_t *conf);
 
+/** returns the ip of the nodename specified, always asking the resolver */
+int get_ip_dns(char *nodename, cluster_conf_t *conf);
+
 /** Returns the short name for a given policy. To be used in eacct etc */
 void get_short_policy(char *buf, char *policy, cluster_conf_t *conf);
 
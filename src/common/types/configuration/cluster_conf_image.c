@@ -0,0 +1,458 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <common/config.h>
+#include <common/output/verbose.h>
+#include <common/types/configuration/cluster_conf_image.h>
+#include <common/types/configuration/cluster_conf_index.h>
+
+#define IMAGE_MAGIC   0x46434145 // EACF
+#define IMAGE_VERSION 1
+#define NONE          0 // Offset 0 is the header, so it is never a target
+#define MODE_BITS     (S_IRWXU | S_IRWXG | S_IRWXO)
+
+typedef struct image_header {
+    uint magic;
+    uint version;
+    ullong layout; // Hash of the type sizes
+    ullong base;
+    ullong size;
+    ullong text_size;
+    ullong text_mtime;
+    ullong conf_offset;
+    ullong index_offset;
+    ullong relocs_offset;
+    ullong num_relocs;
+} image_header_t;
+
+typedef struct builder_s {
+    char *data;
+    size_t size;
+    size_t capacity;
+    ullong *relocs;
+    size_t num_relocs;
+    size_t relocs_capacity;
+} builder_t;
+
+typedef struct mapped_s {
+    char *addr;
+    size_t size;
+} mapped_t;
+
+static pthread_mutex_t image_lock = PTHREAD_MUTEX_INITIALIZER;
+static mapped_t mapped[CONF_IMAGE_MAX_MAP];
+
+static ullong layout_hash()
+{
+    size_t sizes[] = {sizeof(cluster_conf_t), sizeof(node_conf_t),  sizeof(node_range_t),   sizeof(range_def_t),
+                      sizeof(pair),           sizeof(node_island_t), sizeof(tag_t),         sizeof(energy_tag_t),
+                      sizeof(policy_conf_t),  sizeof(eargm_def_t),  sizeof(edcmon_t),       sizeof(node_index_t),
+                      sizeof(node_index_entry_t)};
+    ullong h = 0xcbf29ce484222325ULL;
+    uint i;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+        h = (h ^ sizes[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void image_path_of(char *conf_path, char *image_path, char *dest, size_t size)
+{
+    if (image_path != NULL) {
+        snprintf(dest, size, "%s", image_path);
+    } else {
+        snprintf(dest, size, "%s%s", conf_path, CONF_IMAGE_EXT);
+    }
+}
+
+/************************************** compiler *************************************/
+
+/* Returns the offset of size zeroed bytes, aligned to 8 */
+static size_t b_alloc(builder_t *b, size_t size)
+{
+    size_t offset = (b->size + 7) & ~((size_t) 7);
+
+    while (offset + size > b->capacity) {
+        b->capacity = (b->capacity) ? b->capacity * 2 : 65536;
+        b->data     = realloc(b->data, b->capacity);
+    }
+    memset(&b->data[b->size], 0, offset + size - b->size);
+    b->size = offset + size;
+    return offset;
+}
+
+static size_t b_copy(builder_t *b, const void *src, size_t size)
+{
+    size_t offset = b_alloc(b, size);
+    memcpy(&b->data[offset], src, size);
+    return offset;
+}
+
+/* Sets the pointer at field to the target, or to NULL */
+static void b_pointer(builder_t *b, size_t field, size_t target)
+{
+    ullong value = 0;
+
+    if (target != NONE) {
+        value = CONF_IMAGE_BASE + target;
+        if (b->num_relocs == b->relocs_capacity) {
+            b->relocs_capacity = (b->relocs_capacity) ? b->relocs_capacity * 2 : 4096;
+            b->relocs          = realloc(b->relocs, b->relocs_capacity * sizeof(ullong));
+        }
+        b->relocs[b->num_relocs++] = field;
+    }
+    memcpy(&b->data[field], &value, sizeof(ullong));
+}
+
+static size_t b_array(builder_t *b, size_t field, const void *src, size_t elem_size, size_t count)
+{
+    size_t target = (src != NULL && count > 0) ? b_copy(b, src, elem_size * count) : NONE;
+    b_pointer(b, field, target);
+    return target;
+}
+
+static void b_string(builder_t *b, size_t field, const char *src)
+{
+    b_array(b, field, src, 1, (src != NULL) ? strlen(src) + 1 : 0);
+}
+
+static void b_strings(builder_t *b, size_t field, char **src, size_t count)
+{
+    size_t list = b_array(b, field, src, sizeof(char *), count);
+    size_t i;
+
+    for (i = 0; list != NONE && i < count; i++) {
+        b_string(b, list + i * sizeof(char *), src[i]);
+    }
+}
+
+static void b_range_def(builder_t *b, size_t at, range_def_t *src)
+{
+    size_t next;
+
+    b_array(b, at + offsetof(range_def_t, numbers), src->numbers, sizeof(pair), src->numbers_count);
+    next = b_array(b, at + offsetof(range_def_t, next), src->next, sizeof(range_def_t), 1);
+    if (next != NONE) {
+        b_range_def(b, next, src->next);
+    }
+}
+
+static void b_ranges(builder_t *b, size_t field, node_range_t *src, size_t count)
+{
+    size_t list = b_array(b, field, src, sizeof(node_range_t), count);
+    size_t i, at;
+
+    for (i = 0; list != NONE && i < count; i++) {
+        at = list + i * sizeof(node_range_t);
+        b_range_def(b, at + offsetof(node_range_t, r_def), &src[i].r_def);
+        b_array(b, at + offsetof(node_range_t, specific_tags), src[i].specific_tags, sizeof(int), src[i].num_tags);
+    }
+}
+
+static size_t b_index(builder_t *b, node_index_t *index)
+{
+    size_t at = b_copy(b, index, sizeof(node_index_t));
+    size_t entries, names, names_size = 0, last;
+    uint i;
+
+    if (index->num_entries > 0) {
+        last       = index->entries[index->num_entries - 1].name - index->names;
+        names_size = last + strlen(index->entries[index->num_entries - 1].name) + 1;
+    }
+    ((node_index_t *) &b->data[at])->mapped = 1;
+    entries = b_array(b, at + offsetof(node_index_t, entries), index->entries, sizeof(node_index_entry_t),
+                      index->num_entries);
+    names   = b_array(b, at + offsetof(node_index_t, names), index->names, 1, names_size);
+    for (i = 0; entries != NONE && i < index->num_entries; i++) {
+        b_pointer(b, entries + i * sizeof(node_index_entry_t) + offsetof(node_index_entry_t, name),
+                  names + (index->entries[i].name - index->names));
+    }
+    b_array(b, at + offsetof(node_index_t, range_first), index->range_first, sizeof(uint), index->num_ranges + 1);
+    b_array(b, at + offsetof(node_index_t, table), index->table, sizeof(int32_t), index->table_mask + 1);
+    return at;
+}
+
+static void b_conf(builder_t *b, cluster_conf_t *conf, size_t at)
+{
+    size_t list, elem;
+    uint i;
+
+    list = b_array(b, at + offsetof(cluster_conf_t, eargm) + offsetof(eargm_conf_t, eargms), conf->eargm.eargms,
+                   sizeof(eargm_def_t), conf->eargm.num_eargms);
+    for (i = 0; list != NONE && i < conf->eargm.num_eargms; i++) {
+        b_array(b, list + i * sizeof(eargm_def_t) + offsetof(eargm_def_t, subs), conf->eargm.eargms[i].subs,
+                sizeof(int), conf->eargm.eargms[i].num_subs);
+    }
+    b_array(b, at + offsetof(cluster_conf_t, power_policies), conf->power_policies, sizeof(policy_conf_t),
+            conf->num_policies);
+    b_strings(b, at + offsetof(cluster_conf_t, auth_users), conf->auth_users, conf->auth_users_count);
+    b_strings(b, at + offsetof(cluster_conf_t, auth_groups), conf->auth_groups, conf->auth_groups_count);
+    b_strings(b, at + offsetof(cluster_conf_t, auth_accounts), conf->auth_accounts, conf->auth_acc_count);
+    b_strings(b, at + offsetof(cluster_conf_t, admin_users), conf->admin_users, conf->admin_users_count);
+
+    list = b_array(b, at + offsetof(cluster_conf_t, nodes), conf->nodes, sizeof(node_conf_t), conf->num_nodes);
+    for (i = 0; list != NONE && i < conf->num_nodes; i++) {
+        elem = list + i * sizeof(node_conf_t);
+        b_ranges(b, elem + offsetof(node_conf_t, range), conf->nodes[i].range, conf->nodes[i].range_count);
+        b_string(b, elem + offsetof(node_conf_t, coef_file), conf->nodes[i].coef_file);
+    }
+
+    b_array(b, at + offsetof(cluster_conf_t, tags), conf->tags, sizeof(tag_t), conf->num_tags);
+    list = b_array(b, at + offsetof(cluster_conf_t, e_tags), conf->e_tags, sizeof(energy_tag_t), conf->num_etags);
+    for (i = 0; list != NONE && i < conf->num_etags; i++) {
+        elem = list + i * sizeof(energy_tag_t);
+        b_strings(b, elem + offsetof(energy_tag_t, users), conf->e_tags[i].users, conf->e_tags[i].num_users);
+        b_strings(b, elem + offsetof(energy_tag_t, groups), conf->e_tags[i].groups, conf->e_tags[i].num_groups);
+        b_strings(b, elem + offsetof(energy_tag_t, accounts), conf->e_tags[i].accounts, conf->e_tags[i].num_accounts);
+    }
+
+    list =
+        b_array(b, at + offsetof(cluster_conf_t, islands), conf->islands, sizeof(node_island_t), conf->num_islands);
+    for (i = 0; list != NONE && i < conf->num_islands; i++) {
+        node_island_t *island = &conf->islands[i];
+        elem                  = list + i * sizeof(node_island_t);
+        b_ranges(b, elem + offsetof(node_island_t, ranges), island->ranges, island->num_ranges);
+        b_strings(b, elem + offsetof(node_island_t, db_ips), island->db_ips, island->num_ips);
+        b_strings(b, elem + offsetof(node_island_t, backup_ips), island->backup_ips, island->num_backups);
+        b_strings(b, elem + offsetof(node_island_t, tags), island->tags, island->num_tags);
+        b_strings(b, elem + offsetof(node_island_t, specific_tags), island->specific_tags,
+                  island->num_specific_tags);
+    }
+    b_array(b, at + offsetof(cluster_conf_t, edcmon_tags), conf->edcmon_tags, sizeof(edcmon_t),
+            conf->num_edcmons_tags);
+}
+
+state_t cluster_conf_image_compile(char *conf_path, cluster_conf_t *conf, char *image_path)
+{
+    char path[SZ_PATH], temp[SZ_PATH + 32];
+    image_header_t head = {0};
+    builder_t b         = {0};
+    node_index_t *index;
+    struct stat st;
+    ssize_t written;
+    int fd;
+
+    if (stat(conf_path, &st) != 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    b_alloc(&b, sizeof(image_header_t));
+    head.conf_offset = b_copy(&b, conf, sizeof(cluster_conf_t));
+    b_conf(&b, conf, head.conf_offset);
+    if ((index = cluster_conf_index_get(conf)) != NULL) {
+        head.index_offset = b_index(&b, index);
+    }
+    head.magic         = IMAGE_MAGIC;
+    head.version       = IMAGE_VERSION;
+    head.layout        = layout_hash();
+    head.base          = CONF_IMAGE_BASE;
+    head.text_size     = st.st_size;
+    head.text_mtime    = st.st_mtime;
+    head.num_relocs    = b.num_relocs;
+    head.relocs_offset = b_copy(&b, b.relocs, b.num_relocs * sizeof(ullong));
+    head.size          = b.size;
+    memcpy(b.data, &head, sizeof(image_header_t));
+
+    image_path_of(conf_path, image_path, path, sizeof(path));
+    snprintf(temp, sizeof(temp), "%s.%d", path, getpid());
+    if ((fd = open(temp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR)) < 0) {
+        free(b.data);
+        free(b.relocs);
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    // The image has the secrets of ear.conf (the DB passwords), so it gets its
+    // owner and permissions. If the owner can't be changed (not root), the image
+    // belongs to the caller, and the loaders of other users reject it.
+    if (fchown(fd, st.st_uid, st.st_gid) != 0) {
+        debug("The image %s keeps the owner of the caller: %s", temp, strerror(errno));
+    }
+    if (fchmod(fd, st.st_mode & MODE_BITS & ~(S_IXUSR | S_IXGRP | S_IXOTH)) != 0) {
+        debug("The image %s keeps the mode 0600: %s", temp, strerror(errno));
+    }
+    written = write(fd, b.data, b.size);
+    close(fd);
+    free(b.data);
+    free(b.relocs);
+    if (written != (ssize_t) head.size || rename(temp, path) != 0) {
+        unlink(temp);
+        return_msg(EAR_ERROR, "the image could not be written");
+    }
+    verbose(VCCONF, "Configuration image %s: %llu bytes, %llu pointers", path, head.size, head.num_relocs);
+    return EAR_SUCCESS;
+}
+
+/************************************** loader ***************************************/
+
+/* Returns 1 if size bytes at offset are inside the image */
+static uint inside(image_header_t *head, ullong offset, ullong size)
+{
+    return offset >= sizeof(image_header_t) && offset <= head->size && size <= head->size - offset;
+}
+
+/* Checks that the structures and every pointer listed are inside the image, a
+ * truncated or corrupted file must not be dereferenced */
+static uint image_valid(char *map, image_header_t *head)
+{
+    ullong *relocs, value, i;
+
+    if (!inside(head, head->conf_offset, sizeof(cluster_conf_t)) ||
+        (head->index_offset != NONE && !inside(head, head->index_offset, sizeof(node_index_t))) ||
+        head->num_relocs > head->size / sizeof(ullong) ||
+        (head->num_relocs > 0 && !inside(head, head->relocs_offset, head->num_relocs * sizeof(ullong)))) {
+        return 0;
+    }
+    relocs = (ullong *) &map[head->relocs_offset];
+    for (i = 0; i < head->num_relocs; i++) {
+        if (!inside(head, relocs[i], sizeof(ullong))) {
+            return 0;
+        }
+        memcpy(&value, &map[relocs[i]], sizeof(ullong));
+        if (value < head->base || !inside(head, value - head->base, 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+state_t cluster_conf_image_load(char *conf_path, char *image_path, cluster_conf_t *conf)
+{
+    char path[SZ_PATH];
+    image_header_t head;
+    struct stat st, ist;
+    ullong *relocs, delta, i;
+    char *map;
+    int fd, slot;
+
+    if (stat(conf_path, &st) != 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    image_path_of(conf_path, image_path, path, sizeof(path));
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    // Written by other than root or the owner of ear.conf, or more exposed
+    if (fstat(fd, &ist) != 0 || (ist.st_uid != 0 && ist.st_uid != st.st_uid) ||
+        (ist.st_mode & ~st.st_mode & MODE_BITS)) {
+        close(fd);
+        return_msg(EAR_ERROR, "the image is more permissive than the configuration");
+    }
+    if (pread(fd, &head, sizeof(head), 0) != sizeof(head) || head.magic != IMAGE_MAGIC ||
+        head.version != IMAGE_VERSION || head.layout != layout_hash()) {
+        close(fd);
+        return_msg(EAR_ERROR, "the image is not compatible");
+    }
+    if (head.text_size != (ullong) st.st_size || head.text_mtime != (ullong) st.st_mtime) {
+        close(fd);
+        return_msg(EAR_ERROR, "the image is older than the configuration");
+    }
+    if (head.size != (ullong) ist.st_size || head.size < sizeof(image_header_t)) {
+        close(fd);
+        return_msg(EAR_ERROR, "the image size does not match its header");
+    }
+    map = mmap((void *) head.base, head.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    if (!image_valid(map, &head)) {
+        munmap(map, head.size);
+        return_msg(EAR_ERROR, "the image is corrupted");
+    }
+    if ((ullong) map != head.base) {
+        /* The pointers are relocated, these pages are not shared anymore */
+        delta  = (ullong) map - head.base;
+        relocs = (ullong *) &map[head.relocs_offset];
+        for (i = 0; i < head.num_relocs; i++) {
+            *((ullong *) &map[relocs[i]]) += delta;
+        }
+        debug("Configuration image mapped at %p, %llu pointers relocated", map, head.num_relocs);
+    }
+
+    pthread_mutex_lock(&image_lock);
+    for (slot = 0; slot < CONF_IMAGE_MAX_MAP && mapped[slot].addr != NULL; slot++)
+        ;
+    if (slot < CONF_IMAGE_MAX_MAP) {
+        mapped[slot].addr = map;
+        mapped[slot].size = head.size;
+    }
+    pthread_mutex_unlock(&image_lock);
+    if (slot == CONF_IMAGE_MAX_MAP) {
+        munmap(map, head.size);
+        return_msg(EAR_ERROR, "too many configuration images");
+    }
+
+    memcpy(conf, &map[head.conf_offset], sizeof(cluster_conf_t));
+    if (head.index_offset != NONE) {
+        cluster_conf_index_attach(conf, (node_index_t *) &map[head.index_offset]);
+    }
+    return EAR_SUCCESS;
+}
+
+state_t cluster_conf_image_read(char *conf_path, cluster_conf_t *conf)
+{
+    if (state_ok(cluster_conf_image_load(conf_path, NULL, conf))) {
+        return EAR_SUCCESS;
+    }
+    debug("Configuration image of %s not used: %s", conf_path, state_msg);
+    return read_cluster_conf(conf_path, conf);
+}
+
+/* Returns the slot of the image conf was loaded from, or -1 */
+static int image_slot(cluster_conf_t *conf)
+{
+    char *pointers[] = {(char *) conf->islands, (char *) conf->nodes, (char *) conf->tags,
+                        (char *) conf->power_policies};
+    int slot, found = -1;
+    uint i;
+
+    pthread_mutex_lock(&image_lock);
+    for (slot = 0; slot < CONF_IMAGE_MAX_MAP && found < 0; slot++) {
+        for (i = 0; mapped[slot].addr != NULL && i < sizeof(pointers) / sizeof(char *) && found < 0; i++) {
+            if (pointers[i] >= mapped[slot].addr && pointers[i] < mapped[slot].addr + mapped[slot].size) {
+                found = slot;
+            }
+        }
+    }
+    pthread_mutex_unlock(&image_lock);
+    return found;
+}
+
+uint cluster_conf_image_mapped(cluster_conf_t *conf)
+{
+    return (image_slot(conf) >= 0);
+}
+
+uint cluster_conf_image_release(cluster_conf_t *conf)
+{
+    int slot;
+
+    if ((slot = image_slot(conf)) < 0) {
+        return 0;
+    }
+    cluster_conf_index_release(conf);
+    pthread_mutex_lock(&image_lock);
+    munmap(mapped[slot].addr, mapped[slot].size);
+    mapped[slot].addr = NULL;
+    pthread_mutex_unlock(&image_lock);
+    memset(conf, 0, sizeof(cluster_conf_t));
+    return 1;
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _CLUSTER_CONF_IMAGE_H
+#define _CLUSTER_CONF_IMAGE_H
+
+#include <common/states.h>
+#include <common/types/configuration/cluster_conf.h>
+#include <common/types/generic.h>
+
+/* Compiled ear.conf. The image is a single block with the cluster_conf_t,
+ * everything it points to (nodes, islands, ranges, tags, energy tags,
+ * policies, EARGMs and users) and the node index (cluster_conf_index.h). The
+ * pointers are stored for the address CONF_IMAGE_BASE, where the loader maps
+ * the file without any parsing, and the image also has the list of pointers,
+ * which are relocated if the file can not be mapped there. The mapping is
+ * private, so the pages are shared between processes until written.
+ *
+ * The text ear.conf is the source of truth: the image records its size and
+ * modification time, and it is not loaded if they changed. The compiler writes
+ * a temporal file and renames it, so the image can be regenerated while being
+ * used. The image has the owner and permissions of ear.conf, because it has
+ * its secrets, and it is not loaded if it is more permissive or belongs to
+ * other than root or the owner of ear.conf.
+ *
+ * A loaded configuration is released with free_cluster_conf. It is read only
+ * for the functions that reallocate or free parts of the configuration
+ * (remove_islands_by_*), which do nothing with it. */
+
+#define CONF_IMAGE_BASE    0x5ea000000000ULL
+#define CONF_IMAGE_EXT     ".img"
+#define CONF_IMAGE_MAX_MAP 8
+
+/** Writes the image of conf, read from conf_path, in image_path (conf_path.img if NULL). */
+state_t cluster_conf_image_compile(char *conf_path, cluster_conf_t *conf, char *image_path);
+
+/** Maps the image of conf_path in image_path (conf_path.img if NULL) if it is up to date. */
+state_t cluster_conf_image_load(char *conf_path, char *image_path, cluster_conf_t *conf);
+
+/** Loads the image of conf_path or, if it is not available, reads the text configuration. */
+state_t cluster_conf_image_read(char *conf_path, cluster_conf_t *conf);
+
+/** Returns 1 if conf was loaded from an image. */
+uint cluster_conf_image_mapped(cluster_conf_t *conf);
+
+/** Unmaps the image of conf. Returns 0 if conf was not loaded from an image. */
+uint cluster_conf_image_release(cluster_conf_t *conf);
+
+#endif
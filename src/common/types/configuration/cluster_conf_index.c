@@ -0,0 +1,498 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <common/config.h>
+#include <common/output/verbose.h>
+#include <common/types/configuration/cluster_conf_index.h>
+
+#define INDEX_CACHE_MAGIC   0x49524145 // EARI
+#define INDEX_CACHE_VERSION 1
+
+typedef struct cache_header {
+    uint magic;
+    uint version;
+    ullong hash;
+    uint count;
+    uint pad;
+} cache_header_t;
+
+/* Expansion state */
+typedef struct expand_s {
+    cluster_conf_t *conf;
+    node_index_t *index;
+    uint capacity;
+    size_t *name_offsets;
+    size_t names_size;
+    size_t names_capacity;
+    int island_idx;
+    int range_idx;
+} expand_t;
+
+/* Resolution state, shared by the threads */
+typedef struct resolve_s {
+    cluster_conf_t *conf;
+    node_index_t *index;
+    uint next;
+} resolve_t;
+
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+static node_index_t proc_index;
+static cluster_conf_t *proc_conf;
+static uint proc_index_built;
+
+static ullong fnv_bytes(ullong h, const void *data, size_t size)
+{
+    const uchar *p = (const uchar *) data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* Everything the hostnames and IPs depend on */
+static ullong conf_hash(cluster_conf_t *conf)
+{
+    ullong h = 0xcbf29ce484222325ULL;
+    range_def_t *r;
+    int i, j, k;
+
+    h = fnv_bytes(h, conf->net_ext, strlen(conf->net_ext) + 1);
+    for (i = 0; i < conf->num_islands; i++) {
+        h = fnv_bytes(h, &conf->islands[i].num_ranges, sizeof(int));
+        for (j = 0; j < conf->islands[i].num_ranges; j++) {
+            for (r = &conf->islands[i].ranges[j].r_def; r != NULL; r = r->next) {
+                h = fnv_bytes(h, r->prefix, strlen(r->prefix) + 1);
+                h = fnv_bytes(h, &r->numbers_count, sizeof(int32_t));
+                for (k = 0; k < r->numbers_count; k++) {
+                    h = fnv_bytes(h, &r->numbers[k], sizeof(pair));
+                }
+            }
+        }
+    }
+    return h;
+}
+
+static uint num_ranges(cluster_conf_t *conf)
+{
+    uint ranges = 0;
+    int i;
+
+    for (i = 0; i < conf->num_islands; i++) {
+        ranges += conf->islands[i].num_ranges;
+    }
+    return ranges;
+}
+
+/* The hash of the ranges is only computed for a different configuration, the
+ * lookups of the same one are cheap. Must be called with the lock. */
+static uint is_proc_index(cluster_conf_t *conf)
+{
+    if (!proc_index_built) {
+        return 0;
+    }
+    if (conf == proc_conf && num_ranges(conf) == proc_index.num_ranges) {
+        return 1;
+    }
+    if (proc_index.hash == conf_hash(conf)) {
+        proc_conf = conf;
+        return 1;
+    }
+    return 0;
+}
+
+static uint name_hash(const char *name, size_t len)
+{
+    return (uint) fnv_bytes(0xcbf29ce484222325ULL, name, len);
+}
+
+static void add_entry(expand_t *e, char *name, size_t len)
+{
+    node_island_t *island = &e->conf->islands[e->island_idx];
+    node_range_t *range   = &island->ranges[e->range_idx];
+    node_index_t *index   = e->index;
+    node_index_entry_t *entry;
+    int i;
+
+    if (index->num_entries == e->capacity) {
+        e->capacity     = (e->capacity) ? e->capacity * 2 : 1024;
+        index->entries  = realloc(index->entries, e->capacity * sizeof(node_index_entry_t));
+        e->name_offsets = realloc(e->name_offsets, e->capacity * sizeof(size_t));
+    }
+    while (e->names_size + len + 1 > e->names_capacity) {
+        e->names_capacity = (e->names_capacity) ? e->names_capacity * 2 : 16384;
+        index->names      = realloc(index->names, e->names_capacity);
+    }
+    memcpy(&index->names[e->names_size], name, len + 1);
+    e->name_offsets[index->num_entries] = e->names_size;
+    e->names_size += len + 1;
+
+    entry             = &index->entries[index->num_entries++];
+    entry->ip         = EAR_ERROR;
+    entry->island     = island->id;
+    entry->island_idx = e->island_idx;
+    entry->range_idx  = e->range_idx;
+    entry->node_idx   = -1;
+    for (i = 0; i < e->conf->num_nodes; i++) {
+        if (range_conf_contains_node(&e->conf->nodes[i], name)) {
+            entry->node_idx = i;
+        }
+    }
+    if (range->db_ip >= 0 && island->num_ips > range->db_ip) {
+        entry->db_ip = range->db_ip;
+    } else {
+        entry->db_ip = (island->num_ips > 0) ? 0 : -1;
+    }
+    entry->sec_ip = (range->sec_ip >= 0 && island->num_backups) ? range->sec_ip : -1;
+}
+
+static size_t append_number(char *buff, int32_t zeroes, int32_t v)
+{
+    int32_t i;
+
+    for (i = 0; i < zeroes; i++) {
+        buff[i] = '0';
+    }
+    return zeroes + sprintf(&buff[zeroes], "%d", v);
+}
+
+/* The same names than get_ip_ranges, appending to the buffer in place */
+static void expand_range(expand_t *e, char *buff, size_t len, range_def_t *r)
+{
+    int32_t i, v, zeroes;
+    size_t plen;
+
+    if (r == NULL) {
+        add_entry(e, buff, len);
+        return;
+    }
+    plen = sprintf(&buff[len], "%s", r->prefix);
+    if (r->numbers_count == 0) {
+        add_entry(e, buff, len + plen);
+        return;
+    }
+    for (i = 0; i < r->numbers_count; i++) {
+        pair *aux = &r->numbers[i];
+        if (aux->first == 0 && aux->second == 0) {
+            expand_range(e, buff, len + plen, r->next);
+        } else if (aux->second == 0) {
+            expand_range(e, buff, len + plen + append_number(&buff[len + plen], aux->leading_zeroes, aux->first),
+                         r->next);
+        } else {
+            for (v = aux->first; v <= aux->second; v++) {
+                zeroes = aux->leading_zeroes + difference_in_units(v, aux->second);
+                expand_range(e, buff, len + plen + append_number(&buff[len + plen], zeroes, v), r->next);
+            }
+        }
+        buff[len + plen] = '\0';
+    }
+}
+
+static void *resolve_thread(void *arg)
+{
+    resolve_t *res = (resolve_t *) arg;
+    uint i;
+
+    while ((i = __sync_fetch_and_add(&res->next, 1)) < res->index->num_entries) {
+        res->index->entries[i].ip = get_ip_dns(res->index->entries[i].name, res->conf);
+    }
+    return NULL;
+}
+
+static void resolve_parallel(cluster_conf_t *conf, node_index_t *index)
+{
+    pthread_t threads[NODE_INDEX_DNS_THREADS];
+    resolve_t res = {.conf = conf, .index = index, .next = 0};
+    uint num_threads, created = 0, i;
+
+    num_threads = index->num_entries / NODE_INDEX_NODES_THREAD + 1;
+    num_threads = ear_min(num_threads, NODE_INDEX_DNS_THREADS);
+    for (i = 1; i < num_threads; i++) {
+        if (pthread_create(&threads[created], NULL, resolve_thread, &res) == 0) {
+            created++;
+        }
+    }
+    // The caller also resolves, so it works if no thread can be created
+    resolve_thread(&res);
+    for (i = 0; i < created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    debug("%u nodes resolved by %u threads", index->num_entries, created + 1);
+}
+
+static void cache_path(cluster_conf_t *conf, node_index_t *index, char *path, size_t size)
+{
+    snprintf(path, size, "%s/.ear_node_index_%016llx", conf->install.dir_temp, index->hash);
+}
+
+/* The cache is in the shared temporal directory, so it is just used if it
+ * couldn't have been written by other user than root or this one. */
+static state_t cache_load(cluster_conf_t *conf, node_index_t *index)
+{
+    char path[SZ_PATH];
+    cache_header_t head;
+    struct stat st;
+    int32_t *ips;
+    int fd, ok;
+    uint i;
+
+    if (strlen(conf->install.dir_temp) == 0) {
+        return_msg(EAR_ERROR, Generr.input_null);
+    }
+    cache_path(conf, index, path, sizeof(path));
+    if ((fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC)) < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (st.st_uid != 0 && st.st_uid != geteuid()) ||
+        (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        close(fd);
+        return_msg(EAR_ERROR, "untrusted cache");
+    }
+    if (time(NULL) - st.st_mtime > NODE_INDEX_CACHE_TTL) {
+        close(fd);
+        return_msg(EAR_ERROR, "no valid cache");
+    }
+    ips = calloc(index->num_entries + 1, sizeof(int32_t));
+    ok  = (read(fd, &head, sizeof(head)) == sizeof(head)) && head.magic == INDEX_CACHE_MAGIC &&
+         head.version == INDEX_CACHE_VERSION && head.hash == index->hash && head.count == index->num_entries &&
+         (read(fd, ips, head.count * sizeof(int32_t)) == (ssize_t) (head.count * sizeof(int32_t)));
+    close(fd);
+    if (ok) {
+        for (i = 0; i < index->num_entries; i++) {
+            index->entries[i].ip = ips[i];
+        }
+    }
+    free(ips);
+    if (!ok) {
+        return_msg(EAR_ERROR, "corrupted cache");
+    }
+    return EAR_SUCCESS;
+}
+
+/* Written in a new temporal file which replaces the cache, so a link or a
+ * file of other user is never written. */
+static void cache_store(cluster_conf_t *conf, node_index_t *index)
+{
+    char path[SZ_PATH], temp[SZ_PATH + 32];
+    cache_header_t head = {0};
+    int32_t *ips;
+    ssize_t size;
+    int fd;
+    uint i;
+
+    if (strlen(conf->install.dir_temp) == 0) {
+        return;
+    }
+    cache_path(conf, index, path, sizeof(path));
+    snprintf(temp, sizeof(temp), "%s.%d", path, getpid());
+    // Commands run by users usually can not write the temporal directory
+    if ((fd = open(temp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) <
+        0) {
+        debug("Cannot create the node index cache %s: %s", temp, strerror(errno));
+        return;
+    }
+    head.magic   = INDEX_CACHE_MAGIC;
+    head.version = INDEX_CACHE_VERSION;
+    head.hash    = index->hash;
+    head.count   = index->num_entries;
+    ips          = calloc(index->num_entries + 1, sizeof(int32_t));
+    for (i = 0; i < index->num_entries; i++) {
+        ips[i] = index->entries[i].ip;
+    }
+    size = write(fd, &head, sizeof(head));
+    size += write(fd, ips, index->num_entries * sizeof(int32_t));
+    close(fd);
+    free(ips);
+    if (size != (ssize_t) (sizeof(head) + index->num_entries * sizeof(int32_t)) || rename(temp, path) != 0) {
+        unlink(temp);
+    }
+}
+
+static void build_table(node_index_t *index)
+{
+    uint size = 2, i, slot;
+
+    while (size < index->num_entries * 2) {
+        size *= 2;
+    }
+    index->table      = malloc(size * sizeof(int32_t));
+    index->table_mask = size - 1;
+    memset(index->table, 0xff, size * sizeof(int32_t));
+    for (i = 0; i < index->num_entries; i++) {
+        slot = name_hash(index->entries[i].name, strlen(index->entries[i].name)) & index->table_mask;
+        while (index->table[slot] >= 0) {
+            slot = (slot + 1) & index->table_mask;
+        }
+        index->table[slot] = i;
+    }
+}
+
+state_t node_index_build(cluster_conf_t *conf, node_index_t *index)
+{
+    char buff[SZ_PATH];
+    expand_t e;
+    uint i;
+    int j;
+
+    memset(index, 0, sizeof(node_index_t));
+    memset(&e, 0, sizeof(expand_t));
+    e.conf  = conf;
+    e.index = index;
+
+    index->num_ranges = num_ranges(conf);
+    if (index->num_ranges == 0) {
+        return_msg(EAR_ERROR, "No IP ranges found");
+    }
+    index->hash        = conf_hash(conf);
+    index->range_first = calloc(index->num_ranges + 1, sizeof(uint));
+    index->num_ranges  = 0;
+    for (e.island_idx = 0; e.island_idx < conf->num_islands; e.island_idx++) {
+        for (e.range_idx = 0; e.range_idx < conf->islands[e.island_idx].num_ranges; e.range_idx++) {
+            index->range_first[index->num_ranges++] = index->num_entries;
+            buff[0]                                 = '\0';
+            expand_range(&e, buff, 0, &conf->islands[e.island_idx].ranges[e.range_idx].r_def);
+        }
+    }
+    index->range_first[index->num_ranges] = index->num_entries;
+    for (i = 0; i < index->num_entries; i++) {
+        index->entries[i].name = &index->names[e.name_offsets[i]];
+    }
+    free(e.name_offsets);
+    build_table(index);
+
+    if (state_fail(cache_load(conf, index))) {
+        debug("Node index cache not used: %s", state_msg);
+        resolve_parallel(conf, index);
+        cache_store(conf, index);
+    }
+    for (i = 0, j = 0; i < index->num_entries; i++) {
+        j += (index->entries[i].ip == EAR_ERROR);
+    }
+    verbose(VCCONF + 1, "Node index of %u nodes in %u ranges (%d not resolved)", index->num_entries, index->num_ranges,
+            j);
+    return EAR_SUCCESS;
+}
+
+static node_index_entry_t *find_len(node_index_t *index, char *name, size_t len)
+{
+    uint slot = name_hash(name, len) & index->table_mask;
+    node_index_entry_t *entry;
+
+    while (index->table[slot] >= 0) {
+        entry = &index->entries[index->table[slot]];
+        if (strncmp(entry->name, name, len) == 0 && entry->name[len] == '\0') {
+            return entry;
+        }
+        slot = (slot + 1) & index->table_mask;
+    }
+    return NULL;
+}
+
+node_index_entry_t *node_index_find(node_index_t *index, char *name)
+{
+    node_index_entry_t *entry;
+    char *dot;
+
+    if (index->table == NULL || name == NULL) {
+        return NULL;
+    }
+    if ((entry = find_len(index, name, strlen(name))) != NULL) {
+        return entry;
+    }
+    if ((dot = strchr(name, '.')) != NULL) {
+        return find_len(index, name, dot - name);
+    }
+    return NULL;
+}
+
+void node_index_dispose(node_index_t *index)
+{
+    if (index->mapped) {
+        memset(index, 0, sizeof(node_index_t));
+        return;
+    }
+    free(index->entries);
+    free(index->range_first);
+    free(index->names);
+    free(index->table);
+    memset(index, 0, sizeof(node_index_t));
+}
+
+node_index_t *cluster_conf_index_get(cluster_conf_t *conf)
+{
+    node_index_t *index = NULL;
+
+    pthread_mutex_lock(&index_lock);
+    if (!is_proc_index(conf)) {
+        if (proc_index_built) {
+            node_index_dispose(&proc_index);
+        }
+        proc_index_built = state_ok(node_index_build(conf, &proc_index));
+        proc_conf        = conf;
+    }
+    if (proc_index_built) {
+        index = &proc_index;
+    }
+    pthread_mutex_unlock(&index_lock);
+    return index;
+}
+
+state_t cluster_conf_index_find(cluster_conf_t *conf, char *name, node_index_entry_t *entry)
+{
+    node_index_entry_t *found = NULL;
+
+    pthread_mutex_lock(&index_lock);
+    if (is_proc_index(conf) && (found = node_index_find(&proc_index, name)) != NULL) {
+        memcpy(entry, found, sizeof(node_index_entry_t));
+        entry->name = NULL;
+    }
+    pthread_mutex_unlock(&index_lock);
+    if (found == NULL) {
+        return_msg(EAR_ERROR, Generr.not_found);
+    }
+    return EAR_SUCCESS;
+}
+
+void cluster_conf_index_attach(cluster_conf_t *conf, node_index_t *index)
+{
+    pthread_mutex_lock(&index_lock);
+    if (proc_index_built) {
+        node_index_dispose(&proc_index);
+    }
+    memcpy(&proc_index, index, sizeof(node_index_t));
+    proc_index.mapped = 1;
+    proc_index_built  = 1;
+    proc_conf         = conf;
+    pthread_mutex_unlock(&index_lock);
+}
+
+void cluster_conf_index_release(cluster_conf_t *conf)
+{
+    pthread_mutex_lock(&index_lock);
+    if (is_proc_index(conf)) {
+        node_index_dispose(&proc_index);
+        proc_index_built = 0;
+        proc_conf        = NULL;
+    }
+    pthread_mutex_unlock(&index_lock);
+}
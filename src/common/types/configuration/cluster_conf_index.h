@@ -0,0 +1,83 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _CLUSTER_CONF_INDEX_H
+#define _CLUSTER_CONF_INDEX_H
+
+#include <common/states.h>
+#include <common/types/configuration/cluster_conf.h>
+#include <common/types/generic.h>
+
+/* Compiled index of the nodes defined in the island ranges of a
+ * cluster_conf_t. The ranges are expanded once, in the same order than
+ * get_ip_ranges, and the hostnames are resolved by a pool of threads. Lookups
+ * by hostname use an open addressing hash table.
+ *
+ * The resolved IPs are cached in the EAR temporal directory, in a file named
+ * by a hash of the range definitions and the network extension, so the
+ * daemons and commands only resolve the nodes when ear.conf changes or the
+ * cache is older than NODE_INDEX_CACHE_TTL seconds. The cache is only used if
+ * it is a regular file owned by root or the user of the process, which others
+ * can't write. It is replaced with a new file each time, never written.
+ *
+ * Each process keeps the index of one configuration, built the first time all
+ * the IPs are requested (get_ip_ranges and similar) and released by
+ * free_cluster_conf. The single node functions (get_ip, get_node_island,
+ * get_my_node_conf) only use it when it is already built. */
+
+#define NODE_INDEX_CACHE_TTL    86400
+#define NODE_INDEX_DNS_THREADS  32
+#define NODE_INDEX_NODES_THREAD 16
+
+typedef struct node_index_entry {
+    char *name;       // Without the network extension
+    int32_t ip;       // EAR_ERROR if it could not be resolved
+    int32_t island;   // Island id
+    int16_t island_idx;
+    int16_t range_idx; // In the island
+    int32_t node_idx;  // In conf->nodes, the last matching definition like get_my_node_conf, or -1
+    int32_t db_ip;     // Index in the db_ips of the island, or -1
+    int32_t sec_ip;    // Index in the backup_ips of the island, or -1
+} node_index_entry_t;
+
+typedef struct node_index {
+    ullong hash;
+    node_index_entry_t *entries; // In range order
+    uint num_entries;
+    uint *range_first; // First entry of each range, num_ranges + 1 elements
+    uint num_ranges;
+    char *names;
+    int32_t *table; // Entry index or -1
+    uint table_mask;
+    uint mapped; // The arrays belong to a compiled configuration image
+} node_index_t;
+
+/** Expands and resolves the nodes of conf. */
+state_t node_index_build(cluster_conf_t *conf, node_index_t *index);
+
+/** Returns the entry of the hostname, also accepting the full name of a short one. NULL if not found. */
+node_index_entry_t *node_index_find(node_index_t *index, char *name);
+
+void node_index_dispose(node_index_t *index);
+
+/** Returns the index of conf, building it if it is not the one of the process. The index is valid until
+ * cluster_conf_index_release is called. */
+node_index_t *cluster_conf_index_get(cluster_conf_t *conf);
+
+/** Copies the entry of the hostname if the index of conf is already built. The name of the copy is not valid. */
+state_t cluster_conf_index_find(cluster_conf_t *conf, char *name, node_index_entry_t *entry);
+
+/** Uses index, whose arrays are not released, as the index of conf. */
+void cluster_conf_index_attach(cluster_conf_t *conf, node_index_t *index);
+
+/** Releases the index of the process if it belongs to conf. */
+void cluster_conf_index_release(cluster_conf_t *conf);
+
+#endif
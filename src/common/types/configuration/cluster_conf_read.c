@@ -23,6 +23,8 @@
 #include <common/types/configuration/cluster_conf_eargm.h>
 #include <common/types/configuration/cluster_conf_etag.h>
 #include <common/types/configuration/cluster_conf_generic.h>
+#include <common/types/configuration/cluster_conf_image.h>
+#include <common/types/configuration/cluster_conf_index.h>
 #include <common/utils/sched_support.h>
 
 #ifndef INCLUDE_CONF
@@ -605,6 +607,10 @@ void free_cluster_conf(cluster_conf_t *conf)
     if (conf == NULL) {
         return;
     }
+    if (cluster_conf_image_release(conf)) {
+        return;
+    }
+    cluster_conf_index_release(conf);
 
     for (i = 0; i < conf->auth_users_count; i++)
         free(conf->auth_users[i]);
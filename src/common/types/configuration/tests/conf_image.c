@@ -0,0 +1,177 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Compares the compiled image of an ear.conf with the text configuration.
+//
+// It compiles the image in a temporal file, loads it at its base address and
+// also when the base is busy (relocated), and checks that the printed
+// configuration and the IPs of the nodes are the same than the text ones.
+// The image must have the permissions of ear.conf, and a more permissive one,
+// corrupted or truncated images must be rejected. The islands of an image
+// can not be removed.
+// Then it prints the time of reading the text and loading the image.
+//
+//     ./conf_image ear.conf
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <common/types/configuration/cluster_conf.h>
+#include <common/types/configuration/cluster_conf_image.h>
+#include <common/types/configuration/cluster_conf_index.h>
+
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Prints conf in a temporal file and returns its contents */
+static char *print_conf(cluster_conf_t *conf)
+{
+    char path[SZ_PATH], *buf;
+    FILE *file;
+    long size;
+
+    snprintf(path, sizeof(path), "/tmp/conf_image.%d.txt", getpid());
+    file         = fopen(path, "w+");
+    verb_channel = fileno(file);
+    print_cluster_conf(conf);
+    verb_channel = STDOUT_FILENO;
+    size         = lseek(fileno(file), 0, SEEK_END);
+    buf          = calloc(size + 1, 1);
+    pread(fileno(file), buf, size, 0);
+    fclose(file);
+    unlink(path);
+    return buf;
+}
+
+static uint compare(cluster_conf_t *text, char *text_print, cluster_conf_t *image)
+{
+    node_index_t *t_index, *i_index;
+    node_index_entry_t *entry;
+    uint errors = 0, i;
+    char *image_print;
+
+    image_print = print_conf(image);
+    errors += (strcmp(image_print, text_print) != 0);
+    free(image_print);
+    t_index = cluster_conf_index_get(text);
+    // A node defined twice is resolved by its first definition
+    for (i = 0; t_index != NULL && i < t_index->num_entries; i++) {
+        entry = node_index_find(t_index, t_index->entries[i].name);
+        errors += (entry == NULL);
+        errors += (entry != NULL && get_ip(entry->name, image) != entry->ip);
+        errors += (entry != NULL && get_node_island(image, entry->name) != entry->island);
+    }
+    i_index = cluster_conf_index_get(image);
+    errors += (i_index == NULL || t_index == NULL || i_index->num_entries != t_index->num_entries);
+    return errors;
+}
+
+/* Writes an out of range offset in the last pointer of the list and returns 1 if the image is still loaded */
+static uint corrupted_rejected(char *conf_path, char *image_path, cluster_conf_t *image)
+{
+    ullong offset = ~0ULL, saved;
+    uint errors;
+    long size;
+    int fd;
+
+    if ((fd = open(image_path, O_RDWR)) < 0) {
+        return 1;
+    }
+    size = lseek(fd, 0, SEEK_END);
+    pread(fd, &saved, sizeof(saved), size - sizeof(saved));
+    pwrite(fd, &offset, sizeof(offset), size - sizeof(offset));
+    errors = state_ok(cluster_conf_image_load(conf_path, image_path, image));
+    pwrite(fd, &saved, sizeof(saved), size - sizeof(saved));
+    close(fd);
+    return errors;
+}
+
+int main(int argc, char *argv[])
+{
+    char image_path[SZ_PATH], *text_print;
+    double start, t_text, t_image;
+    cluster_conf_t text, image;
+    struct stat st, ist;
+    uint errors = 0;
+    int islands;
+    void *busy;
+
+    if (argc < 2) {
+        printf("usage: %s ear.conf\n", argv[0]);
+        return 1;
+    }
+    snprintf(image_path, sizeof(image_path), "/tmp/conf_image.%d", getpid());
+    memset(&text, 0, sizeof(cluster_conf_t));
+    start = now_ms();
+    if (read_cluster_conf(argv[1], &text) != EAR_SUCCESS) {
+        printf("cannot read %s\n", argv[1]);
+        return 1;
+    }
+    t_text = now_ms() - start;
+    if (state_fail(cluster_conf_image_compile(argv[1], &text, image_path))) {
+        printf("cannot compile %s: %s\n", argv[1], state_msg);
+        return 1;
+    }
+    text_print = print_conf(&text);
+    errors += (stat(argv[1], &st) != 0 || stat(image_path, &ist) != 0 || (ist.st_mode & 0777) != (st.st_mode & 0666));
+
+    start = now_ms();
+    if (state_fail(cluster_conf_image_load(argv[1], image_path, &image))) {
+        printf("cannot load the image: %s\n", state_msg);
+        unlink(image_path);
+        return 1;
+    }
+    t_image = now_ms() - start;
+    errors += ((ullong) image.islands < CONF_IMAGE_BASE);
+    errors += compare(&text, text_print, &image);
+    islands = image.num_islands;
+    remove_islands_by_island_id(&image, -1);
+    errors += (image.num_islands != islands);
+    free_cluster_conf(&image);
+
+    // The base address is busy, the pointers are relocated
+    busy = mmap((void *) CONF_IMAGE_BASE, 4096, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (state_fail(cluster_conf_image_load(argv[1], image_path, &image))) {
+        printf("cannot load the relocated image: %s\n", state_msg);
+        errors++;
+    } else {
+        errors += ((ullong) image.islands >= CONF_IMAGE_BASE && (ullong) image.islands < CONF_IMAGE_BASE + 4096);
+        errors += compare(&text, text_print, &image);
+        free_cluster_conf(&image);
+    }
+    munmap(busy, 4096);
+
+    // More permissive than ear.conf
+    errors += (chmod(image_path, 0666) != 0 || state_ok(cluster_conf_image_load(argv[1], image_path, &image)));
+    chmod(image_path, st.st_mode & 0666);
+    // An image of other configuration is rejected
+    errors += state_ok(cluster_conf_image_load("/dev/null", image_path, &image));
+    // The pointers list is at the end, a pointer out of the image is rejected
+    errors += corrupted_rejected(argv[1], image_path, &image);
+    // A truncated image is rejected
+    errors += (truncate(image_path, 4096) != 0 || state_ok(cluster_conf_image_load(argv[1], image_path, &image)));
+
+    printf("%u islands, %u nodes: text read in %.2lf ms, image loaded in %.3lf ms, %u errors\n", text.num_islands,
+           (cluster_conf_index_get(&text) != NULL) ? cluster_conf_index_get(&text)->num_entries : 0, t_text, t_image,
+           errors);
+    free(text_print);
+    free_cluster_conf(&text);
+    unlink(image_path);
+    return (errors != 0);
+}
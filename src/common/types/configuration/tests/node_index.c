@@ -0,0 +1,198 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Compares the node index of an ear.conf with the per node functions.
+//
+// It builds the index (the first run resolves the nodes, the next ones use
+// the cache in TmpDir) and checks that the nodes have the same IP, island and
+// range than get_ip_dns, get_my_node_conf and the island range scan, which
+// return the first definition of a node in file order. Then it
+// prints the time of the lookups with and without the index.
+//
+// If the cache was stored, it checks that a cache with other IPs is used only
+// when it is owned by the user and not writable by others, and not through a
+// link. The original cache is restored at the end.
+//
+//     ./node_index ear.conf
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <common/types/configuration/cluster_conf.h>
+#include <common/types/configuration/cluster_conf_index.h>
+
+#define CACHE_HEADER_SIZE 24 // cache_header_t of cluster_conf_index.c
+#define FAKE_IP           0x0a0b0c0d
+
+static void cache_write(char *path, char *data, size_t size, mode_t mode)
+{
+    int fd;
+
+    unlink(path);
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600)) < 0) {
+        return;
+    }
+    if (write(fd, data, size) != (ssize_t) size) {
+        printf("error writing %s\n", path);
+    }
+    fchmod(fd, mode);
+    close(fd);
+}
+
+// Returns the IP of the first node of an index built with the cache of path,
+// which has other IPs, made of mode.
+static int32_t cache_ip(cluster_conf_t *conf, char *path, char *data, size_t size, mode_t mode, int link)
+{
+    char target[SZ_PATH + 8];
+    node_index_t index;
+    int32_t ip = 0;
+
+    if (link) {
+        snprintf(target, sizeof(target), "%s.link", path);
+        cache_write(target, data, size, mode);
+        unlink(path);
+        if (symlink(target, path) != 0) {
+            return 0;
+        }
+    } else {
+        cache_write(path, data, size, mode);
+    }
+    if (state_ok(node_index_build(conf, &index))) {
+        ip = index.entries[0].ip;
+        node_index_dispose(&index);
+    }
+    if (link) {
+        unlink(path);
+        unlink(target);
+    }
+    return ip;
+}
+
+// Checks the cache is trusted just if nobody else could have written it
+static uint check_cache(cluster_conf_t *conf, node_index_t *index)
+{
+    char path[SZ_PATH];
+    char *data, *fake;
+    struct stat st;
+    uint errors = 0;
+    size_t i;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/.ear_node_index_%016llx", conf->install.dir_temp, index->hash);
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) != 0) {
+        printf("cache %s not stored, its checks are skipped\n", path);
+        return 0;
+    }
+    data = calloc(1, st.st_size);
+    fake = calloc(1, st.st_size);
+    if (read(fd, data, st.st_size) != st.st_size) {
+        printf("error reading %s\n", path);
+    }
+    close(fd);
+    memcpy(fake, data, st.st_size);
+    for (i = CACHE_HEADER_SIZE; i + sizeof(int32_t) <= st.st_size; i += sizeof(int32_t)) {
+        *((int32_t *) &fake[i]) = FAKE_IP;
+    }
+    if (cache_ip(conf, path, fake, st.st_size, 0644, 0) != FAKE_IP) {
+        printf("error: a cache of the user is not used\n");
+        errors++;
+    }
+    if (cache_ip(conf, path, fake, st.st_size, 0666, 0) != index->entries[0].ip) {
+        printf("error: a cache writable by others is used\n");
+        errors++;
+    }
+    if (cache_ip(conf, path, fake, st.st_size, 0644, 1) != index->entries[0].ip) {
+        printf("error: a link to a cache is used\n");
+        errors++;
+    }
+    cache_write(path, data, st.st_size, 0644);
+    free(data);
+    free(fake);
+    return errors;
+}
+
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    double start, t_build, t_scan = 0.0, t_index = 0.0, t_dns = 0.0;
+    node_index_entry_t *entry, copy;
+    uint errors = 0, i, checked = 0;
+    cluster_conf_t conf;
+    my_node_conf_t *n;
+    node_index_t *index;
+    int island;
+
+    if (argc < 2) {
+        printf("usage: %s ear.conf\n", argv[0]);
+        return 1;
+    }
+    memset(&conf, 0, sizeof(cluster_conf_t));
+    if (read_cluster_conf(argv[1], &conf) != EAR_SUCCESS) {
+        printf("cannot read %s\n", argv[1]);
+        return 1;
+    }
+    start   = now_ms();
+    index   = cluster_conf_index_get(&conf);
+    t_build = now_ms() - start;
+    if (index == NULL) {
+        printf("cannot build the index: %s\n", state_msg);
+        return 1;
+    }
+    for (i = 0; i < index->num_entries; i++) {
+        // A node can be defined in more than one range (ear.conf.template
+        // does it). The per node functions return its first definition in
+        // file order, and so must do the index.
+        if ((entry = node_index_find(index, index->entries[i].name)) == NULL || entry > &index->entries[i]) {
+            errors++;
+            continue;
+        }
+        // The resolver and get_my_node_conf are checked only for a sample, they are slow
+        if (i % 97 == 0) {
+            start = now_ms();
+            errors += (get_ip_dns(entry->name, &conf) != entry->ip);
+            t_dns += now_ms() - start;
+            n = get_my_node_conf(&conf, entry->name);
+            errors += (n == NULL || n->island != entry->island);
+            free(n);
+            checked++;
+        }
+        start  = now_ms();
+        island = get_node_island(&conf, entry->name);
+        errors += (get_ip(entry->name, &conf) != entry->ip);
+        t_index += now_ms() - start;
+        errors += (island != entry->island);
+        start = now_ms();
+        for (island = 0; island < conf.num_islands; island++) {
+            if (nodeconf_get_island_range_for_node(&conf.islands[island], entry->name) >= 0) {
+                break;
+            }
+        }
+        t_scan += now_ms() - start;
+        errors += (island != entry->island_idx);
+    }
+    errors += (cluster_conf_index_find(&conf, "not-a-node", &copy) == EAR_SUCCESS);
+    errors += check_cache(&conf, index);
+    printf("%u nodes in %u ranges: index built in %.1lf ms (sequential resolution %.1lf ms), %.2lf us per range scan, "
+           "%.2lf us per get_node_island + get_ip, %u nodes checked, %u errors\n",
+           index->num_entries, index->num_ranges, t_build, t_dns / checked * index->num_entries,
+           t_scan * 1e3 / index->num_entries, t_index * 1e3 / index->num_entries, checked, errors);
+    free_cluster_conf(&conf);
+    return (errors != 0);
+}
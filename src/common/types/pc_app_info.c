@@ -20,9 +20,21 @@
 #include <common/types/pc_app_info.h>
 #include <daemon/powercap/powercap_status_conf.h>
 
+size_t pcapp_info_size(uint num_cpus)
+{
+    return sizeof(pc_app_info_t) + sizeof(ulong) * num_cpus;
+}
+
+void pcapp_info_init(pc_app_info_t *t, uint num_cpus)
+{
+    memset(t, 0, pcapp_info_size(num_cpus));
+    t->version  = PC_APP_INFO_VERSION;
+    t->num_cpus = num_cpus;
+}
+
 void pcapp_info_new_job(pc_app_info_t *t)
 {
-    memset(t->req_f, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(t->req_f, 0, sizeof(ulong) * t->num_cpus);
     t->req_power = 0;
     t->pc_status = PC_STATUS_IDLE;
 #if USE_GPUS
@@ -34,7 +46,7 @@ void pcapp_info_new_job(pc_app_info_t *t)
 
 void pcapp_info_end_job(pc_app_info_t *t)
 {
-    memset(t->req_f, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(t->req_f, 0, sizeof(ulong) * t->num_cpus);
     t->req_power = 0;
     t->pc_status = PC_STATUS_IDLE;
 #if USE_GPUS
@@ -46,8 +58,7 @@ void pcapp_info_end_job(pc_app_info_t *t)
 
 void pcapp_info_set_req_f(pc_app_info_t *t, ulong *f, uint num_cpus)
 {
-    memcpy(t->req_f, f, sizeof(ulong) * num_cpus);
-    ;
+    memcpy(t->req_f, f, sizeof(ulong) * ear_min(num_cpus, t->num_cpus));
     t->pc_status = PC_STATUS_OK;
 }
 
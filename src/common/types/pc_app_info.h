@@ -15,10 +15,17 @@
 #include <common/config/config_install.h>
 #include <common/types/types.h>
 
+/* Increase it every time the layout changes, EARL does not attach to areas
+ * created by an EARD with a different version. */
+#define PC_APP_INFO_VERSION 2
+
+/* The area is sized by the number of CPUs of the node, req_f is the last
+ * field. Use pcapp_info_size() instead of sizeof(). */
 typedef struct pc_app_info {
+    uint version;
+    uint num_cpus; /* Length of req_f */
     uint powercap;
     uint cpu_mode;
-    ulong req_f[MAX_CPUS_SUPPORTED];
     ulong imc_f[MAX_SOCKETS_SUPPORTED];
     ulong req_power;
     uint pc_status;
@@ -29,12 +36,18 @@ typedef struct pc_app_info {
     ulong req_gpu_power;
     uint pc_gpu_status;
 #endif
+    ulong req_f[];
 } pc_app_info_t;
 
+/** Returns the size of the area for a node of num_cpus CPUs. */
+size_t pcapp_info_size(uint num_cpus);
+/** Sets the header of a new area. */
+void pcapp_info_init(pc_app_info_t *t, uint num_cpus);
+
 void pcapp_info_new_job(pc_app_info_t *t);
 void pcapp_info_end_job(pc_app_info_t *t);
 
-/** Sets the req_f and the status to OK */
+/** Sets the req_f (up to the CPUs of the area) and the status to OK */
 void pcapp_info_set_req_f(pc_app_info_t *t, ulong *f, uint num_cpus);
 /** Sets the gpu_req_f and the status to OK */
 void pcapp_info_set_gpu_req_f(pc_app_info_t *t, ulong *f, uint num_gpus);
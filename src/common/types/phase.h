@@ -0,0 +1,59 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef EAR_TYPES_PHASE_H
+#define EAR_TYPES_PHASE_H
+
+#include <common/types/generic.h>
+
+/* Phases remembered per application. */
+#define PHASE_CONF_MAX 32
+
+/** Identifies an application phase: its loop, the CPU P_STATE its signature was
+ * computed at and the quantized CPI, GB/s, VPI and I/O of the signature. */
+typedef struct phase_key {
+    ulong event;
+    ulong size;
+    ulong level;
+    uint pstate;
+    int cpi;
+    int gbs;
+    int vpi;
+    int io;
+} phase_key_t;
+
+/** Savings projected by the policy for the frequencies selected. */
+typedef struct phase_proj {
+    float esaving;
+    float psaving;
+    float tpenalty;
+} phase_proj_t;
+
+/** The application a list of phases belongs to. The frequencies selected
+ * depend on the policy settings, so these are part of the identity. */
+typedef struct phase_app {
+    char app_id[GENERIC_NAME];
+    char policy[GENERIC_NAME];
+    double th;
+    ulong def_freq;
+    uint eufs; // The IMC frequency is selected too
+} phase_app_t;
+
+/** The frequencies selected for a phase at node level. A phase with valid set
+ * to 0 is one whose frequencies were not validated and must be forgotten. */
+typedef struct phase_conf {
+    phase_key_t key;
+    phase_proj_t proj;
+    ulong cpu_freq;
+    ulong imc_pstate[2]; // Of the maximum and minimum IMC frequencies
+    uint valid;
+} phase_conf_t;
+
+#endif // EAR_TYPES_PHASE_H
@@ -0,0 +1,199 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include <common/utils/least_squares.h>
+
+#define LSQ_PIVOT_MIN 1e-12 // Relative to the biggest diagonal element
+#define LSQ_RIDGE     1e-9  // Regularization of singular systems, relative to the mean diagonal
+
+void lsq_init(lsq_t *l, uint params)
+{
+    memset(l, 0, sizeof(lsq_t));
+    l->params = ear_min(params, LSQ_MAX_PARAMS);
+}
+
+void lsq_add(lsq_t *l, double *x, double y)
+{
+    uint i, j;
+
+    for (i = 0; i < l->params; ++i) {
+        for (j = i; j < l->params; ++j) {
+            l->xtx[i][j] += x[i] * x[j];
+        }
+        l->xty[i] += x[i] * y;
+    }
+    l->yty += y * y;
+    l->y += y;
+    l->samples += 1;
+}
+
+void lsq_merge(lsq_t *dst, lsq_t *src)
+{
+    uint i, j;
+
+    for (i = 0; i < dst->params; ++i) {
+        for (j = i; j < dst->params; ++j) {
+            dst->xtx[i][j] += src->xtx[i][j];
+        }
+        dst->xty[i] += src->xty[i];
+    }
+    dst->yty += src->yty;
+    dst->y += src->y;
+    dst->samples += src->samples;
+}
+
+/* Gaussian elimination with partial pivoting over a copy of the system */
+static state_t lsq_gauss(lsq_t *l, double ridge, double *coeffs)
+{
+    double a[LSQ_MAX_PARAMS][LSQ_MAX_PARAMS + 1];
+    double diag_max = 0.0, f;
+    uint n = l->params, i, j, k, p;
+
+    for (i = 0; i < n; ++i) {
+        for (j = 0; j < n; ++j) {
+            a[i][j] = (j >= i) ? l->xtx[i][j] : l->xtx[j][i];
+        }
+        a[i][i] += ridge;
+        a[i][n]  = l->xty[i];
+        diag_max = ear_max(diag_max, a[i][i]);
+    }
+    for (k = 0; k < n; ++k) {
+        for (p = k, i = k + 1; i < n; ++i) {
+            if (fabs(a[i][k]) > fabs(a[p][k])) {
+                p = i;
+            }
+        }
+        if (fabs(a[p][k]) <= LSQ_PIVOT_MIN * diag_max) {
+            return EAR_ERROR;
+        }
+        if (p != k) {
+            for (j = k; j <= n; ++j) {
+                f       = a[k][j];
+                a[k][j] = a[p][j];
+                a[p][j] = f;
+            }
+        }
+        for (i = k + 1; i < n; ++i) {
+            f = a[i][k] / a[k][k];
+            for (j = k; j <= n; ++j) {
+                a[i][j] -= f * a[k][j];
+            }
+        }
+    }
+    for (k = n; k-- > 0;) {
+        coeffs[k] = a[k][n];
+        for (j = k + 1; j < n; ++j) {
+            coeffs[k] -= a[k][j] * coeffs[j];
+        }
+        coeffs[k] /= a[k][k];
+    }
+    return EAR_SUCCESS;
+}
+
+state_t lsq_solve(lsq_t *l, double *coeffs)
+{
+    double trace = 0.0;
+    uint i;
+
+    memset(coeffs, 0, l->params * sizeof(double));
+    if (l->samples == 0) {
+        return_msg(EAR_ERROR, "no samples to fit");
+    }
+    if (state_ok(lsq_gauss(l, 0.0, coeffs))) {
+        return EAR_SUCCESS;
+    }
+    for (i = 0; i < l->params; ++i) {
+        trace += l->xtx[i][i];
+    }
+    if (trace <= 0.0 || state_fail(lsq_gauss(l, LSQ_RIDGE * trace / (double) l->params, coeffs))) {
+        memset(coeffs, 0, l->params * sizeof(double));
+        return_msg(EAR_ERROR, "singular system");
+    }
+    return EAR_SUCCESS;
+}
+
+void lsq_quality(lsq_t *l, double *coeffs, double *r2, double *rmse)
+{
+    double sse = l->yty, sst;
+    uint i, j;
+
+    *r2   = 0.0;
+    *rmse = 0.0;
+    if (l->samples == 0) {
+        return;
+    }
+    // sse = yᵀy - 2cᵀXᵀy + cᵀXᵀXc
+    for (i = 0; i < l->params; ++i) {
+        sse -= 2.0 * coeffs[i] * l->xty[i];
+        for (j = 0; j < l->params; ++j) {
+            sse += coeffs[i] * coeffs[j] * ((j >= i) ? l->xtx[i][j] : l->xtx[j][i]);
+        }
+    }
+    sse   = ear_max(sse, 0.0);
+    sst   = l->yty - (l->y * l->y) / (double) l->samples;
+    *rmse = sqrt(sse / (double) l->samples);
+    *r2   = (sst > 0.0) ? 1.0 - sse / sst : 1.0;
+}
+
+void rls_init(rls_t *r, uint params, double *coeffs, double delta, double lambda)
+{
+    uint i;
+
+    memset(r, 0, sizeof(rls_t));
+    r->params = ear_min(params, LSQ_MAX_PARAMS);
+    r->lambda = lambda;
+    for (i = 0; i < r->params; ++i) {
+        r->p[i][i]   = delta;
+        r->coeffs[i] = (coeffs != NULL) ? coeffs[i] : 0.0;
+    }
+}
+
+void rls_update(rls_t *r, double *x, double y)
+{
+    double px[LSQ_MAX_PARAMS], k[LSQ_MAX_PARAMS];
+    double den = r->lambda, err;
+    uint i, j;
+
+    for (i = 0; i < r->params; ++i) {
+        for (px[i] = 0.0, j = 0; j < r->params; ++j) {
+            px[i] += r->p[i][j] * x[j];
+        }
+        den += x[i] * px[i];
+    }
+    if (den <= 0.0) {
+        return;
+    }
+    err = y - rls_predict(r, x);
+    for (i = 0; i < r->params; ++i) {
+        k[i] = px[i] / den;
+        r->coeffs[i] += k[i] * err;
+    }
+    // P = (P - k(Px)ᵀ) / lambda
+    for (i = 0; i < r->params; ++i) {
+        for (j = 0; j < r->params; ++j) {
+            r->p[i][j] = (r->p[i][j] - k[i] * px[j]) / r->lambda;
+        }
+    }
+    r->updates += 1;
+}
+
+double rls_predict(rls_t *r, double *x)
+{
+    double y = 0.0;
+    uint i;
+
+    for (i = 0; i < r->params; ++i) {
+        y += r->coeffs[i] * x[i];
+    }
+    return y;
+}
@@ -0,0 +1,75 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef COMMON_UTILS_LEAST_SQUARES_H
+#define COMMON_UTILS_LEAST_SQUARES_H
+
+#include <common/states.h>
+#include <common/types/generic.h>
+
+#define LSQ_MAX_PARAMS 8
+
+// Streaming linear least squares. The samples are not stored, just the
+// normal equations (XᵀX and Xᵀy) and the sums needed to compute the
+// quality of the fit, so a fit takes a single pass over the data and
+// accumulators filled by different threads can be merged.
+//
+// Ex:
+//  lsq_init(&l, 3);
+//  for (...) {
+//      double x[3] = {1.0, power, tpi};
+//      lsq_add(&l, x, target_power);
+//  }
+//  lsq_solve(&l, coeffs);
+//  lsq_quality(&l, coeffs, &r2, &rmse);
+
+typedef struct lsq_s {
+    uint params;
+    double xtx[LSQ_MAX_PARAMS][LSQ_MAX_PARAMS];
+    double xty[LSQ_MAX_PARAMS];
+    double yty;
+    double y;
+    ulong samples;
+} lsq_t;
+
+void lsq_init(lsq_t *l, uint params);
+
+void lsq_add(lsq_t *l, double *x, double y);
+
+/** Adds the samples of src to dst. Both have to be of the same number of parameters. */
+void lsq_merge(lsq_t *dst, lsq_t *src);
+
+/** Computes the coefficients minimizing the squared error. If the system is singular (more parameters than independent
+ * samples), a slightly regularized system is solved instead. Returns EAR_ERROR if there are no samples. */
+state_t lsq_solve(lsq_t *l, double *coeffs);
+
+/** Computes the coefficient of determination (r2) and the root of the mean squared error of the coefficients. */
+void lsq_quality(lsq_t *l, double *coeffs, double *r2, double *rmse);
+
+// Recursive least squares. The coefficients are updated with each sample,
+// and the older samples lose weight by the forgetting factor lambda (1.0
+// keeps all of them). The initial coefficients are a prior whose weight is
+// given by delta, the lower the stronger.
+
+typedef struct rls_s {
+    uint params;
+    double p[LSQ_MAX_PARAMS][LSQ_MAX_PARAMS]; // Inverse of the (weighted) XᵀX
+    double coeffs[LSQ_MAX_PARAMS];
+    double lambda;
+    ulong updates;
+} rls_t;
+
+void rls_init(rls_t *r, uint params, double *coeffs, double delta, double lambda);
+
+void rls_update(rls_t *r, double *x, double y);
+
+double rls_predict(rls_t *r, double *x);
+
+#endif // COMMON_UTILS_LEAST_SQUARES_H
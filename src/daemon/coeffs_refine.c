@@ -0,0 +1,288 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/output/debug.h>
+#include <common/output/verbose.h>
+#include <common/utils/least_squares.h>
+#include <daemon/coeffs_refine.h>
+
+#define REFINE_APPS        64   // Applications remembered
+#define REFINE_HOLDOUT     4    // One of each REFINE_HOLDOUT pairs validates instead of training
+#define REFINE_RING        8    // Validation pairs kept per P_STATE pair
+#define REFINE_RING_MIN    3    // Validation pairs needed to compare
+#define REFINE_UPDATES_MIN 6    // Training pairs needed to compare
+#define REFINE_LAMBDA      0.98 // Forgetting factor, to follow the drift of the node
+#define REFINE_DELTA       100.0
+#define REFINE_GAIN        0.95 // The refined coefficients must reduce the validation error a 5%
+#define REFINE_SNAP        0.02 // Distance of the average frequency to a P_STATE, relative to the P_STATE
+
+typedef struct refine_sig {
+    double power;
+    double tpi;
+    double cpi;
+    uint valid;
+} refine_sig_t;
+
+typedef struct refine_app {
+    char app_id[GENERIC_NAME];
+    ulong last_use;
+    refine_sig_t *sigs; // Per P_STATE
+} refine_app_t;
+
+typedef struct refine_sample {
+    double x_power[3]; // Bias, power and TPI of the base
+    double x_cpi[3];   // Bias, CPI and TPI of the base
+    double power;      // Of the target
+    double cpi;
+} refine_sample_t;
+
+typedef struct refine_pair {
+    int entry; // In the coefficients area, -1 if the pair is not there
+    rls_t power;
+    rls_t cpi;
+    refine_sample_t ring[REFINE_RING];
+    uint ring_count;
+    uint ring_next;
+    ulong count;
+} refine_pair_t;
+
+static pthread_mutex_t refine_lock = PTHREAD_MUTEX_INITIALIZER;
+static coefficient_t *coeffs_sh;
+static ulong *pstates;
+static uint pstates_count;
+static refine_pair_t *pairs; // Base P_STATE x target P_STATE
+static refine_app_t apps[REFINE_APPS];
+static ulong uses;
+
+static int pstate_index(ulong freq)
+{
+    int i;
+
+    for (i = 0; i < pstates_count; ++i) {
+        if (pstates[i] == freq) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* The P_STATE the application ran at, if its average frequency is close to one. The default frequency
+ * of the signature is the one of the policy settings, not the one the application ran at. */
+static int pstate_snap(ulong avg_f)
+{
+    double dist, dist_min = INFINITY;
+    int i, nearest = -1;
+
+    for (i = 0; i < pstates_count; ++i) {
+        dist = fabs((double) avg_f - (double) pstates[i]);
+        if (dist < dist_min) {
+            dist_min = dist;
+            nearest  = i;
+        }
+    }
+    if (nearest < 0 || dist_min > REFINE_SNAP * (double) pstates[nearest]) {
+        return -1;
+    }
+    return nearest;
+}
+
+static void pstate_add(ulong freq)
+{
+    if (freq > 0 && pstate_index(freq) < 0) {
+        pstates[pstates_count++] = freq;
+    }
+}
+
+state_t coeffs_refine_init(coefficient_t *coeffs, uint count)
+{
+    double prior[3];
+    refine_pair_t *pair;
+    int b, t;
+    uint e;
+
+    if (coeffs == NULL || count == 0) {
+        return_msg(EAR_ERROR, Generr.input_null);
+    }
+    if ((pstates = calloc(2 * count, sizeof(ulong))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    for (e = 0; e < count; ++e) {
+        pstate_add(coeffs[e].pstate_ref);
+        pstate_add(coeffs[e].pstate);
+    }
+    if (pstates_count < 2) {
+        free(pstates);
+        pstates_count = 0;
+        return_msg(EAR_ERROR, "less than two P_STATEs in the coefficients");
+    }
+    if ((pairs = calloc(pstates_count * pstates_count, sizeof(refine_pair_t))) == NULL) {
+        free(pstates);
+        pstates_count = 0;
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    for (e = 0; e < pstates_count * pstates_count; ++e) {
+        pairs[e].entry = -1;
+    }
+    for (e = 0; e < count; ++e) {
+        b = pstate_index(coeffs[e].pstate_ref);
+        t = pstate_index(coeffs[e].pstate);
+        if (b < 0 || t < 0 || b == t) {
+            continue;
+        }
+        // The coefficients of the learning phase are the prior
+        pair        = &pairs[b * pstates_count + t];
+        pair->entry = e;
+        prior[0]    = (coeffs[e].available) ? coeffs[e].C : 0.0;
+        prior[1]    = (coeffs[e].available) ? coeffs[e].A : 0.0;
+        prior[2]    = (coeffs[e].available) ? coeffs[e].B : 0.0;
+        rls_init(&pair->power, 3, prior, REFINE_DELTA, REFINE_LAMBDA);
+        prior[0] = (coeffs[e].available) ? coeffs[e].F : 0.0;
+        prior[1] = (coeffs[e].available) ? coeffs[e].D : 0.0;
+        prior[2] = (coeffs[e].available) ? coeffs[e].E : 0.0;
+        rls_init(&pair->cpi, 3, prior, REFINE_DELTA, REFINE_LAMBDA);
+    }
+    coeffs_sh = coeffs;
+    verbose(VCONF, "Refining %u coefficients of %u P_STATEs", count, pstates_count);
+    return EAR_SUCCESS;
+}
+
+/* Mean relative error of the power and CPI projections of the validation pairs */
+static double pair_error(refine_pair_t *pair, double *power, double *cpi)
+{
+    double error = 0.0, proj_power, proj_cpi;
+    refine_sample_t *s;
+    uint i, j;
+
+    for (i = 0; i < pair->ring_count; ++i) {
+        s = &pair->ring[i];
+        for (j = 0, proj_power = 0.0, proj_cpi = 0.0; j < 3; ++j) {
+            proj_power += power[j] * s->x_power[j];
+            proj_cpi += cpi[j] * s->x_cpi[j];
+        }
+        error += fabs(1.0 - proj_power / s->power) + fabs(1.0 - proj_cpi / s->cpi);
+    }
+    return error / (2.0 * pair->ring_count);
+}
+
+static void pair_check(refine_pair_t *pair)
+{
+    coefficient_t *current = &coeffs_sh[pair->entry];
+    double power[3]        = {current->C, current->A, current->B};
+    double cpi[3]          = {current->F, current->D, current->E};
+    double error_current, error_refined;
+    coefficient_t refined;
+
+    if (pair->ring_count < REFINE_RING_MIN || pair->power.updates < REFINE_UPDATES_MIN) {
+        return;
+    }
+    error_current = (current->available) ? pair_error(pair, power, cpi) : INFINITY;
+    error_refined = pair_error(pair, pair->power.coeffs, pair->cpi.coeffs);
+    if (error_refined >= error_current * REFINE_GAIN) {
+        return;
+    }
+    // EARL copies the coefficients when a job starts, it retries while the entry is written
+    refined           = *current;
+    refined.available = 1;
+    refined.A         = pair->power.coeffs[1];
+    refined.B         = pair->power.coeffs[2];
+    refined.C         = pair->power.coeffs[0];
+    refined.D         = pair->cpi.coeffs[1];
+    refined.E         = pair->cpi.coeffs[2];
+    refined.F         = pair->cpi.coeffs[0];
+    coeff_write(current, &refined);
+    verbose(VJOBPMON, "Coefficients %lu -> %lu refined, validation error %.3lf -> %.3lf", refined.pstate_ref,
+            refined.pstate, error_current, error_refined);
+}
+
+static void pair_update(refine_pair_t *pair, refine_sig_t *base, refine_sig_t *target)
+{
+    refine_sample_t s = {.x_power = {1.0, base->power, base->tpi},
+                         .x_cpi   = {1.0, base->cpi, base->tpi},
+                         .power   = target->power,
+                         .cpi     = target->cpi};
+
+    if (pair->entry < 0) {
+        return;
+    }
+    pair->count += 1;
+    if (pair->count % REFINE_HOLDOUT == 0) {
+        pair->ring[pair->ring_next] = s;
+        pair->ring_next             = (pair->ring_next + 1) % REFINE_RING;
+        pair->ring_count            = ear_min(pair->ring_count + 1, REFINE_RING);
+    } else {
+        rls_update(&pair->power, s.x_power, s.power);
+        rls_update(&pair->cpi, s.x_cpi, s.cpi);
+    }
+    pair_check(pair);
+}
+
+static refine_app_t *app_find(char *app_id)
+{
+    refine_app_t *lru = &apps[0];
+    uint a;
+
+    for (a = 0; a < REFINE_APPS; ++a) {
+        if (apps[a].sigs != NULL && strncmp(apps[a].app_id, app_id, GENERIC_NAME) == 0) {
+            return &apps[a];
+        }
+        if (apps[a].last_use < lru->last_use) {
+            lru = &apps[a];
+        }
+    }
+    // Replacing the least recently used
+    if (lru->sigs == NULL && (lru->sigs = calloc(pstates_count, sizeof(refine_sig_t))) == NULL) {
+        return NULL;
+    }
+    memset(lru->sigs, 0, pstates_count * sizeof(refine_sig_t));
+    snprintf(lru->app_id, sizeof(lru->app_id), "%s", app_id);
+    return lru;
+}
+
+void coeffs_refine_signature(application_t *app)
+{
+    signature_t *sig = &app->signature;
+    refine_sig_t current;
+    refine_app_t *rapp;
+    int ps, o;
+
+    if (coeffs_sh == NULL || sig->DC_power <= 0.0 || sig->CPI <= 0.0 || app->job.app_id[0] == '\0') {
+        return;
+    }
+    if ((ps = pstate_snap(sig->avg_f)) < 0) {
+        return;
+    }
+    current.power = sig->DC_power;
+    current.tpi   = sig->TPI;
+    current.cpi   = sig->CPI;
+    current.valid = 1;
+
+    pthread_mutex_lock(&refine_lock);
+    if ((rapp = app_find(app->job.app_id)) != NULL) {
+        rapp->last_use = ++uses;
+        for (o = 0; o < pstates_count; ++o) {
+            if (o == ps || !rapp->sigs[o].valid) {
+                continue;
+            }
+            pair_update(&pairs[o * pstates_count + ps], &rapp->sigs[o], &current);
+            pair_update(&pairs[ps * pstates_count + o], &current, &rapp->sigs[o]);
+        }
+        rapp->sigs[ps] = current;
+        debug("Application %s signature at %lu (avg. %lu) folded in", app->job.app_id, pstates[ps], sig->avg_f);
+    }
+    pthread_mutex_unlock(&refine_lock);
+}
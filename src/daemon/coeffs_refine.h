@@ -0,0 +1,37 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _EARD_COEFFS_REFINE_H
+#define _EARD_COEFFS_REFINE_H
+
+#include <common/states.h>
+#include <common/types/application.h>
+#include <common/types/coefficient.h>
+
+/* Online refinement of the coefficients computed in the learning phase.
+ * EARD remembers the last signature of the recent applications at each
+ * P_STATE, the one its average frequency is close to. Signatures with an
+ * average frequency between P_STATEs, because the policy changed it or
+ * because of the turbo, are discarded. When an application reports a
+ * signature, it is paired with the ones of the same application at other
+ * P_STATEs, as the learning phase does, and the pairs update a recursive
+ * least squares fit of the power and CPI projections between both
+ * P_STATEs. One of each few pairs is kept apart to validate, and the
+ * refined coefficients replace the ones in the shared area only when they
+ * project the validation pairs better. The entries are written by
+ * coeff_write, the readers copy them by coeff_read. */
+
+/** Starts refining the count coefficients of the shared area coeffs. */
+state_t coeffs_refine_init(coefficient_t *coeffs, uint count);
+
+/** Folds in the signature of an application. It is thread safe. */
+void coeffs_refine_signature(application_t *app);
+
+#endif
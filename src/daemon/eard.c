@@ -31,6 +31,7 @@
 #include <common/system/execute.h>
 #include <common/system/folder.h>
 #include <common/system/monitor.h>
+#include <common/types/configuration/cluster_conf_image.h>
 #include <common/types/pc_app_info.h>
 
 #include <report/report.h>
@@ -47,6 +48,7 @@
 #include <metrics/gpu/gpu.h>
 #include <metrics/imcfreq/imcfreq.h>
 
+#include <daemon/coeffs_refine.h>
 #include <daemon/common.h>
 #include <daemon/eard.h>
 #include <daemon/eard_checkpoint.h>
@@ -412,8 +414,8 @@ void signal_handler(int sig)
 
         free_cluster_conf(&my_cluster_conf);
 
-        // Reading the configuration
-        if (read_cluster_conf(my_ear_conf_path, &my_cluster_conf) != EAR_SUCCESS) {
+        // Reading the configuration, from its compiled image if it is up to date
+        if (state_fail(cluster_conf_image_read(my_ear_conf_path, &my_cluster_conf))) {
             error(" Error reading cluster configuration");
         } else {
             verbose(VCONF, "Loading EAR configuration... There are %d Nodes in the cluster", my_cluster_conf.num_nodes);
@@ -752,7 +754,7 @@ int main(int argc, char *argv[])
         error("Error opening ear.conf file, not available at regular paths ($EAR_ETC/ear/ear.conf)");
         _exit(0);
     }
-    if (read_cluster_conf(my_ear_conf_path, &my_cluster_conf) != EAR_SUCCESS) {
+    if (state_fail(cluster_conf_image_read(my_ear_conf_path, &my_cluster_conf))) {
         error(" Error reading cluster configuration\n");
         _exit(1);
     }
@@ -844,6 +846,11 @@ int main(int argc, char *argv[])
         error("Error creating shared memory for coefficients by default\n");
         _exit(0);
     }
+#if EARD_COEFFS_REFINE
+    if (state_fail(coeffs_refine_init(coeffs_default_conf, coeffs_default_size / sizeof(coefficient_t)))) {
+        verbose(VCONF, "Coefficients are not refined (%s)", state_msg);
+    }
+#endif
 
     /* This area incldues services details */
     get_services_conf_path(my_cluster_conf.install.dir_temp, services_conf_path);
@@ -924,6 +931,15 @@ int main(int argc, char *argv[])
         error("While initiating the energy plug-in: %s", state_msg);
         error_energy = 1;
     }
+    // The node energy cache answers the readings without waiting the BMC
+    char *energy_cache_env = ear_getenv(FLAG_ENERGY_NODE_CACHE);
+    if (!error_energy && energy_cache_env != NULL) {
+        if (state_fail(s = energy_cache_init(&eard_handler_energy, (ulong) atoi(energy_cache_env)))) {
+            error("While initiating the energy cache: %s", state_msg);
+        } else {
+            verbose(VEARD_INIT, "Node energy cache enabled");
+        }
+    }
 
     if (state_fail(s = init_power_monitoring(&handler_energy, &node_desc))) {
         error("While initializing power monitor: %s\n", state_msg);
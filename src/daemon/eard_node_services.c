@@ -33,6 +33,7 @@
 #include <daemon/local_api/eard_api.h>
 #include <daemon/local_api/node_mgr.h>
 #include <daemon/log_eard.h>
+#include <daemon/phase_store.h>
 #include <daemon/power_monitor.h>
 #include <daemon/remote_api/dynamic_configuration.h>
 #include <daemon/shared_configuration.h>
@@ -1219,8 +1220,21 @@ int eard_node_energy(eard_head_t *head, int req_fd, int ack_fd)
     return 1;
 }
 
+/* The phases are kept per user, the one of the job of the connection */
+static state_t phase_store_user(int con_id, char *user_id, size_t size)
+{
+    if (con_id < 0 || eard_local_conn[con_id].anonymous) {
+        return_msg(EAR_ERROR, "the phase store is not available for anonymous connections");
+    }
+    return powermon_job_user(eard_local_conn[con_id].jid, eard_local_conn[con_id].sid, user_id, size);
+}
+
 int eard_system(eard_head_t *head, int req_fd, int ack_fd)
 {
+    phase_conf_t phases[PHASE_CONF_MAX];
+    char user_id[GENERIC_NAME];
+    phase_app_t phase_app;
+    uint phases_count;
     application_t app;
     ear_event_t event;
     loop_t loop;
@@ -1282,6 +1296,33 @@ int eard_system(eard_head_t *head, int req_fd, int ack_fd)
                 s = report_events(&rid, &event, 1);
             }
             break;
+        case RPC_GET_PHASES:
+            serial_reset(&wb, head->size);
+            if (state_fail(s = eard_rpc_read_pending(req_fd, serial_data(&wb), head->size, sizeof(phase_app_t)))) {
+                serror(Rpcerr.pending);
+            } else if (state_ok(s = phase_store_user(con_id, user_id, sizeof(user_id)))) {
+                memcpy(&phase_app, serial_data(&wb), sizeof(phase_app_t));
+                if (state_ok(s = phase_store_get(user_id, &phase_app, phases, &phases_count))) {
+                    data = (char *) phases;
+                    size = phases_count * sizeof(phase_conf_t);
+                }
+            }
+            break;
+        case RPC_PUT_PHASES:
+            serial_reset(&wb, head->size);
+            phases_count = (head->size - sizeof(phase_app_t)) / sizeof(phase_conf_t);
+            if (state_fail(s = eard_rpc_read_pending(req_fd, serial_data(&wb), head->size, 0))) {
+                serror(Rpcerr.pending);
+            } else if (head->size < sizeof(phase_app_t) || phases_count > PHASE_CONF_MAX ||
+                       head->size != sizeof(phase_app_t) + phases_count * sizeof(phase_conf_t)) {
+                s         = EAR_ERROR;
+                state_msg = "phases received with an unexpected size";
+            } else if (state_ok(s = phase_store_user(con_id, user_id, sizeof(user_id)))) {
+                memcpy(&phase_app, serial_data(&wb), sizeof(phase_app_t));
+                memcpy(phases, &serial_data(&wb)[sizeof(phase_app_t)], phases_count * sizeof(phase_conf_t));
+                s = phase_store_put(user_id, &phase_app, phases, phases_count);
+            }
+            break;
         default:
             return 0;
     }
@@ -1557,6 +1598,10 @@ state_t eard_local_api(char *ear_owner)
     verbose(VEARD_LAPI, "Creating global connector");
     create_global_connector(ear_tmp, nodename);
 
+#if EARD_PHASE_STORE
+    phase_store_init(ear_tmp);
+#endif
+
     verbose(VEARD_LAPI, "Communicator for %s ON", nodename);
 
     // we wait until EAR daemon receives a request
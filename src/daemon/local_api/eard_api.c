@@ -855,6 +855,31 @@ state_t eards_get_state(eard_state_t *state)
     return eard_rpc(RPC_GET_STATE, NULL, 0, (char *) state, sizeof(eard_state_t));
 }
 
+state_t eards_get_phases(phase_app_t *app, phase_conf_t *confs, uint max, uint *count)
+{
+    char *buffer;
+    size_t size;
+    state_t s;
+
+    *count = 0;
+    if (state_fail(s = eard_rpc_buffered(RPC_GET_PHASES, (char *) app, sizeof(phase_app_t), &buffer, &size))) {
+        return s;
+    }
+    *count = ear_min(size / sizeof(phase_conf_t), max);
+    memcpy(confs, buffer, *count * sizeof(phase_conf_t));
+    return EAR_SUCCESS;
+}
+
+state_t eards_put_phases(phase_app_t *app, phase_conf_t *confs, uint count)
+{
+    char data[sizeof(phase_app_t) + PHASE_CONF_MAX * sizeof(phase_conf_t)];
+
+    count = ear_min(count, PHASE_CONF_MAX);
+    memcpy(data, app, sizeof(phase_app_t));
+    memcpy(&data[sizeof(phase_app_t)], confs, count * sizeof(phase_conf_t));
+    return eard_rpc(RPC_PUT_PHASES, data, sizeof(phase_app_t) + count * sizeof(phase_conf_t), NULL, 0);
+}
+
 ulong eards_get_data_size_rapl() // size in bytes
 {
     if (!app_connected)
@@ -14,6 +14,7 @@
 #include <common/system/version.h>
 #include <common/types/generic.h>
 #include <common/types/log.h>
+#include <common/types/phase.h>
 #include <daemon/local_api/eard_api_conf.h>
 #include <daemon/local_api/eard_api_rpc.h>
 
@@ -68,6 +69,12 @@ int eards_gpu_support();
 // Returns basic EARD compile configured limits & options for verification
 state_t eards_get_state(eard_state_t *state);
 
+// Requests the phases kept by the EARD phase store for the application, up to max.
+state_t eards_get_phases(phase_app_t *app, phase_conf_t *confs, uint max, uint *count);
+
+// Sends the phases of the application to the EARD phase store. Invalid ones are forgotten.
+state_t eards_put_phases(phase_app_t *app, phase_conf_t *confs, uint count);
+
 /** \defgroup rapl_services RAPL services
  * \ingroup local_api
  * \todo Add a description.
@@ -24,6 +24,8 @@
 #define RPC_WRITE_WF_APPLICATION           2003
 #define RPC_WRITE_LOOP                     2004
 #define RPC_WRITE_EVENT                    2006
+#define RPC_GET_PHASES                     2007
+#define RPC_PUT_PHASES                     2008
 #define RPC_MGT_CPUFREQ_GET_API            1001
 #define RPC_MGT_CPUFREQ_GET_AVAILABLE      1002
 #define RPC_MGT_CPUFREQ_GET_CURRENT        1003
@@ -0,0 +1,261 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <common/output/debug.h>
+#include <common/output/verbose.h>
+#include <common/sizes.h>
+#include <daemon/phase_store.h>
+
+#define PHASE_STORE_APPS    128 // Applications remembered
+#define PHASE_STORE_VERSION 1
+
+typedef struct store_phase {
+    phase_conf_t conf;
+    ulong last_use;
+} store_phase_t;
+
+typedef struct store_app {
+    char user_id[GENERIC_NAME];
+    phase_app_t app;
+    store_phase_t phases[PHASE_CONF_MAX];
+    uint count;
+    ulong last_use;
+} store_app_t;
+
+typedef struct store_head {
+    uint version;
+    uint app_size; // A file of other build is discarded
+    uint apps_count;
+    ulong uses;
+} store_head_t;
+
+static char store_path[SZ_PATH];
+static store_app_t apps[PHASE_STORE_APPS];
+static uint apps_count;
+static ulong uses;
+static uint enabled;
+
+/* The strings are terminated and the counts within the arrays */
+static uint store_app_valid(store_app_t *sapp)
+{
+    return (sapp->count <= PHASE_CONF_MAX) && (strnlen(sapp->user_id, GENERIC_NAME) < GENERIC_NAME) &&
+           (strnlen(sapp->app.app_id, GENERIC_NAME) < GENERIC_NAME) &&
+           (strnlen(sapp->app.policy, GENERIC_NAME) < GENERIC_NAME);
+}
+
+/* The temporal folder can be written by every user, so the store is only
+ * loaded if it is a file of EARD that nobody else could have written. */
+static state_t store_load()
+{
+    store_head_t head;
+    struct stat st;
+    ssize_t size;
+    uint r, a;
+    int fd;
+
+    if ((fd = open(store_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC)) < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (st.st_uid != 0 && st.st_uid != geteuid()) ||
+        (st.st_nlink != 1) || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        close(fd);
+        return_msg(EAR_ERROR, "untrusted file");
+    }
+    r    = (read(fd, &head, sizeof(store_head_t)) == sizeof(store_head_t));
+    r    = r && (head.version == PHASE_STORE_VERSION) && (head.app_size == sizeof(store_app_t));
+    r    = r && (head.apps_count <= PHASE_STORE_APPS);
+    size = (ssize_t) (head.apps_count * sizeof(store_app_t));
+    r    = r && (read(fd, apps, size) == size);
+    close(fd);
+    for (a = 0; r && a < head.apps_count; ++a) {
+        r = store_app_valid(&apps[a]);
+    }
+    if (!r) {
+        memset(apps, 0, sizeof(apps));
+        return_msg(EAR_ERROR, "incompatible or corrupted file");
+    }
+    apps_count = head.apps_count;
+    uses       = head.uses;
+    return EAR_SUCCESS;
+}
+
+/* Written to a new temporal file, readable only by EARD, and renamed. A link
+ * or a file of other user is never written, and an EARD killed while saving
+ * leaves the previous store. */
+static state_t store_save()
+{
+    store_head_t head = {.version = PHASE_STORE_VERSION, .app_size = sizeof(store_app_t), .apps_count = apps_count};
+    ssize_t size      = (ssize_t) (apps_count * sizeof(store_app_t));
+    char path[SZ_PATH + 32];
+    uint w;
+    int fd;
+
+    head.uses = uses;
+    snprintf(path, sizeof(path), "%s.%d", store_path, getpid());
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR)) < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    w = (write(fd, &head, sizeof(store_head_t)) == sizeof(store_head_t));
+    w = w && (write(fd, apps, size) == size);
+    w = w && (fsync(fd) == 0);
+    w = (close(fd) == 0) && w;
+    if (!w || rename(path, store_path) != 0) {
+        unlink(path);
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    return EAR_SUCCESS;
+}
+
+state_t phase_store_init(char *path_tmp)
+{
+    snprintf(store_path, sizeof(store_path), "%s/.ear_phase_store", path_tmp);
+    memset(apps, 0, sizeof(apps));
+    apps_count = 0;
+    uses       = 0;
+    enabled    = 1;
+    if (state_fail(store_load())) {
+        verbose(VCONF, "Phase store %s starts empty (%s)", store_path, state_msg);
+        return EAR_SUCCESS;
+    }
+    verbose(VCONF, "Phase store %s loaded with %u applications", store_path, apps_count);
+    return EAR_SUCCESS;
+}
+
+static int app_equal(store_app_t *sapp, char *user_id, phase_app_t *app)
+{
+    return (strncmp(sapp->user_id, user_id, GENERIC_NAME) == 0) &&
+           (strncmp(sapp->app.app_id, app->app_id, GENERIC_NAME) == 0) &&
+           (strncmp(sapp->app.policy, app->policy, GENERIC_NAME) == 0) && (sapp->app.th == app->th) &&
+           (sapp->app.def_freq == app->def_freq) && (sapp->app.eufs == app->eufs);
+}
+
+static store_app_t *app_find(char *user_id, phase_app_t *app)
+{
+    uint a;
+
+    for (a = 0; a < apps_count; ++a) {
+        if (app_equal(&apps[a], user_id, app)) {
+            return &apps[a];
+        }
+    }
+    return NULL;
+}
+
+static store_app_t *app_new(char *user_id, phase_app_t *app)
+{
+    store_app_t *sapp = &apps[0];
+    uint a;
+
+    if (apps_count < PHASE_STORE_APPS) {
+        sapp = &apps[apps_count++];
+    } else {
+        // Replacing the least recently used
+        for (a = 1; a < PHASE_STORE_APPS; ++a) {
+            if (apps[a].last_use < sapp->last_use) {
+                sapp = &apps[a];
+            }
+        }
+    }
+    memset(sapp, 0, sizeof(store_app_t));
+    snprintf(sapp->user_id, sizeof(sapp->user_id), "%s", user_id);
+    memcpy(&sapp->app, app, sizeof(phase_app_t));
+    return sapp;
+}
+
+static store_phase_t *phase_find(store_app_t *sapp, phase_key_t *key)
+{
+    uint p;
+
+    for (p = 0; p < sapp->count; ++p) {
+        if (memcmp(&sapp->phases[p].conf.key, key, sizeof(phase_key_t)) == 0) {
+            return &sapp->phases[p];
+        }
+    }
+    return NULL;
+}
+
+static void phase_merge(store_app_t *sapp, phase_conf_t *conf)
+{
+    store_phase_t *phase = phase_find(sapp, &conf->key);
+    uint p;
+
+    if (!conf->valid) {
+        if (phase != NULL) {
+            *phase = sapp->phases[--sapp->count];
+        }
+        return;
+    }
+    if (phase == NULL) {
+        if (sapp->count < PHASE_CONF_MAX) {
+            phase = &sapp->phases[sapp->count++];
+        } else {
+            phase = &sapp->phases[0];
+            for (p = 1; p < PHASE_CONF_MAX; ++p) {
+                if (sapp->phases[p].last_use < phase->last_use) {
+                    phase = &sapp->phases[p];
+                }
+            }
+        }
+    }
+    memcpy(&phase->conf, conf, sizeof(phase_conf_t));
+    phase->last_use = uses;
+}
+
+state_t phase_store_get(char *user_id, phase_app_t *app, phase_conf_t *confs, uint *count)
+{
+    store_app_t *sapp;
+    uint p;
+
+    *count = 0;
+    if (!enabled) {
+        return_msg(EAR_ERROR, "the phase store is disabled");
+    }
+    if ((sapp = app_find(user_id, app)) == NULL) {
+        return EAR_SUCCESS;
+    }
+    sapp->last_use = ++uses;
+    for (p = 0; p < sapp->count; ++p) {
+        memcpy(&confs[p], &sapp->phases[p].conf, sizeof(phase_conf_t));
+    }
+    *count = sapp->count;
+    debug("%u phases of %s/%s sent", *count, user_id, app->app_id);
+    return EAR_SUCCESS;
+}
+
+state_t phase_store_put(char *user_id, phase_app_t *app, phase_conf_t *confs, uint count)
+{
+    store_app_t *sapp;
+    uint c;
+
+    if (!enabled) {
+        return_msg(EAR_ERROR, "the phase store is disabled");
+    }
+    if (count == 0) {
+        return EAR_SUCCESS;
+    }
+    if ((sapp = app_find(user_id, app)) == NULL) {
+        sapp = app_new(user_id, app);
+    }
+    sapp->last_use = ++uses;
+    for (c = 0; c < count; ++c) {
+        phase_merge(sapp, &confs[c]);
+    }
+    verbose(VJOBPMON, "Phase store: %u phases of %s/%s kept", sapp->count, user_id, app->app_id);
+    return store_save();
+}
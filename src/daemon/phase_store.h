@@ -0,0 +1,38 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _EARD_PHASE_STORE_H
+#define _EARD_PHASE_STORE_H
+
+#include <common/states.h>
+#include <common/types/phase.h>
+
+/* Node store of the frequencies EARL selected for the phases of the recent
+ * applications. An application is identified by its user, its name and the
+ * policy settings it ran with. When a job ends, EARL sends the phases of its
+ * phase cache, and when the same application starts again it gets them back,
+ * so the policy does not have to search the frequencies of the phases it has
+ * already seen in this node. The store is kept in a file of the EAR temporal
+ * folder, readable only by EARD, so it survives EARD restarts. A file of other
+ * user, writable by others or corrupted is discarded. The least recently used
+ * application is replaced when the store is full. It is built with
+ * EARD_PHASE_STORE (config_def.h), 0 by default. */
+
+/** Loads the store saved in the folder path_tmp, if any. */
+state_t phase_store_init(char *path_tmp);
+
+/** Copies the phases kept for the application, up to PHASE_CONF_MAX. */
+state_t phase_store_get(char *user_id, phase_app_t *app, phase_conf_t *confs, uint *count);
+
+/** Updates the phases of the application and saves the store. The phases
+ * not valid are forgotten. */
+state_t phase_store_put(char *user_id, phase_app_t *app, phase_conf_t *confs, uint count);
+
+#endif
@@ -45,6 +45,7 @@
 #include <common/types/generic.h>
 #include <common/types/periodic_metric.h>
 #include <common/utils/sched_support.h>
+#include <daemon/coeffs_refine.h>
 #include <daemon/eard_checkpoint.h>
 #include <daemon/eard_node_services.h>
 #include <daemon/local_api/node_mgr.h>
@@ -737,7 +738,8 @@ static int new_context(job_id id, job_id sid, char *user, char *group, int *cc)
     get_pc_app_info_path(ear_tmp, ID, shmem_path);
 
     current_ear_app[ccontext]->pc_app_info =
-        create_pc_app_info_shared_area(shmem_path, &current_ear_app[ccontext]->fd_shared_areas[PC_APP_AREA], user);
+        create_pc_app_info_shared_area(shmem_path, node_desc.cpu_count,
+                                       &current_ear_app[ccontext]->fd_shared_areas[PC_APP_AREA], user);
     if (current_ear_app[ccontext]->pc_app_info == NULL) {
         error("Error creating shared memory between EARD & EARL for pc_app_info (%lu,%lu)", id, sid);
         ear_unlock(&powermon_app_mutex[ccontext]);
@@ -1055,7 +1057,8 @@ state_t powermon_create_idle_context()
     get_pc_app_info_path(ear_tmp, ID, shmem_path);
     verbose(VJOBPMON, "App PC area for new context placed at %s", shmem_path);
     pmapp->pc_app_info =
-        create_pc_app_info_shared_area(shmem_path, &pmapp->fd_shared_areas[PC_APP_AREA], my_cluster_conf.ear_owner);
+        create_pc_app_info_shared_area(shmem_path, node_desc.cpu_count, &pmapp->fd_shared_areas[PC_APP_AREA],
+                                       my_cluster_conf.ear_owner);
     if (pmapp->pc_app_info == NULL) {
         verbose(VJOBPMON, "Error creating app pc shared region");
     }
@@ -1088,7 +1091,7 @@ void copy_powermon_app(powermon_app_t *dest, powermon_app_t *src)
     memcpy(dest->settings, src->settings, sizeof(settings_conf_t)); // new
     dest->resched->force_rescheduling = src->resched->force_rescheduling;
     memcpy(dest->app_info, src->app_info, sizeof(app_mgt_t));
-    memcpy(dest->pc_app_info, src->pc_app_info, sizeof(pc_app_info_t));
+    memcpy(dest->pc_app_info, src->pc_app_info, pcapp_info_size(src->pc_app_info->num_cpus));
     cpufreq_data_copy(dest->freq_job1, src->freq_job1);
 }
 
@@ -1490,6 +1493,17 @@ void powermon_loop_signature(job_id jid, job_id sid, loop_t *loops)
     return;
 }
 
+state_t powermon_job_user(job_id jid, job_id sid, char *user_id, size_t size)
+{
+    int cc;
+
+    if ((cc = find_context_for_job(jid, sid)) < 0) {
+        return_msg(EAR_ERROR, Generr.not_found);
+    }
+    snprintf(user_id, size, "%s", current_ear_app[cc]->app.job.user_id);
+    return EAR_SUCCESS;
+}
+
 // That functions controls the mpi init/end of jobs. These functions are called by eard when application executes
 // mpi_init/mpi_finalized and contacts eard
 // TODO: Thread-save here.
@@ -1843,7 +1857,7 @@ void powermon_new_job(powermon_app_t *pmapp, ehandler_t *eh, application_t *appI
     /* Requested frequencies must be done per JOB: PENDING to apply the affinity mask */
     pcapp_info_new_job(pmapp->pc_app_info);
 
-    for (int i = 0; i < MAX_CPUS_SUPPORTED; i++)
+    for (int i = 0; i < pmapp->pc_app_info->num_cpus; i++)
         pmapp->pc_app_info->req_f[i] = pmapp->settings->def_freq;
 
 #if USE_GPUS
@@ -2507,6 +2521,10 @@ void powermon_mpi_signature(application_t *app)
 
     pmapp->sig_reported = 1;
 
+#if EARD_COEFFS_REFINE
+    coeffs_refine_signature(app);
+#endif
+
     verbose(VJOBPMON, "MPI signature reported for context %d (%lu/%lu), avg. freq (kHz) = %lu", cc, app->job.id,
             app->job.step_id, pmapp->app.signature.avg_f);
 
@@ -99,6 +99,9 @@ void powermon_mpi_signature(application_t *application);
 /** New loop signature for jid-sid. */
 void powermon_loop_signature(job_id jid, job_id sid, loop_t *loops);
 
+/** Copies the user of the job jid-sid. */
+state_t powermon_job_user(job_id jid, job_id sid, char *user_id, size_t size);
+
 /** Creates the idle context. */
 state_t powermon_create_idle_context();
 
@@ -48,7 +48,8 @@ static int32_t node_size      = 0;
 static uint32_t energy_packs  = 0;
 static uint32_t *cpu_power    = NULL;
 static uint32_t *dram_power   = NULL;
-static uint64_t *c_req_f      = NULL;
+static ulong *c_req_f         = NULL; // Requested frequencies, one per CPU of the node
+static uint *c_tmp_pstates    = NULL; // P_STATEs being reduced, one per CPU of the node
 static uint64_t *energy_ct1   = NULL;
 static uint64_t *energy_ct2   = NULL;
 static uint64_t *energy_diff  = NULL;
@@ -88,8 +89,12 @@ state_t enable(suscription_t *sus)
     mgt_cpufreq_data_alloc(&av_pstates, NULL);
     mgt_cpufreq_data_alloc(&curr_pstates, NULL);
     mgt_cpufreq_get_available_list(NULL, (const pstate_t **) &av_pstates, &num_pstates);
-    c_req_f   = calloc(MAX_CPUS_SUPPORTED, sizeof(uint64_t));
     node_size = node_desc.cpu_count;
+    c_req_f       = calloc(node_size, sizeof(ulong));
+    c_tmp_pstates = calloc(node_size, sizeof(uint));
+    if (c_req_f == NULL || c_tmp_pstates == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
 
     /* energy_cpu init */
     energy_cpu_data_alloc(NULL, (ullong **) &energy_ct1, &energy_packs);
@@ -238,13 +243,13 @@ void set_pc_mode(uint mode)
 void set_app_req_freq(ulong *f)
 {
     debug("DVFS:Requested application freq[0] set to %lu", f[0]);
-    memcpy(c_req_f, f, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memcpy(c_req_f, f, sizeof(ulong) * node_size);
 }
 
 /* Returns true if some pstate in p1 is higher than p2 */
-static int _cmp_curr_pstate_with_target_freq(pstate_t *curr_pstate, uint64_t *target)
+static int _cmp_curr_pstate_with_target_freq(pstate_t *curr_pstate, ulong *target)
 {
-    for (int32_t i = 0; i < MAX_CPUS_SUPPORTED && i < num_cpus; i++) {
+    for (int32_t i = 0; i < node_size && i < num_cpus; i++) {
         uint32_t t_pstate = 0;
         mgt_cpufreq_get_index(NULL, target[i], &t_pstate, true);
         if (t_pstate > curr_pstate[i].idx)
@@ -253,9 +258,9 @@ static int _cmp_curr_pstate_with_target_freq(pstate_t *curr_pstate, uint64_t *ta
     return 0;
 }
 
-bool _pstates_are_equal(pstate_t *p1, uint64_t *p2)
+bool _pstates_are_equal(pstate_t *p1, ulong *p2)
 {
-    for (int32_t i = 0; i < MAX_CPUS_SUPPORTED; i++) {
+    for (int32_t i = 0; i < node_size; i++) {
         if (p1[i].idx != p2[i])
             return false;
     }
@@ -264,7 +269,7 @@ bool _pstates_are_equal(pstate_t *p1, uint64_t *p2)
 }
 
 /* Computes how many cpus can reduce one pstate with the given limit */
-void num_cpus_to_reduce_pstates(uint *tmp, uint64_t *target, uint *changes, uint *changes_max)
+void num_cpus_to_reduce_pstates(uint *tmp, ulong *target, uint *changes, uint *changes_max)
 {
     int i, logical_pstates;
     *changes     = 0;
@@ -293,10 +298,10 @@ void num_cpus_to_reduce_pstates(uint *tmp, uint64_t *target, uint *changes, uint
 }
 
 /* Reduce 1 pstate in f, whith a limit */
-static void reduce_one_pstate(uint *f, uint64_t *limit)
+static void reduce_one_pstate(uint *f, ulong *limit)
 {
     int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
+    for (i = 0; i < node_size; i++) {
         if (f[i] > limit[i])
             f[i]--;
     }
@@ -306,17 +311,20 @@ static void reduce_one_pstate(uint *f, uint64_t *limit)
 #define PSTATE0_STEP 30
 
 // moved here from powercap_status.c as it is only used in dvfs cases
-static uint32_t _compute_extra_power(uint current_power, uint max_steps, pstate_t *current, uint64_t *target)
+static uint32_t _compute_extra_power(uint current_power, uint max_steps, pstate_t *current, ulong *target)
 {
     uint total = 0, changes, changes_max;
-    uint tmp[MAX_CPUS_SUPPORTED];
+    uint *tmp  = c_tmp_pstates;
+    int i;
     // no pstate_change
     if (_pstates_are_equal(current, target))
         return 0;
     // vector_print_pstates(current, node_size);
     // vector_print_pstates(target, node_size);
 
-    memcpy(tmp, current, sizeof(uint) * MAX_CPUS_SUPPORTED);
+    for (i = 0; i < node_size; i++) {
+        tmp[i] = current[i].idx;
+    }
     do {
         num_cpus_to_reduce_pstates(tmp, target, &changes, &changes_max);
         if (changes || changes_max) {
@@ -355,7 +363,7 @@ uint get_powercap_status(domain_status_t *status)
     status->requested  = 0;
     status->current_pc = current_limit;
 
-    memset(c_req_f, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(c_req_f, 0, sizeof(ulong) * node_size);
     pmgt_get_app_req_freq(DOMAIN_CPU, c_req_f, node_size);
     mgt_cpufreq_get_current_list(NULL, curr_pstates);
 
@@ -391,7 +399,7 @@ uint get_powercap_status(domain_status_t *status)
     /* Running below target settings, requesting more power */
     if (_cmp_curr_pstate_with_target_freq(curr_pstates, c_req_f)) {
         status->ok        = PC_STATUS_GREEDY;
-        status->requested = _compute_extra_power(power, num_pstates, av_pstates, c_req_f);
+        status->requested = _compute_extra_power(power, num_pstates, curr_pstates, c_req_f);
         return 0;
     }
 
@@ -70,6 +70,8 @@ static uint *prev_pstate;
 static int32_t prev_counter;
 static ulong *c_freq;
 static uint *c_pstate, *t_pstate;
+static uint *tmp_pstate, *e_pstate;     /* Scratch lists of the main loop and compute_extra_power */
+static uint *c_pstate_pc, *t_pstate_pc; /* Scratch lists of get_powercap_status */
 static uint node_size;
 static uint dvfs_status              = PC_STATUS_OK;
 static uint dvfs_ask_def             = 0;
@@ -101,53 +103,55 @@ static void frequency_npstate_to_nfreq(uint *p, ulong *f, uint cpus)
         f[i] = frequency_pstate_to_freq(p[i]);
 }
 
+/* The P_STATE vectors are node_size long. The loops are branchless and
+ * without early exits, so the compiler can vectorize them (see Makefile). */
+
 /* Increases one pstate in f */
-static void increase_one_pstate(uint *f)
+static void increase_one_pstate(uint *restrict f)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        f[i] = ear_min(f[i] + 1, num_pstates - 1);
+    uint last = num_pstates - 1;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        f[i] = (f[i] < last) ? f[i] + 1 : last;
     }
 }
 
 /* Reduce 1 pstate in f, which a limit */
-static void reduce_one_pstate(uint *f, uint *limit)
+static void reduce_one_pstate(uint *restrict f, const uint *restrict limit)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        if (f[i] > limit[i])
-            f[i]--;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        f[i] -= (f[i] > limit[i]);
     }
 }
 
 /* Returns true if some pstate in p1 is higher than p2 */
-static int higher_pstate(uint *p1, uint *p2)
+static int higher_pstate(const uint *restrict p1, const uint *restrict p2)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        if (p1[i] > p2[i])
-            return 1;
+    uint higher = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        higher |= (p1[i] > p2[i]);
     }
-    return 0;
+    return (higher != 0);
 }
 
 int pstate_are_equal(uint *p1, uint *p2)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        if (p1[i] != p2[i])
-            return 0;
+    uint differ = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        differ |= (p1[i] ^ p2[i]);
     }
-    return 1;
+    return (differ == 0);
 }
 
 /* P2 is the target, p1 can not be less than p2. Lower pstates means higher frequency */
-static void limit_pstate(uint *p1, uint *p2)
+static void limit_pstate(uint *restrict p1, const uint *restrict p2)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        if (p1[i] < p2[i])
-            p1[i] = p2[i];
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        p1[i] = (p1[i] < p2[i]) ? p2[i] : p1[i];
     }
 }
 
@@ -184,14 +188,14 @@ void num_cpus_to_reduce_pstates(uint *tmp, uint *target, uint *changes, uint *ch
 uint compute_extra_power(uint current_power, uint max_steps, uint *current, uint *target)
 {
     uint total = 0, changes, changes_max;
-    uint tmp[MAX_CPUS_SUPPORTED];
+    uint *tmp = e_pstate;
     // no pstate_change
     if (pstate_are_equal(current, target))
         return 0;
     // vector_print_pstates(current, node_size);
     // vector_print_pstates(target, node_size);
 
-    memcpy(tmp, current, sizeof(uint) * MAX_CPUS_SUPPORTED);
+    memcpy(tmp, current, sizeof(uint) * node_size);
     do {
         num_cpus_to_reduce_pstates(tmp, target, &changes, &changes_max);
         if (changes || changes_max) {
@@ -210,12 +214,20 @@ uint compute_extra_power(uint current_power, uint max_steps, uint *current, uint
 
 int is_null_f(ulong *f)
 {
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
-        if (f[i])
-            return 0;
+    ulong any = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        any |= f[i];
+    }
+    return (any == 0);
+}
+
+static void reset_prev_pstate()
+{
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        prev_pstate[i] = UINT_MAX;
     }
-    return 1;
 }
 
 /************************ This function is called by the monitor before the iterative part ************************/
@@ -260,7 +272,7 @@ state_t dvfs_pc_thread_init(void *p)
 state_t dvfs_pc_thread_main(void *p)
 {
     // debug("entering dvfs_pc_thread_main, current_dvfs_pc %u and c_status %u", current_dvfs_pc, c_status);
-    uint extra, tmp_pstate[MAX_CPUS_SUPPORTED];
+    uint extra;
     timestamp_t curr_time;
     ulong elapsed;
     debug("--------------------------------------") debug("new_dvfs");
@@ -272,9 +284,9 @@ state_t dvfs_pc_thread_main(void *p)
     last_dvfs_time = curr_time;
 
     /* Update target frequency */
-    memset(c_pstate, 0, sizeof(uint) * MAX_CPUS_SUPPORTED);
-    memset(t_pstate, 0, sizeof(uint) * MAX_CPUS_SUPPORTED);
-    memset(c_req_f, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(c_pstate, 0, sizeof(uint) * node_size);
+    memset(t_pstate, 0, sizeof(uint) * node_size);
+    memset(c_req_f, 0, sizeof(ulong) * node_size);
     pmgt_get_app_req_freq(DOMAIN_CPU, c_req_f, node_size);
 
     if (current_dvfs_pc == POWER_CAP_UNLIMITED || current_dvfs_pc == 0) {
@@ -319,7 +331,7 @@ state_t dvfs_pc_thread_main(void *p)
             dvfs_ask_def = 1;
         }
         /* We save in a temp variable the curr pstate and we increase 1 pstate (lower freq) */
-        memcpy(tmp_pstate, c_pstate, sizeof(uint) * MAX_CPUS_SUPPORTED);
+        memcpy(tmp_pstate, c_pstate, sizeof(uint) * node_size);
         increase_one_pstate(tmp_pstate);
         if ((power_rapl - my_limit) >
             30) { /* If the current power is above by a lot, we reduce 2 pstates instead of 1 */
@@ -332,10 +344,10 @@ state_t dvfs_pc_thread_main(void *p)
             if (!pstate_are_equal(prev_pstate, c_pstate)) {
                 prev_counter = 0;
             }
-            memcpy(prev_pstate, c_pstate, sizeof(uint) * MAX_CPUS_SUPPORTED);
+            memcpy(prev_pstate, c_pstate, sizeof(uint) * node_size);
         }
         /* Finally we set */
-        memcpy(c_pstate, tmp_pstate, sizeof(uint) * MAX_CPUS_SUPPORTED);
+        memcpy(c_pstate, tmp_pstate, sizeof(uint) * node_size);
         // vector_print_pstates(c_pstate, node_size);
         frequency_npstate_to_nfreq(c_pstate, c_freq, node_size);
         // print_frequencies(node_size, c_freq);
@@ -421,16 +433,27 @@ state_t enable(suscription_t *sus)
 
     debug("DVFS: found %lu pstates", num_pstates);
 
-    /* node_size or MAX_CPUS_SUPPORTED */
-    c_freq       = calloc(MAX_CPUS_SUPPORTED, sizeof(ulong));
-    c_req_f      = calloc(MAX_CPUS_SUPPORTED, sizeof(ulong));
-    c_pstate     = calloc(MAX_CPUS_SUPPORTED, sizeof(uint));
-    t_pstate     = calloc(MAX_CPUS_SUPPORTED, sizeof(uint));
-    prev_pstate  = calloc(MAX_CPUS_SUPPORTED, sizeof(uint));
+    /* All the lists are sized by the CPUs of the node */
+    if (node_size == 0) {
+        error("DVFS: the number of CPUs cannot be detected");
+        return EAR_ERROR;
+    }
+    c_freq         = calloc(node_size, sizeof(ulong));
+    c_req_f        = calloc(node_size, sizeof(ulong));
+    c_pstate       = calloc(node_size, sizeof(uint));
+    t_pstate       = calloc(node_size, sizeof(uint));
+    prev_pstate    = calloc(node_size, sizeof(uint));
+    tmp_pstate     = calloc(node_size, sizeof(uint));
+    e_pstate       = calloc(node_size, sizeof(uint));
+    c_pstate_pc    = calloc(node_size, sizeof(uint));
+    t_pstate_pc    = calloc(node_size, sizeof(uint));
+    if (!c_freq || !c_req_f || !c_pstate || !t_pstate || !prev_pstate || !tmp_pstate || !e_pstate || !c_pstate_pc ||
+        !t_pstate_pc) {
+        error("DVFS: cannot allocate the P_STATE lists for %u CPUs", node_size);
+        return EAR_ERROR;
+    }
     prev_counter = 0;
-    int i;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
-        prev_pstate[i] = UINT_MAX;
+    reset_prev_pstate();
 
 #if SHOW_DEBUGS
     ulong *freqlist = frequency_get_freq_rank_list();
@@ -461,7 +484,7 @@ void restore_frequency()
 {
     int i;
     /* Get target frequency */
-    memset(c_req_f, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(c_req_f, 0, sizeof(ulong) * node_size);
     pmgt_get_app_req_freq(DOMAIN_CPU, c_req_f, node_size);
     // frequency_get_cpufreq_list(node_size,c_freq); //necessary??
     for (i = 0; i < node_size; i++) {
@@ -475,7 +498,6 @@ void restore_frequency()
 
 state_t set_powercap_value(uint pid, uint domain, uint *limit, uint *cpu_util)
 {
-    int i;
     /* Set data */
     debug("%sDVFS:set_powercap_value %u%s", COL_BLU, *limit, COL_CLR);
     if (domain == LEVEL_DEVICE) {
@@ -491,8 +513,7 @@ state_t set_powercap_value(uint pid, uint domain, uint *limit, uint *cpu_util)
     current_dvfs_pc = default_dvfs_pc;
     dvfs_status     = PC_STATUS_OK;
     dvfs_ask_def    = 0;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
-        prev_pstate[i] = UINT_MAX; // reset flipflop measures
+    reset_prev_pstate(); // reset flipflop measures
     prev_counter = 0;
     if (current_dvfs_pc == POWER_CAP_UNLIMITED) {
         restore_frequency();
@@ -502,41 +523,35 @@ state_t set_powercap_value(uint pid, uint domain, uint *limit, uint *cpu_util)
 
 state_t reset_powercap_value()
 {
-    int i;
     debug("Reset powercap value, changing from %u to %u", current_dvfs_pc, default_dvfs_pc);
     current_dvfs_pc = default_dvfs_pc;
     dvfs_status     = PC_STATUS_OK;
     dvfs_ask_def    = 0;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
-        prev_pstate[i] = UINT_MAX; // reset flipflop measures
+    reset_prev_pstate(); // reset flipflop measures
     prev_counter = 0;
     return EAR_SUCCESS;
 }
 
 state_t increase_powercap_allocation(uint increase)
 {
-    int i;
     debug("Increasing powercap allocation by %u", increase);
     current_dvfs_pc += increase;
     dvfs_ask_def = 0;
     if (current_dvfs_pc >= default_dvfs_pc) {
         dvfs_status = PC_STATUS_OK;
     }
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
-        prev_pstate[i] = UINT_MAX; // reset flipflop measures
+    reset_prev_pstate(); // reset flipflop measures
     prev_counter = 0;
     return EAR_SUCCESS;
 }
 
 state_t release_powercap_allocation(uint decrease)
 {
-    int i;
     debug("Decreasing powercap allocation by %u", decrease);
     current_dvfs_pc -= decrease;
     if (current_dvfs_pc < default_dvfs_pc)
         dvfs_status = PC_STATUS_RELEASE;
-    for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
-        prev_pstate[i] = UINT_MAX; // reset flipflop measures
+    reset_prev_pstate(); // reset flipflop measures
     prev_counter = 0;
     return EAR_SUCCESS;
 }
@@ -585,7 +600,7 @@ void set_pc_mode(uint mode)
 void set_app_req_freq(ulong *f)
 {
     debug("DVFS:Requested application freq[0] set to %lu", f[0]);
-    memcpy(c_req_f, f, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memcpy(c_req_f, f, sizeof(ulong) * node_size);
 }
 
 void set_verb_channel(int fd)
@@ -609,9 +624,6 @@ void set_verb_channel(int fd)
 uint get_powercap_status(domain_status_t *status)
 {
     uint ctbr;
-    uint t_pstate_pc[MAX_CPUS_SUPPORTED], c_pstate_pc[MAX_CPUS_SUPPORTED];
-    memset(c_pstate_pc, 0, MAX_CPUS_SUPPORTED * sizeof(uint));
-    memset(t_pstate_pc, 0, MAX_CPUS_SUPPORTED * sizeof(uint));
     status->ok         = PC_STATUS_OK;
     status->exceed     = 0;
     status->stress     = 0;
@@ -621,6 +633,8 @@ uint get_powercap_status(domain_status_t *status)
     // debug("DVFS: get_powercap_status");
     if (!dvfs_monitor_initialized)
         return 0;
+    memset(c_pstate_pc, 0, node_size * sizeof(uint));
+    memset(t_pstate_pc, 0, node_size * sizeof(uint));
     /* Return 0 means we cannot release power */
     if (current_dvfs_pc == POWER_CAP_UNLIMITED)
         return 0;
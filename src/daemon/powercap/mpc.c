@@ -0,0 +1,462 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#define _GNU_SOURCE
+// #define SHOW_DEBUGS 1
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <common/colors.h>
+#include <common/config.h>
+#include <common/hardware/hardware_info.h>
+#include <common/output/verbose.h>
+#include <common/states.h>
+#include <common/system/monitor.h>
+
+#include <management/cpufreq/frequency.h>
+
+#include <metrics/energy/cpu.h>
+#include <metrics/energy_cpu/energy_cpu.h>
+
+#include <daemon/powercap/mpc_control.h>
+#include <daemon/powercap/powercap_mgt.h>
+#include <daemon/powercap/powercap_status.h>
+#include <daemon/powercap/powercap_status_conf.h>
+
+/* CPU powercap plugin with the same interface than dvfs. Instead of walking
+ * one P_STATE per period, the frequency that meets the limit is predicted from
+ * the node power/frequency slope (see mpc_control.h). */
+
+#define MPC_PERIOD         0.5
+#define MPC_BURST_DURATION 1000
+#define MPC_RELAX_DURATION 1000
+
+#define PSTATE_STEP 8 // W per 100 MHz, the prior of the slope (same than dvfs)
+
+#define MIN_CPU_POWER_MARGIN 10
+
+static uint current_mpc_pc = 0;
+static uint default_mpc_pc = 0;
+static uint mpc_pc_enabled = 0;
+static topology_t node_desc;
+
+static uint c_status = PC_STATUS_IDLE;
+static uint c_mode   = PC_MODE_LIMIT;
+static ulong num_pstates;
+static ulong *pstate_freqs;
+static suscription_t *sus_mpc;
+static mpc_ctl_t ctl;
+
+static uint num_packs;
+static unsigned long long *values_rapl_init, *values_rapl_end, *values_diff;
+static float power_rapl, my_limit;
+static ulong *c_req_f, *c_freq;
+static uint *c_pstate, *t_pstate;
+static uint node_size;
+static uint mpc_status              = PC_STATUS_OK;
+static uint mpc_ask_def             = 0;
+static uint mpc_monitor_initialized = 0;
+static timestamp_t last_mpc_time;
+
+static domain_settings_t settings = {.node_ratio = 0.1, .security_range = 0.05};
+
+extern ulong pmgt_idle_def_freq;
+
+static void frequency_nfreq_to_npstate(ulong *f, uint *p, uint cpus)
+{
+    uint i;
+    for (i = 0; i < cpus; i++) {
+        // 0 is the conservative value towards user performance
+        p[i] = (f[i]) ? frequency_freq_to_pstate(f[i]) : 0;
+    }
+}
+
+static void frequency_npstate_to_nfreq(uint *p, ulong *f, uint cpus)
+{
+    uint i;
+    for (i = 0; i < cpus; i++) {
+        f[i] = pstate_freqs[p[i]];
+    }
+}
+
+static ulong average_freq(ulong *f)
+{
+    ulong total = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        total += f[i];
+    }
+    return total / node_size;
+}
+
+/* Average frequency of the requested P_STATEs */
+static ulong average_pstate_freq(uint *p)
+{
+    ulong total = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        total += pstate_freqs[p[i]];
+    }
+    return total / node_size;
+}
+
+static int is_null_f(ulong *f)
+{
+    ulong any = 0;
+    uint i;
+    for (i = 0; i < node_size; i++) {
+        any |= f[i];
+    }
+    return (any == 0);
+}
+
+/* Power needed to go from the current frequencies to the requested ones */
+static uint compute_extra_power(ulong *current, uint *target)
+{
+    long diff = (long) average_pstate_freq(target) - (long) average_freq(current);
+    if (diff <= 0) {
+        return 0;
+    }
+    return (uint) (ctl.slope * (double) diff * 1e-6);
+}
+
+state_t mpc_pc_thread_init(void *p)
+{
+    debug("MPC_monitor_init");
+
+    num_packs = node_desc.socket_count;
+    if (num_packs == 0) {
+        error("Num packages cannot be detected in mpc_pc thread initialization");
+        pthread_exit(NULL);
+    }
+    if (energy_cpu_init(NULL)) {
+        error("cannot initialize energy_cpu layer in mpc_pc thread initialization");
+        pthread_exit(NULL);
+    }
+    energy_cpu_data_alloc(NULL, &values_rapl_init, &num_packs);
+    energy_cpu_data_alloc(NULL, &values_rapl_end, &num_packs);
+    energy_cpu_data_alloc(NULL, &values_diff, &num_packs);
+    if ((values_rapl_init == NULL) || (values_rapl_end == NULL) || (values_diff == NULL)) {
+        error("values_rapl returns NULL in mpc_pc thread initialization");
+        pthread_exit(NULL);
+    }
+
+    verbose(VEARD_PC, "Setting governor to userspace for MPC powercap control");
+    state_t ret_st = frequency_set_userspace_governor_all_cpus();
+    check_usrspace_gov_set(ret_st, VEARD_PC);
+
+    energy_cpu_read(NULL, values_rapl_init);
+    timestamp_get(&last_mpc_time);
+    mpc_monitor_initialized = 1;
+    return EAR_SUCCESS;
+}
+
+state_t mpc_pc_thread_main(void *p)
+{
+    timestamp_t curr_time;
+    ulong elapsed, f_cur, f_req, f_target;
+    int32_t i;
+
+    timestamp_get(&curr_time);
+    elapsed       = timestamp_diff(&curr_time, &last_mpc_time, TIME_MSECS);
+    last_mpc_time = curr_time;
+
+    memset(c_req_f, 0, sizeof(ulong) * node_size);
+    pmgt_get_app_req_freq(DOMAIN_CPU, c_req_f, node_size);
+
+    if (current_mpc_pc == POWER_CAP_UNLIMITED || current_mpc_pc == 0) {
+        debug("powercap unlimited or disabled");
+        return EAR_SUCCESS;
+    }
+
+    energy_cpu_read(NULL, values_rapl_end);
+    energy_cpu_data_diff(NULL, values_rapl_init, values_rapl_end, values_diff);
+    energy_cpu_data_copy(NULL, values_rapl_init, values_rapl_end);
+
+    power_rapl = 0;
+    for (i = 0; i < node_desc.socket_count; i++) {
+        // DRAM and CPU power
+        power_rapl += energy_cpu_compute_power(values_diff[i], elapsed / 1000.0);
+        power_rapl += energy_cpu_compute_power(values_diff[node_desc.socket_count + i], elapsed / 1000.0);
+    }
+    my_limit = (float) current_mpc_pc;
+    debug("Current power %f current limit %f (%u cpus)", power_rapl, my_limit, node_size);
+
+    if (power_rapl < 0.5)
+        return EAR_SUCCESS;
+
+    frequency_get_cpufreq_list(node_size, c_freq);
+    frequency_nfreq_to_npstate(c_req_f, t_pstate, node_size);
+    f_cur = average_freq(c_freq);
+    f_req = average_pstate_freq(t_pstate);
+    mpc_ctl_observe(&ctl, f_cur, power_rapl);
+
+    if (power_rapl > my_limit) {
+        if (current_mpc_pc < default_mpc_pc) {
+            mpc_ask_def = 1;
+        }
+    } else if (c_mode != PC_MODE_TARGET && f_cur <= f_req) {
+        /* Under the limit the frequency is only raised in target mode */
+        return EAR_SUCCESS;
+    }
+
+    f_target = mpc_ctl_target(&ctl, f_cur, power_rapl, my_limit, f_req);
+    mpc_ctl_pstates(&ctl, f_target, t_pstate, c_pstate, node_size);
+    frequency_npstate_to_nfreq(c_pstate, c_freq, node_size);
+    frequency_set_with_list(node_size, c_freq);
+
+    verbose(VEARD_PC + 1, "%spower %.2f limit %.2f, average freq %lu -> %lu (slope %.1lf W/GHz)%s",
+            (power_rapl > my_limit) ? COL_RED : COL_GRE, power_rapl, my_limit, f_cur, f_target, ctl.slope, COL_CLR);
+    return EAR_SUCCESS;
+}
+
+state_t disable()
+{
+    return EAR_SUCCESS;
+}
+
+state_t enable(suscription_t *sus)
+{
+    uint i;
+
+    if (sus == NULL) {
+        debug("NULL subscription in MPC powercap");
+        return EAR_ERROR;
+    }
+    sus->call_main  = mpc_pc_thread_main;
+    sus->call_init  = mpc_pc_thread_init;
+    sus->time_relax = MPC_RELAX_DURATION * MPC_PERIOD;
+    sus->time_burst = MPC_BURST_DURATION * MPC_PERIOD;
+    sus_mpc         = sus;
+
+    if (state_fail(topology_init(&node_desc))) {
+        debug("Error getting node topology");
+    }
+    node_size = node_desc.cpu_count;
+    if (node_size == 0) {
+        error("MPC: the number of CPUs cannot be detected");
+        return EAR_ERROR;
+    }
+    if (energy_cpu_load(&node_desc, 0)) {
+        error("energy_cpu cannot be loaded");
+        return EAR_ERROR;
+    }
+
+    frequency_init(0);
+    state_t ret_st = frequency_set_userspace_governor_all_cpus();
+    check_usrspace_gov_set(ret_st, VEARD_PC);
+    num_pstates = frequency_get_num_pstates();
+    debug("MPC: found %lu pstates for %u cpus", num_pstates, node_size);
+
+    pstate_freqs = calloc(num_pstates, sizeof(ulong));
+    c_freq       = calloc(node_size, sizeof(ulong));
+    c_req_f      = calloc(node_size, sizeof(ulong));
+    c_pstate     = calloc(node_size, sizeof(uint));
+    t_pstate     = calloc(node_size, sizeof(uint));
+    if (num_pstates == 0 || !pstate_freqs || !c_freq || !c_req_f || !c_pstate || !t_pstate) {
+        error("MPC: cannot allocate the P_STATE lists for %u CPUs", node_size);
+        return EAR_ERROR;
+    }
+    for (i = 0; i < num_pstates; i++) {
+        pstate_freqs[i] = frequency_pstate_to_freq(i);
+    }
+    mpc_ctl_init(&ctl, pstate_freqs, num_pstates, PSTATE_STEP);
+
+    sus->suscribe(sus);
+    return EAR_SUCCESS;
+}
+
+state_t plugin_set_burst()
+{
+    return monitor_burst(sus_mpc, 0);
+}
+
+state_t plugin_set_relax()
+{
+    return monitor_relax(sus_mpc);
+}
+
+void plugin_get_settings(domain_settings_t *s)
+{
+    memcpy(s, &settings, sizeof(domain_settings_t));
+}
+
+static void restore_frequency()
+{
+    uint i;
+    memset(c_req_f, 0, sizeof(ulong) * node_size);
+    pmgt_get_app_req_freq(DOMAIN_CPU, c_req_f, node_size);
+    for (i = 0; i < node_size; i++) {
+        if (c_req_f[i] == 0)
+            c_req_f[i] = pmgt_idle_def_freq;
+    }
+    verbose_frequencies(node_size, c_req_f);
+    frequency_set_with_list(node_size, c_req_f);
+}
+
+state_t set_powercap_value(uint pid, uint domain, uint *limit, uint *cpu_util)
+{
+    uint32_t new_limit = 0;
+    int32_t i;
+
+    debug("%sMPC:set_powercap_value %u%s", COL_BLU, *limit, COL_CLR);
+    if (domain == LEVEL_DEVICE) {
+        for (i = 0; i < node_size; i++) {
+            new_limit += limit[i];
+        }
+        warning("Per device powercap not implemented for MPC, adding up the values (new limit %u)", new_limit);
+        default_mpc_pc = new_limit;
+    } else {
+        default_mpc_pc = *limit;
+    }
+    current_mpc_pc = default_mpc_pc;
+    mpc_status     = PC_STATUS_OK;
+    mpc_ask_def    = 0;
+    mpc_ctl_reset(&ctl);
+    if (current_mpc_pc == POWER_CAP_UNLIMITED) {
+        restore_frequency();
+    }
+    return EAR_SUCCESS;
+}
+
+state_t reset_powercap_value()
+{
+    debug("Reset powercap value, changing from %u to %u", current_mpc_pc, default_mpc_pc);
+    current_mpc_pc = default_mpc_pc;
+    mpc_status     = PC_STATUS_OK;
+    mpc_ask_def    = 0;
+    mpc_ctl_reset(&ctl);
+    return EAR_SUCCESS;
+}
+
+state_t increase_powercap_allocation(uint increase)
+{
+    debug("Increasing powercap allocation by %u", increase);
+    current_mpc_pc += increase;
+    mpc_ask_def = 0;
+    if (current_mpc_pc >= default_mpc_pc) {
+        mpc_status = PC_STATUS_OK;
+    }
+    mpc_ctl_reset(&ctl);
+    return EAR_SUCCESS;
+}
+
+state_t release_powercap_allocation(uint decrease)
+{
+    debug("Decreasing powercap allocation by %u", decrease);
+    current_mpc_pc -= decrease;
+    if (current_mpc_pc < default_mpc_pc)
+        mpc_status = PC_STATUS_RELEASE;
+    mpc_ctl_reset(&ctl);
+    return EAR_SUCCESS;
+}
+
+state_t get_powercap_value(uint pid, ulong *powercap)
+{
+    *powercap = current_mpc_pc;
+    return EAR_SUCCESS;
+}
+
+uint is_powercap_policy_enabled(uint pid)
+{
+    return mpc_pc_enabled;
+}
+
+void print_powercap_value(int fd)
+{
+    dprintf(fd, "mpc_powercap_value %u\n", current_mpc_pc);
+}
+
+void powercap_to_str(char *b)
+{
+    sprintf(b, "%u", current_mpc_pc);
+}
+
+void set_status(uint status)
+{
+    debug("MPC:set_status %u", status);
+    c_status = status;
+}
+
+uint get_powercap_strategy()
+{
+    // Same external behaviour than dvfs
+    return PC_DVFS;
+}
+
+void set_pc_mode(uint mode)
+{
+    debug("MPC:set_pc_mode");
+    c_mode = mode;
+}
+
+void set_app_req_freq(ulong *f)
+{
+    debug("MPC:Requested application freq[0] set to %lu", f[0]);
+    memcpy(c_req_f, f, sizeof(ulong) * node_size);
+}
+
+void set_verb_channel(int fd)
+{
+    WARN_SET_FD(fd);
+    VERB_SET_FD(fd);
+    DEBUG_SET_FD(fd);
+}
+
+/* Same protocol than dvfs get_powercap_status, but the requested power is
+ * predicted with the estimated slope. */
+uint get_powercap_status(domain_status_t *status)
+{
+    uint ctbr;
+    status->ok         = PC_STATUS_OK;
+    status->exceed     = 0;
+    status->stress     = 0;
+    status->requested  = 0;
+    status->current_pc = current_mpc_pc;
+
+    if (!mpc_monitor_initialized)
+        return 0;
+    if (current_mpc_pc == POWER_CAP_UNLIMITED)
+        return 0;
+    if (is_null_f(c_req_f)) {
+        if (c_status != PC_STATUS_IDLE)
+            debug("unknown req_f");
+        return 0;
+    }
+
+    frequency_get_cpufreq_list(node_size, c_freq);
+    status->stress = powercap_get_stress(pstate_freqs[0], pstate_freqs[num_pstates - 1], c_req_f[0], c_freq[0]);
+    frequency_nfreq_to_npstate(c_req_f, t_pstate, node_size);
+    if (average_freq(c_freq) < average_pstate_freq(t_pstate)) {
+        if (mpc_ask_def && current_mpc_pc < default_mpc_pc)
+            status->ok = PC_STATUS_ASK_DEF;
+        else {
+            status->requested = compute_extra_power(c_freq, t_pstate);
+            status->ok        = PC_STATUS_GREEDY;
+        }
+        debug("MPC status %u (requested %u)", status->ok, status->requested);
+        return 0;
+    }
+    ctbr           = (power_rapl < my_limit) ? (my_limit - power_rapl) * 0.5 : 0;
+    status->ok     = PC_STATUS_RELEASE;
+    status->exceed = ctbr;
+    if (ctbr < MIN_CPU_POWER_MARGIN) {
+        status->exceed = 0;
+        status->ok     = PC_STATUS_OK;
+        return 0;
+    }
+    mpc_status = status->ok;
+    debug("MPC status %u", status->ok);
+    return 1;
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <common/output/debug.h>
+#include <daemon/powercap/mpc_control.h>
+#include <math.h>
+
+#define KHZ_TO_GHZ     1e-6
+#define RLS_FORGET     0.9  // Forgetting factor of the slope estimation
+#define RLS_MIN_STEP   0.05 // GHz, smaller frequency changes are not observed
+#define SLOPE_RANGE    4.0  // The slope is kept between prior/4 and prior*4
+#define GAIN_DOWN      1.0  // Proportional gain when over the limit
+#define GAIN_UP        0.8  // Proportional gain when under the limit, slower to avoid overshoots
+#define GAIN_INTEGRAL  0.2
+#define INTEGRAL_BAND  20.0 // W, the integral only acts on errors smaller than this
+#define INTEGRAL_LIMIT 50.0 // W
+#define LIMIT_MARGIN   0.01 // The setpoint is 1% under the limit, to absorb the noise
+
+void mpc_ctl_init(mpc_ctl_t *c, const ulong *freqs, uint pstates, double watts_per_step)
+{
+    c->freqs       = freqs;
+    c->pstates     = pstates;
+    c->slope_prior = watts_per_step * 10.0; // 100 MHz steps to GHz
+    c->slope       = c->slope_prior;
+    c->covariance  = c->slope_prior * c->slope_prior;
+    mpc_ctl_reset(c);
+}
+
+void mpc_ctl_reset(mpc_ctl_t *c)
+{
+    c->integral = 0.0;
+    c->observed = 0;
+}
+
+void mpc_ctl_observe(mpc_ctl_t *c, ulong freq_khz, double power)
+{
+    double freq = (double) freq_khz * KHZ_TO_GHZ;
+    double df, dp, gain;
+
+    if (c->observed) {
+        df = freq - c->last_freq;
+        dp = power - c->last_power;
+        // Scalar RLS of dp = slope * df
+        if (fabs(df) >= RLS_MIN_STEP) {
+            gain = (c->covariance * df) / (RLS_FORGET + df * df * c->covariance);
+            c->slope += gain * (dp - c->slope * df);
+            c->covariance = (c->covariance - gain * df * c->covariance) / RLS_FORGET;
+            c->slope      = fmin(fmax(c->slope, c->slope_prior / SLOPE_RANGE), c->slope_prior * SLOPE_RANGE);
+            debug("slope %.2lf W/GHz (df %.3lf GHz, dp %.2lf W)", c->slope, df, dp);
+        }
+    }
+    c->last_freq  = freq;
+    c->last_power = power;
+    c->observed   = 1;
+}
+
+ulong mpc_ctl_target(mpc_ctl_t *c, ulong freq_khz, double power, double limit, ulong max_khz)
+{
+    double low  = (double) c->freqs[c->pstates - 1] * KHZ_TO_GHZ;
+    double high = (double) max_khz * KHZ_TO_GHZ;
+    double freq = (double) freq_khz * KHZ_TO_GHZ;
+    double err  = limit * (1.0 - LIMIT_MARGIN) - power;
+    double target;
+
+    // Anti-windup: the integral is cleared while saturated and it is not fed
+    // by big errors (i.e., phase changes), which are the model's job
+    if ((err > 0.0 && freq >= high) || (err < 0.0 && freq <= low)) {
+        c->integral = 0.0;
+    } else if (fabs(err) < INTEGRAL_BAND) {
+        c->integral = fmin(fmax(c->integral + err, -INTEGRAL_LIMIT), INTEGRAL_LIMIT);
+    }
+    target = freq + ((err > 0.0 ? GAIN_UP : GAIN_DOWN) * err + GAIN_INTEGRAL * c->integral) / c->slope;
+    target = fmin(fmax(target, low), high);
+    debug("power %.1lf limit %.1lf: %.3lf GHz -> %.3lf GHz (integral %.1lf W)", power, limit, freq, target,
+          c->integral);
+    return (ulong) (target / KHZ_TO_GHZ);
+}
+
+void mpc_ctl_pstates(mpc_ctl_t *c, ulong freq_khz, const uint *limit_ps, uint *ps, uint cpus)
+{
+    uint high, high_cpus, i;
+    double part;
+
+    // The P_STATE whose frequency is just over the target
+    for (high = c->pstates - 1; high > 0 && c->freqs[high] < freq_khz; --high)
+        ;
+    if (high == c->pstates - 1 || c->freqs[high] <= freq_khz) {
+        high_cpus = cpus;
+    } else {
+        // Part of the CPUs at high, the rest one P_STATE below
+        part      = (double) (freq_khz - c->freqs[high + 1]) / (double) (c->freqs[high] - c->freqs[high + 1]);
+        high_cpus = (uint) lround(part * (double) cpus);
+    }
+    for (i = 0; i < cpus; i++) {
+        ps[i] = (i < high_cpus) ? high : high + 1;
+        ps[i] = (ps[i] < limit_ps[i]) ? limit_ps[i] : ps[i];
+    }
+}
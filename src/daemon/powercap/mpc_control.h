@@ -0,0 +1,59 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef DAEMON_POWERCAP_MPC_CONTROL_H
+#define DAEMON_POWERCAP_MPC_CONTROL_H
+
+#include <common/types/generic.h>
+
+/* Model-predictive CPU frequency control for a node power limit.
+ *
+ * The node power is modelled around the current point as a linear function of
+ * the average CPU frequency. Its slope (W/GHz) is estimated online by recursive
+ * least squares from the changes of power and frequency between periods,
+ * starting from a prior. Every period the frequency that meets the limit is
+ * computed in one step from that slope, plus a PI correction of the error left
+ * by the model. The average frequency is converted in a list of P_STATEs by
+ * mixing two consecutive P_STATEs between the CPUs.
+ *
+ * It has no EARD dependencies, so it can be replayed offline (tests/). */
+
+typedef struct mpc_ctl_s {
+    const ulong *freqs; // KHz per P_STATE, 0 is the highest
+    uint pstates;
+    double slope;       // W/GHz estimated
+    double slope_prior;
+    double covariance;  // Of the slope estimation
+    double integral;    // W, integral of the error
+    double last_freq;   // GHz of the previous observation
+    double last_power;
+    uint observed;
+} mpc_ctl_t;
+
+/** Initializes the controller with the P_STATE list and the power that costs
+ * each 100 MHz of average frequency in the node (the prior of the slope). */
+void mpc_ctl_init(mpc_ctl_t *c, const ulong *freqs, uint pstates, double watts_per_step);
+
+/** Forgets the error integral and the previous observation, the slope is kept.
+ * Used when the limit changes. */
+void mpc_ctl_reset(mpc_ctl_t *c);
+
+/** Feeds the average frequency (KHz) and the power of the last period. */
+void mpc_ctl_observe(mpc_ctl_t *c, ulong freq_khz, double power);
+
+/** Returns the average frequency (KHz) that meets the power limit, between
+ * the lowest P_STATE and max_khz. */
+ulong mpc_ctl_target(mpc_ctl_t *c, ulong freq_khz, double power, double limit, ulong max_khz);
+
+/** Fills a P_STATE per CPU whose average frequency is freq_khz. No CPU goes
+ * over its limit_ps (lower P_STATE means higher frequency). */
+void mpc_ctl_pstates(mpc_ctl_t *c, ulong freq_khz, const uint *limit_ps, uint *ps, uint cpus);
+
+#endif // DAEMON_POWERCAP_MPC_CONTROL_H
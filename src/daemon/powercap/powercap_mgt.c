@@ -185,6 +185,7 @@ static uint util_period     = 0;
 static uint gpu_pc_num_gpus = 1;
 #endif
 static topology_t pc_topology_info;
+static ulong *pc_req_f; /* Requested CPU frequencies, one per CPU of the node */
 /* These functions identies and monitors load changes */
 
 static uint pck_tdps[MAX_PACKAGES];
@@ -447,6 +448,10 @@ state_t pmgt_init()
     policy_conf_t *my_policy;
     char basic_path[SZ_PATH];
     topology_init(&pc_topology_info);
+    if ((pc_req_f = calloc(pc_topology_info.cpu_count, sizeof(ulong))) == NULL) {
+        error("Allocating the requested CPU frequencies");
+        return EAR_ERROR;
+    }
 #if USE_GPUS
     gpu_load(NO_EARD);
     gpu_get_api(&gpu_pc_model);
@@ -901,8 +906,9 @@ void pmgt_get_app_req_freq(uint domain, ulong *f, uint dom_size)
     powermon_app_t *pmapp;
     job_context_t *alloc;
     int pos_job_in_node;
+    /* CPU domain lists are dom_size long, the CPUs of the node */
     if (domain == DOMAIN_CPU)
-        for (i = 0; i < MAX_CPUS_SUPPORTED; i++)
+        for (i = 0; i < dom_size; i++)
             f[i] = 0;
 #if USE_GPUS
     if (domain == DOMAIN_GPU)
@@ -932,7 +938,8 @@ void pmgt_get_app_req_freq(uint domain, ulong *f, uint dom_size)
                 }
                 // verbose_affinity_mask(&m, dom_size);
 
-                for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
+                uint cpus = ear_min(dom_size, pmapp->pc_app_info->num_cpus);
+                for (i = 0; i < cpus; i++) {
                     if (CPU_ISSET(i, &m))
                         f[i] = pmapp->pc_app_info->req_f[i];
                 }
@@ -950,7 +957,7 @@ void pmgt_get_app_req_freq(uint domain, ulong *f, uint dom_size)
         }
     }
     if (domain == DOMAIN_CPU) {
-        for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
+        for (i = 0; i < dom_size; i++) {
             if (use_min_cpufreq_in_idle) {
                 if (!f[i])
                     f[i] = frequency_pstate_to_freq(frequency_get_num_pstates() - 1);
@@ -964,15 +971,15 @@ void pmgt_get_app_req_freq(uint domain, ulong *f, uint dom_size)
 
 void pmgt_set_app_req_freq(pwr_mgt_t *phandler)
 {
-    ulong cpuf[MAX_CPUS_SUPPORTED];
-    memset(cpuf, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    uint cpus = pc_topology_info.cpu_count;
+    memset(pc_req_f, 0, sizeof(ulong) * cpus);
     if (pcsyms_fun[DOMAIN_NODE].set_app_req_freq != NULL) {
-        pmgt_get_app_req_freq(DOMAIN_NODE, cpuf, MAX_CPUS_SUPPORTED);
-        freturn(pcsyms_fun[DOMAIN_NODE].set_app_req_freq, cpuf);
+        pmgt_get_app_req_freq(DOMAIN_NODE, pc_req_f, cpus);
+        freturn(pcsyms_fun[DOMAIN_NODE].set_app_req_freq, pc_req_f);
     }
     if (pcsyms_fun[DOMAIN_CPU].set_app_req_freq != NULL) {
-        pmgt_get_app_req_freq(DOMAIN_CPU, cpuf, MAX_CPUS_SUPPORTED);
-        freturn(pcsyms_fun[DOMAIN_CPU].set_app_req_freq, cpuf);
+        pmgt_get_app_req_freq(DOMAIN_CPU, pc_req_f, cpus);
+        freturn(pcsyms_fun[DOMAIN_CPU].set_app_req_freq, pc_req_f);
     }
 #if USE_GPUS
     if (gpu_pc_model != API_DUMMY) {
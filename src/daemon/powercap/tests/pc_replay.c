@@ -0,0 +1,224 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Replays a power trace against the dvfs and mpc CPU powercap strategies.
+//
+// The trace has one line per period with the node power that the application
+// would consume at the nominal frequency (or "<time> <power>" lines, the time
+// is ignored). Without a trace, a synthetic one with three phases is used.
+// The node is simulated as P(f) = idle + (P_nominal - idle) * (f / f_nominal)^2
+// and the limit changes during the replay.
+//
+// For each strategy it prints the periods needed to settle after a limit or
+// phase change, the maximum overshoot, the energy spent over the limit and the
+// average frequency.
+//
+//     ./pc_replay [trace]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <daemon/powercap/mpc_control.h>
+
+#define CPUS         64
+#define PSTATES      15 // 2.4 GHz to 1.0 GHz
+#define IDLE_POWER   100.0
+#define PERIOD       0.5 // Seconds, the same than the plugins
+#define MAX_PERIODS  4096
+#define SETTLE_RANGE 0.05 // Settled when under the limit and closer than 5%, or at the top
+#define PSTATE_STEP  8
+#define PSTATE0_STEP 30
+
+typedef struct replay_s {
+    uint settle_total;
+    uint settle_worst;
+    uint events;
+    double overshoot;
+    double energy_over;
+    double khz_total;
+} replay_t;
+
+static ulong freqs[PSTATES];
+static double trace[MAX_PERIODS];
+static double limits[MAX_PERIODS];
+static uint periods;
+
+static double plant_power(double p_nominal, double khz)
+{
+    double ratio = khz / (double) freqs[0];
+    return IDLE_POWER + (p_nominal - IDLE_POWER) * ratio * ratio;
+}
+
+static void load_trace(char *path)
+{
+    char line[256];
+    double t, p;
+    FILE *fd;
+
+    if ((fd = fopen(path, "r")) == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while (periods < MAX_PERIODS && fgets(line, sizeof(line), fd) != NULL) {
+        if (sscanf(line, "%lf %lf", &t, &p) == 2) {
+            trace[periods++] = p;
+        } else if (sscanf(line, "%lf", &p) == 1) {
+            trace[periods++] = p;
+        }
+    }
+    fclose(fd);
+}
+
+static void synthetic_trace()
+{
+    static const double phases[] = {420.0, 350.0, 480.0, 390.0};
+    uint i;
+
+    periods = 240;
+    for (i = 0; i < periods; i++) {
+        // Phases of 30 periods with a 1% noise
+        trace[i] = phases[(i / 30) % 4] * (1.0 + 0.01 * sin(i * 1.7));
+    }
+}
+
+static void limit_schedule()
+{
+    uint i;
+    for (i = 0; i < periods; i++) {
+        limits[i] = (i < periods / 3) ? 380.0 : (i < 2 * periods / 3) ? 300.0 : 440.0;
+    }
+}
+
+static int is_event(uint i)
+{
+    return (i == 0) || (limits[i] != limits[i - 1]) || (fabs(trace[i] - trace[i - 1]) > 0.05 * trace[i - 1]);
+}
+
+/* The dvfs plugin loop, all the CPUs at the same P_STATE and without the
+ * flip-flop protection. */
+static double dvfs_step(uint *ps, double power, double limit)
+{
+    uint extra;
+
+    if (power > limit) {
+        *ps += (*ps < PSTATES - 1);
+        if (power - limit > 30) {
+            *ps += (*ps < PSTATES - 1);
+        }
+    } else if (*ps > 0) {
+        extra = (*ps <= 2) ? PSTATE0_STEP : PSTATE_STEP;
+        if (power + extra < limit) {
+            *ps -= 1;
+        }
+    }
+    return (double) freqs[*ps];
+}
+
+static double mpc_step(mpc_ctl_t *c, uint *ps, double khz, double power, double limit)
+{
+    uint limit_ps[CPUS];
+    ulong target;
+    double total = 0.0;
+    uint i;
+
+    memset(limit_ps, 0, sizeof(limit_ps));
+    mpc_ctl_observe(c, (ulong) khz, power);
+    target = mpc_ctl_target(c, (ulong) khz, power, limit, freqs[0]);
+    mpc_ctl_pstates(c, target, limit_ps, ps, CPUS);
+    for (i = 0; i < CPUS; i++) {
+        total += (double) freqs[ps[i]];
+    }
+    return total / CPUS;
+}
+
+static void account(replay_t *r, uint i, double khz, double power, uint *since, int *settled)
+{
+    double over = power - limits[i];
+
+    r->khz_total += khz;
+    if (is_event(i)) {
+        if (!*settled && i > 0) {
+            r->settle_total += *since;
+            r->settle_worst = (*since > r->settle_worst) ? *since : r->settle_worst;
+        }
+        r->events++;
+        *since   = 0;
+        *settled = 0;
+    }
+    if (!*settled) {
+        // At the highest frequency there is nothing else to do
+        if (over <= 0.0 && (-over <= SETTLE_RANGE * limits[i] || khz >= (double) freqs[0])) {
+            *settled = 1;
+            r->settle_total += *since;
+            r->settle_worst = (*since > r->settle_worst) ? *since : r->settle_worst;
+        }
+        *since += 1;
+    }
+    if (over > 0.0) {
+        r->overshoot = (over > r->overshoot) ? over : r->overshoot;
+        r->energy_over += over * PERIOD;
+    }
+}
+
+static void report(char *name, replay_t *r)
+{
+    printf("%-6s settling avg %5.1lf worst %3u periods, overshoot max %6.1lf W, energy over limit %8.1lf J, avg freq "
+           "%.3lf GHz\n",
+           name, (double) r->settle_total / r->events, r->settle_worst, r->overshoot, r->energy_over,
+           r->khz_total / periods / 1e6);
+}
+
+int main(int argc, char *argv[])
+{
+    replay_t r_dvfs, r_mpc;
+    uint ps_mpc[CPUS];
+    double f_dvfs, f_mpc, p_dvfs, p_mpc;
+    uint since_dvfs = 0, since_mpc = 0;
+    int settled_dvfs = 0, settled_mpc = 0;
+    uint ps_dvfs = 0;
+    mpc_ctl_t ctl;
+    uint i;
+
+    for (i = 0; i < PSTATES; i++) {
+        freqs[i] = 2400000 - i * 100000;
+    }
+    if (argc > 1) {
+        load_trace(argv[1]);
+    } else {
+        synthetic_trace();
+    }
+    if (periods == 0) {
+        printf("empty trace\n");
+        return 1;
+    }
+    limit_schedule();
+    memset(&r_dvfs, 0, sizeof(replay_t));
+    memset(&r_mpc, 0, sizeof(replay_t));
+    memset(ps_mpc, 0, sizeof(ps_mpc));
+    mpc_ctl_init(&ctl, freqs, PSTATES, PSTATE_STEP);
+
+    f_dvfs = f_mpc = (double) freqs[0];
+    for (i = 0; i < periods; i++) {
+        if (i > 0 && limits[i] != limits[i - 1]) {
+            mpc_ctl_reset(&ctl);
+        }
+        p_dvfs = plant_power(trace[i], f_dvfs);
+        p_mpc  = plant_power(trace[i], f_mpc);
+        account(&r_dvfs, i, f_dvfs, p_dvfs, &since_dvfs, &settled_dvfs);
+        account(&r_mpc, i, f_mpc, p_mpc, &since_mpc, &settled_mpc);
+        f_dvfs = dvfs_step(&ps_dvfs, p_dvfs, limits[i]);
+        f_mpc  = mpc_step(&ctl, ps_mpc, f_mpc, p_mpc, limits[i]);
+    }
+    printf("%u periods, %u CPUs, %u P_STATEs\n", periods, CPUS, PSTATES);
+    report("dvfs", &r_dvfs);
+    report("mpc", &r_mpc);
+    return 0;
+}
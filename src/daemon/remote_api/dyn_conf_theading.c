@@ -30,11 +30,34 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <common/messaging/msg_conf.h>
+#include <common/messaging/msg_internals.h>
+#include <daemon/remote_api/dyn_conf_theading.h>
+
 extern int eard_must_exit;
 
 static afd_set_t rfds_basic;
 static int pipe_for_new_conn[2];
 
+typedef struct rapi_job {
+    int fd;
+    request_t command;
+} rapi_job_t;
+
+typedef struct rapi_queue {
+    rapi_job_t jobs[RAPI_QUEUE_LEN];
+    uint head;
+    uint count;
+    uint running;
+    uint limit;
+} rapi_queue_t;
+
+static rapi_queue_t queues[RAPI_CLASSES];
+static uint queues_limit[RAPI_CLASSES] = {1, 1, 2, 1, 1};
+static pthread_mutex_t queues_lock     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queues_cond      = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[RAPI_WORKERS];
+
 state_t init_active_connections_list()
 {
     AFD_ZERO(&rfds_basic);
@@ -86,7 +109,7 @@ state_t remove_remote_connection(int fd)
 {
     debug("Closing remote connection %d", fd);
     AFD_CLR(fd, &rfds_basic);
-    close(fd);
+    remote_disconnect_fd(fd);
     return EAR_SUCCESS;
 }
 
@@ -101,8 +124,153 @@ static void check_all_fds(afd_set_t *fdset)
     }
 }
 
-/************* This thread will process the remote requests */
-extern state_t process_remote_requests(int clientfd);
+/************* These threads will process the remote requests */
+extern state_t read_remote_request(int clientfd, request_t *command);
+extern void accept_remote_request(int clientfd, request_t *command);
+extern void ignore_remote_request(int clientfd, request_t *command);
+extern state_t process_remote_request(int clientfd, request_t *command);
+
+uint remote_request_class(uint req)
+{
+    switch (req) {
+        case EAR_RC_RED_POWER:
+        case EAR_RC_SET_POWER:
+        case EAR_RC_INC_POWER:
+        case EAR_RC_SET_POWERCAP_OPT:
+        case EAR_RC_DEF_POWERCAP:
+        case EAR_RC_SET_RISK:
+            return RAPI_CLASS_POWER;
+        case EAR_RC_NEW_JOB:
+        case EAR_RC_END_JOB:
+        case EAR_RC_NEW_JOB_LIST:
+        case EAR_RC_END_JOB_LIST:
+        case EAR_RC_NEW_TASK:
+        case EAR_RC_END_TASK:
+        case EAR_RC_NODE_PURGE:
+            return RAPI_CLASS_JOB;
+        case EAR_RC_GET_POWERCAP_STATUS:
+        case EAR_RC_GET_POWERCAP_DELTA:
+        case EAR_RC_RELEASE_IDLE:
+        case EAR_RC_GET_POWER:
+            return RAPI_CLASS_PCQUERY;
+        case EAR_RC_STATUS:
+        case EAR_RC_APP_NODE_STATUS:
+        case EAR_RC_APP_MASTER_STATUS:
+        case EAR_RC_POLICY_STATUS:
+            return RAPI_CLASS_STATUS;
+        default:
+            return RAPI_CLASS_CONF;
+    }
+}
+
+uint remote_request_is_query(uint req)
+{
+    uint class = remote_request_class(req);
+    return (class == RAPI_CLASS_PCQUERY || class == RAPI_CLASS_STATUS);
+}
+
+/* Returns the class of higher priority with requests pending and workers available, RAPI_CLASSES if none. */
+static uint rapi_next_class()
+{
+    uint c;
+
+    for (c = 0; c < RAPI_CLASSES; c++) {
+        if (queues[c].count > 0 && queues[c].running < queues[c].limit) {
+            break;
+        }
+    }
+    return c;
+}
+
+static void *rapi_worker(void *arg)
+{
+    rapi_job_t job;
+    state_t ret;
+    uint c;
+
+    while (eard_must_exit == 0) {
+        pthread_mutex_lock(&queues_lock);
+        while ((c = rapi_next_class()) == RAPI_CLASSES) {
+            pthread_cond_wait(&queues_cond, &queues_lock);
+        }
+        memcpy(&job, &queues[c].jobs[queues[c].head], sizeof(rapi_job_t));
+        queues[c].head = (queues[c].head + 1) % RAPI_QUEUE_LEN;
+        queues[c].count--;
+        queues[c].running++;
+        pthread_mutex_unlock(&queues_lock);
+
+        verbose(VRAPI, "RemoteAPI worker processing request %u of class %u from %d", job.command.req, c, job.fd);
+        ret = process_remote_request(job.fd, &job.command);
+
+        pthread_mutex_lock(&queues_lock);
+        queues[c].running--;
+        pthread_cond_broadcast(&queues_cond);
+        pthread_mutex_unlock(&queues_lock);
+
+        /* The connection goes back to the reader */
+        if (state_fail(ret) || state_fail(notify_new_connection(job.fd))) {
+            verbose(VRAPI, "process_remote_request returns error, closing %d ret %d", job.fd, ret);
+            remote_disconnect_fd(job.fd);
+        }
+    }
+    pthread_exit(0);
+}
+
+static state_t rapi_workers_init()
+{
+    uint c, w;
+
+    for (c = 0; c < RAPI_CLASSES; c++) {
+        queues[c].limit = queues_limit[c];
+    }
+    for (w = 0; w < RAPI_WORKERS; w++) {
+        if (pthread_create(&workers[w], NULL, rapi_worker, NULL)) {
+            error("Creating RemoteAPI worker %u (%s)", w, strerror(errno));
+            return (w > 0) ? EAR_SUCCESS : EAR_ERROR;
+        }
+    }
+    return EAR_SUCCESS;
+}
+
+/* Reads the request of fd and queues it, while the connection is not polled. Returns EAR_ERROR if the connection
+ * must be closed. */
+static state_t rapi_dispatch(int fd)
+{
+    rapi_job_t *job;
+    request_t command;
+    uint c, full;
+
+    AFD_CLR(fd, &rfds_basic);
+    if (state_fail(read_remote_request(fd, &command))) {
+        return EAR_ERROR;
+    }
+    if (command.req == NO_COMMAND) {
+        AFD_SET(fd, &rfds_basic);
+        return EAR_SUCCESS;
+    }
+    c = remote_request_class(command.req);
+    // This is the only producer, so the space can not be lost once checked
+    pthread_mutex_lock(&queues_lock);
+    full = (queues[c].count == RAPI_QUEUE_LEN);
+    pthread_mutex_unlock(&queues_lock);
+    if (full) {
+        verbose(VRAPI, "RemoteAPI queue of class %u is full, ignoring request %u", c, command.req);
+        ignore_remote_request(fd, &command);
+        AFD_SET(fd, &rfds_basic);
+        return EAR_SUCCESS;
+    }
+    // The answer is sent before the request is visible to the workers
+    accept_remote_request(fd, &command);
+
+    pthread_mutex_lock(&queues_lock);
+    job     = &queues[c].jobs[(queues[c].head + queues[c].count) % RAPI_QUEUE_LEN];
+    job->fd = fd;
+    memcpy(&job->command, &command, sizeof(request_t));
+    queues[c].count++;
+    pthread_cond_broadcast(&queues_cond);
+    pthread_mutex_unlock(&queues_lock);
+    return EAR_SUCCESS;
+}
 
 void *process_remote_req_th(void *arg)
 {
@@ -111,6 +279,9 @@ void *process_remote_req_th(void *arg)
     int i;
 
     debug("Thread to process remote requests created ");
+    if (state_fail(rapi_workers_init())) {
+        error("No workers to process remote requests, remote connections won't be processed");
+    }
     verbose(VRAPI, "RemoteAPI connection fd %d", pipe_for_new_conn[0]);
     while ((numfds_ready = aselectv(&rfds_basic, NULL)) && (eard_must_exit == 0)) {
         verbose(VRAPI, "RemoteAPI thread new info received (new_conn/new_data)");
@@ -131,9 +302,9 @@ void *process_remote_req_th(void *arg)
                         add_new_connection();
                     } else {
                         verbose(VRAPI, "New request received in RemoteAPI thread %d", i);
-                        ret = process_remote_requests(i);
+                        ret = rapi_dispatch(i);
                         if (ret != EAR_SUCCESS) {
-                            verbose(VRAPI, "process_remote_requests returns error, closing %d ret %d", i, ret);
+                            verbose(VRAPI, "read_remote_request returns error, closing %d ret %d", i, ret);
                             remove_remote_connection(i);
                         }
                     }
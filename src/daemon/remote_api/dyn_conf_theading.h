@@ -14,10 +14,30 @@
 #include <common/config.h>
 #include <common/states.h>
 
+/* The remote requests are read by a single thread and processed by a pool of
+ * workers. Each class of requests has its queue, with the priority of its
+ * index, and a limit of workers, so the order of the requests changing the
+ * node state is kept and a slow subtree can only delay the requests of its
+ * class. The sum of the limits is the number of workers. */
+#define RAPI_CLASS_POWER   0 // Powercap changes, from the EARGM
+#define RAPI_CLASS_JOB     1 // Job and task events, from the scheduler
+#define RAPI_CLASS_PCQUERY 2 // Powercap and power queries, which wait for the subtree
+#define RAPI_CLASS_CONF    3 // Configuration changes and messages
+#define RAPI_CLASS_STATUS  4 // Status queries, which wait for the subtree
+#define RAPI_CLASSES       5
+
+#define RAPI_WORKERS   6
+#define RAPI_QUEUE_LEN 64
+
 state_t init_active_connections_list();
 state_t notify_new_connection(int fd);
 state_t add_new_connection();
 state_t remove_remote_connection(int fd);
 void *process_remote_req_th(void *arg);
 
+uint remote_request_class(uint req);
+
+/** Queries answer with data, propagating the request themselves. */
+uint remote_request_is_query(uint req);
+
 #endif
@@ -99,6 +99,8 @@ const char *polsyms_nam[] = {"policy_set_risk"};
 
 static char *TH_NAME = "RemoteAPI";
 static ehandler_t my_eh_rapi;
+/* Serializes the local part of the requests processed by the workers (dyn_conf_theading.c) */
+static pthread_mutex_t dyncon_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void print_f_list(uint p_states, ulong *freql)
 {
@@ -450,7 +452,9 @@ void dyncon_get_app_status(int fd, request_t *command)
 {
     app_status_t *status;
     int local_status;
+    pthread_mutex_lock(&dyncon_lock);
     local_status = powermon_get_num_applications(command->req == EAR_RC_APP_MASTER_STATUS);
+    pthread_mutex_unlock(&dyncon_lock);
     verbose(VRAPI, "We have %d local apps in app_status", local_status);
 
     int num_status              = propagate_app_status(command, my_cluster_conf.eard.port, &status, local_status);
@@ -462,7 +466,9 @@ void dyncon_get_app_status(int fd, request_t *command)
         _write(fd, &return_status, sizeof(return_status));
         return;
     }
+    pthread_mutex_lock(&dyncon_lock);
     powermon_get_app_status(&status[num_status - local_status], local_status, command->req == EAR_RC_APP_MASTER_STATUS);
+    pthread_mutex_unlock(&dyncon_lock);
 
     // if no job is present on the current node or we requested the master node and this one isn't, we free its data
     if (status[num_status - local_status].job_id == 0) {
@@ -491,7 +497,9 @@ void dyncon_get_policy_status(int fd, request_t *command)
         _write(fd, &return_status, sizeof(return_status));
         return;
     }
+    pthread_mutex_lock(&dyncon_lock);
     powermon_get_policy_status(&status[num_status - 1]);
+    pthread_mutex_unlock(&dyncon_lock);
     send_data(fd, sizeof(status_t) * num_status, (char *) status, EAR_TYPE_POLICY_STATUS);
     debug("Returning from dyncon_get_status");
     free(status);
@@ -510,7 +518,9 @@ void dyncon_get_status(int fd, request_t *command)
         _write(fd, &return_status, sizeof(return_status));
         return;
     }
+    pthread_mutex_lock(&dyncon_lock);
     powermon_get_status(&status[num_status - 1]);
+    pthread_mutex_unlock(&dyncon_lock);
     send_data(fd, sizeof(status_t) * num_status, (char *) status, EAR_TYPE_STATUS);
     debug("Returning from dyncon_get_status");
     free(status);
@@ -623,7 +633,9 @@ void dyncon_release_idle_power(int fd, request_t *command)
         error("dyncon_release_idle power and return status < 1");
 
     debug("releasing idle power");
+    pthread_mutex_lock(&dyncon_lock);
     powercap_release_idle_power(&rel_data);
+    pthread_mutex_unlock(&dyncon_lock);
 
     send_data(fd, sizeof(pc_release_data_t), (char *) &rel_data, EAR_TYPE_RELEASED);
     debug("returning from release_idle_power");
@@ -678,8 +690,10 @@ void dyncon_get_powerstatus(int fd, request_t *command)
     free(status_data);
     debug("return_status %d status=%p", return_status, status);
 
+    pthread_mutex_lock(&dyncon_lock);
     powercap_get_status(&status[return_status - 1], &p_status, command->my_req.release_power);
     process_pmgt_status(&status[return_status - 1], &p_status);
+    pthread_mutex_unlock(&dyncon_lock);
 
     status_data = mem_alloc_char_powercap_status(status);
     send_data(fd, sizeof(powercap_status_t) * return_status + ((sizeof(uint) * 2 + sizeof(int)) * (status->num_greedy)),
@@ -691,6 +705,97 @@ void dyncon_get_powerstatus(int fd, request_t *command)
     debug("powerstatus released");
 }
 
+/* Own contribution and greedy entry of the last EAR_RC_GET_POWERCAP_DELTA */
+static powercap_status_t pc_delta_base;
+static greedy_bytes_t pc_delta_greedy;
+static uint pc_delta_in_list;
+static uint pc_delta_epoch;
+static uint pc_delta_synced;
+
+static void add_greedy_entry(powercap_status_t *status, int ip, greedy_bytes_t *entry)
+{
+    status->num_greedy++;
+    status->greedy_nodes                         = realloc(status->greedy_nodes, sizeof(int) * status->num_greedy);
+    status->greedy_data                          = realloc(status->greedy_data, sizeof(greedy_bytes_t) * status->num_greedy);
+    status->greedy_nodes[status->num_greedy - 1] = ip;
+    memcpy(&status->greedy_data[status->num_greedy - 1], entry, sizeof(greedy_bytes_t));
+}
+
+/* Adds to status the change of this node since the base. Sums are done
+ * modulo 2^32, so negative changes are aggregated too. */
+static void add_own_delta(powercap_status_t *status, powercap_status_t *own, uint resync, uint epoch)
+{
+    greedy_bytes_t removed = {0};
+    uint in_list           = (own->num_greedy > 0);
+
+    if (!resync && (!pc_delta_synced || epoch != pc_delta_epoch + 1)) {
+        verbose(VRAPI, "powercap delta epoch %u does not follow %u, asking for a resync", epoch, pc_delta_epoch);
+        status->total_nodes += PC_DELTA_UNSYNCED;
+        return;
+    }
+    if (resync) {
+        memset(&pc_delta_base, 0, sizeof(powercap_status_t));
+        pc_delta_in_list = 0;
+    }
+    status->total_nodes += 1;
+    status->idle_nodes += own->idle_nodes - pc_delta_base.idle_nodes;
+    status->released += own->released - pc_delta_base.released;
+    status->requested += own->requested - pc_delta_base.requested;
+    status->total_idle_power += own->total_idle_power - pc_delta_base.total_idle_power;
+    status->current_power += own->current_power - pc_delta_base.current_power;
+    status->total_powercap += own->total_powercap - pc_delta_base.total_powercap;
+    if (in_list && (!pc_delta_in_list || memcmp(&pc_delta_greedy, own->greedy_data, sizeof(greedy_bytes_t)))) {
+        add_greedy_entry(status, my_ip, own->greedy_data);
+        memcpy(&pc_delta_greedy, own->greedy_data, sizeof(greedy_bytes_t));
+    } else if (!in_list && pc_delta_in_list) {
+        add_greedy_entry(status, my_ip, &removed);
+    }
+    memcpy(&pc_delta_base, own, sizeof(powercap_status_t));
+    pc_delta_base.greedy_nodes = NULL;
+    pc_delta_base.greedy_data  = NULL;
+    pc_delta_in_list           = in_list;
+    pc_delta_epoch             = epoch;
+    pc_delta_synced            = 1;
+}
+
+void dyncon_get_powerstatus_delta(int fd, request_t *command)
+{
+    powercap_status_t *status;
+    powercap_status_t own = {0};
+    pmgt_status_t p_status;
+    int return_status;
+    char *status_data;
+    uint resync = command->my_req.pc_delta.resync;
+    uint epoch  = command->my_req.pc_delta.epoch;
+
+    return_status = propagate_powercap_status(command, my_cluster_conf.eard.port, (powercap_status_t **) &status_data);
+    if (return_status < 1) {
+        error("dyncon_get_powerstatus_delta and return status < 1 ");
+        return_status = 0;
+        _write(fd, &return_status, sizeof(return_status));
+        return;
+    }
+    status = mem_alloc_powercap_status(status_data);
+    free(status_data);
+
+    memset(&p_status, 0, sizeof(pmgt_status_t));
+    pthread_mutex_lock(&dyncon_lock);
+    powercap_get_status(&own, &p_status, command->my_req.pc_delta.release_power);
+    process_pmgt_status(&own, &p_status);
+    add_own_delta(status, &own, resync, epoch);
+    pthread_mutex_unlock(&dyncon_lock);
+    free(own.greedy_nodes);
+    free(own.greedy_data);
+
+    status_data = mem_alloc_char_powercap_status(status);
+    send_data(fd, sizeof(powercap_status_t) + ((sizeof(uint) * 2 + sizeof(int)) * (status->num_greedy)), status_data,
+              EAR_TYPE_POWER_STATUS);
+    free(status_data);
+    free(status->greedy_nodes);
+    free(status->greedy_data);
+    free(status);
+}
+
 void dyncon_get_power(int fd, request_t *command)
 {
     power_check_t *power;
@@ -711,7 +816,9 @@ void dyncon_get_power(int fd, request_t *command)
     // the corrected power reading (making sure it is within the preset values and not a nonsense number),
     // which is what we want in this case
     // powermon_get_power(&curr_power);
+    pthread_mutex_lock(&dyncon_lock);
     curr_power = (uint64_t) powermon_current_power();
+    pthread_mutex_unlock(&dyncon_lock);
     power->power += curr_power;
     power->num_nodes++;
     debug("return_status %d power=%lu current_power=%lu", return_status, power->power, curr_power);
@@ -970,16 +1077,29 @@ void dyncon_process_message(char *in_message)
     free(message);
 }
 
-state_t process_remote_requests(int clientfd)
+void ignore_remote_request(int clientfd, request_t *command)
+{
+    long ack = EAR_IGNORE;
+
+    send_answer(clientfd, &ack);
+    if (command->num_nodes > 0) {
+        free(command->nodes);
+    }
+    if (command->req == EAR_RC_SEND_MESSAGE) {
+        free(command->my_req.message);
+    }
+    command->req = NO_COMMAND;
+}
+
+state_t read_remote_request(int clientfd, request_t *command)
 {
-    request_t command;
+    long ack = EAR_IGNORE;
     uint req;
-    long ack         = EAR_SUCCESS;
-    int num_contexts = 0;
+
     verbose(VRAPI, "connection received");
-    memset(&command, 0, sizeof(request_t));
-    command.req = NO_COMMAND;
-    req         = (int) read_command(clientfd, &command);
+    memset(command, 0, sizeof(request_t));
+    command->req = NO_COMMAND;
+    req          = (int) read_command(clientfd, command);
 
     debug("Process remote request %d", req);
 
@@ -987,32 +1107,47 @@ state_t process_remote_requests(int clientfd)
         return EAR_ERROR;
     else if (req == EAR_BAD_ARGUMENT) {
         verbose(VRAPI, "Recieved command with wrong security key");
-        ack = EAR_IGNORE;
+        command->req = NO_COMMAND;
         send_answer(clientfd, &ack);
         return EAR_SUCCESS;
     }
     /* New job and end job are different */
     /* Is it necesary */
-    if (!is_new_command(&command)) {
+    if (!is_new_command(command)) {
         verbose(VRAPI, "Recieved repeating command: %u", req);
-        ack = EAR_IGNORE;
-        send_answer(clientfd, &ack);
-        return EAR_SUCCESS;
+        ignore_remote_request(clientfd, command);
     }
+    return EAR_SUCCESS;
+}
+
+void accept_remote_request(int clientfd, request_t *command)
+{
+    long ack = EAR_SUCCESS;
 
     // new_job is a special case because ack means that shared files are created
-    if (req != EAR_RC_NEW_JOB && req != EAR_RC_NEW_JOB_LIST) {
+    if (command->req != EAR_RC_NEW_JOB && command->req != EAR_RC_NEW_JOB_LIST) {
         send_answer(clientfd, &ack); // send ack BEFORE processing the message to avoid delays
     }
-
     verbose(VRAPI, "New command accepted");
-    new_command_received(&command);
+    new_command_received(command);
+}
 
+state_t process_remote_request(int clientfd, request_t *command)
+{
+    uint req         = command->req;
+    uint locked      = !remote_request_is_query(req);
+    long ack         = EAR_SUCCESS;
+    int num_contexts = 0;
+
+    // Queries propagate and lock only while reading the local status
+    if (locked) {
+        pthread_mutex_lock(&dyncon_lock);
+    }
     switch (req) {
         case EAR_RC_NEW_JOB:
         case EAR_RC_NEW_JOB_LIST:
             verbose(VRAPI, "*******************************************");
-            verbose(VRAPI, "new_job command received %lu", command.my_req.new_job.job.id);
+            verbose(VRAPI, "new_job command received %lu", command->my_req.new_job.job.id);
             application_t req_app;
             // check pending contexts by looking at their pids (if they no longer exists we finish the jobs)
             num_contexts = mark_contexts_to_finish_by_pid();
@@ -1021,7 +1156,7 @@ state_t process_remote_requests(int clientfd)
                 finish_pending_contexts(&my_eh_rapi);
 
             // begin the new_job
-            adap_new_job_req_to_app(&req_app, &command.my_req.new_job);
+            adap_new_job_req_to_app(&req_app, &command->my_req.new_job);
             powermon_new_job(NULL, &my_eh_rapi, &req_app, 0, req == EAR_RC_NEW_JOB_LIST);
             send_answer(clientfd, &ack);
             break;
@@ -1030,58 +1165,58 @@ state_t process_remote_requests(int clientfd)
             break;
 #endif
         case EAR_RC_END_JOB_LIST:
-            powermon_end_job(&my_eh_rapi, command.my_req.end_job.jid, command.my_req.end_job.sid,
+            powermon_end_job(&my_eh_rapi, command->my_req.end_job.jid, command->my_req.end_job.sid,
                              req == EAR_RC_END_JOB_LIST);
             // mark any pending context for that job if it's an SBATCH
-            num_contexts = mark_contexts_to_finish_by_jobid(command.my_req.end_job.jid, command.my_req.end_job.sid);
+            num_contexts = mark_contexts_to_finish_by_jobid(command->my_req.end_job.jid, command->my_req.end_job.sid);
             // do the end_jobs for the marked jobs
             if (num_contexts)
                 finish_pending_contexts(&my_eh_rapi);
 #if 0
             //print_contexts_status();
 #endif
-            verbose(VRAPI, "end_job command received %lu", command.my_req.end_job.jid);
+            verbose(VRAPI, "end_job command received %lu", command->my_req.end_job.jid);
             verbose(VRAPI, "*******************************************");
             break;
         case EAR_RC_NEW_TASK:
             verbose(VRAPI, "NEW task received");
-            powermon_new_task(&command.my_req.new_task);
+            powermon_new_task(&command->my_req.new_task);
             break;
         case EAR_RC_END_TASK:
             verbose(VRAPI, "END task received");
-            // powermon_end_task(&command.my_req.end_task); //pending to implement
+            // powermon_end_task(&command->my_req.end_task); //pending to implement
             break;
         case EAR_RC_MAX_FREQ:
-            verbose(VRAPI, "max_freq command received %lu", command.my_req.ear_conf.max_freq);
-            ack = dynconf_max_freq(command.my_req.ear_conf.max_freq);
+            verbose(VRAPI, "max_freq command received %lu", command->my_req.ear_conf.max_freq);
+            ack = dynconf_max_freq(command->my_req.ear_conf.max_freq);
             break;
         case EAR_RC_NEW_TH:
-            verbose(VRAPI, "new_th command received %lu", command.my_req.ear_conf.th);
-            ack = dynconf_set_th(command.my_req.ear_conf.p_id, command.my_req.ear_conf.th);
+            verbose(VRAPI, "new_th command received %lu", command->my_req.ear_conf.th);
+            ack = dynconf_set_th(command->my_req.ear_conf.p_id, command->my_req.ear_conf.th);
             break;
         case EAR_RC_INC_TH:
-            verbose(VRAPI, "inc_th command received, %lu", command.my_req.ear_conf.th);
-            ack = dynconf_inc_th(command.my_req.ear_conf.p_id, command.my_req.ear_conf.th);
+            verbose(VRAPI, "inc_th command received, %lu", command->my_req.ear_conf.th);
+            ack = dynconf_inc_th(command->my_req.ear_conf.p_id, command->my_req.ear_conf.th);
             break;
         case EAR_RC_RED_PSTATE:
             verbose(VRAPI, "red_max_and_def_p_state command received");
-            ack = dynconf_red_pstates(command.my_req.ear_conf.p_states);
+            ack = dynconf_red_pstates(command->my_req.ear_conf.p_states);
             break;
         case EAR_RC_SET_FREQ:
             verbose(VRAPI, "set freq command received");
-            ack = dynconf_set_freq(command.my_req.ear_conf.max_freq);
+            ack = dynconf_set_freq(command->my_req.ear_conf.max_freq);
             break;
         case EAR_RC_DEF_FREQ:
             verbose(VRAPI, "set def freq command received");
-            ack = dynconf_def_freq(command.my_req.ear_conf.p_id, command.my_req.ear_conf.max_freq);
+            ack = dynconf_def_freq(command->my_req.ear_conf.p_id, command->my_req.ear_conf.max_freq);
             break;
         case EAR_RC_SET_DEF_PSTATE:
             verbose(VRAPI, "set def pstate command received");
-            ack = dynconf_set_def_pstate(command.my_req.ear_conf.p_states, command.my_req.ear_conf.p_id);
+            ack = dynconf_set_def_pstate(command->my_req.ear_conf.p_states, command->my_req.ear_conf.p_id);
             break;
         case EAR_RC_SET_MAX_PSTATE:
             verbose(VRAPI, "set max pstate command received");
-            ack = dynconf_set_max_pstate(command.my_req.ear_conf.p_states);
+            ack = dynconf_set_max_pstate(command->my_req.ear_conf.p_states);
             break;
         case EAR_RC_REST_CONF:
             verbose(VRAPI, "restore conf command received");
@@ -1089,25 +1224,25 @@ state_t process_remote_requests(int clientfd)
             break;
         case EAR_RC_SET_POLICY:
             verbose(VRAPI, "set policy received");
-            ack = dyncon_set_policy(&command.my_req.pol_conf);
+            ack = dyncon_set_policy(&command->my_req.pol_conf);
             break;
         case EAR_RC_PING:
             verbose(VRAPI + 1, "ping received");
             break;
         case EAR_RC_STATUS:
             verbose(VRAPI + 1, "Status received");
-            dyncon_get_status(clientfd, &command);
+            dyncon_get_status(clientfd, command);
             return EAR_SUCCESS;
             break;
         case EAR_RC_POLICY_STATUS:
             verbose(VRAPI + 1, "Policy status received");
-            dyncon_get_policy_status(clientfd, &command);
+            dyncon_get_policy_status(clientfd, command);
             return EAR_SUCCESS;
             break;
         case EAR_RC_APP_NODE_STATUS:
         case EAR_RC_APP_MASTER_STATUS:
             verbose(VRAPI + 1, "App status received");
-            dyncon_get_app_status(clientfd, &command);
+            dyncon_get_app_status(clientfd, command);
             return EAR_SUCCESS;
             break;
         case EAR_RC_RED_POWER:
@@ -1115,37 +1250,44 @@ state_t process_remote_requests(int clientfd)
         case EAR_RC_INC_POWER:
         case EAR_RC_SET_POWERCAP_OPT:
         case EAR_RC_DEF_POWERCAP:
-            dyncon_power_management(clientfd, &command);
+            dyncon_power_management(clientfd, command);
             break;
         case EAR_RC_GET_POWERCAP_STATUS:
-            dyncon_get_powerstatus(clientfd, &command);
+            dyncon_get_powerstatus(clientfd, command);
+            return EAR_SUCCESS;
+        case EAR_RC_GET_POWERCAP_DELTA:
+            dyncon_get_powerstatus_delta(clientfd, command);
             return EAR_SUCCESS;
         case EAR_RC_RELEASE_IDLE:
-            dyncon_release_idle_power(clientfd, &command);
+            dyncon_release_idle_power(clientfd, command);
             return EAR_SUCCESS;
         case EAR_RC_SET_RISK:
             verbose(VRAPI, "set risk command received");
-            dyncon_set_risk(clientfd, &command);
+            dyncon_set_risk(clientfd, command);
             break;
         case EAR_RC_GET_POWER:
-            dyncon_get_power(clientfd, &command);
+            dyncon_get_power(clientfd, command);
             return EAR_SUCCESS;
         case EAR_RC_NODE_PURGE:
             powermon_purge_old_jobs();
+            pthread_mutex_unlock(&dyncon_lock);
             return EAR_SUCCESS;
         case EAR_RC_SEND_MESSAGE:
-            dyncon_process_message(command.my_req.message);
+            dyncon_process_message(command->my_req.message);
             break;
         default:
             error("Invalid remote command %d\n", req);
             req = NO_COMMAND;
     }
+    if (locked) {
+        pthread_mutex_unlock(&dyncon_lock);
+    }
     if (req != EAR_RC_PING && req != NO_COMMAND && node_found != EAR_ERROR) {
-        verbose(VRAPI + 1, "command=%d propagated distance=%d", req, command.node_dist);
-        propagate_req(&command, my_cluster_conf.eard.port);
+        verbose(VRAPI + 1, "command=%d propagated distance=%d", req, command->node_dist);
+        propagate_req(command, my_cluster_conf.eard.port);
     }
     if (req == EAR_RC_SEND_MESSAGE)
-        free(command.my_req.message);
+        free(command->my_req.message);
     return EAR_SUCCESS;
 }
 
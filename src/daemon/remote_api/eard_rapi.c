@@ -68,6 +68,15 @@ state_t ear_get_powercap_status(cluster_conf_t *conf, powercap_status_t **pc_sta
         return ear_nodelist_get_powercap_status(conf, pc_status, release_power, nodes, num_nodes);
 }
 
+state_t ear_get_powercap_delta(cluster_conf_t *conf, powercap_status_t **pc_status, int release_power, uint epoch,
+                               uint resync, char **nodes, int num_nodes)
+{
+    if (nodes == NULL || num_nodes < 1)
+        return ear_cluster_get_powercap_delta(conf, pc_status, release_power, epoch, resync);
+    else
+        return ear_nodelist_get_powercap_delta(conf, pc_status, release_power, epoch, resync, nodes, num_nodes);
+}
+
 state_t ear_get_app_master_status(cluster_conf_t *conf, app_status_t **app_status, int32_t *num_status, char **nodes,
                                   int num_nodes)
 {
@@ -36,6 +36,10 @@
 /* Gets powercap status. Returns EAR_SUCCESS or EAR_ERROR. */
 state_t ear_get_powercap_status(cluster_conf_t *conf, powercap_status_t **pc_status, int release_power, char **nodes,
                                 int num_nodes);
+/* Gets the powercap status changes of every node since the previous epoch (or the whole status
+ * with resync). Returns EAR_SUCCESS or EAR_ERROR. */
+state_t ear_get_powercap_delta(cluster_conf_t *conf, powercap_status_t **pc_status, int release_power, uint epoch,
+                               uint resync, char **nodes, int num_nodes);
 /* Gets hardware status. Sets *num_status to the number of status allocated. Returns EAR_SUCCESS or EAR_ERROR.*/
 state_t ear_get_status(cluster_conf_t *conf, status_t **status, int32_t *num_status, char **nodes, int num_nodes);
 /* Gets accumulated power. Returns EAR_SUCCESS or EAR_ERROR.  */
@@ -30,7 +30,7 @@
 #include <daemon/remote_api/eard_rapi_internals.h>
 #include <daemon/remote_api/eard_server_api.h>
 
-extern int eards_sfd;
+extern __thread int eards_sfd;
 
 /** Asks application status for a single node */
 state_t ear_node_get_app_master_status(cluster_conf_t *my_cluster_conf, app_status_t **status, int32_t *num_status)
@@ -1076,6 +1076,67 @@ state_t ear_nodelist_get_powercap_status(cluster_conf_t *my_cluster_conf, powerc
     return EAR_SUCCESS;
 }
 
+state_t ear_cluster_get_powercap_delta(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status,
+                                       int release_power, uint epoch, uint resync)
+{
+    request_t command     = {0};
+    request_header_t head = {0};
+    powercap_status_t *temp_status;
+
+    command.time_code                     = time(NULL);
+    command.req                           = EAR_RC_GET_POWERCAP_DELTA;
+    command.my_req.pc_delta.release_power = release_power;
+    command.my_req.pc_delta.epoch         = epoch;
+    command.my_req.pc_delta.resync        = resync;
+    command.node_dist                     = 0;
+
+    head = data_all_nodes(&command, my_cluster_conf, (void **) &temp_status);
+
+    if (head.type != EAR_TYPE_POWER_STATUS || head.size < sizeof(powercap_status_t)) {
+        if (head.size > 0)
+            free(temp_status);
+        *pc_status = NULL;
+        return EAR_ERROR;
+    }
+
+    *pc_status = temp_status;
+
+    return EAR_SUCCESS;
+}
+
+state_t ear_nodelist_get_powercap_delta(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status,
+                                        int release_power, uint epoch, uint resync, char **nodes, int num_nodes)
+{
+    request_t command     = {0};
+    request_header_t head = {0};
+    int *ips;
+    powercap_status_t *temp_status;
+
+    get_ip_nodelist(my_cluster_conf, nodes, num_nodes, &ips);
+
+    command.req                           = EAR_RC_GET_POWERCAP_DELTA;
+    command.nodes                         = ips;
+    command.num_nodes                     = num_nodes;
+    command.my_req.pc_delta.release_power = release_power;
+    command.my_req.pc_delta.epoch         = epoch;
+    command.my_req.pc_delta.resync        = resync;
+    command.time_code                     = time(NULL);
+
+    head = data_nodelist(&command, my_cluster_conf, (void **) &temp_status);
+    free(ips);
+
+    if (head.type != EAR_TYPE_POWER_STATUS || head.size < sizeof(powercap_status_t)) {
+        if (head.size > 0)
+            free(temp_status);
+        *pc_status = NULL;
+        return EAR_ERROR;
+    }
+
+    *pc_status = temp_status;
+
+    return EAR_SUCCESS;
+}
+
 /** Asks nodes to release idle power */
 state_t ear_cluster_release_idle_power(cluster_conf_t *my_cluster_conf, pc_release_data_t *released)
 {
@@ -129,6 +129,10 @@ state_t ear_cluster_get_powercap_status(cluster_conf_t *my_cluster_conf, powerca
 
 state_t ear_node_get_powercap_status(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status, int release_power);
 
+/** Asks for the powercap_status changes since the epoch before to all nodes. See EAR_RC_GET_POWERCAP_DELTA. */
+state_t ear_cluster_get_powercap_delta(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status,
+                                       int release_power, uint epoch, uint resync);
+
 /** Send powercap_options to all nodes */
 state_t ear_cluster_set_powercap_opt(cluster_conf_t *my_cluster_conf, powercap_opt_t *pc_opt);
 
@@ -194,6 +198,8 @@ state_t ear_nodelist_get_policy_status(cluster_conf_t *my_cluster_conf, policy_s
                                        char **nodes, int num_nodes);
 state_t ear_nodelist_get_powercap_status(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status,
                                          int release_power, char **nodes, int num_nodes);
+state_t ear_nodelist_get_powercap_delta(cluster_conf_t *my_cluster_conf, powercap_status_t **pc_status,
+                                        int release_power, uint epoch, uint resync, char **nodes, int num_nodes);
 state_t ear_nodelist_get_power(cluster_conf_t *my_cluster_conf, power_check_t *power, char **nodes, int num_nodes);
 state_t ear_nodelist_set_powercap_opt(cluster_conf_t *my_cluster_conf, powercap_opt_t *pc_opt, char **nodes,
                                       int num_nodes);
@@ -551,9 +551,9 @@ int propagate_and_cat_data(request_t *command, uint port, void **status, size_t
         return num_items;
     }
 
-    // memory allocation with the current node
-    final_status = (char *) calloc(num_status + num_items, size);
-    memcpy(final_status, temp_status, head.size);
+    // the current node is appended to the data received, which is not copied if the allocator can grow it in place
+    final_status = (char *) realloc(temp_status, (num_status + num_items) * size);
+    memset(&final_status[num_status * size], 0, num_items * size);
 
     // current node info
     for (i = 0; i < num_items; i++) {
@@ -562,7 +562,6 @@ int propagate_and_cat_data(request_t *command, uint port, void **status, size_t
     }
     *status = final_status;
     num_status += num_items; // we add the original status
-    free(temp_status);
 
     return num_status;
 }
@@ -241,14 +241,19 @@ int get_pc_app_info_path(char *tmp, uint ID, char *path)
     return EAR_SUCCESS;
 }
 
-pc_app_info_t *create_pc_app_info_shared_area(char *path, int *fd, char *user)
+pc_app_info_t *create_pc_app_info_shared_area(char *path, uint num_cpus, int *fd, char *user)
 {
-    pc_app_info_t my_data;
+    size_t size = pcapp_info_size(num_cpus);
     mode_t perms = S_IRUSR | S_IWUSR;
-
+    pc_app_info_t *my_data;
     pc_app_info_t *mem;
-    mem =
-        (pc_app_info_t *) create_shared_area(path, perms, (char *) &my_data, sizeof(my_data), &fd_pc_app_info, 1, user);
+
+    if ((my_data = calloc(1, size)) == NULL) {
+        return NULL;
+    }
+    pcapp_info_init(my_data, num_cpus);
+    mem = (pc_app_info_t *) create_shared_area(path, perms, (char *) my_data, size, &fd_pc_app_info, 1, user);
+    free(my_data);
 
     if (fd) {
         *fd = fd_pc_app_info;
@@ -259,7 +264,23 @@ pc_app_info_t *create_pc_app_info_shared_area(char *path, int *fd, char *user)
 
 pc_app_info_t *attach_pc_app_info_shared_area(char *path)
 {
-    return (pc_app_info_t *) attach_shared_area(path, sizeof(pc_app_info_t), O_RDWR, &fd_pc_app_info, NULL);
+    pc_app_info_t *mem;
+    int size = 0;
+
+    /* The size is taken from the file */
+    mem = (pc_app_info_t *) attach_shared_area(path, 0, O_RDWR, &fd_pc_app_info, &size);
+    if (mem == NULL) {
+        return NULL;
+    }
+    if (size < sizeof(pc_app_info_t) || mem->version != PC_APP_INFO_VERSION ||
+        size < pcapp_info_size(mem->num_cpus)) {
+        error("pc_app_info area version %u not supported (expected %u)",
+              (size < sizeof(pc_app_info_t)) ? 0 : mem->version, PC_APP_INFO_VERSION);
+        munmap(mem, size);
+        dettach_shared_area(fd_pc_app_info);
+        return NULL;
+    }
+    return mem;
 }
 
 void dettach_pc_app_info_shared_area()
@@ -270,7 +291,7 @@ void dettach_pc_app_info_shared_area()
 void pc_app_info_shared_area_dispose(char *path, pc_app_info_t *mem, int fd)
 {
     if (mem) {
-        munmap(mem, sizeof(pc_app_info_t));
+        munmap(mem, pcapp_info_size(mem->num_cpus));
     }
 
     int fd_to_close = (fd >= 0) ? fd : fd_pc_app_info;
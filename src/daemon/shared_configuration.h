@@ -215,10 +215,12 @@ void dettach_frequencies_shared_area();
 /** Returns the path for the powercap application info shared memory area. */
 int get_pc_app_info_path(char *tmp, uint ID, char *path);
 
-/** Creates the shared memory area for powercap info. Owned by user (0660). */
-pc_app_info_t *create_pc_app_info_shared_area(char *path, int *fd, char *user);
+/** Creates the shared memory area for powercap info, sized for num_cpus CPUs.
+ * Owned by user (0660). */
+pc_app_info_t *create_pc_app_info_shared_area(char *path, uint num_cpus, int *fd, char *user);
 
-/** Attaches to the powercap application info shared memory area. */
+/** Attaches to the powercap application info shared memory area. Returns NULL
+ * if the area was created with a different PC_APP_INFO_VERSION. */
 pc_app_info_t *attach_pc_app_info_shared_area(char *path);
 
 /** Detaches from the powercap application info shared memory area. */
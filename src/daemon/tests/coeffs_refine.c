@@ -0,0 +1,218 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Feeds coeffs_refine with the signatures of synthetic applications, whose
+// power and CPI at each P_STATE are linear in their power, CPI and TPI at the
+// nominal one, so the coefficients between each pair of P_STATEs are known.
+// The signatures have the default frequency of the policy, as EARL reports
+// them, and an average frequency close to the P_STATE they ran at. It checks
+// that:
+//
+//   - Signatures with an average frequency between P_STATEs are discarded.
+//   - Starting from the identity, the refined coefficients project the
+//     signatures of new applications as the known ones.
+//   - A reader copying an entry by coeff_read while it is rewritten by
+//     coeff_write never gets a mix of both.
+//
+//     ./coeffs_refine
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <daemon/coeffs_refine.h>
+
+#define PSTATES 4
+#define APPS    40
+#define ROUNDS  12
+#define DEF_F   2400000 // The default frequency of the policy
+#define PROJ_TOL 0.01
+#define WRITES  2000000
+
+static ulong freqs[PSTATES] = {2400000, 2200000, 2000000, 1800000};
+// Per P_STATE, power = pa + pb * base power + pc * TPI, cpi = ca + cb * base CPI + cc * TPI
+static double pa[PSTATES] = {0.0, 12.0, 22.0, 30.0};
+static double pb[PSTATES] = {1.0, 0.86, 0.74, 0.64};
+static double pc[PSTATES] = {0.0, 0.5, 0.9, 1.2};
+static double ca[PSTATES] = {0.0, -0.02, -0.04, -0.05};
+static double cb[PSTATES] = {1.0, 0.95, 0.9, 0.86};
+static double cc[PSTATES] = {0.0, -0.004, -0.008, -0.011};
+static coefficient_t coeffs[PSTATES * PSTATES];
+static uint coeffs_count;
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+static double uniform(double min, double max)
+{
+    return min + (max - min) * (rand() / (double) RAND_MAX);
+}
+
+static void app_signature(application_t *app, char *name, uint ps, ulong avg_f, double power, double cpi, double tpi)
+{
+    memset(app, 0, sizeof(application_t));
+    snprintf(app->job.app_id, sizeof(app->job.app_id), "%s", name);
+    app->signature.def_f    = DEF_F;
+    app->signature.avg_f    = avg_f;
+    app->signature.DC_power = pa[ps] + pb[ps] * power + pc[ps] * tpi;
+    app->signature.CPI      = ca[ps] + cb[ps] * cpi + cc[ps] * tpi;
+    app->signature.TPI      = tpi;
+}
+
+static coefficient_t *coeffs_find(uint b, uint t)
+{
+    uint e;
+
+    for (e = 0; e < coeffs_count; e++) {
+        if (coeffs[e].pstate_ref == freqs[b] && coeffs[e].pstate == freqs[t]) {
+            return &coeffs[e];
+        }
+    }
+    return NULL;
+}
+
+/* Projects new applications from b to t, returns the worst relative error */
+static double projection_error(uint b, uint t)
+{
+    double power, cpi, tpi, proj, error = 0.0;
+    coefficient_t c;
+    uint i;
+
+    coeff_read(&c, coeffs_find(b, t));
+    for (i = 0; i < 20; i++) {
+        power = uniform(150.0, 350.0);
+        cpi   = uniform(0.4, 2.0);
+        tpi   = uniform(0.0, 20.0);
+        // The base signature is the one at b, the known one at t
+        proj = c.C + c.A * (pa[b] + pb[b] * power + pc[b] * tpi) + c.B * tpi;
+        error = fmax(error, fabs(1.0 - proj / (pa[t] + pb[t] * power + pc[t] * tpi)));
+        proj = c.F + c.D * (ca[b] + cb[b] * cpi + cc[b] * tpi) + c.E * tpi;
+        error = fmax(error, fabs(1.0 - proj / (ca[t] + cb[t] * cpi + cc[t] * tpi)));
+    }
+    return error;
+}
+
+static coefficient_t shared;
+static volatile int writing;
+
+static void *writer(void *arg)
+{
+    coefficient_t c;
+    uint i;
+
+    memset(&c, 0, sizeof(coefficient_t));
+    for (i = 1; i <= WRITES; i++) {
+        c.A = c.B = c.C = c.D = c.E = c.F = (double) i;
+        coeff_write(&shared, &c);
+    }
+    writing = 0;
+    return NULL;
+}
+
+static void test_seqlock()
+{
+    ulong reads = 0, torn = 0;
+    pthread_t thread;
+    coefficient_t c;
+
+    memset(&shared, 0, sizeof(coefficient_t));
+    writing = 1;
+    pthread_create(&thread, NULL, writer, NULL);
+    while (writing) {
+        coeff_read(&c, &shared);
+        torn += !(c.A == c.B && c.A == c.C && c.A == c.D && c.A == c.E && c.A == c.F);
+        reads++;
+    }
+    pthread_join(thread, NULL);
+    printf("seqlock: %lu reads, %lu torn\n", reads, torn);
+    check(torn == 0, "coeff_read copied a partially written entry");
+    check(shared.seq == 2 * WRITES, "the sequence is not even after the writes");
+}
+
+int main(int argc, char *argv[])
+{
+    double power, cpi, tpi, error, error_prior;
+    application_t app;
+    uint b, t, a, r, ps, order[PSTATES];
+    char name[32], msg[256];
+    ulong seq;
+
+    srand(11);
+    // Starting from the identity, the coefficients of the learning phase are not accurate
+    for (b = 0; b < PSTATES; b++) {
+        for (t = 0; t < PSTATES; t++) {
+            coeffs[coeffs_count].pstate_ref = freqs[b];
+            coeffs[coeffs_count].pstate     = freqs[t];
+            coeffs[coeffs_count].available  = 1;
+            coeffs[coeffs_count].A          = 1.0;
+            coeffs[coeffs_count].D          = 1.0;
+            coeffs_count++;
+        }
+    }
+    error_prior = projection_error(0, PSTATES - 1);
+    check(state_ok(coeffs_refine_init(coeffs, coeffs_count)), "coeffs_refine_init failed");
+
+    // Between 2.2 and 2.0 GHz, the policy changed the frequency
+    for (r = 0; r < ROUNDS; r++) {
+        for (a = 0; a < APPS; a++) {
+            snprintf(name, sizeof(name), "between%u", a);
+            app_signature(&app, name, r % 2, (r % 2) ? 2100000 : 2300000, uniform(150.0, 350.0), 1.0, 5.0);
+            coeffs_refine_signature(&app);
+        }
+    }
+    for (b = 0, seq = 0; b < coeffs_count; b++) {
+        seq += coeffs[b].seq;
+    }
+    check(seq == 0, "signatures between P_STATEs refined the coefficients");
+
+    // The same applications at every P_STATE, in a different order each round
+    for (r = 0; r < ROUNDS; r++) {
+        for (a = 0; a < APPS; a++) {
+            snprintf(name, sizeof(name), "app%u", a);
+            power = uniform(150.0, 350.0);
+            cpi   = uniform(0.4, 2.0);
+            tpi   = uniform(0.0, 20.0);
+            for (ps = 0; ps < PSTATES; ps++) {
+                order[ps] = (ps + a + r) % PSTATES;
+            }
+            for (ps = 0; ps < PSTATES; ps++) {
+                // Within 0.5% of the P_STATE
+                app_signature(&app, name, order[ps], freqs[order[ps]] * uniform(0.995, 1.005), power, cpi, tpi);
+                coeffs_refine_signature(&app);
+            }
+        }
+    }
+    for (b = 0; b < PSTATES; b++) {
+        for (t = 0; t < PSTATES; t++) {
+            if (b == t) {
+                continue;
+            }
+            error = projection_error(b, t);
+            snprintf(msg, sizeof(msg), "projection %lu -> %lu error %.2lf%%", freqs[b], freqs[t], error * 100.0);
+            check(error < PROJ_TOL, msg);
+            check(coeffs_find(b, t)->seq % 2 == 0, "an entry is left with an odd sequence");
+        }
+    }
+    printf("projection 2.4 -> 1.8 GHz: %.2lf%% error with the identity, %.2lf%% refined\n", error_prior * 100.0,
+           projection_error(0, PSTATES - 1) * 100.0);
+
+    test_seqlock();
+
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
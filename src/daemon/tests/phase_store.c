@@ -0,0 +1,174 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Saves and loads the phase store of EARD (phase_store.h) in a temporal
+// folder, as EARD restarts. It checks that:
+//
+//   - The phases put are got back after loading the store again, without the
+//     ones not valid, and only for the same application and settings.
+//   - The file is created readable only by its owner.
+//   - A file of other version, with too many applications, with a string not
+//     terminated or truncated is discarded.
+//   - A file writable by others, a symbolic link or a file with other hard
+//     links is discarded.
+//   - A link placed where the temporal file is created is never followed.
+//
+//     ./phase_store
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <common/sizes.h>
+#include <daemon/phase_store.h>
+
+// The header of the file: version, application size, applications and uses
+#define HEAD_VERSION 0
+#define HEAD_APPS    (2 * sizeof(uint))
+#define HEAD_SIZE    (3 * sizeof(uint) + sizeof(uint) + sizeof(ulong))
+#define PHASES       3
+
+static char dir[SZ_PATH_SHORT];
+static char store[SZ_PATH];
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+static void conf_set(phase_conf_t *conf, uint i, uint valid)
+{
+    memset(conf, 0, sizeof(phase_conf_t));
+    conf->key.event     = 10;
+    conf->key.size      = 3;
+    conf->key.level     = 1;
+    conf->key.cpi       = i;
+    conf->key.gbs       = 2 * i;
+    conf->proj.esaving  = 10.0 + i;
+    conf->cpu_freq      = 2000000 + i * 100000;
+    conf->imc_pstate[0] = i;
+    conf->imc_pstate[1] = i + 2;
+    conf->valid         = valid;
+}
+
+/* Loads the store again and returns the phases of the application */
+static uint reload(phase_app_t *app, phase_conf_t *confs)
+{
+    uint count = 0;
+
+    phase_store_init(dir);
+    phase_store_get("user", app, confs, &count);
+    return count;
+}
+
+static void corrupt(off_t offset, void *data, size_t size)
+{
+    int fd = open(store, O_WRONLY);
+
+    if (fd < 0 || pwrite(fd, data, size, offset) != size) {
+        printf("error: corrupting %s\n", store);
+        errors++;
+    }
+    close(fd);
+}
+
+int main(int argc, char *argv[])
+{
+    phase_conf_t confs[PHASES], got[PHASE_CONF_MAX];
+    char victim[SZ_PATH], temp[SZ_PATH + 32], name[GENERIC_NAME];
+    phase_app_t app, other;
+    struct stat st;
+    uint value, c;
+    int fd;
+
+    sprintf(dir, "/tmp/ear_phase_store.%d", getpid());
+    if (mkdir(dir, 0700) != 0) {
+        printf("error: creating %s\n", dir);
+        return 1;
+    }
+    snprintf(store, sizeof(store), "%s/.ear_phase_store", dir);
+    snprintf(victim, sizeof(victim), "%s/victim", dir);
+    snprintf(temp, sizeof(temp), "%s.%d", store, getpid());
+    memset(&app, 0, sizeof(phase_app_t));
+    strcpy(app.app_id, "bt-mz.C");
+    strcpy(app.policy, "min_energy");
+    app.th       = 0.1;
+    app.def_freq = 2400000;
+    memcpy(&other, &app, sizeof(phase_app_t));
+    other.th = 0.05;
+    for (c = 0; c < PHASES; ++c) {
+        conf_set(&confs[c], c, (c != 1));
+    }
+
+    // Round-trip
+    check(reload(&app, got) == 0, "an empty folder has phases");
+    check(state_ok(phase_store_put("user", &app, confs, PHASES)), "put");
+    check(stat(store, &st) == 0 && (st.st_mode & 0777) == 0600, "the file is not readable only by its owner");
+    check(reload(&app, got) == 2, "the phases are not loaded");
+    check(memcmp(&got[0], &confs[0], sizeof(phase_conf_t)) == 0 &&
+              memcmp(&got[1], &confs[2], sizeof(phase_conf_t)) == 0,
+          "the phases loaded are not the ones put");
+    c = PHASES;
+    phase_store_get("other", &app, got, &c);
+    check(c == 0, "the phases of other user are got");
+    phase_store_get("user", &other, got, &c);
+    check(c == 0, "the phases of other settings are got");
+
+    // Corrupted files
+    value = 99;
+    corrupt(HEAD_VERSION, &value, sizeof(uint));
+    check(reload(&app, got) == 0, "a file of other version is loaded");
+    phase_store_put("user", &app, confs, PHASES);
+    value = 100000;
+    corrupt(HEAD_APPS, &value, sizeof(uint));
+    check(reload(&app, got) == 0, "a file with too many applications is loaded");
+    phase_store_put("user", &app, confs, PHASES);
+    memset(name, 'x', sizeof(name));
+    corrupt(HEAD_SIZE, name, sizeof(name));
+    check(reload(&app, got) == 0, "a file with a user not terminated is loaded");
+    phase_store_put("user", &app, confs, PHASES);
+    check(truncate(store, HEAD_SIZE + 64) == 0 && reload(&app, got) == 0, "a truncated file is loaded");
+    phase_store_put("user", &app, confs, PHASES);
+    check(reload(&app, got) == 2, "the store is not saved again after a corrupted file");
+
+    // Untrusted files
+    chmod(store, 0666);
+    check(reload(&app, got) == 0, "a file writable by others is loaded");
+    phase_store_put("user", &app, confs, PHASES);
+    rename(store, victim);
+    check(symlink(victim, store) == 0 && reload(&app, got) == 0, "a symbolic link is loaded");
+    unlink(store);
+    check(link(victim, store) == 0 && reload(&app, got) == 0, "a file with other hard links is loaded");
+    unlink(store);
+    unlink(victim);
+
+    // A link in place of the temporal file
+    fd = open(victim, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    close(fd);
+    check(symlink(victim, temp) == 0, "creating the link");
+    check(state_fail(phase_store_put("user", &app, confs, PHASES)), "the temporal link is followed");
+    check(stat(victim, &st) == 0 && st.st_size == 0, "the target of the temporal link is written");
+    unlink(temp);
+    check(state_ok(phase_store_put("user", &app, confs, PHASES)) && reload(&app, got) == 2,
+          "the store is not saved after removing the link");
+
+    unlink(store);
+    unlink(victim);
+    rmdir(dir);
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
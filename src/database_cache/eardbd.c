@@ -23,6 +23,7 @@
 #if !EDB_OFFLINE
 #include <common/config.h>
 #include <common/system/folder.h>
+#include <common/types/configuration/cluster_conf_image.h>
 #include <report/report.h>
 #endif
 
@@ -155,7 +156,7 @@ static void init_general_configuration(int argc, char **argv, cluster_conf_t *co
     }
 
     verb_master("reading '%s' configuration file", extra_buffer);
-    read_cluster_conf(extra_buffer, conf_clus);
+    cluster_conf_image_read(extra_buffer, conf_clus);
 
 #if 0
 	// Database configuration (activated in the past through USE_EARDBD_CONF)
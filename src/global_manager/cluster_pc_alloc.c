@@ -0,0 +1,290 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+// #define SHOW_DEBUGS 1
+#include <common/colors.h>
+#include <common/config.h>
+#include <common/output/verbose.h>
+#include <global_manager/cluster_pc_alloc.h>
+
+#define min(a, b) (a < b ? a : b)
+
+/* A breakpoint of the water-filling function */
+typedef struct level_s {
+    uint watts;
+    int slope;
+} level_t;
+
+static int compare_level(const void *a, const void *b)
+{
+    uint wa = ((level_t *) a)->watts;
+    uint wb = ((level_t *) b)->watts;
+    return (wa > wb) - (wa < wb);
+}
+
+static int compare_uint_desc(const void *a, const void *b)
+{
+    uint ua = *((uint *) a);
+    uint ub = *((uint *) b);
+    return (ua < ub) - (ua > ub);
+}
+
+state_t pc_alloc_load(char *name, pc_alloc_ops_t *ops)
+{
+    if (name == NULL || strcmp(name, PC_ALLOC_LEGACY) == 0) {
+        ops->name   = PC_ALLOC_LEGACY;
+        ops->grant  = pc_alloc_legacy_grant;
+        ops->reduce = pc_alloc_legacy_reduce;
+    } else if (strcmp(name, PC_ALLOC_WATERFILL) == 0) {
+        ops->name   = PC_ALLOC_WATERFILL;
+        ops->grant  = pc_alloc_waterfill_grant;
+        ops->reduce = pc_alloc_waterfill_reduce;
+    } else {
+        return_msg(EAR_ERROR, Generr.api_undefined);
+    }
+    return EAR_SUCCESS;
+}
+
+/************************************** legacy ***************************************/
+
+void pc_alloc_legacy_grant(powercap_status_t *cs, powercap_opt_t *opt, uint *free_power)
+{
+    uint req_no_extra = 0, num_no_extra = 0, num_greedy = 0;
+    uint pending      = *free_power;
+    int i, more_power;
+
+    for (i = 0; i < cs->num_greedy; i++) {
+        if (cs->greedy_data[i].requested) {
+            num_greedy++;
+            if (!cs->greedy_data[i].extra_power) {
+                req_no_extra += cs->greedy_data[i].requested;
+                num_no_extra++;
+            }
+        }
+    }
+    if (num_greedy == 0) {
+        return;
+    }
+    verbose(VGM_PC + 1, "Total extra power for nodes with NO current extra power %u W, %u nodes", req_no_extra,
+            num_no_extra);
+    if (num_no_extra > 0) {
+        if (req_no_extra < pending)
+            more_power = -1;
+        else
+            more_power = pending / num_no_extra;
+        verbose(VGM_PC + 1, "STAGE_1-Allocating %d watts to new greedy nodes first (-1 => alloc=req)", more_power);
+        for (i = 0; i < cs->num_greedy; i++) {
+            if ((cs->greedy_data[i].requested) && (!cs->greedy_data[i].extra_power)) {
+                if (more_power < 0)
+                    opt->extra_power[i] = cs->greedy_data[i].requested;
+                else
+                    opt->extra_power[i] = min(more_power, cs->greedy_data[i].requested);
+                pending -= opt->extra_power[i];
+            }
+        }
+    }
+    /* If there is pending power to allocate */
+    verbose(VGM_PC + 1, "STAGE-2 allocating %uW to the rest of greedy nodes", pending);
+    if (pending) {
+        more_power = pending / num_greedy;
+        for (i = 0; i < cs->num_greedy; i++) {
+            if ((cs->greedy_data[i].requested) && (!opt->extra_power[i])) {
+                opt->extra_power[i] = min(cs->greedy_data[i].requested, more_power);
+                pending -= opt->extra_power[i];
+            }
+        }
+    }
+    *free_power = pending;
+}
+
+void pc_alloc_legacy_reduce(powercap_status_t *cs, powercap_opt_t *opt, uint min_reduction)
+{
+    uint red1, red, red_node, num_extra = 0;
+    int i = 0;
+
+    for (i = 0; i < cs->num_greedy; i++) {
+        num_extra += (cs->greedy_data[i].extra_power > 0);
+    }
+    if (num_extra == 0) {
+        error("We need to reallocated power and there is no extra power ");
+        return;
+    }
+    red_node = min_reduction / num_extra;
+    verbose(VGM_PC + 1, "SEQ reduce_allocation implementation avg red=%uW", red_node);
+    debug("ROUND 1- reducing avg power ");
+    i = 0;
+    while ((min_reduction > 0) && (i < cs->num_greedy)) {
+        if (cs->greedy_data[i].extra_power) {
+            red1                = min(red_node, cs->greedy_data[i].extra_power);
+            red                 = min(red1, min_reduction);
+            opt->extra_power[i] = -red;
+            min_reduction -= red;
+        }
+        i++;
+    }
+    debug("ROUND 2- Reducing remaining power ");
+    i = 0;
+    while ((min_reduction > 0) && (i < cs->num_greedy)) {
+        /* opt->extra_power[i] is a negative value */
+        if ((cs->greedy_data[i].extra_power + opt->extra_power[i]) > 0) {
+            red1 = cs->greedy_data[i].extra_power + opt->extra_power[i];
+            red  = min(red1, min_reduction);
+            opt->extra_power[i] -= red;
+            min_reduction -= red;
+        }
+        i++;
+    }
+}
+
+/************************************** waterfill ************************************/
+
+void pc_alloc_waterfill_grant(powercap_status_t *cs, powercap_opt_t *opt, uint *free_power)
+{
+    ullong total_req = 0, filled = 0, step;
+    uint level, low, high, leftover;
+    level_t *levels;
+    uint count = 0;
+    int slope  = 0;
+    int i;
+
+    if (*free_power == 0 || cs->num_greedy == 0) {
+        return;
+    }
+    for (i = 0; i < cs->num_greedy; i++) {
+        total_req += cs->greedy_data[i].requested;
+    }
+    if (total_req <= *free_power) {
+        for (i = 0; i < cs->num_greedy; i++) {
+            opt->extra_power[i] = cs->greedy_data[i].requested;
+        }
+        *free_power -= total_req;
+        return;
+    }
+    if ((levels = calloc(cs->num_greedy * 2, sizeof(level_t))) == NULL) {
+        error("Cannot allocate %u levels, using the legacy allocation", cs->num_greedy * 2);
+        pc_alloc_legacy_grant(cs, opt, free_power);
+        return;
+    }
+    /* Each node fills between its extra power and its extra power plus
+     * the requested, so the filled power grows one watt per node between
+     * both levels. The level where the filled power is the free power is
+     * found sweeping the sorted breakpoints. */
+    for (i = 0; i < cs->num_greedy; i++) {
+        if (cs->greedy_data[i].requested) {
+            levels[count].watts   = cs->greedy_data[i].extra_power;
+            levels[count++].slope = 1;
+            levels[count].watts   = cs->greedy_data[i].extra_power + cs->greedy_data[i].requested;
+            levels[count++].slope = -1;
+        }
+    }
+    qsort(levels, count, sizeof(level_t), compare_level);
+
+    level = levels[0].watts;
+    for (i = 0; i < count; i++) {
+        step = (ullong) slope * (levels[i].watts - level);
+        if (filled + step >= *free_power) {
+            break;
+        }
+        filled += step;
+        level = levels[i].watts;
+        slope += levels[i].slope;
+    }
+    // The slope is not 0 here, otherwise the total requested is not over the free power
+    level += (*free_power - filled) / slope;
+    free(levels);
+
+    /* The remainder is less than a watt per node at the level */
+    filled = 0;
+    for (i = 0; i < cs->num_greedy; i++) {
+        low  = cs->greedy_data[i].extra_power;
+        high = low + cs->greedy_data[i].requested;
+        if (cs->greedy_data[i].requested && level > low) {
+            opt->extra_power[i] = min(level, high) - low;
+            filled += opt->extra_power[i];
+        }
+    }
+    leftover = *free_power - filled;
+    for (i = 0; i < cs->num_greedy && leftover > 0; i++) {
+        low  = cs->greedy_data[i].extra_power;
+        high = low + cs->greedy_data[i].requested;
+        if (cs->greedy_data[i].requested && level >= low && level < high) {
+            opt->extra_power[i]++;
+            leftover--;
+        }
+    }
+    verbose(VGM_PC + 1, "Water-filling level %u W of extra power for %u greedy nodes", level, count / 2);
+    *free_power = leftover;
+}
+
+void pc_alloc_waterfill_reduce(powercap_status_t *cs, powercap_opt_t *opt, uint reduction)
+{
+    ullong total = 0, above = 0;
+    uint *extras, level = 0, taken, leftover;
+    uint count = 0;
+    int i;
+
+    if (reduction == 0) {
+        return;
+    }
+    if ((extras = calloc(cs->num_greedy, sizeof(uint))) == NULL) {
+        error("Cannot allocate %u extra power values, using the legacy reduction", cs->num_greedy);
+        pc_alloc_legacy_reduce(cs, opt, reduction);
+        return;
+    }
+    for (i = 0; i < cs->num_greedy; i++) {
+        if (cs->greedy_data[i].extra_power) {
+            extras[count++] = cs->greedy_data[i].extra_power;
+            total += cs->greedy_data[i].extra_power;
+        }
+    }
+    if (count == 0) {
+        error("We need to reallocated power and there is no extra power ");
+        free(extras);
+        return;
+    }
+    if (total <= reduction) {
+        level = 0;
+    } else {
+        /* The k highest extra powers go down to a common level */
+        qsort(extras, count, sizeof(uint), compare_uint_desc);
+        for (i = 0; i < count; i++) {
+            above += extras[i];
+            if (above <= reduction) {
+                continue;
+            }
+            // Level of the i+1 highest, rounded up to not take more than needed
+            level = (above - reduction + i) / (i + 1);
+            if (i + 1 == count || level >= extras[i + 1]) {
+                break;
+            }
+        }
+    }
+    free(extras);
+
+    taken = 0;
+    for (i = 0; i < cs->num_greedy; i++) {
+        if (cs->greedy_data[i].extra_power > level) {
+            opt->extra_power[i] = -(int) (cs->greedy_data[i].extra_power - level);
+            taken += cs->greedy_data[i].extra_power - level;
+        }
+    }
+    /* The remainder is less than a watt per node over the level */
+    leftover = (taken < reduction && level > 0) ? reduction - taken : 0;
+    for (i = 0; i < cs->num_greedy && leftover > 0; i++) {
+        if (cs->greedy_data[i].extra_power >= level && cs->greedy_data[i].extra_power > 0) {
+            opt->extra_power[i]--;
+            leftover--;
+        }
+    }
+    verbose(VGM_PC + 1, "%sReducing the extra power to a level of %u W%s", COL_RED, level, COL_CLR);
+}
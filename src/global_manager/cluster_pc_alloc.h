@@ -0,0 +1,58 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef CLUSTER_PC_ALLOC_H
+#define CLUSTER_PC_ALLOC_H
+
+#include <common/states.h>
+#include <common/types/generic.h>
+#include <daemon/powercap/powercap_status_conf.h>
+
+/* Allocation engines of the cluster HARD powercap. They decide how the free
+ * power is distributed between the greedy nodes and from which greedy nodes
+ * the extra power is taken back. Both functions write the extra_power list of
+ * the options, which has the same order than the greedy_data of the status
+ * and has to be zeroed by the caller.
+ *
+ * - legacy: equal splits in array order, first to the greedy nodes without
+ *   extra power and then to the rest.
+ * - waterfill: bounded water-filling. The free power raises the lowest total
+ *   extra power (extra_power + granted) of all the greedy nodes to a common
+ *   level, limited by what each node requested, so no power is left while a
+ *   node can use it. Reductions lower the highest extra powers to a common
+ *   level. O(n log n) in the number of greedy nodes.
+ *
+ * The engine is selected by the EARGM_POWERCAP_ALLOC environment variable,
+ * legacy is the default and waterfill has to be requested explicitly. */
+
+#define PC_ALLOC_LEGACY    "legacy"
+#define PC_ALLOC_WATERFILL "waterfill"
+
+typedef struct pc_alloc_ops_s {
+    char *name;
+    /* Distributes up to *free_power watts, it returns the watts left. */
+    void (*grant)(powercap_status_t *cs, powercap_opt_t *opt, uint *free_power);
+    /* Takes reduction watts back from the extra power (negative extra_power),
+     * or all the extra power if there is not enough. */
+    void (*reduce)(powercap_status_t *cs, powercap_opt_t *opt, uint reduction);
+} pc_alloc_ops_t;
+
+/** Fills ops with the engine called name. A NULL name loads the default one. */
+state_t pc_alloc_load(char *name, pc_alloc_ops_t *ops);
+
+void pc_alloc_legacy_grant(powercap_status_t *cs, powercap_opt_t *opt, uint *free_power);
+
+void pc_alloc_legacy_reduce(powercap_status_t *cs, powercap_opt_t *opt, uint reduction);
+
+void pc_alloc_waterfill_grant(powercap_status_t *cs, powercap_opt_t *opt, uint *free_power);
+
+void pc_alloc_waterfill_reduce(powercap_status_t *cs, powercap_opt_t *opt, uint reduction);
+
+#endif // CLUSTER_PC_ALLOC_H
@@ -0,0 +1,186 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+// #define SHOW_DEBUGS 1
+#include <common/config.h>
+#include <common/output/verbose.h>
+#include <global_manager/cluster_pc_view.h>
+
+typedef struct greedy_entry_s {
+    int32_t ip;
+    greedy_bytes_t data;
+} greedy_entry_t;
+
+static int compare_entry(const void *a, const void *b)
+{
+    int32_t ia = ((greedy_entry_t *) a)->ip;
+    int32_t ib = ((greedy_entry_t *) b)->ip;
+    return (ia > ib) - (ia < ib);
+}
+
+static uint is_removal(greedy_bytes_t *data)
+{
+    return (data->requested == 0 && data->extra_power == 0);
+}
+
+static greedy_entry_t *sorted_entries(powercap_status_t *reply)
+{
+    greedy_entry_t *entries;
+    uint i;
+
+    if ((entries = calloc(reply->num_greedy + 1, sizeof(greedy_entry_t))) == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < reply->num_greedy; i++) {
+        entries[i].ip   = reply->greedy_nodes[i];
+        entries[i].data = reply->greedy_data[i];
+    }
+    qsort(entries, reply->num_greedy, sizeof(greedy_entry_t), compare_entry);
+    return entries;
+}
+
+void pc_view_init(pc_view_t *v)
+{
+    memset(v, 0, sizeof(pc_view_t));
+    v->enabled = 1;
+}
+
+void pc_view_dispose(pc_view_t *v)
+{
+    free(v->greedy_nodes);
+    free(v->greedy_data);
+    pc_view_init(v);
+}
+
+uint pc_view_next(pc_view_t *v, uint *resync)
+{
+    *resync = (!v->synced || v->periods >= PC_VIEW_RESYNC_PERIODS);
+    v->epoch++;
+    return v->epoch;
+}
+
+void pc_view_invalidate(pc_view_t *v)
+{
+    v->synced = 0;
+}
+
+void pc_view_full(pc_view_t *v, powercap_status_t *status)
+{
+    v->full_nodes = status->total_nodes;
+}
+
+/* Merges the sorted changes with the sorted view, O(n + k). */
+static state_t merge_changes(pc_view_t *v, greedy_entry_t *changes, uint num_changes)
+{
+    int32_t *nodes;
+    greedy_bytes_t *data;
+    uint i = 0, c = 0, n = 0;
+
+    nodes = calloc(v->num_greedy + num_changes + 1, sizeof(int32_t));
+    data  = calloc(v->num_greedy + num_changes + 1, sizeof(greedy_bytes_t));
+    if (nodes == NULL || data == NULL) {
+        free(nodes);
+        free(data);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    while (i < v->num_greedy || c < num_changes) {
+        if (c == num_changes || (i < v->num_greedy && v->greedy_nodes[i] < changes[c].ip)) {
+            nodes[n]  = v->greedy_nodes[i];
+            data[n++] = v->greedy_data[i++];
+            continue;
+        }
+        // The change replaces the node entry, if any
+        if (i < v->num_greedy && v->greedy_nodes[i] == changes[c].ip) {
+            i++;
+        }
+        if (!is_removal(&changes[c].data)) {
+            nodes[n]  = changes[c].ip;
+            data[n++] = changes[c].data;
+        }
+        c++;
+    }
+    free(v->greedy_nodes);
+    free(v->greedy_data);
+    v->greedy_nodes = nodes;
+    v->greedy_data  = data;
+    v->num_greedy   = n;
+    return EAR_SUCCESS;
+}
+
+state_t pc_view_apply(pc_view_t *v, powercap_status_t *reply, uint resync)
+{
+    greedy_entry_t *changes;
+    state_t s;
+
+    if (resync) {
+        if (reply->total_nodes < v->full_nodes) {
+            v->failed_resyncs++;
+            v->enabled = (v->failed_resyncs < PC_VIEW_MAX_FAILED_RESYNCS);
+            v->synced  = 0;
+            verbose(VGM_PC, "Powercap resync with %u nodes of %u, deltas %s", reply->total_nodes, v->full_nodes,
+                    (v->enabled) ? "retried" : "disabled");
+            return_msg(EAR_ERROR, "some nodes did not reply the resync");
+        }
+        v->failed_resyncs = 0;
+        v->num_greedy     = 0;
+        v->periods        = 0;
+        v->expected_nodes = reply->total_nodes;
+        memset(&v->totals, 0, sizeof(powercap_status_t));
+    } else if (!v->synced || reply->total_nodes != v->expected_nodes) {
+        verbose(VGM_PC + 1, "Powercap delta with %u nodes of %u, resyncing", reply->total_nodes, v->expected_nodes);
+        v->synced = 0;
+        return_msg(EAR_ERROR, "the powercap delta does not match the view");
+    }
+    if ((changes = sorted_entries(reply)) == NULL) {
+        v->synced = 0;
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    s = merge_changes(v, changes, reply->num_greedy);
+    free(changes);
+    if (state_fail(s)) {
+        v->synced = 0;
+        return s;
+    }
+    /* Sums are modulo 2^32, the differences of the nodes can be negative */
+    v->totals.total_nodes = reply->total_nodes;
+    v->totals.idle_nodes += reply->idle_nodes;
+    v->totals.released += reply->released;
+    v->totals.requested += reply->requested;
+    v->totals.total_idle_power += reply->total_idle_power;
+    v->totals.current_power += reply->current_power;
+    v->totals.total_powercap += reply->total_powercap;
+    v->synced = 1;
+    v->periods++;
+    debug("powercap view epoch %u: %u nodes, %u W, %u greedy (%u changes)", v->epoch, v->totals.total_nodes,
+          v->totals.current_power, v->num_greedy, reply->num_greedy);
+    return EAR_SUCCESS;
+}
+
+powercap_status_t *pc_view_status(pc_view_t *v)
+{
+    size_t size = sizeof(powercap_status_t) + v->num_greedy * (sizeof(int32_t) + sizeof(greedy_bytes_t));
+    powercap_status_t *status;
+    char *data;
+
+    if ((data = calloc(1, size)) == NULL) {
+        return NULL;
+    }
+    status = (powercap_status_t *) data;
+    memcpy(status, &v->totals, sizeof(powercap_status_t));
+    status->num_greedy   = v->num_greedy;
+    status->greedy_nodes = (int32_t *) &data[sizeof(powercap_status_t)];
+    status->greedy_data  = (greedy_bytes_t *) &data[sizeof(powercap_status_t) + v->num_greedy * sizeof(int32_t)];
+    memcpy(status->greedy_nodes, v->greedy_nodes, v->num_greedy * sizeof(int32_t));
+    memcpy(status->greedy_data, v->greedy_data, v->num_greedy * sizeof(greedy_bytes_t));
+    return status;
+}
@@ -0,0 +1,67 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef CLUSTER_PC_VIEW_H
+#define CLUSTER_PC_VIEW_H
+
+#include <common/states.h>
+#include <common/types/generic.h>
+#include <daemon/powercap/powercap_status_conf.h>
+
+/* Running view of the cluster powercap status built from the replies of
+ * EAR_RC_GET_POWERCAP_DELTA. A resync reply replaces the whole view, the
+ * following epochs only carry what changed: the sums are added and the greedy
+ * entries are merged by node IP (the view keeps them sorted). An entry with
+ * nothing requested and no extra power leaves the list.
+ *
+ * The view is valid while every node replies every epoch, which is checked
+ * with the number of nodes replying. Otherwise it gets unsynced and the next
+ * epoch is a resync. A resync with less nodes than the last full status means
+ * some eards do not support deltas, after PC_VIEW_MAX_FAILED_RESYNCS of them
+ * the view gets disabled. EARGM_POWERCAP_DELTAS=0 disables it from the start. */
+
+#define PC_VIEW_RESYNC_PERIODS     20
+#define PC_VIEW_MAX_FAILED_RESYNCS 3
+
+typedef struct pc_view_s {
+    powercap_status_t totals; // greedy pointers not used
+    int32_t *greedy_nodes;
+    greedy_bytes_t *greedy_data;
+    uint num_greedy;
+    uint epoch;
+    uint periods; // Since the last resync
+    uint synced;
+    uint enabled;
+    uint expected_nodes; // Nodes of the last resync
+    uint full_nodes;     // Nodes of the last full status
+    uint failed_resyncs;
+} pc_view_t;
+
+void pc_view_init(pc_view_t *v);
+
+void pc_view_dispose(pc_view_t *v);
+
+/** Returns the epoch to ask for, and sets resync if the nodes have to send their full status. */
+uint pc_view_next(pc_view_t *v, uint *resync);
+
+/** Applies the aggregated reply of the epoch returned by pc_view_next. On errors the view gets unsynced and the status
+ * has to be taken with a full request. */
+state_t pc_view_apply(pc_view_t *v, powercap_status_t *reply, uint resync);
+
+/** Takes note of the nodes replying a full status request, to validate the next resync. */
+void pc_view_full(pc_view_t *v, powercap_status_t *status);
+
+/** Forces a resync in the next epoch. */
+void pc_view_invalidate(pc_view_t *v);
+
+/** Returns a copy of the view with the same layout than the received status, released with a single free. */
+powercap_status_t *pc_view_status(pc_view_t *v);
+
+#endif // CLUSTER_PC_VIEW_H
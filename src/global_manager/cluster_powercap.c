@@ -26,6 +26,8 @@
 #include <daemon/remote_api/eard_rapi.h>
 #include <daemon/remote_api/eard_rapi_internals.h>
 
+#include <global_manager/cluster_pc_alloc.h>
+#include <global_manager/cluster_pc_view.h>
 #include <global_manager/cluster_powercap.h>
 #include <global_manager/log_eargmd.h>
 
@@ -51,8 +53,7 @@ pthread_mutex_t ext_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 uint num_nodes;
 uint actions_executed = 0;
-uint total_req_new, total_req_greedy, req_no_extra, num_no_extra, num_greedy, num_extra, extra_power_alloc,
-    total_extra_power, greedy_allocated;
+uint total_req_new, total_req_greedy, num_greedy, num_extra, extra_power_alloc, total_extra_power, greedy_allocated;
 cluster_powercap_status_t *my_cluster_power_status;
 powercap_opt_t cluster_options;
 extern uint policy;
@@ -62,6 +63,8 @@ extern char host[GENERIC_NAME];
 static uint must_send_pc_options;
 static ulong current_extra_power;
 static uint total_free;
+static pc_alloc_ops_t alloc_ops;
+static pc_view_t pc_view;
 #define min(a, b) (a < b ? a : b)
 
 void check_powercap_actions(uint cluster_powercap);
@@ -100,8 +103,6 @@ void aggregate_data(powercap_status_t *cs)
     int i;
     total_req_greedy  = 0;
     total_extra_power = 0;
-    req_no_extra      = 0;
-    num_no_extra      = 0;
     num_greedy        = 0;
     num_extra         = 0;
     extra_power_alloc = 0;
@@ -114,10 +115,6 @@ void aggregate_data(powercap_status_t *cs)
         }
         if (cs->greedy_data[i].requested)
             num_greedy++;
-        if ((cs->greedy_data[i].requested) && (!cs->greedy_data[i].extra_power)) {
-            req_no_extra += cs->greedy_data[i].requested;
-            num_no_extra++;
-        }
     }
 }
 
@@ -142,7 +139,6 @@ void print_powercap_opt(powercap_opt_t *opt)
 void allocate_free_power_to_greedy_nodes(cluster_powercap_status_t *cluster_status, powercap_opt_t *cluster_options,
                                          uint *total_free)
 {
-    int i, more_power;
     uint pending = *total_free;
     if (num_greedy == 0) {
         debug("NO greedy nodes, returning");
@@ -154,81 +150,16 @@ void allocate_free_power_to_greedy_nodes(cluster_powercap_status_t *cluster_stat
     }
     must_send_pc_options = 1;
     debug("allocate_free_power_to_greedy_nodes----------------");
-    verbose(VGM_PC + 1, "Total extra power for nodes with NO current extra power %u W, %u nodes", req_no_extra,
-            num_no_extra);
-    verbose(VGM_PC + 1, "Nodes with extra power already allocated %u", num_greedy);
-    greedy_allocated = 0;
-    if (num_no_extra > 0) {
-        if (req_no_extra < pending)
-            more_power = -1;
-        else
-            more_power = pending / num_no_extra;
-        verbose(VGM_PC + 1, "STAGE_1-Allocating %d watts to new greedy nodes first (-1 => alloc=req)", more_power);
-        for (i = 0; i < cluster_status->num_greedy; i++) {
-            if ((cluster_status->greedy_data[i].requested) && (!cluster_status->greedy_data[i].extra_power)) {
-                if (more_power < 0)
-                    cluster_options->extra_power[i] = cluster_status->greedy_data[i].requested;
-                else
-                    cluster_options->extra_power[i] = min(more_power, cluster_status->greedy_data[i].requested);
-                pending -= cluster_options->extra_power[i];
-                greedy_allocated += cluster_options->extra_power[i];
-            }
-        }
-    }
-    /* If there is pending power to allocate */
-    verbose(VGM_PC + 1, "STAGE-2 allocating %uW to the rest of greedy nodes", pending);
-    if (pending) {
-        verbose(VGM_PC + 1, "Allocating %u watts to greedy nodes ", pending);
-        more_power = pending / num_greedy;
-        for (i = 0; i < cluster_status->num_greedy; i++) {
-            if ((cluster_status->greedy_data[i].requested) && (!cluster_options->extra_power[i])) {
-                cluster_options->extra_power[i] = min(cluster_status->greedy_data[i].requested, more_power);
-                pending -= cluster_options->extra_power[i];
-                greedy_allocated += cluster_options->extra_power[i];
-            }
-        }
-    }
-    *total_free = pending;
+    verbose(VGM_PC + 1, "Allocating %u W to %u greedy nodes (%s)", pending, num_greedy, alloc_ops.name);
+    alloc_ops.grant(cluster_status, cluster_options, total_free);
+    greedy_allocated = pending - *total_free;
 }
 
 /* This function is executed when there is not enough power for new running nodes */
 void reduce_allocation(cluster_powercap_status_t *cs, powercap_opt_t *cluster_options, uint min_reduction)
 {
-    int i = 0;
-    uint red1, red, red_node;
-    int new_extra;
-    if (num_extra == 0) {
-        error("We need to reallocated power and there is no extra power ");
-        return;
-    }
-    red_node = min_reduction / num_extra;
-    verbose(VGM_PC + 1, "SEQ reduce_allocation implementation avg red=%uW", red_node);
-    debug("ROUND 1- reducing avg power ");
-    while ((min_reduction > 0) && (i < cs->num_greedy)) {
-        if (cs->greedy_data[i].extra_power) {
-            red1      = min(red_node, cs->greedy_data[i].extra_power);
-            red       = min(red1, min_reduction);
-            new_extra = -red;
-            verbose(VGM_PC + 1, "%sreducing %d W to node %d %s", COL_RED, new_extra, i, COL_CLR);
-            cluster_options->extra_power[i] = new_extra;
-            min_reduction -= red;
-        }
-        i++;
-    }
-    debug("ROUND 2- Reducing remaining power ");
-    i = 0;
-    while ((min_reduction > 0) && (i < cs->num_greedy)) {
-        /* cluster_options->extra_power[i] is a negative value */
-        if ((cs->greedy_data[i].extra_power + cluster_options->extra_power[i]) > 0) {
-            red1      = cs->greedy_data[i].extra_power + cluster_options->extra_power[i];
-            red       = min(red1, min_reduction);
-            new_extra = -red;
-            verbose(VGM_PC + 1, "%sreducing %d W to node %d %s", COL_RED, new_extra, i, COL_CLR);
-            cluster_options->extra_power[i] += new_extra;
-            min_reduction -= red;
-        }
-        i++;
-    }
+    verbose(VGM_PC + 1, "Reducing %u W of extra power from %u nodes (%s)", min_reduction, num_extra, alloc_ops.name);
+    alloc_ops.reduce(cs, cluster_options, min_reduction);
 }
 
 /* This function is executed when there is enough power for new running nodes but not for all the greedy nodes */
@@ -546,6 +477,18 @@ void cluster_powercap_init(cluster_conf_t *cc)
     if (current_cluster_powercap == 0)
         return;
 
+    if (state_fail(pc_alloc_load(ear_getenv("EARGM_POWERCAP_ALLOC"), &alloc_ops))) {
+        warning("Unknown powercap allocation engine %s, using the default", ear_getenv("EARGM_POWERCAP_ALLOC"));
+        pc_alloc_load(NULL, &alloc_ops);
+    }
+    verbose(VGM_PC, "Powercap allocation engine: %s", alloc_ops.name);
+
+    pc_view_init(&pc_view);
+    if (ear_getenv("EARGM_POWERCAP_DELTAS") != NULL && atoi(ear_getenv("EARGM_POWERCAP_DELTAS")) == 0) {
+        pc_view.enabled = 0;
+    }
+    verbose(VGM_PC, "Incremental powercap status: %s", (pc_view.enabled) ? "enabled" : "disabled");
+
     /* This thread accepts external commands */
     if ((ret = pthread_create(&cluster_powercap_th, NULL, eargm_powercap_th, NULL))) {
         errno = ret;
@@ -640,11 +583,41 @@ void write_shared_data(ulong current_power, ulong freeable_power, ulong requeste
     pthread_mutex_unlock(&ext_mutex);
 }
 
+/* Gets the cluster status from the incremental view. The first period and
+ * any period where the view is not valid use the full status request. */
+static state_t get_cluster_power_status(powercap_status_t **status, int release_power)
+{
+    powercap_status_t *reply;
+    uint epoch, resync;
+    state_t s;
+
+    if (pc_view.enabled && pc_view.full_nodes) {
+        epoch = pc_view_next(&pc_view, &resync);
+        if (state_ok(ear_get_powercap_delta(&my_cluster_conf, &reply, release_power, epoch, resync, nodes,
+                                            num_eargm_nodes))) {
+            s = pc_view_apply(&pc_view, reply, resync);
+            free(reply);
+            if (state_ok(s) && (*status = pc_view_status(&pc_view)) != NULL) {
+                return EAR_SUCCESS;
+            }
+        } else {
+            pc_view_invalidate(&pc_view);
+        }
+        /* Nodes replying have already released their idle power */
+        release_power = 0;
+    }
+    if (state_fail(ear_get_powercap_status(&my_cluster_conf, status, release_power, nodes, num_eargm_nodes))) {
+        return EAR_ERROR;
+    }
+    pc_view_full(&pc_view, *status);
+    return EAR_SUCCESS;
+}
+
 void cluster_power_monitor()
 {
     debug("%sGlobal POWER monitoring INIT----%s", COL_BLU, COL_CLR);
     /* We use this function for now, we must use a new light one */
-    if (state_fail(ear_get_powercap_status(&my_cluster_conf, &my_cluster_power_status, 1, nodes, num_eargm_nodes))) {
+    if (state_fail(get_cluster_power_status(&my_cluster_power_status, 1))) {
         verbose(VGM_PC + 1, "ear_get_powercap_status in cluster_power_monitor returns EAR_ERROR");
         write_shared_data(0, 0, 0);
         return;
@@ -673,7 +646,7 @@ void cluster_power_monitor()
 void cluster_hard_powercap()
 {
     debug("%sSTART cluster_check_powercap---------%s", COL_BLU, COL_CLR);
-    if (state_fail(ear_get_powercap_status(&my_cluster_conf, &my_cluster_power_status, 1, nodes, num_eargm_nodes))) {
+    if (state_fail(get_cluster_power_status(&my_cluster_power_status, 1))) {
         verbose(VGM_PC + 1, "ear_get_powercap_status in cluster_hard_powercap returns EAR_ERROR");
         write_shared_data(0, 0, 0);
         return;
@@ -139,7 +139,7 @@ void *eargm_server_api(void *p)
             error(" wait_for_client returns error");
         } else {
             process_remote_requests(eargm_client);
-            close(eargm_client);
+            remote_disconnect_fd(eargm_client);
         }
     } while (1);
     verbose(VGM, "exiting");
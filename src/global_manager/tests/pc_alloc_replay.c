@@ -0,0 +1,207 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Replays cluster powercap status snapshots against the allocation engines.
+//
+// A snapshot starts with a "grant <watts>" or "reduce <watts>" line, followed
+// by one "<requested> <extra_power>" line per greedy node (the greedy_data of
+// a powercap_status_t). Lines starting with # are ignored. Without a file,
+// random snapshots of 10000 nodes are generated.
+//
+// For grants it prints the power left unallocated while some node still
+// requested power (stranded), the lowest extra power (previous plus granted)
+// of the requesting nodes and the average fraction of the requests granted. For reductions, the highest extra power
+// left in a node. Also the time per decision.
+//
+//     ./pc_alloc_replay [snapshots]
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <global_manager/cluster_pc_alloc.h>
+
+#define RANDOM_NODES     10000
+#define RANDOM_SNAPSHOTS 20
+#define REPEATS          20
+
+typedef struct snapshot_s {
+    int grant; // 0 is a reduction
+    uint watts;
+    powercap_status_t cs;
+} snapshot_t;
+
+static snapshot_t *snaps;
+static uint num_snaps;
+
+static snapshot_t *new_snapshot(int grant, uint watts, uint nodes)
+{
+    snapshot_t *s;
+
+    snaps = realloc(snaps, (num_snaps + 1) * sizeof(snapshot_t));
+    s     = &snaps[num_snaps++];
+    memset(s, 0, sizeof(snapshot_t));
+    s->grant                = grant;
+    s->watts                = watts;
+    s->cs.greedy_data       = calloc(nodes, sizeof(greedy_bytes_t));
+    s->cs.greedy_nodes      = calloc(nodes, sizeof(int32_t));
+    s->cs.num_greedy        = 0;
+    s->cs.total_nodes       = nodes;
+    return s;
+}
+
+static void load_snapshots(char *path)
+{
+    uint capacity = 0, watts, req, extra;
+    snapshot_t *s = NULL;
+    char line[256];
+    FILE *fd;
+
+    if ((fd = fopen(path, "r")) == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), fd) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "grant %u", &watts) == 1 || sscanf(line, "reduce %u", &watts) == 1) {
+            capacity = 1024;
+            s        = new_snapshot(line[0] == 'g', watts, capacity);
+        } else if (s != NULL && sscanf(line, "%u %u", &req, &extra) == 2) {
+            if (s->cs.num_greedy == capacity) {
+                capacity *= 2;
+                s->cs.greedy_data  = realloc(s->cs.greedy_data, capacity * sizeof(greedy_bytes_t));
+                s->cs.greedy_nodes = realloc(s->cs.greedy_nodes, capacity * sizeof(int32_t));
+            }
+            s->cs.greedy_data[s->cs.num_greedy].requested   = req;
+            s->cs.greedy_data[s->cs.num_greedy].extra_power = extra;
+            s->cs.greedy_nodes[s->cs.num_greedy]            = s->cs.num_greedy;
+            s->cs.num_greedy++;
+        }
+    }
+    fclose(fd);
+}
+
+static void random_snapshots()
+{
+    ullong total;
+    snapshot_t *s;
+    uint i, n;
+
+    srand(1234);
+    for (i = 0; i < RANDOM_SNAPSHOTS; i++) {
+        s     = new_snapshot(i % 2 == 0, 0, RANDOM_NODES);
+        total = 0;
+        for (n = 0; n < RANDOM_NODES; n++) {
+            // Some nodes are not greedy, some have extra power from previous periods
+            s->cs.greedy_data[n].requested   = (rand() % 3) ? rand() % 256 : 0;
+            s->cs.greedy_data[n].extra_power = (rand() % 2) ? rand() % 300 : 0;
+            s->cs.greedy_nodes[n]            = n;
+            total += (s->grant) ? s->cs.greedy_data[n].requested : s->cs.greedy_data[n].extra_power;
+        }
+        s->cs.num_greedy = RANDOM_NODES;
+        // Between the 20% and the 80% of what could be granted or reduced
+        s->watts = total * (20 + rand() % 60) / 100;
+    }
+}
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void replay(char *name)
+{
+    double us = 0.0, ratio, sum_ratio, avg_ratio = 0.0, stranded = 0.0;
+    uint grants = 0, reductions = 0, max_extra = 0, min_extra = UINT_MAX, errors = 0;
+    uint free_power, left, requesting, remaining, extra;
+    pc_alloc_ops_t ops;
+    powercap_opt_t opt;
+    ullong total;
+    snapshot_t *s;
+    double start;
+    uint i, n, r;
+
+    pc_alloc_load(name, &ops);
+    for (i = 0; i < num_snaps; i++) {
+        s               = &snaps[i];
+        opt.num_greedy  = s->cs.num_greedy;
+        opt.extra_power = calloc(s->cs.num_greedy + 1, sizeof(int32_t));
+        for (r = 0; r < REPEATS; r++) {
+            memset(opt.extra_power, 0, s->cs.num_greedy * sizeof(int32_t));
+            free_power = s->watts;
+            start      = now_us();
+            if (s->grant) {
+                ops.grant(&s->cs, &opt, &free_power);
+            } else {
+                ops.reduce(&s->cs, &opt, s->watts);
+            }
+            us += now_us() - start;
+        }
+        total = 0;
+        if (s->grant) {
+            grants++;
+            left       = 0;
+            requesting = 0;
+            sum_ratio  = 0.0;
+            for (n = 0; n < s->cs.num_greedy; n++) {
+                total += opt.extra_power[n];
+                errors += (opt.extra_power[n] < 0 || opt.extra_power[n] > s->cs.greedy_data[n].requested);
+                if (s->cs.greedy_data[n].requested) {
+                    ratio = (double) opt.extra_power[n] / s->cs.greedy_data[n].requested;
+                    extra = s->cs.greedy_data[n].extra_power + opt.extra_power[n];
+                    min_extra = (extra < min_extra) ? extra : min_extra;
+                    sum_ratio += ratio;
+                    requesting++;
+                    left += (opt.extra_power[n] < s->cs.greedy_data[n].requested);
+                }
+            }
+            errors += (total + free_power != s->watts);
+            // Power not given while some node still wanted it
+            stranded += (left) ? free_power : 0;
+            avg_ratio += sum_ratio / ((requesting) ? requesting : 1);
+        } else {
+            reductions++;
+            for (n = 0; n < s->cs.num_greedy; n++) {
+                total += -opt.extra_power[n];
+                remaining = s->cs.greedy_data[n].extra_power + opt.extra_power[n];
+                errors += (opt.extra_power[n] > 0 || remaining > s->cs.greedy_data[n].extra_power);
+                max_extra = (remaining > max_extra) ? remaining : max_extra;
+            }
+            errors += (total < s->watts && max_extra > 0);
+        }
+        free(opt.extra_power);
+    }
+    printf("%-10s %u grants: stranded %8.1lf W/snapshot, min extra %3u W, avg %.2lf of the request | %u reductions: max "
+           "extra left %3u W | %8.1lf us/decision | %u errors\n",
+           name, grants, (grants) ? stranded / grants : 0.0, min_extra, (grants) ? avg_ratio / grants : 0.0, reductions,
+           max_extra, us / (num_snaps * REPEATS), errors);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        load_snapshots(argv[1]);
+    } else {
+        random_snapshots();
+    }
+    if (num_snaps == 0) {
+        printf("no snapshots\n");
+        return 1;
+    }
+    printf("%u snapshots\n", num_snaps);
+    replay(PC_ALLOC_LEGACY);
+    replay(PC_ALLOC_WATERFILL);
+    return 0;
+}
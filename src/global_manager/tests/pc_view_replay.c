@@ -0,0 +1,203 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Replays random powercap status periods against the incremental view.
+//
+// Each period some nodes change their power, powercap and greedy state. The
+// nodes compute their deltas like the eards do for EAR_RC_GET_POWERCAP_DELTA
+// and the aggregated reply is applied to the view, which is compared with the
+// full status of the same period. It prints the greedy entries sent with the
+// full status and with deltas, and the mismatches (there should be none).
+//
+//     ./pc_view_replay [nodes] [periods] [changing %]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/messaging/msg_conf.h>
+#include <global_manager/cluster_pc_view.h>
+
+typedef struct node_s {
+    powercap_status_t now;
+    uint greedy;
+    greedy_bytes_t data;
+    // Delta state
+    powercap_status_t base;
+    uint base_greedy;
+    greedy_bytes_t base_data;
+    uint epoch;
+    uint synced;
+} node_t;
+
+static node_t *cluster;
+static uint num_nodes;
+
+static void add_entry(powercap_status_t *s, int32_t ip, greedy_bytes_t *data)
+{
+    s->greedy_nodes                 = realloc(s->greedy_nodes, (s->num_greedy + 1) * sizeof(int32_t));
+    s->greedy_data                  = realloc(s->greedy_data, (s->num_greedy + 1) * sizeof(greedy_bytes_t));
+    s->greedy_nodes[s->num_greedy]  = ip;
+    s->greedy_data[s->num_greedy++] = *data;
+}
+
+static void add_sums(powercap_status_t *s, powercap_status_t *a, powercap_status_t *b)
+{
+    s->idle_nodes += a->idle_nodes - b->idle_nodes;
+    s->released += a->released - b->released;
+    s->requested += a->requested - b->requested;
+    s->total_idle_power += a->total_idle_power - b->total_idle_power;
+    s->current_power += a->current_power - b->current_power;
+    s->total_powercap += a->total_powercap - b->total_powercap;
+}
+
+static void full_status(powercap_status_t *s)
+{
+    powercap_status_t zero = {0};
+    uint i;
+
+    memset(s, 0, sizeof(powercap_status_t));
+    for (i = 0; i < num_nodes; i++) {
+        s->total_nodes++;
+        add_sums(s, &cluster[i].now, &zero);
+        if (cluster[i].greedy) {
+            add_entry(s, i, &cluster[i].data);
+        }
+    }
+}
+
+static void delta_status(powercap_status_t *s, uint epoch, uint resync, uint lost)
+{
+    greedy_bytes_t removed = {0};
+    node_t *n;
+    uint i;
+
+    memset(s, 0, sizeof(powercap_status_t));
+    for (i = 0; i < num_nodes; i++) {
+        n = &cluster[i];
+        if (i == lost) {
+            // The node computes the delta but the reply gets lost
+            n->base        = n->now;
+            n->base_greedy = n->greedy;
+            n->base_data   = n->data;
+            n->epoch       = epoch;
+            continue;
+        }
+        if (!resync && (!n->synced || epoch != n->epoch + 1)) {
+            s->total_nodes += PC_DELTA_UNSYNCED;
+            continue;
+        }
+        if (resync) {
+            memset(&n->base, 0, sizeof(powercap_status_t));
+            n->base_greedy = 0;
+        }
+        s->total_nodes++;
+        add_sums(s, &n->now, &n->base);
+        if (n->greedy && (!n->base_greedy || memcmp(&n->data, &n->base_data, sizeof(greedy_bytes_t)))) {
+            add_entry(s, i, &n->data);
+        } else if (!n->greedy && n->base_greedy) {
+            add_entry(s, i, &removed);
+        }
+        n->base        = n->now;
+        n->base_greedy = n->greedy;
+        n->base_data   = n->data;
+        n->epoch       = epoch;
+        n->synced      = 1;
+    }
+}
+
+static void change_nodes(uint percent)
+{
+    node_t *n;
+    uint i;
+
+    for (i = 0; i < num_nodes; i++) {
+        if ((uint) (rand() % 100) >= percent) {
+            continue;
+        }
+        n                     = &cluster[i];
+        n->now.idle_nodes     = (rand() % 10 == 0);
+        n->now.current_power  = 150 + rand() % 300;
+        n->now.total_powercap = 300 + rand() % 100;
+        n->greedy             = (rand() % 4 == 0);
+        n->data.requested     = (n->greedy) ? 1 + rand() % 100 : 0;
+        n->data.extra_power   = (n->greedy) ? rand() % 100 : 0;
+        n->data.stress        = rand() % 100;
+    }
+}
+
+static uint compare(powercap_status_t *full, powercap_status_t *view)
+{
+    uint i;
+
+    if (full->total_nodes != view->total_nodes || full->idle_nodes != view->idle_nodes ||
+        full->current_power != view->current_power || full->total_powercap != view->total_powercap) {
+        return 1;
+    }
+    // The full status is in IP order, the same than the view
+    if (full->num_greedy != view->num_greedy) {
+        return 1;
+    }
+    for (i = 0; i < full->num_greedy; i++) {
+        if (full->greedy_nodes[i] != view->greedy_nodes[i] ||
+            memcmp(&full->greedy_data[i], &view->greedy_data[i], sizeof(greedy_bytes_t))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    ullong full_entries = 0, delta_entries = 0;
+    uint periods, percent, p, epoch, resync;
+    uint mismatches = 0, resyncs = 0;
+    powercap_status_t full, reply, *view_status;
+    pc_view_t view;
+
+    num_nodes = (argc > 1) ? atoi(argv[1]) : 10000;
+    periods   = (argc > 2) ? atoi(argv[2]) : 200;
+    percent   = (argc > 3) ? atoi(argv[3]) : 5;
+    cluster   = calloc(num_nodes, sizeof(node_t));
+
+    srand(1234);
+    pc_view_init(&view);
+    change_nodes(100);
+    full_status(&full);
+    pc_view_full(&view, &full);
+    free(full.greedy_nodes);
+    free(full.greedy_data);
+
+    for (p = 0; p < periods; p++) {
+        change_nodes(percent);
+        full_status(&full);
+        epoch = pc_view_next(&view, &resync);
+        resyncs += resync;
+        // A reply lost in the tree every 50 periods
+        delta_status(&reply, epoch, resync, (p % 50 == 25) ? (uint) (rand() % num_nodes) : num_nodes);
+        full_entries += full.num_greedy;
+        delta_entries += reply.num_greedy;
+        if (state_ok(pc_view_apply(&view, &reply, resync))) {
+            view_status = pc_view_status(&view);
+            mismatches += compare(&full, view_status);
+            free(view_status);
+        }
+        free(full.greedy_nodes);
+        free(full.greedy_data);
+        free(reply.greedy_nodes);
+        free(reply.greedy_data);
+    }
+    printf("%u nodes, %u periods, %u%% changing: greedy entries full %llu delta %llu (%.1lf%%), %u resyncs, %u "
+           "mismatches\n",
+           num_nodes, periods, percent, full_entries, delta_entries, 100.0 * delta_entries / full_entries, resyncs,
+           mismatches);
+    pc_view_dispose(&view);
+    free(cluster);
+    return (mismatches != 0);
+}
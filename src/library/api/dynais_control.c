@@ -0,0 +1,207 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <string.h>
+
+#include <common/system/time.h>
+#include <library/api/dynais_control.h>
+#include <library/common/verbose_lib.h>
+
+#define CTL_TIMED      16   // One of each CTL_TIMED calls feeding DynAIS is timed
+#define CTL_TIMED_MIN  8    // Timed calls needed to update the cost estimation
+#define CTL_SAMPLE_MAX 64   // Beyond that sampling the loops are hardly detected
+#define CTL_FINER      0.5  // Fraction of the budget the finer mode has to be projected under
+#define CTL_ALPHA      0.25 // Weight of the last window in the cost estimation
+
+static const char *mode_names[DYNAIS_MODES] = {"full", "sampled", "periodic"};
+
+static uint mode;
+static uint sample_every;
+static uint sample_skip;
+static double budget;    // Fraction of the cycles
+static double fed_cost;  // Cycles per call feeding DynAIS
+static double overhead;  // Of the last window
+static ullong win_start; // In cycles
+static ullong win_calls;
+static ullong win_fed;
+static ullong win_timed;
+static ullong win_timed_cycles;
+static timestamp_t mode_start;
+static ullong mode_time[DYNAIS_MODES]; // In usecs
+static uint switches;
+
+#if TEST
+ullong dynais_ctl_test_cycles; // Advanced by the tests instead of the time stamp counter
+#endif
+
+static ullong cycles_read()
+{
+#if TEST
+    return dynais_ctl_test_cycles;
+#elif defined(__x86_64__)
+    uint lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((ullong) hi << 32) | lo;
+#elif defined(__aarch64__)
+    ullong v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    timestamp_t ts;
+    timestamp_getfast(&ts);
+    return timestamp_convert(&ts, TIME_NSECS);
+#endif
+}
+
+static void window_reset()
+{
+    win_start        = cycles_read();
+    win_calls        = 0;
+    win_fed          = 0;
+    win_timed        = 0;
+    win_timed_cycles = 0;
+}
+
+static void mode_change(uint new_mode, uint new_sample_every)
+{
+    timestamp_t now;
+
+    if (new_mode != mode) {
+        timestamp_getfast(&now);
+        mode_time[mode] += timestamp_diff(&now, &mode_start, TIME_USECS);
+        mode_start = now;
+        switches++;
+    }
+    verbose_master(2, "DynAIS mode %s -> %s (sampling 1/%u -> 1/%u), overhead %.3lf%%", mode_names[mode],
+                   mode_names[new_mode], sample_every, new_sample_every, overhead * 100.0);
+    mode         = new_mode;
+    sample_every = new_sample_every;
+    sample_skip  = 0;
+}
+
+void dynais_ctl_init(double budget_perc)
+{
+    mode         = DYNAIS_MODE_FULL;
+    sample_every = 1;
+    sample_skip  = 0;
+    budget       = budget_perc / 100.0;
+    fed_cost     = 0.0;
+    overhead     = 0.0;
+    switches     = 0;
+    memset(mode_time, 0, sizeof(mode_time));
+    timestamp_getfast(&mode_start);
+    window_reset();
+}
+
+uint dynais_ctl_feeds()
+{
+    win_calls++;
+    if (mode == DYNAIS_MODE_PERIODIC) {
+        return 0;
+    }
+    if (++sample_skip < sample_every) {
+        return 0;
+    }
+    sample_skip = 0;
+    win_fed++;
+    return 1;
+}
+
+ullong dynais_ctl_begin()
+{
+    if ((win_fed % CTL_TIMED) != 0) {
+        return 0;
+    }
+    return cycles_read();
+}
+
+void dynais_ctl_end(ullong start)
+{
+    if (start == 0) {
+        return;
+    }
+    win_timed++;
+    win_timed_cycles += cycles_read() - start;
+}
+
+uint dynais_ctl_check()
+{
+    ullong window = cycles_read() - win_start;
+    double finer;
+    uint coarser;
+
+    if (window == 0 || win_calls == 0) {
+        return mode;
+    }
+    // Each timed call takes two time stamps, a cheap cost estimation
+    if (win_timed >= CTL_TIMED_MIN) {
+        if (fed_cost == 0.0) {
+            fed_cost = (double) win_timed_cycles / win_timed;
+        } else {
+            fed_cost = CTL_ALPHA * ((double) win_timed_cycles / win_timed) + (1.0 - CTL_ALPHA) * fed_cost;
+        }
+    }
+    overhead = fed_cost * win_fed / window;
+
+    if (overhead > budget && mode != DYNAIS_MODE_PERIODIC) {
+        // The sampling needed to be under the budget, rounded to the next power of 2
+        for (coarser = sample_every * 2; coarser <= CTL_SAMPLE_MAX && coarser * budget < sample_every * overhead;
+             coarser *= 2)
+            ;
+        if (coarser > CTL_SAMPLE_MAX) {
+            mode_change(DYNAIS_MODE_PERIODIC, CTL_SAMPLE_MAX);
+        } else {
+            mode_change(DYNAIS_MODE_SAMPLED, coarser);
+        }
+    } else if (mode != DYNAIS_MODE_FULL && fed_cost > 0.0) {
+        // Halving the sampling doubles the calls feeding DynAIS
+        if (mode == DYNAIS_MODE_PERIODIC) {
+            finer = fed_cost * win_calls / (CTL_SAMPLE_MAX * (double) window);
+        } else {
+            finer = overhead * 2.0;
+        }
+        if (finer < budget * CTL_FINER) {
+            if (mode == DYNAIS_MODE_PERIODIC) {
+                mode_change(DYNAIS_MODE_SAMPLED, CTL_SAMPLE_MAX);
+            } else if (sample_every > 2) {
+                mode_change(DYNAIS_MODE_SAMPLED, sample_every / 2);
+            } else {
+                mode_change(DYNAIS_MODE_FULL, 1);
+            }
+        }
+    }
+    window_reset();
+    return mode;
+}
+
+void dynais_ctl_set(uint new_mode)
+{
+    if (new_mode < DYNAIS_MODES && new_mode != mode) {
+        mode_change(new_mode, (new_mode == DYNAIS_MODE_FULL) ? 1 : sample_every);
+    }
+}
+
+void dynais_ctl_verbose(int level)
+{
+    ullong usecs[DYNAIS_MODES];
+    timestamp_t now;
+    uint m;
+
+    timestamp_getfast(&now);
+    for (m = 0; m < DYNAIS_MODES; m++) {
+        usecs[m] = mode_time[m];
+    }
+    usecs[mode] += timestamp_diff(&now, &mode_start, TIME_USECS);
+    verbose(level,
+            "DynAIS interception: %.2lf s full, %.2lf s sampled, %.2lf s periodic, %u switches, last overhead %.3lf%% "
+            "(budget %.2lf%%)",
+            usecs[DYNAIS_MODE_FULL] / 1000000.0, usecs[DYNAIS_MODE_SAMPLED] / 1000000.0,
+            usecs[DYNAIS_MODE_PERIODIC] / 1000000.0, switches, overhead * 100.0, budget * 100.0);
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _EAR_DYNAIS_CONTROL_H
+#define _EAR_DYNAIS_CONTROL_H
+
+#include <common/types/generic.h>
+
+/* Keeps the overhead of the MPI calls interception under a budget. The cost
+ * of the calls feeding DynAIS is measured with the time stamp counter in one
+ * of each few of them, and every check the cycles spent in DynAIS are compared
+ * with the cycles elapsed. When the overhead exceeds the budget, only one of
+ * each N calls feeds DynAIS, N growing in powers of 2, and when N would be too
+ * large to keep the loop structure, EARL goes to the periodic mode. The way
+ * back is taken one step at a time and only when the overhead projected for
+ * the finer mode is below half the budget, so the mode does not oscillate. */
+
+#define DYNAIS_MODE_FULL     0 // Every MPI call feeds DynAIS
+#define DYNAIS_MODE_SAMPLED  1 // One of each N calls feeds DynAIS
+#define DYNAIS_MODE_PERIODIC 2 // DynAIS is not fed, the policy is applied periodically
+#define DYNAIS_MODES         3
+
+/** Starts in DYNAIS_MODE_FULL. The budget is a percentage of the application time. */
+void dynais_ctl_init(double budget);
+
+/** Counts an intercepted MPI call and returns 1 if it has to feed DynAIS. */
+uint dynais_ctl_feeds();
+
+/** Returns the current time stamp if the DynAIS call that follows has to be timed, 0 otherwise. */
+ullong dynais_ctl_begin();
+
+void dynais_ctl_end(ullong start);
+
+/** Updates the overhead estimation and returns the mode the next calls have to be intercepted in. */
+uint dynais_ctl_check();
+
+/** Sets the mode when EARL changes it for other reasons. */
+void dynais_ctl_set(uint mode);
+
+/** Verboses the time spent in each mode and the last overhead estimated. */
+void dynais_ctl_verbose(int level);
+
+#endif // _EAR_DYNAIS_CONTROL_H
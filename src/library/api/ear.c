@@ -64,6 +64,7 @@
 #include <management/cpufreq/frequency.h>
 
 #include <library/api/clasify.h>
+#include <library/api/dynais_control.h>
 #include <library/api/eard_dummy.h>
 #include <library/api/mpi_support.h>
 #include <library/common/externs.h>
@@ -258,7 +259,6 @@ uint per_proc_verb_file = 0;
 
 uint exclusive = 1;
 ear_classify_t phases_limits;
-uint limit_exceeded = 0;
 
 extern ulong perf_accuracy_min_time;
 static uint exiting = 0;
@@ -1209,6 +1209,9 @@ void update_configuration()
 
     check_every = system_conf->lib_info.check_every;
 
+    char *cdynais_budget = ear_getenv("EAR_MAX_DYNAIS_OVERHEAD");
+    dynais_ctl_init((cdynais_budget != NULL) ? atof(cdynais_budget) : MAX_DYNAIS_OVERHEAD);
+
 #if FAKE_LEARNING
     ear_whole_app = 1;
 #else
@@ -2474,6 +2477,11 @@ void ear_finalize(int exit_status)
         } else {
             report_mpi_application_data(2, &application);
         }
+#if MPI
+        if (module_mpi_is_enabled() && (masters_info.my_master_rank >= 0)) {
+            dynais_ctl_verbose((masters_info.my_master_rank == 0) ? 1 : 2);
+        }
+#endif
     }
     // Closing any remaining loop
     if (loop_with_signature) {
@@ -2524,12 +2532,20 @@ void ear_finalize(int exit_status)
 
 #if MPI
 
-void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest);
-void ear_mpi_call_dynais_off(mpi_call call_type, p2i buf, p2i dest);
+void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest, ulong mix);
+void ear_mpi_call_dynais_off(mpi_call call_type, p2i buf, p2i dest, ulong mix);
+
+/* The DynAIS event. The mix is 0 unless EAR_DYNAIS_EVENT_MIX is set, so by
+ * default the event is the buffer and destination one. */
+static inline ulong mpi_call_event(mpi_call call_type, p2i buf, p2i dest, ulong mix)
+{
+    return (ulong) (((((buf >> 5) ^ dest) ^ mix) << 5) | call_type);
+}
 
 static void _go_to_time_guided(int new_ear_guided)
 {
     ear_periodic_mode = PERIODIC_MODE_ON;
+    dynais_ctl_set(DYNAIS_MODE_PERIODIC);
 
     if (ear_guided != new_ear_guided) {
         if (earl_monitor->time_burst < earl_monitor->time_relax) {
@@ -2549,7 +2565,52 @@ static void _go_to_time_guided(int new_ear_guided)
     }
 }
 
-void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest)
+/* The policy is applied each mpi_calls_per_second calls, as if they were an iteration */
+static void _go_to_periodic(ulong event)
+{
+    ear_periodic_mode    = PERIODIC_MODE_ON;
+    mpi_calls_per_second = (uint) avg_mpi_calls_per_second();
+    if (mpi_calls_per_second == 0) {
+        mpi_calls_per_second = check_every;
+    }
+
+    traces_start();
+
+    verbose_master(EARL_GUIDED_LVL, "Going to periodic mode: mpi calls in period %u.", mpi_calls_per_second);
+
+    if (in_loop) {
+        traces_end_period(ear_my_rank, my_node_id);
+        states_end_period(ear_iterations);
+        in_loop = 0;
+    }
+    ear_iterations = 0;
+
+    states_begin_period(my_id, event, (ulong) lib_period, 1);
+    states_new_iteration(my_id, 1, ear_iterations, 1, 1, lib_period, 0);
+}
+
+/* DynAIS detects the loops again */
+static void _go_to_dynais()
+{
+    ear_periodic_mode = PERIODIC_MODE_OFF;
+
+    verbose_master(EARL_GUIDED_LVL, "Going back to DynAIS mode after %u periodic iterations.", ear_iterations);
+
+    states_end_period(ear_iterations);
+    ear_iterations     = 0;
+    in_loop            = 0;
+    mpi_calls_per_loop = 0;
+}
+
+static uint dynais_timeout_passed()
+{
+    timestamp_t curr_time;
+
+    timestamp_getfast(&curr_time);
+    return (timestamp_diff(&curr_time, &ear_application_time_init, TIME_SECS) >= dynais_timeout);
+}
+
+void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest, ulong mix)
 {
 
     if (!ear_lib_initialized) {
@@ -2584,7 +2645,7 @@ void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest)
 
     /* The learning phase avoids EAR internals. ear_whole_app is set to 1 when learning-phase is set */
     if (!ear_whole_app) {
-        ulong ear_event_l = (ulong) ((((buf >> 5) ^ dest) << 5) | call_type);
+        ulong ear_event_l = mpi_call_event(call_type, buf, dest, mix);
 
         // unsigned short ear_event_s = dynais_sample_convert(ear_event_l);
 
@@ -2601,90 +2662,51 @@ void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest)
                     case DYNAIS_ENABLED: {
 // DYNAIS_ENABLED is only enabled for MPI applications
 #if MPI
-                        /* First time EAR computes a signature using dynais, check_periodic_mode is set to 0 */
-                        if (check_periodic_mode == 0) {
-                            ear_mpi_call_dynais_on(call_type, buf, dest);
-                        } else {
-                            /* Check here if we must move to periodic mode, do it every N mpicalls to reduce the
-                             * overhead */
-                            if ((total_mpi_calls % check_every) == 0) {
-                                /* We add a minimum number of mpi calls to allow the application to start a "normal"
-                                 * computation */
-                                if (avg_mpi_calls_per_second() >= MAX_MPI_CALLS_SECOND) {
-#if 0
-                                    verbose(0, "Going to periodic mode because limit exceeded avg mpi_per_sec %f limit %u", avg_mpi_calls_per_second(),
-                                            MAX_MPI_CALLS_SECOND);
-#endif
-                                    limit_exceeded = 1;
-                                }
-
-                                time_t curr_time;
-                                time(&curr_time);
-
-                                double time_from_mpi_init = difftime(curr_time, application.job.start_time);
-
-                                /* In that case, the maximum time without signature has been passed, go to set
-                                 * ear_periodic_mode ON */
-                                if (limit_exceeded || time_from_mpi_init >= dynais_timeout) {
-                                    if (limit_exceeded) {
-                                        // we must compute N here
-                                        ear_periodic_mode = PERIODIC_MODE_ON;
-
-                                        assert(dynais_timeout > 0);
-
-                                        // mpi_calls_per_second = (uint)(total_mpi_calls/dynais_timeout);
-                                        mpi_calls_per_second = (uint) avg_mpi_calls_per_second();
-
-                                        traces_start();
-
-                                        verbose_master(
-                                            EARL_GUIDED_LVL,
-                                            "Going to periodic mode after %lf secs: mpi calls in period %u.\n",
-                                            time_from_mpi_init, mpi_calls_per_second);
-
-                                        ear_iterations = 0;
-
-                                        states_begin_period(my_id, ear_event_l, (ulong) lib_period, 1);
-                                        states_new_iteration(my_id, 1, ear_iterations, 1, 1, lib_period, 0);
-                                    } else
-                                        _go_to_time_guided(TIME_GUIDED);
-
-                                } else {
-                                    /* We continue using dynais */
-                                    ear_mpi_call_dynais_on(call_type, buf, dest);
-                                }
-                            } else { // We check the periodic mode every check_every mpi calls
-                                ear_mpi_call_dynais_on(call_type, buf, dest);
+                        if (dynais_ctl_feeds()) {
+                            ullong start = dynais_ctl_begin();
+                            ear_mpi_call_dynais_on(call_type, buf, dest, mix);
+                            dynais_ctl_end(start);
+                        }
+                        /* Every check_every calls the interception overhead is checked. Until the first signature
+                         * is computed with DynAIS (check_periodic_mode set to 0), it is also checked whether it has
+                         * been too long without loops. */
+                        if ((total_mpi_calls % check_every) == 0) {
+                            if (dynais_ctl_check() == DYNAIS_MODE_PERIODIC) {
+                                _go_to_periodic(ear_event_l);
+                            } else if (check_periodic_mode && dynais_timeout_passed()) {
+                                _go_to_time_guided(TIME_GUIDED);
                             }
                         }
-
 #endif
                     } break;
                     case DYNAIS_DISABLED:
                         /** That case means we have computed some signature and we have decided to set dynais disabled
                          */
-                        ear_mpi_call_dynais_off(call_type, buf, dest);
+                        ear_mpi_call_dynais_off(call_type, buf, dest, mix);
                         break;
                 }
             } break;
             case PERIODIC_MODE_ON:
+                dynais_ctl_feeds();
+#if MPI
+                /* DynAIS is fed again when its projected overhead fits in the budget */
+                if ((total_mpi_calls % check_every) == 0 && dynais_ctl_check() != DYNAIS_MODE_PERIODIC) {
+                    _go_to_dynais();
+                    break;
+                }
+#endif
                 /* EAR energy policy is called periodically */
                 if ((mpi_calls_per_second > 0) && (total_mpi_calls % mpi_calls_per_second) == 0) {
                     ear_iterations++;
                     // verbose_master(0, "Periodic mode on calling states_new_iteration");
                     states_new_iteration(my_id, 1, ear_iterations, 1, 1, lib_period, 0);
-#if MPI
-                    /* We add a minimum number of iterations to guarantee the application has run for some time */
-                    if (!limit_exceeded && (avg_mpi_calls_per_second() >= MAX_MPI_CALLS_SECOND))
-                        limit_exceeded = 1;
-#endif
                 }
                 break;
         }
     }
 }
 
-void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest)
+void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest, ulong mix)
 {
 #if ONLY_MASTER
     if (my_id) {
@@ -2699,7 +2721,7 @@ void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest)
         uint ear_size;
         uint ear_level;
 
-        ear_event_l = (ulong) ((((buf >> 5) ^ dest) << 5) | call_type);
+        ear_event_l = mpi_call_event(call_type, buf, dest, mix);
         ear_event_s = dynais_sample_convert(ear_event_l);
         // debug("EAR(%s) EAR executing before an MPI Call: DYNAIS ON\n",__FILE__);
 
@@ -2741,9 +2763,14 @@ void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest)
                 mpi_calls_per_loop = 1;
                 ear_loop_size      = (uint) ear_size;
                 ear_loop_level     = (uint) ear_level;
+                in_loop            = 1;
                 states_begin_period(my_id, ear_event_l, (ulong) ear_size, (ulong) ear_level);
                 break;
             case NEW_ITERATION:
+                /* The iterations of a loop detected before the periodic mode are ignored */
+                if (!in_loop) {
+                    break;
+                }
                 ear_iterations++;
 
                 if (loop_with_signature) {
@@ -2757,6 +2784,9 @@ void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest)
                 break;
             case END_LOOP:
                 // debug("END_LOOP event %lu\n",ear_event_l);
+                if (!in_loop) {
+                    break;
+                }
                 if (loop_with_signature) {
                     // debug("loop ends with %d iterations detected", ear_iterations);
                 }
@@ -2773,7 +2803,7 @@ void ear_mpi_call_dynais_on(mpi_call call_type, p2i buf, p2i dest)
     } // ear_whole_app
 }
 
-void ear_mpi_call_dynais_off(mpi_call call_type, p2i buf, p2i dest)
+void ear_mpi_call_dynais_off(mpi_call call_type, p2i buf, p2i dest, ulong mix)
 {
 #if ONLY_MASTER
     if (my_id) {
@@ -2788,7 +2818,7 @@ void ear_mpi_call_dynais_off(mpi_call call_type, p2i buf, p2i dest)
         unsigned short ear_level;
         ear_level = 0;
 
-        ear_event_l = (unsigned long) ((((buf >> 5) ^ dest) << 5) | call_type);
+        ear_event_l = mpi_call_event(call_type, buf, dest, mix);
         // ear_event_s = dynais_sample_convert(ear_event_l);
 
         // debug("EAR(%s) EAR executing before an MPI Call: DYNAIS ON\n", __FILE__);
@@ -3010,8 +3040,6 @@ state_t earl_periodic_actions(void *no_arg)
             overhead_stop(id_ovh_earl_monitor);
             return EAR_SUCCESS;
         }
-        if (avg_mpi_calls_per_second() >= MAX_MPI_CALLS_SECOND)
-            limit_exceeded = 1;
     }
 
     seconds = period_elapsed - last_check;
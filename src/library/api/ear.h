@@ -20,8 +20,9 @@ void ear_init();
 
 /** Given the information corresponding a MPI call, creates a DynAIS event
  *   and processes it as well as creating the trace. If the library is in
- *   a learning phase it does nothing. */
-void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest);
+ *   a learning phase it does nothing. \p mix is a hash of the message data
+ *   (size, communicator, tag) mixed into the event, 0 if not used. */
+void ear_mpi_call(mpi_call call_type, p2i buf, p2i dest, ulong mix);
 
 /** Finalizes the processes, closing and registering metrics and traces, as well as
  *   closing the connection to the daemon and releasing the memory from DynAIS. */
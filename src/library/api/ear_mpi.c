@@ -9,15 +9,67 @@
  **************************************************************************/
 
 // #define SHOW_DEBUGS 1
+#include <common/config/config_env.h>
+#include <common/environment_common.h>
+#include <common/hardware/defines.h>
 #include <common/output/debug.h>
 #include <common/states.h>
+#include <common/string_enhanced.h>
 #include <library/api/ear.h>
 #include <library/api/ear_mpi.h>
 #include <library/policies/policy.h>
+#if __ARCH_X86
+#include <nmmintrin.h>
+#endif
+
+uint mpi_event_mix;
+static ulong (*event_hash)(ulong a, ulong b, ulong c);
+
+static ulong event_hash_mul(ulong a, ulong b, ulong c)
+{
+    ulong h = (a * 0x9E3779B97F4A7C15UL) ^ b;
+    h       = (h * 0x9E3779B97F4A7C15UL) ^ c;
+    return h ^ (h >> 32);
+}
+
+#if __ARCH_X86
+// The library is not compiled for a specific CPU, so the CRC32 instruction is
+// enabled just for this function and selected after checking the CPU flags.
+__attribute__((target("sse4.2"))) static ulong event_hash_crc32(ulong a, ulong b, ulong c)
+{
+    ulong h = _mm_crc32_u64(0, a);
+    h       = _mm_crc32_u64(h, b);
+    return _mm_crc32_u64(h, c);
+}
+#endif
+
+static void event_mix_init()
+{
+    char *mix = ear_getenv(FLAG_DYNAIS_EVENT_MIX);
+
+    mpi_event_mix = 0;
+    if (mix == NULL) {
+        return;
+    }
+    if (strinlist(mix, ",", "bytes"))
+        mpi_event_mix |= MPI_EVENT_BYTES;
+    if (strinlist(mix, ",", "comm"))
+        mpi_event_mix |= MPI_EVENT_COMM;
+    if (strinlist(mix, ",", "tag"))
+        mpi_event_mix |= MPI_EVENT_TAG;
+
+    event_hash = event_hash_mul;
+#if __ARCH_X86
+    if (__builtin_cpu_supports("sse4.2"))
+        event_hash = event_hash_crc32;
+#endif
+    debug("DynAIS event mix %s (0x%x)", mix, mpi_event_mix);
+}
 
 void before_init()
 {
     debug("before_init");
+    event_mix_init();
 }
 
 void after_init()
@@ -41,7 +93,33 @@ void before_mpi(mpi_call call_type, p2i buf, p2i dest)
     return;
 #endif
     policy_mpi_init(call_type);
-    ear_mpi_call(call_type, buf, dest);
+    ear_mpi_call(call_type, buf, dest, 0);
+}
+
+void before_mpi_event(mpi_call call_type, p2i buf, p2i dest, ulong bytes, p2i comm, int tag)
+{
+    ulong bucket = 0;
+
+    debug("before_mpi_event");
+#if MPI_OPTIMIZED
+    last_buf  = buf;
+    last_dest = dest;
+#endif
+#if EAR_OFF
+    return;
+#endif
+    // Sizes in the same power of two are the same message
+    if ((mpi_event_mix & MPI_EVENT_BYTES) && bytes) {
+        bucket = 64 - __builtin_clzl(bytes);
+    }
+    if (!(mpi_event_mix & MPI_EVENT_COMM)) {
+        comm = 0;
+    }
+    if (!(mpi_event_mix & MPI_EVENT_TAG)) {
+        tag = 0;
+    }
+    policy_mpi_init(call_type);
+    ear_mpi_call(call_type, buf, dest, event_hash(bucket, (ulong) comm, (ulong) tag));
 }
 
 void after_mpi(mpi_call call_type)
@@ -11,14 +11,27 @@
 #ifndef LIBRARY_EAR_MPI_H
 #define LIBRARY_EAR_MPI_H
 
+#include <common/types.h>
 #include <library/api/mpi.h>
 
 void before_init();
 
 void after_init();
 
+/* Message information mixed into the DynAIS event. The set is selected through
+ * EAR_DYNAIS_EVENT_MIX, a comma separated list of bytes, comm and tag. */
+#define MPI_EVENT_BYTES 0x1
+#define MPI_EVENT_COMM  0x2
+#define MPI_EVENT_TAG   0x4
+
+extern uint mpi_event_mix;
+
 void before_mpi(mpi_call call_type, p2i buf, p2i dest);
 
+/** Same as before_mpi, but the message size, communicator and tag are mixed
+ * into the event when they are enabled in mpi_event_mix. */
+void before_mpi_event(mpi_call call_type, p2i buf, p2i dest, ulong bytes, p2i comm, int tag);
+
 void after_mpi(mpi_call call_type);
 
 void before_finalize();
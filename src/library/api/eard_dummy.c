@@ -273,13 +273,14 @@ state_t eard_dummy_app_mgt(char *ear_tmp, uint ID)
 
 state_t eard_dummy_pc_app_info(char *ear_tmp, uint ID)
 {
+    // Metrics are not initialized yet, so the topology is not available
+    uint num_cpus = (uint) sysconf(_SC_NPROCESSORS_CONF);
     pc_app_info_t *dummy;
 
     get_pc_app_info_path(ear_tmp, ID, path);
-    dummy = create_pc_app_info_shared_area(path, NULL, NULL);
+    dummy = create_pc_app_info_shared_area(path, num_cpus, NULL, NULL);
     check_null(dummy, "Error creating pc area in path %s", path);
 
-    memset(dummy, 0, sizeof(pc_app_info_t));
     dummy->cpu_mode = PC_POWER;
 #if USE_GPUS
     dummy->gpu_mode = PC_POWER;
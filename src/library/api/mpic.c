@@ -119,11 +119,30 @@ void ear_mpic_setnext(mpic_t *_next_mpic)
     debug("<< C setnext...............");
 }
 
+/* Passes the message data to before_mpi_event when the DynAIS event mix is
+ * enabled. The datatype size is only requested when the bytes are mixed. */
+static inline void before_mpic(mpi_call call_type, p2i buf, p2i dest, int count, MPI_Datatype datatype, MPI_Comm comm,
+                               int tag)
+{
+    int size = 0;
+
+    if (!mpi_event_mix) {
+        before_mpi(call_type, buf, dest);
+        return;
+    }
+    if ((mpi_event_mix & MPI_EVENT_BYTES) && (count > 0)) {
+        if (PMPI_Type_size(datatype, &size) != MPI_SUCCESS) {
+            size = 0;
+        }
+    }
+    before_mpi_event(call_type, buf, dest, (ulong) count * (ulong) size, (p2i) comm, tag);
+}
+
 int ear_mpic_Allgather(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
                        MPI_Datatype recvtype, MPI_Comm comm)
 {
     debug(">> C Allgather...............");
-    before_mpi(Allgather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Allgather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
     debug("<< C Allgather...............");
     after_mpi(Allgather);
@@ -134,7 +153,7 @@ int ear_mpic_Allgatherv(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype se
                         MPI3_CONST int *recvcounts, MPI3_CONST int *displs, MPI_Datatype recvtype, MPI_Comm comm)
 {
     debug(">> C Allgatherv...............");
-    before_mpi(Allgatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Allgatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Allgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm);
     debug("<< C Allgatherv...............");
     after_mpi(Allgatherv);
@@ -145,7 +164,7 @@ int ear_mpic_Allreduce(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_D
                        MPI_Comm comm)
 {
     debug(">> C Allreduce...............");
-    before_mpi(Allreduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Allreduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
     debug("<< C Allreduce...............");
     after_mpi(Allreduce);
@@ -156,7 +175,7 @@ int ear_mpic_Alltoall(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype send
                       MPI_Datatype recvtype, MPI_Comm comm)
 {
     debug(">> C Alltoall...............");
-    before_mpi(Alltoall, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Alltoall, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
     debug("<< C Alltoall...............");
     after_mpi(Alltoall);
@@ -168,7 +187,7 @@ int ear_mpic_Alltoallv(MPI3_CONST void *sendbuf, MPI3_CONST int *sendcounts, MPI
                        MPI_Datatype recvtype, MPI_Comm comm)
 {
     debug(">> C Alltoallv...............");
-    before_mpi(Alltoallv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Alltoallv, (p2i) sendbuf, (p2i) recvbuf, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
     debug("<< C Alltoallv...............");
     after_mpi(Alltoallv);
@@ -178,7 +197,7 @@ int ear_mpic_Alltoallv(MPI3_CONST void *sendbuf, MPI3_CONST int *sendcounts, MPI
 int ear_mpic_Barrier(MPI_Comm comm)
 {
     debug(">> C Barrier...............");
-    before_mpi(Barrier, (p2i) comm, 0);
+    before_mpic(Barrier, (p2i) comm, 0, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Barrier(comm);
     debug("<< C Barrier...............");
     after_mpi(Barrier);
@@ -188,7 +207,7 @@ int ear_mpic_Barrier(MPI_Comm comm)
 int ear_mpic_Bcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm)
 {
     debug(">> C Bcast...............");
-    before_mpi(Bcast, (p2i) comm, 0);
+    before_mpic(Bcast, (p2i) comm, 0, count, datatype, comm, 0);
     int res = next_mpic.Bcast(buffer, count, datatype, root, comm);
     debug("<< C Bcast...............");
     after_mpi(Bcast);
@@ -198,7 +217,7 @@ int ear_mpic_Bcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI
 int ear_mpic_Bsend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
 {
     debug(">> C Bsend...............");
-    before_mpi(Bsend, (p2i) buf, (p2i) dest);
+    before_mpic(Bsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Bsend(buf, count, datatype, dest, tag, comm);
     debug("<< C Bsend...............");
     after_mpi(Bsend);
@@ -209,7 +228,7 @@ int ear_mpic_Bsend_init(MPI3_CONST void *buf, int count, MPI_Datatype datatype,
                         MPI_Request *request)
 {
     debug(">> C Bsend_init...............");
-    before_mpi(Bsend_init, (p2i) buf, (p2i) dest);
+    before_mpic(Bsend_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Bsend_init(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Bsend_init...............");
     after_mpi(Bsend_init);
@@ -440,7 +459,7 @@ int ear_mpic_Gather(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sendty
                     MPI_Datatype recvtype, int root, MPI_Comm comm)
 {
     debug(">> C Gather...............");
-    before_mpi(Gather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Gather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
     debug("<< C Gather...............");
     after_mpi(Gather);
@@ -451,7 +470,7 @@ int ear_mpic_Gatherv(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sendt
                      MPI3_CONST int *recvcounts, MPI3_CONST int *displs, MPI_Datatype recvtype, int root, MPI_Comm comm)
 {
     debug(">> C Gatherv...............");
-    before_mpi(Gatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Gatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
     debug("<< C Gatherv...............");
     after_mpi(Gatherv);
@@ -474,7 +493,7 @@ int ear_mpic_Ibsend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int
                     MPI_Request *request)
 {
     debug(">> C Ibsend...............");
-    before_mpi(Ibsend, (p2i) buf, (p2i) datatype);
+    before_mpic(Ibsend, (p2i) buf, (p2i) datatype, count, datatype, comm, tag);
     int res = next_mpic.Ibsend(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Ibsend...............");
     after_mpi(Ibsend);
@@ -525,7 +544,7 @@ int ear_mpic_Intercomm_merge(MPI_Comm intercomm, int high, MPI_Comm *newintracom
 int ear_mpic_Iprobe(int source, int tag, MPI_Comm comm, int *flag, MPI_Status *status)
 {
     debug(">> C Iprobe...............");
-    before_mpi(Iprobe, (p2i) flag, (p2i) status);
+    before_mpic(Iprobe, (p2i) flag, (p2i) status, 0, MPI_DATATYPE_NULL, comm, tag);
     int res = next_mpic.Iprobe(source, tag, comm, flag, status);
     debug("<< C Iprobe...............");
     after_mpi(Iprobe);
@@ -536,7 +555,7 @@ int ear_mpic_Irecv(void *buf, int count, MPI_Datatype datatype, int source, int
                    MPI_Request *request)
 {
     debug(">> C Irecv...............");
-    before_mpi(Irecv, (p2i) buf, (p2i) request);
+    before_mpic(Irecv, (p2i) buf, (p2i) request, count, datatype, comm, tag);
     int res = next_mpic.Irecv(buf, count, datatype, source, tag, comm, request);
     debug("<< C Irecv...............");
     after_mpi(Irecv);
@@ -547,7 +566,7 @@ int ear_mpic_Irsend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int
                     MPI_Request *request)
 {
     debug(">> C Irsend...............");
-    before_mpi(Irsend, (p2i) buf, (p2i) dest);
+    before_mpic(Irsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Irsend(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Irsend...............");
     after_mpi(Irsend);
@@ -558,7 +577,7 @@ int ear_mpic_Isend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int d
                    MPI_Request *request)
 {
     debug(">> C Isend...............");
-    before_mpi(Isend, (p2i) buf, (p2i) dest);
+    before_mpic(Isend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Isend(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Isend...............");
     after_mpi(Isend);
@@ -569,7 +588,7 @@ int ear_mpic_Issend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int
                     MPI_Request *request)
 {
     debug(">> C Issend...............");
-    before_mpi(Issend, (p2i) buf, (p2i) dest);
+    before_mpic(Issend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Issend(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Issend...............");
     after_mpi(Issend);
@@ -579,7 +598,7 @@ int ear_mpic_Issend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int
 int ear_mpic_Probe(int source, int tag, MPI_Comm comm, MPI_Status *status)
 {
     debug(">> C Probe...............");
-    before_mpi(Probe, (p2i) source, (p2i) 0);
+    before_mpic(Probe, (p2i) source, (p2i) 0, 0, MPI_DATATYPE_NULL, comm, tag);
     int res = next_mpic.Probe(source, tag, comm, status);
     debug("<< C Probe...............");
     after_mpi(Probe);
@@ -601,7 +620,7 @@ int ear_mpic_Put(MPI3_CONST void *origin_addr, int origin_count, MPI_Datatype or
 int ear_mpic_Recv(void *buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status *status)
 {
     debug(">> C Recv...............");
-    before_mpi(Recv, (p2i) buf, (p2i) source);
+    before_mpic(Recv, (p2i) buf, (p2i) source, count, datatype, comm, tag);
     int res = next_mpic.Recv(buf, count, datatype, source, tag, comm, status);
     debug("<< C Recv...............");
     after_mpi(Recv);
@@ -612,7 +631,7 @@ int ear_mpic_Recv_init(void *buf, int count, MPI_Datatype datatype, int source,
                        MPI_Request *request)
 {
     debug(">> C Recv_init...............");
-    before_mpi(Recv_init, (p2i) buf, (p2i) source);
+    before_mpic(Recv_init, (p2i) buf, (p2i) source, count, datatype, comm, tag);
     int res = next_mpic.Recv_init(buf, count, datatype, source, tag, comm, request);
     debug("<< C Recv_init...............");
     after_mpi(Recv_init);
@@ -623,7 +642,7 @@ int ear_mpic_Reduce(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_Data
                     MPI_Comm comm)
 {
     debug(">> C Reduce...............");
-    before_mpi(Reduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Reduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
     debug("<< C Reduce...............");
     after_mpi(Reduce);
@@ -634,7 +653,7 @@ int ear_mpic_Reduce_scatter(MPI3_CONST void *sendbuf, void *recvbuf, MPI3_CONST
                             MPI_Op op, MPI_Comm comm)
 {
     debug(">> C Reduce_scatter...............");
-    before_mpi(Reduce_scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Reduce_scatter, (p2i) sendbuf, (p2i) recvbuf, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Reduce_scatter(sendbuf, recvbuf, recvcounts, datatype, op, comm);
     debug("<< C Reduce_scatter...............");
     after_mpi(Reduce_scatter);
@@ -664,7 +683,7 @@ int ear_mpic_Request_get_status(MPI_Request request, int *flag, MPI_Status *stat
 int ear_mpic_Rsend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
 {
     debug(">> C Rsend...............");
-    before_mpi(Rsend, (p2i) buf, (p2i) dest);
+    before_mpic(Rsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Rsend(buf, count, datatype, dest, tag, comm);
     debug("<< C Rsend...............");
     after_mpi(Rsend);
@@ -675,7 +694,7 @@ int ear_mpic_Rsend_init(MPI3_CONST void *buf, int count, MPI_Datatype datatype,
                         MPI_Request *request)
 {
     debug(">> C Rsend_init...............");
-    before_mpi(Rsend_init, (p2i) buf, (p2i) 0);
+    before_mpic(Rsend_init, (p2i) buf, (p2i) 0, count, datatype, comm, tag);
     int res = next_mpic.Rsend_init(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Rsend_init...............");
     after_mpi(Rsend_init);
@@ -685,7 +704,7 @@ int ear_mpic_Rsend_init(MPI3_CONST void *buf, int count, MPI_Datatype datatype,
 int ear_mpic_Scan(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
 {
     debug(">> C Scan...............");
-    before_mpi(Scan, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Scan, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Scan(sendbuf, recvbuf, count, datatype, op, comm);
     debug("<< C Scan...............");
     after_mpi(Scan);
@@ -696,7 +715,7 @@ int ear_mpic_Scatter(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sendt
                      MPI_Datatype recvtype, int root, MPI_Comm comm)
 {
     debug(">> C Scatter...............");
-    before_mpi(Scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Scatter, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, 0);
     int res = next_mpic.Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
     debug("<< C Scatter...............");
     after_mpi(Scatter);
@@ -708,7 +727,7 @@ int ear_mpic_Scatterv(MPI3_CONST void *sendbuf, MPI3_CONST int *sendcounts, MPI3
                       MPI_Comm comm)
 {
     debug(">> C Scatterv...............");
-    before_mpi(Scatterv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Scatterv, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, 0);
     int res = next_mpic.Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
     debug("<< C Scatterv...............");
     after_mpi(Scatterv);
@@ -718,7 +737,7 @@ int ear_mpic_Scatterv(MPI3_CONST void *sendbuf, MPI3_CONST int *sendcounts, MPI3
 int ear_mpic_Send(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
 {
     debug(">> C Send...............");
-    before_mpi(Send, (p2i) buf, (p2i) dest);
+    before_mpic(Send, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Send(buf, count, datatype, dest, tag, comm);
     debug("<< C Send...............");
     after_mpi(Send);
@@ -729,7 +748,7 @@ int ear_mpic_Send_init(MPI3_CONST void *buf, int count, MPI_Datatype datatype, i
                        MPI_Request *request)
 {
     debug(">> C Send_init...............");
-    before_mpi(Send_init, (p2i) buf, (p2i) dest);
+    before_mpic(Send_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Send_init(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Send_init...............");
     after_mpi(Send_init);
@@ -741,7 +760,7 @@ int ear_mpic_Sendrecv(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype send
                       MPI_Status *status)
 {
     debug(">> C Sendrecv...............");
-    before_mpi(Sendrecv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Sendrecv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, sendtag);
     int res = next_mpic.Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype, source,
                                  recvtag, comm, status);
     debug("<< C Sendrecv...............");
@@ -753,7 +772,7 @@ int ear_mpic_Sendrecv_replace(void *buf, int count, MPI_Datatype datatype, int d
                               int recvtag, MPI_Comm comm, MPI_Status *status)
 {
     debug(">> C Sendrecv_replace...............");
-    before_mpi(Sendrecv_replace, (p2i) buf, (p2i) dest);
+    before_mpic(Sendrecv_replace, (p2i) buf, (p2i) dest, count, datatype, comm, sendtag);
     int res = next_mpic.Sendrecv_replace(buf, count, datatype, dest, sendtag, source, recvtag, comm, status);
     debug("<< C Sendrecv_replace...............");
     after_mpi(Sendrecv_replace);
@@ -763,7 +782,7 @@ int ear_mpic_Sendrecv_replace(void *buf, int count, MPI_Datatype datatype, int d
 int ear_mpic_Ssend(MPI3_CONST void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
 {
     debug(">> C Ssend...............");
-    before_mpi(Ssend, (p2i) buf, (p2i) dest);
+    before_mpic(Ssend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Ssend(buf, count, datatype, dest, tag, comm);
     debug("<< C Ssend...............");
     after_mpi(Ssend);
@@ -774,7 +793,7 @@ int ear_mpic_Ssend_init(MPI3_CONST void *buf, int count, MPI_Datatype datatype,
                         MPI_Request *request)
 {
     debug(">> C Ssend_init...............");
-    before_mpi(Ssend_init, (p2i) buf, (p2i) dest);
+    before_mpic(Ssend_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     int res = next_mpic.Ssend_init(buf, count, datatype, dest, tag, comm, request);
     debug("<< C Ssend_init...............");
     after_mpi(Ssend_init);
@@ -958,7 +977,7 @@ int ear_mpic_Iallgather(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype se
                         MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Iallgather...............");
-    before_mpi(Iallgather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iallgather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Iallgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, request);
     debug("<< C Iallgather...............");
     after_mpi(Iallgather);
@@ -970,7 +989,7 @@ int ear_mpic_Iallgatherv(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype s
                          MPI_Request *request)
 {
     debug(">> C Iallgatherv...............");
-    before_mpi(Iallgatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iallgatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Iallgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm, request);
     debug("<< C Iallgatherv...............");
     after_mpi(Iallgatherv);
@@ -981,7 +1000,7 @@ int ear_mpic_Iallreduce(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_
                         MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Iallreduce...............");
-    before_mpi(Iallreduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iallreduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Iallreduce(sendbuf, recvbuf, count, datatype, op, comm, request);
     debug("<< C Iallreduce...............");
     after_mpi(Iallreduce);
@@ -992,7 +1011,7 @@ int ear_mpic_Ialltoall(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sen
                        MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ialltoall...............");
-    before_mpi(Ialltoall, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Ialltoall, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Ialltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, request);
     debug("<< C Ialltoall...............");
     after_mpi(Ialltoall);
@@ -1004,7 +1023,7 @@ int ear_mpic_Ialltoallv(MPI3_CONST void *sendbuf, MPI3_CONST int sendcounts[], M
                         MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ialltoallv...............");
-    before_mpi(Ialltoallv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Ialltoallv, (p2i) sendbuf, (p2i) recvbuf, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Ialltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm,
                                    request);
     debug("<< C Ialltoallv...............");
@@ -1015,7 +1034,7 @@ int ear_mpic_Ialltoallv(MPI3_CONST void *sendbuf, MPI3_CONST int sendcounts[], M
 int ear_mpic_Ibarrier(MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ibarrier...............");
-    before_mpi(Ibarrier, (p2i) request, (p2i) 0);
+    before_mpic(Ibarrier, (p2i) request, (p2i) 0, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Ibarrier(comm, request);
     debug("<< C Ibarrier...............");
     after_mpi(Ibarrier);
@@ -1025,7 +1044,7 @@ int ear_mpic_Ibarrier(MPI_Comm comm, MPI_Request *request)
 int ear_mpic_Ibcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ibcast...............");
-    before_mpi(Ibcast, (p2i) buffer, (p2i) request);
+    before_mpic(Ibcast, (p2i) buffer, (p2i) request, count, datatype, comm, 0);
     int res = next_mpic.Ibcast(buffer, count, datatype, root, comm, request);
     debug("<< C Ibcast...............");
     after_mpi(Ibcast);
@@ -1036,7 +1055,7 @@ int ear_mpic_Igather(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype sendt
                      MPI_Datatype recvtype, int root, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Igather...............");
-    before_mpi(Igather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Igather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res = next_mpic.Igather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
     debug("<< C Igather...............");
     after_mpi(Igather);
@@ -1048,7 +1067,7 @@ int ear_mpic_Igatherv(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype send
                       MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Igatherv...............");
-    before_mpi(Igatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Igatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, 0);
     int res =
         next_mpic.Igatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm, request);
     debug("<< C Igatherv...............");
@@ -1060,7 +1079,7 @@ int ear_mpic_Ireduce(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_Dat
                      MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ireduce...............");
-    before_mpi(Ireduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Ireduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Ireduce(sendbuf, recvbuf, count, datatype, op, root, comm, request);
     debug("<< C Ireduce...............");
     after_mpi(Ireduce);
@@ -1071,7 +1090,7 @@ int ear_mpic_Ireduce_scatter(MPI3_CONST void *sendbuf, void *recvbuf, MPI3_CONST
                              MPI_Datatype datatype, MPI_Op op, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Ireduce_scatter...............");
-    before_mpi(Ireduce_scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Ireduce_scatter, (p2i) sendbuf, (p2i) recvbuf, 0, MPI_DATATYPE_NULL, comm, 0);
     int res = next_mpic.Ireduce_scatter(sendbuf, recvbuf, recvcounts, datatype, op, comm, request);
     debug("<< C Ireduce_scatter...............");
     after_mpi(Ireduce_scatter);
@@ -1082,7 +1101,7 @@ int ear_mpic_Iscan(MPI3_CONST void *sendbuf, void *recvbuf, int count, MPI_Datat
                    MPI_Request *request)
 {
     debug(">> C Iscan...............");
-    before_mpi(Iscan, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iscan, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, 0);
     int res = next_mpic.Iscan(sendbuf, recvbuf, count, datatype, op, comm, request);
     debug("<< C Iscan...............");
     after_mpi(Iscan);
@@ -1093,7 +1112,7 @@ int ear_mpic_Iscatter(MPI3_CONST void *sendbuf, int sendcount, MPI_Datatype send
                       MPI_Datatype recvtype, int root, MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Iscatter...............");
-    before_mpi(Iscatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iscatter, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, 0);
     int res = next_mpic.Iscatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
     debug("<< C Iscatter...............");
     after_mpi(Iscatter);
@@ -1105,7 +1124,7 @@ int ear_mpic_Iscatterv(MPI3_CONST void *sendbuf, MPI3_CONST int sendcounts[], MP
                        MPI_Comm comm, MPI_Request *request)
 {
     debug(">> C Iscatterv...............");
-    before_mpi(Iscatterv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpic(Iscatterv, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, 0);
     int res =
         next_mpic.Iscatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
     debug("<< C Iscatterv...............");
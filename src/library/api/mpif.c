@@ -22,11 +22,30 @@ void ear_mpif_setnext(mpif_t *_next_mpif)
     debug("<< F setnext...............");
 }
 
+/* Fortran version of before_mpic. Arguments the call does not have are NULL. */
+static inline void before_mpif(mpi_call call_type, p2i buf, p2i dest, const MPI_Fint *count, const MPI_Fint *datatype,
+                               const MPI_Fint *comm, const MPI_Fint *tag)
+{
+    ulong bytes = 0;
+    int size    = 0;
+
+    if (!mpi_event_mix) {
+        before_mpi(call_type, buf, dest);
+        return;
+    }
+    if ((mpi_event_mix & MPI_EVENT_BYTES) && (count != NULL) && (*count > 0)) {
+        if (PMPI_Type_size(MPI_Type_f2c(*datatype), &size) == MPI_SUCCESS) {
+            bytes = (ulong) *count * (ulong) size;
+        }
+    }
+    before_mpi_event(call_type, buf, dest, bytes, (p2i) ((comm != NULL) ? *comm : 0), (tag != NULL) ? *tag : 0);
+}
+
 void ear_mpif_Allgather(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *sendtype, void *recvbuf,
                         MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Allgather...............");
-    before_mpi(Allgather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Allgather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, ierror);
     debug("<< F Allgather...............");
     after_mpi(Allgather);
@@ -37,7 +56,7 @@ void ear_mpif_Allgatherv(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint
                          MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Allgatherv...............");
-    before_mpi(Allgatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Allgatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.allgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm, ierror);
     debug("<< F Allgatherv...............");
     after_mpi(Allgatherv);
@@ -47,7 +66,7 @@ void ear_mpif_Allreduce(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *count
                         MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Allreduce...............");
-    before_mpi(Allreduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Allreduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, NULL);
     next_mpif.allreduce(sendbuf, recvbuf, count, datatype, op, comm, ierror);
     debug("<< F Allreduce...............");
     after_mpi(Allreduce);
@@ -57,7 +76,7 @@ void ear_mpif_Alltoall(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *
                        MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Alltoall...............");
-    before_mpi(Alltoall, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Alltoall, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, ierror);
     debug("<< F Alltoall...............");
     after_mpi(Alltoall);
@@ -68,7 +87,7 @@ void ear_mpif_Alltoallv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcount
                         MPI3_CONST MPI_Fint *rdispls, MPI_Fint *recvtype, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Alltoallv...............");
-    before_mpi(Alltoallv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Alltoallv, (p2i) sendbuf, (p2i) recvbuf, NULL, NULL, comm, NULL);
     next_mpif.alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm, ierror);
     debug("<< F Alltoallv...............");
     after_mpi(Alltoallv);
@@ -77,7 +96,7 @@ void ear_mpif_Alltoallv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcount
 void ear_mpif_Barrier(MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Barrier...............");
-    before_mpi(Barrier, (p2i) comm, (p2i) ierror);
+    before_mpif(Barrier, (p2i) comm, (p2i) ierror, NULL, NULL, comm, NULL);
     next_mpif.barrier(comm, ierror);
     debug("<< F Barrier...............");
     after_mpi(Barrier);
@@ -86,7 +105,7 @@ void ear_mpif_Barrier(MPI_Fint *comm, MPI_Fint *ierror)
 void ear_mpif_Bcast(void *buffer, MPI_Fint *count, MPI_Fint *datatype, MPI_Fint *root, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Bcast...............");
-    before_mpi(Bcast, (p2i) buffer, 0);
+    before_mpif(Bcast, (p2i) buffer, 0, count, datatype, comm, NULL);
     next_mpif.bcast(buffer, count, datatype, root, comm, ierror);
     debug("<< F Bcast...............");
     after_mpi(Bcast);
@@ -96,7 +115,7 @@ void ear_mpif_Bsend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype, M
                     MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Bsend...............");
-    before_mpi(Bsend, (p2i) buf, (p2i) dest);
+    before_mpif(Bsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.bsend(buf, count, datatype, dest, tag, comm, ierror);
     debug("<< F Bsend...............");
     after_mpi(Bsend);
@@ -106,7 +125,7 @@ void ear_mpif_Bsend_init(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *dataty
                          MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Bsend_init...............");
-    before_mpi(Bsend_init, (p2i) buf, (p2i) dest);
+    before_mpif(Bsend_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.bsend_init(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Bsend_init...............");
     after_mpi(Bsend_init);
@@ -319,7 +338,7 @@ void ear_mpif_Gather(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *se
                      MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *root, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Gather...............");
-    before_mpi(Gather, (p2i) sendbuf, 0);
+    before_mpif(Gather, (p2i) sendbuf, 0, sendcount, sendtype, comm, NULL);
     next_mpif.gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, ierror);
     debug("<< F Gather...............");
     after_mpi(Gather);
@@ -330,7 +349,7 @@ void ear_mpif_Gatherv(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *s
                       MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Gatherv...............");
-    before_mpi(Gatherv, (p2i) sendbuf, 0);
+    before_mpif(Gatherv, (p2i) sendbuf, 0, sendcount, sendtype, comm, NULL);
     next_mpif.gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm, ierror);
     debug("<< F Gatherv...............");
     after_mpi(Gatherv);
@@ -352,7 +371,7 @@ void ear_mpif_Ibsend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype,
                      MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ibsend...............");
-    before_mpi(Ibsend, (p2i) buf, (p2i) dest);
+    before_mpif(Ibsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.ibsend(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Ibsend...............");
     after_mpi(Ibsend);
@@ -399,7 +418,7 @@ void ear_mpif_Iprobe(MPI_Fint *source, MPI_Fint *tag, MPI_Fint *comm, MPI_Fint *
                      MPI_Fint *ierror)
 {
     debug(">> F Iprobe...............");
-    before_mpi(Iprobe, (p2i) source, 0);
+    before_mpif(Iprobe, (p2i) source, 0, NULL, NULL, comm, tag);
     next_mpif.iprobe(source, tag, comm, flag, status, ierror);
     debug("<< F Iprobe...............");
     after_mpi(Iprobe);
@@ -409,7 +428,7 @@ void ear_mpif_Irecv(void *buf, MPI_Fint *count, MPI_Fint *datatype, MPI_Fint *so
                     MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Irecv...............");
-    before_mpi(Irecv, (p2i) buf, (p2i) source);
+    before_mpif(Irecv, (p2i) buf, (p2i) source, count, datatype, comm, tag);
     next_mpif.irecv(buf, count, datatype, source, tag, comm, request, ierror);
     debug("<< F Irecv...............");
     after_mpi(Irecv);
@@ -419,7 +438,7 @@ void ear_mpif_Irsend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype,
                      MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Irsend...............");
-    before_mpi(Irsend, (p2i) buf, (p2i) dest);
+    before_mpif(Irsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.irsend(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Irsend...............");
     after_mpi(Irsend);
@@ -429,7 +448,7 @@ void ear_mpif_Isend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype, M
                     MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Isend...............");
-    before_mpi(Isend, (p2i) buf, (p2i) dest);
+    before_mpif(Isend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.isend(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Isend...............");
     after_mpi(Isend);
@@ -439,7 +458,7 @@ void ear_mpif_Issend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype,
                      MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Issend...............");
-    before_mpi(Issend, (p2i) buf, (p2i) dest);
+    before_mpif(Issend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.issend(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Issend...............");
     after_mpi(Issend);
@@ -448,7 +467,7 @@ void ear_mpif_Issend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype,
 void ear_mpif_Probe(MPI_Fint *source, MPI_Fint *tag, MPI_Fint *comm, MPI_Fint *status, MPI_Fint *ierror)
 {
     debug(">> F Probe...............");
-    before_mpi(Probe, (p2i) source, 0);
+    before_mpif(Probe, (p2i) source, 0, NULL, NULL, comm, tag);
     next_mpif.probe(source, tag, comm, status, ierror);
     debug("<< F Probe...............");
     after_mpi(Probe);
@@ -470,7 +489,7 @@ void ear_mpif_Recv(void *buf, MPI_Fint *count, MPI_Fint *datatype, MPI_Fint *sou
                    MPI_Fint *status, MPI_Fint *ierror)
 {
     debug(">> F Recv...............");
-    before_mpi(Recv, (p2i) buf, (p2i) source);
+    before_mpif(Recv, (p2i) buf, (p2i) source, count, datatype, comm, tag);
     next_mpif.recv(buf, count, datatype, source, tag, comm, status, ierror);
     debug("<< F Recv...............");
     after_mpi(Recv);
@@ -480,7 +499,7 @@ void ear_mpif_Recv_init(void *buf, MPI_Fint *count, MPI_Fint *datatype, MPI_Fint
                         MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Recv_init...............");
-    before_mpi(Recv_init, (p2i) buf, (p2i) source);
+    before_mpif(Recv_init, (p2i) buf, (p2i) source, count, datatype, comm, tag);
     next_mpif.recv_init(buf, count, datatype, source, tag, comm, request, ierror);
     debug("<< F Recv_init...............");
     after_mpi(Recv_init);
@@ -490,7 +509,7 @@ void ear_mpif_Reduce(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *count, M
                      MPI_Fint *root, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Reduce...............");
-    before_mpi(Reduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Reduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, NULL);
     next_mpif.reduce(sendbuf, recvbuf, count, datatype, op, root, comm, ierror);
     debug("<< F Reduce...............");
     after_mpi(Reduce);
@@ -500,7 +519,7 @@ void ear_mpif_Reduce_scatter(MPI3_CONST void *sendbuf, void *recvbuf, MPI3_CONST
                              MPI_Fint *datatype, MPI_Fint *op, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Reduce_scatter...............");
-    before_mpi(Reduce_scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Reduce_scatter, (p2i) sendbuf, (p2i) recvbuf, NULL, NULL, comm, NULL);
     next_mpif.reduce_scatter(sendbuf, recvbuf, recvcounts, datatype, op, comm, ierror);
     debug("<< F Reduce_scatter...............");
     after_mpi(Reduce_scatter);
@@ -528,7 +547,7 @@ void ear_mpif_Rsend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype, M
                     MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Rsend...............");
-    before_mpi(Rsend, (p2i) buf, (p2i) dest);
+    before_mpif(Rsend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.rsend(buf, count, datatype, dest, tag, comm, ierror);
     debug("<< F Rsend...............");
     after_mpi(Rsend);
@@ -538,7 +557,7 @@ void ear_mpif_Rsend_init(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *dataty
                          MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Rsend_init...............");
-    before_mpi(Rsend_init, (p2i) buf, (p2i) dest);
+    before_mpif(Rsend_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.rsend_init(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Rsend_init...............");
     after_mpi(Rsend_init);
@@ -548,7 +567,7 @@ void ear_mpif_Scan(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *count, MPI
                    MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Scan...............");
-    before_mpi(Scan, (p2i) sendbuf, 0);
+    before_mpif(Scan, (p2i) sendbuf, 0, count, datatype, comm, NULL);
     next_mpif.scan(sendbuf, recvbuf, count, datatype, op, comm, ierror);
     debug("<< F Scan...............");
     after_mpi(Scan);
@@ -558,7 +577,7 @@ void ear_mpif_Scatter(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *s
                       MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *root, MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Scatter...............");
-    before_mpi(Scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Scatter, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, NULL);
     next_mpif.scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, ierror);
     debug("<< F Scatter...............");
     after_mpi(Scatter);
@@ -569,7 +588,7 @@ void ear_mpif_Scatterv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcounts
                        MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Scatterv...............");
-    before_mpi(Scatterv, (p2i) sendbuf, 0);
+    before_mpif(Scatterv, (p2i) sendbuf, 0, recvcount, recvtype, comm, NULL);
     next_mpif.scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm, ierror);
     debug("<< F Scatterv...............");
     after_mpi(Scatterv);
@@ -579,7 +598,7 @@ void ear_mpif_Send(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype, MP
                    MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Send...............");
-    before_mpi(Send, (p2i) buf, (p2i) dest);
+    before_mpif(Send, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.send(buf, count, datatype, dest, tag, comm, ierror);
     debug("<< F Send...............");
     after_mpi(Send);
@@ -589,7 +608,7 @@ void ear_mpif_Send_init(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatyp
                         MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Send_init...............");
-    before_mpi(Send_init, (p2i) buf, (p2i) dest);
+    before_mpif(Send_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.send_init(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Send_init...............");
     after_mpi(Send_init);
@@ -600,7 +619,7 @@ void ear_mpif_Sendrecv(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *
                        MPI_Fint *recvtag, MPI_Fint *comm, MPI_Fint *status, MPI_Fint *ierror)
 {
     debug(">> F Sendrecv...............");
-    before_mpi(Sendrecv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Sendrecv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, sendtag);
     next_mpif.sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype, source, recvtag, comm,
                        status, ierror);
     debug("<< F Sendrecv...............");
@@ -611,7 +630,7 @@ void ear_mpif_Sendrecv_replace(void *buf, MPI_Fint *count, MPI_Fint *datatype, M
                                MPI_Fint *source, MPI_Fint *recvtag, MPI_Fint *comm, MPI_Fint *status, MPI_Fint *ierror)
 {
     debug(">> F Sendrecv_replace...............");
-    before_mpi(Sendrecv_replace, (p2i) buf, (p2i) dest);
+    before_mpif(Sendrecv_replace, (p2i) buf, (p2i) dest, count, datatype, comm, sendtag);
     next_mpif.sendrecv_replace(buf, count, datatype, dest, sendtag, source, recvtag, comm, status, ierror);
     debug("<< F Sendrecv_replace...............");
     after_mpi(Sendrecv_replace);
@@ -621,7 +640,7 @@ void ear_mpif_Ssend(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *datatype, M
                     MPI_Fint *comm, MPI_Fint *ierror)
 {
     debug(">> F Ssend...............");
-    before_mpi(Ssend, (p2i) buf, (p2i) dest);
+    before_mpif(Ssend, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.ssend(buf, count, datatype, dest, tag, comm, ierror);
     debug("<< F Ssend...............");
     after_mpi(Ssend);
@@ -631,7 +650,7 @@ void ear_mpif_Ssend_init(MPI3_CONST void *buf, MPI_Fint *count, MPI_Fint *dataty
                          MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ssend_init...............");
-    before_mpi(Ssend_init, (p2i) buf, (p2i) dest);
+    before_mpif(Ssend_init, (p2i) buf, (p2i) dest, count, datatype, comm, tag);
     next_mpif.ssend_init(buf, count, datatype, dest, tag, comm, request, ierror);
     debug("<< F Ssend_init...............");
     after_mpi(Ssend_init);
@@ -800,7 +819,7 @@ void ear_mpif_Iallgather(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint
                          MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Iallgather...............");
-    before_mpi(Iallgather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iallgather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.iallgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, request, ierror);
     debug("<< F Iallgather...............");
     after_mpi(Iallgather);
@@ -811,7 +830,7 @@ void ear_mpif_Iallgatherv(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fin
                           MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Iallgatherv...............");
-    before_mpi(Iallgatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iallgatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.iallgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcount, displs, recvtype, comm, request, ierror);
     debug("<< F Iallgatherv...............");
     after_mpi(Iallgatherv);
@@ -821,7 +840,7 @@ void ear_mpif_Iallreduce(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *coun
                          MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Iallreduce...............");
-    before_mpi(Iallreduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iallreduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, NULL);
     next_mpif.iallreduce(sendbuf, recvbuf, count, datatype, op, comm, request, ierror);
     debug("<< F Iallreduce...............");
     after_mpi(Iallreduce);
@@ -831,7 +850,7 @@ void ear_mpif_Ialltoall(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint
                         MPI_Fint *recvcount, MPI_Fint *recvtype, MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ialltoall...............");
-    before_mpi(Ialltoall, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Ialltoall, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.ialltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm, request, ierror);
     debug("<< F Ialltoall...............");
     after_mpi(Ialltoall);
@@ -843,7 +862,7 @@ void ear_mpif_Ialltoallv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcoun
                          MPI_Fint *ierror)
 {
     debug(">> F Ialltoallv...............");
-    before_mpi(Ialltoallv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Ialltoallv, (p2i) sendbuf, (p2i) recvbuf, NULL, NULL, comm, NULL);
     next_mpif.ialltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, request, comm,
                          ierror);
     debug("<< F Ialltoallv...............");
@@ -853,7 +872,7 @@ void ear_mpif_Ialltoallv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcoun
 void ear_mpif_Ibarrier(MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ibarrier...............");
-    before_mpi(Ibarrier, (p2i) request, 0);
+    before_mpif(Ibarrier, (p2i) request, 0, NULL, NULL, comm, NULL);
     next_mpif.ibarrier(comm, request, ierror);
     debug("<< F Ibarrier...............");
     after_mpi(Ibarrier);
@@ -863,7 +882,7 @@ void ear_mpif_Ibcast(void *buffer, MPI_Fint *count, MPI_Fint *datatype, MPI_Fint
                      MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ibcast...............");
-    before_mpi(Ibcast, (p2i) buffer, 0);
+    before_mpif(Ibcast, (p2i) buffer, 0, count, datatype, comm, NULL);
     next_mpif.ibcast(buffer, count, datatype, root, comm, request, ierror);
     debug("<< F Ibcast...............");
     after_mpi(Ibcast);
@@ -874,7 +893,7 @@ void ear_mpif_Igather(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *s
                       MPI_Fint *ierror)
 {
     debug(">> F Igather...............");
-    before_mpi(Igather, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Igather, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.igather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request, ierror);
     debug("<< F Igather...............");
     after_mpi(Igather);
@@ -885,7 +904,7 @@ void ear_mpif_Igatherv(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *
                        MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Igatherv...............");
-    before_mpi(Igatherv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Igatherv, (p2i) sendbuf, (p2i) recvbuf, sendcount, sendtype, comm, NULL);
     next_mpif.igatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm, request,
                        ierror);
     debug("<< F Igatherv...............");
@@ -896,7 +915,7 @@ void ear_mpif_Ireduce(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *count,
                       MPI_Fint *root, MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ireduce...............");
-    before_mpi(Ireduce, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Ireduce, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, NULL);
     next_mpif.ireduce(sendbuf, recvbuf, count, datatype, op, root, comm, request, ierror);
     debug("<< F Ireduce...............");
     after_mpi(Ireduce);
@@ -906,7 +925,7 @@ void ear_mpif_Ireduce_scatter(MPI3_CONST void *sendbuf, void *recvbuf, MPI3_CONS
                               MPI_Fint *datatype, MPI_Fint *op, MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Ireduce_scatter...............");
-    before_mpi(Ireduce_scatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Ireduce_scatter, (p2i) sendbuf, (p2i) recvbuf, NULL, NULL, comm, NULL);
     next_mpif.ireduce_scatter(sendbuf, recvbuf, recvcounts, datatype, op, comm, request, ierror);
     debug("<< F Ireduce_scatter...............");
     after_mpi(Ireduce_scatter);
@@ -916,7 +935,7 @@ void ear_mpif_Iscan(MPI3_CONST void *sendbuf, void *recvbuf, MPI_Fint *count, MP
                     MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Iscan...............");
-    before_mpi(Iscan, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iscan, (p2i) sendbuf, (p2i) recvbuf, count, datatype, comm, NULL);
     next_mpif.iscan(sendbuf, recvbuf, count, datatype, op, comm, request, ierror);
     debug("<< F Iscan...............");
     after_mpi(Iscan);
@@ -927,7 +946,7 @@ void ear_mpif_Iscatter(MPI3_CONST void *sendbuf, MPI_Fint *sendcount, MPI_Fint *
                        MPI_Fint *ierror)
 {
     debug(">> F Iscatter...............");
-    before_mpi(Iscatter, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iscatter, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, NULL);
     next_mpif.iscatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request, ierror);
     debug("<< F Iscatter...............");
     after_mpi(Iscatter);
@@ -938,7 +957,7 @@ void ear_mpif_Iscatterv(MPI3_CONST void *sendbuf, MPI3_CONST MPI_Fint *sendcount
                         MPI_Fint *comm, MPI_Fint *request, MPI_Fint *ierror)
 {
     debug(">> F Iscatterv...............");
-    before_mpi(Iscatterv, (p2i) sendbuf, (p2i) recvbuf);
+    before_mpif(Iscatterv, (p2i) sendbuf, (p2i) recvbuf, recvcount, recvtype, comm, NULL);
     next_mpif.iscatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm, request,
                         ierror);
     debug("<< F Iscatterv...............");
@@ -0,0 +1,130 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Replays the MPI calls interception of ear.c over a synthetic cycle counter.
+// Each call spends some cycles in the application and, when it feeds DynAIS,
+// some cycles in it, and the mode is checked every MPI_CALLS_TO_CHECK_PERIODIC
+// calls. The budget is EAR_MAX_DYNAIS_OVERHEAD, or MAX_DYNAIS_OVERHEAD if it is
+// not set, as in EARL. It checks that:
+//
+//   - A cheap DynAIS keeps every call feeding it.
+//   - A DynAIS over the budget is sampled, with the overhead under the budget.
+//   - A DynAIS over the budget even sampled takes EARL to the periodic mode.
+//   - When the calls get less frequent, the way back to the full mode is taken
+//     one step at a time, without going back and forth and without exceeding
+//     the budget in any window.
+//
+//     ./dynais_control
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <common/config.h>
+#include <library/api/dynais_control.h>
+#include <library/common/global_comm.h>
+
+#define WINDOWS MPI_CALLS_TO_CHECK_PERIODIC
+#define STEADY  5 // Last windows of each phase checked
+
+extern ullong dynais_ctl_test_cycles;
+
+// The mode changes are shown by the master, EARL is not linked
+masters_info_t masters_info;
+
+typedef struct window {
+    uint mode;
+    ullong fed;
+    double overhead; // Measured, the cycles spent in DynAIS of the window ones
+} window_t;
+
+static double budget;
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+static void window(ullong gap, ullong cost, window_t *w)
+{
+    ullong start = dynais_ctl_test_cycles, time;
+    uint c;
+
+    w->fed = 0;
+    for (c = 0; c < WINDOWS; c++) {
+        if (dynais_ctl_feeds()) {
+            time = dynais_ctl_begin();
+            dynais_ctl_test_cycles += cost;
+            dynais_ctl_end(time);
+            w->fed++;
+        }
+        dynais_ctl_test_cycles += gap;
+    }
+    w->overhead = (double) (w->fed * cost) / (dynais_ctl_test_cycles - start);
+    w->mode     = dynais_ctl_check();
+}
+
+/* Runs count windows and checks the last ones are in mode, under the budget */
+static void phase(char *name, ullong gap, ullong cost, uint count, uint mode, window_t *w)
+{
+    char msg[256];
+    uint i;
+
+    for (i = 0; i < count; i++) {
+        window(gap, cost, &w[i]);
+    }
+    printf("%-10s cost %6llu gap %9llu: mode %u, %5llu of %u calls fed, overhead %.2lf%%\n", name, cost, gap,
+           w[count - 1].mode, w[count - 1].fed, WINDOWS, w[count - 1].overhead * 100.0);
+    for (i = count - STEADY; i < count; i++) {
+        snprintf(msg, sizeof(msg), "%s: window %u in mode %u, expected %u", name, i, w[i].mode, mode);
+        check(w[i].mode == mode, msg);
+        snprintf(msg, sizeof(msg), "%s: window %u overhead %.2lf%% over the budget", name, i, w[i].overhead * 100.0);
+        check(w[i].overhead <= budget, msg);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char *cbudget = getenv("EAR_MAX_DYNAIS_OVERHEAD");
+    window_t w[40];
+    char msg[256];
+    uint i;
+
+    budget = ((cbudget != NULL) ? atof(cbudget) : MAX_DYNAIS_OVERHEAD) / 100.0;
+    // The time stamp of an untimed call is 0
+    dynais_ctl_test_cycles = 1000000;
+    dynais_ctl_init(budget * 100.0);
+
+    // A call to DynAIS costs a fraction of the budget of the application cycles of a call
+    phase("full", 10000, (ullong) (10000 * budget * 0.4), 20, DYNAIS_MODE_FULL, w);
+    check(w[19].fed == WINDOWS, "the full mode does not feed every call");
+    // Twice the budget
+    phase("sampled", 10000, (ullong) (10000 * budget * 2.0), 20, DYNAIS_MODE_SAMPLED, w);
+    check(w[19].fed <= WINDOWS / 2, "the sampled mode feeds more than half the calls");
+    // Over the budget even with the coarsest sampling
+    phase("periodic", 10000, 100000, 20, DYNAIS_MODE_PERIODIC, w);
+    check(w[19].fed == 0, "the periodic mode feeds calls");
+
+    // The calls are 1000 times less frequent, the way back to the full mode
+    phase("back", 10000000, 100000, 40, DYNAIS_MODE_FULL, w);
+    for (i = 1; i < 40; i++) {
+        snprintf(msg, sizeof(msg), "back: window %u fed %llu calls, %llu the previous one", i, w[i].fed, w[i - 1].fed);
+        check(w[i].fed >= w[i - 1].fed, msg);
+        snprintf(msg, sizeof(msg), "back: window %u overhead %.2lf%% over the budget", i, w[i].overhead * 100.0);
+        check(w[i].overhead <= budget, msg);
+    }
+    check(w[0].mode != DYNAIS_MODE_FULL, "back: the full mode is reached in one step");
+
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
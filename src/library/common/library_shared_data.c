@@ -1299,6 +1299,21 @@ state_t compute_job_node_cpuutil(const shsignature_t *sig, int n_procs, uint *t_
     return EAR_SUCCESS;
 }
 
+static void cache_signature_rates(cache_signature_t *cache)
+{
+    cache->l1d_miss_rate = (cache->l1d_accesses) ? cache->l1d_misses / (double) cache->l1d_accesses : 0;
+    cache->l1d_hit_rate  = (cache->l1d_accesses) ? cache->l1d_hits / (double) cache->l1d_accesses : 0;
+
+    cache->l2_miss_rate = (cache->l2_accesses) ? cache->l2_misses / (double) cache->l2_accesses : 0;
+    cache->l2_hit_rate  = (cache->l2_accesses) ? cache->l2_hits / (double) cache->l2_accesses : 0;
+
+    cache->l3_miss_rate = (cache->l3_accesses) ? cache->l3_misses / (double) cache->l3_accesses : 0;
+    cache->l3_hit_rate  = (cache->l3_accesses) ? cache->l3_hits / (double) cache->l3_accesses : 0;
+
+    cache->ll_miss_rate = (cache->ll_accesses) ? cache->ll_misses / (double) cache->ll_accesses : 0;
+    cache->ll_hit_rate  = (cache->ll_accesses) ? cache->ll_hits / (double) cache->ll_accesses : 0;
+}
+
 state_t compute_job_node_cache_metrics(const shsignature_t *sig, int n_procs, cache_signature_t *cache)
 {
     if (!sig || !cache) {
@@ -1328,18 +1343,54 @@ state_t compute_job_node_cache_metrics(const shsignature_t *sig, int n_procs, ca
         cache->ll_accesses += sig[i].sig.cache.ll_accesses;
     }
 
-    /* Compute rates */
-    cache->l1d_miss_rate = (cache->l1d_accesses) ? cache->l1d_misses / (double) cache->l1d_accesses : 0;
-    cache->l1d_hit_rate  = (cache->l1d_accesses) ? cache->l1d_hits / (double) cache->l1d_accesses : 0;
+    cache_signature_rates(cache);
 
-    cache->l2_miss_rate = (cache->l2_accesses) ? cache->l2_misses / (double) cache->l2_accesses : 0;
-    cache->l2_hit_rate  = (cache->l2_accesses) ? cache->l2_hits / (double) cache->l2_accesses : 0;
+    return EAR_SUCCESS;
+}
 
-    cache->l3_miss_rate = (cache->l3_accesses) ? cache->l3_misses / (double) cache->l3_accesses : 0;
-    cache->l3_hit_rate  = (cache->l3_accesses) ? cache->l3_hits / (double) cache->l3_accesses : 0;
+state_t compute_job_node_totals(const shsignature_t *sig, int n_procs, job_node_totals_t *totals)
+{
+    const ssig_t *s;
+    int i, f;
 
-    cache->ll_miss_rate = (cache->ll_accesses) ? cache->ll_misses / (double) cache->ll_accesses : 0;
-    cache->ll_hit_rate  = (cache->ll_accesses) ? cache->ll_hits / (double) cache->ll_accesses : 0;
+    if (!sig || !totals) {
+        return_msg(EAR_ERROR, Generr.input_null);
+    }
+    memset(totals, 0, sizeof(job_node_totals_t));
+    if (!n_procs) {
+        return_msg(EAR_WARNING, "Number of processes is zero.");
+    }
+    /* All the per-process accumulations in a single pass over the shared region */
+    for (i = 0; i < n_procs; i++) {
+        s = &sig[i].sig;
+        totals->instructions += s->instructions;
+        totals->cycles += s->cycles;
+        totals->fetch_decode += s->stalls.fetch_decode;
+        totals->resources += s->stalls.resources;
+        totals->memory += s->stalls.memory;
+        totals->L1_misses += s->L1_misses;
+        totals->L2_misses += s->L2_misses;
+        totals->L3_misses += s->L3_misses;
+        totals->Gflops += s->Gflops;
+        totals->IO_MBS += (double) s->IO_MBS;
+        totals->cpu_util += sig[i].cpu_util;
+        for (f = 0; f < FLOPS_EVENTS; f++) {
+            totals->FLOPS[f] += s->FLOPS[f];
+        }
+        totals->cache.l1d_misses += s->cache.l1d_misses;
+        totals->cache.l2_misses += s->cache.l2_misses;
+        totals->cache.l3_misses += s->cache.l3_misses;
+        totals->cache.ll_misses += s->cache.ll_misses;
+        totals->cache.l1d_hits += s->cache.l1d_hits;
+        totals->cache.l2_hits += s->cache.l2_hits;
+        totals->cache.l3_hits += s->cache.l3_hits;
+        totals->cache.ll_hits += s->cache.ll_hits;
+        totals->cache.l1d_accesses += s->cache.l1d_accesses;
+        totals->cache.l2_accesses += s->cache.l2_accesses;
+        totals->cache.l3_accesses += s->cache.l3_accesses;
+        totals->cache.ll_accesses += s->cache.ll_accesses;
+    }
+    cache_signature_rates(&totals->cache);
 
     return EAR_SUCCESS;
 }
@@ -126,6 +126,23 @@ typedef struct shsignature {
     uint cpu_util; /*!< The CPU utilization computed from Proc Stat */
 } shsignature_t;
 
+/** Accumulation of the per-process metrics of a job in a node. */
+typedef struct job_node_totals {
+    ullong instructions;
+    ullong cycles;
+    ullong fetch_decode;
+    ullong resources;
+    ullong memory;
+    ullong FLOPS[FLOPS_EVENTS];
+    ullong L1_misses;
+    ullong L2_misses;
+    ullong L3_misses;
+    double Gflops;
+    double IO_MBS;
+    uint cpu_util;
+    cache_signature_t cache;
+} job_node_totals_t;
+
 typedef struct node_mgr_sh_data {
     job_id jid;
     job_id sid;
@@ -531,6 +548,11 @@ state_t compute_job_node_gflops(const shsignature_t *sig, int n_procs, double *t
  */
 state_t compute_job_node_cache_metrics(const shsignature_t *sig, int n_procs, cache_signature_t *cache);
 
+/** Computes in a single pass over \p sig all the accumulations that the
+ * compute_job_node_* functions compute separately. The rates of the cache
+ * metrics are also computed. */
+state_t compute_job_node_totals(const shsignature_t *sig, int n_procs, job_node_totals_t *totals);
+
 uint compute_max_vpi_idx(const shsignature_t *sig, int n_procs, double *max_vpi);
 
 void compute_total_io(lib_shared_data_t *data, shsignature_t *sig, ullong *total_io);
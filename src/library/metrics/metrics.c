@@ -76,6 +76,9 @@
 #if METRICS_OVH
 #include <common/utils/overhead.h>
 #endif
+#if METRICS_ALLOC_STATS
+#include <malloc.h>
+#endif
 
 #if DLB_SUPPORT
 #include <library/metrics/dlb_talp_lib.h>
@@ -121,6 +124,21 @@
         verbose_master(vl, msg);                                                                                       \
     }
 
+#if METRICS_ALLOC_STATS
+/* Counters of the signature computation path. Allocations and signature
+ * copies are counted in place. The heap growth is measured by the allocator,
+ * so it also includes the allocations done by the metrics modules. */
+static ulong stats_signatures;
+static ulong stats_allocs;
+static ulong stats_copies;
+static ulong stats_heap;
+#define stats_alloc() stats_allocs++
+#define stats_copy()  stats_copies++
+#else
+#define stats_alloc()
+#define stats_copy()
+#endif
+
 #if METRICS_OVH
 uint id_ovh_partial_stop;
 uint id_ovh_compute_data;
@@ -1190,8 +1208,11 @@ static void metrics_partial_start()
 
     /* These data is measured only by the master */
     if (master) {
-        /* Avg CPU freq */
-        cpufreq_data_copy(cpufreq_read1[LOO], cpufreq_read2[LOO]);
+        /* Avg CPU freq: the snapshots are swapped instead of copied, read2 is
+         * always read again before computing the next difference. */
+        cpufreq_t *cpufreq_aux = cpufreq_read1[LOO];
+        cpufreq_read1[LOO]     = cpufreq_read2[LOO];
+        cpufreq_read2[LOO]     = cpufreq_aux;
         debug("cpufreq_read ");
 
         /* Avg IMC freq */
@@ -1208,7 +1229,9 @@ static void metrics_partial_start()
         /*  Avoidable since at global start: gpu_metrics_read2[LOO] <- gpu_metrics_read1[APP]
            if (gpu_loop_stopped) {
          */
-        gpu_data_copy(gpu_metrics_read1[LOO], gpu_metrics_read2[LOO]);
+        gpu_t *gpu_aux         = gpu_metrics_read1[LOO];
+        gpu_metrics_read1[LOO] = gpu_metrics_read2[LOO];
+        gpu_metrics_read2[LOO] = gpu_aux;
         /*
            } else {
            gpu_data_copy(gpu_metrics_read1[LOO], gpu_metrics_read1[APP]);
@@ -1428,6 +1451,8 @@ static int metrics_partial_stop(uint where)
         /* Avg CPU freq */
         if (state_fail(s = cpufreq_read(no_ctx, cpufreq_read2[LOO]))) {
             verbose_warning_master("CPUFreq data read in partial stop failed.");
+            // Snapshots are swapped, so the old one is diffed against itself
+            cpufreq_data_copy(cpufreq_read2[LOO], cpufreq_read1[LOO]);
         }
 
 #if METRICS_OVH
@@ -1632,6 +1657,7 @@ static void metrics_compute_signature_data(uint sign_app_loop_idx, signature_t *
 
     if (metrics->sig_ext == NULL) {
         metrics->sig_ext = (void *) calloc(1, sizeof(sig_ext_t));
+        stats_alloc();
     }
     sig_ext_t *sig_ext = metrics->sig_ext;
 
@@ -1950,6 +1976,8 @@ static void metrics_compute_signature_data(uint sign_app_loop_idx, signature_t *
     if (master) {
         signature_copy(&lib_shared_region->node_signature, metrics);
         signature_copy(&lib_shared_region->job_signature, metrics);
+        stats_copy();
+        stats_copy();
 
         if (VERB_ON(2)) {
             signature_print_simple_fd(verb_channel, metrics);
@@ -2275,6 +2303,10 @@ void metrics_dispose(signature_t *metrics, ulong procs, uint job_node_ratio)
     if (masters_info.my_master_rank >= 0)
         overhead_report(1);
 #endif
+#if METRICS_ALLOC_STATS
+    verbose(0, "EARL[%d] signature path: %lu signatures, %lu allocations, %lu copies, %lu heap bytes", my_node_id,
+            stats_signatures, stats_allocs, stats_copies, stats_heap);
+#endif
 
     // metrics->sig_ext = NULL;
     signature_copy(&last_loop_sig, metrics);
@@ -2401,6 +2433,26 @@ void metrics_dispose(signature_t *metrics, ulong procs, uint job_node_ratio)
     debug("Metrics_dispose_end %d", my_node_id);
 }
 
+#if METRICS_ALLOC_STATS
+static size_t heap_in_use()
+{
+#if __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+    return (size_t) mi.uordblks + (size_t) mi.hblkhd;
+}
+
+void metrics_alloc_stats(ulong *signatures, ulong *allocs, ulong *copies, ulong *heap_bytes)
+{
+    *signatures = stats_signatures;
+    *allocs     = stats_allocs;
+    *copies     = stats_copies;
+    *heap_bytes = stats_heap;
+}
+#endif
+
 void metrics_compute_signature_begin()
 {
     metrics_partial_stop(SIG_BEGIN);
@@ -2481,8 +2533,16 @@ state_t metrics_compute_signature_finish(signature_t *metrics, uint iterations,
         last_sig_elapsed = elap_time;
         last_iterations  = iterations;
 
+#if METRICS_ALLOC_STATS
+        size_t heap_before = heap_in_use();
+#endif
         // Marks the signature as ready
         metrics_compute_signature_data(LOO, metrics, iterations, procs);
+#if METRICS_ALLOC_STATS
+        size_t heap_after = heap_in_use();
+        stats_heap += (heap_after > heap_before) ? heap_after - heap_before : 0;
+        stats_signatures++;
+#endif
 
 #if METRICS_OVH
         overhead_stop(id_ovh_compute_data);
@@ -2544,62 +2604,48 @@ long long metrics_usecs_diff(long long end, long long init)
 
 void metrics_app_node_signature(signature_t *master, signature_t *ns)
 {
-    ullong inst, max_inst = 0;
-    ullong cycles;
-    ullong FLOPS[FLOPS_EVENTS];
-    sig_ext_t *se;
-    int i;
+    job_node_totals_t totals;
+    ullong max_inst = 0;
     ulong valid_period;
-    ullong L1, L2, L3;
     ullong accesses = 0;
-    double io_mbs;
+    state_t s;
+    int i;
 
-    se = (sig_ext_t *) master->sig_ext;
-    signature_copy(ns, master);
-    if (se != NULL)
-        memcpy(ns->sig_ext, se, sizeof(sig_ext_t));
+    // The copy also shares master's sig_ext with ns.
+    if (ns != master) {
+        signature_copy(ns, master);
+        stats_copy();
+    }
 
     debug("metrics_app_node_signature");
 
-    compute_job_node_instructions(sig_shared_region, lib_shared_region->num_processes, &inst);
-    compute_job_node_cycles(sig_shared_region, lib_shared_region->num_processes, &cycles);
-    compute_job_node_stalls_fetch_decode(sig_shared_region, lib_shared_region->num_processes, &ns->stalls.fetch_decode);
-    compute_job_node_stalls_resources(sig_shared_region, lib_shared_region->num_processes, &ns->stalls.resources);
-    compute_job_node_stalls_memory(sig_shared_region, lib_shared_region->num_processes, &ns->stalls.memory);
-    compute_job_node_io_mbs(sig_shared_region, lib_shared_region->num_processes, &io_mbs);
-
-    ns->CPI    = (inst ? (double) cycles / (double) inst : 1);
-    ns->IO_MBS = io_mbs;
-
-    compute_job_node_flops(sig_shared_region, lib_shared_region->num_processes, FLOPS);
-
-    compute_job_node_L1_misses(sig_shared_region, lib_shared_region->num_processes, &L1);
-    compute_job_node_L2_misses(sig_shared_region, lib_shared_region->num_processes, &L2);
-    compute_job_node_L3_misses(sig_shared_region, lib_shared_region->num_processes, &L3);
-    compute_job_node_cache_metrics(sig_shared_region, lib_shared_region->num_processes, &ns->cache);
-
-    for (i = 0; i < FLOPS_EVENTS; i++) {
-        ns->FLOPS[i] = FLOPS[i];
-    }
+    // A warning (no processes) leaves the totals zeroed. On error, ns keeps the
+    // values of the master.
+    memset(&totals, 0, sizeof(job_node_totals_t));
+    if (state_fail(s = compute_job_node_totals(sig_shared_region, lib_shared_region->num_processes, &totals)) &&
+        (s != EAR_WARNING)) {
+        verbose_warning("Error on computing job's node totals: %s", state_msg);
+    } else {
+        ns->stalls.fetch_decode = totals.fetch_decode;
+        ns->stalls.resources    = totals.resources;
+        ns->stalls.memory       = totals.memory;
+        ns->CPI                 = (totals.instructions ? (double) totals.cycles / (double) totals.instructions : 1);
+        ns->IO_MBS              = totals.IO_MBS;
+        ns->cache               = totals.cache;
+        ns->Gflops              = totals.Gflops;
+        ns->ps_sig.cpu_util     = totals.cpu_util;
 
-    if (state_fail(compute_job_node_gflops(sig_shared_region, lib_shared_region->num_processes, &ns->Gflops))) {
-        verbose_warning("Error on computing job's node GFLOP/s rate: %s", state_msg);
-    }
+        for (i = 0; i < FLOPS_EVENTS; i++) {
+            ns->FLOPS[i] = totals.FLOPS[i];
+        }
 
-    /* Proc stat aggregation */
-    uint total_cpuutil = 0;
-    if (state_fail(compute_job_node_cpuutil(sig_shared_region, lib_shared_region->num_processes, &total_cpuutil))) {
-        verbose_warning("Error computing application's node total CPU util: %s", state_msg);
-    } else {
-        ns->ps_sig.cpu_util = total_cpuutil;
+        ns->L1_misses    = totals.L1_misses;
+        ns->L2_misses    = totals.L2_misses;
+        ns->L3_misses    = totals.L3_misses;
+        ns->cycles       = totals.cycles;
+        ns->instructions = totals.instructions;
     }
 
-    ns->L1_misses    = L1;
-    ns->L2_misses    = L2;
-    ns->L3_misses    = L3;
-    ns->cycles       = cycles;
-    ns->instructions = inst;
-
     uint tcpus     = 0;
     ns->DC_power   = 0;
     ns->GBS        = 0;
@@ -2630,83 +2676,55 @@ void metrics_app_node_signature(signature_t *master, signature_t *ns)
         ns->avg_f = (tcpus ? ns->avg_f / (double) tcpus : ns->avg_f);
         ns->TPI   = (max_inst ? (double) accesses / (double) max_inst : 1);
         /* TPI should be computed based on total instructions */
-        verbose_master(TPI_DEBUG, "AVG  %lu TPI %.2lf (accesses %llu, inst %llu) ", ns->avg_f, ns->TPI, accesses, inst);
+        verbose_master(TPI_DEBUG, "AVG  %lu TPI %.2lf (accesses %llu, inst %llu) ", ns->avg_f, ns->TPI, accesses,
+                       totals.instructions);
     }
     signature_copy(&lib_shared_region->node_signature, ns);
+    stats_copy();
 }
 
 void metrics_job_signature(const signature_t *master, signature_t *dst)
 {
-    ullong inst;
-    ullong cycles;
-    ullong FLOPS[FLOPS_EVENTS];
-    ullong L1, L2, L3;
-    ullong fetch_decode, resources, memory;
-
     signature_copy(dst, master);
+    stats_copy();
+    metrics_job_signature_update(dst);
+}
 
-    /* If some job node computation fails, we use the CPI data we had from \p master */
-    if (state_fail(compute_job_node_instructions(sig_shared_region, lib_shared_region->num_processes, &inst))) {
-        verbose_warning("Error on computing job's node instructions: %s", state_msg);
-    } else if (state_fail(compute_job_node_cycles(sig_shared_region, lib_shared_region->num_processes, &cycles))) {
-        verbose_warning("Error on computing job's node cycles: %s", state_msg);
-    } else {
-
-        dst->cycles       = cycles;
-        dst->instructions = inst;
+void metrics_job_signature_update(signature_t *dst)
+{
+    job_node_totals_t totals;
 
-        assert(inst != 0);
-        dst->CPI = (double) cycles / (double) inst;
-    }
-    if (state_fail(
-            compute_job_node_stalls_fetch_decode(sig_shared_region, lib_shared_region->num_processes, &fetch_decode))) {
-        verbose_warning("Error on computing job's node stalls' fetch decode: %s", state_msg);
-    } else {
-        dst->stalls.fetch_decode = fetch_decode;
-    }
-    if (state_fail(
-            compute_job_node_stalls_resources(sig_shared_region, lib_shared_region->num_processes, &resources))) {
-        verbose_warning("Error on computing job's node stalls' resources: %s", state_msg);
-    } else {
-        dst->stalls.resources = resources;
-    }
-    if (state_fail(compute_job_node_stalls_memory(sig_shared_region, lib_shared_region->num_processes, &memory))) {
-        verbose_warning("Error on computing job's node stalls' memory: %s", state_msg);
-    } else {
-        dst->stalls.memory = memory;
+    /* If the job node computation fails, we keep the data \p dst had */
+    if (state_fail(compute_job_node_totals(sig_shared_region, lib_shared_region->num_processes, &totals))) {
+        verbose_warning("Error on computing job's node totals: %s", state_msg);
+        return;
     }
 
-    if (state_fail(compute_job_node_flops(sig_shared_region, lib_shared_region->num_processes, FLOPS))) {
-        verbose_warning("Error on computing job's node FLOPs events: %s", state_msg);
-    } else {
-        for (uint i = 0; i < FLOPS_EVENTS; i++) {
-            dst->FLOPS[i] = FLOPS[i];
-        }
-    }
+    dst->cycles       = totals.cycles;
+    dst->instructions = totals.instructions;
 
-    if (state_fail(compute_job_node_gflops(sig_shared_region, lib_shared_region->num_processes, &dst->Gflops))) {
-        verbose_warning("Error on computing job's node GFLOP/s rate: %s", state_msg);
-    }
+    assert(totals.instructions != 0);
+    dst->CPI = (double) totals.cycles / (double) totals.instructions;
+
+    dst->stalls.fetch_decode = totals.fetch_decode;
+    dst->stalls.resources    = totals.resources;
+    dst->stalls.memory       = totals.memory;
 
-    compute_job_node_io_mbs(sig_shared_region, lib_shared_region->num_processes, &dst->IO_MBS);
+    for (uint i = 0; i < FLOPS_EVENTS; i++) {
+        dst->FLOPS[i] = totals.FLOPS[i];
+    }
 
-    compute_job_node_L1_misses(sig_shared_region, lib_shared_region->num_processes, &L1);
-    compute_job_node_L2_misses(sig_shared_region, lib_shared_region->num_processes, &L2);
-    compute_job_node_L3_misses(sig_shared_region, lib_shared_region->num_processes, &L3);
-    compute_job_node_cache_metrics(sig_shared_region, lib_shared_region->num_processes, &dst->cache);
+    dst->Gflops = totals.Gflops;
+    dst->IO_MBS = totals.IO_MBS;
+    dst->cache  = totals.cache;
 
-    dst->L1_misses = L1;
-    dst->L2_misses = L2;
-    dst->L3_misses = L3;
+    dst->L1_misses = totals.L1_misses;
+    dst->L2_misses = totals.L2_misses;
+    dst->L3_misses = totals.L3_misses;
 
     /* Proc stat aggregation */
-    uint total_cpuutil = 0;
-    if (state_fail(compute_job_node_cpuutil(sig_shared_region, lib_shared_region->num_processes, &total_cpuutil))) {
-        verbose_warning("Error computing application's node total CPU util: %s", state_msg);
-    } else {
-        debug("Total CPU util: %u", total_cpuutil);
-        dst->ps_sig.cpu_util = total_cpuutil;
-    }
+    debug("Total CPU util: %u", totals.cpu_util);
+    dst->ps_sig.cpu_util = totals.cpu_util;
 }
 
 extern uint last_earl_phase_classification;
@@ -96,6 +96,9 @@ unsigned long long metrics_vec_inst(signature_t *metrics);
 /** Computes the job signature including data from other processes. */
 void metrics_job_signature(const signature_t *master, signature_t *dst);
 
+/** Like metrics_job_signature, but computed in place over the signature (the master) \p dst. */
+void metrics_job_signature_update(signature_t *dst);
+
 /** Computes the node signature at app end */
 void metrics_app_node_signature(signature_t *master, signature_t *ns);
 
@@ -105,6 +108,12 @@ void compute_per_process_and_job_metrics(signature_t *sig);
 /* Computes metrics per-iteration, very lightweight */
 state_t metrics_new_iteration(signature_t *sig);
 
+#if METRICS_ALLOC_STATS
+/** Returns the number of signatures computed, and the allocations, signature copies and
+ * heap bytes grown while computing them (requires METRICS_ALLOC_STATS in config_def.h). */
+void metrics_alloc_stats(ulong *signatures, ulong *allocs, ulong *copies, ulong *heap_bytes);
+#endif
+
 /* Resets metrics for new processes , after fork*/
 void metrics_lib_reset();
 
@@ -41,6 +41,8 @@ struct energy_model_s {
     state_t (*model_project_power)(signature_t *signature, ulong from_ps, ulong to_ps, double *proj_power);
     uint (*model_projection_available)(ulong from_ps, ulong to_ps);
     uint (*model_any_projection_available)();
+    state_t (*model_project_all)(signature_t *signature, ulong from_ps, uint num_ps, double *proj_time,
+                                 double *proj_power, uint *available);
 };
 
 typedef enum em {
@@ -50,9 +52,9 @@ typedef enum em {
 
 static const char *energy_model_sym_names[] = {"energy_model_init", "energy_model_project_time",
                                                "energy_model_project_power", "energy_model_projection_available",
-                                               "energy_model_any_projection_available"};
+                                               "energy_model_any_projection_available", "energy_model_project_all"};
 
-static const int model_sym_cnt = 5;
+static const int model_sym_cnt = 6;
 
 static energy_model_t energy_model_load(settings_conf_t *sconf, architecture_t *arch_desc, em_t em_type);
 
@@ -91,6 +93,27 @@ state_t energy_model_project_power(energy_model_t energy_model, signature_t *sig
     freturn(energy_model->model_project_power, signature, from_ps, to_ps, proj_power);
 }
 
+state_t energy_model_project_all(energy_model_t energy_model, signature_t *signature, ulong from_ps, uint num_ps,
+                                 double *proj_time, double *proj_power, uint *available)
+{
+    uint to_ps;
+
+    assert_null(energy_model);
+    if (energy_model->model_project_all != NULL) {
+        return energy_model->model_project_all(signature, from_ps, num_ps, proj_time, proj_power, available);
+    }
+    for (to_ps = 0; to_ps < num_ps; to_ps++) {
+        proj_time[to_ps]  = 0;
+        proj_power[to_ps] = 0;
+        available[to_ps]  = energy_model_projection_available(energy_model, from_ps, to_ps);
+        if (available[to_ps]) {
+            energy_model_project_time(energy_model, signature, from_ps, to_ps, &proj_time[to_ps]);
+            energy_model_project_power(energy_model, signature, from_ps, to_ps, &proj_power[to_ps]);
+        }
+    }
+    return EAR_SUCCESS;
+}
+
 uint energy_model_projection_available(energy_model_t energy_model, ulong from_ps, ulong to_ps)
 {
     if (energy_model) {
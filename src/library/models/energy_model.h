@@ -68,6 +68,20 @@ state_t energy_model_project_time(energy_model_t energy_model, signature_t *sign
 state_t energy_model_project_power(energy_model_t energy_model, signature_t *signature, ulong from_ps, ulong to_ps,
                                    double *proj_power);
 
+/** Projects the execution time and power consumption of the signature given as input argument from
+ * \ref from_ps to each of the first \ref num_ps P-States in a single call. Models implementing it project the
+ * whole row at once, otherwise the single pair functions are used.
+ * \param[in]  energy_model A loaded energy model.
+ * \param[in]  signature    The input signature for the model.
+ * \param[in]  from_ps      The P-State index you want the model to project from.
+ * \param[in]  num_ps       The number of target P-States, from 0 to num_ps - 1.
+ * \param[out] proj_time    An array of num_ps elements filled with the projected execution times.
+ * \param[out] proj_power   An array of num_ps elements filled with the projected power consumptions.
+ * \param[out] available    An array of num_ps elements filled like \ref energy_model_projection_available. The
+ *                          projections of the P-States not available are 0. */
+state_t energy_model_project_all(energy_model_t energy_model, signature_t *signature, ulong from_ps, uint num_ps,
+                                 double *proj_time, double *proj_power, uint *available);
+
 /** Checks whether the loaded model has a projection from \ref from_ps to \ref to_ps.
  * Model's implementation dependant.
  * \return 0 If the input argument is invalid.
@@ -19,7 +19,7 @@
 #include <management/cpufreq/frequency.h>
 #include <stdlib.h>
 
-static coefficient_t **coefficients;
+static em_coeffs_t coefficients;
 static coefficient_t *coefficients_sm;
 static int num_coeffs;
 static uint num_pstates;
@@ -70,22 +70,16 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
     debug("Pstate for maximum freq avx512 %lu=%d Pstate for maximum freq avx2 %lu=%d", arch.max_freq_avx512,
           avx512_pstate, arch.max_freq_avx2, avx2_pstate);
 
-    coefficients = (coefficient_t **) malloc(sizeof(coefficient_t *) * num_pstates);
-
-    if (coefficients == NULL) {
+    if (state_fail(em_coeffs_alloc(&coefficients, num_pstates))) {
         return EAR_ERROR;
     }
     for (i = 0; i < num_pstates; i++) {
-        coefficients[i] = (coefficient_t *) malloc(sizeof(coefficient_t) * num_pstates);
-        if (coefficients[i] == NULL) {
-            return EAR_ERROR;
-        }
-
         for (ref = 0; ref < num_pstates; ref++) {
+            coefficient_t coeff = {0};
 
-            coefficients[i][ref].pstate_ref = frequency_pstate_to_freq(i);
-            coefficients[i][ref].pstate     = frequency_pstate_to_freq(ref);
-            coefficients[i][ref].available  = 0;
+            coeff.pstate_ref = frequency_pstate_to_freq(i);
+            coeff.pstate     = frequency_pstate_to_freq(ref);
+            em_coeffs_set(&coefficients, i, ref, &coeff);
         }
     }
 
@@ -122,12 +116,15 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
     if (num_coeffs > 0) {
         num_coeffs = num_coeffs / sizeof(coefficient_t);
 
+        coefficient_t coeff_sm;
         int ccoeff;
         for (ccoeff = 0; ccoeff < num_coeffs; ccoeff++) {
             ref = frequency_closest_pstate(coefficients_sm[ccoeff].pstate_ref);
             i   = frequency_closest_pstate(coefficients_sm[ccoeff].pstate);
             if (frequency_is_valid_pstate(ref) && frequency_is_valid_pstate(i)) {
-                memcpy(&coefficients[ref][i], &coefficients_sm[ccoeff], sizeof(coefficient_t));
+                // EARD can be refining the entry
+                coeff_read(&coeff_sm, &coefficients_sm[ccoeff]);
+                em_coeffs_set(&coefficients, ref, i, &coeff_sm);
                 // verbose_master(3,"initializing coeffs for ref: %d i: %d\n", ref, i);
             }
         }
@@ -149,7 +146,7 @@ state_t energy_model_project_time(signature_t *signature, ulong from_ps, ulong t
     }
 
     if (basic_model_init && valid_range(from_ps, to_ps)) {
-        coeff = &coefficients[from_ps][to_ps];
+        coeff = em_coeffs_get(&coefficients, from_ps, to_ps);
         if (coeff->available) {
             time_nosimd = project_time(coeff, signature, coeff->pstate_ref, coeff->pstate);
             perc_avx512 = avx512_vpi(signature);
@@ -164,7 +161,7 @@ state_t energy_model_project_time(signature_t *signature, ulong from_ps, ulong t
                 else
                     pdest = 1;
                 unsigned long nominal = frequency_pstate_to_freq(pdest);
-                avx512_coeffs         = &coefficients[from_ps][pdest];
+                avx512_coeffs         = em_coeffs_get(&coefficients, from_ps, pdest);
                 time_avx512           = project_time(avx512_coeffs, signature, coeff->pstate_ref, nominal);
             } else {
                 perc_avx512 = 0;
@@ -201,7 +198,7 @@ state_t energy_model_project_power(signature_t *signature, ulong from_ps, ulong
     }
 
     if (basic_model_init && valid_range(from_ps, to_ps)) {
-        coeff = &coefficients[from_ps][to_ps];
+        coeff = em_coeffs_get(&coefficients, from_ps, to_ps);
         if (coeff->available) {
             power_nosimd = project_power(coeff, signature);
             // Is this <= or >= ?? :(
@@ -216,7 +213,7 @@ state_t energy_model_project_power(signature_t *signature, ulong from_ps, ulong
                     pdest = avx512_pstate;
                 else
                     pdest = avx512_pstate;
-                avx512_coeffs = &coefficients[from_ps][pdest];
+                avx512_coeffs = em_coeffs_get(&coefficients, from_ps, pdest);
                 power_avx512  = project_power(avx512_coeffs, signature);
             } else {
                 perc_avx512 = 0;
@@ -235,6 +232,54 @@ state_t energy_model_project_power(signature_t *signature, ulong from_ps, ulong
     return st;
 }
 
+state_t energy_model_project_all(signature_t *signature, ulong from_ps, uint num_ps, double *proj_time,
+                                 double *proj_power, uint *available)
+{
+    double time_avx512[2], power_avx512 = 0, perc_avx512;
+    coefficient_t *avx512_coeffs;
+    uint count = ear_min(num_ps, num_pstates);
+    ulong pdest[2];
+    uint to_ps, up;
+
+    if (!basic_model_init || from_ps >= num_pstates) {
+        return EAR_ERROR;
+    }
+    em_common_project_row(&coefficients, signature, from_ps, count, proj_time, proj_power, available);
+
+    /* The AVX512 terms only depend on the direction, they are computed once. The rows
+     * keep the same reference frequency, so the ratio is applied for each target. */
+    perc_avx512 = avx512_vpi(signature);
+    pdest[0]    = 1;
+    pdest[1]    = avx512_pstate;
+    for (up = 0; up < 2 && perc_avx512 > 0.0; up++) {
+        avx512_coeffs   = em_coeffs_get(&coefficients, from_ps, pdest[up]);
+        time_avx512[up] = (signature->time * em_common_project_cpi(signature, avx512_coeffs)) / signature->CPI;
+    }
+    if (perc_avx512 > 0.0) {
+        power_avx512 = project_power(em_coeffs_get(&coefficients, from_ps, avx512_pstate), signature);
+    }
+
+    for (to_ps = 0; to_ps < num_ps; to_ps++) {
+        if (to_ps == from_ps) {
+            proj_time[to_ps]  = signature->time;
+            proj_power[to_ps] = signature->DC_power;
+        } else if (to_ps >= count || !available[to_ps]) {
+            proj_time[to_ps]  = 0;
+            proj_power[to_ps] = 0;
+            available[to_ps]  = 0;
+        } else if (to_ps < avx512_pstate && perc_avx512 > 0.0) {
+            /* from_ps > to_ps means from lower cpufreq to high cpufreq */
+            up                = (from_ps > to_ps);
+            proj_time[to_ps]  = proj_time[to_ps] * (1 - perc_avx512) +
+                               time_avx512[up] * ((double) em_coeffs_get(&coefficients, from_ps, to_ps)->pstate_ref /
+                                                  (double) frequency_pstate_to_freq(pdest[up])) *
+                                   perc_avx512;
+            proj_power[to_ps] = proj_power[to_ps] * (1 - perc_avx512) + power_avx512 * perc_avx512;
+        }
+    }
+    return EAR_SUCCESS;
+}
+
 uint energy_model_projection_available(ulong from_ps, ulong to_ps)
 {
     return projection_available(from_ps, to_ps);
@@ -283,9 +328,9 @@ static double project_power(coefficient_t *coeff, signature_t *signature)
 static uint projection_available(ulong from_ps, ulong to_ps)
 {
     // verbose_master(2, "projection_available test: from %lu to %lu aval %lu", from_ps, to_ps,
-    // coefficients[from_ps][to_ps].available);
+    // em_coeffs_get(&coefficients, from_ps, to_ps)->available);
     if (valid_range(from_ps, to_ps)) {
-        return coefficients[from_ps][to_ps].available;
+        return em_coeffs_get(&coefficients, from_ps, to_ps)->available;
     }
 
     return 0;
@@ -19,7 +19,7 @@
 #include <management/cpufreq/frequency.h>
 #include <stdlib.h>
 
-static coefficient_t **coefficients;
+static em_coeffs_t coefficients;
 static coefficient_t *coefficients_sm;
 static int num_coeffs;
 static uint num_pstates;
@@ -41,20 +41,16 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
     num_pstates = (uint) arch_desc->pstates;
     debug("Using %u pstates", num_pstates);
 
-    coefficients = (coefficient_t **) malloc(sizeof(coefficient_t *) * num_pstates);
-    if (coefficients == NULL) {
+    if (state_fail(em_coeffs_alloc(&coefficients, num_pstates))) {
         return EAR_ERROR;
     }
     for (i = 0; i < num_pstates; i++) {
-        coefficients[i] = (coefficient_t *) malloc(sizeof(coefficient_t) * num_pstates);
-        if (coefficients[i] == NULL) {
-            return EAR_ERROR;
-        }
-
         for (ref = 0; ref < num_pstates; ref++) {
-            coefficients[i][ref].pstate_ref = frequency_pstate_to_freq(i);
-            coefficients[i][ref].pstate     = frequency_pstate_to_freq(ref);
-            coefficients[i][ref].available  = 0;
+            coefficient_t coeff = {0};
+
+            coeff.pstate_ref = frequency_pstate_to_freq(i);
+            coeff.pstate     = frequency_pstate_to_freq(ref);
+            em_coeffs_set(&coefficients, i, ref, &coeff);
         }
     }
 
@@ -88,12 +84,15 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
 
     if (num_coeffs > 0) {
         num_coeffs = num_coeffs / sizeof(coefficient_t);
+        coefficient_t coeff_sm;
         int ccoeff;
         for (ccoeff = 0; ccoeff < num_coeffs; ccoeff++) {
             ref = frequency_closest_pstate(coefficients_sm[ccoeff].pstate_ref);
             i   = frequency_closest_pstate(coefficients_sm[ccoeff].pstate);
             if (frequency_is_valid_pstate(ref) && frequency_is_valid_pstate(i)) {
-                memcpy(&coefficients[ref][i], &coefficients_sm[ccoeff], sizeof(coefficient_t));
+                // EARD can be refining the entry
+                coeff_read(&coeff_sm, &coefficients_sm[ccoeff]);
+                em_coeffs_set(&coefficients, ref, i, &coeff_sm);
                 // verbose_master(3,"initializing coeffs for ref: %d i: %d\n", ref, i);
             }
         }
@@ -102,7 +101,8 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
 #if SHOW_DEBUGS
     for (ref = 0; ref < num_pstates; ref++) {
         for (i = 0; i < num_pstates; i++)
-            debug("coefficient from ref: %d i: %d available: %d\n", ref, i, coefficients[ref][i].available);
+            debug("coefficient from ref: %d i: %d available: %d\n", ref, i,
+                  em_coeffs_get(&coefficients, ref, i)->available);
     }
 #endif
     return EAR_SUCCESS;
@@ -113,7 +113,7 @@ state_t energy_model_project_time(signature_t *signature, ulong from_ps, ulong t
     state_t st = EAR_SUCCESS;
     coefficient_t *coeff;
     if ((basic_model_init) && (valid_range(from_ps, to_ps))) {
-        coeff = &coefficients[from_ps][to_ps];
+        coeff = em_coeffs_get(&coefficients, from_ps, to_ps);
         if (coeff->available) {
             double proj_cpi = em_common_project_cpi(signature, coeff);
             double freq_src = (double) coeff->pstate_ref;
@@ -134,7 +134,7 @@ state_t energy_model_project_power(signature_t *signature, ulong from_ps, ulong
     state_t st = EAR_SUCCESS;
     coefficient_t *coeff;
     if ((basic_model_init) && (valid_range(from_ps, to_ps))) {
-        coeff = &coefficients[from_ps][to_ps];
+        coeff = em_coeffs_get(&coefficients, from_ps, to_ps);
         if (coeff->available) {
             *proj_power = (coeff->A * signature->DC_power) + (coeff->B * signature->TPI) + (coeff->C);
             debug("Power %lf = %lf x %lf + %lf x %lf + %lf", *proj_power, coeff->A, signature->DC_power, coeff->B,
@@ -148,6 +148,26 @@ state_t energy_model_project_power(signature_t *signature, ulong from_ps, ulong
     return st;
 }
 
+state_t energy_model_project_all(signature_t *signature, ulong from_ps, uint num_ps, double *proj_time,
+                                 double *proj_power, uint *available)
+{
+    uint count = ear_min(num_ps, num_pstates);
+    uint to_ps;
+
+    if (!basic_model_init || from_ps >= num_pstates) {
+        return EAR_ERROR;
+    }
+    em_common_project_row(&coefficients, signature, from_ps, count, proj_time, proj_power, available);
+    for (to_ps = 0; to_ps < num_ps; to_ps++) {
+        if (to_ps >= count || !available[to_ps]) {
+            proj_time[to_ps]  = 0;
+            proj_power[to_ps] = 0;
+            available[to_ps]  = 0;
+        }
+    }
+    return EAR_SUCCESS;
+}
+
 uint energy_model_projection_available(ulong from_ps, ulong to_ps)
 {
     return projection_available(from_ps, to_ps);
@@ -176,7 +196,7 @@ static int valid_range(ulong from_ps, ulong to_ps)
 static uint projection_available(ulong from_ps, ulong to_ps)
 {
     if (valid_range(from_ps, to_ps)) {
-        if (coefficients[from_ps][to_ps].available) {
+        if (em_coeffs_get(&coefficients, from_ps, to_ps)->available) {
             return 1;
         }
     }
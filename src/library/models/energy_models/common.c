@@ -8,9 +8,73 @@
  * SPDX-License-Identifier: EPL-2.0
  **************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <library/models/energy_models/common.h>
 
 double em_common_project_cpi(signature_t *signature, coefficient_t *coeff)
 {
     return coeff->D * signature->CPI + coeff->E * signature->TPI + coeff->F;
 }
+
+state_t em_coeffs_alloc(em_coeffs_t *m, uint num_pstates)
+{
+    size_t count = num_pstates * num_pstates;
+    double *terms;
+
+    memset(m, 0, sizeof(em_coeffs_t));
+    m->coeffs    = calloc(count, sizeof(coefficient_t));
+    terms        = calloc(count * 7, sizeof(double));
+    m->available = calloc(count, sizeof(uint));
+    if (m->coeffs == NULL || terms == NULL || m->available == NULL) {
+        free(m->coeffs);
+        free(terms);
+        free(m->available);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    m->num_pstates = num_pstates;
+    m->A           = &terms[count * 0];
+    m->B           = &terms[count * 1];
+    m->C           = &terms[count * 2];
+    m->D           = &terms[count * 3];
+    m->E           = &terms[count * 4];
+    m->F           = &terms[count * 5];
+    m->ratio       = &terms[count * 6];
+    return EAR_SUCCESS;
+}
+
+void em_coeffs_set(em_coeffs_t *m, ulong from, ulong to, coefficient_t *coeff)
+{
+    size_t i = (from * m->num_pstates) + to;
+
+    memcpy(&m->coeffs[i], coeff, sizeof(coefficient_t));
+    m->A[i]         = coeff->A;
+    m->B[i]         = coeff->B;
+    m->C[i]         = coeff->C;
+    m->D[i]         = coeff->D;
+    m->E[i]         = coeff->E;
+    m->F[i]         = coeff->F;
+    m->ratio[i]     = (coeff->pstate) ? (double) coeff->pstate_ref / (double) coeff->pstate : 0.0;
+    m->available[i] = coeff->available;
+}
+
+void em_common_project_row(em_coeffs_t *m, signature_t *signature, ulong from, uint count, double *proj_time,
+                           double *proj_power, uint *available)
+{
+    size_t row = from * m->num_pstates;
+    const double *restrict A = &m->A[row], *restrict B = &m->B[row], *restrict C = &m->C[row];
+    const double *restrict D = &m->D[row], *restrict E = &m->E[row], *restrict F = &m->F[row];
+    const double *restrict ratio = &m->ratio[row];
+    double *restrict time = proj_time, *restrict power = proj_power;
+    double cpi = signature->CPI, tpi = signature->TPI, dc_power = signature->DC_power, sig_time = signature->time;
+    uint to;
+
+    /* Without branches, so the compiler vectorizes it. The operations are in the same order than the single
+     * pair projections, so both give the same result. */
+    for (to = 0; to < count; to++) {
+        time[to]  = ((sig_time * (D[to] * cpi + E[to] * tpi + F[to])) / cpi) * ratio[to];
+        power[to] = A[to] * dc_power + B[to] * tpi + C[to];
+    }
+    memcpy(available, &m->available[row], count * sizeof(uint));
+}
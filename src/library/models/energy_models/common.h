@@ -11,11 +11,44 @@
 #ifndef _EAR_ENERGY_MODELS_COMM_
 #define _EAR_ENERGY_MODELS_COMM_
 
+#include <common/states.h>
 #include <common/types/coefficient.h>
 #include <common/types/signature.h>
 
+/** The coefficients of all the P-State pairs in a single block. The pair
+ * <from, to> is the element from * num_pstates + to, both in coeffs and in the
+ * arrays of each term, which are used to project a whole row at once. */
+typedef struct em_coeffs_s {
+    uint num_pstates;
+    coefficient_t *coeffs;
+    double *A; // Power
+    double *B;
+    double *C;
+    double *D; // CPI
+    double *E;
+    double *F;
+    double *ratio; // pstate_ref / pstate
+    uint *available;
+} em_coeffs_t;
+
+/** Returns the coefficient_t of the pair <from, to>. */
+#define em_coeffs_get(m, from, to) (&(m)->coeffs[((from) * (m)->num_pstates) + (to)])
+
 /** Computes the projection of the \ref signature CPI by using \ref coeff.
  * \pre Input arguments must be initialized. */
 double em_common_project_cpi(signature_t *signature, coefficient_t *coeff);
 
+/** Allocates the coefficients of num_pstates x num_pstates pairs, all of them not available. */
+state_t em_coeffs_alloc(em_coeffs_t *m, uint num_pstates);
+
+/** Sets the coefficients of the pair <from, to>. */
+void em_coeffs_set(em_coeffs_t *m, ulong from, ulong to, coefficient_t *coeff);
+
+/** Projects the \ref signature time and power from \ref from to the first \ref count P-States, using the
+ * CPI and power terms of each pair, and copies their availability. The projection of a pair which is not
+ * available is not meaningful.
+ * \pre from and count must be in the range of the P-States. */
+void em_common_project_row(em_coeffs_t *m, signature_t *signature, ulong from, uint count, double *proj_time,
+                           double *proj_power, uint *available);
+
 #endif // _EAR_ENERGY_MODELS_COMM_
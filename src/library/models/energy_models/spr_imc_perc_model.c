@@ -97,7 +97,8 @@ state_t energy_model_init(char *ear_coeffs_path, char *ear_tmp_path, architectur
             ref = frequency_closest_pstate(coefficients_sm[ccoeff].pstate_ref);
             i   = frequency_closest_pstate(coefficients_sm[ccoeff].pstate);
             if (frequency_is_valid_pstate(ref) && frequency_is_valid_pstate(i)) {
-                memcpy(&coefficients[ref][i], &coefficients_sm[ccoeff], sizeof(coefficient_t));
+                // EARD can be refining the entry
+                coeff_read(&coefficients[ref][i], &coefficients_sm[ccoeff]);
                 debug("initializing coeffs for ref: %d i: %d\n", ref, i);
                 total_coeffs++;
             }
@@ -41,6 +41,32 @@ extern polctx_t my_pol_ctx;
 extern ear_classify_t phases_limits;
 extern settings_conf_t *system_conf;
 
+/* Projections of all the P-States from the current one, see project_all_pstates */
+static double *proj_time_all;
+static double *proj_power_all;
+static uint *proj_available_all;
+static uint proj_all_size;
+
+/** Projects the signature from \ref from to the P-States 0..num_ps-1 in the proj_*_all arrays. */
+static state_t project_all_pstates(signature_t *signature, energy_model_t energy_model, ulong from, uint num_ps)
+{
+    if (num_ps > proj_all_size) {
+        proj_time_all      = realloc(proj_time_all, num_ps * sizeof(double));
+        proj_power_all     = realloc(proj_power_all, num_ps * sizeof(double));
+        proj_available_all = realloc(proj_available_all, num_ps * sizeof(uint));
+        if (proj_time_all == NULL || proj_power_all == NULL || proj_available_all == NULL) {
+            proj_all_size = 0;
+            return_msg(EAR_ERROR, Generr.alloc_error);
+        }
+        proj_all_size = num_ps;
+    }
+    if (state_fail(energy_model_project_all(energy_model, signature, from, num_ps, proj_time_all, proj_power_all,
+                                            proj_available_all))) {
+        memset(proj_available_all, 0, num_ps * sizeof(uint));
+    }
+    return EAR_SUCCESS;
+}
+
 state_t compute_reference(signature_t *signature, energy_model_t energy_model, ulong *curr_freq, ulong *def_freq,
                           ulong *freq_ref, double *time_ref, double *power_ref)
 {
@@ -98,15 +124,17 @@ state_t compute_cpu_freq_min_energy(signature_t *signature, energy_model_t energ
     verbose_master(2, "CPUfreq algorithm for min_energy, projecting from pstate %lu to %lu", minp, maxp);
     if (from == minp)
         minp++;
+    if (state_fail(project_all_pstates(signature, energy_model, from, maxp))) {
+        *newf = best_freq;
+        return EAR_ERROR;
+    }
     for (i = minp; i < maxp; i++) {
 
         verbose_master(3, "CPUfreq algorithm testing pstate %lu", i);
-        if (energy_model_projection_available(energy_model, from, i)) {
+        if (proj_available_all[i]) {
             proj_av++;
-            // If energy_model is invalid, the above condition is false, so we don't need to check
-            // the correctness of the below calls.
-            energy_model_project_power(energy_model, signature, from, i, &power_proj);
-            energy_model_project_time(energy_model, signature, from, i, &time_proj);
+            power_proj = proj_power_all[i];
+            time_proj  = proj_time_all[i];
 
             energy_proj = power_proj * time_proj;
 
@@ -138,7 +166,7 @@ state_t compute_cpu_freq_min_time(signature_t *signature, energy_model_t energy_
 {
     int i;
     uint try_next;
-    double time_current, power_proj, time_proj, freq_gain, perf_gain, vpi;
+    double time_current, time_proj, freq_gain, perf_gain, vpi;
     ulong freq_ref;
 
     compute_sig_vpi(&vpi, signature);
@@ -149,14 +177,13 @@ state_t compute_cpu_freq_min_time(signature_t *signature, energy_model_t energy_
     try_next     = 1;
     i            = best_pstate - 1;
     time_current = time_ref;
+    if (state_fail(project_all_pstates(signature, energy_model, curr_pstate, best_pstate))) {
+        try_next = 0;
+    }
     while (try_next && i >= min_pstate) {
-        if (energy_model_projection_available(energy_model, curr_pstate, i)) {
+        if (proj_available_all[i]) {
             verbose_master(3, "Looking for pstate %d", i);
-
-            // If energy_model is invalid, the above condition is false, so we don't need to check
-            // the correctness of the below calls.
-            energy_model_project_power(energy_model, signature, curr_pstate, i, &power_proj);
-            energy_model_project_time(energy_model, signature, curr_pstate, i, &time_proj);
+            time_proj = proj_time_all[i];
 
             freq_ref  = frequency_pstate_to_freq(i);
             freq_gain = min_eff_gain * (double) (freq_ref - best_freq) / (double) best_freq;
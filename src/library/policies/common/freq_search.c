@@ -0,0 +1,274 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/output/debug.h>
+#include <common/states.h>
+#include <common/types/generic.h>
+#include <library/policies/common/freq_search.h>
+
+#define known(d, x) ((d)->source[x] >= FSEARCH_PROJECTED)
+
+static void dim_clear(fsearch_dim_t *d)
+{
+    memset(d->time, 0, d->count * sizeof(double));
+    memset(d->power, 0, d->count * sizeof(double));
+    memset(d->source, 0, d->count * sizeof(uint));
+}
+
+/* Estimates the states not known by a line between two known ones */
+static void dim_estimate(fsearch_dim_t *d)
+{
+    int x, l, r, count = (int) d->count;
+    double w;
+
+    for (x = 0; x < count; x++) {
+        if (known(d, x)) {
+            continue;
+        }
+        d->source[x] = FSEARCH_UNKNOWN;
+        for (l = x - 1; l >= 0 && !known(d, l); l--)
+            ;
+        for (r = x + 1; r < count && !known(d, r); r++)
+            ;
+        if (l < 0 && r < count) {
+            // Extrapolation to the left from the two first known states
+            for (l = r + 1; l < count && !known(d, l); l++)
+                ;
+            if (l == count || r - x > FSEARCH_EXTRAPOLATION) {
+                continue;
+            }
+        } else if (r == count && l >= 0) {
+            // Extrapolation to the right from the two last known states
+            for (r = l - 1; r >= 0 && !known(d, r); r--)
+                ;
+            if (r < 0 || x - l > FSEARCH_EXTRAPOLATION) {
+                continue;
+            }
+        } else if (l < 0 || r == count) {
+            continue;
+        }
+        w           = (double) (x - l) / (double) (r - l);
+        d->time[x]  = d->time[l] + (d->time[r] - d->time[l]) * w;
+        d->power[x] = d->power[l] + (d->power[r] - d->power[l]) * w;
+        if (d->time[x] > 0.0 && d->power[x] > 0.0) {
+            d->source[x] = FSEARCH_ESTIMATED;
+        }
+    }
+}
+
+state_t fsearch_init(fsearch_t *s, uint cpu_states, uint mem_states, uint gpu_states)
+{
+    uint counts[FSEARCH_DIMS] = {cpu_states, mem_states, gpu_states};
+    fsearch_dim_t *d;
+    uint dim;
+
+    memset(s, 0, sizeof(fsearch_t));
+    for (dim = 0; dim < FSEARCH_DIMS; dim++) {
+        d         = &s->dims[dim];
+        d->count  = ear_max(counts[dim], 1);
+        d->time   = calloc(d->count, sizeof(double));
+        d->power  = calloc(d->count, sizeof(double));
+        d->source = calloc(d->count, sizeof(uint));
+        if (d->time == NULL || d->power == NULL || d->source == NULL) {
+            fsearch_dispose(s);
+            return_msg(EAR_ERROR, Generr.alloc_error);
+        }
+    }
+    if ((s->cpu_available = calloc(s->dims[DOM_CPU].count, sizeof(uint))) == NULL) {
+        fsearch_dispose(s);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    return EAR_SUCCESS;
+}
+
+void fsearch_dispose(fsearch_t *s)
+{
+    uint dim;
+
+    for (dim = 0; dim < FSEARCH_DIMS; dim++) {
+        free(s->dims[dim].time);
+        free(s->dims[dim].power);
+        free(s->dims[dim].source);
+    }
+    free(s->cpu_available);
+    memset(s, 0, sizeof(fsearch_t));
+}
+
+void fsearch_reset(fsearch_t *s, uint dim, uint ref)
+{
+    fsearch_dim_t *d = &s->dims[dim];
+
+    dim_clear(d);
+    d->ref = ear_min(ref, d->count - 1);
+    if (dim == DOM_CPU) {
+        memset(s->cpu_key, 0, sizeof(s->cpu_key));
+    }
+}
+
+void fsearch_observe(fsearch_t *s, uint dim, uint state, double time, double power)
+{
+    fsearch_dim_t *d = &s->dims[dim];
+
+    if (state >= d->count || time <= 0.0) {
+        return;
+    }
+    d->time[state]   = time;
+    d->power[state]  = power;
+    d->source[state] = FSEARCH_MEASURED;
+    dim_estimate(d);
+    debug("Search dimension %u state %u measured: time %.3lf power %.1lf", dim, state, time, power);
+}
+
+state_t fsearch_project_cpu(fsearch_t *s, energy_model_t energy_model, signature_t *signature, ulong from_ps)
+{
+    double key[4]    = {signature->time, signature->CPI, signature->TPI, signature->DC_power};
+    fsearch_dim_t *d = &s->dims[DOM_CPU];
+    uint x;
+
+    if (from_ps >= d->count) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    if (d->ref == from_ps && memcmp(key, s->cpu_key, sizeof(key)) == 0) {
+        return EAR_SUCCESS;
+    }
+    if (state_fail(energy_model_project_all(energy_model, signature, from_ps, d->count, d->time, d->power,
+                                            s->cpu_available))) {
+        memset(s->cpu_available, 0, d->count * sizeof(uint));
+    }
+    for (x = 0; x < d->count; x++) {
+        d->source[x] = (s->cpu_available[x]) ? FSEARCH_PROJECTED : FSEARCH_UNKNOWN;
+    }
+    d->ref             = from_ps;
+    d->time[from_ps]   = signature->time;
+    d->power[from_ps]  = signature->DC_power;
+    d->source[from_ps] = FSEARCH_MEASURED;
+    memcpy(s->cpu_key, key, sizeof(key));
+    return EAR_SUCCESS;
+}
+
+/* Fills the time factor and power difference of the usable states of a dimension, and their minimums */
+static void dim_factors(fsearch_dim_t *d, uint min, uint max, uint measured_only, double *factor, double *delta,
+                        uint *usable, double *factor_min, double *delta_min)
+{
+    uint min_source = (measured_only) ? FSEARCH_PROJECTED : FSEARCH_ESTIMATED;
+    uint ref_known  = known(d, d->ref);
+    uint x;
+
+    *factor_min = 1.0;
+    *delta_min  = 0.0;
+    for (x = 0; x < d->count; x++) {
+        usable[x] = (x == d->ref) || (ref_known && x >= min && x <= max && d->source[x] >= min_source);
+        factor[x] = 1.0;
+        delta[x]  = 0.0;
+        if (usable[x] && x != d->ref) {
+            factor[x]   = d->time[x] / d->time[d->ref];
+            delta[x]    = d->power[x] - d->power[d->ref];
+            *factor_min = ear_min(*factor_min, factor[x]);
+            *delta_min  = ear_min(*delta_min, delta[x]);
+        }
+    }
+}
+
+state_t fsearch_min_energy(fsearch_t *s, uint *min, uint *max, double penalty, uint measured_only,
+                           fsearch_conf_t *best)
+{
+    fsearch_dim_t *cpu = &s->dims[DOM_CPU], *mem = &s->dims[DOM_MEM], *gpu = &s->dims[DOM_GPU];
+    double *factor[FSEARCH_DIMS], *delta[FSEARCH_DIMS], fmin[FSEARCH_DIMS], dmin[FSEARCH_DIMS];
+    double time_max, energy_best, time_c, power_c, time_m, power_m, time, power;
+    uint *usable[FSEARCH_DIMS], dim, c, m, g;
+    state_t ret = EAR_SUCCESS;
+
+    if (!known(cpu, cpu->ref)) {
+        return_msg(EAR_ERROR, "the CPU reference is not known");
+    }
+    for (dim = 0; dim < FSEARCH_DIMS; dim++) {
+        factor[dim] = calloc(s->dims[dim].count, sizeof(double));
+        delta[dim]  = calloc(s->dims[dim].count, sizeof(double));
+        usable[dim] = calloc(s->dims[dim].count, sizeof(uint));
+        if (factor[dim] == NULL || delta[dim] == NULL || usable[dim] == NULL) {
+            ret = EAR_ERROR;
+        } else {
+            dim_factors(&s->dims[dim], min[dim], max[dim], measured_only, factor[dim], delta[dim], usable[dim],
+                        &fmin[dim], &dmin[dim]);
+        }
+    }
+    if (state_fail(ret)) {
+        goto release;
+    }
+    best->state[DOM_CPU] = cpu->ref;
+    best->state[DOM_MEM] = mem->ref;
+    best->state[DOM_GPU] = gpu->ref;
+    best->time           = cpu->time[cpu->ref];
+    best->power          = cpu->power[cpu->ref];
+    best->measured       = 1;
+    time_max             = best->time * (1.0 + penalty);
+    energy_best          = best->time * best->power;
+    s->evaluated         = 0;
+
+    for (c = 0; c < cpu->count; c++) {
+        if (!usable[DOM_CPU][c]) {
+            continue;
+        }
+        time_c  = cpu->time[c];
+        power_c = cpu->power[c];
+        // Neither the time nor the energy can be lower than with the best IMC and GPU states
+        time = time_c * fmin[DOM_MEM] * fmin[DOM_GPU];
+        if (time > time_max || (power_c + dmin[DOM_MEM] + dmin[DOM_GPU]) * time >= energy_best) {
+            continue;
+        }
+        for (m = 0; m < mem->count; m++) {
+            if (!usable[DOM_MEM][m]) {
+                continue;
+            }
+            time_m  = time_c * factor[DOM_MEM][m];
+            power_m = power_c + delta[DOM_MEM][m];
+            time    = time_m * fmin[DOM_GPU];
+            if (time > time_max || (power_m + dmin[DOM_GPU]) * time >= energy_best) {
+                continue;
+            }
+            for (g = 0; g < gpu->count; g++) {
+                if (!usable[DOM_GPU][g]) {
+                    continue;
+                }
+                s->evaluated++;
+                time  = time_m * factor[DOM_GPU][g];
+                power = power_m + delta[DOM_GPU][g];
+                if (time <= time_max && time * power < energy_best) {
+                    energy_best          = time * power;
+                    best->state[DOM_CPU] = c;
+                    best->state[DOM_MEM] = m;
+                    best->state[DOM_GPU] = g;
+                    best->time           = time;
+                    best->power          = power;
+                    best->measured       = known(cpu, c) && (m == mem->ref || known(mem, m)) &&
+                                     (g == gpu->ref || known(gpu, g));
+                }
+            }
+        }
+    }
+    debug("Search: %u configurations evaluated, best CPU %u IMC %u GPU %u time %.3lf power %.1lf measured %u",
+          s->evaluated, best->state[DOM_CPU], best->state[DOM_MEM], best->state[DOM_GPU], best->time, best->power,
+          best->measured);
+release:
+    for (dim = 0; dim < FSEARCH_DIMS; dim++) {
+        free(factor[dim]);
+        free(delta[dim]);
+        free(usable[dim]);
+    }
+    if (state_fail(ret)) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    return EAR_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _FREQ_SEARCH_H
+#define _FREQ_SEARCH_H
+
+#include <common/states.h>
+#include <common/types/signature.h>
+#include <library/models/energy_model.h>
+#include <library/policies/common/cpu_support.h>
+
+/* Joint search of the CPU, IMC and GPU states (DOM_CPU, DOM_MEM and DOM_GPU).
+ * Each dimension has a reference state and the time and power of its states,
+ * either projected by the CPU energy model or measured by the policy with the
+ * other dimensions at their reference. A configuration is evaluated as:
+ *
+ *     time(c, m, g)  = time_cpu(c) * time_mem(m) / time_mem(ref) * time_gpu(g) / time_gpu(ref)
+ *     power(c, m, g) = power_cpu(c) + power_mem(m) - power_mem(ref) + power_gpu(g) - power_gpu(ref)
+ *
+ * The states not measured are estimated by interpolation between the measured
+ * ones, or by extrapolation up to FSEARCH_EXTRAPOLATION states away, so a
+ * policy can jump to the state the search proposes instead of trying them one
+ * by one. The grid is walked with lower bounds of time and energy, pruning the
+ * CPU and IMC states which can not improve the best configuration found. */
+
+#define FSEARCH_DIMS          3
+#define FSEARCH_EXTRAPOLATION 2
+
+#define FSEARCH_UNKNOWN   0
+#define FSEARCH_ESTIMATED 1
+#define FSEARCH_PROJECTED 2 // By the energy model
+#define FSEARCH_MEASURED  3
+
+typedef struct fsearch_dim {
+    uint count;
+    uint ref;
+    double *time;
+    double *power;
+    uint *source;
+} fsearch_dim_t;
+
+typedef struct fsearch {
+    fsearch_dim_t dims[FSEARCH_DIMS];
+    uint *cpu_available;
+    double cpu_key[4]; // Signature metrics of the cached CPU projection
+    uint evaluated;    // Configurations evaluated by the last search
+} fsearch_t;
+
+typedef struct fsearch_conf {
+    uint state[FSEARCH_DIMS];
+    double time;
+    double power;
+    uint measured; // All the states were measured or projected
+} fsearch_conf_t;
+
+/** Allocates a search of the given number of states per dimension, 1 for dimensions not searched. */
+state_t fsearch_init(fsearch_t *s, uint cpu_states, uint mem_states, uint gpu_states);
+
+void fsearch_dispose(fsearch_t *s);
+
+/** Sets the reference state of a dimension and forgets its states. */
+void fsearch_reset(fsearch_t *s, uint dim, uint ref);
+
+/** Records the time and power measured with the dimension at the state and the others at their reference. */
+void fsearch_observe(fsearch_t *s, uint dim, uint state, double time, double power);
+
+/** Projects the CPU states from from_ps, which becomes the CPU reference. The projection is reused while the
+ * signature metrics used by the models do not change. */
+state_t fsearch_project_cpu(fsearch_t *s, energy_model_t energy_model, signature_t *signature, ulong from_ps);
+
+/** Finds the configuration with the minimum energy whose time is not greater than the reference one plus the
+ * penalty. Only the states between min and max (both included) of each dimension are evaluated, and only the
+ * measured or projected ones if measured_only is set. The reference configuration is always valid. */
+state_t fsearch_min_energy(fsearch_t *s, uint *min, uint *max, double penalty, uint measured_only,
+                           fsearch_conf_t *best);
+
+#endif
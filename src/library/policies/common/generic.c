@@ -271,6 +271,23 @@ void compute_policy_savings(energy_model_t energy_model, signature_t *ns, node_f
                    tref, pref, tnext, pnext);
 }
 
+void policy_savings_get(float *esaving, float *psaving, float *tpenalty)
+{
+    *esaving  = energy_policy_saving;
+    *psaving  = power_policy_saving;
+    *tpenalty = time_policy_penalty;
+}
+
+void policy_savings_set(float esaving, float psaving, float tpenalty)
+{
+    energy_policy_saving = esaving;
+    power_policy_saving  = psaving;
+    time_policy_penalty  = tpenalty;
+
+    timestamp_getfast(&policy_saving_time_start);
+    policy_saving_updated = 1;
+}
+
 static uint must_compute_policy_savings(signature_t *ns, node_freqs_t *freqs, node_freq_domain_t *dom, uint *savings)
 {
     *savings = 1;
@@ -29,6 +29,12 @@ void compute_energy_savings(signature_t *curr, signature_t *prev);
 
 void compute_policy_savings(energy_model_t energy_model, signature_t *ns, node_freqs_t *freqs, node_freq_domain_t *dom);
 
+/** Gets the savings projected for the last CPU frequency selection. */
+void policy_savings_get(float *esaving, float *psaving, float *tpenalty);
+
+/** Sets the savings projected for a CPU frequency selection not computed by the models (e.g., a cached one). */
+void policy_savings_set(float esaving, float psaving, float tpenalty);
+
 void compute_gpu_policy_savings(energy_model_t energy_model, signature_t *ns, node_freqs_t *freqs);
 void compute_gpu_energy_savings(signature_t *curr);
 #endif
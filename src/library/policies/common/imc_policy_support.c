@@ -11,6 +11,7 @@
 // #define SHOW_DEBUGS 1
 
 #include <common/config.h>
+#include <common/environment_common.h>
 #include <common/math_operations.h>
 #include <common/output/debug.h>
 #include <common/output/verbose.h>
@@ -234,3 +235,97 @@ uint select_imc_pstate(int num_pstates, float p)
 {
     return (uint) truncf(num_pstates * p);
 }
+
+state_t imc_search_init(fsearch_t *s, uint cpu_pstates, uint imc_pstates)
+{
+    char *cimc_search = ear_getenv(FLAG_IMC_SEARCH);
+
+    memset(s, 0, sizeof(fsearch_t));
+    if (cimc_search == NULL || atoi(cimc_search) == 0) {
+        return EAR_SUCCESS;
+    }
+    verbose_master(2, "IMC search enabled");
+    return fsearch_init(s, cpu_pstates, imc_pstates, 1);
+}
+
+void imc_search_start(fsearch_t *s, uint cpu_pstate, uint imc_pstate, signature_t *sig)
+{
+    if (s->dims[DOM_MEM].source == NULL) {
+        return;
+    }
+    fsearch_reset(s, DOM_CPU, cpu_pstate);
+    fsearch_reset(s, DOM_MEM, imc_pstate);
+    fsearch_observe(s, DOM_CPU, cpu_pstate, sig->time, sig->DC_power);
+    fsearch_observe(s, DOM_MEM, imc_pstate, sig->time, sig->DC_power);
+}
+
+/* The search stops at a measured pstate only when its neighbours within min and max are measured too, so a
+ * pstate skipped by the estimation can not be better than the one selected when the energy has a single minimum. */
+static uint imc_search_bracket(fsearch_t *s, uint best, uint min, uint max)
+{
+    uint *source = s->dims[DOM_MEM].source;
+
+    if (best < max && source[best + 1] != FSEARCH_MEASURED) {
+        return best + 1;
+    }
+    if (best > min && source[best - 1] != FSEARCH_MEASURED) {
+        return best - 1;
+    }
+    return best;
+}
+
+uint imc_search_next(fsearch_t *s, uint cpu_pstate, uint imc_pstate, uint max_pstate, signature_t *sig,
+                     double penalty)
+{
+    uint min[FSEARCH_DIMS] = {cpu_pstate, s->dims[DOM_MEM].ref, 0};
+    uint max[FSEARCH_DIMS] = {cpu_pstate, max_pstate, 0};
+    fsearch_conf_t best;
+
+    if (s->dims[DOM_MEM].source == NULL) {
+        return ear_min(imc_pstate + 1, max_pstate);
+    }
+    fsearch_observe(s, DOM_MEM, imc_pstate, sig->time, sig->DC_power);
+    max[DOM_MEM] = ear_min(max_pstate, s->dims[DOM_MEM].count - 1);
+    if (imc_pstate >= max[DOM_MEM]) {
+        return imc_search_bracket(s, imc_pstate, min[DOM_MEM], max[DOM_MEM]);
+    }
+    if (s->dims[DOM_MEM].source[imc_pstate + 1] == FSEARCH_UNKNOWN) {
+        return imc_pstate + 1;
+    }
+    if (state_fail(fsearch_min_energy(s, min, max, penalty, 0, &best))) {
+        return imc_pstate;
+    }
+    verbose_master(2, "IMC search: %u configurations evaluated, IMC pstate %u (time %.3lf power %.1lf %s)",
+                   s->evaluated, best.state[DOM_MEM], best.time, best.power, (best.measured) ? "measured" : "estimated");
+    if (!best.measured) {
+        return best.state[DOM_MEM];
+    }
+    return imc_search_bracket(s, best.state[DOM_MEM], min[DOM_MEM], max[DOM_MEM]);
+}
+
+uint imc_search_back(fsearch_t *s, uint cpu_pstate, uint imc_pstate, signature_t *sig, double penalty)
+{
+    uint min[FSEARCH_DIMS] = {cpu_pstate, s->dims[DOM_MEM].ref, 0};
+    uint max[FSEARCH_DIMS] = {cpu_pstate, imc_pstate - 1, 0};
+    fsearch_conf_t best;
+
+    if (s->dims[DOM_MEM].source == NULL || imc_pstate <= s->dims[DOM_MEM].ref) {
+        return (imc_pstate > 0) ? imc_pstate - 1 : 0;
+    }
+    fsearch_observe(s, DOM_MEM, imc_pstate, sig->time, sig->DC_power);
+    if (state_fail(fsearch_min_energy(s, min, max, penalty, 0, &best))) {
+        return imc_pstate - 1;
+    }
+    if (!best.measured) {
+        return best.state[DOM_MEM];
+    }
+    return imc_search_bracket(s, best.state[DOM_MEM], min[DOM_MEM], max[DOM_MEM]);
+}
+
+uint imc_search_done(fsearch_t *s, uint imc_pstate, uint next_pstate)
+{
+    if (s->dims[DOM_MEM].source == NULL) {
+        return next_pstate <= imc_pstate;
+    }
+    return next_pstate < s->dims[DOM_MEM].ref || s->dims[DOM_MEM].source[next_pstate] == FSEARCH_MEASURED;
+}
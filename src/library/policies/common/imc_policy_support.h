@@ -12,6 +12,7 @@
 #define _IMC_SUPPORT_H
 
 #include <common/types/signature.h>
+#include <library/policies/common/freq_search.h>
 #include <management/imcfreq/imcfreq.h>
 
 typedef struct imc_data {
@@ -67,4 +68,27 @@ uint must_start(imc_data_t *my_imc_data, uint cpu_pstate, uint imc_pstate, uint
 
 uint select_imc_pstate(int num_pstates, float p);
 
+/*  Allocates the IMC search if it is enabled by FLAG_IMC_SEARCH. Otherwise the search is empty and the functions
+ *  below return the adjacent IMC pstates, so they are tried one by one. */
+state_t imc_search_init(fsearch_t *s, uint cpu_pstates, uint imc_pstates);
+
+/*  Starts the IMC search (freq_search.h) with the reference signature, measured at cpu_pstate and imc_pstate. */
+void imc_search_start(fsearch_t *s, uint cpu_pstate, uint imc_pstate, signature_t *sig);
+
+/*  Records the signature measured at imc_pstate and returns the next IMC pstate, up to max_pstate. It is the
+ *  pstate with the minimum energy estimated within the penalty since the search started, which can be more than
+ *  one pstate away in either direction. When that pstate is measured, its neighbours are returned until they are
+ *  measured too, so the search selects the true minimum of an energy curve with a single minimum. Without enough
+ *  measures it returns imc_pstate + 1. Use imc_search_done to know whether the pstate returned is the selection. */
+uint imc_search_next(fsearch_t *s, uint cpu_pstate, uint imc_pstate, uint max_pstate, signature_t *sig,
+                     double penalty);
+
+/*  Records the signature measured at imc_pstate, which is over the penalty, and returns the next IMC pstate with
+ *  a higher IMC frequency, as imc_search_next does. */
+uint imc_search_back(fsearch_t *s, uint cpu_pstate, uint imc_pstate, signature_t *sig, double penalty);
+
+/*  Whether next_pstate, returned by imc_search_next or imc_search_back at imc_pstate, is the one selected or it
+ *  has to be measured. Without the search the pstates are tried while they increase. */
+uint imc_search_done(fsearch_t *s, uint imc_pstate, uint next_pstate);
+
 #endif
@@ -127,7 +127,6 @@ float LB_TH = EAR_LB_TH;
 
 static float critical_path_th = 1;
 
-extern uint limit_exceeded;
 #if MPI_OPTIMIZED
 
 static uint barrier_optimize     = 0;
@@ -648,10 +647,11 @@ state_t mpi_call_end(polctx_t *c, mpi_call call_type)
     /* Dynamic MPI monitoring */
 
 #if MPI_STATS
-    int mpi_sampling_check =
-        !get_mpi_stats && mpi_sampling_enabled && (dynamic_monitor_state == MPI_SAMPLING_IDLE) && limit_exceeded;
+    int mpi_sampling_check = !get_mpi_stats && mpi_sampling_enabled && (dynamic_monitor_state == MPI_SAMPLING_IDLE) &&
+                             (avg_mpi_calls_per_second() >= MAX_MPI_CALLS_SECOND);
 #else
-    int mpi_sampling_check = mpi_sampling_enabled && (dynamic_monitor_state == MPI_SAMPLING_IDLE) && limit_exceeded;
+    int mpi_sampling_check = mpi_sampling_enabled && (dynamic_monitor_state == MPI_SAMPLING_IDLE) &&
+                             (avg_mpi_calls_per_second() >= MAX_MPI_CALLS_SECOND);
 #endif
 
     if (mpi_sampling_check) {
@@ -0,0 +1,237 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/config.h>
+#include <common/output/debug.h>
+#include <library/policies/common/cpu_support.h>
+#include <library/policies/common/imc_policy_support.h>
+#include <library/policies/common/phase_cache.h>
+
+state_t pcache_init(pcache_t *c, uint count)
+{
+    uint e;
+
+    memset(c, 0, sizeof(pcache_t));
+    if ((c->entries = calloc(count, sizeof(pcache_entry_t))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    c->count = count;
+    for (e = 0; e < count; e++) {
+        node_freqs_alloc(&c->entries[e].freqs);
+        if (c->entries[e].freqs.cpu_freq == NULL || c->entries[e].freqs.imc_freq == NULL) {
+            pcache_dispose(c);
+            return_msg(EAR_ERROR, Generr.alloc_error);
+        }
+    }
+    return EAR_SUCCESS;
+}
+
+void pcache_dispose(pcache_t *c)
+{
+    uint e;
+
+    for (e = 0; e < c->count; e++) {
+        node_freqs_free(&c->entries[e].freqs);
+    }
+    free(c->entries);
+    memset(c, 0, sizeof(pcache_t));
+}
+
+/* Logarithmic buckets, so the width is relative to the value */
+static int bucket_log(double x)
+{
+    if (x <= 0.0) {
+        return INT_MIN;
+    }
+    return (int) floor(log(x) / log1p(EARL_PHASE_CACHE_QUANTUM));
+}
+
+void pcache_key(phase_key_t *k, loop_id_t *loop, signature_t *sig, uint pstate)
+{
+    double vpi;
+
+    memset(k, 0, sizeof(phase_key_t));
+    if (loop != NULL) {
+        k->event = loop->event;
+        k->size  = loop->size;
+        k->level = loop->level;
+    }
+    compute_sig_vpi(&vpi, sig);
+    k->pstate = pstate;
+    k->cpi    = bucket_log(sig->CPI);
+    k->gbs    = bucket_log(sig->GBS);
+    // VPI is a fraction and the I/O is usually near 0, so their buckets are absolute
+    k->vpi = (int) floor(vpi / EARL_PHASE_CACHE_QUANTUM);
+    k->io  = bucket_log(1.0 + sig->IO_MBS);
+}
+
+static pcache_entry_t *pcache_find(pcache_t *c, phase_key_t *k)
+{
+    uint e;
+
+    for (e = 0; e < c->count; e++) {
+        if (c->entries[e].valid && memcmp(&c->entries[e].key, k, sizeof(phase_key_t)) == 0) {
+            return &c->entries[e];
+        }
+    }
+    return NULL;
+}
+
+state_t pcache_lookup(pcache_t *c, phase_key_t *k, node_freqs_t *freqs, phase_proj_t *proj)
+{
+    pcache_entry_t *entry;
+
+    if ((entry = pcache_find(c, k)) == NULL) {
+        c->misses++;
+        return_msg(EAR_ERROR, Generr.not_found);
+    }
+    entry->last_use = ++c->uses;
+    node_freqs_copy(freqs, &entry->freqs);
+    *proj = entry->proj;
+    c->hits++;
+    debug("Phase cache hit: pstate %u CPI %d GBS %d VPI %d IO %d", k->pstate, k->cpi, k->gbs, k->vpi, k->io);
+    return EAR_SUCCESS;
+}
+
+/* The entry of the phase, or the one to be replaced when the phase is not there */
+static pcache_entry_t *pcache_slot(pcache_t *c, phase_key_t *k)
+{
+    pcache_entry_t *entry = pcache_find(c, k);
+    uint e;
+
+    if (entry != NULL) {
+        return entry;
+    }
+    entry = &c->entries[0];
+    for (e = 0; e < c->count && entry->valid; e++) {
+        if (!c->entries[e].valid || c->entries[e].last_use < entry->last_use) {
+            entry = &c->entries[e];
+        }
+    }
+    if (entry->valid) {
+        c->evictions++;
+    }
+    memcpy(&entry->key, k, sizeof(phase_key_t));
+    return entry;
+}
+
+void pcache_insert(pcache_t *c, phase_key_t *k, node_freqs_t *freqs, phase_proj_t *proj)
+{
+    pcache_entry_t *entry;
+
+    if (c->count == 0) {
+        return;
+    }
+    entry = pcache_slot(c, k);
+    node_freqs_copy(&entry->freqs, freqs);
+    entry->proj     = *proj;
+    entry->last_use = ++c->uses;
+    entry->valid    = 1;
+    entry->removed  = 0;
+}
+
+void pcache_settings(pcache_t *c, settings_conf_t *app)
+{
+    pcache_settings_t settings;
+    uint e;
+
+    memset(&settings, 0, sizeof(pcache_settings_t));
+    memcpy(settings.settings, app->settings, sizeof(settings.settings));
+    settings.max_freq       = app->max_freq;
+    settings.def_freq       = app->def_freq;
+    settings.cpu_max_pstate = app->cpu_max_pstate;
+    settings.imc_max_pstate = app->imc_max_pstate;
+    if (memcmp(&settings, &c->settings, sizeof(pcache_settings_t)) == 0) {
+        return;
+    }
+    // Selected with other settings, they are not removed from the phase store
+    for (e = 0; e < c->count; e++) {
+        if (c->entries[e].valid) {
+            c->entries[e].valid = 0;
+            c->flushes++;
+        }
+    }
+    c->settings = settings;
+    debug("Phase cache flushed: threshold %.2lf max freq %lu def freq %lu", settings.settings[0], settings.max_freq,
+          settings.def_freq);
+}
+
+void pcache_invalidate(pcache_t *c, phase_key_t *k)
+{
+    pcache_entry_t *entry;
+
+    if ((entry = pcache_find(c, k)) != NULL) {
+        entry->valid   = 0;
+        entry->removed = 1;
+        c->invalidations++;
+    }
+}
+
+void pcache_import(pcache_t *c, phase_conf_t *confs, uint count, uint procs, uint sockets)
+{
+    pcache_entry_t *entry;
+    uint i, p, sid;
+
+    for (i = 0; i < count && c->count > 0; i++) {
+        if (!confs[i].valid) {
+            continue;
+        }
+        entry = pcache_slot(c, &confs[i].key);
+        for (p = 0; p < procs; p++) {
+            entry->freqs.cpu_freq[p] = confs[i].cpu_freq;
+        }
+        for (sid = 0; sid < sockets && IMC_VAL > IMC_MIN; sid++) {
+            entry->freqs.imc_freq[sid * IMC_VAL + IMC_MAX] = confs[i].imc_pstate[IMC_MAX];
+            entry->freqs.imc_freq[sid * IMC_VAL + IMC_MIN] = confs[i].imc_pstate[IMC_MIN];
+        }
+        entry->proj     = confs[i].proj;
+        entry->last_use = ++c->uses;
+        entry->valid    = 1;
+        entry->removed  = 0;
+    }
+    debug("%u stored phases imported", count);
+}
+
+uint pcache_export(pcache_t *c, phase_conf_t *confs, uint max, uint procs)
+{
+    pcache_entry_t *entry;
+    uint e, p, count = 0;
+
+    for (e = 0; e < c->count && count < max; e++) {
+        entry = &c->entries[e];
+        if (!entry->valid && !entry->removed) {
+            continue;
+        }
+        // Per process selections depend on the load of this run, they are not kept
+        for (p = 1; p < procs && entry->freqs.cpu_freq[p] == entry->freqs.cpu_freq[0]; p++)
+            ;
+        if (entry->valid && p < procs) {
+            continue;
+        }
+        memset(&confs[count], 0, sizeof(phase_conf_t));
+        confs[count].key                 = entry->key;
+        confs[count].proj                = entry->proj;
+        confs[count].cpu_freq            = entry->freqs.cpu_freq[0];
+        if (IMC_VAL > IMC_MIN) {
+            confs[count].imc_pstate[IMC_MAX] = entry->freqs.imc_freq[IMC_MAX];
+            confs[count].imc_pstate[IMC_MIN] = entry->freqs.imc_freq[IMC_MIN];
+        }
+        confs[count].valid               = entry->valid;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef _PHASE_CACHE_H
+#define _PHASE_CACHE_H
+
+#include <common/states.h>
+#include <common/types/loop.h>
+#include <common/types/phase.h>
+#include <common/types/signature.h>
+#include <library/policies/policy_ctx.h>
+
+/* Cache of the frequencies selected by the policy for the phases of a job.
+ * A phase is identified by its loop, the CPU P_STATE its signature was
+ * computed at and the CPI, GB/s, VPI and I/O of the signature, quantized in
+ * logarithmic buckets of EARL_PHASE_CACHE_QUANTUM relative width. When a
+ * phase already seen comes back, the policy layer sets the frequencies found
+ * the first time instead of searching them again. The entries also keep the
+ * savings projected for the selection, restored with the frequencies. The
+ * least recently used entry is replaced when the cache is full. The entries
+ * are forgotten when the policy settings or the frequency limits change, as
+ * they were selected with the previous ones. */
+
+/* The settings of the job the frequencies are selected with */
+typedef struct pcache_settings {
+    double settings[MAX_POLICY_SETTINGS]; // The first one is the policy threshold
+    ulong max_freq;
+    ulong def_freq;
+    int cpu_max_pstate;
+    int imc_max_pstate;
+} pcache_settings_t;
+
+typedef struct pcache_entry {
+    phase_key_t key;
+    node_freqs_t freqs;
+    phase_proj_t proj;
+    ulong last_use;
+    uint valid;
+    uint removed; // Invalidated, pending of being forgotten by the phase store
+} pcache_entry_t;
+
+typedef struct pcache {
+    pcache_entry_t *entries;
+    uint count;
+    ulong uses;
+    ulong hits;
+    ulong misses;
+    ulong evictions;
+    ulong invalidations;
+    ulong flushes;
+    pcache_settings_t settings;
+} pcache_t;
+
+/** Allocates a cache of count entries. */
+state_t pcache_init(pcache_t *c, uint count);
+
+void pcache_dispose(pcache_t *c);
+
+/** Builds the key of the phase. Loop can be NULL in periodic mode. */
+void pcache_key(phase_key_t *k, loop_id_t *loop, signature_t *sig, uint pstate);
+
+/** Copies the frequencies and projections of the phase. Returns EAR_ERROR if the phase is not in the cache. */
+state_t pcache_lookup(pcache_t *c, phase_key_t *k, node_freqs_t *freqs, phase_proj_t *proj);
+
+void pcache_insert(pcache_t *c, phase_key_t *k, node_freqs_t *freqs, phase_proj_t *proj);
+
+/** Sets the settings of the job. The phases are forgotten if they are not the ones of the phases cached. */
+void pcache_settings(pcache_t *c, settings_conf_t *app);
+
+/** Forgets the phase, when its cached frequencies were not validated by the policy. */
+void pcache_invalidate(pcache_t *c, phase_key_t *k);
+
+/** Adds the phases kept by the phase store of the node. The CPU frequency is set
+ * for the procs processes and the IMC P_STATEs for the sockets. */
+void pcache_import(pcache_t *c, phase_conf_t *confs, uint count, uint procs, uint sockets);
+
+/** Fills up to max phases to be kept by the phase store: the ones whose frequency
+ * is the same for the procs processes and the ones invalidated. Returns the count. */
+uint pcache_export(pcache_t *c, phase_conf_t *confs, uint max, uint procs);
+
+#endif
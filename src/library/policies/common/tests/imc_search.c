@@ -0,0 +1,196 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Replays the IMC pstate selection of min_energy and min_time over synthetic
+// time and power curves. Each step measures the signature at the current IMC
+// pstate and asks imc_search_next for the next one, or imc_search_back when the
+// time is over the penalty, as the policies do. It checks that:
+//
+//   - Without FLAG_IMC_SEARCH the pstates are tried one by one.
+//   - With the search, the pstate selected is the one with the minimum energy
+//     within the penalty of the whole curve, also when it is behind the last
+//     one measured, it is measured and it is reached in fewer steps than one by
+//     one. The pstates skipped by the estimation are bracketed: the search only
+//     stops once both neighbours of the best pstate are measured.
+//
+//     ./imc_search
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/config/config_env.h>
+#include <library/common/global_comm.h>
+#include <library/policies/common/imc_policy_support.h>
+
+#define PSTATES    20
+#define CPU_PSTATE 1
+#define PENALTY    0.05
+
+masters_info_t masters_info;
+const pstate_t *imc_pstates;
+uint imc_num_pstates;
+
+// Not used by the IMC search
+uint above_max_penalty(double time_ref, double time_curr, double cpi_ref, double cpi_curr, double gbs_ref,
+                       double gbs_curr, double penalty_th)
+{
+    return 0;
+}
+
+uint below_perf_min_benefit(double time_ref, double time_curr, double cpi_ref, double cpi_curr, double gbs_ref,
+                            double gbs_curr, double freq_ref, double freq_curr, double penalty_th)
+{
+    return 0;
+}
+
+state_t energy_model_project_all(energy_model_t energy_model, signature_t *signature, ulong from_ps, uint num_ps,
+                                 double *proj_time, double *proj_power, uint *available)
+{
+    return EAR_ERROR;
+}
+
+typedef struct curve {
+    char *name;
+    double time[PSTATES];
+    double power[PSTATES];
+} curve_t;
+
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+/* Memory bound until knee: the time grows quadratically past it while the power keeps decreasing */
+static void curve_knee(curve_t *c, char *name, uint knee, double slope)
+{
+    uint m;
+
+    c->name = name;
+    for (m = 0; m < PSTATES; m++) {
+        c->time[m]  = 10.0 * (1.0 + 0.001 * m + ((m > knee) ? slope * (m - knee) * (m - knee) : 0.0));
+        c->power[m] = 300.0 - 4.0 * m;
+    }
+}
+
+#define energy(c, m) ((c)->time[m] * (c)->power[m])
+
+/* The pstate with the minimum energy within the penalty, of the measured ones if measured is not NULL */
+static uint curve_best(curve_t *c, uint *measured)
+{
+    uint m, best = 0;
+
+    for (m = 1; m < PSTATES; m++) {
+        if ((measured == NULL || measured[m]) && c->time[m] <= c->time[0] * (1.0 + PENALTY) &&
+            energy(c, m) < energy(c, best)) {
+            best = m;
+        }
+    }
+    return best;
+}
+
+/* Returns the pstate selected, the signatures measured and the highest pstate measured */
+static uint replay(fsearch_t *s, curve_t *c, uint *measured, uint *steps, uint *last)
+{
+    uint curr = 0, next;
+    signature_t sig;
+
+    memset(&sig, 0, sizeof(signature_t));
+    memset(measured, 0, PSTATES * sizeof(uint));
+    sig.time     = c->time[0];
+    sig.DC_power = c->power[0];
+    measured[0]  = 1;
+    *last        = 0;
+    imc_search_start(s, CPU_PSTATE, 0, &sig);
+    next   = imc_search_next(s, CPU_PSTATE, curr, PSTATES - 1, &sig, PENALTY);
+    *steps = 1;
+    while (!imc_search_done(s, curr, next)) {
+        curr           = next;
+        sig.time       = c->time[curr];
+        sig.DC_power   = c->power[curr];
+        measured[curr] = 1;
+        *last          = ear_max(*last, curr);
+        *steps += 1;
+        if (sig.time > c->time[0] * (1.0 + PENALTY)) {
+            next = imc_search_back(s, CPU_PSTATE, curr, &sig, PENALTY);
+        } else {
+            next = imc_search_next(s, CPU_PSTATE, curr, PSTATES - 1, &sig, PENALTY);
+        }
+    }
+    return next;
+}
+
+/* Returns the highest pstate measured by the search */
+static uint test_curve(fsearch_t *off, fsearch_t *on, curve_t *c)
+{
+    uint steps_off, steps_on, sel_off, sel_on, last = 0, best = curve_best(c, NULL);
+    uint measured[PSTATES];
+    char msg[256];
+
+    sel_off = replay(off, c, measured, &steps_off, &last);
+    sel_on  = replay(on, c, measured, &steps_on, &last);
+    printf("%-12s best %2u | one by one: pstate %2u in %2u steps | search: pstate %2u in %2u steps, up to %2u\n",
+           c->name, best, sel_off, steps_off, sel_on, steps_on, last);
+    snprintf(msg, sizeof(msg), "%s: the search selected pstate %u, the best measured is %u", c->name, sel_on,
+             curve_best(c, measured));
+    check(sel_on == curve_best(c, measured), msg);
+    snprintf(msg, sizeof(msg), "%s: the search selected pstate %u, the best of the curve is %u", c->name, sel_on,
+             best);
+    check(sel_on == best, msg);
+    snprintf(msg, sizeof(msg), "%s: the search took %u steps, one by one %u", c->name, steps_on, steps_off);
+    check(steps_on <= steps_off, msg);
+    return last;
+}
+
+int main(int argc, char *argv[])
+{
+    uint measured[PSTATES], steps, last, m;
+    fsearch_t off, on;
+    curve_t c;
+
+    masters_info.my_master_rank = -1;
+
+    // Disabled by default, the pstates are tried one by one
+    unsetenv(FLAG_IMC_SEARCH);
+    check(state_ok(imc_search_init(&off, 4, PSTATES)), "disabled search init");
+    check(off.dims[DOM_MEM].source == NULL, "the search is enabled without FLAG_IMC_SEARCH");
+    curve_knee(&c, "flat", PSTATES, 0.0);
+    check(replay(&off, &c, measured, &steps, &last) == PSTATES - 1 && steps == PSTATES, "the disabled search skipped pstates");
+
+    setenv(FLAG_IMC_SEARCH, "1", 1);
+    check(state_ok(imc_search_init(&on, 4, PSTATES)), "search init");
+    check(on.dims[DOM_MEM].source != NULL, "the search is not enabled by FLAG_IMC_SEARCH");
+
+    test_curve(&off, &on, &c);
+    curve_knee(&c, "knee 6", 6, 0.004);
+    test_curve(&off, &on, &c);
+    curve_knee(&c, "knee 12", 12, 0.01);
+    test_curve(&off, &on, &c);
+
+    // The energy grows from pstate 4 while the time is within the penalty: the
+    // search has to go back to the best pstate measured instead of staying at the
+    // last one
+    c.name = "energy min 4";
+    for (m = 0; m < PSTATES; m++) {
+        c.time[m]  = 10.0 * (1.0 + 0.002 * m);
+        c.power[m] = (m <= 4) ? 300.0 - 5.0 * m : 280.0 + 6.0 * (m - 4);
+    }
+    last = test_curve(&off, &on, &c);
+    check(last > 4, "the energy min 4 curve did not overshoot the best pstate");
+
+    fsearch_dispose(&on);
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
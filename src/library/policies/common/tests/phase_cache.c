@@ -0,0 +1,217 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Checks the cache of the policy frequencies per phase (phase_cache.h):
+//
+//   - A phase inserted is found with its frequencies and projections, and a
+//     different one misses, counting the hits and the misses.
+//   - The signatures within the same buckets share the key, the ones in other
+//     buckets, loops or CPU P_STATEs do not, and inserting a phase twice keeps
+//     a single entry.
+//   - The least recently used phase is evicted when the cache is full.
+//   - An invalidated phase misses and it is exported to be forgotten.
+//   - A change of the policy threshold or the frequency limits forgets the
+//     phases, and setting the same settings again does not.
+//
+//     ./phase_cache
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/config.h>
+#include <library/policies/common/imc_policy_support.h>
+#include <library/policies/common/phase_cache.h>
+
+#define ENTRIES 4
+
+uint imc_devices = 2;
+
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+// The policy support is not linked, just the node frequencies are used
+void node_freqs_alloc(node_freqs_t *node_freq)
+{
+    node_freq->cpu_freq = calloc(MAX_CPUS_SUPPORTED, sizeof(ulong));
+    node_freq->imc_freq = calloc(MAX_SOCKETS_SUPPORTED * IMC_VAL, sizeof(ulong));
+}
+
+void node_freqs_free(node_freqs_t *node_freq)
+{
+    free(node_freq->cpu_freq);
+    free(node_freq->imc_freq);
+}
+
+void node_freqs_copy(node_freqs_t *dst, node_freqs_t *src)
+{
+    memcpy(dst->cpu_freq, src->cpu_freq, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memcpy(dst->imc_freq, src->imc_freq, MAX_SOCKETS_SUPPORTED * IMC_VAL * sizeof(ulong));
+}
+
+static void phase(signature_t *sig, double cpi, double gbs)
+{
+    memset(sig, 0, sizeof(signature_t));
+    sig->CPI          = cpi;
+    sig->GBS          = gbs;
+    sig->IO_MBS       = 0.5;
+    sig->instructions = 1000000000;
+}
+
+static void freqs_set(node_freqs_t *f, ulong khz)
+{
+    uint p;
+
+    for (p = 0; p < MAX_CPUS_SUPPORTED; p++) {
+        f->cpu_freq[p] = khz;
+    }
+    f->imc_freq[IMC_MAX] = 2;
+}
+
+/* Inserts the phase with CPI cpi selecting khz */
+static void insert(pcache_t *c, loop_id_t *loop, double cpi, ulong khz, node_freqs_t *f)
+{
+    phase_proj_t proj = {.esaving = 10.0, .psaving = 12.0, .tpenalty = 2.0};
+    phase_key_t k;
+    signature_t sig;
+
+    phase(&sig, cpi, 40.0);
+    pcache_key(&k, loop, &sig, 1);
+    freqs_set(f, khz);
+    pcache_insert(c, &k, f, &proj);
+}
+
+/* Returns the frequency cached for the phase, 0 if it misses */
+static ulong lookup(pcache_t *c, loop_id_t *loop, double cpi, node_freqs_t *f)
+{
+    phase_proj_t proj;
+    phase_key_t k;
+    signature_t sig;
+
+    phase(&sig, cpi, 40.0);
+    pcache_key(&k, loop, &sig, 1);
+    if (state_fail(pcache_lookup(c, &k, f, &proj))) {
+        return 0;
+    }
+    return f->cpu_freq[0];
+}
+
+static uint valid_entries(pcache_t *c)
+{
+    uint e, count = 0;
+
+    for (e = 0; e < c->count; e++) {
+        count += c->entries[e].valid;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    loop_id_t loop       = {.event = 10, .size = 3, .level = 1};
+    loop_id_t other_loop = {.event = 10, .size = 4, .level = 1};
+    phase_key_t k1, k2;
+    phase_conf_t confs[ENTRIES];
+    settings_conf_t app;
+    signature_t sig;
+    node_freqs_t f;
+    phase_proj_t proj;
+    pcache_t c;
+    uint count;
+
+    node_freqs_alloc(&f);
+    check(state_ok(pcache_init(&c, ENTRIES)), "init");
+    memset(&app, 0, sizeof(settings_conf_t));
+    app.settings[0] = 0.1;
+    app.max_freq    = 2600000;
+    app.def_freq    = 2400000;
+    pcache_settings(&c, &app);
+
+    // Hit and miss
+    insert(&c, &loop, 1.0, 2200000, &f);
+    memset(f.cpu_freq, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    phase(&sig, 1.0, 40.0);
+    pcache_key(&k1, &loop, &sig, 1);
+    check(state_ok(pcache_lookup(&c, &k1, &f, &proj)) && f.cpu_freq[MAX_CPUS_SUPPORTED - 1] == 2200000 &&
+              f.imc_freq[IMC_MAX] == 2 && proj.esaving == 10.0 && proj.tpenalty == 2.0,
+          "the phase inserted is not found with its frequencies");
+    check(lookup(&c, &loop, 3.0, &f) == 0, "a different CPI hits");
+    check(c.hits == 1 && c.misses == 1, "hits and misses not counted");
+
+    // Key collisions: the same buckets share the key
+    phase(&sig, 1.0 * (1.0 + EARL_PHASE_CACHE_QUANTUM / 4.0), 40.0);
+    pcache_key(&k2, &loop, &sig, 1);
+    check(memcmp(&k1, &k2, sizeof(phase_key_t)) == 0, "a CPI in the same bucket has a different key");
+    phase(&sig, 1.0 * (1.0 + EARL_PHASE_CACHE_QUANTUM * 2.0), 40.0);
+    pcache_key(&k2, &loop, &sig, 1);
+    check(memcmp(&k1, &k2, sizeof(phase_key_t)) != 0, "a CPI two buckets away has the same key");
+    phase(&sig, 1.0, 40.0 * (1.0 + EARL_PHASE_CACHE_QUANTUM * 2.0));
+    pcache_key(&k2, &loop, &sig, 1);
+    check(memcmp(&k1, &k2, sizeof(phase_key_t)) != 0, "a GB/s two buckets away has the same key");
+    phase(&sig, 1.0, 40.0);
+    pcache_key(&k2, &loop, &sig, 2);
+    check(memcmp(&k1, &k2, sizeof(phase_key_t)) != 0, "another P_STATE has the same key");
+    check(lookup(&c, &other_loop, 1.0, &f) == 0, "another loop hits");
+    check(lookup(&c, NULL, 1.0, &f) == 0, "the periodic mode hits the loop");
+    insert(&c, &loop, 1.0, 2000000, &f);
+    check(valid_entries(&c) == 1 && lookup(&c, &loop, 1.0, &f) == 2000000, "a phase inserted twice is duplicated");
+
+    // Eviction of the least recently used
+    insert(&c, &loop, 2.0, 2100000, &f);
+    insert(&c, &loop, 4.0, 1900000, &f);
+    insert(&c, &loop, 8.0, 1800000, &f);
+    check(valid_entries(&c) == ENTRIES && c.evictions == 0, "full cache");
+    lookup(&c, &loop, 1.0, &f);
+    insert(&c, &loop, 16.0, 1700000, &f);
+    check(c.evictions == 1, "eviction not counted");
+    check(lookup(&c, &loop, 2.0, &f) == 0, "the least recently used phase was not evicted");
+    check(lookup(&c, &loop, 1.0, &f) == 2000000 && lookup(&c, &loop, 16.0, &f) == 1700000,
+          "a recently used phase was evicted");
+
+    // Invalidation
+    phase(&sig, 4.0, 40.0);
+    pcache_key(&k2, &loop, &sig, 1);
+    pcache_invalidate(&c, &k2);
+    check(lookup(&c, &loop, 4.0, &f) == 0 && c.invalidations == 1, "the invalidated phase hits");
+    count = pcache_export(&c, confs, ENTRIES, 2);
+    check(count == ENTRIES, "export");
+    for (count = 0; count < ENTRIES && memcmp(&confs[count].key, &k2, sizeof(phase_key_t)); count++)
+        ;
+    check(count < ENTRIES && !confs[count].valid, "the invalidated phase is not exported to be forgotten");
+
+    // Settings
+    pcache_settings(&c, &app);
+    check(c.flushes == 0 && lookup(&c, &loop, 1.0, &f) == 2000000, "the same settings forgot the phases");
+    app.settings[0] = 0.05;
+    pcache_settings(&c, &app);
+    check(c.flushes == 3 && lookup(&c, &loop, 1.0, &f) == 0, "a new threshold did not forget the phases");
+    insert(&c, &loop, 1.0, 2300000, &f);
+    app.max_freq = 2200000;
+    pcache_settings(&c, &app);
+    check(lookup(&c, &loop, 1.0, &f) == 0, "a new maximum frequency did not forget the phases");
+    insert(&c, &loop, 1.0, 2300000, &f);
+    app.imc_max_pstate = 3;
+    pcache_settings(&c, &app);
+    check(lookup(&c, &loop, 1.0, &f) == 0, "a new IMC limit did not forget the phases");
+
+    printf("%lu hits, %lu misses, %lu evictions, %lu invalidations, %lu flushed\n", c.hits, c.misses, c.evictions,
+           c.invalidations, c.flushes);
+    pcache_dispose(&c);
+    node_freqs_free(&f);
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
@@ -48,10 +48,12 @@
 #include <library/metrics/metrics.h>
 #include <library/policies/common/cpu_support.h>
 #include <library/policies/common/cpuprio_support.h>
+#include <library/policies/common/generic.h>
 #include <library/policies/common/gpu_support.h>
 #include <library/policies/common/imc_policy_support.h>
 #include <library/policies/common/mpi_stats_support.h>
 #include <library/policies/common/pc_support.h>
+#include <library/policies/common/phase_cache.h>
 #include <library/policies/policy_ctx.h>
 #include <library/policies/policy_state.h>
 #include <library/tracer/tracer.h>
@@ -228,6 +230,18 @@ static const uint *gpuf_pol_list_items;
 
 static uint first_policy_try = 1;
 
+#if EARL_PHASE_CACHE
+#define PHASE_IDLE   0
+#define PHASE_SEARCH 1 // The policy is searching the frequencies of phase_key
+#define PHASE_HIT    2 // The frequencies of phase_key were cached, pending of policy_ok
+
+static pcache_t phase_cache;
+static uint phase_cache_on;
+static uint phase_state = PHASE_IDLE;
+static phase_key_t phase_key;
+static loop_id_t phase_loop;
+#endif
+
 static uint total_mpi_optimized = 0;
 
 /* Governor management for exclusive mode */
@@ -329,6 +343,21 @@ static state_t policy_io_freq_selection(polctx_t *c, signature_t *my_sig, node_f
                                         node_freqs_t *avg_freq);
 static void verbose_governor_list(int vrb_lvl);
 
+/** Sets the frequencies cached for the phase of the signature. Returns 0 if the policy must search them. */
+static uint policy_phase_cached(polctx_t *c, signature_t *sig, node_freqs_t *freqs);
+
+/** Caches the frequencies selected by the policy when the search of the phase ends. */
+static void policy_phase_searched(node_freqs_t *freqs);
+
+/** Forgets the cached frequencies set for the current phase if the policy does not validate them. */
+static void policy_phase_validated(int ok);
+
+/** Fills the phase cache with the phases the EARD phase store kept for this application. */
+static void policy_phase_restore(polctx_t *c);
+
+/** Sends the phases of the phase cache to the EARD phase store. */
+static void policy_phase_store(polctx_t *c);
+
 #define DEBUG_CPUFREQ_COST 0
 
 #if DEBUG_CPUFREQ_COST
@@ -649,12 +678,26 @@ static state_t policy_init()
     node_freqs_alloc(&nf);
     node_freqs_alloc(&avg_nf);
 
+#if EARL_PHASE_CACHE
+    /* The GPU policies have their own search, so the phases are only cached without GPUs */
+    if (is_master && (c->num_gpus == 0)) {
+        phase_cache_on = state_ok(pcache_init(&phase_cache, EARL_PHASE_CACHE));
+    }
+    if (phase_cache_on) {
+        pcache_settings(&phase_cache, c->app);
+        policy_phase_restore(c);
+    }
+    verbose_policy_info("Phase cache: %s", phase_cache_on ? "Enabled" : "Disabled");
+#endif
+
     if (POLICY_MPI_CALL_ENABLED) {
         /* This is to be used in mpi_calls */
         node_freqs_alloc(&per_process_node_freq);
     }
 
-    freq_per_core = calloc(MAX_CPUS_SUPPORTED, sizeof(ulong));
+    if ((freq_per_core = calloc(arch_desc.top.cpu_count, sizeof(ulong))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
     signature_init(&policy_last_local_signature);
     signature_init(&policy_last_global_signature);
 #if USE_GPUS
@@ -1002,8 +1045,11 @@ state_t policy_node_apply(signature_t *my_sig, ulong *freq_set, int *ready)
             memset(freqs->cpu_freq, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
         }
 
-        /* CPU specific function is applied here */
-        st = polsyms_fun.node_policy_apply(c, &node_sig, freqs, &cpu_ready);
+        /* CPU specific function is applied here, unless the phase was already seen */
+        if (!policy_phase_cached(c, &node_sig, freqs)) {
+            st = polsyms_fun.node_policy_apply(c, &node_sig, freqs, &cpu_ready);
+            policy_phase_searched(freqs);
+        }
 
         // if (cpu_ready) compute_policy_savings(&node_sig, freqs, &freqs_domain);
 
@@ -1086,6 +1132,10 @@ state_t policy_set_default_freq(signature_t *sig)
         return EAR_SUCCESS;
     verbose_master(2, "policy_set_default_freq");
 
+#if EARL_PHASE_CACHE
+    phase_state = PHASE_IDLE;
+#endif
+
 #if USE_GPUS
     s.gpu_sig.num_gpus = my_pol_ctx.num_gpus;
 #endif
@@ -1162,6 +1212,8 @@ state_t policy_ok(signature_t *curr, signature_t *prev, int *ok)
 
         ret = polsyms_fun.ok(c, curr, prev, ok);
 
+        policy_phase_validated(*ok);
+
         // char *ok_color = COL_GRE;
 
         if (*ok == 0) {
@@ -1233,6 +1285,18 @@ state_t policy_end()
 
     verbose_master(2, "Total number of MPI calls %llu", total_mpi);
 
+#if EARL_PHASE_CACHE
+    if (phase_cache_on) {
+        verbose_master((masters_info.my_master_rank == 0) ? 1 : 2,
+                       "Phase cache: %lu hits, %lu misses, %lu evictions, %lu invalidations, %lu flushed",
+                       phase_cache.hits, phase_cache.misses, phase_cache.evictions, phase_cache.invalidations,
+                       phase_cache.flushes);
+        policy_phase_store(c);
+        pcache_dispose(&phase_cache);
+        phase_cache_on = 0;
+    }
+#endif
+
 #if MPI_OPTIMIZED
     if (ear_mpi_opt) {
         verbose(1, "[%d] Total number of MPI calls with optimization: %u", my_node_id, total_mpi_optimized);
@@ -1259,6 +1323,12 @@ state_t policy_end()
 /* This function is executed  at loop init or period init */
 state_t policy_loop_init(loop_id_t *loop_id)
 {
+#if EARL_PHASE_CACHE
+    if (loop_id != NULL) {
+        phase_loop = *loop_id;
+    }
+    phase_state = PHASE_IDLE;
+#endif
     preturn(polsyms_fun.loop_init, &my_pol_ctx, loop_id);
 }
 
@@ -1706,7 +1776,7 @@ static state_t policy_cpu_freq_selection(polctx_t *c, signature_t *my_sig, node_
     verbose_master(3, "%-12s: %s\n%-12s: %d", "Policy level", pol_grain_str, "Affinity", ear_affinity_is_set);
 
     ulong max_cpufreq_sel_khz = 0, min_cpufreq_sel_khz = 1000000000;
-    memset(freq_per_core, 0, sizeof(ulong) * MAX_CPUS_SUPPORTED);
+    memset(freq_per_core, 0, sizeof(ulong) * arch_desc.top.cpu_count);
 
     // Assumption: If affinity is set for master, it
     // is set for all, we could check individually
@@ -1725,7 +1795,7 @@ static state_t policy_cpu_freq_selection(polctx_t *c, signature_t *my_sig, node_
                 from_proc_to_core(freq_set, lib_shared_region->num_processes, &freq_per_core, arch_desc.top.cpu_count,
                                   &max_cpufreq_sel_khz, &min_cpufreq_sel_khz, process_id);
             } else {
-                for (i = 0; i < MAX_CPUS_SUPPORTED; i++) {
+                for (i = 0; i < arch_desc.top.cpu_count; i++) {
                     freq_per_core[i] = freq_set[0];
                 }
             }
@@ -1772,7 +1842,7 @@ static state_t policy_cpu_freq_selection(polctx_t *c, signature_t *my_sig, node_
     if (process_id == ALL_PROCESSES) {
         if ((pc_app_info_data != NULL) && (pc_app_info_data->cpu_mode == PC_DVFS)) {
             /* Warning: POL_GRAIN_CORE not supported */
-            pcapp_info_set_req_f(pc_app_info_data, freq_per_core, MAX_CPUS_SUPPORTED);
+            pcapp_info_set_req_f(pc_app_info_data, freq_per_core, arch_desc.top.cpu_count);
         }
 
         int freq_cnt = (dom->cpu == POL_GRAIN_CORE) ? lib_shared_region->num_processes : 1;
@@ -2185,3 +2255,103 @@ static void verbose_governor_list(int vrb_lvl)
         verbose(vrb_lvl, " %d CPUs to %s", metrics_get(MGT_CPUFREQ)->devs_count - last_gov_cpu, gov_str);
     }
 }
+
+static uint policy_phase_cached(polctx_t *c, signature_t *sig, node_freqs_t *freqs)
+{
+#if EARL_PHASE_CACHE
+    phase_proj_t proj;
+
+    if (!phase_cache_on || (phase_state == PHASE_SEARCH)) {
+        return 0;
+    }
+    // The threshold or the frequency limits can be changed while the job runs
+    pcache_settings(&phase_cache, c->app);
+    pcache_key(&phase_key, &phase_loop, sig, frequency_closest_pstate(*(c->ear_frequency)));
+    if (state_fail(pcache_lookup(&phase_cache, &phase_key, freqs, &proj))) {
+        phase_state = PHASE_SEARCH;
+        return 0;
+    }
+    policy_savings_set(proj.esaving, proj.psaving, proj.tpenalty);
+    cpu_ready   = EAR_POLICY_READY;
+    phase_state = PHASE_HIT;
+    verbose_policy_info("Phase already seen, using the cached CPU freq. %lu kHz", freqs->cpu_freq[0]);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static void policy_phase_searched(node_freqs_t *freqs)
+{
+#if EARL_PHASE_CACHE
+    phase_proj_t proj;
+
+    if ((phase_state != PHASE_SEARCH) || (cpu_ready != EAR_POLICY_READY)) {
+        return;
+    }
+    policy_savings_get(&proj.esaving, &proj.psaving, &proj.tpenalty);
+    pcache_insert(&phase_cache, &phase_key, freqs, &proj);
+    phase_state = PHASE_IDLE;
+#endif
+}
+
+static void policy_phase_validated(int ok)
+{
+#if EARL_PHASE_CACHE
+    if (phase_state != PHASE_HIT) {
+        return;
+    }
+    if (!ok) {
+        verbose_policy_info("The cached frequencies of the phase were not validated.");
+        pcache_invalidate(&phase_cache, &phase_key);
+    }
+    phase_state = PHASE_IDLE;
+#endif
+}
+
+#if EARL_PHASE_CACHE
+static void policy_phase_app(polctx_t *c, phase_app_t *app)
+{
+    memset(app, 0, sizeof(phase_app_t));
+    snprintf(app->app_id, sizeof(app->app_id), "%s", application.job.app_id);
+    snprintf(app->policy, sizeof(app->policy), "%s", c->app->policy_name);
+    app->th       = c->app->settings[0];
+    app->def_freq = c->app->def_freq;
+    app->eufs     = dyn_unc;
+}
+#endif
+
+static void policy_phase_restore(polctx_t *c)
+{
+#if EARL_PHASE_CACHE
+    phase_conf_t confs[PHASE_CONF_MAX];
+    phase_app_t app;
+    uint count;
+
+    policy_phase_app(c, &app);
+    if (state_fail(eards_get_phases(&app, confs, PHASE_CONF_MAX, &count))) {
+        verbose_policy_info("Phase store not available: %s", state_msg);
+        return;
+    }
+    pcache_import(&phase_cache, confs, count, MAX_CPUS_SUPPORTED, arch_desc.top.socket_count);
+    verbose_policy_info("Phase cache: %u phases of previous runs", count);
+#endif
+}
+
+static void policy_phase_store(polctx_t *c)
+{
+#if EARL_PHASE_CACHE
+    phase_conf_t confs[PHASE_CONF_MAX];
+    phase_app_t app;
+    uint count;
+
+    count = pcache_export(&phase_cache, confs, PHASE_CONF_MAX, lib_shared_region->num_processes);
+    if (count == 0) {
+        return;
+    }
+    policy_phase_app(c, &app);
+    if (state_fail(eards_put_phases(&app, confs, count))) {
+        verbose_master(2, "Phases not stored: %s", state_msg);
+    }
+#endif
+}
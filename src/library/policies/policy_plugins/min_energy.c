@@ -73,6 +73,7 @@ static uint ref_imc_pstate;
 static uint last_imc_pstate;
 
 static imc_data_t *imc_data;
+static fsearch_t imc_search;
 
 /*  Frequency management */
 static uint last_cpu_pstate;
@@ -227,6 +228,10 @@ state_t policy_init(polctx_t *c)
     }
 
     imc_data = calloc(c->num_pstates * NUM_UNC_FREQ, sizeof(imc_data_t));
+    if (state_fail(imc_search_init(&imc_search, c->num_pstates, imc_num_pstates))) {
+        verbose_master(2, "%sWarning%s IMC search not available, IMC pstates will be tried one by one.", COL_YLW,
+                       COL_CLR);
+    }
 
     num_processes = lib_shared_region->num_processes;
 
@@ -282,6 +287,7 @@ state_t policy_init(polctx_t *c)
 state_t policy_end(polctx_t *c)
 {
     policy_end_summary(2); // Summary of optimization
+    fsearch_dispose(&imc_search);
 
     if (use_energy_models) {
         energy_model_dispose(cpu_energy_model);
@@ -708,6 +714,7 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                     } else {
                         ref_imc_pstate   = curr_imc_pstate;
                         min_energy_state = SELECT_IMCFREQ;
+                        imc_search_start(&imc_search, curr_pstate, curr_imc_pstate, my_app);
                     }
                     *ready = EAR_POLICY_TRY_AGAIN;
                 } else {
@@ -719,6 +726,7 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
     } else if ((min_energy_state == COMP_IMCREF) || (min_energy_state == TRY_TURBO_CPUFREQ)) {
         /**** COMP_IMCREF ***/
         ref_imc_pstate = curr_imc_pstate;
+        imc_search_start(&imc_search, curr_pstate, curr_imc_pstate, my_app);
         for (sid = 0; sid < imc_devices; sid++) {
             freqs->imc_freq[sid * IMC_VAL + IMC_MAX] = curr_imc_pstate;
             freqs->imc_freq[sid * IMC_VAL + IMC_MIN] = imc_max_pstate[sid];
@@ -746,10 +754,10 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
             uint must_start_again =
                 must_start(imc_data, curr_pstate, curr_imc_pstate, curr_pstate, ref_imc_pstate, my_app);
             debug("%sWarning, passing the imc_th limit: start_again %u", COL_RED, must_start_again);
+            /* The IMC pstate with the minimum energy, usually the previous one, or one to measure */
+            uint back_imc_pstate = imc_search_back(&imc_search, curr_pstate, curr_imc_pstate, my_app, imc_extra_th);
             for (sid = 0; sid < imc_devices; sid++) {
-                freqs->imc_freq[sid * IMC_VAL + IMC_MAX] =
-                    ((freqs->imc_freq[sid * IMC_VAL + IMC_MAX] > 0) ? (freqs->imc_freq[sid * IMC_VAL + IMC_MAX] - 1)
-                                                                    : 0);
+                freqs->imc_freq[sid * IMC_VAL + IMC_MAX] = back_imc_pstate;
                 freqs->imc_freq[sid * IMC_VAL + IMC_MIN] = imc_max_pstate[sid];
             }
             sid = 0;
@@ -757,15 +765,24 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                            imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MAX]].khz,
                            imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MIN]].khz, COL_CLR);
 
-            if (!must_start_again)
-                *ready = EAR_POLICY_READY;
-            else
+            if (must_start_again) {
+                *ready           = EAR_POLICY_TRY_AGAIN;
+                min_energy_state = SELECT_CPUFREQ;
+            } else if (!imc_search_done(&imc_search, curr_imc_pstate, back_imc_pstate)) {
+                /* A pstate skipped by the search, it is measured before selecting one */
                 *ready = EAR_POLICY_TRY_AGAIN;
-
-            min_energy_state = SELECT_CPUFREQ;
+            } else {
+                *ready           = EAR_POLICY_READY;
+                min_energy_state = SELECT_CPUFREQ;
+            }
         } else {
             /* IMC_MAX is max frequency, lower bound p-state */
             /* IMC_MIN is min frequency, upper bound p-state */
+            /* The search proposes the next IMC pstate from the ones already measured. It can skip pstates, and
+             * go back to measure one skipped or to select the best one when the lower IMC frequencies are not
+             * expected to save energy. */
+            uint next_imc_pstate = imc_search_next(&imc_search, curr_pstate, curr_imc_pstate, imc_max_pstate[0],
+                                                   my_app, imc_extra_th);
             for (sid = 0; sid < imc_devices; sid++) {
                 // Lower bound IMC p-state index
                 int min_ps_idx = sid * IMC_VAL + IMC_MAX;
@@ -773,7 +790,7 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                 // retrieved by hardware.
                 // freqs->imc_freq[min_ps_idx] = ear_min(imc_max_pstate[sid],
                 //                                       freqs->imc_freq[min_ps_idx] + 1);
-                freqs->imc_freq[min_ps_idx] = ear_min(imc_max_pstate[sid], curr_imc_pstate + 1);
+                freqs->imc_freq[min_ps_idx] = ear_min(imc_max_pstate[sid], next_imc_pstate);
 
                 // Lower bound IMC p-state index
                 int max_ps_idx              = sid * IMC_VAL + IMC_MIN;
@@ -800,7 +817,8 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
             // The selected p-state is the minimum permitted by the device.
             int selected_ps_eq_minfreq = freqs->imc_freq[sid * IMC_VAL + IMC_MAX] == imc_max_pstate[sid];
 
-            if (selected_ps_leq_max && !(max_ps_config_eq_dev && selected_ps_eq_minfreq && selected_ps_eq_last)) {
+            if (selected_ps_leq_max && !(max_ps_config_eq_dev && selected_ps_eq_minfreq && selected_ps_eq_last) &&
+                !imc_search_done(&imc_search, curr_imc_pstate, next_imc_pstate)) {
                 *ready = EAR_POLICY_TRY_AGAIN;
             } else {
                 *ready           = EAR_POLICY_READY;
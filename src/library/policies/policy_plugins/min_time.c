@@ -66,6 +66,7 @@ static int min_pstate;
 static int ref_imc_pstate = -1;
 
 static imc_data_t *imc_data;
+static fsearch_t imc_search;
 
 static uint first_imc_try = 1;
 
@@ -210,6 +211,10 @@ state_t policy_init(polctx_t *c)
             return EAR_ERROR;
 
         imc_data = calloc(c->num_pstates * NUM_UNC_FREQ, sizeof(imc_data_t));
+        if (state_fail(imc_search_init(&imc_search, c->num_pstates, imc_num_pstates))) {
+            verbose_master(2, "%sWarning%s IMC search not available, IMC pstates will be tried one by one.",
+                           COL_YLW, COL_CLR);
+        }
 
         num_processes = lib_shared_region->num_processes;
 
@@ -269,6 +274,7 @@ state_t policy_init(polctx_t *c)
 
 state_t policy_end(polctx_t *c)
 {
+    fsearch_dispose(&imc_search);
     if (use_energy_models) {
         energy_model_dispose(cpu_energy_model);
     }
@@ -684,6 +690,7 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                     } else {
                         ref_imc_pstate = curr_imc_pstate;
                         min_time_state = SELECT_IMCFREQ;
+                        imc_search_start(&imc_search, curr_pstate, curr_imc_pstate, my_app);
                     }
                     *ready = EAR_POLICY_TRY_AGAIN;
                 } else {
@@ -694,6 +701,7 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
         memcpy(last_nodefreq_sel.imc_freq, freqs->imc_freq, imc_devices * IMC_VAL * sizeof(ulong));
     } else if (min_time_state == COMP_IMCREF || min_time_state == TRY_TURBO_CPUFREQ) {
         ref_imc_pstate = curr_imc_pstate;
+        imc_search_start(&imc_search, curr_pstate, curr_imc_pstate, my_app);
 
         for (sid = 0; sid < imc_devices; sid++) {
             freqs->imc_freq[sid * IMC_VAL + IMC_MAX] = curr_imc_pstate;
@@ -778,28 +786,35 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                 uint must_start_again =
                     must_start(imc_data, curr_pstate, curr_imc_pstate, curr_pstate, ref_imc_pstate, my_app);
                 debug("%sWarning, passing the imc_th limit: start_again %u", COL_RED, must_start_again);
+                /* The IMC pstate with the minimum energy, usually the previous one, or one to measure */
+                uint back_imc_pstate =
+                    imc_search_back(&imc_search, curr_pstate, curr_imc_pstate, my_app, imc_extra_th);
                 for (sid = 0; sid < imc_devices; sid++) {
-                    freqs->imc_freq[sid * IMC_VAL + IMC_MAX] =
-                        ((freqs->imc_freq[sid * IMC_VAL + IMC_MAX] > 0) ? (freqs->imc_freq[sid * IMC_VAL + IMC_MAX] - 1)
-                                                                        : 0);
+                    freqs->imc_freq[sid * IMC_VAL + IMC_MAX] = back_imc_pstate;
                     freqs->imc_freq[sid * IMC_VAL + IMC_MIN] = imc_max_pstate[sid];
                 }
                 sid = 0;
                 debug("Selecting IMC range %llu - %llu%s", imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MAX]].khz,
                       imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MIN]].khz, COL_CLR);
 
-                if (!must_start_again)
-                    *ready = EAR_POLICY_READY;
-                else
+                if (must_start_again) {
+                    *ready         = EAR_POLICY_TRY_AGAIN;
+                    min_time_state = SELECT_CPUFREQ;
+                } else if (!imc_search_done(&imc_search, curr_imc_pstate, back_imc_pstate)) {
+                    /* A pstate skipped by the search, it is measured before selecting one */
                     *ready = EAR_POLICY_TRY_AGAIN;
-
-                min_time_state = SELECT_CPUFREQ;
+                } else {
+                    *ready         = EAR_POLICY_READY;
+                    min_time_state = SELECT_CPUFREQ;
+                }
             } else {
+                /* The search proposes the next IMC pstate from the ones already measured. It can skip pstates, and
+                 * go back to measure one skipped or to select the best one when the lower IMC frequencies are
+                 * not expected to save energy. */
+                uint next_imc_pstate = imc_search_next(&imc_search, curr_pstate, curr_imc_pstate,
+                                                       imc_max_pstate[0], my_app, imc_extra_th);
                 for (sid = 0; sid < imc_devices; sid++) {
-                    freqs->imc_freq[sid * IMC_VAL + IMC_MAX] =
-                        ((freqs->imc_freq[sid * IMC_VAL + IMC_MAX] < imc_max_pstate[sid])
-                             ? freqs->imc_freq[sid * IMC_VAL + IMC_MAX] + 1
-                             : imc_max_pstate[sid]);
+                    freqs->imc_freq[sid * IMC_VAL + IMC_MAX] = ear_min(next_imc_pstate, imc_max_pstate[sid]);
                     freqs->imc_freq[sid * IMC_VAL + IMC_MIN] = imc_max_pstate[sid];
                 }
                 sid = 0;
@@ -807,7 +822,8 @@ state_t policy_apply(polctx_t *c, signature_t *sig, node_freqs_t *freqs, int *re
                       imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MAX]].khz,
                       imc_pstates[freqs->imc_freq[sid * IMC_VAL + IMC_MIN]].khz, COL_CLR);
                 /* We are assuming all sockets uses the same frequency range */
-                if (freqs->imc_freq[sid * IMC_VAL + IMC_MAX] < max_policy_imcfreq_ps)
+                if (freqs->imc_freq[sid * IMC_VAL + IMC_MAX] < max_policy_imcfreq_ps &&
+                    !imc_search_done(&imc_search, curr_imc_pstate, next_imc_pstate))
                     *ready = EAR_POLICY_TRY_AGAIN;
                 else {
                     *ready         = EAR_POLICY_READY;
@@ -676,11 +676,11 @@ void states_new_iteration(int my_id, uint period, uint iterations, uint level, u
              * Now we compute the JOB signature for reporting. */
             /* This function is the one that accumulates per-process metrics */
             if (master) {
-                // curr_loop.signature <- lib_shared_region->job_signature
-                metrics_job_signature(&lib_shared_region->job_signature, &curr_loop.signature);
+                // lib_shared_region->job_signature is computed in place
+                metrics_job_signature_update(&lib_shared_region->job_signature);
 
-                // lib_shared_region->job_signature <- curr_loop.signature
-                signature_copy(&lib_shared_region->job_signature, &curr_loop.signature);
+                // curr_loop.signature <- lib_shared_region->job_signature
+                signature_copy(&curr_loop.signature, &lib_shared_region->job_signature);
             }
 
             /* This function takes into account if we are using or not the whole node. */
@@ -862,10 +862,10 @@ void states_new_iteration(int my_id, uint period, uint iterations, uint level, u
             /* This function accumulates per procecss metrics in curr_loop.signature,
              * so curr_loop.signature is the job signature */
             if (master) {
-                metrics_job_signature(&lib_shared_region->job_signature, &curr_loop.signature);
+                // lib_shared_region->job_signature is computed in place
+                metrics_job_signature_update(&lib_shared_region->job_signature);
+                signature_copy(&curr_loop.signature, &lib_shared_region->job_signature);
                 signature_copy(&loop_signature, &curr_loop.signature); // loop_signature <- curr_loop.signature
-                signature_copy(&lib_shared_region->job_signature,
-                               &curr_loop.signature); // lib_shared_region->job_signature <- curr_loop.signature
             }
             if (master) {
                 traces_generic_event(ear_my_rank, my_node_id, JOB_POWER,
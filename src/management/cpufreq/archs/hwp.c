@@ -0,0 +1,612 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <common/config/config_env.h>
+#include <common/environment_common.h>
+#include <common/hardware/bithack.h>
+#include <common/output/debug.h>
+#include <common/sizes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <management/cpufreq/archs/hwp.h>
+#include <metrics/common/apis.h>
+#include <metrics/common/msr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define REG_PLATFORM_INFO 0x0CE
+#define REG_PERF_CTL      0x199
+#define REG_TURBO_LIMIT   0x1AD
+#define REG_PM_ENABLE     0x770
+#define REG_HWP_CAPS      0x771
+#define REG_HWP_REQUEST   0x774
+
+#define JOURNAL_NAME      ".ear_cpufreq_hwp"
+#define JOURNAL_MAGIC     0x45415248 // EARH
+#define JOURNAL_VERSION   1
+
+// Journal file header, followed by an ullong per CPU with the original value
+// of the register. There is a journal per component (the program name), locked
+// by its owner while alive, so two processes never save over each other. It is
+// kept in the shared temporary folder, so it is only used if it is a regular
+// file owned by this user and nobody else can write it.
+typedef struct journal_s {
+    uint magic;
+    uint version;
+    uint cpu_count;
+    uint reg;
+} journal_t;
+
+static mgt_ps_driver_ops_t *driver;
+static topology_t tp;
+static char journal_path[SZ_PATH];
+static int journal_fd = -1;
+static off_t reg_request;
+static uint hwp_enabled;
+static uint boost_enabled;
+static uint ratio_highest;
+static uint ratio_nominal;
+static uint ratio_lowest;
+static ullong *freqs_available;
+static uint freqs_count;
+static ullong *reqs_current; // Last value of the request register per CPU
+static ullong *reqs_original;
+static ullong *reqs_new;
+
+state_t mgt_cpufreq_hwp_load(topology_t *tp_in, mgt_ps_ops_t *ops, mgt_ps_driver_ops_t *ops_driver)
+{
+    state_t s;
+    int cond2;
+
+    debug("testing HWP P_STATE control status");
+    if (ear_getenv(FLAG_CPUFREQ_MSR) == NULL) {
+        return_msg(EAR_ERROR, Generr.api_undefined);
+    }
+    if (tp_in->vendor != VENDOR_INTEL) {
+        return_msg(EAR_ERROR, Generr.api_incompatible);
+    }
+    // Governors are still managed by the driver
+    if (ops_driver->init == NULL) {
+        return_msg(EAR_ERROR, "Driver is not available");
+    }
+    if (state_fail(s = msr_test(tp_in, MSR_WR))) {
+        return s;
+    }
+    if (tp.cpu_count == 0) {
+        if (state_fail(s = topology_copy(&tp, tp_in))) {
+            return s;
+        }
+    }
+    driver = ops_driver;
+    cond2  = (driver->set_governor != NULL);
+    apis_put(ops->init, mgt_cpufreq_hwp_init);
+    apis_put(ops->dispose, mgt_cpufreq_hwp_dispose);
+    apis_put(ops->get_info, mgt_cpufreq_hwp_get_info);
+    apis_put(ops->get_freq_details, mgt_cpufreq_hwp_get_freq_details);
+    apis_put(ops->count_available, mgt_cpufreq_hwp_count_available);
+    apis_put(ops->get_available_list, mgt_cpufreq_hwp_get_available_list);
+    apis_put(ops->get_current_list, mgt_cpufreq_hwp_get_current_list);
+    apis_put(ops->get_nominal, mgt_cpufreq_hwp_get_nominal);
+    apis_put(ops->get_index, mgt_cpufreq_hwp_get_index);
+    apis_put(ops->set_current_list, mgt_cpufreq_hwp_set_current_list);
+    apis_put(ops->set_current, mgt_cpufreq_hwp_set_current);
+    apis_put(ops->reset, mgt_cpufreq_hwp_reset);
+    apis_put(ops->get_governor, mgt_cpufreq_hwp_governor_get);
+    apis_put(ops->get_governor_list, mgt_cpufreq_hwp_governor_get_list);
+    apis_pin(ops->set_governor, mgt_cpufreq_hwp_governor_set, cond2);
+    apis_pin(ops->set_governor_mask, mgt_cpufreq_hwp_governor_set_mask, cond2);
+    apis_pin(ops->set_governor_list, mgt_cpufreq_hwp_governor_set_list, cond2);
+    return EAR_SUCCESS;
+}
+
+static void static_free()
+{
+    free(freqs_available);
+    free(reqs_current);
+    free(reqs_original);
+    free(reqs_new);
+    freqs_available = NULL;
+    reqs_current    = NULL;
+    reqs_original   = NULL;
+    reqs_new        = NULL;
+    freqs_count     = 0;
+}
+
+static state_t static_dispose(uint close_msr_up_to, state_t s, char *msg)
+{
+    int cpu;
+    for (cpu = 0; cpu < close_msr_up_to; ++cpu) {
+        msr_close(tp.cpus[cpu].id);
+    }
+    static_free();
+    if (driver != NULL) {
+        driver->dispose();
+    }
+    return_msg(s, msg);
+}
+
+/* Writes the values of the list whose CPUs differ from the current one. The
+ * current values are the last ones written, but others (the driver, the BIOS)
+ * could have changed the registers since, so with force all are written. */
+static state_t reqs_write(ullong *values, int force)
+{
+    uint errors   = 0;
+    uint changed  = 0;
+    int error_cpu = -1;
+    uint cpu;
+
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        if (!force && values[cpu] == reqs_current[cpu]) {
+            continue;
+        }
+        changed++;
+        if (state_ok(msr_write(tp.cpus[cpu].id, &values[cpu], sizeof(ullong), reg_request))) {
+            reqs_current[cpu] = values[cpu];
+        } else if (errors++ == 0) {
+            error_cpu = cpu;
+        }
+    }
+    debug("%u CPUs changed of %u", changed, tp.cpu_count);
+    if (errors) {
+        return_print(EAR_ERROR, "%u of %u CPU frequency MSR writes failed (first at CPU%d)", errors, changed,
+                     error_cpu);
+    }
+    return EAR_SUCCESS;
+}
+
+static state_t reqs_read()
+{
+    state_t s;
+    uint cpu;
+
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        if (state_fail(s = msr_read(tp.cpus[cpu].id, &reqs_current[cpu], sizeof(ullong), reg_request))) {
+            return s;
+        }
+    }
+    return EAR_SUCCESS;
+}
+
+extern char *program_invocation_short_name;
+
+static void journal_build_path()
+{
+    char *tmp = ear_getenv(ENV_PATH_TMP);
+    snprintf(journal_path, sizeof(journal_path), "%s/%s.%s", (tmp != NULL) ? tmp : "/tmp", JOURNAL_NAME,
+             program_invocation_short_name);
+}
+
+/* Opens and locks the journal. A lock is released when its owner dies, so
+ * it fails only if other process of the same component is alive. Links are
+ * not followed, and a journal which could have been written by other users is
+ * not opened (nor removed). */
+static state_t journal_open()
+{
+    struct stat st;
+
+    journal_fd = open(journal_path, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    if (journal_fd < 0 && errno == ENOENT) {
+        journal_fd = open(journal_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    }
+    if (journal_fd < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    if (fstat(journal_fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() || st.st_nlink != 1 ||
+        (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        close(journal_fd);
+        journal_fd = -1;
+        return_msg(EAR_ERROR, "HWP journal not owned by this user or writable by others");
+    }
+    if (flock(journal_fd, LOCK_EX | LOCK_NB) < 0) {
+        close(journal_fd);
+        journal_fd = -1;
+        return_msg(EAR_BUSY, "HWP journal locked by other process");
+    }
+    return EAR_SUCCESS;
+}
+
+/* Removes the journal and releases the lock. */
+static void journal_close()
+{
+    if (journal_fd < 0) {
+        return;
+    }
+    unlink(journal_path);
+    close(journal_fd);
+    journal_fd = -1;
+}
+
+/* Checks that a request register value could have been set by the OS, in the
+ * P_STATE range of the node (Intel SDM Vol. 3B, 15.4.4 and 15.3.2). */
+static int request_valid(ullong reg)
+{
+    uint ratio_max = (uint) getbits64(reg, 15, 8);
+    uint ratio_min = (uint) getbits64(reg, 7, 0);
+
+    if (ratio_max < ratio_lowest || ratio_max > ratio_highest) {
+        return 0;
+    }
+    if (!hwp_enabled) {
+        return 1;
+    }
+    // Bits 58:43 are reserved
+    return (ratio_min >= ratio_lowest && ratio_min <= ratio_max && getbits64(reg, 58, 43) == 0LLU);
+}
+
+/* Loads the original values saved by a previous process which didn't restore
+ * them. Fails if there is no journal, it doesn't belong to this node mode or
+ * its values can't be written in the registers. */
+static state_t journal_load()
+{
+    size_t size = tp.cpu_count * sizeof(ullong);
+    journal_t j;
+    uint cpu;
+
+    if (pread(journal_fd, &j, sizeof(journal_t), 0) != sizeof(journal_t) || j.magic != JOURNAL_MAGIC ||
+        j.version != JOURNAL_VERSION || j.cpu_count != tp.cpu_count || j.reg != (uint) reg_request ||
+        pread(journal_fd, reqs_original, size, sizeof(journal_t)) != size) {
+        return_msg(EAR_ERROR, "Invalid HWP journal");
+    }
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        if (!request_valid(reqs_original[cpu])) {
+            return_print(EAR_ERROR, "Invalid HWP journal value 0x%llx (CPU%u)", reqs_original[cpu], cpu);
+        }
+    }
+    return EAR_SUCCESS;
+}
+
+static state_t journal_save()
+{
+    size_t size = tp.cpu_count * sizeof(ullong);
+    journal_t j = {.magic = JOURNAL_MAGIC, .version = JOURNAL_VERSION, .cpu_count = tp.cpu_count, .reg = reg_request};
+
+    if (ftruncate(journal_fd, 0) < 0 || pwrite(journal_fd, &j, sizeof(journal_t), 0) != sizeof(journal_t) ||
+        pwrite(journal_fd, reqs_original, size, sizeof(journal_t)) != size) {
+        return_msg(EAR_ERROR, "Error while writing the HWP journal");
+    }
+    return EAR_SUCCESS;
+}
+
+static state_t build_pstate_list()
+{
+    ullong reg;
+    state_t s;
+    uint i;
+
+    // Intel SDM Vol. 3B, 15.4.3 HWP Performance Range and Dynamic Capabilities
+    if (hwp_enabled) {
+        if (state_fail(s = msr_read(tp.cpus[0].id, &reg, sizeof(ullong), REG_HWP_CAPS))) {
+            return s;
+        }
+        ratio_highest = (uint) getbits64(reg, 7, 0);
+        ratio_nominal = (uint) getbits64(reg, 15, 8);
+        ratio_lowest  = (uint) getbits64(reg, 31, 24);
+    } else {
+        if (state_fail(s = msr_read(tp.cpus[0].id, &reg, sizeof(ullong), REG_PLATFORM_INFO))) {
+            return s;
+        }
+        ratio_nominal = (uint) getbits64(reg, 15, 8);
+        ratio_lowest  = (uint) getbits64(reg, 47, 40);
+        // Maximum ratio limit for 1 active core, if not available there is no boost
+        ratio_highest = ratio_nominal;
+        if (state_ok(msr_read(tp.cpus[0].id, &reg, sizeof(ullong), REG_TURBO_LIMIT))) {
+            ratio_highest = (uint) getbits64(reg, 7, 0);
+        }
+    }
+    debug("ratios: highest %u, nominal %u, lowest %u", ratio_highest, ratio_nominal, ratio_lowest);
+    if (ratio_nominal == 0 || ratio_lowest == 0 || ratio_lowest > ratio_nominal) {
+        return_msg(EAR_ERROR, "Incorrect P_STATE limits");
+    }
+    boost_enabled = (ratio_highest > ratio_nominal);
+    freqs_count   = boost_enabled + (ratio_nominal - ratio_lowest) + 1;
+    if ((freqs_available = calloc(freqs_count, sizeof(ullong))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    // Boost P_STATE follows the CPUFreq notation (nominal + 1 MHz)
+    if (boost_enabled) {
+        freqs_available[0] = (ratio_nominal * 100000LLU) + 1000LLU;
+    }
+    for (i = boost_enabled; i < freqs_count; ++i) {
+        freqs_available[i] = (ratio_nominal - (i - boost_enabled)) * 100000LLU;
+        debug("PS%u: %llu KHz", i, freqs_available[i]);
+    }
+    return EAR_SUCCESS;
+}
+
+state_t mgt_cpufreq_hwp_init(ctx_t *c)
+{
+    ullong reg;
+    state_t s;
+    int cpu;
+
+    debug("Initializing HWP P_STATE control");
+    if (state_fail(s = driver->init())) {
+        return static_dispose(0, s, state_msg);
+    }
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        if (state_fail(s = msr_open(tp.cpus[cpu].id, MSR_WR))) {
+            return static_dispose(cpu, s, state_msg);
+        }
+    }
+    // If HWP is enabled PERF_CTL writes are ignored (Intel SDM Vol. 3B, 15.4.2)
+    if (state_fail(s = msr_read(tp.cpus[0].id, &reg, sizeof(ullong), REG_PM_ENABLE))) {
+        reg = 0LLU;
+    }
+    hwp_enabled = (uint) getbits64(reg, 0, 0);
+    reg_request = (hwp_enabled) ? REG_HWP_REQUEST : REG_PERF_CTL;
+    if (state_fail(s = build_pstate_list())) {
+        return static_dispose(tp.cpu_count, s, state_msg);
+    }
+    reqs_current  = calloc(tp.cpu_count, sizeof(ullong));
+    reqs_original = calloc(tp.cpu_count, sizeof(ullong));
+    reqs_new      = calloc(tp.cpu_count, sizeof(ullong));
+    if (!reqs_current || !reqs_original || !reqs_new) {
+        return static_dispose(tp.cpu_count, EAR_ERROR, Generr.alloc_error);
+    }
+    if (state_fail(s = reqs_read())) {
+        return static_dispose(tp.cpu_count, s, state_msg);
+    }
+    // If a journal exists, the previous owner did not restore the registers
+    journal_build_path();
+    if (state_fail(s = journal_open())) {
+        debug("Journal %s not opened: %s", journal_path, state_msg);
+        memcpy(reqs_original, reqs_current, tp.cpu_count * sizeof(ullong));
+    } else if (state_fail(journal_load())) {
+        memcpy(reqs_original, reqs_current, tp.cpu_count * sizeof(ullong));
+        if (state_fail(s = journal_save())) {
+            debug("Journal %s not saved: %s", journal_path, state_msg);
+            journal_close();
+        }
+    } else {
+        debug("Loaded original registers from journal %s", journal_path);
+    }
+    debug("Initialized correctly in %s mode with %u P_STATEs", (hwp_enabled) ? "HWP" : "PERF_CTL", freqs_count);
+    return EAR_SUCCESS;
+}
+
+state_t mgt_cpufreq_hwp_dispose(ctx_t *c)
+{
+    if (reqs_original != NULL) {
+        reqs_write(reqs_original, 1);
+    }
+    journal_close();
+    return static_dispose(tp.cpu_count, EAR_SUCCESS, NULL);
+}
+
+void mgt_cpufreq_hwp_get_info(apinfo_t *info)
+{
+    info->api        = API_HWP;
+    info->devs_count = tp.cpu_count;
+}
+
+void mgt_cpufreq_hwp_get_freq_details(freq_details_t *details)
+{
+    if (driver->get_freq_details != NULL) {
+        driver->get_freq_details(details);
+    }
+}
+
+state_t mgt_cpufreq_hwp_count_available(ctx_t *c, uint *pstate_count)
+{
+    *pstate_count = freqs_count;
+    return EAR_SUCCESS;
+}
+
+state_t mgt_cpufreq_hwp_get_available_list(ctx_t *c, pstate_t *pstate_list)
+{
+    uint i;
+    for (i = 0; i < freqs_count; ++i) {
+        pstate_list[i].idx = i;
+        pstate_list[i].khz = freqs_available[i];
+    }
+    return EAR_SUCCESS;
+}
+
+/* Ratio to P_STATE, the ratios over the nominal are the boost P_STATE. */
+static uint ratio_to_pstate(uint ratio)
+{
+    if (ratio > ratio_nominal) {
+        return 0;
+    }
+    if (ratio < ratio_lowest) {
+        return freqs_count - 1;
+    }
+    return boost_enabled + (ratio_nominal - ratio);
+}
+
+static uint pstate_to_ratio(uint pstate)
+{
+    if (boost_enabled && pstate == 0) {
+        return ratio_highest;
+    }
+    return ratio_nominal - (pstate - boost_enabled);
+}
+
+state_t mgt_cpufreq_hwp_get_current_list(ctx_t *c, pstate_t *pstate_list)
+{
+    uint cpu, ratio;
+
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        // HWP maximum performance and PERF_CTL target ratio share the bits
+        ratio = (uint) getbits64(reqs_current[cpu], 15, 8);
+        pstate_list[cpu].idx = ratio_to_pstate(ratio);
+        pstate_list[cpu].khz = freqs_available[pstate_list[cpu].idx];
+    }
+    return EAR_SUCCESS;
+}
+
+state_t mgt_cpufreq_hwp_get_nominal(ctx_t *c, uint *pstate_index)
+{
+    *pstate_index = boost_enabled;
+    return EAR_SUCCESS;
+}
+
+state_t mgt_cpufreq_hwp_get_index(ctx_t *c, ullong freq_khz, uint *pstate_index, uint closest)
+{
+    uint pst;
+
+    if (freq_khz == 0LLU) {
+        return_msg(EAR_ERROR, "P_STATE not found for 0 KHz");
+    }
+    if (boost_enabled && freqs_available[0] == freq_khz) {
+        *pstate_index = 0;
+        return EAR_SUCCESS;
+    }
+    for (pst = boost_enabled; pst < freqs_count; ++pst) {
+        if (freq_khz == freqs_available[pst]) {
+            *pstate_index = pst;
+            return EAR_SUCCESS;
+        }
+    }
+    if (!closest) {
+        return_msg(EAR_ERROR, "P_STATE not found");
+    }
+    // Steps are of 100 MHz, rounding to the closest ratio
+    if (freq_khz >= freqs_available[boost_enabled]) {
+        *pstate_index = boost_enabled;
+    } else {
+        *pstate_index = ratio_to_pstate((uint) ((freq_khz + 50000LLU) / 100000LLU));
+    }
+    return EAR_SUCCESS;
+}
+
+/* Composes the request register of a CPU for a P_STATE range. */
+static ullong compose_request(ullong reg, uint pstate_min, uint pstate_max)
+{
+    uint ratio_max = pstate_to_ratio(pstate_max);
+    uint ratio_min = pstate_to_ratio(pstate_min);
+
+    if (!hwp_enabled) {
+        return setbits64(reg, (ullong) ratio_max, 15, 8);
+    }
+    // Boost is a range from nominal to highest, the hardware decides
+    if (boost_enabled && pstate_min == 0) {
+        ratio_min = ratio_nominal;
+    }
+    // Desired performance to 0 lets the hardware select in the range
+    reg = setbits64(reg, (ullong) ratio_min, 7, 0);
+    reg = setbits64(reg, (ullong) ratio_max, 15, 8);
+    reg = setbits64(reg, 0LLU, 23, 16);
+    return reg;
+}
+
+state_t mgt_cpufreq_hwp_set_current_list(ctx_t *c, uint *pstate_index)
+{
+    uint cpu;
+
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        reqs_new[cpu] = reqs_current[cpu];
+        if (pstate_index[cpu] == ps_nothing) {
+            continue;
+        }
+        if (pstate_index[cpu] >= freqs_count) {
+            return_msg(EAR_ERROR, Generr.arg_outbounds);
+        }
+        reqs_new[cpu] = compose_request(reqs_current[cpu], pstate_index[cpu], pstate_index[cpu]);
+    }
+    return reqs_write(reqs_new, 0);
+}
+
+state_t mgt_cpufreq_hwp_set_current(ctx_t *c, uint pstate_index, int cpu)
+{
+    uint i;
+
+    if (pstate_index >= freqs_count) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    if (cpu != all_cpus && (cpu < 0 || cpu >= tp.cpu_count)) {
+        return_msg(EAR_ERROR, Generr.cpu_invalid);
+    }
+    for (i = 0; i < tp.cpu_count; ++i) {
+        reqs_new[i] = reqs_current[i];
+        if (cpu == all_cpus || cpu == i) {
+            reqs_new[i] = compose_request(reqs_current[i], pstate_index, pstate_index);
+        }
+    }
+    return reqs_write(reqs_new, 0);
+}
+
+state_t mgt_cpufreq_hwp_set_range_list(ctx_t *c, uint *pstate_min, uint *pstate_max, uint epp)
+{
+    uint cpu;
+
+    if (!hwp_enabled) {
+        return_msg(EAR_ERROR, "HWP is not enabled");
+    }
+    if (epp != HWP_EPP_KEEP && epp > 255) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        reqs_new[cpu] = reqs_current[cpu];
+        if (pstate_min[cpu] == ps_nothing || pstate_max[cpu] == ps_nothing) {
+            continue;
+        }
+        // The minimum P_STATE is the maximum frequency
+        if (pstate_min[cpu] >= freqs_count || pstate_max[cpu] >= freqs_count || pstate_min[cpu] < pstate_max[cpu]) {
+            return_msg(EAR_ERROR, Generr.arg_outbounds);
+        }
+        reqs_new[cpu] = compose_request(reqs_current[cpu], pstate_min[cpu], pstate_max[cpu]);
+        if (epp != HWP_EPP_KEEP) {
+            reqs_new[cpu] = setbits64(reqs_new[cpu], (ullong) epp, 31, 24);
+        }
+    }
+    return reqs_write(reqs_new, 0);
+}
+
+state_t mgt_cpufreq_hwp_reset(ctx_t *c)
+{
+    return reqs_write(reqs_original, 1);
+}
+
+// Governors
+state_t mgt_cpufreq_hwp_governor_get(ctx_t *c, uint *governor)
+{
+    return driver->get_governor(governor);
+}
+
+state_t mgt_cpufreq_hwp_governor_get_list(ctx_t *c, uint *governors)
+{
+    return driver->get_governor_list(governors);
+}
+
+// The driver writes the request register when changing the governor, so it is
+// read again to keep the list of current values updated.
+state_t mgt_cpufreq_hwp_governor_set(ctx_t *c, uint governor)
+{
+    state_t s;
+    if (state_fail(s = driver->set_governor(governor))) {
+        return s;
+    }
+    return reqs_read();
+}
+
+state_t mgt_cpufreq_hwp_governor_set_mask(ctx_t *c, uint governor, cpu_set_t mask)
+{
+    state_t s;
+    if (state_fail(s = driver->set_governor_mask(governor, mask))) {
+        return s;
+    }
+    return reqs_read();
+}
+
+state_t mgt_cpufreq_hwp_governor_set_list(ctx_t *c, uint *governors)
+{
+    state_t s;
+    if (state_fail(s = driver->set_governor_list(governors))) {
+        return s;
+    }
+    return reqs_read();
+}
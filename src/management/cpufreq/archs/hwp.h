@@ -0,0 +1,80 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef MANAGEMENT_CPUFREQ_ARCHS_HWP
+#define MANAGEMENT_CPUFREQ_ARCHS_HWP
+
+#include <management/cpufreq/cpufreq.h>
+
+// Intel direct P_STATE control:
+//
+// This API writes the frequency requests in the MSRs instead of passing
+// through the CPUFreq driver. If HWP is enabled (IA32_PM_ENABLE) it writes
+// IA32_HWP_REQUEST, pinning the minimum and maximum performance to the
+// requested ratio. If not, it writes the target ratio in IA32_PERF_CTL.
+//
+// P_STATEs are built from the hardware limits in steps of 100 MHz, from
+// the nominal (or boost) to the lowest ratio. Writes are done per CPU and
+// only for the CPUs whose request changes.
+//
+// The register values found before the first write are saved in a journal
+// file in EAR_TMP. They are written back by reset and dispose. If the
+// previous process did not restore them (i.e. it crashed), the journal
+// values are the ones restored.
+//
+// Because it bypasses the CPUFreq governors, it only loads if EAR_CPUFREQ_MSR
+// is defined. Governor functions still rely on the driver.
+
+// Keeps the current energy performance preference in set_range_list.
+#define HWP_EPP_KEEP ((uint) -1)
+
+state_t mgt_cpufreq_hwp_load(topology_t *tp, mgt_ps_ops_t *ops, mgt_ps_driver_ops_t *ops_driver);
+
+state_t mgt_cpufreq_hwp_init(ctx_t *c);
+
+state_t mgt_cpufreq_hwp_dispose(ctx_t *c);
+
+void mgt_cpufreq_hwp_get_info(apinfo_t *info);
+
+void mgt_cpufreq_hwp_get_freq_details(freq_details_t *details);
+
+state_t mgt_cpufreq_hwp_count_available(ctx_t *c, uint *pstate_count);
+
+state_t mgt_cpufreq_hwp_get_available_list(ctx_t *c, pstate_t *pstate_list);
+
+state_t mgt_cpufreq_hwp_get_current_list(ctx_t *c, pstate_t *pstate_list);
+
+state_t mgt_cpufreq_hwp_get_nominal(ctx_t *c, uint *pstate_index);
+
+state_t mgt_cpufreq_hwp_get_index(ctx_t *c, ullong freq_khz, uint *pstate_index, uint closest);
+
+state_t mgt_cpufreq_hwp_set_current_list(ctx_t *c, uint *pstate_index);
+
+state_t mgt_cpufreq_hwp_set_current(ctx_t *c, uint pstate_index, int cpu);
+
+/** Sets a range of P_STATEs per CPU and, if it is not HWP_EPP_KEEP, the energy
+ * performance preference (0 performance, 255 energy). HWP must be enabled. A
+ * ps_nothing in any of both lists leaves that CPU untouched. */
+state_t mgt_cpufreq_hwp_set_range_list(ctx_t *c, uint *pstate_min, uint *pstate_max, uint epp);
+
+state_t mgt_cpufreq_hwp_reset(ctx_t *c);
+
+// Governors
+state_t mgt_cpufreq_hwp_governor_get(ctx_t *c, uint *governor);
+
+state_t mgt_cpufreq_hwp_governor_get_list(ctx_t *c, uint *governors);
+
+state_t mgt_cpufreq_hwp_governor_set(ctx_t *c, uint governor);
+
+state_t mgt_cpufreq_hwp_governor_set_mask(ctx_t *c, uint governor, cpu_set_t mask);
+
+state_t mgt_cpufreq_hwp_governor_set_list(ctx_t *c, uint *governors);
+
+#endif // MANAGEMENT_CPUFREQ_ARCHS_HWP
@@ -17,6 +17,7 @@
 #include <management/cpufreq/archs/default.h>
 #include <management/cpufreq/archs/dummy.h>
 #include <management/cpufreq/archs/eard.h>
+#include <management/cpufreq/archs/hwp.h>
 #include <management/cpufreq/cpufreq.h>
 #include <management/cpufreq/drivers/acpi_cpufreq.h>
 #include <management/cpufreq/drivers/intel_pstate.h>
@@ -48,6 +49,13 @@ state_t mgt_cpufreq_load(topology_t *tp, int force_api)
     if (API_IS(force_api, API_DUMMY)) {
         goto dummy;
     }
+    // HWP loads if it is requested by environment, MSR test is passed and
+    // driver can be initialized. It goes first because it replaces the driver
+    // set functions, but not the governor ones.
+    if (state_ok(s = mgt_cpufreq_hwp_load(tp, &ops, &ops_driver))) {
+        api = API_HWP;
+        debug("Loaded HWP");
+    }
     // AMD17 loads if MSR test is passed and driver can be initialized. But it
     // does not add its set functions if driver can't write. Also, AMD17 goes
     // before because it works with DEFAULT but the AMD17 dedicated API is
@@ -14,6 +14,7 @@
 #include <common/hardware/bithack.h>
 #include <common/hardware/cpuid.h>
 #include <common/hardware/defines.h>
+#include <common/hardware/hwroot.h>
 #include <common/output/debug.h>
 #include <common/system/time.h>
 #include <common/utils/stress.h>
@@ -154,6 +155,14 @@ static int basefreq_environment(topology_t *tp, cpufreq_base_t *base)
     return basefreq_completed();
 }
 
+// Adds the hardware root prefix (if any) to a sysfs file.
+static char *file_path(char *file)
+{
+    static char path[SZ_PATH];
+    sprintf(path, "%s%s", hwroot_get(), file);
+    return path;
+}
+
 static int basefreq_file_baf(topology_t *tp, cpufreq_base_t *base)
 {
     char buffer[128];
@@ -161,7 +170,7 @@ static int basefreq_file_baf(topology_t *tp, cpufreq_base_t *base)
     if (found_freq) {
         return 0;
     }
-    if (filemagic_once_read(FILE_BAF, buffer, sizeof(buffer))) {
+    if (filemagic_once_read(file_path(FILE_BAF), buffer, sizeof(buffer))) {
         base->frequency = (ullong) atoi(buffer);
         basefreq_found_set(1, 0);
     } else {
@@ -178,7 +187,7 @@ static int basefreq_file_ntb(topology_t *tp, cpufreq_base_t *base)
         return 0;
     }
     // intel_pstate (https://wiki.archlinux.org/title/CPU_frequency_scaling)
-    if (filemagic_once_read(FILE_NTB, buffer, sizeof(buffer))) {
+    if (filemagic_once_read(file_path(FILE_NTB), buffer, sizeof(buffer))) {
         base->boost_enabled = atoi(buffer);
         base->boost_enabled = !base->boost_enabled;
         basefreq_found_set(0, 1);
@@ -196,10 +205,10 @@ static int basefreq_file_cpb(topology_t *tp, cpufreq_base_t *base)
         return 0;
     }
     // non intel_pstate
-    if (filemagic_once_read(FILE_BST, buffer, sizeof(buffer))) {
+    if (filemagic_once_read(file_path(FILE_BST), buffer, sizeof(buffer))) {
         base->boost_enabled = atoi(buffer);
         basefreq_found_set(0, 1);
-    } else if (filemagic_once_read(FILE_CPB, buffer, sizeof(buffer))) {
+    } else if (filemagic_once_read(file_path(FILE_CPB), buffer, sizeof(buffer))) {
         base->boost_enabled = atoi(buffer);
         basefreq_found_set(0, 1);
     } else {
@@ -227,7 +236,7 @@ static int basefreq_file_saf(topology_t *tp, cpufreq_base_t *base)
     ullong f0, f1;
     int fd;
     // This is a complete function
-    if ((fd = open(FILE_SAF, O_RDONLY)) < 0) {
+    if ((fd = open(file_path(FILE_SAF), O_RDONLY)) < 0) {
         sprintf(reason, "%s", strerror(errno));
         return 0;
     }
@@ -310,8 +319,8 @@ static int basefreq_file_smf(topology_t *tp, cpufreq_base_t *base)
     // if the frequency is already found, and the found frequency is not
     // under the CMF or SMF frequency, it means that turbo boost
     // could be enabled. We don't considere this method reliable.
-    if (filemagic_once_read(FILE_CMF, buffer, sizeof(buffer)) ||
-        filemagic_once_read(FILE_SMF, buffer, sizeof(buffer))) {
+    if (filemagic_once_read(file_path(FILE_CMF), buffer, sizeof(buffer)) ||
+        filemagic_once_read(file_path(FILE_SMF), buffer, sizeof(buffer))) {
         if (!found_boost && found_freq) {
             base->boost_enabled = ((ullong) atoi(buffer) > base->frequency);
             basefreq_found_set(0, 1);
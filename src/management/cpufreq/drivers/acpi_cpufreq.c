@@ -17,6 +17,7 @@
 #include <management/cpufreq/cpufreq_base.h>
 #include <management/cpufreq/drivers/acpi_cpufreq.h>
 #include <management/cpufreq/drivers/intel_pstate.h>
+#include <management/cpufreq/drivers/sysfs_cache.h>
 #include <metrics/common/file.h>
 #include <sched.h>
 #include <stdlib.h>
@@ -38,6 +39,8 @@ static uint avail_list_count;
 static ullong avail_list_real[N_FREQS]; // From 10 GHz to 1 GHz there are 90 items, enough
 static ullong avail_list_disp[N_FREQS]; // Returned frequencies
 static ullong *current_list;
+static ullong *set_list;
+static sysfs_cache_t sss_cache;
 static int *fds_sgv;
 static int *fds_sss;
 static uint governor_last;
@@ -170,6 +173,13 @@ void mgt_acpi_cpufreq_load(topology_t *tp, mgt_ps_driver_ops_t *ops)
     // Allocating space for current list
     cpu_count    = tp->cpu_count;
     current_list = calloc(cpu_count, sizeof(ullong));
+    set_list     = calloc(cpu_count, sizeof(ullong));
+    if (set_list == NULL || state_fail(sysfs_cache_init(&sss_cache, tp, fds_sss))) {
+        // The lists are written CPU by CPU, without the cache
+        debug("Error when allocating the setspeed cache: %s", state_msg);
+        free(set_list);
+        set_list = NULL;
+    }
     // Checking max/min frequency
     if (!mgt_intel_pstate_read_cpuinfo(1, &freq_max0)) {
         if (!keeper_load_uint64("AcpiCpufreqMaxFrequency", &freq_max0)) {
@@ -223,11 +233,15 @@ state_t mgt_acpi_cpufreq_init()
 
 state_t mgt_acpi_cpufreq_dispose()
 {
+    sysfs_cache_dispose(&sss_cache);
+    free(set_list);
+    set_list = NULL;
     return EAR_SUCCESS;
 }
 
 state_t mgt_acpi_cpufreq_reset()
 {
+    sysfs_cache_invalidate(&sss_cache);
     return EAR_SUCCESS;
 }
 
@@ -278,7 +292,8 @@ state_t mgt_acpi_cpufreq_get_boost(uint *boost_enabled)
 }
 
 /** Setters */
-state_t mgt_acpi_cpufreq_set_current_list(uint *freqs_index)
+// Writes every CPU of the list, used when there is no cache
+static state_t set_current_list_direct(uint *freqs_index)
 {
     char data[SZ_NAME_SHORT];
     state_t s = EAR_SUCCESS;
@@ -288,12 +303,10 @@ state_t mgt_acpi_cpufreq_set_current_list(uint *freqs_index)
         if (freqs_index[cpu] == ps_nothing) {
             continue;
         }
-        if (freqs_index[cpu] > avail_list_count) {
+        if (freqs_index[cpu] >= avail_list_count) {
             freqs_index[cpu] = avail_list_count - 1;
         }
-        sprintf(data, "%llu", avail_list_real[freqs_index[cpu]]);
-        debug("set_list%d: %llu", cpu, avail_list_real[freqs_index[cpu]]);
-        strcat(data, "\n");
+        sprintf(data, "%llu\n", avail_list_real[freqs_index[cpu]]);
         if (!filemagic_word_write(fds_sss[cpu], data, strlen(data), 0)) {
             s = EAR_ERROR;
         }
@@ -301,6 +314,28 @@ state_t mgt_acpi_cpufreq_set_current_list(uint *freqs_index)
     return s;
 }
 
+state_t mgt_acpi_cpufreq_set_current_list(uint *freqs_index)
+{
+    int cpu;
+
+    if (set_list == NULL) {
+        return set_current_list_direct(freqs_index);
+    }
+    // The cache writes just the CPUs whose frequency changes
+    for (cpu = 0; cpu < cpu_count; ++cpu) {
+        if (freqs_index[cpu] == ps_nothing) {
+            set_list[cpu] = 0LLU;
+            continue;
+        }
+        if (freqs_index[cpu] >= avail_list_count) {
+            freqs_index[cpu] = avail_list_count - 1;
+        }
+        set_list[cpu] = avail_list_real[freqs_index[cpu]];
+        debug("set_list%d: %llu", cpu, set_list[cpu]);
+    }
+    return sysfs_cache_write(&sss_cache, set_list);
+}
+
 state_t mgt_acpi_cpufreq_set_current(uint freq_index, int cpu)
 {
     char data[SZ_NAME_SHORT];
@@ -312,14 +347,24 @@ state_t mgt_acpi_cpufreq_set_current(uint freq_index, int cpu)
     if (cpu == all_cpus) {
         // Converting frequency to text
         sprintf(data, "%llu", avail_list_real[freq_index]);
-        return (filemagic_word_mwrite(fds_sss, cpu_count, data, 1) ? EAR_SUCCESS : EAR_ERROR);
+        if (!filemagic_word_mwrite(fds_sss, cpu_count, data, 1)) {
+            sysfs_cache_invalidate(&sss_cache);
+            return EAR_ERROR;
+        }
+        sysfs_cache_set(&sss_cache, all_cpus, avail_list_real[freq_index]);
+        return EAR_SUCCESS;
     }
     // If it is for a specified CPU
     if (cpu >= 0 && cpu < cpu_count) {
         sprintf(data, "%llu", avail_list_real[freq_index]);
         debug("writing a word '%s'", data);
         strcat(data, "\n");
-        return (filemagic_word_write(fds_sss[cpu], data, strlen(data), 0) ? EAR_SUCCESS : EAR_ERROR);
+        if (!filemagic_word_write(fds_sss[cpu], data, strlen(data), 0)) {
+            sysfs_cache_set(&sss_cache, cpu, 0LLU);
+            return EAR_ERROR;
+        }
+        sysfs_cache_set(&sss_cache, cpu, avail_list_real[freq_index]);
+        return EAR_SUCCESS;
     }
     return_msg(EAR_ERROR, Generr.cpu_invalid);
 }
@@ -370,6 +415,8 @@ state_t mgt_acpi_cpufreq_governor_set(uint governor)
     if (state_fail(s = mgt_governor_tostr(governor, buffer))) {
         return s;
     }
+    // The governor switch can change the setspeed value
+    sysfs_cache_invalidate(&sss_cache);
     return (filemagic_word_mwrite(fds_sgv, cpu_count, buffer, 1) ? EAR_SUCCESS : EAR_ERROR);
 }
 
@@ -386,6 +433,7 @@ state_t mgt_acpi_cpufreq_governor_set_mask(uint governor, cpu_set_t mask)
     for (cpu = 0; cpu < cpu_count; ++cpu) {
         if (CPU_ISSET(cpu, &mask)) {
             // verbose(0,"Setting cpu %d to governor '%s'", cpu, buffer);
+            sysfs_cache_set(&sss_cache, cpu, 0LLU);
             if (!filemagic_word_write(fds_sgv[cpu], buffer, strlen(buffer), 0)) {
                 s = EAR_ERROR;
             }
@@ -405,6 +453,7 @@ state_t mgt_acpi_cpufreq_governor_set_list(uint *governors)
             return s;
         }
         strcat(buffer, "\n");
+        sysfs_cache_set(&sss_cache, cpu, 0LLU);
         if (!filemagic_word_write(fds_sgv[cpu], buffer, strlen(buffer), 0)) {
             return EAR_ERROR;
         }
@@ -18,6 +18,7 @@
 #include <fcntl.h>
 #include <management/cpufreq/cpufreq_base.h>
 #include <management/cpufreq/drivers/intel_pstate.h>
+#include <management/cpufreq/drivers/sysfs_cache.h>
 #include <metrics/common/file.h>
 #include <sched.h>
 #include <stdlib.h>
@@ -33,6 +34,8 @@
 
 static uint cpu_count;
 static ullong *current_list;
+static ullong *set_list;
+static sysfs_cache_t smf_cache;
 static uint avail_list_count;
 static ullong avail_list[128]; // From 10 GHz to 1 GHz there are 90 items, enough
 static cfb_t bf;
@@ -91,6 +94,13 @@ void mgt_intel_pstate_load(topology_t *tp, mgt_ps_driver_ops_t *ops)
     cpu_count    = tp->cpu_count;
     freq_max     = freq_max0;
     current_list = calloc(cpu_count, sizeof(ullong));
+    set_list     = calloc(cpu_count, sizeof(ullong));
+    if (set_list == NULL || state_fail(sysfs_cache_init(&smf_cache, tp, fds_smf))) {
+        // The lists are written CPU by CPU, without the cache
+        debug("Error when allocating the scaling_max_freq cache: %s", state_msg);
+        free(set_list);
+        set_list = NULL;
+    }
     //
     mgt_intel_pstate_governor_get(&governor0);
     keeper_macro(uint32, "IntelPstateDefaultGovernor", governor0);
@@ -147,11 +157,15 @@ state_t mgt_intel_pstate_init()
 
 state_t mgt_intel_pstate_dispose()
 {
+    sysfs_cache_dispose(&smf_cache);
+    free(set_list);
+    set_list = NULL;
     return EAR_SUCCESS;
 }
 
 state_t mgt_intel_pstate_reset()
 {
+    sysfs_cache_invalidate(&smf_cache);
     return EAR_SUCCESS;
 }
 
@@ -205,37 +219,51 @@ state_t mgt_intel_pstate_get_boost(uint *boost_enabled)
 }
 
 /** Setters */
+// The value written in scaling_max_freq for a P_STATE. Boost is requested by
+// writing the maximum frequency.
+static ullong index_to_khz(uint freq_index)
+{
+    // Correcting invalid values
+    if (freq_index >= avail_list_count) {
+        freq_index = avail_list_count - 1;
+    }
+    if (bf.boost_enabled && freq_index == 0) {
+        return freq_max0;
+    }
+    return avail_list[freq_index];
+}
+
 state_t mgt_intel_pstate_set_current(uint freq_index, int cpu)
 {
     char data[SZ_NAME_SHORT];
+    ullong khz;
     //
     if (freq_index == ps_nothing) {
         return EAR_SUCCESS;
     }
-    // Correcting invalid values
-    if (freq_index >= avail_list_count) {
-        freq_index = avail_list_count - 1;
-    }
+    khz = index_to_khz(freq_index);
     // If is one P_STATE for all CPUs
     if (cpu == all_cpus) {
         debug("All cpus: boost enabled: %u, freq index %u", bf.boost_enabled, freq_index);
-        if (bf.boost_enabled && freq_index == 0) {
-            sprintf(data, "%llu", freq_max0);
-        } else {
-            sprintf(data, "%llu", avail_list[freq_index]);
+        sprintf(data, "%llu", khz);
+        if (!filemagic_word_mwrite(fds_smf, cpu_count, data, 1)) {
+            sysfs_cache_invalidate(&smf_cache);
+            return EAR_ERROR;
         }
-        return (filemagic_word_mwrite(fds_smf, cpu_count, data, 1) ? EAR_SUCCESS : EAR_ERROR);
+        sysfs_cache_set(&smf_cache, all_cpus, khz);
+        return EAR_SUCCESS;
     }
     // If it is for a specified CPU
     if (cpu >= 0 && cpu < cpu_count) {
-        if (bf.boost_enabled && freq_index == 0) {
-            sprintf(data, "%llu", freq_max0);
-        } else {
-            sprintf(data, "%llu", avail_list[freq_index]);
-        }
+        sprintf(data, "%llu", khz);
         debug("writing a word '%s' freq_index %u freq_max %llu", data, freq_index, freq_max0);
         strcat(data, "\n");
-        return (filemagic_word_write(fds_smf[cpu], data, strlen(data), 0) ? EAR_SUCCESS : EAR_ERROR);
+        if (!filemagic_word_write(fds_smf[cpu], data, strlen(data), 0)) {
+            sysfs_cache_set(&smf_cache, cpu, 0LLU);
+            return EAR_ERROR;
+        }
+        sysfs_cache_set(&smf_cache, cpu, khz);
+        return EAR_SUCCESS;
     }
     return_msg(EAR_ERROR, Generr.cpu_invalid);
 }
@@ -243,10 +271,19 @@ state_t mgt_intel_pstate_set_current(uint freq_index, int cpu)
 state_t mgt_intel_pstate_set_current_list(uint *freqs_index)
 {
     int cpu;
+
+    // Without the cache every CPU is written
+    if (set_list == NULL) {
+        for (cpu = 0; cpu < cpu_count; ++cpu) {
+            mgt_intel_pstate_set_current(freqs_index[cpu], cpu);
+        }
+        return EAR_SUCCESS;
+    }
+    // The cache writes just the CPUs whose frequency changes
     for (cpu = 0; cpu < cpu_count; ++cpu) {
-        mgt_intel_pstate_set_current(freqs_index[cpu], cpu);
+        set_list[cpu] = (freqs_index[cpu] == ps_nothing) ? 0LLU : index_to_khz(freqs_index[cpu]);
     }
-    return EAR_SUCCESS;
+    return sysfs_cache_write(&smf_cache, set_list);
 }
 
 static state_t static_get_governor(int cpu, uint *governor)
@@ -302,6 +339,7 @@ state_t mgt_intel_pstate_governor_set(uint governor)
     // Restoring max frequency
     sprintf(buffer_freq, "%llu", freq_max0);
     debug("CPU-1: restoring to %s KHz and setting governor '%s'", buffer_freq, buffer_govr);
+    sysfs_cache_invalidate(&smf_cache);
     if (!filemagic_word_mwrite(fds_smf, cpu_count, buffer_freq, 1)) {
         // If fails, nothing by now
     }
@@ -314,6 +352,7 @@ static state_t set_governor_single(int cpu, char *governor)
     // Restoring max frequency
     sprintf(buffer, "%llu", freq_max0);
     debug("CPU%d: restoring to %s KHz and setting governor '%s'", cpu, buffer, governor);
+    sysfs_cache_set(&smf_cache, cpu, 0LLU);
     if (!filemagic_word_write(fds_smf[cpu], buffer, strlen(buffer), 1)) {
         // If fails, nothing by now
     }
@@ -0,0 +1,212 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <common/output/debug.h>
+#include <common/sizes.h>
+#include <management/cpufreq/drivers/sysfs_cache.h>
+#include <metrics/common/apis.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Below this number of changed CPUs the writes are done by the caller, the
+// threads creation would cost more than the writes.
+#define PARALLEL_MIN_CPUS 32
+
+typedef struct worker_s {
+    sysfs_cache_t *c;
+    ullong *values;
+    uint first;
+    uint last;
+    uint errors;
+    int error_cpu;
+} worker_t;
+
+state_t sysfs_cache_init(sysfs_cache_t *c, topology_t *tp, int *fds)
+{
+    uint *counts;
+    uint cpu, s;
+
+    memset(c, 0, sizeof(sysfs_cache_t));
+    c->fds          = fds;
+    c->cpu_count    = tp->cpu_count;
+    c->socket_count = (tp->socket_count > 0) ? tp->socket_count : 1;
+    c->values       = calloc(c->cpu_count, sizeof(ullong));
+    c->pending      = calloc(c->cpu_count, sizeof(uint));
+    c->sockets      = calloc(c->cpu_count, sizeof(uint));
+    c->offsets      = calloc(c->socket_count + 1, sizeof(uint));
+    counts          = calloc(c->socket_count, sizeof(uint));
+    if (!c->values || !c->pending || !c->sockets || !c->offsets || !counts) {
+        free(counts);
+        free(c->values);
+        free(c->pending);
+        free(c->sockets);
+        free(c->offsets);
+        memset(c, 0, sizeof(sysfs_cache_t));
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    for (cpu = 0; cpu < c->cpu_count; ++cpu) {
+        s = (uint) tp->cpus[cpu].socket_idx;
+        if (s >= c->socket_count) {
+            s = 0;
+        }
+        c->sockets[cpu] = s;
+        counts[s]++;
+    }
+    for (s = 0; s < c->socket_count; ++s) {
+        c->offsets[s + 1] = c->offsets[s] + counts[s];
+    }
+    free(counts);
+    pthread_mutex_init(&c->lock, NULL);
+    return EAR_SUCCESS;
+}
+
+void sysfs_cache_dispose(sysfs_cache_t *c)
+{
+    if (c->values == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    free(c->values);
+    free(c->pending);
+    free(c->offsets);
+    free(c->sockets);
+    c->values  = NULL;
+    c->pending = NULL;
+    c->offsets = NULL;
+    c->sockets = NULL;
+    pthread_mutex_unlock(&c->lock);
+    pthread_mutex_destroy(&c->lock);
+}
+
+void sysfs_cache_invalidate(sysfs_cache_t *c)
+{
+    if (c->values == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    memset(c->values, 0, c->cpu_count * sizeof(ullong));
+    pthread_mutex_unlock(&c->lock);
+}
+
+void sysfs_cache_set(sysfs_cache_t *c, int cpu, ullong value)
+{
+    uint i;
+
+    if (c->values == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (cpu == all_cpus) {
+        for (i = 0; i < c->cpu_count; ++i) {
+            c->values[i] = value;
+        }
+    } else if (cpu >= 0 && cpu < c->cpu_count) {
+        c->values[cpu] = value;
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Writes the pending CPUs from first to last. The errors are counted per
+// worker, state_msg is not used because it is shared between threads.
+static void *worker_write(void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    char data[SZ_NAME_SHORT];
+    uint i, cpu;
+    int len;
+
+    for (i = w->first; i < w->last; ++i) {
+        cpu = w->c->pending[i];
+        len = snprintf(data, sizeof(data), "%llu\n", w->values[cpu]);
+        if (pwrite(w->c->fds[cpu], data, len, 0) == len) {
+            w->c->values[cpu] = w->values[cpu];
+        } else {
+            w->c->values[cpu] = 0LLU;
+            if (w->errors++ == 0) {
+                w->error_cpu = (int) cpu;
+            }
+        }
+    }
+    return NULL;
+}
+
+state_t sysfs_cache_write(sysfs_cache_t *c, ullong *values)
+{
+    worker_t workers[c->socket_count];
+    pthread_t threads[c->socket_count];
+    int created[c->socket_count];
+    uint fill[c->socket_count];
+    uint changed = 0;
+    uint errors  = 0;
+    int error_cpu = -1;
+    uint cpu, s;
+
+    if (c->values == NULL) {
+        return_msg(EAR_ERROR, Generr.api_uninitialized);
+    }
+    // The pending list and the values are shared, a write is done at a time
+    pthread_mutex_lock(&c->lock);
+    // Grouping the changed CPUs by socket
+    memcpy(fill, c->offsets, c->socket_count * sizeof(uint));
+    for (cpu = 0; cpu < c->cpu_count; ++cpu) {
+        if (values[cpu] == 0LLU || values[cpu] == c->values[cpu]) {
+            continue;
+        }
+        c->pending[fill[c->sockets[cpu]]++] = cpu;
+        changed++;
+    }
+    debug("%u CPUs changed of %u", changed, c->cpu_count);
+    if (changed == 0) {
+        pthread_mutex_unlock(&c->lock);
+        return EAR_SUCCESS;
+    }
+    for (s = 0; s < c->socket_count; ++s) {
+        workers[s] = (worker_t){.c = c, .values = values, .first = c->offsets[s], .last = fill[s], .error_cpu = -1};
+        created[s] = 0;
+    }
+    if (changed < PARALLEL_MIN_CPUS || c->socket_count == 1) {
+        for (s = 0; s < c->socket_count; ++s) {
+            worker_write(&workers[s]);
+        }
+    } else {
+        // The caller writes the first socket. If a thread can not be created
+        // its socket is also written by the caller.
+        for (s = 1; s < c->socket_count; ++s) {
+            if (workers[s].first < workers[s].last) {
+                created[s] = (pthread_create(&threads[s], NULL, worker_write, &workers[s]) == 0);
+                if (!created[s]) {
+                    worker_write(&workers[s]);
+                }
+            }
+        }
+        worker_write(&workers[0]);
+        for (s = 1; s < c->socket_count; ++s) {
+            if (created[s]) {
+                pthread_join(threads[s], NULL);
+            }
+        }
+    }
+    for (s = 0; s < c->socket_count; ++s) {
+        if (workers[s].errors && error_cpu < 0) {
+            error_cpu = workers[s].error_cpu;
+        }
+        errors += workers[s].errors;
+    }
+    pthread_mutex_unlock(&c->lock);
+    if (errors) {
+        return_print(EAR_ERROR, "%u of %u CPU frequency writes failed (first at CPU%d)", errors, changed, error_cpu);
+    }
+    return EAR_SUCCESS;
+}
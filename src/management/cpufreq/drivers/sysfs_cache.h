@@ -0,0 +1,59 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef MANAGEMENT_DRIVERS_SYSFS_CACHE_H
+#define MANAGEMENT_DRIVERS_SYSFS_CACHE_H
+
+#include <common/hardware/topology.h>
+#include <common/states.h>
+#include <common/types.h>
+#include <pthread.h>
+
+// Cache of the values written in a per CPU set of cpufreq files (one file
+// descriptor per CPU). A list write skips the CPUs whose file already has the
+// requested value, and the rest are written in parallel, one thread per
+// socket, when there are enough of them.
+//
+// The cache only knows what has been written through it. Anything changing
+// these files by other means (a governor switch or a write of the same file
+// by the driver) has to call sysfs_cache_set() or sysfs_cache_invalidate().
+//
+// The calls are serialized by the lock of the cache, so it can be used by
+// several threads. After sysfs_cache_dispose() the cache can be initialized
+// again, and in between the calls do nothing (or return an error).
+
+typedef struct sysfs_cache_s {
+    int *fds;
+    ullong *values; // Last value written per CPU, 0 if unknown
+    uint *pending;  // Changed CPUs grouped by socket
+    uint *offsets;  // Where the CPUs of each socket begin in pending
+    uint *sockets;  // Socket index per CPU
+    uint socket_count;
+    uint cpu_count;
+    pthread_mutex_t lock; // Initialized while values is not NULL
+} sysfs_cache_t;
+
+state_t sysfs_cache_init(sysfs_cache_t *c, topology_t *tp, int *fds);
+
+void sysfs_cache_dispose(sysfs_cache_t *c);
+
+/* Marks all the CPUs as unknown, the next write will write all of them. */
+void sysfs_cache_invalidate(sysfs_cache_t *c);
+
+/* Records a value written by other means. It accepts all_cpus, and a value
+ * 0 invalidates the CPU. */
+void sysfs_cache_set(sysfs_cache_t *c, int cpu, ullong value);
+
+/* Writes values[cpu] in every CPU whose cached value differs. A 0 value
+ * means that CPU is not changed. If some writes fail, the returned error
+ * reports how many and the first one, and those CPUs become unknown. */
+state_t sysfs_cache_write(sysfs_cache_t *c, ullong *values);
+
+#endif // MANAGEMENT_DRIVERS_SYSFS_CACHE_H
@@ -0,0 +1,227 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Runs the HWP P_STATE API over the simulated hardware tree. The CPUFreq driver
+// is replaced by a stub, because the API only uses it for the governors. The
+// journal is checked to be restored only when it is valid, owned by the user
+// and not writable by others, and not to follow links.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <common/config/config_env.h>
+#include <common/hardware/topology.h>
+#include <management/cpufreq/archs/hwp.h>
+#include <metrics/common/apis.h>
+#include <metrics/tests/hw_fake.h>
+
+extern char *program_invocation_short_name;
+
+#define REG_HWP_REQUEST 0x774
+#define JOURNAL_MAGIC   0x45415248
+#define JOURNAL_VERSION 1
+
+// As in hwp.c
+typedef struct journal_s {
+    uint magic;
+    uint version;
+    uint cpu_count;
+    uint reg;
+} journal_t;
+
+static char root[SZ_PATH_SHORT];
+static uint failures;
+
+static state_t stub_init()
+{
+    return EAR_SUCCESS;
+}
+
+static state_t stub_dispose()
+{
+    return EAR_SUCCESS;
+}
+
+static ullong request(uint cpu)
+{
+    char path[SZ_PATH];
+    ullong reg = 0;
+    int fd;
+
+    sprintf(path, "%s/dev/cpu/%u/msr", root, cpu);
+    if ((fd = open(path, O_RDONLY)) >= 0) {
+        if (pread(fd, &reg, sizeof(reg), HW_FAKE_MSR(REG_HWP_REQUEST)) != sizeof(reg)) {
+            reg = 0;
+        }
+        close(fd);
+    }
+    return reg;
+}
+
+// A write of other process
+static void set_request(uint cpu, ullong reg)
+{
+    char path[SZ_PATH];
+    int fd;
+
+    sprintf(path, "%s/dev/cpu/%u/msr", root, cpu);
+    if ((fd = open(path, O_WRONLY)) >= 0) {
+        if (pwrite(fd, &reg, sizeof(reg), HW_FAKE_MSR(REG_HWP_REQUEST)) != sizeof(reg)) {
+            printf("error writing the request of CPU%u\n", cpu);
+        }
+        close(fd);
+    }
+}
+
+// A journal left by a dead owner, with the same value for all the CPUs
+static void journal_write(char *path, uint cpus, ullong reg, mode_t mode)
+{
+    journal_t j = {.magic = JOURNAL_MAGIC, .version = JOURNAL_VERSION, .cpu_count = cpus, .reg = REG_HWP_REQUEST};
+    uint cpu;
+    int fd;
+
+    unlink(path);
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600)) < 0) {
+        return;
+    }
+    if (write(fd, &j, sizeof(j)) != sizeof(j)) {
+        printf("error writing %s\n", path);
+    }
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        if (write(fd, &reg, sizeof(reg)) != sizeof(reg)) {
+            printf("error writing %s\n", path);
+        }
+    }
+    fchmod(fd, mode);
+    close(fd);
+}
+
+static void check(int cond, char *what)
+{
+    printf("%-48s %s\n", what, (cond) ? "ok" : "FAILED");
+    failures += !cond;
+}
+
+int main(int argc, char *argv[])
+{
+    mgt_ps_driver_ops_t driver = {.init = stub_init, .dispose = stub_dispose};
+    mgt_ps_ops_t ops;
+    char journal[SZ_PATH];
+    char target[SZ_PATH];
+    ullong saved;
+    pstate_t *current;
+    pstate_t *available;
+    ullong original;
+    uint *list, *list_max;
+    uint count, nominal, idx;
+    topology_t tp;
+    uint cpu;
+    int fd;
+
+    memset(&ops, 0, sizeof(ops));
+    sprintf(root, "/tmp/ear_hw_fake.%d", getpid());
+    if (state_fail(hw_fake_create(root, 8, 2, 1))) {
+        printf("hw_fake_create failed: %s\n", state_msg);
+        return 1;
+    }
+    setenv(FLAG_HW_ROOT, root, 1);
+    setenv(ENV_PATH_TMP, root, 1);
+    setenv(FLAG_CPUFREQ_MSR, "1", 1);
+    topology_init(&tp);
+    // The simulated registers are Intel ones
+    tp.vendor = VENDOR_INTEL;
+    original  = request(0);
+
+    check(state_ok(mgt_cpufreq_hwp_load(&tp, &ops, &driver)), "load");
+    check(state_ok(mgt_cpufreq_hwp_init(no_ctx)), "init");
+    sprintf(journal, "%s/.ear_cpufreq_hwp.%s", root, program_invocation_short_name);
+    check(access(journal, F_OK) == 0, "journal created");
+    fd = open(journal, O_RDONLY);
+    check(flock(fd, LOCK_EX | LOCK_NB) != 0, "journal locked by its owner");
+    close(fd);
+
+    mgt_cpufreq_hwp_count_available(no_ctx, &count);
+    mgt_cpufreq_hwp_get_nominal(no_ctx, &nominal);
+    available = calloc(count, sizeof(pstate_t));
+    current   = calloc(tp.cpu_count, sizeof(pstate_t));
+    list      = calloc(tp.cpu_count, sizeof(uint));
+    list_max  = calloc(tp.cpu_count, sizeof(uint));
+    mgt_cpufreq_hwp_get_available_list(no_ctx, available);
+    // Boost, 2.4 GHz down to 0.8 GHz
+    check(count == 18 && nominal == 1, "P_STATE list size");
+    check(available[0].khz == 2401000 && available[1].khz == 2400000 && available[17].khz == 800000,
+          "P_STATE list frequencies");
+    check(state_ok(mgt_cpufreq_hwp_get_index(no_ctx, 1950000, &idx, 1)) && idx == 5, "closest index");
+
+    // Even CPUs at 2.0 GHz, odd CPUs untouched
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        list[cpu] = (cpu % 2) ? ps_nothing : 5;
+    }
+    check(state_ok(mgt_cpufreq_hwp_set_current_list(no_ctx, list)), "set list");
+    check(request(0) == ((0x80LLU << 24) | (20 << 8) | 20), "request pinned to 2.0 GHz (EPP kept)");
+    check(request(1) == original, "untouched CPU");
+    mgt_cpufreq_hwp_get_current_list(no_ctx, current);
+    check(current[0].khz == 2000000 && current[1].idx == 0, "current list");
+
+    // Range from 1.0 to 2.4 GHz with performance EPP
+    for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
+        list[cpu]     = 15;
+        list_max[cpu] = 1;
+    }
+    check(state_ok(mgt_cpufreq_hwp_set_range_list(no_ctx, list, list_max, 0)), "set range");
+    check(request(3) == ((24 << 8) | 10), "request range and EPP");
+    check(state_fail(mgt_cpufreq_hwp_set_range_list(no_ctx, list_max, list, 0)), "inverted range rejected");
+
+    check(state_ok(mgt_cpufreq_hwp_reset(no_ctx)), "reset");
+    check(request(3) == original, "reset restores the original");
+    // The register is changed by other, the cached value is stale
+    set_request(2, (20 << 8) | 20);
+    check(state_ok(mgt_cpufreq_hwp_reset(no_ctx)) && request(2) == original, "reset rewrites a changed register");
+    mgt_cpufreq_hwp_set_current(no_ctx, 17, all_cpus);
+    check(state_ok(mgt_cpufreq_hwp_dispose(no_ctx)), "dispose");
+    check(request(7) == original, "dispose restores the original");
+    check(access(journal, F_OK) != 0, "journal removed");
+
+    // The journal of a dead owner is restored
+    saved = (0x80LLU << 24) | (20 << 8) | 10;
+    journal_write(journal, tp.cpu_count, saved, 0600);
+    mgt_cpufreq_hwp_init(no_ctx);
+    mgt_cpufreq_hwp_dispose(no_ctx);
+    check(request(5) == saved, "journal of a dead owner restored");
+    // Out of the P_STATE range
+    journal_write(journal, tp.cpu_count, (0xFFLLU << 8) | 10, 0600);
+    mgt_cpufreq_hwp_init(no_ctx);
+    mgt_cpufreq_hwp_dispose(no_ctx);
+    check(request(5) == saved, "journal with invalid values rejected");
+    // Writable by others
+    journal_write(journal, tp.cpu_count, original, 0622);
+    mgt_cpufreq_hwp_init(no_ctx);
+    mgt_cpufreq_hwp_dispose(no_ctx);
+    check(request(5) == saved, "journal writable by others rejected");
+    check(access(journal, F_OK) == 0, "journal of others not removed");
+    unlink(journal);
+    // A link to other file
+    sprintf(target, "%s/target", root);
+    journal_write(target, tp.cpu_count, original, 0600);
+    check(symlink(target, journal) == 0, "journal link created");
+    mgt_cpufreq_hwp_init(no_ctx);
+    mgt_cpufreq_hwp_dispose(no_ctx);
+    check(request(5) == saved, "journal link not followed");
+    check(access(target, F_OK) == 0, "journal link target kept");
+    unlink(journal);
+    unlink(target);
+
+    hw_fake_destroy();
+    return (failures > 0);
+}
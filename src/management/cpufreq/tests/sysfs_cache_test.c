@@ -0,0 +1,286 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Runs the sysfs cache of the CPUFreq drivers over a set of plain files, one
+// per CPU, as the scaling_setspeed ones. The pwrite calls are counted (the
+// test is linked with --wrap=pwrite). It checks that:
+//
+//   - A list is written once, and repeating it writes nothing.
+//   - Only the changed CPUs are written, also with the threads per socket.
+//   - A failed write is reported and its CPU is written again the next time.
+//   - Several threads can write and invalidate the same cache.
+//   - The cache can be disposed and initialized again.
+//
+// And it measures the writes and the time of a sequence of list writes with
+// the cache against writing every CPU, as the drivers did before:
+//
+//     ./sysfs_cache_test [cpus] [sockets] [applies]
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <common/system/time.h>
+#include <management/cpufreq/drivers/sysfs_cache.h>
+#include <metrics/common/apis.h>
+
+#define THREADS 4
+#define KHZ(i)  (1000000LLU + ((ullong) (i) * 100000LLU))
+
+static ulong writes;
+static uint errors;
+
+ssize_t __real_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+ssize_t __wrap_pwrite(int fd, const void *buf, size_t count, off_t offset)
+{
+    __atomic_add_fetch(&writes, 1, __ATOMIC_RELAXED);
+    return __real_pwrite(fd, buf, count, offset);
+}
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+static ullong file_value(int fd)
+{
+    char data[64];
+    ssize_t len;
+
+    if ((len = pread(fd, data, sizeof(data) - 1, 0)) <= 0) {
+        return 0LLU;
+    }
+    data[len] = '\0';
+    return strtoull(data, NULL, 10);
+}
+
+static int files_equal(int *fds, ullong *values, uint cpus)
+{
+    uint cpu;
+
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        if (values[cpu] != 0LLU && file_value(fds[cpu]) != values[cpu]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct thread_s {
+    sysfs_cache_t *c;
+    ullong *list;
+    uint cpus;
+    uint id;
+} thread_t;
+
+// Each thread writes its own lists, the odd ones invalidate the cache too
+static void *thread_main(void *arg)
+{
+    thread_t *t = (thread_t *) arg;
+    uint i, cpu;
+
+    for (i = 0; i < 200; ++i) {
+        for (cpu = 0; cpu < t->cpus; ++cpu) {
+            t->list[cpu] = KHZ((cpu + i + t->id) % 8);
+        }
+        sysfs_cache_write(t->c, t->list);
+        if (t->id % 2) {
+            sysfs_cache_invalidate(t->c);
+        }
+    }
+    return NULL;
+}
+
+// Writing every CPU, as the drivers do without the cache
+static void write_direct(int *fds, ullong *list, uint cpus)
+{
+    char data[64];
+    uint cpu;
+    int len;
+
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        if (list[cpu] != 0LLU) {
+            len = snprintf(data, sizeof(data), "%llu\n", list[cpu]);
+            if (pwrite(fds[cpu], data, len, 0) != len) {
+                errors++;
+            }
+        }
+    }
+}
+
+// A policy applying a frequency per CPU, which raises a different quarter of
+// the CPUs each time. The rest keep the lowest frequency.
+static void apply_list(ullong *list, uint cpus, uint apply)
+{
+    uint cpu;
+
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        list[cpu] = KHZ((cpu % 4 == apply % 4) ? apply % 8 : 0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char root[SZ_PATH_SHORT];
+    char path[SZ_PATH];
+    thread_t threads[THREADS];
+    pthread_t tids[THREADS];
+    ullong *lists[THREADS];
+    ulong direct_writes, cache_writes;
+    ullong direct_ns, cache_ns;
+    timestamp t1, t2;
+    sysfs_cache_t c;
+    topology_t tp;
+    ullong *list;
+    uint cpus    = 256;
+    uint sockets = 2;
+    uint applies = 1000;
+    char msg[256];
+    int *fds;
+    uint cpu, i;
+    state_t s = EAR_SUCCESS;
+
+    if (argc > 1) cpus = (uint) atoi(argv[1]);
+    if (argc > 2) sockets = (uint) atoi(argv[2]);
+    if (argc > 3) applies = (uint) atoi(argv[3]);
+
+    sprintf(root, "/tmp/ear_sysfs_cache.%d", getpid());
+    if (mkdir(root, 0700) != 0) {
+        printf("error: creating %s\n", root);
+        return 1;
+    }
+    memset(&tp, 0, sizeof(topology_t));
+    tp.cpu_count    = cpus;
+    tp.socket_count = sockets;
+    tp.cpus         = calloc(cpus, sizeof(cpu_t));
+    fds             = calloc(cpus, sizeof(int));
+    list            = calloc(cpus, sizeof(ullong));
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        tp.cpus[cpu].id         = cpu;
+        tp.cpus[cpu].socket_idx = cpu / (cpus / sockets);
+        sprintf(path, "%s/%u", root, cpu);
+        fds[cpu] = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+    for (i = 0; i < THREADS; ++i) {
+        lists[i] = calloc(cpus, sizeof(ullong));
+    }
+
+    check(state_ok(sysfs_cache_init(&c, &tp, fds)), "init");
+    // Every CPU the first time, none the second
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        list[cpu] = KHZ(cpu % 8);
+    }
+    writes = 0;
+    check(state_ok(sysfs_cache_write(&c, list)), "first write");
+    snprintf(msg, sizeof(msg), "first write: %lu writes, expected %u", writes, cpus);
+    check(writes == cpus && files_equal(fds, list, cpus), msg);
+    writes = 0;
+    sysfs_cache_write(&c, list);
+    snprintf(msg, sizeof(msg), "same list: %lu writes, expected 0", writes);
+    check(writes == 0, msg);
+    // Half the CPUs changed, over PARALLEL_MIN_CPUS the sockets are threaded
+    for (cpu = 0; cpu < cpus; cpu += 2) {
+        list[cpu] = KHZ(9);
+    }
+    writes = 0;
+    sysfs_cache_write(&c, list);
+    snprintf(msg, sizeof(msg), "half list: %lu writes, expected %u", writes, cpus / 2);
+    check(writes == cpus / 2 && files_equal(fds, list, cpus), msg);
+    // A 0 keeps the CPU
+    memset(list, 0, cpus * sizeof(ullong));
+    list[1] = KHZ(3);
+    writes  = 0;
+    sysfs_cache_write(&c, list);
+    check(writes == 1 && file_value(fds[1]) == KHZ(3), "single CPU list");
+    // A failed write
+    close(fds[1]);
+    fds[1]  = -1;
+    list[1] = KHZ(4);
+    check(state_fail(sysfs_cache_write(&c, list)), "failed write not reported");
+    sprintf(path, "%s/1", root);
+    fds[1] = open(path, O_RDWR, 0600);
+    writes = 0;
+    sysfs_cache_write(&c, list);
+    check(writes == 1 && file_value(fds[1]) == KHZ(4), "failed CPU not written again");
+    // Invalidation, everything is written again
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        list[cpu] = KHZ(cpu % 8);
+    }
+    sysfs_cache_write(&c, list);
+    sysfs_cache_invalidate(&c);
+    writes = 0;
+    sysfs_cache_write(&c, list);
+    check(writes == cpus, "invalidate");
+
+    // Threads sharing the cache, the cached values have to match the files
+    for (i = 0; i < THREADS; ++i) {
+        threads[i] = (thread_t){.c = &c, .list = lists[i], .cpus = cpus, .id = i};
+        pthread_create(&tids[i], NULL, thread_main, &threads[i]);
+    }
+    for (i = 0; i < THREADS; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    check(files_equal(fds, c.values, cpus), "threads: the cached values are not the written ones");
+
+    // Dispose and initialize again
+    sysfs_cache_dispose(&c);
+    sysfs_cache_dispose(&c);
+    sysfs_cache_invalidate(&c);
+    sysfs_cache_set(&c, all_cpus, KHZ(1));
+    check(state_fail(sysfs_cache_write(&c, list)), "write after dispose");
+    check(state_ok(sysfs_cache_init(&c, &tp, fds)), "init after dispose");
+    writes = 0;
+    sysfs_cache_write(&c, list);
+    check(writes == cpus && files_equal(fds, list, cpus), "first write after init");
+
+    // Measurement
+    writes = 0;
+    timestamp_getprecise(&t1);
+    for (i = 0; i < applies; ++i) {
+        apply_list(list, cpus, i);
+        write_direct(fds, list, cpus);
+    }
+    timestamp_getprecise(&t2);
+    direct_ns     = timestamp_diff(&t2, &t1, TIME_NSECS);
+    direct_writes = writes;
+    sysfs_cache_invalidate(&c);
+    writes = 0;
+    timestamp_getprecise(&t1);
+    for (i = 0; i < applies; ++i) {
+        apply_list(list, cpus, i);
+        s = sysfs_cache_write(&c, list);
+    }
+    timestamp_getprecise(&t2);
+    cache_ns     = timestamp_diff(&t2, &t1, TIME_NSECS);
+    cache_writes = writes;
+    check(state_ok(s) && files_equal(fds, list, cpus), "measurement: files");
+    check(cache_writes < direct_writes, "measurement: the cache does not save writes");
+    printf("%u CPUs, %u sockets, %u applies raising a quarter of the CPUs\n", cpus, sockets, applies);
+    printf("%-8s %12s %14s\n", "", "writes", "us/apply");
+    printf("%-8s %12lu %14.2lf\n", "direct", direct_writes, (double) direct_ns / (applies * 1000.0));
+    printf("%-8s %12lu %14.2lf\n", "cache", cache_writes, (double) cache_ns / (applies * 1000.0));
+
+    sysfs_cache_dispose(&c);
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        close(fds[cpu]);
+        sprintf(path, "%s/%u", root, cpu);
+        unlink(path);
+    }
+    rmdir(root);
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}
@@ -9,6 +9,7 @@
  **************************************************************************/
 
 #include <limits.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +40,12 @@ static uint8_t pm_connected_status  = 0;
 static char my_buffer[1024];
 static uint num_packs    = 0;
 static uint num_counters = 0;
+// RAPL data for the node energy cache extrapolation
+static pthread_mutex_t aux_lock = PTHREAD_MUTEX_INITIALIZER;
+static ullong *aux_curr;
+static ullong *aux_prev;
+static ullong *aux_diff;
+static ullong aux_energy_nj;
 
 // GPU
 #if USE_GPUS
@@ -91,6 +98,41 @@ static int pm_node_dc_energy(ehandler_t *my_eh, node_data_t *dc)
     }
 }
 
+/** Accumulated CPU and DRAM energy, used by the node energy cache to
+ * extrapolate the node energy between BMC updates. */
+static state_t pm_read_aux(ullong *energy_mj)
+{
+    state_t s;
+    int i;
+
+    pthread_mutex_lock(&aux_lock);
+    if (state_ok(s = energy_cpu_read(NULL, aux_curr))) {
+        energy_cpu_data_diff(NULL, aux_prev, aux_curr, aux_diff);
+        for (i = 0; i < num_packs * NUM_PACKS; ++i) {
+            aux_energy_nj += aux_diff[i];
+        }
+        energy_cpu_data_copy(NULL, aux_prev, aux_curr);
+        *energy_mj = aux_energy_nj / 1000000LLU;
+    }
+    pthread_mutex_unlock(&aux_lock);
+    return s;
+}
+
+static void pm_connect_aux()
+{
+    if (!energy_cache_is_enabled() || aux_curr != NULL) {
+        return;
+    }
+    if (state_fail(energy_cpu_data_alloc(NULL, &aux_curr, NULL)) ||
+        state_fail(energy_cpu_data_alloc(NULL, &aux_prev, NULL)) ||
+        state_fail(energy_cpu_data_alloc(NULL, &aux_diff, NULL))) {
+        return;
+    }
+    if (state_ok(energy_cpu_read(NULL, aux_prev))) {
+        energy_cache_set_aux(pm_read_aux);
+    }
+}
+
 static int pm_connect(ehandler_t *my_eh, topology_t *tp)
 {
     int status_enode;
@@ -155,6 +197,7 @@ static int pm_connect(ehandler_t *my_eh, topology_t *tp)
     }
 
     debug("%d packages detected in power metrics ", num_packs);
+    pm_connect_aux();
 #if USE_GPUS
     int gpu_error = 0;
 
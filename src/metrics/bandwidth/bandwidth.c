@@ -25,6 +25,7 @@
 #include <metrics/bandwidth/archs/perf.h>
 #include <metrics/bandwidth/bandwidth.h>
 #include <metrics/common/apis.h>
+#include <metrics/common/kernels.h>
 #include <pthread.h>
 #include <stdlib.h>
 
@@ -60,6 +61,7 @@ dummy:
     // Bandiwdth wants to know more about the loaded API. This is safe because at
     // this point all API's have their devices counter.
     bwidth_get_info(&api);
+    kernels_init(tp);
     // Saving some additional data
     overhead_suscribe("metrics/bandwidth", &oid);
     line_size = (double) tp->cache_line_size;
@@ -142,6 +144,7 @@ void bwidth_data_diff(bwidth_t *b2, bwidth_t *b1, bwidth_t *bD, ullong *cas, dou
 {
     ullong tcas = 0LLU; // Total CAS
     ullong diff = 0LLU;
+    ullong *diffs;
     ullong time = 0LLU;
     double tgbs = 0.0; // Total GB/s
     double secs = 0.0;
@@ -175,13 +178,33 @@ void bwidth_data_diff(bwidth_t *b2, bwidth_t *b1, bwidth_t *bD, ullong *cas, dou
     // - LIKWID: doubt.
     // Meanwhile this API is not fully updated to get the registers width, we
     // will convert to 0 the result if the values of b1 are greater than b2.
-    for (i = 0; i < api.devs_count - 1; ++i) {
-        diff = overflow_zeros_u64(b2[i].cas, b1[i].cas);
-        tcas += diff;
-        if (bD != NULL) {
-            bD[i].cas = diff;
+    if (kernels_type() == KERNELS_SCALAR) {
+        // One pass is faster than the scalar kernels
+        for (i = 0; i < api.devs_count - 1; ++i) {
+            diff = overflow_zeros_u64(b2[i].cas, b1[i].cas);
+            tcas += diff;
+            if (bD != NULL) {
+                bD[i].cas = diff;
+            }
+            debug("DEV%02d/%u: %014llu - %014llu = %llu", i, api.devs_count - 2, b2[i].cas, b1[i].cas, diff);
+        }
+    } else if ((diffs = kernels_buffer(0, api.devs_count - 1)) != NULL) {
+        if (kernels_diff(diffs, &b2[0].cas, &b1[0].cas, api.devs_count - 1, kernels_stride64(bwidth_t), 64)) {
+            for (i = 0; i < api.devs_count - 1; ++i) {
+                diffs[i] = overflow_zeros_u64(b2[i].cas, b1[i].cas);
+            }
+        }
+        tcas = kernels_sum(diffs, NULL, api.devs_count - 1, NULL);
+        for (i = 0; bD != NULL && i < api.devs_count - 1; ++i) {
+            bD[i].cas = diffs[i];
         }
-        debug("DEV%02d/%u: %014llu - %014llu = %llu", i, api.devs_count - 2, b2[i].cas, b1[i].cas, diff);
+#if SHOW_DEBUGS
+        for (i = 0; i < api.devs_count - 1; ++i) {
+            debug("DEV%02d/%u: %014llu - %014llu = %llu", i, api.devs_count - 2, b2[i].cas, b1[i].cas, diffs[i]);
+        }
+#endif
+    } else {
+        return;
     }
     tgbs = bwidth_help_castogbs(tcas, secs);
     debug("CAS: %llu in %0.4lf secs", tcas, secs);
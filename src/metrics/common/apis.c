@@ -81,6 +81,8 @@ static char *_apis_tostr(uint api)
         return "GRACE_CPU";
     else if (api == API_HWMON)
         return "HWMON";
+    else if (api == API_HWP)
+        return "HWP";
     else if (api == API_PVC_HWMON)
         return "PVC_HWMON";
 
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <common/sizes.h>
+#include <common/hardware/hwroot.h>
 #include <common/output/debug.h>
 #include <metrics/common/file.h>
 #include <metrics/common/hwmon.h>
@@ -209,7 +210,7 @@ state_t hwmon_open(char *chip_name, char *dev_type, char *label, hwmon_t *chips[
     *chips       = NULL;
     *chips_count = 0;
     do {
-        sprintf(folder_path, "/sys/class/hwmon/hwmon%d", i);
+        sprintf(folder_path, "%s/sys/class/hwmon/hwmon%d", hwroot_get(), i);
         // debug("HWMON testing chip %s", folder_path);
         //  If folder does not exists, there are no more hwmon folders
         if (!test_chip_folder(folder_path)) {
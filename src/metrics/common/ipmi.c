@@ -19,6 +19,16 @@ static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 
 #define TEST_PWR_READING 0
 
+// Only the test builds define IPMI_FAKE=1 (see metrics/energy/Makefile.test)
+#ifndef IPMI_FAKE
+#define IPMI_FAKE 0
+#endif
+
+#if IPMI_FAKE
+#include <metrics/common/ipmi_fake.h>
+static int fake;
+#endif
+
 state_t ipmi_open()
 {
     state_t s;
@@ -27,6 +37,13 @@ state_t ipmi_open()
 	if (getenv("EAR_ROOT_MODE") != NULL) s = EAR_SUCCESS;
 	if (getenv("EAR_USER_MODE") != NULL) s = EAR_ERROR;
 	#else
+    #if IPMI_FAKE
+    if ((fake = ipmi_fake_is_enabled())) {
+        s = ipmi_fake_open();
+        pthread_mutex_unlock(&lock);
+        return s;
+    }
+    #endif
     s = ipmi_driver_open();
 	#endif
     pthread_mutex_unlock(&lock);
@@ -38,6 +55,12 @@ void ipmi_close()
     while (pthread_mutex_trylock(&lock));
 	#if TEST_PWR_READING
 	#else
+    #if IPMI_FAKE
+    if (fake) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    #endif
     ipmi_driver_close();
 	#endif
     pthread_mutex_unlock(&lock);
@@ -48,6 +71,9 @@ int ipmi_devs_count()
 	#if TEST_PWR_READING
 	return 1;
 	#else
+    #if IPMI_FAKE
+    if (fake) return ipmi_fake_devs_count();
+    #endif
     return ipmi_driver_devs_count();
 	#endif
 }
@@ -57,6 +83,9 @@ int ipmi_has_hardware(char *string)
 	#if TEST_PWR_READING
 	return 1;
 	#else
+    #if IPMI_FAKE
+    if (fake) return ipmi_fake_has_hardware(string);
+    #endif
     return ipmi_driver_has_hardware(string);
 	#endif
 }
@@ -79,6 +108,9 @@ int ipmi_sensors_find(char *string, ipmi_sensor_t **sensors, uint *sensors_count
 	}
 	return 1;
 	#else
+    #if IPMI_FAKE
+    if (fake) return 0;
+    #endif
     return ipmi_driver_sensors_find(string, sensors, sensors_count);
 	#endif
 }
@@ -136,6 +168,13 @@ state_t ipmi_cmd_send(int dev_no, ipmi_cmd_t *pkg)
 	#if TEST_PWR_READING
 	s = EAR_SUCCESS;
 	#else
+    #if IPMI_FAKE
+    if (fake) {
+        s = ipmi_fake_cmd_send(dev_no, pkg);
+        pthread_mutex_unlock(&lock);
+        return s;
+    }
+    #endif
     s = ipmi_driver_cmd_send(dev_no, pkg);
 	#endif
     pthread_mutex_unlock(&lock);
@@ -0,0 +1,143 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <common/config.h>
+#include <common/system/time.h>
+#include <common/output/debug.h>
+#include <common/string_enhanced.h>
+#include <metrics/common/ipmi_fake.h>
+
+#define FAKE_POWER_DEF   300 // W
+#define FAKE_REFRESH_DEF 200 // ms
+#define FAKE_LATENCY_DEF 20  // ms
+
+static timestamp_t fake_start;
+static ulong       fake_power   = FAKE_POWER_DEF;
+static ulong       fake_refresh = FAKE_REFRESH_DEF;
+static ulong       fake_latency = FAKE_LATENCY_DEF;
+static int         fake_opened;
+
+int ipmi_fake_is_enabled()
+{
+    return (getenv(FLAG_IPMI_FAKE) != NULL);
+}
+
+state_t ipmi_fake_open()
+{
+    char *conf;
+
+    if (fake_opened) {
+        return EAR_SUCCESS;
+    }
+    if ((conf = getenv(FLAG_IPMI_FAKE)) != NULL) {
+        sscanf(conf, "%lu:%lu:%lu", &fake_power, &fake_refresh, &fake_latency);
+    }
+    if (fake_refresh == 0) {
+        fake_refresh = 1;
+    }
+    timestamp_get(&fake_start);
+    fake_opened = 1;
+    debug("fake BMC: %lu W, refresh %lu ms, latency %lu ms", fake_power, fake_refresh, fake_latency);
+    return EAR_SUCCESS;
+}
+
+int ipmi_fake_devs_count()
+{
+    return fake_opened;
+}
+
+int ipmi_fake_has_hardware(char *board_name)
+{
+    char buffer[256] = {0};
+
+    strncpy(buffer, board_name, 255);
+    strtolow(buffer);
+    return (strstr("sd650 thinksystem", buffer) != NULL);
+}
+
+// Returns the time of the last BMC refresh, in ms since the start
+static ullong fake_refresh_time()
+{
+    ullong elapsed = timestamp_diffnow(&fake_start, TIME_MSECS);
+    return (elapsed / fake_refresh) * fake_refresh;
+}
+
+static void fake_put16(uchar *data, ushort value)
+{
+    memcpy(data, &value, sizeof(ushort));
+}
+
+static void fake_put32(uchar *data, uint value)
+{
+    memcpy(data, &value, sizeof(uint));
+}
+
+state_t ipmi_fake_cmd_send(int dev_no, ipmi_cmd_t *pkg)
+{
+    uchar netfn = pkg->msg_send.netfn;
+    uchar cmd   = pkg->msg_send.cmd;
+    uchar *data = pkg->msg_recv_data;
+    ullong time_ms;
+    ullong energy_mj;
+
+    if (!fake_opened || dev_no != 0) {
+        return_msg(EAR_ERROR, "No IPMI devices found.");
+    }
+    if (fake_latency > 0) {
+        usleep(fake_latency * 1000LU);
+    }
+    time_ms   = fake_refresh_time();
+    energy_mj = time_ms * fake_power;
+    // Completion code OK by default
+    memset(data, 0, sizeof(pkg->msg_recv_data));
+    pkg->msg_recv_data_len = 20;
+
+    if (netfn == 0x06 && cmd == 0x01) {
+        // Get Device ID
+        pkg->msg_recv_data_len = 16;
+    } else if (netfn == 0x3a && cmd == 0x32 && pkg->msg_send_data[1] == 0x02) {
+        // Lenovo SD650 energy: J (4 bytes), mJ (2), s (4), ms (2)
+        fake_put32(&data[3], (uint) (energy_mj / 1000LLU));
+        fake_put16(&data[7], (ushort) (energy_mj % 1000LLU));
+        fake_put32(&data[9], (uint) (time_ms / 1000LLU));
+        fake_put16(&data[13], (ushort) (time_ms % 1000LLU));
+    } else if (netfn == 0x3a && cmd == 0x32 && pkg->msg_send_data[1] == 0x08) {
+        // Lenovo SD650 power: s (4), ms (2), W (2)
+        fake_put32(&data[1], (uint) (time_ms / 1000LLU));
+        fake_put16(&data[5], (ushort) (time_ms % 1000LLU));
+        fake_put16(&data[7], (ushort) fake_power);
+    } else if (netfn == 0x2c && cmd == 0x02) {
+        // DCMI power reading: cur/min/max/avg W (2 each), s (4), timeframe (4)
+        fake_put16(&data[2], (ushort) fake_power);
+        fake_put16(&data[4], (ushort) fake_power);
+        fake_put16(&data[6], (ushort) fake_power);
+        fake_put16(&data[8], (ushort) fake_power);
+        fake_put32(&data[10], (uint) (time_ms / 1000LLU));
+        fake_put32(&data[14], (uint) fake_refresh);
+    } else if (netfn == 0x2e && cmd == 0xc8) {
+        // Intel Node Manager: cur/min/max/avg W (2 each), s (4), timeframe (4)
+        fake_put16(&data[4], (ushort) fake_power);
+        fake_put16(&data[6], (ushort) fake_power);
+        fake_put16(&data[8], (ushort) fake_power);
+        fake_put16(&data[10], (ushort) fake_power);
+        fake_put32(&data[12], (uint) (time_ms / 1000LLU));
+        fake_put32(&data[16], (uint) fake_refresh);
+    } else {
+        data[0]                = IPMI_INVALID_CMD_COMPLETION_CODE;
+        pkg->msg_recv_data_len = 1;
+    }
+    return EAR_SUCCESS;
+}
@@ -0,0 +1,35 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef METRICS_COMMON_IPMI_FAKE_H
+#define METRICS_COMMON_IPMI_FAKE_H
+
+#include <metrics/common/ipmi.h>
+
+// A simulated BMC, enabled by EAR_IPMI_FAKE=power_w:refresh_ms:latency_ms in
+// the builds of ipmi.c with IPMI_FAKE=1, which are only done by the tests. It
+// answers the raw commands used by the IPMI energy plug-ins (Get Device ID,
+// Lenovo SD650 energy and power, DCMI and Intel Node Manager power readings)
+// with a constant node power. The readings are only refreshed every refresh_ms
+// and every command sleeps latency_ms, like a real BMC does.
+
+#define FLAG_IPMI_FAKE "EAR_IPMI_FAKE"
+
+int ipmi_fake_is_enabled();
+
+state_t ipmi_fake_open();
+
+int ipmi_fake_devs_count();
+
+int ipmi_fake_has_hardware(char *board_name);
+
+state_t ipmi_fake_cmd_send(int dev_no, ipmi_cmd_t *pkg);
+
+#endif // METRICS_COMMON_IPMI_FAKE_H
@@ -0,0 +1,238 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <common/hardware/defines.h>
+#include <common/output/debug.h>
+#include <stdlib.h>
+#include <metrics/common/kernels.h>
+#if __ARCH_X86
+#include <metrics/common/kernels_avx2.h>
+#endif
+#if __ARCH_X86 && FEAT_AVX512
+#include <metrics/common/kernels_avx512.h>
+#endif
+
+static uint scalar_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask)
+{
+    uint overflows = 0;
+    ullong e, s;
+    uint i;
+
+    for (i = 0; i < n; ++i) {
+        e = end[i * stride];
+        s = start[i * stride];
+        overflows += (e < s);
+        dst[i] = (e - s) & mask;
+    }
+    return overflows;
+}
+
+static void scalar_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride)
+{
+    uint i;
+    for (i = 0; i < n; ++i) {
+        dst[i] = ((err2[i * stride] | err1[i * stride]) == 0);
+    }
+}
+
+static ullong scalar_sum(ullong *src, uint *valid, uint n, uint *count)
+{
+    ullong total = 0LLU;
+    uint counter = n;
+    uint i;
+
+    if (valid == NULL) {
+        for (i = 0; i < n; ++i) {
+            total += src[i];
+        }
+    } else {
+        for (i = 0, counter = 0; i < n; ++i) {
+            total += src[i] & (0LLU - (valid[i] != 0));
+            counter += (valid[i] != 0);
+        }
+    }
+    if (count != NULL) {
+        *count = counter;
+    }
+    return total;
+}
+
+static void scalar_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt)
+{
+    double ratio;
+    uint i;
+
+    for (i = 0; i < n; ++i) {
+        dst[i] = 0LU;
+        if ((valid != NULL && !valid[i]) || num[i] == 0LLU || den[i] == 0LLU) {
+            continue;
+        }
+        if (pcnt) {
+            ratio  = (((double) num[i]) * 100.0) / ((double) den[i]);
+            dst[i] = (scale * ((ulong) ratio)) / 100LU;
+        } else {
+            ratio  = ((double) num[i]) / ((double) den[i]);
+            dst[i] = (ulong) (((double) scale) * ratio);
+        }
+    }
+}
+
+static kernels_ops_t ops_scalar = {
+    .diff  = scalar_diff,
+    .valid = scalar_valid,
+    .sum   = scalar_sum,
+    .ratio = scalar_ratio,
+};
+
+#if __ARCH_X86
+static kernels_ops_t ops_avx2 = {
+    .diff  = avx2_kernels_diff,
+    .valid = avx2_kernels_valid,
+    .sum   = avx2_kernels_sum,
+    .ratio = avx2_kernels_ratio,
+};
+#endif
+#if __ARCH_X86 && FEAT_AVX512
+static kernels_ops_t ops_avx512 = {
+    .diff  = avx512_kernels_diff,
+    .valid = avx512_kernels_valid,
+    .sum   = avx512_kernels_sum,
+    .ratio = avx512_kernels_ratio,
+};
+#endif
+
+static kernels_ops_t *ops = &ops_scalar;
+static uint type          = KERNELS_SCALAR;
+
+static __thread ullong *buffers[KERNELS_BUFFERS];
+static __thread uint buffers_len[KERNELS_BUFFERS];
+
+// Tail elements (the ones not filling a full vector) are computed by the scalar
+// kernels. These functions are exported to the vector versions.
+uint kernels_scalar_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask)
+{
+    return scalar_diff(dst, end, start, n, stride, mask);
+}
+
+void kernels_scalar_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride)
+{
+    scalar_valid(dst, err2, err1, n, stride);
+}
+
+ullong kernels_scalar_sum(ullong *src, uint *valid, uint n, uint *count)
+{
+    return scalar_sum(src, valid, n, count);
+}
+
+void kernels_scalar_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt)
+{
+    scalar_ratio(dst, num, den, valid, n, scale, pcnt);
+}
+
+state_t kernels_select(uint new_type)
+{
+    switch (new_type) {
+        case KERNELS_SCALAR:
+            ops = &ops_scalar;
+            break;
+#if __ARCH_X86
+        case KERNELS_AVX2:
+            if (!__builtin_cpu_supports("avx2")) {
+                return_msg(EAR_ERROR, Generr.api_incompatible);
+            }
+            ops = &ops_avx2;
+            break;
+#endif
+#if __ARCH_X86 && FEAT_AVX512
+        case KERNELS_AVX512:
+            if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512dq")) {
+                return_msg(EAR_ERROR, Generr.api_incompatible);
+            }
+            ops = &ops_avx512;
+            break;
+#endif
+        default:
+            return_msg(EAR_ERROR, Generr.api_undefined);
+    }
+    type = new_type;
+    return EAR_SUCCESS;
+}
+
+void kernels_init(topology_t *tp)
+{
+#if __ARCH_X86
+#if FEAT_AVX512
+    if (tp->avx512 && state_ok(kernels_select(KERNELS_AVX512))) {
+        debug("Selected AVX-512 kernels");
+        return;
+    }
+#endif
+    if (state_ok(kernels_select(KERNELS_AVX2))) {
+        debug("Selected AVX2 kernels");
+        return;
+    }
+#endif
+    kernels_select(KERNELS_SCALAR);
+    debug("Selected scalar kernels");
+}
+
+uint kernels_type()
+{
+    return type;
+}
+
+uint kernels_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, uint bits)
+{
+    ullong mask = (bits == 0 || bits >= 64) ? ULLONG_MAX : ((1LLU << bits) - 1LLU);
+    return ops->diff(dst, end, start, n, stride, mask);
+}
+
+void kernels_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride)
+{
+    ops->valid(dst, err2, err1, n, stride);
+}
+
+ullong kernels_sum(ullong *src, uint *valid, uint n, uint *count)
+{
+    return ops->sum(src, valid, n, count);
+}
+
+void kernels_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt)
+{
+    ops->ratio(dst, num, den, valid, n, scale, pcnt);
+}
+
+ulong kernels_average(ulong *src, uint *valid, uint n)
+{
+    ullong total;
+    uint count;
+
+    total = ops->sum((ullong *) src, valid, n, &count);
+    return (count > 0) ? (ulong) (total / count) : 0LU;
+}
+
+void *kernels_buffer(uint id, uint n)
+{
+    ullong *aux;
+
+    if (id >= KERNELS_BUFFERS) {
+        return NULL;
+    }
+    if (buffers_len[id] < n) {
+        if ((aux = realloc(buffers[id], n * sizeof(ullong))) == NULL) {
+            return NULL;
+        }
+        buffers[id]     = aux;
+        buffers_len[id] = n;
+    }
+    return buffers[id];
+}
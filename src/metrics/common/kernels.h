@@ -0,0 +1,79 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef METRICS_COMMON_KERNELS_H
+#define METRICS_COMMON_KERNELS_H
+
+#include <common/hardware/topology.h>
+#include <common/states.h>
+#include <common/types.h>
+
+// Vectorized kernels to compute the differences of per CPU/device counters
+// (APERF/MPERF, IMC, CAS, RAPL...). The input arrays can be arrays of structs,
+// because the elements are read with a stride: the distance between two
+// consecutive elements in 64 bit words (or 32 bit words for the error fields).
+// The output arrays are always contiguous. Validity arrays contain 1 (valid) or
+// 0 (invalid) per element, and NULL means all elements are valid.
+//
+// By default the scalar version is used. Call kernels_init() to select the best
+// implementation for the node (AVX-512, AVX2 or scalar). The scalar kernels
+// take a pass per step, so when kernels_type() is KERNELS_SCALAR the callers
+// keep their fused loops, and the scalar kernels are just the vector tails.
+
+#define KERNELS_SCALAR 0
+#define KERNELS_AVX2   1
+#define KERNELS_AVX512 2
+
+#define KERNELS_BUFFERS 4
+
+// Stride helpers to walk arrays of structs.
+#define kernels_stride64(type) (sizeof(type) / sizeof(ullong))
+#define kernels_stride32(type) (sizeof(type) / sizeof(uint))
+
+typedef struct kernels_ops_s {
+    uint (*diff)(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask);
+    void (*valid)(uint *dst, uint *err2, uint *err1, uint n, uint stride);
+    ullong (*sum)(ullong *src, uint *valid, uint n, uint *count);
+    void (*ratio)(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt);
+} kernels_ops_t;
+
+void kernels_init(topology_t *tp);
+
+// Forces a specific implementation (benchmarks and tests).
+state_t kernels_select(uint type);
+
+uint kernels_type();
+
+// dst[i] = (end[i] - start[i]) & mask. A mask of ~0 (or 0) is a plain 64 bit
+// wrap around. Returns the number of elements in which end is lower than start,
+// in case the caller wants to apply a specific overflow policy.
+uint kernels_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, uint bits);
+
+// dst[i] = 1 if err2[i] and err1[i] are 0.
+void kernels_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride);
+
+// Sums the valid elements and counts them (count can be NULL).
+ullong kernels_sum(ullong *src, uint *valid, uint n, uint *count);
+
+// dst[i] = scale * (num[i] / den[i]). If pcnt, the ratio is truncated to a
+// percentage first (scale * floor(100 * num / den) / 100). It is 0 if not valid
+// or num or den are 0.
+void kernels_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt);
+
+// Average of the valid elements (0 if there are no valid elements).
+ulong kernels_average(ulong *src, uint *valid, uint n);
+
+// Returns a per thread scratch buffer of at least n 64 bit elements, to be used
+// as intermediate arrays by the diff functions. There are KERNELS_BUFFERS
+// buffers (id), and its content is not preserved between diff functions.
+// Returns NULL if id is out of range or it can not be allocated.
+void *kernels_buffer(uint id, uint n);
+
+#endif // METRICS_COMMON_KERNELS_H
@@ -0,0 +1,187 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <immintrin.h>
+#include <metrics/common/kernels_avx2.h>
+
+// AVX2 has no unsigned 64 bit comparison nor 64 bit integer/double
+// conversions, so these are emulated. The sign bit is flipped to compare as
+// signed, and the conversions use the magic number (2^52 and 2^84) method.
+#define SIGN_BIT  0x8000000000000000LL
+#define MAGIC_52  0x4330000000000000LL
+#define MAGIC_84  0x4530000000000000LL
+#define MAGIC_D52 4503599627370496.0 // 2^52
+
+static inline __m256i load_u64(ullong *p, uint stride, __m256i vindex)
+{
+    if (stride == 1) {
+        return _mm256_loadu_si256((__m256i *) p);
+    }
+    return _mm256_i64gather_epi64((long long const *) p, vindex, 8);
+}
+
+// Correctly rounded conversion of unsigned 64 bit integers to double.
+static inline __m256d u64_to_pd(__m256i x)
+{
+    __m256i xh = _mm256_or_si256(_mm256_srli_epi64(x, 32), _mm256_set1_epi64x(MAGIC_84));
+    __m256i xl = _mm256_blend_epi32(_mm256_set1_epi64x(MAGIC_52), x, 0x55);
+    __m256d fh = _mm256_sub_pd(_mm256_castsi256_pd(xh), _mm256_set1_pd(19342813118337666422669312.0)); // 2^84 + 2^52
+    return _mm256_add_pd(fh, _mm256_castsi256_pd(xl));
+}
+
+// Conversion of unsigned 64 bit integers lower than 2^52 to double.
+static inline __m256d u52_to_pd(__m256i x)
+{
+    __m256i xm = _mm256_or_si256(x, _mm256_set1_epi64x(MAGIC_52));
+    return _mm256_sub_pd(_mm256_castsi256_pd(xm), _mm256_set1_pd(MAGIC_D52));
+}
+
+// Conversion of integral doubles in [0, 2^52) to unsigned 64 bit integers.
+static inline __m256i pd_to_u64(__m256d x)
+{
+    __m256d m = _mm256_set1_pd(MAGIC_D52);
+    return _mm256_xor_si256(_mm256_castpd_si256(_mm256_add_pd(x, m)), _mm256_castpd_si256(m));
+}
+
+// Truncated division by 100 of integral doubles lower than 2^52. The
+// multiplication by 0.01 can be 1 unit off, so it is corrected.
+static inline __m256d div100_pd(__m256d x)
+{
+    __m256d v100 = _mm256_set1_pd(100.0);
+    __m256d vone = _mm256_set1_pd(1.0);
+    __m256d r    = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(0.01)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256d r100 = _mm256_mul_pd(r, v100);
+    r = _mm256_sub_pd(r, _mm256_and_pd(_mm256_cmp_pd(r100, x, _CMP_GT_OQ), vone));
+    r = _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(_mm256_add_pd(r100, v100), x, _CMP_LE_OQ), vone));
+    return r;
+}
+
+static inline __m256i load_valid(uint *valid)
+{
+    if (valid == NULL) {
+        return _mm256_set1_epi64x(-1LL);
+    }
+    __m256i v = _mm256_cvtepu32_epi64(_mm_loadu_si128((__m128i *) valid));
+    return _mm256_xor_si256(_mm256_cmpeq_epi64(v, _mm256_setzero_si256()), _mm256_set1_epi64x(-1LL));
+}
+
+uint avx2_kernels_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask)
+{
+    __m256i vindex = _mm256_set_epi64x(3LL * stride, 2LL * stride, 1LL * stride, 0LL);
+    __m256i vsign  = _mm256_set1_epi64x(SIGN_BIT);
+    __m256i vmask  = _mm256_set1_epi64x((long long) mask);
+    __m256i ve, vs, vo;
+    uint overflows = 0;
+    uint i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        ve = load_u64(&end[i * stride], stride, vindex);
+        vs = load_u64(&start[i * stride], stride, vindex);
+        vo = _mm256_cmpgt_epi64(_mm256_xor_si256(vs, vsign), _mm256_xor_si256(ve, vsign));
+        overflows += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(vo)));
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_and_si256(_mm256_sub_epi64(ve, vs), vmask));
+    }
+    return overflows + kernels_scalar_diff(&dst[i], &end[i * stride], &start[i * stride], n - i, stride, mask);
+}
+
+void avx2_kernels_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride)
+{
+    __m256i vindex = _mm256_mullo_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(stride));
+    __m256i vone   = _mm256_set1_epi32(1);
+    __m256i vzero  = _mm256_setzero_si256();
+    __m256i v2, v1;
+    uint i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        if (stride == 1) {
+            v2 = _mm256_loadu_si256((__m256i *) &err2[i]);
+            v1 = _mm256_loadu_si256((__m256i *) &err1[i]);
+        } else {
+            v2 = _mm256_i32gather_epi32((int const *) &err2[i * stride], vindex, 4);
+            v1 = _mm256_i32gather_epi32((int const *) &err1[i * stride], vindex, 4);
+        }
+        v2 = _mm256_cmpeq_epi32(_mm256_or_si256(v2, v1), vzero);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_and_si256(v2, vone));
+    }
+    kernels_scalar_valid(&dst[i], &err2[i * stride], &err1[i * stride], n - i, stride);
+}
+
+ullong avx2_kernels_sum(ullong *src, uint *valid, uint n, uint *count)
+{
+    __m256i vtotal = _mm256_setzero_si256();
+    __m256i vcount = _mm256_setzero_si256();
+    __m256i vone   = _mm256_set1_epi64x(1LL);
+    ullong lanes[4];
+    ullong total;
+    uint counter;
+    __m256i vv;
+    uint i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        vv     = load_valid((valid != NULL) ? &valid[i] : NULL);
+        vtotal = _mm256_add_epi64(vtotal, _mm256_and_si256(_mm256_loadu_si256((__m256i *) &src[i]), vv));
+        vcount = _mm256_add_epi64(vcount, _mm256_and_si256(vv, vone));
+    }
+    total = kernels_scalar_sum(&src[i], (valid != NULL) ? &valid[i] : NULL, n - i, &counter);
+    _mm256_storeu_si256((__m256i *) lanes, vtotal);
+    total += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_si256((__m256i *) lanes, vcount);
+    counter += (uint) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    if (count != NULL) {
+        *count = counter;
+    }
+    return total;
+}
+
+void avx2_kernels_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt)
+{
+    __m256d vscale = _mm256_set1_pd((double) scale);
+    __m256d vlimit = _mm256_set1_pd(MAGIC_D52);
+    __m256d v100   = _mm256_set1_pd(100.0);
+    __m256i vzero  = _mm256_setzero_si256();
+    __m256i vhigh  = _mm256_set1_epi64x((long long) 0xFFF0000000000000LL);
+    __m256i vn, vd, vv;
+    __m256d vnd, vdd;
+    __m256d vr;
+    uint i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        vn = _mm256_loadu_si256((__m256i *) &num[i]);
+        vd = _mm256_loadu_si256((__m256i *) &den[i]);
+        vv = load_valid((valid != NULL) ? &valid[i] : NULL);
+        vv = _mm256_andnot_si256(_mm256_cmpeq_epi64(vn, vzero), vv);
+        vv = _mm256_andnot_si256(_mm256_cmpeq_epi64(vd, vzero), vv);
+        // Counter differences are usually lower than 2^52, which are converted faster
+        if (_mm256_testz_si256(_mm256_or_si256(vn, vd), vhigh)) {
+            vnd = u52_to_pd(vn);
+            vdd = u52_to_pd(vd);
+        } else {
+            vnd = u64_to_pd(vn);
+            vdd = u64_to_pd(vd);
+        }
+        if (pcnt) {
+            // scale * trunc(100 * num / den) / 100, exact while lower than 2^52
+            vr = _mm256_div_pd(_mm256_mul_pd(vnd, v100), vdd);
+            vr = _mm256_round_pd(vr, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            vr = div100_pd(_mm256_mul_pd(vscale, vr));
+        } else {
+            vr = _mm256_mul_pd(vscale, _mm256_div_pd(vnd, vdd));
+        }
+        vr = _mm256_round_pd(vr, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        vr = _mm256_and_pd(vr, _mm256_castsi256_pd(vv));
+        // Out of range values (not realistic) are computed by the scalar version
+        if (_mm256_movemask_pd(_mm256_cmp_pd(vr, vlimit, _CMP_GE_OQ))) {
+            kernels_scalar_ratio(&dst[i], &num[i], &den[i], (valid != NULL) ? &valid[i] : NULL, 4, scale, pcnt);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i *) &dst[i], pd_to_u64(vr));
+    }
+    kernels_scalar_ratio(&dst[i], &num[i], &den[i], (valid != NULL) ? &valid[i] : NULL, n - i, scale, pcnt);
+}
@@ -0,0 +1,33 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef METRICS_COMMON_KERNELS_AVX2_H
+#define METRICS_COMMON_KERNELS_AVX2_H
+
+#include <metrics/common/kernels.h>
+
+uint avx2_kernels_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask);
+
+void avx2_kernels_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride);
+
+ullong avx2_kernels_sum(ullong *src, uint *valid, uint n, uint *count);
+
+void avx2_kernels_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt);
+
+// Scalar versions, used for the tail elements.
+uint kernels_scalar_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask);
+
+void kernels_scalar_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride);
+
+ullong kernels_scalar_sum(ullong *src, uint *valid, uint n, uint *count);
+
+void kernels_scalar_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt);
+
+#endif // METRICS_COMMON_KERNELS_AVX2_H
@@ -0,0 +1,136 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <immintrin.h>
+#include <metrics/common/kernels_avx512.h>
+
+static inline __m512i load_u64(ullong *p, uint stride, __m512i vindex)
+{
+    if (stride == 1) {
+        return _mm512_loadu_si512((void *) p);
+    }
+    return _mm512_i64gather_epi64(vindex, (void const *) p, 8);
+}
+
+// Truncated division by 100 of integral doubles lower than 2^52. The
+// multiplication by 0.01 can be 1 unit off, so it is corrected.
+static inline __m512d div100_pd(__m512d x)
+{
+    __m512d v100 = _mm512_set1_pd(100.0);
+    __m512d vone = _mm512_set1_pd(1.0);
+    __m512d r    = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(0.01)), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m512d r100 = _mm512_mul_pd(r, v100);
+    r = _mm512_mask_sub_pd(r, _mm512_cmp_pd_mask(r100, x, _CMP_GT_OQ), r, vone);
+    r = _mm512_mask_add_pd(r, _mm512_cmp_pd_mask(_mm512_add_pd(r100, v100), x, _CMP_LE_OQ), r, vone);
+    return r;
+}
+
+static inline __mmask8 load_valid(uint *valid)
+{
+    if (valid == NULL) {
+        return 0xFF;
+    }
+    return _mm256_cmpneq_epi32_mask(_mm256_loadu_si256((__m256i *) valid), _mm256_setzero_si256());
+}
+
+uint avx512_kernels_diff(ullong *dst, ullong *end, ullong *start, uint n, uint stride, ullong mask)
+{
+    __m512i vindex = _mm512_mullo_epi64(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi64(stride));
+    __m512i vmask  = _mm512_set1_epi64((long long) mask);
+    __m512i ve, vs;
+    uint overflows = 0;
+    uint i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        ve = load_u64(&end[i * stride], stride, vindex);
+        vs = load_u64(&start[i * stride], stride, vindex);
+        overflows += __builtin_popcount(_mm512_cmplt_epu64_mask(ve, vs));
+        _mm512_storeu_si512((void *) &dst[i], _mm512_and_si512(_mm512_sub_epi64(ve, vs), vmask));
+    }
+    return overflows + kernels_scalar_diff(&dst[i], &end[i * stride], &start[i * stride], n - i, stride, mask);
+}
+
+void avx512_kernels_valid(uint *dst, uint *err2, uint *err1, uint n, uint stride)
+{
+    __m512i vindex = _mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+                                        _mm512_set1_epi32(stride));
+    __m512i vone   = _mm512_set1_epi32(1);
+    __m512i v2, v1;
+    __mmask16 m;
+    uint i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        if (stride == 1) {
+            v2 = _mm512_loadu_si512((void *) &err2[i]);
+            v1 = _mm512_loadu_si512((void *) &err1[i]);
+        } else {
+            v2 = _mm512_i32gather_epi32(vindex, (void const *) &err2[i * stride], 4);
+            v1 = _mm512_i32gather_epi32(vindex, (void const *) &err1[i * stride], 4);
+        }
+        m = _mm512_cmpeq_epi32_mask(_mm512_or_si512(v2, v1), _mm512_setzero_si512());
+        _mm512_storeu_si512((void *) &dst[i], _mm512_maskz_mov_epi32(m, vone));
+    }
+    kernels_scalar_valid(&dst[i], &err2[i * stride], &err1[i * stride], n - i, stride);
+}
+
+ullong avx512_kernels_sum(ullong *src, uint *valid, uint n, uint *count)
+{
+    __m512i vtotal = _mm512_setzero_si512();
+    ullong total;
+    uint counter;
+    uint vcount = 0;
+    __mmask8 m;
+    uint i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        m       = load_valid((valid != NULL) ? &valid[i] : NULL);
+        vtotal  = _mm512_add_epi64(vtotal, _mm512_maskz_loadu_epi64(m, (void *) &src[i]));
+        vcount += __builtin_popcount(m);
+    }
+    total = kernels_scalar_sum(&src[i], (valid != NULL) ? &valid[i] : NULL, n - i, &counter);
+    total += (ullong) _mm512_reduce_add_epi64(vtotal);
+    if (count != NULL) {
+        *count = counter + vcount;
+    }
+    return total;
+}
+
+void avx512_kernels_ratio(ulong *dst, ullong *num, ullong *den, uint *valid, uint n, ulong scale, uint pcnt)
+{
+    __m512d vscale = _mm512_set1_pd((double) scale);
+    __m512d vlimit = _mm512_set1_pd(4503599627370496.0); // 2^52
+    __m512d v100   = _mm512_set1_pd(100.0);
+    __m512i vn, vd;
+    __m512d vr;
+    __mmask8 m;
+    uint i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        vn = _mm512_loadu_si512((void *) &num[i]);
+        vd = _mm512_loadu_si512((void *) &den[i]);
+        m  = load_valid((valid != NULL) ? &valid[i] : NULL);
+        m &= _mm512_test_epi64_mask(vn, vn) & _mm512_test_epi64_mask(vd, vd);
+        if (pcnt) {
+            // scale * trunc(100 * num / den) / 100, exact while lower than 2^52
+            vr = _mm512_div_pd(_mm512_mul_pd(_mm512_cvtepu64_pd(vn), v100), _mm512_cvtepu64_pd(vd));
+            vr = _mm512_roundscale_pd(vr, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            vr = div100_pd(_mm512_mul_pd(vscale, vr));
+        } else {
+            vr = _mm512_mul_pd(vscale, _mm512_div_pd(_mm512_cvtepu64_pd(vn), _mm512_cvtepu64_pd(vd)));
+        }
+        vr = _mm512_maskz_mov_pd(m, vr);
+        if (_mm512_cmp_pd_mask(vr, vlimit, _CMP_GE_OQ)) {
+            kernels_scalar_ratio(&dst[i], &num[i], &den[i], (valid != NULL) ? &valid[i] : NULL, 8, scale, pcnt);
+            continue;
+        }
+        _mm512_storeu_si512((void *) &dst[i], _mm512_cvttpd_epu64(vr));
+    }
+    kernels_scalar_ratio(&dst[i], &num[i], &den[i], (valid != NULL) ? &valid[i] : NULL, n - i, scale, pcnt);
+}
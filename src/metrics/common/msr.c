@@ -11,6 +11,7 @@
 
 // #define SHOW_DEBUGS 1
 
+#include <common/hardware/hwroot.h>
 #include <common/output/verbose.h>
 #include <common/sizes.h>
 #include <fcntl.h>
@@ -25,6 +26,19 @@
 
 #define MSR_MAX 4096
 
+// Only the test builds define HW_FAKE=1 (see metrics/tests/Makefile). The
+// simulated MSR files are plain files, which can't overlap the consecutive
+// registers as the driver does, so each one takes 8 bytes there.
+#ifndef HW_FAKE
+#define HW_FAKE 0
+#endif
+
+#if HW_FAKE
+#define msr_offset(offset) (hwroot_is_enabled() ? (offset) * sizeof(ullong) : (offset))
+#else
+#define msr_offset(offset) (offset)
+#endif
+
 static pthread_mutex_t lock_gen = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t lock_cpu[MSR_MAX];
 static int init_lock[MSR_MAX];
@@ -87,11 +101,11 @@ static int static_open_debug(char *file, mode_t mode, char *cmode)
 
 static int static_open(uint cpu, mode_t mode, char *cmode)
 {
-    char file[SZ_PATH_KERNEL];
+    char file[SZ_NAME_LARGE];
     int fd;
-    sprintf(file, "/dev/cpu/%d/msr", cpu);
+    sprintf(file, "%s/dev/cpu/%d/msr", hwroot_get(), cpu);
     if ((fd = static_open_debug(file, mode, cmode)) < 0) {
-        sprintf(file, "/dev/cpu/%d/msr_safe", cpu);
+        sprintf(file, "%s/dev/cpu/%d/msr_safe", hwroot_get(), cpu);
         fd = static_open_debug(file, mode, cmode);
     }
     return fd;
@@ -151,7 +165,7 @@ state_t msr_read(uint cpu, void *buffer, size_t size, off_t offset)
     #ifdef MSR_LOCK
     while (pthread_mutex_trylock(&lock_cpu[cpu]));
     #endif
-    psize = pread(fds_rd[cpu], buffer, size, offset);
+    psize = pread(fds_rd[cpu], buffer, size, msr_offset(offset));
     debug("MSR read in CPU%d (fd %d, address %lx): %lu bytes of %lu expected", cpu, fds_wr[cpu], offset, psize, size);
     if (psize != size) {
         #ifdef MSR_LOCK
@@ -182,7 +196,7 @@ state_t msr_write(uint cpu, const void *buffer, size_t size, off_t offset)
     #ifdef MSR_LOCK
     while (pthread_mutex_trylock(&lock_cpu[cpu]));
     #endif
-    psize = pwrite(fds_wr[cpu], buffer, size, offset);
+    psize = pwrite(fds_wr[cpu], buffer, size, msr_offset(offset));
     debug("MSR written in CPU%d (fd %d, address %lx): %lu bytes of %lu expected", cpu, fds_wr[cpu], offset, psize,
           size);
     if (psize != size) {
@@ -11,6 +11,7 @@
 // #define SHOW_DEBUGS 1
 
 #include <asm/unistd.h>
+#include <common/hardware/hwroot.h>
 #include <common/output/debug.h>
 #include <common/string_enhanced.h>
 #include <common/system/file.h>
@@ -24,6 +25,15 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+// Only the test builds define HW_FAKE=1 (see metrics/tests/Makefile)
+#ifndef HW_FAKE
+#define HW_FAKE 0
+#endif
+
+#if HW_FAKE
+#include <metrics/common/perf_fake.h>
+#endif
+
 // Future TO-DO:
 // - Add a control and static manager for already open events (duplicates are
 //   bad because there are limited counters in each CPU).
@@ -35,6 +45,11 @@ static int test_paranoid()
     static int paranoid_invalid = 0;
     char buffer[32];
 
+#if HW_FAKE
+    if (perf_fake_is_enabled()) {
+        return 1;
+    }
+#endif
     if (!paranoid_checked) {
         // Checking if the paranoid is valid
         if (filemagic_once_read("/proc/sys/kernel/perf_event_paranoid", buffer, sizeof(buffer))) {
@@ -48,6 +63,47 @@ static int test_paranoid()
     return 1;
 }
 
+static int static_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd)
+{
+#if HW_FAKE
+    if (perf_fake_is_enabled()) {
+        return perf_fake_open(attr, pid, cpu, group_fd);
+    }
+#endif
+    return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, 0);
+}
+
+static int static_ioctl(int fd, ulong request, int flags)
+{
+#if HW_FAKE
+    if (perf_fake_is_enabled()) {
+        return perf_fake_ioctl(fd, request, flags);
+    }
+#endif
+    return ioctl(fd, request, flags);
+}
+
+static int static_read(int fd, void *buffer, size_t size)
+{
+#if HW_FAKE
+    if (perf_fake_is_enabled()) {
+        return perf_fake_read(fd, buffer, size);
+    }
+#endif
+    return read(fd, buffer, size);
+}
+
+static void static_close(int fd)
+{
+#if HW_FAKE
+    if (perf_fake_is_enabled()) {
+        perf_fake_close(fd);
+        return;
+    }
+#endif
+    close(fd);
+}
+
 state_t perf_open(perf_t *perf, perf_t *group, pid_t pid, uint type, ulong event)
 {
     return perf_open_cpu(perf, group, pid, type, event, 0, -1);
@@ -88,7 +144,7 @@ state_t perf_open_cpu(perf_t *perf, perf_t *group, pid_t pid, uint type, ulong e
         perf->attr.exclude_hv     = 1;
     }
     perf->attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING | gp_flag;
-    perf->fd               = syscall(__NR_perf_event_open, &perf->attr, pid, cpu, gp_fd, 0);
+    perf->fd               = static_open(&perf->attr, pid, cpu, gp_fd);
     // Used in some cases
     perf->scale = 1.0;
 
@@ -110,7 +166,7 @@ state_t perf_open_cpu(perf_t *perf, perf_t *group, pid_t pid, uint type, ulong e
 state_t perf_close(perf_t *perf)
 {
     if (perf->fd >= 0) {
-        close(perf->fd);
+        static_close(perf->fd);
     }
     memset(perf, 0, sizeof(perf_t));
     return EAR_SUCCESS;
@@ -123,7 +179,7 @@ state_t perf_reset(perf_t *perf)
     if (perf->group != NULL) {
         gp_flag = PERF_IOC_FLAG_GROUP;
     }
-    ret = ioctl(perf->fd, PERF_EVENT_IOC_RESET, gp_flag);
+    ret = static_ioctl(perf->fd, PERF_EVENT_IOC_RESET, gp_flag);
 #ifdef SHOW_DEBUGS
     if (ret == -1) {
         debug("ioctl of fd %d returned %d (no: %d, s: %s)", perf->fd, ret, errno, strerror(errno));
@@ -146,7 +202,7 @@ state_t perf_start(perf_t *perf)
     if (perf->group != NULL) {
         gp_flag = PERF_IOC_FLAG_GROUP;
     }
-    ret = ioctl(perf->fd, PERF_EVENT_IOC_ENABLE, gp_flag);
+    ret = static_ioctl(perf->fd, PERF_EVENT_IOC_ENABLE, gp_flag);
 #ifdef SHOW_DEBUGS
     if (ret == -1) {
         debug("ioctl of fd %d returned %d (no: %d, s: %s)", perf->fd, ret, errno, strerror(errno));
@@ -169,7 +225,7 @@ state_t perf_stop(perf_t *perf)
     if (perf->group != NULL) {
         gp_flag = PERF_IOC_FLAG_GROUP;
     }
-    ret = ioctl(perf->fd, PERF_EVENT_IOC_DISABLE, gp_flag);
+    ret = static_ioctl(perf->fd, PERF_EVENT_IOC_DISABLE, gp_flag);
 #ifdef SHOW_DEBUGS
     if (ret == -1) {
         debug("ioctl of fd %d returned %d (no: %d, s: %s)", perf->fd, ret, errno, strerror(errno));
@@ -203,7 +259,7 @@ state_t perf_read(perf_t *perf, llong *value)
     int i;
 
     memset(&value_s, 0, sizeof(struct read_format_s));
-    ret = read(perf->fd, &value_s, sizeof(struct read_format_s));
+    ret = static_read(perf->fd, &value_s, sizeof(struct read_format_s));
     debug("PERF read val/ret/err: %llu %d %d", value_s.nrval, ret, errno);
     //
     if (ret == -1) {
@@ -381,13 +437,13 @@ static state_t _perf_open_files(perf_t **perfs, char *pmu_name, char *ev_name, u
         return_msg(EAR_ERROR, Generr.input_null);
     }
     // If folder exists
-    sprintf(path, "/sys/bus/event_source/devices/%s", pmu_name);
+    sprintf(path, "%s/sys/bus/event_source/devices/%s", hwroot_get(), pmu_name);
     if ((dir = opendir(path)) == NULL) {
         return_msg(EAR_ERROR, Generr.not_found);
     }
     closedir(dir);
     // Getting cpumask (i.e: 0-79(80) or 0,40(2)
-    sprintf(path, "/sys/bus/event_source/devices/%s/cpumask", pmu_name);
+    sprintf(path, "%s/sys/bus/event_source/devices/%s/cpumask", hwroot_get(), pmu_name);
     // Reading cpumask format file (this field is used to know the number of perfs to open)
     if (state_ok(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
         if ((cpus_count = parse_cpumask(buffer, (uint **) &cpus)) > 0) {
@@ -402,7 +458,7 @@ static state_t _perf_open_files(perf_t **perfs, char *pmu_name, char *ev_name, u
     // If the event is not a number
     if (strncmp(ev_name, "0x", 2) != 0) {
         // Getting event (i.e: 'event=0xff,umask=0x10')
-        sprintf(path, "/sys/bus/event_source/devices/%s/events/%s", pmu_name, ev_name);
+        sprintf(path, "%s/sys/bus/event_source/devices/%s/events/%s", hwroot_get(), pmu_name, ev_name);
         // Reading event file
         debug("%s reading event file", path);
         if (state_fail(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
@@ -411,25 +467,25 @@ static state_t _perf_open_files(perf_t **perfs, char *pmu_name, char *ev_name, u
         event = (ulong) strtol(parse_value(buffer, "event="), NULL, 16);
         umask = (ulong) strtol(parse_value(buffer, "umask="), NULL, 16);
         // Getting event scale (i.e: 'event=0xff,umask=0x10')
-        sprintf(path, "/sys/bus/event_source/devices/%s/events/%s.scale", pmu_name, ev_name);
+        sprintf(path, "%s/sys/bus/event_source/devices/%s/events/%s.scale", hwroot_get(), pmu_name, ev_name);
         // Reading event file
         if (state_ok(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
             scale = atof(buffer);
         }
         // Getting event unit (i.e: 'event=0xff,umask=0x10')
-        sprintf(path, "/sys/bus/event_source/devices/%s/events/%s.unit", pmu_name, ev_name);
+        sprintf(path, "%s/sys/bus/event_source/devices/%s/events/%s.unit", hwroot_get(), pmu_name, ev_name);
         // Reading event file
         if (state_ok(ear_file_read(path, memset(unit, 0, sizeof(unit)), sizeof(unit), 0))) {
             strclean(unit, '\n');
         }
         // Getting event format (i.e: 'config:0-7')
-        sprintf(path, "/sys/bus/event_source/devices/%s/format/event", pmu_name);
+        sprintf(path, "%s/sys/bus/event_source/devices/%s/format/event", hwroot_get(), pmu_name);
         // Reading event format file
         if (state_ok(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
             config = config | parse_config(buffer, event);
         }
         // Getting umask format (i.e: 'config:8-15,32-55')
-        sprintf(path, "/sys/bus/event_source/devices/%s/format/umask", pmu_name);
+        sprintf(path, "%s/sys/bus/event_source/devices/%s/format/umask", hwroot_get(), pmu_name);
         // Reading umask format file
         if (state_ok(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
             config = config | parse_config(buffer, umask);
@@ -438,7 +494,7 @@ static state_t _perf_open_files(perf_t **perfs, char *pmu_name, char *ev_name, u
         config = (ulong) atoull(ev_name);
     }
     // Getting type (i.e: '17')
-    sprintf(path, "/sys/bus/event_source/devices/%s/type", pmu_name);
+    sprintf(path, "%s/sys/bus/event_source/devices/%s/type", hwroot_get(), pmu_name);
     // Reading umask format file
     if (state_ok(ear_file_read(path, memset(buffer, 0, sizeof(buffer)), sizeof(buffer), 0))) {
         type = (uint) atoi(buffer);
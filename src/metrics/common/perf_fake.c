@@ -0,0 +1,250 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// #define SHOW_DEBUGS 1
+
+#include <common/hardware/hwroot.h>
+#include <common/output/debug.h>
+#include <common/system/time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <metrics/common/perf_fake.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GROUP_MAX 8
+
+typedef struct counter_s {
+    uint used;
+    uint enabled;
+    uint group_format;
+    int leader;
+    int members[GROUP_MAX];
+    uint members_count;
+    double rate;     // Events per ns
+    double value;    // Accumulated while enabled
+    ullong time_acc; // Accumulated enabled time (ns)
+    timestamp_t since;
+} counter_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static counter_t *counters;
+static int counters_count;
+
+int perf_fake_is_enabled()
+{
+    return hwroot_is_enabled();
+}
+
+static double static_rate(struct perf_event_attr *attr, int cpu)
+{
+    double rate = 0.05;
+
+    if (attr->type == PERF_TYPE_HARDWARE) {
+        switch (attr->config) {
+            case PERF_COUNT_HW_CPU_CYCLES:
+                rate = 2.4;
+                break;
+            case PERF_COUNT_HW_INSTRUCTIONS:
+                rate = 3.0;
+                break;
+            case PERF_COUNT_HW_REF_CPU_CYCLES:
+                rate = 2.0;
+                break;
+            case PERF_COUNT_HW_BRANCH_INSTRUCTIONS:
+                rate = 0.5;
+                break;
+            case PERF_COUNT_HW_CACHE_REFERENCES:
+                rate = 0.05;
+                break;
+            default:
+                rate = 0.01;
+        }
+    } else if (attr->type == PERF_TYPE_HW_CACHE) {
+        rate = 0.02;
+    } else if (attr->type == PERF_TYPE_RAW) {
+        rate = 0.3;
+    }
+    // Up to 10% of variation between CPUs and events
+    return rate * (0.95 + (double) ((cpu * 7 + attr->config * 13) % 11) / 100.0);
+}
+
+static double static_value(counter_t *c, ullong *time)
+{
+    ullong elapsed = 0LLU;
+    timestamp_t now;
+
+    if (c->enabled) {
+        timestamp_getprecise(&now);
+        elapsed = timestamp_diff(&now, &c->since, TIME_NSECS);
+    }
+    if (time != NULL) {
+        *time = c->time_acc + elapsed;
+    }
+    return c->value + (c->rate * (double) elapsed);
+}
+
+static counter_t *static_get(int fd)
+{
+    if (fd < 0 || fd >= counters_count || !counters[fd].used) {
+        return NULL;
+    }
+    return &counters[fd];
+}
+
+int perf_fake_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd)
+{
+    counter_t *leader = NULL;
+    counter_t *aux;
+    int fd;
+
+    pthread_mutex_lock(&lock);
+    if (group_fd >= 0 && ((leader = static_get(group_fd)) == NULL || leader->members_count >= GROUP_MAX)) {
+        pthread_mutex_unlock(&lock);
+        errno = EINVAL;
+        return -1;
+    }
+    if ((fd = open("/dev/null", O_RDONLY)) < 0) {
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+    if (fd >= counters_count) {
+        if ((aux = realloc(counters, (fd + 1) * sizeof(counter_t))) == NULL) {
+            pthread_mutex_unlock(&lock);
+            close(fd);
+            errno = ENOMEM;
+            return -1;
+        }
+        memset(&aux[counters_count], 0, (fd + 1 - counters_count) * sizeof(counter_t));
+        counters       = aux;
+        counters_count = fd + 1;
+    }
+    memset(&counters[fd], 0, sizeof(counter_t));
+    counters[fd].used         = 1;
+    counters[fd].enabled      = !attr->disabled;
+    counters[fd].rate         = static_rate(attr, cpu);
+    counters[fd].group_format = (attr->read_format & PERF_FORMAT_GROUP) != 0;
+    counters[fd].leader       = (group_fd >= 0) ? group_fd : fd;
+    timestamp_getprecise(&counters[fd].since);
+    // The leader is also the first member of its group
+    leader = (group_fd >= 0) ? &counters[group_fd] : &counters[fd];
+    leader->members[leader->members_count++] = fd;
+    debug("opened fake counter fd %d (type %u, config 0x%llx, cpu %d, rate %0.2lf)", fd, attr->type, attr->config,
+          cpu, counters[fd].rate);
+    pthread_mutex_unlock(&lock);
+    return fd;
+}
+
+static void static_enable(counter_t *c, uint enable)
+{
+    if (enable && !c->enabled) {
+        timestamp_getprecise(&c->since);
+    }
+    if (!enable && c->enabled) {
+        c->value = static_value(c, &c->time_acc);
+    }
+    c->enabled = enable;
+}
+
+static void static_reset(counter_t *c)
+{
+    c->value    = 0.0;
+    c->time_acc = 0LLU;
+    timestamp_getprecise(&c->since);
+}
+
+static void static_ioctl(counter_t *c, ulong request)
+{
+    if (request == PERF_EVENT_IOC_ENABLE) {
+        static_enable(c, 1);
+    } else if (request == PERF_EVENT_IOC_DISABLE) {
+        static_enable(c, 0);
+    } else if (request == PERF_EVENT_IOC_RESET) {
+        static_reset(c);
+    }
+}
+
+int perf_fake_ioctl(int fd, ulong request, int flags)
+{
+    counter_t *c;
+    uint i;
+
+    pthread_mutex_lock(&lock);
+    if ((c = static_get(fd)) == NULL) {
+        pthread_mutex_unlock(&lock);
+        errno = EBADF;
+        return -1;
+    }
+    if (flags & PERF_IOC_FLAG_GROUP) {
+        c = &counters[c->leader];
+        for (i = 0; i < c->members_count; ++i) {
+            static_ioctl(&counters[c->members[i]], request);
+        }
+    } else {
+        static_ioctl(c, request);
+    }
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int perf_fake_read(int fd, void *buffer, size_t size)
+{
+    ullong *values = (ullong *) buffer;
+    ullong time    = 0LLU;
+    counter_t *c;
+    uint i;
+
+    pthread_mutex_lock(&lock);
+    if ((c = static_get(fd)) == NULL) {
+        pthread_mutex_unlock(&lock);
+        errno = EBADF;
+        return -1;
+    }
+    // Group format: nr, time_enabled, time_running, values[nr]
+    if (c->group_format) {
+        c = &counters[c->leader];
+        if (size < (3 + c->members_count) * sizeof(ullong)) {
+            pthread_mutex_unlock(&lock);
+            errno = ENOSPC;
+            return -1;
+        }
+        values[0] = c->members_count;
+        for (i = 0; i < c->members_count; ++i) {
+            values[3 + i] = (ullong) static_value(&counters[c->members[i]], &time);
+        }
+        values[1] = time;
+        values[2] = time;
+        pthread_mutex_unlock(&lock);
+        return (3 + c->members_count) * sizeof(ullong);
+    }
+    // Single: value, time_enabled, time_running
+    if (size < 3 * sizeof(ullong)) {
+        pthread_mutex_unlock(&lock);
+        errno = ENOSPC;
+        return -1;
+    }
+    values[0] = (ullong) static_value(c, &time);
+    values[1] = time;
+    values[2] = time;
+    pthread_mutex_unlock(&lock);
+    return 3 * sizeof(ullong);
+}
+
+void perf_fake_close(int fd)
+{
+    pthread_mutex_lock(&lock);
+    if (static_get(fd) != NULL) {
+        counters[fd].used = 0;
+    }
+    pthread_mutex_unlock(&lock);
+    close(fd);
+}
@@ -0,0 +1,35 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef METRICS_COMMON_PERF_FAKE_H
+#define METRICS_COMMON_PERF_FAKE_H
+
+#include <common/states.h>
+#include <common/types.h>
+#include <linux/perf_event.h>
+
+// Simulated perf counters, enabled when the hardware root is redirected (see
+// common/hardware/hwroot.h). The counters progress with the time they have
+// been enabled, at a fixed rate per event type (cycles at 2.4 GHz, IPC 1.25,
+// uncore events at 50M per second...) with a small per CPU variation. The
+// file descriptors are real (/dev/null), so they can be polled or closed.
+
+int perf_fake_is_enabled();
+
+// Same arguments and return values than perf_event_open(), ioctl() and read().
+int perf_fake_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd);
+
+int perf_fake_ioctl(int fd, ulong request, int flags);
+
+int perf_fake_read(int fd, void *buffer, size_t size);
+
+void perf_fake_close(int fd);
+
+#endif // METRICS_COMMON_PERF_FAKE_H
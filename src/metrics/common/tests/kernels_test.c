@@ -0,0 +1,226 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Microbenchmark of the diff kernels against the previous scalar loops, using
+// synthetic samples. Usage: ./kernels_test [cpus] [iterations]
+
+#include <common/system/time.h>
+#include <common/types.h>
+#include <metrics/common/kernels.h>
+#include <metrics/cpufreq/cpufreq.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BASE_FREQ 2400000LU
+
+static uint cpus  = 512;
+static uint iters = 100000;
+
+static cpufreq_t *f1;
+static cpufreq_t *f2;
+static ullong *e1;
+static ullong *e2;
+static ulong *freqs_old;
+static ulong *freqs_new;
+static ullong *ediff_old;
+static ullong *ediff_new;
+static ullong *aperfs;
+static ullong *mperfs;
+static uint *valids;
+
+// Previous cpufreq_intel63_data_diff loop
+static ulong legacy_cpufreq(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs)
+{
+    ulong mperf_diff, aperf_diff, aperf_pcnt;
+    ulong valid_count = 0;
+    ulong average     = 0;
+    ulong freq_aux;
+    int cpu;
+
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        freqs[cpu] = 0LU;
+        if (f2[cpu].error || f1[cpu].error) {
+            continue;
+        }
+        valid_count += 1LU;
+        if (f2[cpu].freq_mperf < f1[cpu].freq_mperf) {
+            mperf_diff = ULONG_MAX - f1[cpu].freq_mperf + f2[cpu].freq_mperf;
+        } else {
+            mperf_diff = f2[cpu].freq_mperf - f1[cpu].freq_mperf;
+        }
+        if (f2[cpu].freq_aperf < f1[cpu].freq_aperf) {
+            aperf_diff = ULONG_MAX - f1[cpu].freq_aperf + f2[cpu].freq_aperf;
+        } else {
+            aperf_diff = f2[cpu].freq_aperf - f1[cpu].freq_aperf;
+        }
+        if (aperf_diff == 0 || mperf_diff == 0) {
+            continue;
+        }
+        if (((ulong) (-1LU) / 100LU) < aperf_diff) {
+            aperf_diff >>= 7;
+            mperf_diff >>= 7;
+        }
+        aperf_pcnt = (aperf_diff * 100LU) / mperf_diff;
+        freq_aux   = (BASE_FREQ * aperf_pcnt) / 100LU;
+        freqs[cpu] = freq_aux;
+        average += freq_aux;
+    }
+    if (valid_count > 0LU) {
+        average = average / valid_count;
+    }
+    return average;
+}
+
+// Like the callers, the fused loop is kept when the kernels are scalar
+static ulong kernels_cpufreq(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs)
+{
+    uint stride = kernels_stride64(cpufreq_t);
+
+    if (kernels_type() == KERNELS_SCALAR) {
+        return legacy_cpufreq(f2, f1, freqs);
+    }
+
+    kernels_valid(valids, &f2[0].error, &f1[0].error, cpus, kernels_stride32(cpufreq_t));
+    kernels_diff(mperfs, (ullong *) &f2[0].freq_mperf, (ullong *) &f1[0].freq_mperf, cpus, stride, 64);
+    kernels_diff(aperfs, (ullong *) &f2[0].freq_aperf, (ullong *) &f1[0].freq_aperf, cpus, stride, 64);
+    kernels_ratio(freqs, aperfs, mperfs, valids, cpus, BASE_FREQ, 1);
+    return kernels_average(freqs, valids, cpus);
+}
+
+// Previous energy_cpu_data_diff loop (without the overflow branch)
+static ullong legacy_energy(ullong *end, ullong *start, ullong *result)
+{
+    ullong total = 0;
+    int i;
+    for (i = 0; i < cpus; ++i) {
+        result[i] = (start[i] > end[i]) ? 0LLU : end[i] - start[i];
+        total += result[i];
+    }
+    return total;
+}
+
+static ullong kernels_energy(ullong *end, ullong *start, ullong *result)
+{
+    if (kernels_type() == KERNELS_SCALAR) {
+        return legacy_energy(end, start, result);
+    }
+    kernels_diff(result, end, start, cpus, 1, 64);
+    return kernels_sum(result, NULL, cpus, NULL);
+}
+
+static double ns_per_iter(timestamp_t *t1)
+{
+    timestamp_t t2;
+    timestamp_getprecise(&t2);
+    return (double) timestamp_diff(&t2, t1, TIME_NSECS) / (double) iters;
+}
+
+static void samples_fill()
+{
+    ulong mperf;
+    int i;
+
+    srand(cpus);
+    for (i = 0; i < cpus; ++i) {
+        f1[i].freq_mperf = ((ulong) rand() << 16);
+        f1[i].freq_aperf = ((ulong) rand() << 16);
+        mperf            = BASE_FREQ * 1000LU + (ulong) (rand() % 1000);
+        f2[i].freq_mperf = f1[i].freq_mperf + mperf;
+        f2[i].freq_aperf = f1[i].freq_aperf + (mperf / 100LU) * (ulong) (50 + rand() % 100);
+        f1[i].error      = (rand() % 64) == 0;
+        f2[i].error      = 0;
+        e1[i]            = ((ullong) rand() << 20);
+        e2[i]            = e1[i] + (ullong) rand();
+    }
+    // Some CPUs without activity
+    f2[1].freq_aperf = f1[1].freq_aperf;
+    f2[2].freq_mperf = f1[2].freq_mperf;
+}
+
+static void bench(char *name, uint type)
+{
+    ulong avg_old, avg_new;
+    ullong sum_old, sum_new;
+    timestamp_t t;
+    double ns_old, ns_new;
+    uint errors = 0;
+    int i;
+
+    if (type != (uint) -1 && state_fail(kernels_select(type))) {
+        printf("%-8s: not supported\n", name);
+        return;
+    }
+    // Correctness
+    avg_old = legacy_cpufreq(f2, f1, freqs_old);
+    avg_new = kernels_cpufreq(f2, f1, freqs_new);
+    sum_old = legacy_energy(e2, e1, ediff_old);
+    sum_new = kernels_energy(e2, e1, ediff_new);
+    errors += (avg_old != avg_new) + (sum_old != sum_new);
+    errors += (memcmp(freqs_old, freqs_new, cpus * sizeof(ulong)) != 0);
+    errors += (memcmp(ediff_old, ediff_new, cpus * sizeof(ullong)) != 0);
+    // Performance
+    timestamp_getprecise(&t);
+    for (i = 0; i < iters; ++i) {
+        avg_old += legacy_cpufreq(f2, f1, freqs_old);
+        __asm__ volatile("" ::: "memory");
+    }
+    ns_old = ns_per_iter(&t);
+    timestamp_getprecise(&t);
+    for (i = 0; i < iters; ++i) {
+        avg_new += kernels_cpufreq(f2, f1, freqs_new);
+        __asm__ volatile("" ::: "memory");
+    }
+    ns_new = ns_per_iter(&t);
+    printf("%-8s: cpufreq %8.1lf ns (old %8.1lf ns, x%0.2lf), ", name, ns_new, ns_old, ns_old / ns_new);
+
+    timestamp_getprecise(&t);
+    for (i = 0; i < iters; ++i) {
+        sum_old += legacy_energy(e2, e1, ediff_old);
+        __asm__ volatile("" ::: "memory");
+    }
+    ns_old = ns_per_iter(&t);
+    timestamp_getprecise(&t);
+    for (i = 0; i < iters; ++i) {
+        sum_new += kernels_energy(e2, e1, ediff_new);
+        __asm__ volatile("" ::: "memory");
+    }
+    ns_new = ns_per_iter(&t);
+    printf("diff+sum %8.1lf ns (old %8.1lf ns, x%0.2lf), %s\n", ns_new, ns_old, ns_old / ns_new,
+           (errors) ? "MISMATCH" : "ok");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        cpus = (uint) atoi(argv[1]);
+    }
+    if (argc > 2) {
+        iters = (uint) atoi(argv[2]);
+    }
+    f1        = calloc(cpus, sizeof(cpufreq_t));
+    f2        = calloc(cpus, sizeof(cpufreq_t));
+    e1        = calloc(cpus, sizeof(ullong));
+    e2        = calloc(cpus, sizeof(ullong));
+    freqs_old = calloc(cpus, sizeof(ulong));
+    freqs_new = calloc(cpus, sizeof(ulong));
+    ediff_old = calloc(cpus, sizeof(ullong));
+    ediff_new = calloc(cpus, sizeof(ullong));
+    aperfs    = calloc(cpus, sizeof(ullong));
+    mperfs    = calloc(cpus, sizeof(ullong));
+    valids    = calloc(cpus, sizeof(uint));
+    samples_fill();
+
+    printf("%u CPUs, %u iterations\n", cpus, iters);
+    bench("scalar", KERNELS_SCALAR);
+    bench("avx2", KERNELS_AVX2);
+    bench("avx512", KERNELS_AVX512);
+    return 0;
+}
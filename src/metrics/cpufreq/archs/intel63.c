@@ -14,6 +14,7 @@
 #include <common/sizes.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <metrics/common/kernels.h>
 #include <metrics/common/msr.h>
 #include <metrics/cpufreq/archs/intel63.h>
 #include <metrics/cpufreq/cpufreq_base.h>
@@ -45,6 +46,8 @@ state_t cpufreq_intel63_status(topology_t *tp_in, cpufreq_ops_t *ops)
     topology_copy(&tp, tp_in);
     // Getting base frequency
     cpufreq_base_init(&tp, &bf);
+    // Selecting the diff kernels
+    kernels_init(&tp);
     replace_ops(ops->count_devices, cpufreq_intel63_count_devices);
     replace_ops(ops->data_diff, cpufreq_intel63_data_diff);
 
@@ -111,22 +114,14 @@ state_t cpufreq_intel63_read(ctx_t *c, cpufreq_t *f)
     return EAR_SUCCESS;
 }
 
-state_t cpufreq_intel63_data_diff(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ulong *average)
+// One pass over the CPUs, faster than the scalar kernels (which take a pass per step)
+static void data_diff_fused(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ulong *average)
 {
     ulong mperf_diff, aperf_diff, aperf_pcnt;
     ulong valid_count = 0;
     ulong freq_aux;
     int cpu;
 
-    debug("cpufreq_intel63_data diff");
-    // If null return.
-    if (f2 == NULL || f1 == NULL) {
-        return_msg(EAR_ERROR, Generr.input_null);
-    }
-    // If average not null, then clean.
-    if (average != NULL) {
-        *average = 0LU;
-    }
     // Iterating over all CPU cores.
     for (cpu = 0; cpu < tp.cpu_count; ++cpu) {
         // Also frequency clean.
@@ -152,11 +147,6 @@ state_t cpufreq_intel63_data_diff(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ul
         } else {
             aperf_diff = f2[cpu].freq_aperf - f1[cpu].freq_aperf;
         }
-#if 0
-		debug("CPU %d: APERF %lu - %lu = , MPERF %lu - %lu = %lu", tp.cpus[cpu].id,
-			f2[cpu].freq_aperf, f1[cpu].freq_aperf, aperf_diff,
-			f2[cpu].freq_mperf, f1[cpu].freq_mperf, mperf_diff);
-#endif
         // Preventing floating point exception
         if (aperf_diff == 0 || mperf_diff == 0) {
             continue;
@@ -165,9 +155,6 @@ state_t cpufreq_intel63_data_diff(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ul
         // only way to overflow that counter is measuring if the aperf
         // difference is smaller than the maximum ulong value ((ulong) -1LU)
         // divided by 100. In case it is, removing 7 bits prevents that problem.
-        // But it is an incorrect solution because it would take a lot of bits
-        // and does not control when the first APERF/MPERF is greater the
-        // second. It has to be fixed.
         if (((ulong) (-1LU) / 100LU) < aperf_diff) {
             aperf_diff >>= 7;
             mperf_diff >>= 7;
@@ -187,6 +174,55 @@ state_t cpufreq_intel63_data_diff(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ul
     if (average != NULL && valid_count > 0LU) {
         *average = *average / valid_count;
     }
+}
+
+state_t cpufreq_intel63_data_diff(cpufreq_t *f2, cpufreq_t *f1, ulong *freqs, ulong *average)
+{
+    uint stride64 = kernels_stride64(cpufreq_t);
+    uint stride32 = kernels_stride32(cpufreq_t);
+    uint n        = tp.cpu_count;
+    ullong *aperf_diffs = kernels_buffer(0, n);
+    ullong *mperf_diffs = kernels_buffer(1, n);
+    ulong *freqs_aux    = kernels_buffer(2, n);
+    uint *valids        = kernels_buffer(3, n);
+    ulong *freqs_out;
+
+    debug("cpufreq_intel63_data diff");
+    // If null return.
+    if (f2 == NULL || f1 == NULL) {
+        return_msg(EAR_ERROR, Generr.input_null);
+    }
+    // If average not null, then clean.
+    if (average != NULL) {
+        *average = 0LU;
+    }
+    if (kernels_type() == KERNELS_SCALAR) {
+        data_diff_fused(f2, f1, freqs, average);
+        return EAR_SUCCESS;
+    }
+    if (aperf_diffs == NULL || mperf_diffs == NULL || freqs_aux == NULL || valids == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    freqs_out = (freqs != NULL) ? freqs : freqs_aux;
+    // The samples are not valid if there is an error in any of the lectures.
+    // Invalid samples are not counted in the average.
+    kernels_valid(valids, &f2[0].error, &f1[0].error, n, stride32);
+    // Differences between APERF/MPERF counters between both samples. The
+    // 64 bit wrap around is computed in modular arithmetic.
+    if (kernels_diff(mperf_diffs, (ullong *) &f2[0].freq_mperf, (ullong *) &f1[0].freq_mperf, n, stride64, 64)) {
+        debug("Warning, potential overflow in MPERF computation");
+    }
+    if (kernels_diff(aperf_diffs, (ullong *) &f2[0].freq_aperf, (ullong *) &f1[0].freq_aperf, n, stride64, 64)) {
+        debug("Warning, potential overflow in APERF computation");
+    }
+    // With the APERF/MPERF percentage applied to the base frequency, finally
+    // can be computed the average frequency of each CPU. The ratio is computed
+    // in double precision, so the aperf * 100 overflow is not a problem, and
+    // the CPUs with 0 differences are returned as 0 (but counted as valid).
+    kernels_ratio(freqs_out, aperf_diffs, mperf_diffs, valids, n, bf.frequency, 1);
+    if (average != NULL) {
+        *average = kernels_average(freqs_out, valids, n);
+    }
 
     return EAR_SUCCESS;
 }
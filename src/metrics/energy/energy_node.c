@@ -11,6 +11,7 @@
 
 //#define SHOW_DEBUGS 1
 
+#include <pthread.h>
 #include <common/config.h>
 #include <common/includes.h>
 #include <common/output/debug.h>
@@ -33,14 +34,54 @@ struct energy_op {
     state_t (*energy_to_str)(char *str, edata_t end);
     state_t (*power_limit)(void *c, ulong limit, ulong target);
     uint (*is_null)(edata_t end);
+    state_t (*data_add)(edata_t e, ulong units);
 } energy_ops;
 
 const char *energy_names[] = {"energy_init",        "energy_dispose",      "energy_datasize",    "energy_frequency",
                               "energy_dc_read",     "energy_dc_time_read", "energy_ac_read",     "energy_units",
-                              "energy_accumulated", "energy_to_str",       "energy_power_limit", "energy_data_is_null"};
+                              "energy_accumulated", "energy_to_str",       "energy_power_limit", "energy_data_is_null",
+                              "energy_data_add"};
 
+#define CACHE_PERIOD_DEF_US  100000  // Polling period when the plug-in does not report its frequency
+#define CACHE_PERIOD_MIN_US  10000
+#define CACHE_PERIOD_MAX_US  1000000
+#define CACHE_EXTRA_MAX      2       // Extrapolation stops after 2 BMC periods without updates
+
+typedef struct energy_cache_s {
+    pthread_mutex_t lock;        // Protects the cached sample
+    pthread_mutex_t plugin_lock; // Serializes the calls to the plug-in
+    pthread_t       thread;
+    void           *context;
+    size_t          size;
+    uint            units;
+    ulong           period_us;
+    uint            enabled;
+    uint            running;
+    uint            valid;
+    uint            extrapolate;
+    edata_t         sample;      // Last BMC sample
+    edata_t         reading;     // Thread private reading
+    timestamp_t     sample_time; // When the last BMC update was detected
+    ullong          sample_aux;  // Auxiliar energy (mJ) when the last BMC update was detected
+    timestamp_t     poll_time;   // When the thread read the auxiliar energy for the last time
+    ullong          poll_aux;    // Auxiliar energy (mJ) read by the thread
+    int             poll_aux_ok;
+    double          power_w;     // Node power between the two last BMC updates
+    double          aux_ratio;   // Node energy per auxiliar energy between the two last BMC updates
+    ulong           extra_last;  // Last extrapolated energy (plug-in units) returned
+    ulong           extra_carry; // Extrapolated energy not yet covered by the BMC
+    energy_aux_f    read_aux;
+    ullong          read_us_acc;
+    ullong          period_us_acc;
+    energy_cache_stats_t stats;
+} energy_cache_t;
+
+static energy_cache_t cache = {
+    .lock        = PTHREAD_MUTEX_INITIALIZER,
+    .plugin_lock = PTHREAD_MUTEX_INITIALIZER,
+};
 static int energy_loaded = 0;
-static int energy_nops   = 12;
+static int energy_nops   = 13;
 
 state_t energy_load(char *energy_obj)
 {
@@ -95,6 +136,9 @@ state_t energy_dispose(ehandler_t *eh)
 {
     state_t s = EAR_SUCCESS;
 
+    if (cache.enabled && eh->context == cache.context) {
+        energy_cache_dispose();
+    }
     if (energy_ops.dispose != NULL) {
         s = energy_ops.dispose(&eh->context);
     }
@@ -158,19 +202,40 @@ state_t energy_frequency(ehandler_t *eh, ulong *fus)
     return EAR_SUCCESS;
 }
 
+static state_t cache_read(edata_t emj, ulong *tms);
+
 state_t energy_dc_read(ehandler_t *eh, edata_t emj)
 {
+    state_t s;
+
+    // If the cache is disposed meanwhile, the plug-in is read
+    if (cache.enabled && (s = cache_read(emj, NULL)) != EAR_NOT_INITIALIZED) {
+        return s;
+    }
     preturn(energy_ops.dc_read, eh->context, emj);
 }
 
 state_t energy_dc_time_read(ehandler_t *eh, edata_t emj, ulong *tms)
 {
+    state_t s;
+
+    if (cache.enabled && (s = cache_read(emj, tms)) != EAR_NOT_INITIALIZED) {
+        return s;
+    }
     preturn(energy_ops.dc_time_read, eh->context, emj, tms);
 }
 
 state_t energy_ac_read(ehandler_t *eh, edata_t emj)
 {
-    preturn(energy_ops.ac_read, eh->context, emj);
+    state_t s;
+
+    if (energy_ops.ac_read == NULL) {
+        return_msg(EAR_UNDEFINED, Generr.api_undefined);
+    }
+    pthread_mutex_lock(&cache.plugin_lock);
+    s = energy_ops.ac_read(eh->context, emj);
+    pthread_mutex_unlock(&cache.plugin_lock);
+    return s;
 }
 
 /* Energy units are 1=Joules, 1000=mJ, 1000000=uJ, 1000000000nJ */
@@ -193,7 +258,15 @@ state_t energy_to_str(ehandler_t *eh, char *str, edata_t e)
 
 state_t energy_set_power_limit(ehandler_t *eh, ulong limit, ulong target)
 {
-    preturn(energy_ops.power_limit, eh->context, limit, target);
+    state_t s;
+
+    if (energy_ops.power_limit == NULL) {
+        return_msg(EAR_UNDEFINED, Generr.api_undefined);
+    }
+    pthread_mutex_lock(&cache.plugin_lock);
+    s = energy_ops.power_limit(eh->context, limit, target);
+    pthread_mutex_unlock(&cache.plugin_lock);
+    return s;
 }
 
 uint energy_data_is_null(ehandler_t *eh, edata_t e)
@@ -204,4 +277,262 @@ uint energy_data_is_null(ehandler_t *eh, edata_t e)
         /* Should we return 1 or 0 by default */
         return 1;
     }
-}
\ No newline at end of file
+}
+/*
+ * Node energy cache
+ */
+
+static ulong cache_diff(edata_t init, edata_t end)
+{
+    ulong diff = 0;
+
+    if (energy_ops.accumulated != NULL) {
+        energy_ops.accumulated(&diff, init, end);
+    } else if (cache.size == sizeof(ulong)) {
+        diff = *((ulong *) end) - *((ulong *) init);
+    }
+    return diff;
+}
+
+static void cache_add(edata_t e, ulong units)
+{
+    if (energy_ops.data_add != NULL) {
+        energy_ops.data_add(e, units);
+    } else if (cache.size == sizeof(ulong)) {
+        *((ulong *) e) += units;
+    }
+}
+
+static int cache_aux(ullong *energy_mj)
+{
+    if (cache.read_aux == NULL) {
+        return 0;
+    }
+    return state_ok(cache.read_aux(energy_mj));
+}
+
+static void cache_update(state_t s, timestamp_t *time, ulong read_us, ullong aux, int aux_ok)
+{
+    ulong diff;
+    ulong elapsed_us;
+    ullong aux_diff;
+
+    pthread_mutex_lock(&cache.lock);
+    cache.poll_time   = *time;
+    cache.poll_aux    = aux;
+    cache.poll_aux_ok = aux_ok;
+    cache.stats.bmc_reads++;
+    cache.read_us_acc += read_us;
+    cache.stats.bmc_read_us = (ulong) (cache.read_us_acc / cache.stats.bmc_reads);
+    // Some plug-ins warn when the BMC has not been refreshed yet
+    if (s == EAR_WARNING) {
+        goto leave;
+    }
+    if (state_fail(s)) {
+        cache.stats.bmc_errors++;
+        goto leave;
+    }
+    if (!cache.valid) {
+        memcpy(cache.sample, cache.reading, cache.size);
+        cache.sample_time = *time;
+        cache.sample_aux  = aux;
+        cache.valid       = 1;
+        goto leave;
+    }
+    // If the BMC has not refreshed its value, the sample is the same
+    if ((diff = cache_diff(cache.sample, cache.reading)) == 0) {
+        goto leave;
+    }
+    elapsed_us    = (ulong) timestamp_diff(time, &cache.sample_time, TIME_USECS);
+    cache.power_w = (((double) diff) / ((double) cache.units)) / (((double) ear_max(elapsed_us, 1)) / 1000000.0);
+    cache.aux_ratio = 0.0;
+    if (aux_ok && aux > cache.sample_aux) {
+        aux_diff        = aux - cache.sample_aux;
+        cache.aux_ratio = (((double) diff) * 1000.0 / ((double) cache.units)) / ((double) aux_diff);
+    }
+    // The energy already returned over the BMC value is kept to be monotonic
+    cache.extra_carry = (cache.extra_last > diff) ? cache.extra_last - diff : 0;
+    cache.extra_last  = cache.extra_carry;
+    memcpy(cache.sample, cache.reading, cache.size);
+    cache.sample_time = *time;
+    cache.sample_aux  = aux;
+    cache.stats.bmc_updates++;
+    if (cache.stats.bmc_updates > 1) {
+        cache.period_us_acc += elapsed_us;
+        cache.stats.bmc_period_us = (ulong) (cache.period_us_acc / (cache.stats.bmc_updates - 1));
+    }
+    debug("BMC update: %lu units in %lu us (%0.2lf W, aux ratio %0.2lf)", diff, elapsed_us, cache.power_w,
+          cache.aux_ratio);
+leave:
+    pthread_mutex_unlock(&cache.lock);
+}
+
+static void *cache_main(void *arg)
+{
+    timestamp_t time1;
+    timestamp_t time2;
+    ullong aux = 0;
+    int aux_ok;
+    state_t s;
+
+    while (cache.running) {
+        timestamp_getfast(&time1);
+        pthread_mutex_lock(&cache.plugin_lock);
+        s = energy_ops.dc_read(cache.context, cache.reading);
+        pthread_mutex_unlock(&cache.plugin_lock);
+        timestamp_getfast(&time2);
+        aux_ok = cache_aux(&aux);
+        cache_update(s, &time2, (ulong) timestamp_diff(&time2, &time1, TIME_USECS), aux, aux_ok);
+        usleep(cache.period_us);
+    }
+    return NULL;
+}
+
+static ulong cache_extrapolate(ullong aux, int aux_ok)
+{
+    ulong elapsed_us;
+    ulong elapsed_max;
+    double extra_mj;
+
+    elapsed_us  = (ulong) timestamp_diffnow(&cache.sample_time, TIME_USECS);
+    elapsed_max = (cache.stats.bmc_period_us > 0) ? cache.stats.bmc_period_us : CACHE_PERIOD_MAX_US;
+    elapsed_max = elapsed_max * CACHE_EXTRA_MAX;
+    if (aux_ok && cache.aux_ratio > 0.0 && aux >= cache.sample_aux && elapsed_us <= elapsed_max) {
+        extra_mj = ((double) (aux - cache.sample_aux)) * cache.aux_ratio;
+    } else {
+        extra_mj = cache.power_w * ((double) ear_min(elapsed_us, elapsed_max)) / 1000.0;
+    }
+    return (ulong) (extra_mj * ((double) cache.units) / 1000.0);
+}
+
+static state_t cache_read(edata_t emj, ulong *tms)
+{
+    timestamp_t time;
+    ullong aux = 0;
+    ulong extra;
+    int aux_ok;
+
+    pthread_mutex_lock(&cache.lock);
+    if (!cache.enabled) {
+        pthread_mutex_unlock(&cache.lock);
+        return_msg(EAR_NOT_INITIALIZED, Generr.api_uninitialized);
+    }
+    if (!cache.valid) {
+        pthread_mutex_unlock(&cache.lock);
+        return_msg(EAR_NOT_READY, "No BMC sample cached yet");
+    }
+    memcpy(emj, cache.sample, cache.size);
+    if (cache.extrapolate) {
+        // The auxiliar energy read by the thread, unless it missed a period (the plug-in is slow)
+        aux    = cache.poll_aux;
+        aux_ok = cache.poll_aux_ok;
+        if (timestamp_diffnow(&cache.poll_time, TIME_USECS) > 2 * cache.period_us) {
+            aux_ok = cache_aux(&aux);
+        }
+        extra = ear_max(cache_extrapolate(aux, aux_ok), cache.extra_carry);
+        extra = ear_max(extra, cache.extra_last);
+        cache_add(emj, extra);
+        cache.extra_last = extra;
+    }
+    cache.stats.reads++;
+    pthread_mutex_unlock(&cache.lock);
+    if (tms != NULL) {
+        timestamp_getreal(&time);
+        *tms = (ulong) timestamp_convert(&time, TIME_MSECS);
+    }
+    return EAR_SUCCESS;
+}
+
+state_t energy_cache_init(ehandler_t *eh, ulong period_ms)
+{
+    ulong freq_us = 0;
+    int m_errno;
+
+    if (!energy_loaded) {
+        return_msg(EAR_ERROR, Generr.api_uninitialized);
+    }
+    if (cache.enabled) {
+        return_msg(EAR_ERROR, Generr.api_initialized);
+    }
+    if (energy_ops.dc_read == NULL || energy_ops.datasize == NULL) {
+        return_msg(EAR_ERROR, Generr.api_undefined);
+    }
+    energy_ops.datasize(&cache.size);
+    cache.units = 1;
+    if (energy_ops.units != NULL) {
+        energy_ops.units(&cache.units);
+    }
+    // Opaque samples are extrapolated only if the plug-in knows how to add energy
+    cache.extrapolate = (energy_ops.data_add != NULL) || (cache.size == sizeof(ulong));
+    // Period: the plug-in native frequency if it has a dedicated one
+    if (period_ms > 0) {
+        cache.period_us = period_ms * 1000LU;
+    } else if (energy_ops.frequency != NULL && state_ok(energy_ops.frequency(&freq_us)) && freq_us > 0) {
+        cache.period_us = freq_us;
+    } else {
+        cache.period_us = CACHE_PERIOD_DEF_US;
+    }
+    cache.period_us = ear_min(ear_max(cache.period_us, CACHE_PERIOD_MIN_US), CACHE_PERIOD_MAX_US);
+    cache.sample    = calloc(1, cache.size);
+    cache.reading   = calloc(1, cache.size);
+    if (cache.sample == NULL || cache.reading == NULL) {
+        free(cache.sample);
+        free(cache.reading);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    cache.context = eh->context;
+    cache.valid   = 0;
+    cache.running = 1;
+    memset(&cache.stats, 0, sizeof(energy_cache_stats_t));
+    if ((m_errno = pthread_create(&cache.thread, NULL, cache_main, NULL)) != 0) {
+        cache.running = 0;
+        free(cache.sample);
+        free(cache.reading);
+        return_msg(EAR_ERROR, strerror(m_errno));
+    }
+    cache.enabled = 1;
+    debug("energy cache polling every %lu us (extrapolation %u)", cache.period_us, cache.extrapolate);
+    return EAR_SUCCESS;
+}
+
+state_t energy_cache_set_aux(energy_aux_f read_aux)
+{
+    pthread_mutex_lock(&cache.lock);
+    cache.read_aux  = read_aux;
+    cache.aux_ratio = 0.0;
+    pthread_mutex_unlock(&cache.lock);
+    return EAR_SUCCESS;
+}
+
+state_t energy_cache_dispose()
+{
+    if (!cache.enabled) {
+        return EAR_SUCCESS;
+    }
+    // The thread is stopped before freeing its reading
+    cache.running = 0;
+    pthread_join(cache.thread, NULL);
+    // And the readers holding the lock finish before freeing the sample
+    pthread_mutex_lock(&cache.lock);
+    cache.enabled = 0;
+    cache.valid   = 0;
+    free(cache.sample);
+    free(cache.reading);
+    cache.sample  = NULL;
+    cache.reading = NULL;
+    pthread_mutex_unlock(&cache.lock);
+    return EAR_SUCCESS;
+}
+
+int energy_cache_is_enabled()
+{
+    return cache.enabled;
+}
+
+state_t energy_cache_stats(energy_cache_stats_t *stats)
+{
+    pthread_mutex_lock(&cache.lock);
+    memcpy(stats, &cache.stats, sizeof(energy_cache_stats_t));
+    pthread_mutex_unlock(&cache.lock);
+    return EAR_SUCCESS;
+}
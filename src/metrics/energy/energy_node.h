@@ -49,4 +49,32 @@ state_t energy_set_power_limit(ehandler_t *eh, ulong limit, ulong target);
 
 state_t energy_not_privileged_init();
 
+/* Node energy cache service. A dedicated thread polls the plugin at its native
+ * refresh rate (or period_ms if not 0) and energy_dc_read/energy_dc_time_read
+ * are answered from the cached sample. Between BMC updates the energy is
+ * extrapolated using the auxiliar reader (usually RAPL) when it is set, or the
+ * last node power otherwise. The extrapolation is only done for plugins with a
+ * single counter (datasize == sizeof(ulong)) or exporting energy_data_add, the
+ * other plugins get the last BMC sample as it was read. */
+typedef state_t (*energy_aux_f)(ullong *energy_mj);
+
+typedef struct energy_cache_stats_s {
+    ullong reads;        // energy_dc_read calls answered from cache
+    ullong bmc_reads;    // Plugin reads issued by the cache thread
+    ullong bmc_updates;  // Plugin reads in which the value changed
+    ullong bmc_errors;   // Plugin reads which failed
+    ulong  bmc_read_us;  // Average plugin read latency
+    ulong  bmc_period_us; // Average time between BMC updates
+} energy_cache_stats_t;
+
+state_t energy_cache_init(ehandler_t *eh, ulong period_ms);
+
+state_t energy_cache_set_aux(energy_aux_f read_aux);
+
+state_t energy_cache_dispose();
+
+int energy_cache_is_enabled();
+
+state_t energy_cache_stats(energy_cache_stats_t *stats);
+
 #endif // EAR_ENERGY_H
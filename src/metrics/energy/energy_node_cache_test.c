@@ -0,0 +1,157 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <pthread.h>
+
+#include <common/config.h>
+#include <metrics/common/ipmi_fake.h>
+#include <metrics/energy/energy_node.h>
+
+// make -f Makefile.test test_cache
+// ./test_cache ./ipmi_raw_fake.so:1
+// ipmi_raw_fake.so is ipmi_raw.so built with the simulated BMC (IPMI_FAKE=1),
+// by default a 300 W node refreshing its readings every 200 ms and answering
+// in 20 ms (EAR_IPMI_FAKE=300:200:20). Production plug-ins ignore the variable.
+
+#define DIRECT_READS 20
+#define CACHED_READS 100000
+#define TEST_SECONDS 3
+
+static timestamp_t aux_time;
+static ulong aux_reads;
+static volatile int racing;
+static ehandler_t eh;
+
+/* A 300 W auxiliar meter, counting how many times it is read */
+static state_t aux_read(ullong *energy_mj)
+{
+    __atomic_add_fetch(&aux_reads, 1, __ATOMIC_RELAXED);
+    *energy_mj = (ullong) timestamp_diffnow(&aux_time, TIME_USECS) * 300LLU / 1000LLU;
+    return EAR_SUCCESS;
+}
+
+/* Reads while the cache is disposed */
+static void *reader(void *arg)
+{
+    edata_t e = (edata_t) arg;
+
+    while (racing) {
+        energy_dc_read(&eh, e);
+    }
+    return NULL;
+}
+
+static ulong read_latency(ehandler_t *eh, edata_t e, uint reads)
+{
+    timestamp_t t1;
+    uint i;
+
+    timestamp_getfast(&t1);
+    for (i = 0; i < reads; ++i) {
+        energy_dc_read(eh, e);
+    }
+    return (ulong) (timestamp_diffnow(&t1, TIME_NSECS) / reads);
+}
+
+int main(int argc, char *argv[])
+{
+    edata_t e_init, e_prev, e_curr;
+    energy_cache_stats_t stats;
+    pthread_t thread;
+    int disposed;
+    ulong aux_cached;
+    ulong latency_direct;
+    ulong latency_cached;
+    timestamp_t time_init;
+    double power_w;
+    ulong energy_mj;
+    ulong diff;
+    uint errors = 0;
+    size_t size;
+    uint units;
+    int i;
+
+    if (argc < 2) {
+        printf("usage: %s energy_plugin.so[:args]\n", argv[0]);
+        return 0;
+    }
+    setenv(FLAG_IPMI_FAKE, "300:200:20", 0);
+
+    if (state_fail(energy_load(argv[1]))) {
+        printf("energy_load failed: %s\n", state_msg);
+        return EXIT_FAILURE;
+    }
+    if (state_fail(energy_init(&eh))) {
+        printf("energy_init failed: %s\n", state_msg);
+        return EXIT_FAILURE;
+    }
+    energy_units(&eh, &units);
+    energy_datasize(&eh, &size);
+    e_init = calloc(1, size);
+    e_prev = calloc(1, size);
+    e_curr = calloc(1, size);
+
+    latency_direct = read_latency(&eh, e_curr, DIRECT_READS);
+
+    if (state_fail(energy_cache_init(&eh, 0))) {
+        printf("energy_cache_init failed: %s\n", state_msg);
+        return EXIT_FAILURE;
+    }
+    timestamp_getfast(&aux_time);
+    energy_cache_set_aux(aux_read);
+    // Waiting the first BMC sample
+    while (state_fail(energy_dc_read(&eh, e_init))) {
+        usleep(1000);
+    }
+    aux_cached     = aux_reads;
+    latency_cached = read_latency(&eh, e_curr, CACHED_READS);
+    // The auxiliar meter is read by the thread, not by each cached read
+    aux_cached = aux_reads - aux_cached;
+
+    // The cached energy can't go back, even when the BMC corrects the extrapolation
+    energy_dc_read(&eh, e_init);
+    timestamp_getfast(&time_init);
+    memcpy(e_prev, e_init, size);
+    for (i = 0; i < TEST_SECONDS * 1000; ++i) {
+        usleep(1000);
+        energy_dc_read(&eh, e_curr);
+        energy_accumulated(&eh, &diff, e_init, e_curr);
+        energy_accumulated(&eh, &energy_mj, e_init, e_prev);
+        if (diff < energy_mj) {
+            errors++;
+        }
+        memcpy(e_prev, e_curr, size);
+    }
+    energy_accumulated(&eh, &energy_mj, e_init, e_curr);
+    power_w = ((double) energy_mj) / ((double) units) / (((double) timestamp_diffnow(&time_init, TIME_MSECS)) / 1000.0);
+    energy_cache_stats(&stats);
+    // Disposing the cache while it is read, the reads go to the plug-in
+    racing = 1;
+    pthread_create(&thread, NULL, reader, e_prev);
+    usleep(10000);
+    energy_cache_dispose();
+    usleep(10000);
+    racing = 0;
+    pthread_join(thread, NULL);
+    disposed = !energy_cache_is_enabled() && energy_dc_read(&eh, e_curr) != EAR_NOT_INITIALIZED;
+    energy_dispose(&eh);
+
+    printf("direct read latency  : %lu ns\n", latency_direct);
+    printf("cached read latency  : %lu ns\n", latency_cached);
+    printf("cached reads         : %llu (%lu auxiliar reads)\n", stats.reads, aux_cached);
+    printf("BMC reads/updates    : %llu/%llu (%llu errors)\n", stats.bmc_reads, stats.bmc_updates, stats.bmc_errors);
+    printf("BMC latency/period   : %lu/%lu us\n", stats.bmc_read_us, stats.bmc_period_us);
+    printf("average power        : %0.2lf W\n", power_w);
+    printf("non-monotonic reads  : %u\n", errors);
+    printf("read after dispose   : %s\n", (disposed) ? "plug-in" : "failed");
+
+    return (errors == 0 && disposed && latency_cached < latency_direct && aux_cached < CACHED_READS / 100) ? EXIT_SUCCESS
+                                                                                                : EXIT_FAILURE;
+}
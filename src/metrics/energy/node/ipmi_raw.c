@@ -287,6 +287,14 @@ state_t energy_to_str(char *buffer, void *data)
     return EAR_SUCCESS;
 }
 
+// Used by the node energy cache to extrapolate between BMC updates. The energy
+// comes in the plug-in units (energy_units), mJ in this plug-in.
+state_t energy_data_add(void *data, ulong units)
+{
+    ((consumption_t *) data)->energy += (uint64_t) units;
+    return EAR_SUCCESS;
+}
+
 uint energy_data_is_null(void *data)
 {
     return ((consumption_t *) data)->energy == 0;
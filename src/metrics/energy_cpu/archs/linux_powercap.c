@@ -20,6 +20,7 @@
 #include <common/states.h>
 
 #include <common/hardware/hardware_info.h>
+#include <common/hardware/hwroot.h>
 #include <common/output/debug.h>
 #include <common/output/verbose.h>
 #include <metrics/common/apis.h>
@@ -28,12 +29,12 @@
  * https://www.kernel.org/doc/html/next/power/powercap/powercap.html
  */
 
-#define linux_powercap_folder "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d"
+#define linux_powercap_folder "%s/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d"
 /* Core means package in this case */
-#define linux_powercap_core_folder   "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/"
-#define linux_powercap_pck_metric    "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/%s"
-#define linux_powercap_uncore_folder "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/intel-rapl:%d:0"
-#define linux_powercap_metric        "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/intel-rapl:%d:%d/%s"
+#define linux_powercap_core_folder   "%s/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/"
+#define linux_powercap_pck_metric    "%s/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/%s"
+#define linux_powercap_uncore_folder "%s/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/intel-rapl:%d:0"
+#define linux_powercap_metric        "%s/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%d/intel-rapl:%d:%d/%s"
 #define linux_powercap_energy_file   "energy_uj"
 #define linux_powercap_domain_name   "name"
 #define linux_powercap_pck_name      "package-%d"
@@ -94,7 +95,7 @@ state_t linux_powercap_load(topology_t *tp_in)
     debug("linux_powercap: Using %d sockets", my_topo.cpu_count);
 
     for (j = 0; j < my_topo.cpu_count; j++) {
-        sprintf(aux_folder_name, linux_powercap_folder, j);
+        sprintf(aux_folder_name, linux_powercap_folder, hwroot_get(), j);
         debug("testing driver folder %s", aux_folder_name);
         /* Check socket folder */
         if (ear_file_is_directory(aux_folder_name)) {
@@ -102,12 +103,12 @@ state_t linux_powercap_load(topology_t *tp_in)
             linux_powercap_socket[j] = 1;
 
             /* Core */
-            sprintf(aux_folder_name, linux_powercap_core_folder, j);
+            sprintf(aux_folder_name, linux_powercap_core_folder, hwroot_get(), j);
             debug("Testing %s", aux_folder_name);
             if (ear_file_is_directory(aux_folder_name)) {
                 debug("core folder detected %s", aux_folder_name);
                 sprintf(pck_name, linux_powercap_pck_name, j);
-                sprintf(aux_folder_name, linux_powercap_pck_metric, j, linux_powercap_domain_name);
+                sprintf(aux_folder_name, linux_powercap_pck_metric, hwroot_get(), j, linux_powercap_domain_name);
 
                 /* This code is just to check the name is the expected one */
                 debug("Reding %s to check device", aux_folder_name);
@@ -126,7 +127,7 @@ state_t linux_powercap_load(topology_t *tp_in)
                 }
 
                 /* Here we open the metric file */
-                sprintf(aux_folder_name, linux_powercap_pck_metric, j, linux_powercap_energy_file);
+                sprintf(aux_folder_name, linux_powercap_pck_metric, hwroot_get(), j, linux_powercap_energy_file);
                 debug("Testing metric %s", aux_folder_name);
                 if ((linux_powercap_core_fds[j] = open(aux_folder_name, O_RDONLY)) >= 0) {
                     linux_powercap_num_sockets++;
@@ -141,12 +142,13 @@ state_t linux_powercap_load(topology_t *tp_in)
             }
 
             /* Uncore */
-            sprintf(aux_folder_name, linux_powercap_uncore_folder, j, j);
+            sprintf(aux_folder_name, linux_powercap_uncore_folder, hwroot_get(), j, j);
             debug("Testing %s", aux_folder_name);
             if (ear_file_is_directory(aux_folder_name)) {
                 debug("uncore folder detected %s", aux_folder_name);
                 /* This code is just to check the name is the expected one */
-                sprintf(aux_folder_name, linux_powercap_metric, j, j, uncore_id, linux_powercap_domain_name);
+                sprintf(aux_folder_name, linux_powercap_metric, hwroot_get(), j, j, uncore_id,
+                        linux_powercap_domain_name);
 
                 debug("Reding %s to check device", aux_folder_name);
                 int fd = open(aux_folder_name, O_RDONLY);
@@ -162,7 +164,7 @@ state_t linux_powercap_load(topology_t *tp_in)
                     debug("error reading device name %s", aux_folder_name);
                 }
                 /* We open the metric file now */
-                sprintf(aux_folder_name, linux_powercap_metric, j, j, uncore_id, linux_powercap_energy_file);
+                sprintf(aux_folder_name, linux_powercap_metric, hwroot_get(), j, j, uncore_id, linux_powercap_energy_file);
                 debug("Testing metric %s", aux_folder_name);
                 if ((linux_powercap_uncore_fds[j] = open(aux_folder_name, O_RDONLY)) >= 0) {
                     linux_powercap_num_sockets++;
@@ -19,6 +19,7 @@
 
 #include <common/config.h>
 #include <common/hardware/hardware_info.h>
+#include <common/hardware/hwroot.h>
 #include <common/output/debug.h>
 #include <common/output/verbose.h>
 #include <common/states.h>
@@ -293,7 +294,7 @@ static state_t perf_rapl_read_conf()
     FILE *fconfig;
 
     /* Event type */
-    snprintf(cfile, sizeof(cfile), "%s/type", EVENTS_PATH);
+    snprintf(cfile, sizeof(cfile), "%s%s/type", hwroot_get(), EVENTS_PATH);
     debug("perf_rapl: detecting perf type in %s", cfile);
     fconfig = fopen(cfile, "r");
     if (fconfig == NULL) {
@@ -308,7 +309,7 @@ static state_t perf_rapl_read_conf()
     debug("perf_rapl: type for rapl events detected %d", perf_type);
 
     /* PCK Scale */
-    snprintf(cfile, sizeof(cfile), "%s/events/energy-pkg.scale", EVENTS_PATH);
+    snprintf(cfile, sizeof(cfile), "%s%s/events/energy-pkg.scale", hwroot_get(), EVENTS_PATH);
     debug("perf_rapl: detecting pkg scale %s", cfile);
     fconfig = fopen(cfile, "r");
     if (fconfig == NULL) {
@@ -321,7 +322,7 @@ static state_t perf_rapl_read_conf()
     fclose(fconfig);
 
     /* RAM Units */
-    snprintf(cfile, sizeof(cfile), "%s/events/energy-ram.scale", EVENTS_PATH);
+    snprintf(cfile, sizeof(cfile), "%s%s/events/energy-ram.scale", hwroot_get(), EVENTS_PATH);
     debug("perf_rapl: detecting ram scale %s", cfile);
     fconfig = fopen(cfile, "r");
     if (fconfig == NULL) {
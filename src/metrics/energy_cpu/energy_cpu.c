@@ -15,6 +15,7 @@
 #include <common/plugins.h>
 #include <common/system/lock.h>
 #include <common/output/debug.h>
+#include <metrics/common/kernels.h>
 #include <metrics/energy_cpu/energy_cpu.h>
 #include <metrics/energy_cpu/archs/msr.h>
 #include <metrics/energy_cpu/archs/perf.h>
@@ -48,6 +49,7 @@ state_t energy_cpu_load(topology_t *tp, uint force_api)
         ear_unlock(&lock);
         return EAR_SUCCESS;
     }
+    kernels_init(tp);
     if (API_IS(force_api, API_DUMMY)) {
         goto dummy;
     }
@@ -147,14 +149,31 @@ state_t energy_cpu_dispose(ctx_t *c)
 state_t energy_cpu_data_diff(ctx_t *c, ullong *start, ullong *end, ullong *result)
 {
     int i;
-    for (i = 0; i < socket_count * NUM_PACKS; ++i) {
-        if (start[i] > end[i]) {
-            result[i] = ullong_diff_overflow(start[i], end[i]);
-        } else {
-            result[i] = end[i] - start[i];
+    if (kernels_type() == KERNELS_SCALAR) {
+        // One pass is faster than the scalar kernels
+        for (i = 0; i < socket_count * NUM_PACKS; ++i) {
+            if (start[i] > end[i]) {
+                result[i] = ullong_diff_overflow(start[i], end[i]);
+            } else {
+                result[i] = end[i] - start[i];
+            }
+            debug("doing diff %d, result %llu = %llu - %llu", i, result[i], end[i], start[i]);
+        }
+        return EAR_SUCCESS;
+    }
+    // The overflows (start greater than end) are rare, so are computed apart.
+    if (kernels_diff(result, end, start, socket_count * NUM_PACKS, 1, 64)) {
+        for (i = 0; i < socket_count * NUM_PACKS; ++i) {
+            if (start[i] > end[i]) {
+                result[i] = ullong_diff_overflow(start[i], end[i]);
+            }
         }
+    }
+#if SHOW_DEBUGS
+    for (i = 0; i < socket_count * NUM_PACKS; ++i) {
         debug("doing diff %d, result %llu = %llu - %llu", i, result[i], end[i], start[i]);
     }
+#endif
     return EAR_SUCCESS;
 }
 
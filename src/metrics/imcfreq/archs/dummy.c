@@ -12,6 +12,7 @@
 #include <stdlib.h>
 // #define SHOW_DEBUGS 1
 #include <common/output/debug.h>
+#include <metrics/common/kernels.h>
 #include <metrics/imcfreq/archs/dummy.h>
 
 static imcfreq_ops_t *ops_static;
@@ -122,6 +123,9 @@ state_t imcfreq_dummy_data_copy(imcfreq_t *i2, imcfreq_t *i1)
 
 state_t imcfreq_dummy_data_diff(imcfreq_t *i2, imcfreq_t *i1, ulong *freq_list, ulong *average)
 {
+    ullong *diffs = kernels_buffer(0, devs_count);
+    ulong *freqs  = kernels_buffer(1, devs_count);
+    uint *valids  = kernels_buffer(2, devs_count);
     ulong time;
     ulong freq;
     ulong aux1; // Adds frequencies
@@ -140,28 +144,40 @@ state_t imcfreq_dummy_data_diff(imcfreq_t *i2, imcfreq_t *i1, ulong *freq_list,
         *average = 0LU;
     }
     time = (ulong) timestamp_diff(&i2[0].time, &i1[0].time, TIME_MSECS);
-    //
-    for (cpu = 0, aux1 = aux2 = 0LU; cpu < devs_count; ++cpu) {
-        if (freq_list != NULL) {
-            freq_list[cpu] = 0LU;
-        }
-        if (i2[cpu].error || i1[cpu].error || time == 0) {
-            continue;
+    if (time == 0) {
+        return EAR_SUCCESS;
+    }
+    if (kernels_type() == KERNELS_SCALAR) {
+        // One pass is faster than the scalar kernels
+        for (cpu = 0, aux1 = aux2 = 0LU; cpu < devs_count; ++cpu) {
+            if (i2[cpu].error || i1[cpu].error) {
+                continue;
+            }
+            freq = (i2[cpu].freq - i1[cpu].freq) / time;
+            aux1 += freq;
+            aux2 += 1;
+            if (freq_list != NULL) {
+                freq_list[cpu] = freq;
+            }
         }
-        //
-        freq = (i2[cpu].freq - i1[cpu].freq) / time;
-        aux1 += freq;
-        aux2 += 1;
-        //
-        if (freq_list != NULL) {
-            freq_list[cpu] = freq;
+        if (average != NULL && aux2 > 0LU) {
+            *average = aux1 / aux2;
         }
+        return EAR_SUCCESS;
+    }
+    if (diffs == NULL || freqs == NULL || valids == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    kernels_valid(valids, &i2[0].error, &i1[0].error, devs_count, kernels_stride32(imcfreq_t));
+    kernels_diff(diffs, (ullong *) &i2[0].freq, (ullong *) &i1[0].freq, devs_count, kernels_stride64(imcfreq_t), 64);
+    for (cpu = 0; cpu < devs_count; ++cpu) {
+        freqs[cpu] = (valids[cpu]) ? (ulong) (diffs[cpu] / time) : 0LU;
+    }
+    if (freq_list != NULL) {
+        memcpy((void *) freq_list, (void *) freqs, sizeof(ulong) * devs_count);
     }
     if (average != NULL) {
-        *average = 0LU;
-        if (aux2 > 0LU) {
-            *average = aux1 / aux2;
-        }
+        *average = kernels_average(freqs, valids, devs_count);
     }
     return EAR_SUCCESS;
 }
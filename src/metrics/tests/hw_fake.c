@@ -0,0 +1,374 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <common/output/debug.h>
+#include <common/sizes.h>
+#include <metrics/tests/hw_fake.h>
+
+// Tree paths
+#define cpu_path            "/sys/devices/system/cpu/cpu%u"
+#define rapl_path           "/sys/devices/virtual/powercap/intel-rapl/intel-rapl:%u"
+#define hwmon_path          "/sys/class/hwmon/hwmon%u"
+// Registers
+#define MSR_TSC             0x0010
+#define MSR_PLATFORM_INFO   0x00CE
+#define MSR_MPERF           0x00E7
+#define MSR_APERF           0x00E8
+#define MSR_PERF_CTL        0x0199
+#define MSR_THERM_STATUS    0x019C
+#define MSR_TEMP_TARGET     0x01A2
+#define MSR_TURBO_LIMIT     0x01AD
+#define MSR_PKG_THERM       0x01B1
+#define MSR_RAPL_UNIT       0x0606
+#define MSR_PKG_ENERGY      0x0611
+#define MSR_DRAM_ENERGY     0x0619
+#define MSR_PP0_ENERGY      0x0639
+#define MSR_UNC_GLBL_CTL    0x0700
+#define MSR_UNC_FIXED_CTL   0x0703
+#define MSR_UNC_FIXED_CTR   0x0704
+#define MSR_PM_ENABLE       0x0770
+#define MSR_HWP_CAPS        0x0771
+#define MSR_HWP_REQUEST     0x0774
+#define MSR_SPR_UCLK_CTL    0x2FDE
+#define MSR_SPR_UCLK_CTR    0x2FDF
+#define MSR_SPR_GLBL_CTL    0x2FF0
+#define MSR_AMD_RAPL_UNIT   0xC0010299
+#define MSR_AMD_CORE_ENERGY 0xC001029A
+#define MSR_AMD_PKG_ENERGY  0xC001029B
+// Simulated values
+#define BASE_RATIO          24      // 2.4 GHz
+#define TURBO_RATIO         35      // 3.5 GHz
+#define LOWEST_RATIO        8       // 0.8 GHz
+#define HWP_EPP             0x80
+#define UNCORE_HZ           2.0e9   // 2.0 GHz
+#define RAPL_UNITS          0xA0E03 // 1/16384 J
+#define RAPL_J              16384.0
+#define PKG_WATTS           150.0
+#define DRAM_WATTS          20.0
+#define NODE_WATTS          400.0 // Node manager average
+#define TJMAX               100
+#define TEMP_DISTANCE       40 // 60 degrees
+#define POWERCAP_RANGE      262143328850LLU
+
+typedef struct fcpu_s {
+    int fd;
+    uint socket;
+    double hz; // APERF frequency
+} fcpu_t;
+
+static char root[SZ_PATH_SHORT];
+static fcpu_t *fcpus;
+static uint fcpus_count;
+static uint sockets_count;
+static double sim_time;
+
+static state_t mkdir_p(char *path)
+{
+    char buffer[SZ_PATH];
+    char *p;
+
+    snprintf(buffer, sizeof(buffer), "%s", path);
+    for (p = &buffer[1]; *p != '\0'; ++p) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(buffer, 0755) != 0 && errno != EEXIST) {
+                return_msg(EAR_ERROR, strerror(errno));
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(buffer, 0755) != 0 && errno != EEXIST) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    return EAR_SUCCESS;
+}
+
+// Writes a formatted text in root + path, creating the parent folders.
+static state_t fput(const char *text, const char *fmt, ...)
+{
+    char path[SZ_PATH];
+    char *slash;
+    va_list args;
+    FILE *fd;
+    int n;
+
+    n = snprintf(path, sizeof(path), "%s", root);
+    va_start(args, fmt);
+    vsnprintf(&path[n], sizeof(path) - n, fmt, args);
+    va_end(args);
+    if ((slash = strrchr(path, '/')) != NULL) {
+        *slash = '\0';
+        if (state_fail(mkdir_p(path))) {
+            return EAR_ERROR;
+        }
+        *slash = '/';
+    }
+    if ((fd = fopen(path, "w")) == NULL) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    fputs(text, fd);
+    fclose(fd);
+    return EAR_SUCCESS;
+}
+
+static void mwrite(uint cpu, off_t reg, ullong value)
+{
+    if (pwrite(fcpus[cpu].fd, &value, sizeof(value), HW_FAKE_MSR(reg)) != sizeof(value)) {
+        debug("pwrite failed for CPU%u register 0x%lx", cpu, reg);
+    }
+}
+
+static state_t create_cpu(uint cpu, uint cores, uint threads)
+{
+    uint cores_per_socket = cores / sockets_count;
+    uint core             = cpu % cores;
+    uint socket           = core / cores_per_socket;
+    char buffer[SZ_NAME_MEDIUM];
+    char path[SZ_PATH];
+    state_t s;
+
+    if (threads > 1) {
+        sprintf(buffer, "%u,%u\n", core, core + cores);
+    } else {
+        sprintf(buffer, "%u\n", core);
+    }
+    state_assert(s, fput(buffer, cpu_path "/topology/thread_siblings_list", cpu), return s);
+    sprintf(buffer, "%u\n", socket);
+    state_assert(s, fput(buffer, cpu_path "/topology/physical_package_id", cpu), return s);
+    // L1, L2 (private) and L3 (per socket)
+    state_assert(s, fput("1\n", cpu_path "/cache/index0/level", cpu), return s);
+    state_assert(s, fput("2\n", cpu_path "/cache/index2/level", cpu), return s);
+    state_assert(s, fput("3\n", cpu_path "/cache/index3/level", cpu), return s);
+    sprintf(buffer, "%u\n", core);
+    state_assert(s, fput(buffer, cpu_path "/cache/index0/id", cpu), return s);
+    state_assert(s, fput(buffer, cpu_path "/cache/index2/id", cpu), return s);
+    sprintf(buffer, "%u\n", socket);
+    state_assert(s, fput(buffer, cpu_path "/cache/index3/id", cpu), return s);
+    // Base frequency in kHz, when it is not taken from the host CPUID
+    sprintf(buffer, "%u\n", BASE_RATIO * 100000);
+    state_assert(s, fput(buffer, cpu_path "/cpufreq/base_frequency", cpu), return s);
+    // The MSR file is sparse, registers are written in its offsets
+    sprintf(path, "%s/dev/cpu/%u", root, cpu);
+    state_assert(s, mkdir_p(path), return s);
+    strcat(path, "/msr");
+    if ((fcpus[cpu].fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+        return_msg(EAR_ERROR, strerror(errno));
+    }
+    fcpus[cpu].socket = socket;
+    // Between 1.9 and 2.9 GHz, spread to avoid all CPUs having the same value
+    fcpus[cpu].hz = (BASE_RATIO * 0.1e9) * (0.8 + 0.4 * ((double) ((cpu * 37) % 100) / 100.0));
+    mwrite(cpu, MSR_PLATFORM_INFO, ((ullong) LOWEST_RATIO << 40) | (BASE_RATIO << 8));
+    mwrite(cpu, MSR_TURBO_LIMIT, TURBO_RATIO);
+    // HWP enabled, the request lets the hardware move between lowest and turbo
+    mwrite(cpu, MSR_PM_ENABLE, 1);
+    mwrite(cpu, MSR_HWP_CAPS, (LOWEST_RATIO << 24) | (BASE_RATIO << 8) | TURBO_RATIO);
+    mwrite(cpu, MSR_HWP_REQUEST, ((ullong) HWP_EPP << 24) | (TURBO_RATIO << 8) | LOWEST_RATIO);
+    mwrite(cpu, MSR_PERF_CTL, BASE_RATIO << 8);
+    mwrite(cpu, MSR_RAPL_UNIT, RAPL_UNITS);
+    mwrite(cpu, MSR_AMD_RAPL_UNIT, RAPL_UNITS);
+    mwrite(cpu, MSR_TEMP_TARGET, TJMAX << 16);
+    mwrite(cpu, MSR_THERM_STATUS, 0x88000000LLU | (TEMP_DISTANCE << 16));
+    mwrite(cpu, MSR_PKG_THERM, 0x88000000LLU | (TEMP_DISTANCE << 16));
+    mwrite(cpu, MSR_UNC_GLBL_CTL, 0);
+    mwrite(cpu, MSR_UNC_FIXED_CTL, 0);
+    mwrite(cpu, MSR_SPR_UCLK_CTL, 0);
+    mwrite(cpu, MSR_SPR_GLBL_CTL, 0);
+    return EAR_SUCCESS;
+}
+
+static state_t create_cpuinfo(uint cpus, uint cores)
+{
+    char *flags = NULL;
+    char *line  = NULL;
+    size_t len  = 0;
+    char *text;
+    size_t n = 0;
+    uint cpu, core;
+    FILE *fd;
+    state_t s;
+
+    // Flags are copied from the host, it is used to know if AVX512 is present
+    if ((fd = fopen("/proc/cpuinfo", "r")) != NULL) {
+        while (flags == NULL && getline(&line, &len, fd) != -1) {
+            if (strncmp(line, "flags", 5) == 0) {
+                flags = strdup(line);
+            }
+        }
+        fclose(fd);
+        free(line);
+    }
+    if (flags == NULL) {
+        flags = strdup("flags\t\t: fpu\n");
+    }
+    text = calloc(cpus, SZ_NAME_MEDIUM + strlen(flags));
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        core = cpu % cores;
+        n += sprintf(&text[n], "processor\t: %u\napicid\t\t: %u\n%s\n", cpu,
+                     ((core / (cores / sockets_count)) << 8) | ((core % (cores / sockets_count)) << 1) | (cpu >= cores),
+                     flags);
+    }
+    s = fput(text, "/proc/cpuinfo");
+    free(flags);
+    free(text);
+    return s;
+}
+
+static state_t create_pmu(char *name, uint type, char *cpumask)
+{
+    char buffer[SZ_NAME_SHORT];
+    state_t s;
+
+    sprintf(buffer, "%u\n", type);
+    state_assert(s, fput(buffer, "/sys/bus/event_source/devices/%s/type", name), return s);
+    if (cpumask != NULL) {
+        state_assert(s, fput(cpumask, "/sys/bus/event_source/devices/%s/cpumask", name), return s);
+    }
+    state_assert(s, fput("config:0-7\n", "/sys/bus/event_source/devices/%s/format/event", name), return s);
+    state_assert(s, fput("config:8-15\n", "/sys/bus/event_source/devices/%s/format/umask", name), return s);
+    return EAR_SUCCESS;
+}
+
+static state_t create_devices(uint cores)
+{
+    char cpumask[SZ_NAME_MEDIUM];
+    char buffer[SZ_NAME_SHORT];
+    uint socket, imc;
+    state_t s;
+
+    // First CPU of each socket
+    cpumask[0] = '\0';
+    for (socket = 0; socket < sockets_count; ++socket) {
+        sprintf(buffer, "%s%u", (socket) ? "," : "", socket * (cores / sockets_count));
+        strcat(cpumask, buffer);
+    }
+    strcat(cpumask, "\n");
+    // Perf PMUs (type numbers are taken from a real node)
+    state_assert(s, create_pmu("cpu", 4, NULL), return s);
+    state_assert(s, create_pmu("power", 23, cpumask), return s);
+    state_assert(s, fput("event=0x02\n", "/sys/bus/event_source/devices/power/events/energy-pkg"), return s);
+    state_assert(s, fput("2.3283064365386962890625e-10\n", "/sys/bus/event_source/devices/power/events/energy-pkg.scale"), return s);
+    state_assert(s, fput("Joules\n", "/sys/bus/event_source/devices/power/events/energy-pkg.unit"), return s);
+    state_assert(s, fput("event=0x03\n", "/sys/bus/event_source/devices/power/events/energy-ram"), return s);
+    state_assert(s, fput("2.3283064365386962890625e-10\n", "/sys/bus/event_source/devices/power/events/energy-ram.scale"), return s);
+    state_assert(s, fput("Joules\n", "/sys/bus/event_source/devices/power/events/energy-ram.unit"), return s);
+    for (imc = 0; imc < 4; ++imc) {
+        sprintf(buffer, "uncore_imc_%u", imc);
+        state_assert(s, create_pmu(buffer, 30 + imc, cpumask), return s);
+    }
+    // Powercap and hwmon
+    for (socket = 0; socket < sockets_count; ++socket) {
+        sprintf(buffer, "package-%u\n", socket);
+        state_assert(s, fput(buffer, rapl_path "/name", socket), return s);
+        state_assert(s, fput("0\n", rapl_path "/energy_uj", socket), return s);
+        state_assert(s, fput("dram\n", rapl_path "/intel-rapl:%u:0/name", socket, socket), return s);
+        state_assert(s, fput("0\n", rapl_path "/intel-rapl:%u:0/energy_uj", socket, socket), return s);
+        state_assert(s, fput("coretemp\n", hwmon_path "/name", socket), return s);
+        sprintf(buffer, "Package id %u\n", socket);
+        state_assert(s, fput(buffer, hwmon_path "/temp1_label", socket), return s);
+        sprintf(buffer, "%u\n", (TJMAX - TEMP_DISTANCE) * 1000);
+        state_assert(s, fput(buffer, hwmon_path "/temp1_input", socket), return s);
+    }
+    // The node manager, after the coretemp chips (in micro Watts)
+    state_assert(s, fput("power_meter\n", hwmon_path "/name", sockets_count), return s);
+    sprintf(buffer, "%llu\n", (ullong) (NODE_WATTS * 1e6));
+    state_assert(s, fput(buffer, hwmon_path "/power1_average", sockets_count), return s);
+    return EAR_SUCCESS;
+}
+
+state_t hw_fake_create(char *_root, uint cpus, uint sockets, uint threads)
+{
+    uint cores;
+    uint cpu;
+    state_t s;
+
+    if (threads < 1 || threads > 2 || sockets == 0 || cpus % (sockets * threads) != 0) {
+        return_msg(EAR_ERROR, Generr.arg_outbounds);
+    }
+    hw_fake_destroy();
+    snprintf(root, sizeof(root), "%s", _root);
+    state_assert(s, mkdir_p(root), return s);
+    cores         = cpus / threads;
+    sockets_count = sockets;
+    fcpus_count   = cpus;
+    fcpus         = calloc(cpus, sizeof(fcpu_t));
+    sim_time      = 0.0;
+
+    for (cpu = 0; cpu < cpus; ++cpu) {
+        state_assert(s, create_cpu(cpu, cores, threads), return s);
+    }
+    state_assert(s, create_cpuinfo(cpus, cores), return s);
+    state_assert(s, create_devices(cores), return s);
+    // Initial counter values
+    return hw_fake_advance(1.0);
+}
+
+state_t hw_fake_advance(double secs)
+{
+    char buffer[SZ_NAME_SHORT];
+    ullong pkg, dram;
+    uint socket;
+    uint cpu;
+    state_t s;
+
+    sim_time += secs;
+    pkg  = (ullong) (sim_time * PKG_WATTS * RAPL_J);
+    dram = (ullong) (sim_time * DRAM_WATTS * RAPL_J);
+
+    for (cpu = 0; cpu < fcpus_count; ++cpu) {
+        mwrite(cpu, MSR_TSC, (ullong) (sim_time * BASE_RATIO * 0.1e9));
+        mwrite(cpu, MSR_MPERF, (ullong) (sim_time * BASE_RATIO * 0.1e9));
+        mwrite(cpu, MSR_APERF, (ullong) (sim_time * fcpus[cpu].hz));
+        // Socket registers are written in all its CPUs, whichever is read
+        mwrite(cpu, MSR_PKG_ENERGY, pkg & 0xFFFFFFFF);
+        mwrite(cpu, MSR_DRAM_ENERGY, dram & 0xFFFFFFFF);
+        mwrite(cpu, MSR_PP0_ENERGY, (pkg / 2) & 0xFFFFFFFF);
+        mwrite(cpu, MSR_AMD_PKG_ENERGY, pkg & 0xFFFFFFFF);
+        mwrite(cpu, MSR_AMD_CORE_ENERGY, (pkg / fcpus_count) & 0xFFFFFFFF);
+        mwrite(cpu, MSR_UNC_FIXED_CTR, (ullong) (sim_time * UNCORE_HZ) & 0xFFFFFFFFFFFFLLU);
+        mwrite(cpu, MSR_SPR_UCLK_CTR, (ullong) (sim_time * UNCORE_HZ) & 0xFFFFFFFFFFFFLLU);
+    }
+    for (socket = 0; socket < sockets_count; ++socket) {
+        sprintf(buffer, "%llu\n", (ullong) (sim_time * PKG_WATTS * 1e6) % POWERCAP_RANGE);
+        state_assert(s, fput(buffer, rapl_path "/energy_uj", socket), return s);
+        sprintf(buffer, "%llu\n", (ullong) (sim_time * DRAM_WATTS * 1e6) % POWERCAP_RANGE);
+        state_assert(s, fput(buffer, rapl_path "/intel-rapl:%u:0/energy_uj", socket, socket), return s);
+    }
+    return EAR_SUCCESS;
+}
+
+void hw_fake_destroy()
+{
+    char command[SZ_PATH];
+    uint cpu;
+
+    for (cpu = 0; cpu < fcpus_count; ++cpu) {
+        close(fcpus[cpu].fd);
+    }
+    free(fcpus);
+    fcpus       = NULL;
+    fcpus_count = 0;
+    // Only the folders created by this module are removed
+    if (root[0] != '\0') {
+        sprintf(command, "rm -rf '%s/dev' '%s/sys' '%s/proc'", root, root, root);
+        if (system(command) != 0) {
+            debug("failed to clean %s", root);
+        }
+        rmdir(root);
+        root[0] = '\0';
+    }
+}
@@ -0,0 +1,42 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef METRICS_TESTS_HW_FAKE_H
+#define METRICS_TESTS_HW_FAKE_H
+
+#include <common/states.h>
+#include <common/types.h>
+
+/* Simulated hardware tree. It builds, below a root folder, the sysfs CPU
+ * topology, /proc/cpuinfo, a sparse /dev/cpu/N/msr file per CPU, a powercap
+ * and hwmon tree and a set of perf PMUs. Set EAR_HW_ROOT to the same folder
+ * before calling topology_init() to make the metrics layer use it. The objects
+ * of the metrics layer have to be built with HW_FAKE=1 (see the Makefile).
+ *
+ * In the MSR files each register takes 8 bytes, the register R is read at the
+ * offset HW_FAKE_MSR(R).
+ *
+ * MSR, powercap and hwmon counters only progress when hw_fake_advance() is
+ * called, so the simulated time is not accounted in the benchmarks. Perf
+ * counters are simulated by perf_fake and follow the real clock. */
+
+#define HW_FAKE_MSR(reg) ((off_t) (reg) * sizeof(ullong))
+
+// Builds the tree. The CPUs are numbered Linux-like: the first half are the
+// physical cores and the second half their SMT siblings (if threads is 2).
+state_t hw_fake_create(char *root, uint cpus, uint sockets, uint threads);
+
+// Moves the counters forward a number of simulated seconds.
+state_t hw_fake_advance(double secs);
+
+// Removes the tree.
+void hw_fake_destroy();
+
+#endif //METRICS_TESTS_HW_FAKE_H
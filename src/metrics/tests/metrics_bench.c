@@ -0,0 +1,269 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Benchmark of the metrics API over the simulated hardware of hw_fake. It
+// reports the latency and the number of allocations per call. Usage:
+//     ./metrics_bench [cpus] [sockets] [repetitions]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <common/config/config_env.h>
+#include <common/hardware/topology.h>
+#include <common/system/time.h>
+#include <common/types.h>
+#include <daemon/node_metrics.h>
+#include <metrics/bandwidth/bandwidth.h>
+#include <metrics/cache/cache.h>
+#include <metrics/common/apis.h>
+#include <metrics/cpi/cpi.h>
+#include <metrics/cpufreq/cpufreq.h>
+#include <metrics/energy_cpu/energy_cpu.h>
+#include <metrics/flops/flops.h>
+#include <metrics/imcfreq/imcfreq.h>
+#include <metrics/temperature/temperature.h>
+#include <metrics/tests/hw_fake.h>
+
+// Allocations are counted by wrapping the allocator (-Wl,--wrap), so
+// just the allocations done by EAR code are counted, not the libc ones.
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static ulong allocs;
+
+void *__wrap_malloc(size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+static uint reps = 100;
+
+static void report(char *name, uint calls, ullong ns, ulong allocs)
+{
+    printf("%-28s %8u %14.1lf %12.2lf\n", name, calls, (double) ns / (double) calls, (double) allocs / (double) calls);
+}
+
+// Runs 'call' 'n' times. The 'before' sentence is not measured, it is used to
+// move the simulated hardware forward between samples.
+#define bench(name, n, before, call)                                                                                   \
+    {                                                                                                                  \
+        ullong _ns = 0;                                                                                                \
+        ulong _al  = 0;                                                                                                \
+        ulong _al0;                                                                                                    \
+        timestamp _t1, _t2;                                                                                            \
+        uint _r;                                                                                                       \
+        for (_r = 0; _r < n; ++_r) {                                                                                   \
+            before;                                                                                                    \
+            _al0 = allocs;                                                                                             \
+            timestamp_getprecise(&_t1);                                                                                \
+            call;                                                                                                      \
+            timestamp_getprecise(&_t2);                                                                                \
+            _al += allocs - _al0;                                                                                      \
+            _ns += timestamp_diff(&_t2, &_t1, TIME_NSECS);                                                             \
+        }                                                                                                              \
+        report(name, n, _ns, _al);                                                                                     \
+    }
+
+#define advance() hw_fake_advance(0.1)
+
+static void bench_cpufreq(topology_t *tp)
+{
+    cpufreq_t *f1, *f2;
+    ulong *freqs;
+    ulong avg;
+    uint api;
+
+    bench("cpufreq_load", 1, , cpufreq_load(tp, API_FREE));
+    bench("cpufreq_init", 1, , cpufreq_init(no_ctx));
+    cpufreq_get_api(&api);
+    apis_print(api, "cpufreq api: ");
+    cpufreq_data_alloc(&f1, &freqs);
+    cpufreq_data_alloc(&f2, NULL);
+    cpufreq_read(no_ctx, f1);
+    bench("cpufreq_read", reps, advance(), cpufreq_read(no_ctx, f2));
+    bench("cpufreq_data_diff", reps, , cpufreq_data_diff(f2, f1, freqs, &avg));
+    bench("cpufreq_read_copy", reps, advance(), cpufreq_read_copy(no_ctx, f2, f1, freqs, &avg));
+    cpufreq_data_free(&f1, &freqs);
+    cpufreq_data_free(&f2, NULL);
+}
+
+static void bench_imcfreq(topology_t *tp)
+{
+    imcfreq_t *i1, *i2;
+    ulong *freqs;
+    ulong avg;
+    uint api;
+
+    bench("imcfreq_load", 1, , imcfreq_load(tp, API_FREE));
+    bench("imcfreq_init", 1, , imcfreq_init(no_ctx));
+    imcfreq_get_api(&api);
+    apis_print(api, "imcfreq api: ");
+    imcfreq_data_alloc(&i1, &freqs);
+    imcfreq_data_alloc(&i2, NULL);
+    imcfreq_read(no_ctx, i1);
+    bench("imcfreq_read", reps, advance(), imcfreq_read(no_ctx, i2));
+    bench("imcfreq_data_diff", reps, , imcfreq_data_diff(i2, i1, freqs, &avg));
+    bench("imcfreq_read_copy", reps, advance(), imcfreq_read_copy(no_ctx, i2, i1, freqs, &avg));
+    imcfreq_data_free(&i1, &freqs);
+    imcfreq_data_free(&i2, NULL);
+}
+
+static void bench_energy_cpu(topology_t *tp)
+{
+    ullong *e1, *e2, *eD;
+    uint api;
+
+    bench("energy_cpu_load", 1, , energy_cpu_load(tp, API_FREE));
+    bench("energy_cpu_init", 1, , energy_cpu_init(no_ctx));
+    energy_cpu_get_api(&api);
+    apis_print(api, "energy_cpu api: ");
+    energy_cpu_data_alloc(no_ctx, &e1, NULL);
+    energy_cpu_data_alloc(no_ctx, &e2, NULL);
+    energy_cpu_data_alloc(no_ctx, &eD, NULL);
+    energy_cpu_read(no_ctx, e1);
+    bench("energy_cpu_read", reps, advance(), energy_cpu_read(no_ctx, e2));
+    bench("energy_cpu_data_diff", reps, , energy_cpu_data_diff(no_ctx, e1, e2, eD));
+    bench("energy_cpu_read_copy", reps, advance(), energy_cpu_read_copy(no_ctx, e2, e1, eD));
+    energy_cpu_data_free(no_ctx, &e1);
+    energy_cpu_data_free(no_ctx, &e2);
+    energy_cpu_data_free(no_ctx, &eD);
+}
+
+static void bench_temp(topology_t *tp)
+{
+    llong *t1, *t2, *tD;
+    llong avg;
+
+    bench("temp_load", 1, , temp_load(tp, API_FREE));
+    bench("temp_init", 1, , temp_init());
+    temp_data_alloc(&t1);
+    temp_data_alloc(&t2);
+    temp_data_alloc(&tD);
+    temp_read(t1, &avg);
+    bench("temp_read", reps, advance(), temp_read(t2, &avg));
+    bench("temp_read_copy", reps, advance(), temp_read_copy(t2, t1, tD, &avg));
+    free(t1);
+    free(t2);
+    free(tD);
+}
+
+static void bench_bwidth(topology_t *tp)
+{
+    bwidth_t *b1, *b2, *bD;
+    double gbs;
+    ullong cas;
+    uint api;
+
+    bench("bwidth_load", 1, , bwidth_load(tp, API_FREE));
+    bench("bwidth_init", 1, , bwidth_init(no_ctx));
+    bwidth_get_api(&api);
+    apis_print(api, "bwidth api: ");
+    bwidth_data_alloc(&b1);
+    bwidth_data_alloc(&b2);
+    bwidth_data_alloc(&bD);
+    bwidth_read(no_ctx, b1);
+    bench("bwidth_read", reps, advance(), bwidth_read(no_ctx, b2));
+    bench("bwidth_data_diff", reps, , bwidth_data_diff(b2, b1, bD, &cas, &gbs));
+    bench("bwidth_read_copy", reps, advance(), bwidth_read_copy(no_ctx, b2, b1, bD, &cas, &gbs));
+    bwidth_data_free(&b1);
+    bwidth_data_free(&b2);
+    bwidth_data_free(&bD);
+}
+
+static void bench_perf_metrics(topology_t *tp)
+{
+    cache_t ca1, ca2, caD;
+    flops_t fl1, fl2, flD;
+    cpi_t ci1, ci2, ciD;
+    double cpi, gbs, gfs;
+
+    bench("cache_load", 1, , cache_load(tp, API_FREE));
+    bench("cache_init", 1, , cache_init(no_ctx));
+    cache_read(no_ctx, &ca1);
+    bench("cache_read", reps, , cache_read(no_ctx, &ca2));
+    bench("cache_data_diff", reps, , cache_data_diff(&ca2, &ca1, &caD, &gbs));
+
+    bench("cpi_load", 1, , cpi_load(tp, API_FREE));
+    bench("cpi_init", 1, , cpi_init(no_ctx));
+    cpi_read(no_ctx, &ci1);
+    bench("cpi_read", reps, , cpi_read(no_ctx, &ci2));
+    bench("cpi_data_diff", reps, , cpi_data_diff(&ci2, &ci1, &ciD, &cpi));
+
+    bench("flops_load", 1, , flops_load(tp, API_FREE));
+    bench("flops_init", 1, , flops_init(no_ctx));
+    flops_read(no_ctx, &fl1);
+    bench("flops_read", reps, , flops_read(no_ctx, &fl2));
+    bench("flops_data_diff", reps, , flops_data_diff(&fl2, &fl1, &flD, &gfs));
+}
+
+static void bench_node_metrics(topology_t *tp)
+{
+    nm_data_t nm1, nm2, nmD;
+    nm_t id;
+
+    bench("init_node_metrics", 1, , init_node_metrics(&id, tp, 2400000));
+    init_node_metrics_data(&id, &nm1);
+    init_node_metrics_data(&id, &nm2);
+    init_node_metrics_data(&id, &nmD);
+    bench("start_compute_node_metrics", reps, advance(), start_compute_node_metrics(&id, &nm1));
+    bench("end_compute_node_metrics", reps, advance(), end_compute_node_metrics(&id, &nm2));
+    bench("diff_node_metrics", reps, , diff_node_metrics(&id, &nm1, &nm2, &nmD));
+}
+
+int main(int argc, char *argv[])
+{
+    char root[SZ_PATH];
+    uint sockets = 2;
+    uint cpus    = 128;
+    topology_t tp;
+    state_t s;
+
+    // Unbuffered, to keep the order with the API messages printed in stderr
+    setbuf(stdout, NULL);
+    if (argc > 1) cpus = (uint) atoi(argv[1]);
+    if (argc > 2) sockets = (uint) atoi(argv[2]);
+    if (argc > 3) reps = (uint) atoi(argv[3]);
+
+    sprintf(root, "/tmp/ear_hw_fake.%d", getpid());
+    if (state_fail(s = hw_fake_create(root, cpus, sockets, 2))) {
+        printf("hw_fake_create failed: %s\n", state_msg);
+        return 1;
+    }
+    setenv(FLAG_HW_ROOT, root, 1);
+    topology_init(&tp);
+    printf("simulated node: %d CPUs, %d cores, %d sockets\n", tp.cpu_count, tp.core_count, tp.socket_count);
+    printf("%-28s %8s %14s %12s\n", "call", "calls", "ns/call", "allocs/call");
+
+    bench_cpufreq(&tp);
+    bench_imcfreq(&tp);
+    bench_energy_cpu(&tp);
+    bench_temp(&tp);
+    bench_bwidth(&tp);
+    bench_perf_metrics(&tp);
+    bench_node_metrics(&tp);
+
+    hw_fake_destroy();
+    return 0;
+}
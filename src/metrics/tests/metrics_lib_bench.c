@@ -0,0 +1,215 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Benchmark of the EARL metrics (library/metrics/metrics.c) over the simulated
+// hardware of hw_fake, as a single process job without EARD. It is linked with
+// libear, whose hardware access (hwroot, perf) is replaced by the HW_FAKE
+// objects of this binary. It reports the latency and the number of allocations
+// per call of metrics_load, metrics_compute_signature_begin (partial stop and
+// start), metrics_compute_signature_finish (partial stop, the signature and
+// partial start) and metrics_dispose. Usage:
+//     ./metrics_lib_bench [cpus] [sockets] [repetitions]
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <common/config/config_env.h>
+#include <common/hardware/topology.h>
+#include <common/system/time.h>
+#include <common/types.h>
+#include <daemon/local_api/node_mgr.h>
+#include <library/common/externs.h>
+#include <library/metrics/metrics.h>
+#include <metrics/common/apis.h>
+#include <metrics/tests/hw_fake.h>
+
+// Allocations are counted by interposing the allocator of libc, which is also
+// the one of libear.
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+static ulong allocs;
+
+void *malloc(size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+extern sem_t *lib_shared_lock_sem;
+extern ear_njob_t *node_mgr_data;
+
+// Defined by the loader (libearld), which is not used
+int is_cuda_enabled()
+{
+    return 0;
+}
+
+int module_mpi_is_enabled()
+{
+    return 0;
+}
+
+int module_mpi_is_open()
+{
+    return 0;
+}
+
+static uint reps = 50;
+
+static void report(char *name, uint calls, ullong ns, ulong allocs)
+{
+    printf("%-34s %8u %14.1lf %12.2lf\n", name, calls, (double) ns / (double) calls, (double) allocs / (double) calls);
+}
+
+// Runs 'call' 'n' times. The 'before' sentence is not measured, it is used to
+// move the simulated hardware forward between samples.
+#define bench(name, n, before, call)                                                                                   \
+    {                                                                                                                  \
+        ullong _ns = 0;                                                                                                \
+        ulong _al  = 0;                                                                                                \
+        ulong _al0;                                                                                                    \
+        timestamp _t1, _t2;                                                                                            \
+        uint _r;                                                                                                       \
+        for (_r = 0; _r < n; ++_r) {                                                                                   \
+            before;                                                                                                    \
+            _al0 = allocs;                                                                                             \
+            timestamp_getprecise(&_t1);                                                                                \
+            call;                                                                                                      \
+            timestamp_getprecise(&_t2);                                                                                \
+            _al += allocs - _al0;                                                                                      \
+            _ns += timestamp_diff(&_t2, &_t1, TIME_NSECS);                                                             \
+        }                                                                                                              \
+        report(name, n, _ns, _al);                                                                                     \
+    }
+
+// The signature is computed when the loop has run for the minimum time, so the
+// simulated hardware and the clock are moved forward the same time before each
+// one, and the node power is the one of the simulated RAPL counters. EARL uses
+// the coarse clock (some ms of resolution).
+#define MIN_TIME_US 20000
+// The path is relative to metrics/tests
+#define PLUGIN "../energy/node/energy_rapl.so"
+#define advance()                                                                                                      \
+    {                                                                                                                  \
+        hw_fake_advance((double) MIN_TIME_US / 1000000.0);                                                             \
+        usleep(MIN_TIME_US);                                                                                           \
+        sig_shared_region[my_node_id].ready = 0;                                                                       \
+    }
+
+/* A single process job, the master of its node, as ear_init leaves it. The node
+ * manager region is created as EARD does, with no other jobs in the node. */
+static state_t job_init(topology_t *tp, char *root, char *plugin)
+{
+    static settings_conf_t conf;
+    static sem_t lock;
+    int cpu;
+
+    system_conf        = &conf;
+    conf.user_type     = NORMAL;
+    conf.min_sig_power = MIN_SIG_POWER;
+    conf.max_sig_power = MAX_SIG_POWER;
+    strncpy(conf.installation.obj_ener, plugin, sizeof(conf.installation.obj_ener) - 1);
+    lib_shared_region                = calloc(1, sizeof(lib_shared_data_t));
+    lib_shared_region->num_processes = 1;
+    lib_shared_region->num_cpus      = tp->cpu_count;
+    sig_shared_region                = calloc(1, sizeof(shsignature_t));
+    sig_shared_region[0].master      = 1;
+    sig_shared_region[0].pid         = getpid();
+    my_node_id                       = 0;
+    masters_info.my_master_rank      = 0;
+    // The process runs in the whole node
+    CPU_ZERO(&ear_process_mask);
+    for (cpu = 0; cpu < tp->cpu_count; ++cpu) {
+        CPU_SET(cpu, &ear_process_mask);
+    }
+    sig_shared_region[0].cpu_mask = ear_process_mask;
+    lib_shared_region->node_mask  = ear_process_mask;
+    // Private, there is just one process
+    sem_init(&lock, 0, 1);
+    lib_shared_lock_sem = &lock;
+    if (state_fail(nodemgr_server_init(root, &node_mgr_data, NULL))) {
+        return_msg(EAR_ERROR, "creating the node manager region");
+    }
+    init_earl_node_mgr_info();
+    return EAR_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    char root[SZ_PATH];
+    signature_t sig;
+    uint sockets = 2;
+    uint cpus    = 128;
+    llong passed;
+    topology_t tp;
+    state_t s;
+    uint ready = 0;
+    int ok     = 0;
+
+    // Unbuffered, to keep the order with the API messages printed in stderr
+    setbuf(stdout, NULL);
+    if (argc > 1) cpus = (uint) atoi(argv[1]);
+    if (argc > 2) sockets = (uint) atoi(argv[2]);
+    if (argc > 3) reps = (uint) atoi(argv[3]);
+
+    sprintf(root, "/tmp/ear_hw_fake.%d", getpid());
+    if (state_fail(s = hw_fake_create(root, cpus, sockets, 2))) {
+        printf("hw_fake_create failed: %s\n", state_msg);
+        return 1;
+    }
+    setenv(FLAG_HW_ROOT, root, 1);
+    topology_init(&tp);
+    printf("simulated node: %d CPUs, %d cores, %d sockets\n", tp.cpu_count, tp.core_count, tp.socket_count);
+    printf("%-34s %8s %14s %12s\n", "call", "calls", "ns/call", "allocs/call");
+
+    if (state_fail(s = job_init(&tp, root, PLUGIN))) {
+        printf("job_init failed: %s\n", state_msg);
+        hw_fake_destroy();
+        return 1;
+    }
+    bench("metrics_load", 1, , ok = (metrics_load(&tp) == EAR_SUCCESS));
+    if (!ok) {
+        printf("metrics_load failed: %s\n", state_msg);
+        hw_fake_destroy();
+        return 1;
+    }
+    apis_print(metrics_get(MET_CPUFREQ)->api, "cpufreq api: ");
+    apis_print(metrics_get(MET_IMCFREQ)->api, "imcfreq api: ");
+    apis_print(metrics_get(MET_BWIDTH)->api, "bwidth api: ");
+    apis_print(metrics_get(MET_CPI)->api, "cpi api: ");
+    memset(&sig, 0, sizeof(signature_t));
+    bench("metrics_compute_signature_begin", reps, advance(), metrics_compute_signature_begin());
+    bench("metrics_compute_signature_finish", reps, advance(),
+          ready += (metrics_compute_signature_finish(&sig, 1, MIN_TIME_US, 1, &passed) == EAR_SUCCESS));
+    printf("signatures computed: %u of %u, the last one: %.2lf ms, %.2lf W, CPI %.2lf, GB/s %.2lf, %lu kHz\n", ready,
+           reps, sig.time * 1000.0, sig.DC_power, sig.CPI, sig.GBS, sig.avg_f);
+    bench("metrics_dispose", 1, advance(), metrics_dispose(&sig, 1, 1));
+
+    hw_fake_destroy();
+    return 0;
+}
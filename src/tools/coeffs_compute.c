@@ -18,10 +18,12 @@
 #include <common/types/configuration/cluster_conf.h>
 #include <common/types/configuration/cluster_conf_db.h>
 #include <common/types/projection.h>
-#include <gsl/gsl_math.h>
-#include <gsl/gsl_matrix.h>
-#include <gsl/gsl_multifit.h>
+#include <common/utils/least_squares.h>
 #include <management/cpufreq/cpufreq.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <library/models/cpu_power_model_default.h>
 #include <metrics/flops/flops.h>
@@ -46,8 +48,14 @@ typedef struct matrix_s {
     double *err_cpi;
     double *err_time;
     double *err_power;
+    double *r2_cpi;
+    double *r2_power;
+    uint *name; // Application name of each app in app_list
+    int *index; // Position in app_list of each application name, -1 if it is not found
 } matrix_t;
 
+static uint names_count;
+
 intel_skl_t *coeffs_cpu;
 
 static state_t write_cpu_model_coefficients(char *tag_path, intel_skl_t *coeffs_cpu, uint pstate_count)
@@ -86,181 +94,98 @@ static state_t write_coefficients(int fd, matrix_t *matrix, uint matrix_count)
     return EAR_SUCCESS;
 }
 
-static int find_app(matrix_t *matrix, char *app_name)
-{
-    int a;
-    for (a = 0; a < matrix->app_count; ++a) {
-        if (strcmp(matrix->app_list[a].job.app_id, app_name) == 0) {
-            return a;
-        }
-    }
-    return -1;
-}
-
 static state_t compute_cpu_power_coefficients(intel_skl_t **cpu_power_coeffs, application_t *app_list, uint apps_count)
 {
-    int n, a;
+    double x[5], coefficients[5], vpi, r2, rmse;
     intel_skl_t *coeff;
+    lsq_t fit;
+    int a;
     //
-    n                 = apps_count;
     *cpu_power_coeffs = calloc(1, sizeof(intel_skl_t));
     coeff             = *cpu_power_coeffs;
-
     //
-    gsl_matrix *signature_base   = gsl_matrix_calloc(n, 5);
-    gsl_vector *cpu_power_target = gsl_vector_alloc(n);
-    gsl_vector *coefficients     = gsl_vector_alloc(5);
-    //
-    for (a = 0; a < n; ++a) {
-        // Initializations
-        gsl_vector_set(cpu_power_target, a, 0.0);
-        gsl_matrix_set(signature_base, a, 0, 0.0);
-        gsl_matrix_set(signature_base, a, 1, 0.0);
-        gsl_matrix_set(signature_base, a, 2, 0.0);
-        gsl_matrix_set(signature_base, a, 3, 0.0);
-        gsl_matrix_set(signature_base, a, 4, 0.0);
-
-        gsl_vector_set(cpu_power_target, a, app_list[a].signature.DC_power);
-        gsl_matrix_set(signature_base, a, 0, 1.0);
-        gsl_matrix_set(signature_base, a, 1, 1 / app_list[a].signature.CPI);
-        gsl_matrix_set(signature_base, a, 2, app_list[a].signature.GBS);
-        // printf("AVGF %lu\n", app_list[a].signature.avg_f);
-        // printf("VPI data %llu %llu %llu %llu instructions %llu\n", app_list[a].signature.FLOPS[INDEX_256F],
-        // app_list[a].signature.FLOPS[INDEX_256D], app_list[a].signature.FLOPS[INDEX_512F],
-        // app_list[a].signature.FLOPS[INDEX_512D], app_list[a].signature.instructions);
-        double vpi;
+    lsq_init(&fit, 5);
+    for (a = 0; a < apps_count; ++a) {
         vpi = (double) ((double) app_list[a].signature.FLOPS[INDEX_256F] / WEIGHT_256F +
                         (double) app_list[a].signature.FLOPS[INDEX_256D] / WEIGHT_256D +
                         (double) app_list[a].signature.FLOPS[INDEX_512F] / WEIGHT_512F +
                         (double) app_list[a].signature.FLOPS[INDEX_512D] / WEIGHT_512D) /
               (double) app_list[a].signature.instructions;
-        gsl_matrix_set(signature_base, a, 3, vpi);
-        gsl_matrix_set(signature_base, a, 4, (double) app_list[a].signature.avg_f / 1000000.0);
-        // printf("Adding IPC %lf GBS %lf VPI %lf F %lf\n", 1/app_list[a].signature.CPI, app_list[a].signature.GBS, vpi,
-        // (double)app_list[a].signature.avg_f/1000000.0);
-    }
-    // Linear least squares fitting (SVD algorithm)
-    gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(n, 5);
-    // Variance-covariance matrix
-    gsl_matrix *cov = gsl_matrix_alloc(5, 5);
-    // Sum of squares of the residuals from the best-fit
-    double chisq;
-    // Best fit of cpi_target = signature_base*coefficients
-    gsl_multifit_linear(signature_base, cpu_power_target, coefficients, cov, &chisq, work);
+        // Bias, IPC, GBS, VPI and frequency
+        x[0] = 1.0;
+        x[1] = 1 / app_list[a].signature.CPI;
+        x[2] = app_list[a].signature.GBS;
+        x[3] = vpi;
+        x[4] = (double) app_list[a].signature.avg_f / 1000000.0;
+        lsq_add(&fit, x, app_list[a].signature.DC_power);
+    }
+    // Best fit of cpu_power_target = signature_base*coefficients
+    lsq_solve(&fit, coefficients);
+    lsq_quality(&fit, coefficients, &r2, &rmse);
     // Saving coefficient values
-    coeff->ipc   = gsl_vector_get(coefficients, 1);
-    coeff->gbs   = gsl_vector_get(coefficients, 2);
-    coeff->vpi   = gsl_vector_get(coefficients, 3);
-    coeff->f     = gsl_vector_get(coefficients, 4);
-    coeff->inter = gsl_vector_get(coefficients, 0);
-    printf("tag %s: IPC %lf GBS %lf VPI %lf F %lf INTER %lf\n", tag_name, coeff->ipc, coeff->gbs, coeff->vpi, coeff->f,
-           coeff->inter);
-    // Freeing space
-    gsl_vector_free(cpu_power_target);
-    gsl_vector_free(coefficients);
-    gsl_matrix_free(signature_base);
-    gsl_matrix_free(cov);
-    gsl_multifit_linear_free(work);
+    coeff->ipc   = coefficients[1];
+    coeff->gbs   = coefficients[2];
+    coeff->vpi   = coefficients[3];
+    coeff->f     = coefficients[4];
+    coeff->inter = coefficients[0];
+    printf("tag %s: IPC %lf GBS %lf VPI %lf F %lf INTER %lf (r2 %0.3lf, rmse %0.2lf W)\n", tag_name, coeff->ipc,
+           coeff->gbs, coeff->vpi, coeff->f, coeff->inter, r2, rmse);
     return EAR_SUCCESS;
 }
 
-static void compute_cpi(matrix_t *matrix_base, matrix_t *matrix_target)
+/* Fits the power and CPI projections from the P_STATE m to all the others. Each
+ * target application is paired with the same application in the base P_STATE,
+ * and the normal equations of every target are accumulated in the same pass. */
+static void compute_fits(matrix_t *matrix, uint matrix_count, int m)
 {
-    int n, a, b;
-    //
-    n = matrix_target->app_count;
-    //
-    gsl_matrix *signature_base = gsl_matrix_calloc(n, 3);
-    gsl_vector *cpi_target     = gsl_vector_alloc(n);
-    gsl_vector *coefficients   = gsl_vector_alloc(3);
-    //
-    for (a = 0; a < n; ++a) {
-        // Initializations
-        gsl_vector_set(cpi_target, a, 0.0);
-        gsl_matrix_set(signature_base, a, 0, 0.0);
-        gsl_matrix_set(signature_base, a, 1, 0.0);
-        gsl_matrix_set(signature_base, a, 2, 0.0);
-        // Trying to find the base application.
-        if ((b = find_app(matrix_base, matrix_target->app_list[a].job.app_id)) != -1) {
-            // Target applications cpi
-            gsl_vector_set(cpi_target, a, matrix_target->app_list[a].signature.CPI);
-            // Base applications bias, power and TPI
-            gsl_matrix_set(signature_base, a, 0, 1.0);
-            gsl_matrix_set(signature_base, a, 1, matrix_base->app_list[b].signature.CPI);
-            gsl_matrix_set(signature_base, a, 2, matrix_base->app_list[b].signature.TPI);
+    lsq_t *fit_power = calloc(matrix_count, sizeof(lsq_t));
+    lsq_t *fit_cpi   = calloc(matrix_count, sizeof(lsq_t));
+    signature_t *base, *target;
+    double x[3], coefficients[3], rmse;
+    int p, a, b;
+
+    for (p = 0; p < matrix_count; ++p) {
+        lsq_init(&fit_power[p], 3);
+        lsq_init(&fit_cpi[p], 3);
+        if (p == m) {
+            continue;
         }
-    }
-    // Linear least squares fitting (SVD algorithm)
-    gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(n, 3);
-    // Variance-covariance matrix
-    gsl_matrix *cov = gsl_matrix_alloc(3, 3);
-    // Sum of squares of the residuals from the best-fit
-    double chisq;
-    // Best fit of cpi_target = signature_base*coefficients
-    gsl_multifit_linear(signature_base, cpi_target, coefficients, cov, &chisq, work);
-    // Saving coefficient values
-    matrix_base->coef_list[matrix_target->id].D = gsl_vector_get(coefficients, 1);
-    matrix_base->coef_list[matrix_target->id].E = gsl_vector_get(coefficients, 2);
-    matrix_base->coef_list[matrix_target->id].F = gsl_vector_get(coefficients, 0);
-    // Freeing space
-    gsl_vector_free(cpi_target);
-    gsl_vector_free(coefficients);
-    gsl_matrix_free(signature_base);
-    gsl_matrix_free(cov);
-    gsl_multifit_linear_free(work);
-}
-
-static void compute_power(matrix_t *matrix_base, matrix_t *matrix_target)
-{
-    int n, a, b;
-    //
-    n = matrix_target->app_count;
-    //
-    gsl_matrix *signature_base = gsl_matrix_calloc(n, 3);
-    gsl_vector *power_target   = gsl_vector_alloc(n);
-    gsl_vector *coefficients   = gsl_vector_alloc(3);
-    //
-    //	printf("%llu -> %llu\n", matrix_base->pstate.khz, matrix_target->pstate.khz);
-    for (a = 0; a < n; ++a) {
-#if 0
-		printf("\t%lu\t%0.2lf\t%0.2lf\t%0.2lf\t%s\n",
-			matrix_base->app_list[a].signature.def_f, matrix_base->app_list[a].signature.CPI,
-			matrix_base->app_list[a].signature.TPI,   matrix_base->app_list[a].signature.DC_power,
-			matrix_base->app_list[a].job.app_id);
-#endif
-        // Initializations
-        gsl_vector_set(power_target, a, 0.0);
-        gsl_matrix_set(signature_base, a, 0, 0.0);
-        gsl_matrix_set(signature_base, a, 1, 0.0);
-        gsl_matrix_set(signature_base, a, 2, 0.0);
-        // Trying to find the base application.
-        if ((b = find_app(matrix_base, matrix_target->app_list[a].job.app_id)) != -1) {
-            // Target applications power
-            gsl_vector_set(power_target, a, matrix_target->app_list[a].signature.DC_power);
+        for (a = 0; a < matrix[p].app_count; ++a) {
+            // Trying to find the base application.
+            if ((b = matrix[m].index[matrix[p].name[a]]) == -1) {
+                continue;
+            }
+            base   = &matrix[m].app_list[b].signature;
+            target = &matrix[p].app_list[a].signature;
             // Base applications bias, power and TPI
-            gsl_matrix_set(signature_base, a, 0, 1.0);
-            gsl_matrix_set(signature_base, a, 1, matrix_base->app_list[b].signature.DC_power);
-            gsl_matrix_set(signature_base, a, 2, matrix_base->app_list[b].signature.TPI);
+            x[0] = 1.0;
+            x[1] = base->DC_power;
+            x[2] = base->TPI;
+            lsq_add(&fit_power[p], x, target->DC_power);
+            // Base applications bias, CPI and TPI
+            x[1] = base->CPI;
+            lsq_add(&fit_cpi[p], x, target->CPI);
         }
     }
-    // Linear least squares fitting (SVD algorithm)
-    gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(n, 3);
-    // Variance-covariance matrix
-    gsl_matrix *cov = gsl_matrix_alloc(3, 3);
-    // Sum of squares of the residuals from the best-fit
-    double chisq;
-    // Best fit of power_target = signature_base*coefficients
-    gsl_multifit_linear(signature_base, power_target, coefficients, cov, &chisq, work);
-    // Saving coefficient values
-    matrix_base->coef_list[matrix_target->id].A = gsl_vector_get(coefficients, 1);
-    matrix_base->coef_list[matrix_target->id].B = gsl_vector_get(coefficients, 2);
-    matrix_base->coef_list[matrix_target->id].C = gsl_vector_get(coefficients, 0);
-    // Freeing space
-    gsl_vector_free(power_target);
-    gsl_vector_free(coefficients);
-    gsl_matrix_free(signature_base);
-    gsl_matrix_free(cov);
-    gsl_multifit_linear_free(work);
+    for (p = 0; p < matrix_count; ++p) {
+        if (matrix[p].app_count == 0 || p == m) {
+            continue;
+        }
+        // Best fit of power_target = signature_base*coefficients
+        lsq_solve(&fit_power[p], coefficients);
+        lsq_quality(&fit_power[p], coefficients, &matrix[m].r2_power[p], &rmse);
+        matrix[m].coef_list[p].A = coefficients[1];
+        matrix[m].coef_list[p].B = coefficients[2];
+        matrix[m].coef_list[p].C = coefficients[0];
+        // Best fit of cpi_target = signature_base*coefficients
+        lsq_solve(&fit_cpi[p], coefficients);
+        lsq_quality(&fit_cpi[p], coefficients, &matrix[m].r2_cpi[p], &rmse);
+        matrix[m].coef_list[p].D = coefficients[1];
+        matrix[m].coef_list[p].E = coefficients[2];
+        matrix[m].coef_list[p].F = coefficients[0];
+    }
+    free(fit_power);
+    free(fit_cpi);
 }
 
 static void print_coefficients(matrix_t *matrix, int m, int p)
@@ -275,9 +200,9 @@ static void print_coefficients(matrix_t *matrix, int m, int p)
     if (header++ == 0) {
         verbose(0, "---------------------------------------------------------------------------------------------------"
                    "--------");
-        tprintf_init(fderr, STR_MODE_COL, "8 8 10 10 10 10 10 10 10 10 10");
-        tprintf("f_from||f_to|||A||B||C||D||E||D|||e.cpi||e.time||e.power");
-        tprintf("------||----|||-||-||-||-||-||-|||-----||------||-------");
+        tprintf_init(fderr, STR_MODE_COL, "8 8 10 10 10 10 10 10 10 10 10 10 10");
+        tprintf("f_from||f_to|||A||B||C||D||E||D|||e.cpi||e.time||e.power|||r2.cpi||r2.power");
+        tprintf("------||----|||-||-||-||-||-||-|||-----||------||-------|||------||--------");
     }
     // Error color
     char *ecc = (matrix[m].err_cpi[i] < 4.0) ? "" : STR_YLW;
@@ -287,10 +212,12 @@ static void print_coefficients(matrix_t *matrix, int m, int p)
     ect       = (matrix[m].err_time[i] < 8.0) ? ect : STR_RED;
     ecp       = (matrix[m].err_power[i] < 8.0) ? ecp : STR_RED;
 
-    tprintf("%llu||%llu|||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf|||%s%0.2lf||%s%0.2lf||%s%0.2lf",
+    tprintf("%llu||%llu|||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf|||%s%0.2lf||%s%0.2lf||%s%0.2lf|||"
+            "%0.3lf||%0.3lf",
             matrix[m].pstate.khz, matrix[p].pstate.khz, matrix[m].coef_list[i].A, matrix[m].coef_list[i].B,
             matrix[m].coef_list[i].C, matrix[m].coef_list[i].D, matrix[m].coef_list[i].E, matrix[m].coef_list[i].F, ecc,
-            matrix[m].err_cpi[i], ect, matrix[m].err_time[i], ecp, matrix[m].err_power[i]);
+            matrix[m].err_cpi[i], ect, matrix[m].err_time[i], ecp, matrix[m].err_power[i], matrix[m].r2_cpi[i],
+            matrix[m].r2_power[i]);
 }
 
 static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
@@ -306,6 +233,8 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
         matrix[m].err_cpi   = calloc(matrix_count, sizeof(double));
         matrix[m].err_time  = calloc(matrix_count, sizeof(double));
         matrix[m].err_power = calloc(matrix_count, sizeof(double));
+        matrix[m].r2_cpi    = calloc(matrix_count, sizeof(double));
+        matrix[m].r2_power  = calloc(matrix_count, sizeof(double));
         // Giving start values to coefficient
         for (p = 0; p < matrix_count; ++p) {
             // pstate_ref is the P_STATE base (from what frequency)
@@ -320,17 +249,19 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
             }
         }
     }
+    // Computing coefficients, each P_STATE base in parallel.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (m = 0; m < matrix_count; ++m) {
+        if (matrix[m].app_count > 0) {
+            compute_fits(matrix, matrix_count, m);
+        }
+    }
     for (m = 0; m < matrix_count; ++m) {
         if (matrix[m].app_count == 0) {
             continue;
         }
-        // Computing coefficients.
-        for (p = 0; p < matrix_count; ++p) {
-            if (matrix[p].app_count > 0 && m != p) {
-                compute_power(&matrix[m], &matrix[p]);
-                compute_cpi(&matrix[m], &matrix[p]);
-            }
-        }
         // Computing errors for each application and frequency.
         for (f = 0; f < matrix_count; ++f) {
             double proj_count = 0.0;
@@ -339,7 +270,7 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
             }
             for (a = 0; a < matrix[m].app_count; ++a) {
                 // p will be the index in the frequency target.
-                if ((p = find_app(&matrix[f], matrix[m].app_list[a].job.app_id)) == -1) {
+                if ((p = matrix[f].index[matrix[m].name[a]]) == -1) {
                     continue;
                 }
                 // From matrix base pstate to matrix target pstate project CPI, TPI and power.
@@ -410,6 +341,46 @@ static state_t matrix_fill(application_t *apps, uint apps_count, matrix_t *matri
     return EAR_SUCCESS;
 }
 
+static state_t matrix_index(application_t *apps, uint apps_count, matrix_t *matrix, uint matrix_count)
+{
+    uint *group;
+    int m, a, n;
+    // Index
+    // 	Applications are identified by a name number, so the same application
+    // 	is found in the list of other P_STATE without comparing names.
+    group = calloc(ear_max(apps_count, 1), sizeof(uint));
+    if (state_fail(applications_group(apps, apps_count, 0, group, &names_count))) {
+        free(group);
+        return EAR_ERROR;
+    }
+    for (m = 0; m < matrix_count; ++m) {
+        matrix[m].name  = calloc(ear_max(matrix[m].app_count, 1), sizeof(uint));
+        matrix[m].index = calloc(ear_max(names_count, 1), sizeof(int));
+        for (n = 0; n < names_count; ++n) {
+            matrix[m].index[n] = -1;
+        }
+        // Reusing the fill counter
+        matrix[m].a = 0;
+    }
+    // The applications are visited in the order used by matrix_fill
+    for (a = 0; a < apps_count; ++a) {
+        for (m = 0; m < matrix_count && matrix[m].pstate.khz != apps[a].signature.def_f; ++m)
+            ;
+        if (m == matrix_count) {
+            continue;
+        }
+        n                           = group[a];
+        matrix[m].name[matrix[m].a] = n;
+        // The first one, in case there are repeated applications
+        if (matrix[m].index[n] == -1) {
+            matrix[m].index[n] = matrix[m].a;
+        }
+        matrix[m].a += 1;
+    }
+    free(group);
+    return EAR_SUCCESS;
+}
+
 static state_t matrix_init(pstate_t *pstate_list, uint pstate_count, matrix_t **matrix, uint *matrix_count)
 {
     int p;
@@ -458,41 +429,35 @@ static state_t apps_merge(application_t **apps, uint *apps_count)
 {
     application_t *apps_o; // Original apps array
     application_t *apps_n; // Apps by name accumulated
+#if ACCUM_DATA
     uint apps_n_count = 0;
-    int o, b, n;
+    uint *group;
+    int o, n;
+#endif
 
     // This function averages an replicated applications per frequency.
     apps_o = *apps;
     //
     apps_n = calloc(*apps_count, sizeof(application_t));
-    // Copying the first ocurrence of each app in apps_n. It counts different applications
-    // by its name and frequency.
-    for (o = 0; o < *apps_count; ++o) {
-        for (b = 0; b < o; ++b) {
-            if ((strcmp(apps_o[o].job.app_id, apps_o[b].job.app_id) == 0) &&
-                (apps_o[o].signature.def_f == apps_o[b].signature.def_f)) {
-                break;
-            }
-        }
-        // If equal means that didn't found.
-        if (o == b) {
-            // Copying just the name and frequency
-            strcpy(apps_n[apps_n_count].job.app_id, apps_o[o].job.app_id);
-            apps_n[apps_n_count].signature.def_f = apps_o[o].signature.def_f;
-            apps_n_count += 1;
-        }
-    }
 #if ACCUM_DATA
+    // Grouping the applications by its name and frequency.
+    group = calloc(*apps_count, sizeof(uint));
+    if (state_fail(applications_group(apps_o, *apps_count, 1, group, &apps_n_count))) {
+        free(apps_n);
+        free(group);
+        return EAR_ERROR;
+    }
     // Accumulating signature values
     for (o = 0; o < *apps_count; ++o) {
-        for (n = 0; n < apps_n_count; ++n) {
-            if ((strcmp(apps_o[o].job.app_id, apps_n[n].job.app_id) == 0) &&
-                (apps_o[o].signature.def_f == apps_n[n].signature.def_f)) {
-                accum(&apps_n[n].signature, &apps_o[o].signature);
-                break;
-            }
+        n = group[o];
+        if (apps_n[n].signature.cycles == 0) {
+            // Copying just the name and frequency
+            strcpy(apps_n[n].job.app_id, apps_o[o].job.app_id);
+            apps_n[n].signature.def_f = apps_o[o].signature.def_f;
         }
+        accum(&apps_n[n].signature, &apps_o[o].signature);
     }
+    free(group);
     // Averaging
     for (n = 0; n < apps_n_count; ++n) {
         average(&apps_n[n].signature);
@@ -815,6 +780,7 @@ int main(int argc, char *argv[])
     state_assert(s, apps_merge(&app_list, &app_count), return 0);
     state_assert(s, matrix_init(pstate_list, pstate_count, &matrix, &matrix_count), return 0);
     state_assert(s, matrix_fill(app_list, app_count, matrix, matrix_count), return 0);
+    state_assert(s, matrix_index(app_list, app_count, matrix, matrix_count), return 0);
     state_assert(s, compute_coefficients(matrix, matrix_count), return 0);
     state_assert(s, compute_cpu_power_coefficients(&coeffs_cpu, app_list, app_count), return 0);
     state_assert(s, write_coefficients(fd, matrix, matrix_count), return 0);
@@ -17,14 +17,18 @@
 #include <common/types/coefficient.h>
 #include <common/types/configuration/cluster_conf.h>
 #include <common/types/projection.h>
-#include <gsl/gsl_math.h>
-#include <gsl/gsl_matrix.h>
-#include <gsl/gsl_multifit.h>
+#include <common/utils/least_squares.h>
 #include <management/cpufreq/cpufreq.h>
+#include <math.h>
+#include <tools/coeffs_stats.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // Temporal buffers
 static char buffer1[SZ_PATH];
 static char buffer2[SZ_PATH];
+static char stats_path[SZ_PATH];
 
 //
 typedef struct matrix_s {
@@ -37,8 +41,14 @@ typedef struct matrix_s {
     double *err_cpi;
     double *err_time;
     double *err_power;
+    double *r2_cpi;
+    double *r2_power;
+    uint *name; // Application name of each app in app_list
+    int *index; // Position in app_list of each application name, -1 if it is not found
 } matrix_t;
 
+static uint names_count;
+
 static state_t write_coefficients(int fd, matrix_t *matrix, uint matrix_count)
 {
     int m, c;
@@ -57,114 +67,59 @@ static state_t write_coefficients(int fd, matrix_t *matrix, uint matrix_count)
     return EAR_SUCCESS;
 }
 
-static int find_app(matrix_t *matrix, char *app_name)
+/* Fits the power and CPI projections from the P_STATE m to all the others. Each
+ * target application is paired with the same application in the base P_STATE,
+ * and the normal equations of every target are accumulated in the same pass. */
+static void compute_fits(matrix_t *matrix, uint matrix_count, int m)
 {
-    int a;
-    for (a = 0; a < matrix->app_count; ++a) {
-        if (strcmp(matrix->app_list[a].job.app_id, app_name) == 0) {
-            return a;
+    lsq_t *fit_power = calloc(matrix_count, sizeof(lsq_t));
+    lsq_t *fit_cpi   = calloc(matrix_count, sizeof(lsq_t));
+    signature_t *base, *target;
+    double x[3], coefficients[3], rmse;
+    int p, a, b;
+
+    for (p = 0; p < matrix_count; ++p) {
+        lsq_init(&fit_power[p], 3);
+        lsq_init(&fit_cpi[p], 3);
+        if (p == m) {
+            continue;
         }
-    }
-    return -1;
-}
-
-static void compute_cpi(matrix_t *matrix_base, matrix_t *matrix_target)
-{
-    int n, a, b;
-    //
-    n = matrix_target->app_count;
-    //
-    gsl_matrix *signature_base = gsl_matrix_calloc(n, 3);
-    gsl_vector *cpi_target     = gsl_vector_alloc(n);
-    gsl_vector *coefficients   = gsl_vector_alloc(3);
-    //
-    for (a = 0; a < n; ++a) {
-        // Initializations
-        gsl_vector_set(cpi_target, a, 0.0);
-        gsl_matrix_set(signature_base, a, 0, 0.0);
-        gsl_matrix_set(signature_base, a, 1, 0.0);
-        gsl_matrix_set(signature_base, a, 2, 0.0);
-        // Trying to find the base application.
-        if ((b = find_app(matrix_base, matrix_target->app_list[a].job.app_id)) != -1) {
-            // Target applications cpi
-            gsl_vector_set(cpi_target, a, matrix_target->app_list[a].signature.CPI);
+        for (a = 0; a < matrix[p].app_count; ++a) {
+            // Trying to find the base application.
+            if ((b = matrix[m].index[matrix[p].name[a]]) == -1) {
+                continue;
+            }
+            base   = &matrix[m].app_list[b].signature;
+            target = &matrix[p].app_list[a].signature;
             // Base applications bias, power and TPI
-            gsl_matrix_set(signature_base, a, 0, 1.0);
-            gsl_matrix_set(signature_base, a, 1, matrix_base->app_list[b].signature.CPI);
-            gsl_matrix_set(signature_base, a, 2, matrix_base->app_list[b].signature.TPI);
+            x[0] = 1.0;
+            x[1] = base->DC_power;
+            x[2] = base->TPI;
+            lsq_add(&fit_power[p], x, target->DC_power);
+            // Base applications bias, CPI and TPI
+            x[1] = base->CPI;
+            lsq_add(&fit_cpi[p], x, target->CPI);
         }
     }
-    // Linear least squares fitting (SVD algorithm)
-    gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(n, 3);
-    // Variance-covariance matrix
-    gsl_matrix *cov = gsl_matrix_alloc(3, 3);
-    // Sum of squares of the residuals from the best-fit
-    double chisq;
-    // Best fit of cpi_target = signature_base*coefficients
-    gsl_multifit_linear(signature_base, cpi_target, coefficients, cov, &chisq, work);
-    // Saving coefficient values
-    matrix_base->coef_list[matrix_target->id].D = gsl_vector_get(coefficients, 1);
-    matrix_base->coef_list[matrix_target->id].E = gsl_vector_get(coefficients, 2);
-    matrix_base->coef_list[matrix_target->id].F = gsl_vector_get(coefficients, 0);
-    // Freeing space
-    gsl_vector_free(cpi_target);
-    gsl_vector_free(coefficients);
-    gsl_matrix_free(signature_base);
-    gsl_matrix_free(cov);
-    gsl_multifit_linear_free(work);
-}
-
-static void compute_power(matrix_t *matrix_base, matrix_t *matrix_target)
-{
-    int n, a, b;
-    //
-    n = matrix_target->app_count;
-    //
-    gsl_matrix *signature_base = gsl_matrix_calloc(n, 3);
-    gsl_vector *power_target   = gsl_vector_alloc(n);
-    gsl_vector *coefficients   = gsl_vector_alloc(3);
-    //
-    //	printf("%llu -> %llu\n", matrix_base->pstate.khz, matrix_target->pstate.khz);
-    for (a = 0; a < n; ++a) {
-#if 0
-		printf("\t%lu\t%0.2lf\t%0.2lf\t%0.2lf\t%s\n",
-			matrix_base->app_list[a].signature.def_f, matrix_base->app_list[a].signature.CPI,
-			matrix_base->app_list[a].signature.TPI,   matrix_base->app_list[a].signature.DC_power,
-			matrix_base->app_list[a].job.app_id);
-#endif
-        // Initializations
-        gsl_vector_set(power_target, a, 0.0);
-        gsl_matrix_set(signature_base, a, 0, 0.0);
-        gsl_matrix_set(signature_base, a, 1, 0.0);
-        gsl_matrix_set(signature_base, a, 2, 0.0);
-        // Trying to find the base application.
-        if ((b = find_app(matrix_base, matrix_target->app_list[a].job.app_id)) != -1) {
-            // Target applications power
-            gsl_vector_set(power_target, a, matrix_target->app_list[a].signature.DC_power);
-            // Base applications bias, power and TPI
-            gsl_matrix_set(signature_base, a, 0, 1.0);
-            gsl_matrix_set(signature_base, a, 1, matrix_base->app_list[b].signature.DC_power);
-            gsl_matrix_set(signature_base, a, 2, matrix_base->app_list[b].signature.TPI);
+    for (p = 0; p < matrix_count; ++p) {
+        if (matrix[p].app_count == 0 || p == m) {
+            continue;
         }
-    }
-    // Linear least squares fitting (SVD algorithm)
-    gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(n, 3);
-    // Variance-covariance matrix
-    gsl_matrix *cov = gsl_matrix_alloc(3, 3);
-    // Sum of squares of the residuals from the best-fit
-    double chisq;
-    // Best fit of power_target = signature_base*coefficients
-    gsl_multifit_linear(signature_base, power_target, coefficients, cov, &chisq, work);
-    // Saving coefficient values
-    matrix_base->coef_list[matrix_target->id].A = gsl_vector_get(coefficients, 1);
-    matrix_base->coef_list[matrix_target->id].B = gsl_vector_get(coefficients, 2);
-    matrix_base->coef_list[matrix_target->id].C = gsl_vector_get(coefficients, 0);
-    // Freeing space
-    gsl_vector_free(power_target);
-    gsl_vector_free(coefficients);
-    gsl_matrix_free(signature_base);
-    gsl_matrix_free(cov);
-    gsl_multifit_linear_free(work);
+        // Best fit of power_target = signature_base*coefficients
+        lsq_solve(&fit_power[p], coefficients);
+        lsq_quality(&fit_power[p], coefficients, &matrix[m].r2_power[p], &rmse);
+        matrix[m].coef_list[p].A = coefficients[1];
+        matrix[m].coef_list[p].B = coefficients[2];
+        matrix[m].coef_list[p].C = coefficients[0];
+        // Best fit of cpi_target = signature_base*coefficients
+        lsq_solve(&fit_cpi[p], coefficients);
+        lsq_quality(&fit_cpi[p], coefficients, &matrix[m].r2_cpi[p], &rmse);
+        matrix[m].coef_list[p].D = coefficients[1];
+        matrix[m].coef_list[p].E = coefficients[2];
+        matrix[m].coef_list[p].F = coefficients[0];
+    }
+    free(fit_power);
+    free(fit_cpi);
 }
 
 static void print_coefficients(matrix_t *matrix, int m, int p)
@@ -179,9 +134,9 @@ static void print_coefficients(matrix_t *matrix, int m, int p)
     if (header++ == 0) {
         verbose(0, "---------------------------------------------------------------------------------------------------"
                    "--------");
-        tprintf_init(fderr, STR_MODE_COL, "8 8 10 10 10 10 10 10 10 10 10");
-        tprintf("f_from||f_to|||A||B||C||D||E||D|||e.cpi||e.time||e.power");
-        tprintf("------||----|||-||-||-||-||-||-|||-----||------||-------");
+        tprintf_init(fderr, STR_MODE_COL, "8 8 10 10 10 10 10 10 10 10 10 10 10");
+        tprintf("f_from||f_to|||A||B||C||D||E||D|||e.cpi||e.time||e.power|||r2.cpi||r2.power");
+        tprintf("------||----|||-||-||-||-||-||-|||-----||------||-------|||------||--------");
     }
     // Error color
     char *ecc = (matrix[m].err_cpi[i] < 4.0) ? "" : STR_YLW;
@@ -191,10 +146,12 @@ static void print_coefficients(matrix_t *matrix, int m, int p)
     ect       = (matrix[m].err_time[i] < 8.0) ? ect : STR_RED;
     ecp       = (matrix[m].err_power[i] < 8.0) ? ecp : STR_RED;
 
-    tprintf("%llu||%llu|||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf|||%s%0.2lf||%s%0.2lf||%s%0.2lf",
+    tprintf("%llu||%llu|||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf||%+0.3lf|||%s%0.2lf||%s%0.2lf||%s%0.2lf|||"
+            "%0.3lf||%0.3lf",
             matrix[m].pstate.khz, matrix[p].pstate.khz, matrix[m].coef_list[i].A, matrix[m].coef_list[i].B,
             matrix[m].coef_list[i].C, matrix[m].coef_list[i].D, matrix[m].coef_list[i].E, matrix[m].coef_list[i].F, ecc,
-            matrix[m].err_cpi[i], ect, matrix[m].err_time[i], ecp, matrix[m].err_power[i]);
+            matrix[m].err_cpi[i], ect, matrix[m].err_time[i], ecp, matrix[m].err_power[i], matrix[m].r2_cpi[i],
+            matrix[m].r2_power[i]);
 }
 
 static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
@@ -210,6 +167,8 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
         matrix[m].err_cpi   = calloc(matrix_count, sizeof(double));
         matrix[m].err_time  = calloc(matrix_count, sizeof(double));
         matrix[m].err_power = calloc(matrix_count, sizeof(double));
+        matrix[m].r2_cpi    = calloc(matrix_count, sizeof(double));
+        matrix[m].r2_power  = calloc(matrix_count, sizeof(double));
         // Giving start values to coefficient
         for (p = 0; p < matrix_count; ++p) {
             // pstate_ref is the P_STATE base (from what frequency)
@@ -224,17 +183,19 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
             }
         }
     }
+    // Computing coefficients, each P_STATE base in parallel.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (m = 0; m < matrix_count; ++m) {
+        if (matrix[m].app_count > 0) {
+            compute_fits(matrix, matrix_count, m);
+        }
+    }
     for (m = 0; m < matrix_count; ++m) {
         if (matrix[m].app_count == 0) {
             continue;
         }
-        // Computing coefficients.
-        for (p = 0; p < matrix_count; ++p) {
-            if (matrix[p].app_count > 0 && m != p) {
-                compute_power(&matrix[m], &matrix[p]);
-                compute_cpi(&matrix[m], &matrix[p]);
-            }
-        }
         // Computing errors for each application and frequency.
         for (f = 0; f < matrix_count; ++f) {
             double proj_count = 0.0;
@@ -243,7 +204,7 @@ static state_t compute_coefficients(matrix_t *matrix, uint matrix_count)
             }
             for (a = 0; a < matrix[m].app_count; ++a) {
                 // p will be the index in the frequency target.
-                if ((p = find_app(&matrix[f], matrix[m].app_list[a].job.app_id)) == -1) {
+                if ((p = matrix[f].index[matrix[m].name[a]]) == -1) {
                     continue;
                 }
                 // From matrix base pstate to matrix target pstate project CPI, TPI and power.
@@ -314,6 +275,46 @@ static state_t matrix_fill(application_t *apps, uint apps_count, matrix_t *matri
     return EAR_SUCCESS;
 }
 
+static state_t matrix_index(application_t *apps, uint apps_count, matrix_t *matrix, uint matrix_count)
+{
+    uint *group;
+    int m, a, n;
+    // Index
+    // 	Applications are identified by a name number, so the same application
+    // 	is found in the list of other P_STATE without comparing names.
+    group = calloc(ear_max(apps_count, 1), sizeof(uint));
+    if (state_fail(applications_group(apps, apps_count, 0, group, &names_count))) {
+        free(group);
+        return EAR_ERROR;
+    }
+    for (m = 0; m < matrix_count; ++m) {
+        matrix[m].name  = calloc(ear_max(matrix[m].app_count, 1), sizeof(uint));
+        matrix[m].index = calloc(ear_max(names_count, 1), sizeof(int));
+        for (n = 0; n < names_count; ++n) {
+            matrix[m].index[n] = -1;
+        }
+        // Reusing the fill counter
+        matrix[m].a = 0;
+    }
+    // The applications are visited in the order used by matrix_fill
+    for (a = 0; a < apps_count; ++a) {
+        for (m = 0; m < matrix_count && matrix[m].pstate.khz != apps[a].signature.def_f; ++m)
+            ;
+        if (m == matrix_count) {
+            continue;
+        }
+        n                           = group[a];
+        matrix[m].name[matrix[m].a] = n;
+        // The first one, in case there are repeated applications
+        if (matrix[m].index[n] == -1) {
+            matrix[m].index[n] = matrix[m].a;
+        }
+        matrix[m].a += 1;
+    }
+    free(group);
+    return EAR_SUCCESS;
+}
+
 static state_t matrix_init(pstate_t *pstate_list, uint pstate_count, matrix_t **matrix, uint *matrix_count)
 {
     int p;
@@ -328,76 +329,6 @@ static state_t matrix_init(pstate_t *pstate_list, uint pstate_count, matrix_t **
     return EAR_SUCCESS;
 }
 
-static void average(signature_t *sig)
-{
-    double samples_count = (double) sig->cycles;
-    sig->time            = (sig->time / samples_count);
-    sig->GBS             = (sig->GBS / samples_count);
-    sig->DC_power        = (sig->DC_power / samples_count);
-    sig->CPI             = (sig->CPI / samples_count);
-    sig->TPI             = (sig->TPI / samples_count);
-}
-
-static void accum(signature_t *d, signature_t *s)
-{
-    d->cycles += 1; // Using cycles as counter, genius
-    d->time += s->time;
-    d->GBS += s->GBS;
-    d->DC_power += s->DC_power;
-    d->TPI += s->TPI;
-    d->CPI += s->CPI;
-}
-
-static state_t apps_merge(application_t **apps, uint *apps_count)
-{
-    application_t *apps_o; // Original apps array
-    application_t *apps_n; // Apps by name accumulated
-    uint apps_n_count = 0;
-    int o, b, n;
-
-    // This function averages an replicated applications per frequency.
-    apps_o = *apps;
-    //
-    apps_n = calloc(*apps_count, sizeof(application_t));
-    // Copying the first ocurrence of each app in apps_n. It counts different applications
-    // by its name and frequency.
-    for (o = 0; o < *apps_count; ++o) {
-        for (b = 0; b < o; ++b) {
-            if ((strcmp(apps_o[o].job.app_id, apps_o[b].job.app_id) == 0) &&
-                (apps_o[o].signature.def_f == apps_o[b].signature.def_f)) {
-                break;
-            }
-        }
-        // If equal means that didn't found.
-        if (o == b) {
-            // Copying just the name and frequency
-            strcpy(apps_n[apps_n_count].job.app_id, apps_o[o].job.app_id);
-            apps_n[apps_n_count].signature.def_f = apps_o[o].signature.def_f;
-            apps_n_count += 1;
-        }
-    }
-    // Accumulating signature values
-    for (o = 0; o < *apps_count; ++o) {
-        for (n = 0; n < apps_n_count; ++n) {
-            if ((strcmp(apps_o[o].job.app_id, apps_n[n].job.app_id) == 0) &&
-                (apps_o[o].signature.def_f == apps_n[n].signature.def_f)) {
-                accum(&apps_n[n].signature, &apps_o[o].signature);
-                break;
-            }
-        }
-    }
-    // Averaging
-    for (n = 0; n < apps_n_count; ++n) {
-        average(&apps_n[n].signature);
-    }
-    // Converting apps to apps_n
-    free(*apps);
-    *apps       = apps_n;
-    *apps_count = apps_n_count;
-
-    return EAR_SUCCESS;
-}
-
 static state_t pstate_sort(application_t *app_list, uint app_count, pstate_t **pstate_list, uint *pstate_count)
 {
     int a, b, f;
@@ -446,22 +377,40 @@ static state_t pstate_sort(application_t *app_list, uint app_count, pstate_t **p
 }
 
 static state_t db_query(int argc, char *argv[], cluster_conf_t *conf, char *host_name, application_t **apps,
-                        uint *apps_count)
+                        uint *apps_count, coeffs_stats_t *stats)
 {
-    application_t *apps_temp;
-    char *p_list = buffer1;
-    char *p_elem = buffer2;
+    application_t *apps_temp = NULL;
+    char *p_list             = buffer1;
+    char *p_elem             = buffer2;
     int job_list;
-    int t, a;
+    int t, a, n, total;
     //
     init_db_helper(&conf->database);
-    //
-    if ((*apps_count = get_num_applications(1, host_name)) <= 0) {
+    if ((total = get_num_applications(1, host_name)) <= 0) {
         return_msg(EAR_ERROR, "while reading applications from this hostname");
     }
-    if ((*apps_count = db_read_applications(&apps_temp, 1, *apps_count, host_name)) <= 0) {
+    // Just the applications after the cached ones are read
+    db_set_counters(stats->job_id, stats->step_id);
+    if ((n = db_read_applications(&apps_temp, 1, total, host_name)) < 0) {
+        return_msg(EAR_ERROR, "while reading applications from database");
+    }
+    // Applications deleted or inserted before the cached job, the statistics are computed again
+    if (!coeffs_stats_current(stats, (ulong) total, (ulong) n)) {
+        verbose(0, "discarding statistics cache, %d apps in the database (%lu cached, %d new)", total, stats->rows,
+                ear_max(n, 0));
+        free(apps_temp);
+        apps_temp = NULL;
+        coeffs_stats_reset(stats);
+        db_set_counters(stats->job_id, stats->step_id);
+        if ((n = db_read_applications(&apps_temp, 1, total, host_name)) < 0) {
+            return_msg(EAR_ERROR, "while reading applications from database");
+        }
+    }
+    if (n == 0 && stats->count == 0) {
         return_msg(EAR_ERROR, "while reading applications from database");
     }
+    coeffs_stats_advance(stats, apps_temp, n);
+    *apps_count = n;
     //
     job_list = strinargs(argc, argv, "job-list:", p_list);
     //
@@ -479,7 +428,7 @@ static state_t db_query(int argc, char *argv[], cluster_conf_t *conf, char *host
         }
         a += 1;
     }
-    *apps = calloc(a, sizeof(application_t));
+    *apps = calloc(ear_max(a, 1), sizeof(application_t));
     for (t = 0, a = 0; t < *apps_count; t++) {
         if (apps_temp[t].job.id != (ulong) -1L) {
             copy_application(&((*apps)[a]), &apps_temp[t]);
@@ -575,6 +524,7 @@ static state_t configuration(int argc, char *argv[], cluster_conf_t *conf, my_no
     }
     // Setting the complete coefficient file (i was using (*node)->coef_file).
     xsprintf(buffer1, "%s/coeffs.%s", buffer2, host_name);
+    xsprintf(stats_path, "%s.stats", buffer1);
     if ((*fd = open(buffer1, F_WR | F_CR | F_TR, F_UR | F_UW | F_GR | F_GW | F_OR | F_OW)) < 0) {
         return_print(EAR_ERROR, "failed opening file '%s' (%s)", buffer1, strerror(errno));
     }
@@ -596,6 +546,7 @@ static state_t usage(int argc, char *argv[])
     int path          = 0;
     int help          = 0;
     int verbose       = 0;
+    int no_cache      = 0;
     // More than one means something to process
     if (argc > 1) {
         help = strinargs(argc, argv, "h", NULL);
@@ -604,7 +555,8 @@ static state_t usage(int argc, char *argv[])
         node_name     = strinargs(argc, argv, "node-name:", NULL);
         path          = strinargs(argc, argv, "root-path:", NULL);
         verbose       = strinargs(argc, argv, "verbose", NULL);
-        expected_args = job_list + node_name + path + verbose + 1;
+        no_cache      = strinargs(argc, argv, "no-cache", NULL);
+        expected_args = job_list + node_name + path + verbose + no_cache + 1;
     }
     // Something happens in the arguments
     if (argc == expected_args) {
@@ -623,6 +575,8 @@ static state_t usage(int argc, char *argv[])
     verbose(0, "\t--job-list=<list-ids>\tDiscards jobs not present in <list-ids>.");
     verbose(0, "\t--root-path=<path>\tSets the root directory where coefficients will");
     verbose(0, "\t                  \tbe stored.");
+    verbose(0, "\t--no-cache\t\tReads all the learning applications, ignoring the");
+    verbose(0, "\t          \t\tstatistics saved by previous runs.");
     verbose(0, "\t--verbose\t\tVerbose mode. It includes errors.");
 
     return EAR_ERROR;
@@ -638,6 +592,8 @@ int main(int argc, char *argv[])
     uint pstate_count;
     application_t *app_list;
     uint app_count;
+    coeffs_stats_t stats = {.step_id = -1};
+    uint cached;
     matrix_t *matrix;
     uint matrix_count;
     state_t s;
@@ -647,7 +603,16 @@ int main(int argc, char *argv[])
     }
 
     state_assert(s, configuration(argc, argv, &conf, &node, host_name, &fd), return 0);
-    state_assert(s, db_query(argc, argv, &conf, host_name, &app_list, &app_count), return 0);
+    // The cache is not used when filtering jobs, it has to contain all of them
+    cached = !strinargs(argc, argv, "job-list:", NULL) && !strinargs(argc, argv, "no-cache", NULL);
+    if (cached) {
+        state_assert(s, coeffs_stats_load(stats_path, &stats), return 0);
+    }
+    state_assert(s, db_query(argc, argv, &conf, host_name, &app_list, &app_count, &stats), return 0);
+    state_assert(s, coeffs_stats_fold(&stats, &app_list, &app_count), return 0);
+    if (cached && state_fail(coeffs_stats_save(stats_path, &stats))) {
+        verbose(0, "failed saving statistics cache (%s)", state_msg);
+    }
 #if 0
 	state_assert(s, topology_init(&topo),                                           return 0);
 	state_assert(s, mgt_cpufreq_load(&topo),                                        return 0); 
@@ -657,9 +622,9 @@ int main(int argc, char *argv[])
 #else
     state_assert(s, pstate_sort(app_list, app_count, &pstate_list, &pstate_count), return 0);
 #endif
-    state_assert(s, apps_merge(&app_list, &app_count), return 0);
     state_assert(s, matrix_init(pstate_list, pstate_count, &matrix, &matrix_count), return 0);
     state_assert(s, matrix_fill(app_list, app_count, matrix, matrix_count), return 0);
+    state_assert(s, matrix_index(app_list, app_count, matrix, matrix_count), return 0);
     state_assert(s, compute_coefficients(matrix, matrix_count), return 0);
     state_assert(s, write_coefficients(fd, matrix, matrix_count), return 0);
 
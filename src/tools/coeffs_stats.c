@@ -0,0 +1,240 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <common/output/verbose.h>
+#include <common/system/file.h>
+#include <tools/coeffs_stats.h>
+
+#define STATS_VERSION 2
+
+typedef struct stats_header_s {
+    uint version;
+    int job_id;
+    int step_id;
+    uint count;
+    ulong rows;
+} stats_header_t;
+
+typedef struct app_stats_s {
+    char app_id[GENERIC_NAME];
+    ulong def_f;
+    ulong samples;
+    double time;
+    double GBS;
+    double DC_power;
+    double TPI;
+    double CPI;
+} app_stats_t;
+
+void coeffs_stats_reset(coeffs_stats_t *stats)
+{
+    free(stats->sums);
+    memset(stats, 0, sizeof(coeffs_stats_t));
+    stats->step_id = -1;
+}
+
+state_t coeffs_stats_load(char *path, coeffs_stats_t *stats)
+{
+    stats_header_t header;
+    app_stats_t *records;
+    uint i;
+    int fd;
+
+    coeffs_stats_reset(stats);
+    if ((fd = open(path, F_RD)) < 0) {
+        return EAR_SUCCESS;
+    }
+    if (state_fail(ear_fd_read(fd, (char *) &header, sizeof(stats_header_t))) || header.version != STATS_VERSION) {
+        verbose(0, "discarding statistics cache '%s'", path);
+        close(fd);
+        return EAR_SUCCESS;
+    }
+    records     = calloc(ear_max(header.count, 1), sizeof(app_stats_t));
+    stats->sums = calloc(ear_max(header.count, 1), sizeof(application_t));
+    if (records == NULL || stats->sums == NULL) {
+        close(fd);
+        free(records);
+        coeffs_stats_reset(stats);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    if (state_fail(ear_fd_read(fd, (char *) records, header.count * sizeof(app_stats_t)))) {
+        verbose(0, "discarding statistics cache '%s'", path);
+        close(fd);
+        free(records);
+        coeffs_stats_reset(stats);
+        return EAR_SUCCESS;
+    }
+    close(fd);
+    for (i = 0; i < header.count; ++i) {
+        strncpy(stats->sums[i].job.app_id, records[i].app_id, GENERIC_NAME - 1);
+        stats->sums[i].signature.def_f    = records[i].def_f;
+        stats->sums[i].signature.cycles   = records[i].samples;
+        stats->sums[i].signature.time     = records[i].time;
+        stats->sums[i].signature.GBS      = records[i].GBS;
+        stats->sums[i].signature.DC_power = records[i].DC_power;
+        stats->sums[i].signature.TPI      = records[i].TPI;
+        stats->sums[i].signature.CPI      = records[i].CPI;
+    }
+    free(records);
+    stats->count   = header.count;
+    stats->job_id  = header.job_id;
+    stats->step_id = header.step_id;
+    stats->rows    = header.rows;
+    verbose(0, "cached apps:   %u (%lu rows, until job %d.%d)", stats->count, stats->rows, stats->job_id,
+            stats->step_id);
+    return EAR_SUCCESS;
+}
+
+state_t coeffs_stats_save(char *path, coeffs_stats_t *stats)
+{
+    stats_header_t header = {.version = STATS_VERSION, .job_id = stats->job_id, .step_id = stats->step_id,
+                             .count = stats->count, .rows = stats->rows};
+    app_stats_t *records  = calloc(ear_max(stats->count, 1), sizeof(app_stats_t));
+    state_t s;
+    uint i;
+    int fd;
+
+    if (records == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    for (i = 0; i < stats->count; ++i) {
+        strncpy(records[i].app_id, stats->sums[i].job.app_id, GENERIC_NAME - 1);
+        records[i].def_f    = stats->sums[i].signature.def_f;
+        records[i].samples  = stats->sums[i].signature.cycles;
+        records[i].time     = stats->sums[i].signature.time;
+        records[i].GBS      = stats->sums[i].signature.GBS;
+        records[i].DC_power = stats->sums[i].signature.DC_power;
+        records[i].TPI      = stats->sums[i].signature.TPI;
+        records[i].CPI      = stats->sums[i].signature.CPI;
+    }
+    if ((fd = open(path, F_WR | F_CR | F_TR, F_UR | F_UW | F_GR | F_OR)) < 0) {
+        free(records);
+        return_print(EAR_ERROR, "failed opening file '%s' (%s)", path, strerror(errno));
+    }
+    s = ear_fd_write(fd, (char *) &header, sizeof(stats_header_t));
+    if (state_ok(s)) {
+        s = ear_fd_write(fd, (char *) records, stats->count * sizeof(app_stats_t));
+    }
+    close(fd);
+    free(records);
+    return s;
+}
+
+uint coeffs_stats_current(coeffs_stats_t *stats, ulong rows_total, ulong rows_new)
+{
+    return (rows_total >= stats->rows) && (rows_total - stats->rows == rows_new);
+}
+
+void coeffs_stats_advance(coeffs_stats_t *stats, application_t *rows, uint rows_count)
+{
+    int job_id, step_id;
+    uint r;
+
+    for (r = 0; r < rows_count; ++r) {
+        job_id  = (int) rows[r].job.id;
+        step_id = (int) rows[r].job.step_id;
+        if (job_id > stats->job_id || (job_id == stats->job_id && step_id > stats->step_id)) {
+            stats->job_id  = job_id;
+            stats->step_id = step_id;
+        }
+    }
+    stats->rows += rows_count;
+}
+
+static void average(signature_t *sig)
+{
+    double samples_count = (double) sig->cycles;
+    sig->time            = (sig->time / samples_count);
+    sig->GBS             = (sig->GBS / samples_count);
+    sig->DC_power        = (sig->DC_power / samples_count);
+    sig->CPI             = (sig->CPI / samples_count);
+    sig->TPI             = (sig->TPI / samples_count);
+}
+
+static void accum(signature_t *d, signature_t *s)
+{
+    d->cycles += 1; // Using cycles as counter, genius
+    d->time += s->time;
+    d->GBS += s->GBS;
+    d->DC_power += s->DC_power;
+    d->TPI += s->TPI;
+    d->CPI += s->CPI;
+}
+
+static void accum_sums(signature_t *d, signature_t *s)
+{
+    d->cycles += s->cycles;
+    d->time += s->time;
+    d->GBS += s->GBS;
+    d->DC_power += s->DC_power;
+    d->TPI += s->TPI;
+    d->CPI += s->CPI;
+}
+
+state_t coeffs_stats_fold(coeffs_stats_t *stats, application_t **apps, uint *apps_count)
+{
+    application_t *apps_o; // Original apps array followed by the cached sums
+    application_t *apps_n; // Apps by name accumulated
+    uint apps_n_count = 0;
+    uint total        = *apps_count + stats->count;
+    uint *group;
+    int o, n;
+
+    // This function averages an replicated applications per frequency. The
+    // cached sums are appended to the apps, so the groups include them.
+    if ((apps_o = realloc(*apps, ear_max(total, 1) * sizeof(application_t))) == NULL) {
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    *apps = apps_o;
+    if (stats->count > 0) {
+        memcpy(&apps_o[*apps_count], stats->sums, stats->count * sizeof(application_t));
+    }
+    group = calloc(ear_max(total, 1), sizeof(uint));
+    if (group == NULL || state_fail(applications_group(apps_o, total, 1, group, &apps_n_count))) {
+        free(group);
+        return_msg(EAR_ERROR, Generr.alloc_error);
+    }
+    apps_n = calloc(ear_max(apps_n_count, 1), sizeof(application_t));
+    // Accumulating signature values
+    for (o = 0; o < total; ++o) {
+        n = group[o];
+        if (apps_n[n].signature.cycles == 0) {
+            // Copying just the name and frequency
+            strcpy(apps_n[n].job.app_id, apps_o[o].job.app_id);
+            apps_n[n].signature.def_f = apps_o[o].signature.def_f;
+        }
+        if (o < *apps_count) {
+            accum(&apps_n[n].signature, &apps_o[o].signature);
+        } else {
+            accum_sums(&apps_n[n].signature, &apps_o[o].signature);
+        }
+    }
+    free(group);
+    // Saving the sums before averaging
+    free(stats->sums);
+    stats->sums  = calloc(ear_max(apps_n_count, 1), sizeof(application_t));
+    stats->count = apps_n_count;
+    memcpy(stats->sums, apps_n, apps_n_count * sizeof(application_t));
+    // Averaging
+    for (n = 0; n < apps_n_count; ++n) {
+        average(&apps_n[n].signature);
+    }
+    // Converting apps to apps_n
+    free(*apps);
+    *apps       = apps_n;
+    *apps_count = apps_n_count;
+
+    return EAR_SUCCESS;
+}
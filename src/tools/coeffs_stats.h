@@ -0,0 +1,52 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+#ifndef EAR_COEFFS_STATS_H
+#define EAR_COEFFS_STATS_H
+
+#include <common/states.h>
+#include <common/types/application.h>
+
+/* Statistics cache of coeffs_power_compute. The accumulated metrics of each
+ * application and frequency are saved next to the coefficients file, with the
+ * greatest learning job and step folded in and the number of rows of the node
+ * read. The next run only reads the learning applications after that job and
+ * step, and folds them into the sums. If the rows of the node are not the ones
+ * folded plus the new ones, the table was modified (applications deleted or
+ * inserted before the last job) and the sums are computed again from scratch. */
+
+typedef struct coeffs_stats {
+    application_t *sums; // Per application and frequency, signature.cycles is the number of samples
+    uint count;
+    int job_id; // Greatest job and step folded in
+    int step_id;
+    ulong rows; // Learning applications of the node read
+} coeffs_stats_t;
+
+/** Empties the statistics. */
+void coeffs_stats_reset(coeffs_stats_t *stats);
+
+/** Loads the statistics saved in path. A missing or incompatible file loads empty statistics. */
+state_t coeffs_stats_load(char *path, coeffs_stats_t *stats);
+
+state_t coeffs_stats_save(char *path, coeffs_stats_t *stats);
+
+/** Returns 1 if the statistics are up to date with the table: it has rows_total rows for the node and rows_new of
+ * them are after the job and step of the statistics. */
+uint coeffs_stats_current(coeffs_stats_t *stats, ulong rows_total, ulong rows_new);
+
+/** Counts the rows read from the table and moves the job and step to the greatest of them. */
+void coeffs_stats_advance(coeffs_stats_t *stats, application_t *rows, uint rows_count);
+
+/** Accumulates the applications into the statistics, and replaces them by the average of each application and
+ * frequency including the ones accumulated before. */
+state_t coeffs_stats_fold(coeffs_stats_t *stats, application_t **apps, uint *apps_count);
+
+#endif // EAR_COEFFS_STATS_H
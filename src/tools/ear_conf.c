@@ -11,11 +11,43 @@
 #include <common/config.h>
 #include <common/states.h>
 #include <common/types/configuration/cluster_conf.h>
+#include <common/types/configuration/cluster_conf_image.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 static char *buffer_serial;
 
+/* ear_conf --compile ear.conf [image]: writes the compiled image (cluster_conf_image.h) */
+static int compile_image(int argc, char *argv[])
+{
+    cluster_conf_t my_cluster;
+    int ret = 0;
+
+    if (argc < 3) {
+        printf("usage: %s --compile ear.conf [image]\n", argv[0]);
+        return 1;
+    }
+    memset(&my_cluster, 0, sizeof(cluster_conf_t));
+    if (state_fail(read_cluster_conf(argv[2], &my_cluster))) {
+        printf("Error reading %s\n", argv[2]);
+        return 1;
+    }
+    if (state_fail(cluster_conf_image_compile(argv[2], &my_cluster, (argc > 3) ? argv[3] : NULL))) {
+        printf("Error compiling %s: %s\n", argv[2], state_msg);
+        ret = 1;
+    }
+    free_cluster_conf(&my_cluster);
+    if (ret == 0 && state_fail(cluster_conf_image_load(argv[2], (argc > 3) ? argv[3] : NULL, &my_cluster))) {
+        printf("Error loading the image of %s: %s\n", argv[2], state_msg);
+        ret = 1;
+    } else if (ret == 0) {
+        printf("Image of %s compiled: %u islands, %u nodes definitions\n", argv[2], my_cluster.num_islands,
+               my_cluster.num_nodes);
+        free_cluster_conf(&my_cluster);
+    }
+    return ret;
+}
+
 static void serialize_deserialize_test(char *ear_path)
 {
     cluster_conf_t my_cluster_ser, my_cluster_deser;
@@ -49,6 +81,9 @@ int main(int argc, char *argv[])
     char ear_path[256];
     strcpy(nodename, "");
     verb_channel = STDOUT_FILENO;
+    if (argc > 1 && strcmp(argv[1], "--compile") == 0) {
+        return compile_image(argc, argv);
+    }
     if (argc > 1) {
         strcpy(ear_path, argv[1]);
         if (argc > 2)
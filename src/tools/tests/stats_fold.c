@@ -0,0 +1,186 @@
+/***************************************************************************
+ * Copyright (c) 2024 Energy Aware Runtime - Barcelona Supercomputing Center
+ *
+ * This program and the accompanying materials are made
+ * available under the terms of the Eclipse Public License 2.0
+ * which is available at https://www.eclipse.org/legal/epl-2.0/
+ *
+ * SPDX-License-Identifier: EPL-2.0
+ **************************************************************************/
+
+// Folds a synthetic learning table into the statistics cache of
+// coeffs_power_compute, the same way it reads the database: the rows after the
+// job and step of the statistics, ordered by job and step. It checks that:
+//
+//   - Folding the table in two runs, saving and loading the cache between them,
+//     gives the same averages as folding it all at once, also when the split is
+//     between the steps of a job.
+//   - The table is detected as modified when rows are deleted or inserted before
+//     the job and step of the cache, and not when they are appended.
+//
+//     ./stats_fold
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <tools/coeffs_stats.h>
+
+#define JOBS  20
+#define STEPS 3
+#define ROWS  (JOBS * STEPS)
+#define PATH  "/tmp/ear_stats_fold.stats"
+
+static char *names[]  = {"bt", "cg", "ep", "lu"};
+static ulong freqs[]  = {2400000, 2200000, 2000000};
+static application_t table[ROWS];
+static uint errors;
+
+static void check(int cond, char *msg)
+{
+    if (!cond) {
+        printf("error: %s\n", msg);
+        errors++;
+    }
+}
+
+/* Ordered by job and step, as the query */
+static void table_fill()
+{
+    uint j, s, r = 0;
+
+    srand(7);
+    memset(table, 0, sizeof(table));
+    for (j = 0; j < JOBS; j++) {
+        for (s = 0; s < STEPS; s++, r++) {
+            table[r].job.id             = 100 + j;
+            table[r].job.step_id        = s;
+            table[r].signature.def_f    = freqs[(j + s) % 3];
+            table[r].signature.time     = 60.0 + (rand() % 1000) / 10.0;
+            table[r].signature.GBS      = (rand() % 1000) / 50.0;
+            table[r].signature.DC_power = 200.0 + (rand() % 1000) / 5.0;
+            table[r].signature.TPI      = (rand() % 1000) / 100.0;
+            table[r].signature.CPI      = 0.3 + (rand() % 1000) / 500.0;
+            strcpy(table[r].job.app_id, names[rand() % 4]);
+        }
+    }
+}
+
+/* The rows of the first rows_count after the job and step of the statistics */
+static uint table_read(coeffs_stats_t *stats, uint rows_count, application_t **apps)
+{
+    uint r, n = 0;
+
+    *apps = calloc(ROWS, sizeof(application_t));
+    for (r = 0; r < rows_count; r++) {
+        if ((int) table[r].job.id > stats->job_id ||
+            ((int) table[r].job.id == stats->job_id && (int) table[r].job.step_id > stats->step_id)) {
+            memcpy(&(*apps)[n++], &table[r], sizeof(application_t));
+        }
+    }
+    return n;
+}
+
+/* Reads and folds the rows after the statistics, returns the averages */
+static uint run(coeffs_stats_t *stats, uint rows_count, application_t **apps)
+{
+    uint n = table_read(stats, rows_count, apps);
+
+    check(coeffs_stats_current(stats, rows_count, n), "the table is detected as modified when it only grew");
+    coeffs_stats_advance(stats, *apps, n);
+    check(state_ok(coeffs_stats_fold(stats, apps, &n)), "fold failed");
+    return n;
+}
+
+static application_t *find(application_t *apps, uint count, application_t *key)
+{
+    uint a;
+
+    for (a = 0; a < count; a++) {
+        if (apps[a].signature.def_f == key->signature.def_f && strcmp(apps[a].job.app_id, key->job.app_id) == 0) {
+            return &apps[a];
+        }
+    }
+    return NULL;
+}
+
+#define close_to(a, b) (fabs((a) - (b)) <= 1e-9 * fabs(b))
+
+static void compare(application_t *full, uint full_count, application_t *inc, uint inc_count, char *split)
+{
+    signature_t *f, *i;
+    application_t *app;
+    char msg[256];
+    uint a;
+
+    snprintf(msg, sizeof(msg), "split %s: %u averages folding in two runs, %u at once", split, inc_count, full_count);
+    check(inc_count == full_count, msg);
+    for (a = 0; a < full_count; a++) {
+        snprintf(msg, sizeof(msg), "split %s: %s at %lu differs from folding at once", split, full[a].job.app_id,
+                 full[a].signature.def_f);
+        if ((app = find(inc, inc_count, &full[a])) == NULL) {
+            check(0, msg);
+            continue;
+        }
+        f = &full[a].signature;
+        i = &app->signature;
+        check(i->cycles == f->cycles && close_to(i->time, f->time) && close_to(i->GBS, f->GBS) &&
+                  close_to(i->DC_power, f->DC_power) && close_to(i->TPI, f->TPI) && close_to(i->CPI, f->CPI),
+              msg);
+    }
+}
+
+static void test_split(application_t *full, uint full_count, uint split)
+{
+    coeffs_stats_t stats = {.step_id = -1};
+    application_t *apps;
+    uint count;
+    char name[32];
+
+    snprintf(name, sizeof(name), "%u.%u", (uint) table[split].job.id, (uint) table[split].job.step_id);
+    count = run(&stats, split, &apps);
+    free(apps);
+    check(state_ok(coeffs_stats_save(PATH, &stats)), "save failed");
+    check(state_ok(coeffs_stats_load(PATH, &stats)), "load failed");
+    check(stats.rows == split, "the rows read are not loaded");
+    check(stats.job_id == (int) table[split - 1].job.id && stats.step_id == (int) table[split - 1].job.step_id,
+          "the job and step loaded are not the last ones read");
+    count = run(&stats, ROWS, &apps);
+    compare(full, full_count, apps, count, name);
+    check(stats.rows == ROWS, "the rows read are not counted");
+    free(apps);
+    coeffs_stats_reset(&stats);
+}
+
+int main(int argc, char *argv[])
+{
+    coeffs_stats_t stats = {.step_id = -1};
+    application_t *full;
+    uint full_count;
+
+    table_fill();
+    full_count = run(&stats, ROWS, &full);
+    check(stats.job_id == 100 + JOBS - 1 && stats.step_id == STEPS - 1, "the job and step are not the last ones");
+
+    // Between jobs and between the steps of a job
+    test_split(full, full_count, ROWS / 2);
+    test_split(full, full_count, ROWS / 2 + 1);
+    test_split(full, full_count, 1);
+
+    // Rows deleted, and inserted before the last job and step
+    check(!coeffs_stats_current(&stats, ROWS - 1, 0), "a deleted row is not detected");
+    check(!coeffs_stats_current(&stats, ROWS + 1, 0), "a row inserted before the last job is not detected");
+    check(!coeffs_stats_current(&stats, ROWS + 2, 1), "a row inserted and another appended are not detected");
+    check(coeffs_stats_current(&stats, ROWS + 2, 2), "two rows appended are detected as a modification");
+
+    // A missing cache loads empty statistics
+    unlink(PATH);
+    check(state_ok(coeffs_stats_load(PATH, &stats)) && stats.count == 0 && stats.rows == 0 && stats.step_id == -1,
+          "a missing cache is not empty");
+
+    free(full);
+    printf("%u errors\n", errors);
+    return (errors != 0);
+}